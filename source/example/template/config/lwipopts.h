@@ -75,6 +75,9 @@
 
 #define LWIP_TCPIP_CORE_LOCKING    1
 
+// checksum of tcp data is calculated while copying, see LWIP_CHKSUM_COPY in arch/cc.h
+#define LWIP_CHECKSUM_ON_COPY      1
+
 #define LWIP_NETIF_LINK_CALLBACK        1
 #define LWIP_NETIF_STATUS_CALLBACK      1
 #define LWIP_NETIF_EXT_STATUS_CALLBACK  1
@@ -114,7 +114,7 @@
 #   endif
 #endif
 
-#if APP_USE_VSFIP_DEMO == ENABLED || APP_USE_LWIP_DEMO == ENABLED
+#if APP_USE_VSFIP_DEMO == ENABLED || APP_USE_LWIP_DEMO == ENABLED || APP_USE_SOCKET_DEMO == ENABLED
 #   define VSF_USE_TCPIP                                ENABLED
 #endif
 #if APP_USE_VSFIP_DEMO == ENABLED
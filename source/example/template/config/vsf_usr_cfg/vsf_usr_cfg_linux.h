@@ -26,6 +26,10 @@
 
 // linux support does not support preemption, so need evtq in idle
 #define VSF_OS_CFG_ADD_EVTQ_TO_IDLE                     ENABLED
+// enable smp to poll vsf_prio_n in host worker thread n, vsf_prio_0 runs in idle
+//#define VSF_ARCH_CFG_CORE_NUM                           4
+// enable epoll based irq emulation, systimer is then implemented by timerfd
+//#define VSF_ARCH_CFG_EPOLL                              ENABLED
 // test configurations, remove later
 #define VSF_USE_UI                                      ENABLED
 #define VSF_ARCH_CFG_IRQ_TRACE_EN                       ENABLED
@@ -35,13 +39,24 @@
 #define APP_USE_LINUX_DEMO                              DISABLED
 #   define APP_USE_LINUX_LIBUSB_DEMO                    DISABLED
 #   define APP_USE_LINUX_MOUNT_FILE_DEMO                DISABLED
+#   define APP_USE_LINUX_FS_BENCH_DEMO                  DISABLED
+//  writes through fatfs on an empty image, eg: mkfs.fat -C image 65536, and checks the image
+#   define APP_USE_LINUX_FATFS_TEST_DEMO                DISABLED
+#   define APP_USE_LINUX_CHECKSUM_BENCH_DEMO            DISABLED
+#   define APP_USE_LINUX_FD_BENCH_DEMO                  DISABLED
+//  needs VSF_USE_TCPIP and VSF_NETDRV_USE_LINUX, which are enabled by vsfip or lwip demo
+#   define APP_USE_LINUX_NETDRV_BENCH_DEMO              DISABLED
 #define APP_USE_USBH_DEMO                               DISABLED
 #   define APP_USE_DFU_HOST_DEMO                        DISABLED
+#   define APP_USE_USBH_BENCH_DEMO                      DISABLED
 #define APP_USE_USBD_DEMO                               DISABLED
 #   define APP_USE_USBD_CDC_DEMO                        DISABLED
 #   define APP_USE_USBD_MSC_DEMO                        DISABLED
+#       define USRAPP_CFG_USBD_MSC_BUFFER_SIZE          (64 * 1024)
+#       define APP_USE_USBD_USBIP_BENCH_DEMO            DISABLED
 #   define APP_USE_USBD_UVC_DEMO                        DISABLED
 #define APP_USE_SCSI_DEMO                               DISABLED
+#define APP_USE_SCSI_TEST                               DISABLED
 #define APP_USE_AUDIO_DEMO                              DISABLED
 #define APP_USE_TGUI_DEMO                               DISABLED
 #define APP_USE_SDL2_DEMO                               DISABLED
@@ -71,6 +86,7 @@
 // select one for tcpip stack
 #define APP_USE_VSFIP_DEMO                              DISABLED
 #define APP_USE_LWIP_DEMO                               DISABLED
+#define APP_USE_SOCKET_DEMO                             DISABLED
 
 #if APP_USE_TGUI_DEMO == ENABLED || APP_USE_XBOOT_XUI_DEMO == ENABLED || APP_LVGL_DEMO_CFG_FREETYPE == ENABLED
 #   define APP_USE_FREETYPE_DEMO                        ENABLED
@@ -115,6 +131,8 @@
 #   define VSF_MAL_USE_FAKEFAT32_MAL                    ENABLED
 #   define VSF_MAL_USE_SCSI_MAL                         ENABLED
 #   define VSF_MAL_USE_FILE_MAL                         ENABLED
+#   define VSF_MAL_USE_MMAP_MAL                         ENABLED
+#   define VSF_MAL_USE_AIO_MAL                          ENABLED
 
 #define VSF_USE_SCSI                                    ENABLED
 #   define VSF_SCSI_USE_MAL_SCSI                        ENABLED
@@ -122,6 +140,7 @@
 #define VSF_USE_FS                                      ENABLED
 #   define VSF_FS_USE_MEMFS                             ENABLED
 #   define VSF_FS_USE_FATFS                             ENABLED
+#   define VSF_FS_CFG_DENTRY_CACHE                      ENABLED
 
 #define VSF_USE_TRACE                                   ENABLED
 #define USRAPP_CFG_STDIO_EN                             ENABLED
@@ -169,6 +188,10 @@
 #       define VSF_USBIP_SERVER_CFG_DEBUG               ENABLED
 #       define VSF_USBIP_SERVER_CFG_DEBUG_TRAFFIC       DISABLED
 #       define VSF_USBIP_SERVER_CFG_DEBUG_URB           ENABLED
+#       if APP_USE_USBD_USBIP_BENCH_DEMO == ENABLED
+// small send buffer makes replies partially sent, usbip_bench verifies they are resent correctly
+#           define VSF_USBIP_DCD_CFG_POSIX_SNDBUF_SIZE  4096
+#       endif
 #       define VSF_USBD_CFG_EDA_PRIORITY                vsf_prio_0
 #       define VSF_USBD_CFG_HW_PRIORITY                 vsf_arch_prio_0
 #   define USRAPP_CFG_USBD_DEV                          VSF_USB_DC0
@@ -201,10 +224,11 @@
 #endif
 
 #if APP_USE_VSFIP_DEMO == ENABLED || APP_USE_LWIP_DEMO == ENABLED
-#   define VSF_NETDRV_USE_WPCAP                         ENABLED
-#       define VSF_NETDRV_WPCAP_CFG_HW_PRIORITY         vsf_arch_prio_0
+//  netdrv name: tap:TAP_NAME, packet:HOST_IF_NAME or fd:SOCKETPAIR_FD
+#   define VSF_NETDRV_USE_LINUX                         ENABLED
+#       define VSF_NETDRV_LINUX_CFG_HW_PRIORITY         vsf_arch_prio_0
 //  TODO: modify the virtual mac address
-#   define APP_NETDRV_WPCAP_CFG_MAC                     0xDC,0xFB,0x48,0x7B,0x9C,0x88
+#   define APP_NETDRV_LINUX_CFG_MAC                     0xDC,0xFB,0x48,0x7B,0x9C,0x88
 #endif
 
 #define VSF_DISP_USE_SDL2                               ENABLED
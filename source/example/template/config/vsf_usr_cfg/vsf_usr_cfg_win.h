@@ -38,14 +38,19 @@
 #define APP_USE_LINUX_DEMO                              ENABLED
 #   define APP_USE_LINUX_LIBUSB_DEMO                    ENABLED
 #   define APP_USE_LINUX_MOUNT_FILE_DEMO                ENABLED
+#   define APP_USE_LINUX_FS_BENCH_DEMO                  ENABLED
+#   define APP_USE_LINUX_CHECKSUM_BENCH_DEMO            DISABLED
+#   define APP_USE_LINUX_FD_BENCH_DEMO                  DISABLED
 #define APP_USE_USBH_DEMO                               ENABLED
 #   define APP_USE_DFU_HOST_DEMO                        ENABLED
+#   define APP_USE_USBH_BENCH_DEMO                      DISABLED
 #define APP_USE_USBD_DEMO                               ENABLED
 #   define APP_USE_USBD_CDC_DEMO                        ENABLED
 #   define APP_USE_USBD_MSC_DEMO                        ENABLED
 #   define APP_USE_USBD_UVC_DEMO                        ENABLED
 #   define APP_USE_USBD_USER_DEMO                       ENABLED
 #define APP_USE_SCSI_DEMO                               ENABLED
+#define APP_USE_SCSI_TEST                               ENABLED
 #define APP_USE_AUDIO_DEMO                              ENABLED
 #define APP_USE_TGUI_DEMO                               ENABLED
 #define APP_USE_TGUI_DESIGNER_DEMO                      DISABLED
@@ -144,6 +149,7 @@
 #define VSF_USE_FS                                      ENABLED
 #   define VSF_FS_USE_MEMFS                             ENABLED
 #   define VSF_FS_USE_FATFS                             ENABLED
+#   define VSF_FS_CFG_DENTRY_CACHE                      ENABLED
 
 #define VSF_USE_TRACE                                   ENABLED
 #define USRAPP_CFG_STDIO_EN                             ENABLED
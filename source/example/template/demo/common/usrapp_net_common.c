@@ -27,7 +27,7 @@
 /*============================ TYPES =========================================*/
 /*============================ GLOBAL VARIABLES ==============================*/
 
-#if VSF_NETDRV_USE_WPCAP == ENABLED
+#if VSF_NETDRV_USE_WPCAP == ENABLED || VSF_NETDRV_USE_LINUX == ENABLED
 usrapp_net_common_t usrapp_net_common = {
 #   if VSF_NETDRV_USE_WPCAP == ENABLED
     .netdrv                 = {
@@ -37,6 +37,14 @@ usrapp_net_common_t usrapp_net_common = {
         .mtu                = 1500 + TCPIP_ETH_HEADSIZE,
         .hwtype             = TCPIP_ETH_HWTYPE,
     },
+#   elif VSF_NETDRV_USE_LINUX == ENABLED
+    .netdrv                 = {
+        .macaddr.size       = TCPIP_ETH_ADDRLEN,
+        .macaddr.addr_buf   = {APP_NETDRV_LINUX_CFG_MAC},
+        .mac_header_size    = TCPIP_ETH_HEADSIZE,
+        .mtu                = 1500 + TCPIP_ETH_HEADSIZE,
+        .hwtype             = TCPIP_ETH_HWTYPE,
+    },
 #   endif
 };
 #endif
@@ -46,7 +54,7 @@ usrapp_net_common_t usrapp_net_common = {
 /*============================ IMPLEMENTATION ================================*/
 
 vsf_err_t usrapp_net_common_init(
-#if VSF_NETDRV_USE_WPCAP == ENABLED
+#if VSF_NETDRV_USE_WPCAP == ENABLED || VSF_NETDRV_USE_LINUX == ENABLED
     char *name
 #else
     void
@@ -55,11 +63,25 @@ vsf_err_t usrapp_net_common_init(
 {
     vsf_err_t err = VSF_ERR_NONE;
 
-#if VSF_NETDRV_USE_WPCAP == ENABLED
+#if VSF_NETDRV_USE_WPCAP == ENABLED || VSF_NETDRV_USE_LINUX == ENABLED
 
 #   if VSF_NETDRV_USE_WPCAP == ENABLED
     usrapp_net_common.netdrv.name = name;
     vk_netdrv_set_netlink_op((vk_netdrv_t *)&usrapp_net_common.netdrv, &vk_netdrv_wpcap_netlink_op, NULL);
+#   elif VSF_NETDRV_USE_LINUX == ENABLED
+    // tap:TAP_NAME, packet:HOST_IF_NAME or fd:SOCKETPAIR_FD
+    if (!strncmp(name, "tap:", 4)) {
+        usrapp_net_common.netdrv.mode = VSF_NETDRV_LINUX_MODE_TAP;
+    } else if (!strncmp(name, "packet:", 7)) {
+        usrapp_net_common.netdrv.mode = VSF_NETDRV_LINUX_MODE_PACKET;
+    } else if (!strncmp(name, "fd:", 3)) {
+        usrapp_net_common.netdrv.mode = VSF_NETDRV_LINUX_MODE_SOCKETPAIR;
+        usrapp_net_common.netdrv.fd = atoi(&name[3]);
+    } else {
+        return VSF_ERR_INVALID_PARAMETER;
+    }
+    usrapp_net_common.netdrv.name = strchr(name, ':') + 1;
+    vk_netdrv_set_netlink_op((vk_netdrv_t *)&usrapp_net_common.netdrv, &vk_netdrv_linux_netlink_op, NULL);
 #   endif
 
     err = vk_netdrv_connect((vk_netdrv_t *)&usrapp_net_common.netdrv);
@@ -34,17 +34,19 @@
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
 
-#if VSF_NETDRV_USE_WPCAP == ENABLED
+#if VSF_NETDRV_USE_WPCAP == ENABLED || VSF_NETDRV_USE_LINUX == ENABLED
 typedef struct usrapp_net_common_t {
 #   if VSF_NETDRV_USE_WPCAP == ENABLED
     vk_netdrv_wpcap_t netdrv;
+#   elif VSF_NETDRV_USE_LINUX == ENABLED
+    vk_netdrv_linux_t netdrv;
 #   endif
 } usrapp_net_common_t;
 #endif
 
 /*============================ GLOBAL VARIABLES ==============================*/
 
-#if VSF_NETDRV_USE_WPCAP == ENABLED
+#if VSF_NETDRV_USE_WPCAP == ENABLED || VSF_NETDRV_USE_LINUX == ENABLED
 extern usrapp_net_common_t usrapp_net_common;
 #endif
 
@@ -52,7 +54,7 @@ extern usrapp_net_common_t usrapp_net_common;
 /*============================ PROTOTYPES ====================================*/
 
 extern vsf_err_t usrapp_net_common_init(
-#if VSF_NETDRV_USE_WPCAP == ENABLED
+#if VSF_NETDRV_USE_WPCAP == ENABLED || VSF_NETDRV_USE_LINUX == ENABLED
     char *name
 #else
     void
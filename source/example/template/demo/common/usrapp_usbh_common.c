@@ -114,6 +114,10 @@ usrapp_usbh_common_t usrapp_usbh_common = {
 #if VSF_USBH_USE_UAC == ENABLED
     .uac                = &vk_usbh_uac_drv,
 #endif
+#if     APP_USE_USBH_DEMO == ENABLED && APP_USE_USBH_BENCH_DEMO == ENABLED       \
+    &&  APP_USE_LINUX_DEMO == ENABLED
+    .bench.drv          = &usrapp_usbh_bench_drv,
+#endif
 };
 
 /*============================ LOCAL VARIABLES ===============================*/
@@ -163,6 +167,10 @@ vsf_err_t usrapp_usbh_common_init(void)
 #if VSF_USBH_USE_UAC == ENABLED
     vk_usbh_register_class(&usrapp_usbh_common.host, &usrapp_usbh_common.uac);
 #endif
+#if     APP_USE_USBH_DEMO == ENABLED && APP_USE_USBH_BENCH_DEMO == ENABLED       \
+    &&  APP_USE_LINUX_DEMO == ENABLED
+    vk_usbh_register_class(&usrapp_usbh_common.host, &usrapp_usbh_common.bench);
+#endif
 
     return VSF_ERR_NONE;
 }
@@ -94,6 +94,10 @@ typedef struct usrapp_usbh_common_t {
 #if VSF_USBH_USE_UAC == ENABLED
     vk_usbh_class_t uac;
 #endif
+#if     APP_USE_USBH_DEMO == ENABLED && APP_USE_USBH_BENCH_DEMO == ENABLED       \
+    &&  APP_USE_LINUX_DEMO == ENABLED
+    vk_usbh_class_t bench;
+#endif
 } usrapp_usbh_common_t;
 
 /*============================ GLOBAL VARIABLES ==============================*/
@@ -104,6 +108,10 @@ typedef struct usrapp_usbh_common_t {
 extern const usrapp_usbh_common_const_t usrapp_usbh_common_const;
 #endif
 extern usrapp_usbh_common_t usrapp_usbh_common;
+#if     APP_USE_USBH_DEMO == ENABLED && APP_USE_USBH_BENCH_DEMO == ENABLED       \
+    &&  APP_USE_LINUX_DEMO == ENABLED
+extern const vk_usbh_class_drv_t usrapp_usbh_bench_drv;
+#endif
 
 /*============================ LOCAL VARIABLES ===============================*/
 /*============================ PROTOTYPES ====================================*/
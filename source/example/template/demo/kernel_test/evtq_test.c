@@ -0,0 +1,297 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+/*============================ INCLUDES ======================================*/
+
+#include "vsf.h"
+
+#if APP_USE_KERNEL_TEST == ENABLED
+
+/*============================ MACROS ========================================*/
+
+// producers post bursts to one consumer in vsf_prio_0 as fast as they can,
+//  and yield every batch messages. When the evtq of the consumer is full, the
+//  producer stalls and is kicked again by the consumer(back-pressure).
+#ifndef APP_EVTQ_TEST_CFG_PRODUCER_NUM
+#   define APP_EVTQ_TEST_CFG_PRODUCER_NUM   8
+#endif
+#if APP_EVTQ_TEST_CFG_PRODUCER_NUM > 32
+#   error "APP_EVTQ_TEST_CFG_PRODUCER_NUM MUST be <= 32"
+#endif
+#ifndef APP_EVTQ_TEST_CFG_BATCH
+#   define APP_EVTQ_TEST_CFG_BATCH          64
+#endif
+// messages not yet acked by the consumer, MUST be at least 32. It is far more
+//  than a bounded evtq can hold, and only limits the size of unbounded evtq.
+#ifndef APP_EVTQ_TEST_CFG_INFLIGHT
+#   define APP_EVTQ_TEST_CFG_INFLIGHT       256
+#endif
+// messages of every producer in one burst
+#ifndef APP_EVTQ_TEST_CFG_BURST
+#   define APP_EVTQ_TEST_CFG_BURST          100000
+#endif
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+
+// producers are spread over the priorities above the consumer if available
+#if VSF_OS_CFG_PRIORITY_NUM > 1
+#   define __APP_EVTQ_TEST_PRODUCER_PRIO(__idx)                                 \
+            (vsf_prio_t)(vsf_prio_0 + 1 + ((__idx) % (VSF_OS_CFG_PRIORITY_NUM - 1)))
+#else
+#   define __APP_EVTQ_TEST_PRODUCER_PRIO(__idx)     vsf_prio_0
+#endif
+
+// bit0 of message MUST be 0, so sequence is saved from bit1
+#define __APP_EVTQ_TEST_MSG(__idx, __seq)                                       \
+            (((uintptr_t)(__idx) << 24) | (((__seq) & 0x7FFFFF) << 1))
+
+/*============================ TYPES =========================================*/
+
+typedef struct usrapp_evtq_test_producer_t {
+    vsf_eda_t eda;
+    // seq_sent, remain, stalls and errors are only accessed by the producer
+    //  in a burst, and read by the consumer after the burst
+    uint32_t seq_sent;
+    uint32_t remain;
+    uint32_t stalls;
+    uint32_t errors;
+    // seq_recv is only accessed by the consumer
+    uint32_t seq_recv;
+    // seq_recv published by the consumer, protected by vsf_protect_int
+    uint32_t acked;
+} usrapp_evtq_test_producer_t;
+
+typedef struct usrapp_evtq_test_t {
+    vsf_teda_t consumer;
+    usrapp_evtq_test_producer_t producer[APP_EVTQ_TEST_CFG_PRODUCER_NUM];
+
+    // set by stalled producers and cleared by the consumer when kicking them,
+    //  protected by vsf_protect_int, but polled by the consumer without
+    volatile uint32_t stalled_mask;
+
+    // accessed by the consumer only
+    uint32_t posts;
+    uint32_t errors;
+    vsf_systimer_cnt_t start_tick;
+} usrapp_evtq_test_t;
+
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ LOCAL VARIABLES ===============================*/
+
+static NO_INIT usrapp_evtq_test_t __usrapp_evtq;
+
+/*============================ PROTOTYPES ====================================*/
+/*============================ IMPLEMENTATION ================================*/
+
+static uint_fast8_t __usrapp_evtq_producer_idx(usrapp_evtq_test_producer_t *producer)
+{
+    return producer - &__usrapp_evtq.producer[0];
+}
+
+static void __usrapp_evtq_set_stalled(usrapp_evtq_test_producer_t *producer)
+{
+    vsf_protect_t orig = vsf_protect_int();
+        __usrapp_evtq.stalled_mask |= 1UL << __usrapp_evtq_producer_idx(producer);
+    vsf_unprotect_int(orig);
+}
+
+// return false if the stalled bit is already taken by the consumer
+static bool __usrapp_evtq_clear_stalled(usrapp_evtq_test_producer_t *producer)
+{
+    uint32_t mask = 1UL << __usrapp_evtq_producer_idx(producer);
+    vsf_protect_t orig = vsf_protect_int();
+        bool is_stalled = !!(__usrapp_evtq.stalled_mask & mask);
+        __usrapp_evtq.stalled_mask &= ~mask;
+    vsf_unprotect_int(orig);
+    return is_stalled;
+}
+
+static vsf_err_t __usrapp_evtq_producer_post(usrapp_evtq_test_producer_t *producer)
+{
+    return vsf_eda_post_msg(&__usrapp_evtq.consumer.use_as__vsf_eda_t,
+                (void *)__APP_EVTQ_TEST_MSG(__usrapp_evtq_producer_idx(producer), producer->seq_sent));
+}
+
+static void __usrapp_evtq_producer_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
+{
+    usrapp_evtq_test_producer_t *producer = (usrapp_evtq_test_producer_t *)eda;
+    uint_fast32_t num;
+    vsf_protect_t orig;
+    vsf_err_t err;
+
+    switch (evt) {
+    case VSF_EVT_USER:
+        // kicked by itself, or by the consumer on burst start and stall
+        orig = vsf_protect_int();
+            num = APP_EVTQ_TEST_CFG_INFLIGHT - (producer->seq_sent - producer->acked);
+            if (0 == num) {
+                __usrapp_evtq.stalled_mask |= 1UL << __usrapp_evtq_producer_idx(producer);
+            }
+        vsf_unprotect_int(orig);
+        if (0 == num) {
+            // wait for the ack from the consumer
+            break;
+        }
+        num = min(num, min(producer->remain, APP_EVTQ_TEST_CFG_BATCH));
+
+        while (num-- > 0) {
+            err = __usrapp_evtq_producer_post(producer);
+            if (VSF_ERR_NOT_ENOUGH_RESOURCES == err) {
+                // evtq full, register for the kick before retry, so that the
+                //  kick is not lost if the consumer drains the evtq in between
+                producer->stalls++;
+                __usrapp_evtq_set_stalled(producer);
+                err = __usrapp_evtq_producer_post(producer);
+                if (VSF_ERR_NONE == err) {
+                    producer->seq_sent++;
+                    producer->remain--;
+                    if (!__usrapp_evtq_clear_stalled(producer)) {
+                        // already kicked by the consumer, continue there
+                        return;
+                    }
+                    continue;
+                }
+            }
+            if (err != VSF_ERR_NONE) {
+                if (err != VSF_ERR_NOT_ENOUGH_RESOURCES) {
+                    producer->errors++;
+                }
+                // wait for the kick from the consumer
+                return;
+            }
+            producer->seq_sent++;
+            producer->remain--;
+        }
+        // yield to other edas in the same evtq
+        if (    (producer->remain > 0)
+            &&  (VSF_ERR_NONE != vsf_eda_post_evt(eda, VSF_EVT_USER))) {
+            producer->stalls++;
+            __usrapp_evtq_set_stalled(producer);
+        }
+        break;
+    }
+}
+
+// called by the consumer to ack received messages and kick stalled producers
+static void __usrapp_evtq_ack(void)
+{
+    usrapp_evtq_test_producer_t *producer;
+    vsf_protect_t orig;
+    uint32_t mask;
+    int i;
+
+    orig = vsf_protect_int();
+        for (i = 0; i < dimof(__usrapp_evtq.producer); i++) {
+            __usrapp_evtq.producer[i].acked = __usrapp_evtq.producer[i].seq_recv;
+        }
+        mask = __usrapp_evtq.stalled_mask;
+        __usrapp_evtq.stalled_mask = 0;
+    vsf_unprotect_int(orig);
+
+    while (mask != 0) {
+        i = vsf_ffs(mask);
+        mask &= ~(1UL << i);
+        producer = &__usrapp_evtq.producer[i];
+        if (VSF_ERR_NONE != vsf_eda_post_evt(&producer->eda, VSF_EVT_USER)) {
+            // evtq of the producer is full, retry on next message
+            __usrapp_evtq_set_stalled(producer);
+        }
+    }
+}
+
+static void __usrapp_evtq_burst_start(void)
+{
+    __usrapp_evtq.posts = 0;
+    __usrapp_evtq.start_tick = vsf_systimer_get();
+    for (int i = 0; i < dimof(__usrapp_evtq.producer); i++) {
+        __usrapp_evtq.producer[i].remain = APP_EVTQ_TEST_CFG_BURST;
+        __usrapp_evtq.producer[i].stalls = 0;
+        if (VSF_ERR_NONE != vsf_eda_post_evt(&__usrapp_evtq.producer[i].eda, VSF_EVT_USER)) {
+            __usrapp_evtq_set_stalled(&__usrapp_evtq.producer[i]);
+        }
+    }
+}
+
+static void __usrapp_evtq_consumer_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
+{
+    switch (evt) {
+    case VSF_EVT_INIT:
+        vsf_teda_set_timer_ms(1000);
+        break;
+    case VSF_EVT_MESSAGE: {
+            uintptr_t msg = (uintptr_t)vsf_eda_get_cur_msg();
+            usrapp_evtq_test_producer_t *producer = &__usrapp_evtq.producer[msg >> 24];
+
+            // evts from one producer MUST be received in order
+            if (msg != __APP_EVTQ_TEST_MSG(msg >> 24, producer->seq_recv)) {
+                __usrapp_evtq.errors++;
+            }
+            producer->seq_recv++;
+
+            // a stalled producer is kicked on the next message it is visible
+            if ((0 == (++__usrapp_evtq.posts & 0x0F)) || (__usrapp_evtq.stalled_mask != 0)) {
+                __usrapp_evtq_ack();
+            }
+
+            if (__usrapp_evtq.posts == APP_EVTQ_TEST_CFG_PRODUCER_NUM * APP_EVTQ_TEST_CFG_BURST) {
+                uint_fast32_t us = vsf_systimer_tick_to_us(vsf_systimer_get() - __usrapp_evtq.start_tick);
+                uint32_t errors = __usrapp_evtq.errors, stalls = 0;
+
+                for (int i = 0; i < dimof(__usrapp_evtq.producer); i++) {
+                    errors += __usrapp_evtq.producer[i].errors;
+                    stalls += __usrapp_evtq.producer[i].stalls;
+                }
+                vsf_trace(VSF_TRACE_INFO, "evtq_test: %d posts/s, %d evtq full, %d errors" VSF_TRACE_CFG_LINEEND,
+                        (int)((uint64_t)__usrapp_evtq.posts * 1000000 / (us ? us : 1)),
+                        (int)stalls, (int)errors);
+                vsf_teda_set_timer_ms(1000);
+            }
+        }
+        break;
+    case VSF_EVT_TIMER:
+        __usrapp_evtq_burst_start();
+        break;
+    }
+}
+
+void usrapp_evtq_test_start(void)
+{
+    memset(&__usrapp_evtq, 0, sizeof(__usrapp_evtq));
+
+    const vsf_eda_cfg_t consumer_cfg = {
+        .fn.evthandler  = __usrapp_evtq_consumer_evthandler,
+        .priority       = vsf_prio_0,
+    };
+    vsf_teda_start(&__usrapp_evtq.consumer, (vsf_eda_cfg_t *)&consumer_cfg);
+
+    for (int i = 0; i < dimof(__usrapp_evtq.producer); i++) {
+        const vsf_eda_cfg_t cfg = {
+            .fn.evthandler  = __usrapp_evtq_producer_evthandler,
+            .priority       = __APP_EVTQ_TEST_PRODUCER_PRIO(i),
+        };
+        vsf_eda_start(&__usrapp_evtq.producer[i].eda, (vsf_eda_cfg_t *)&cfg);
+    }
+}
+
+#if APP_USE_LINUX_DEMO == ENABLED
+int kernel_evtq_test_main(int argc, char *argv[])
+{
+    usrapp_evtq_test_start();
+    return 0;
+}
+#endif
+
+#endif
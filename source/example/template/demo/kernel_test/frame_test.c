@@ -0,0 +1,169 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+/*============================ INCLUDES ======================================*/
+
+#include "vsf.h"
+
+#if APP_USE_KERNEL_TEST == ENABLED && VSF_KERNEL_CFG_EDA_SUPPORT_SUB_CALL == ENABLED
+
+/*============================ MACROS ========================================*/
+
+// depth of nested sub calls, every sub call uses a different local size
+#ifndef APP_FRAME_TEST_CFG_DEPTH
+#   define APP_FRAME_TEST_CFG_DEPTH         4
+#endif
+#ifndef APP_FRAME_TEST_CFG_ROUNDS
+#   define APP_FRAME_TEST_CFG_ROUNDS        100000
+#endif
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+
+#define __APP_FRAME_TEST_PATTERN(__depth, __size)                               \
+            ((uint8_t)(((__depth) << 4) ^ (__size)))
+
+/*============================ TYPES =========================================*/
+
+typedef struct usrapp_frame_test_t {
+    vsf_eda_t eda;
+    uint32_t rounds;
+    uint32_t calls;
+    uint32_t errors;
+    vsf_systimer_cnt_t start_tick;
+} usrapp_frame_test_t;
+
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ LOCAL VARIABLES ===============================*/
+
+static NO_INIT usrapp_frame_test_t __usrapp_frame;
+
+// local sizes seen in typical peda chains, last ones are served by heap
+static const uint16_t __usrapp_frame_local_size[] = {
+    0, 8, 16, 24, 40, 64, 96, 128, 200, 512,
+};
+
+/*============================ PROTOTYPES ====================================*/
+/*============================ IMPLEMENTATION ================================*/
+
+static uint_fast16_t __usrapp_frame_test_local_size(uintptr_t depth)
+{
+    return __usrapp_frame_local_size[(__usrapp_frame.rounds + depth) % dimof(__usrapp_frame_local_size)];
+}
+
+// param evthandler is called with the local buffer, param is the target
+static void __usrapp_frame_test_sub(uintptr_t local_ptr, vsf_evt_t evt)
+{
+    uintptr_t depth = vsf_eda_target_get();
+    uint_fast16_t local_size = __usrapp_frame_test_local_size(depth);
+    uint8_t *local = (uint8_t *)local_ptr;
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+        __usrapp_frame.calls++;
+        if (local_size > 0) {
+            if ((uintptr_t)local != vsf_eda_get_local()) {
+                __usrapp_frame.errors++;
+                vsf_eda_return();
+                break;
+            }
+            // local buffer MUST be cleared for every sub call
+            for (uint_fast16_t i = 0; i < local_size; i++) {
+                if (local[i] != 0) {
+                    __usrapp_frame.errors++;
+                    break;
+                }
+            }
+            memset(local, __APP_FRAME_TEST_PATTERN(depth, local_size), local_size);
+        }
+        if (depth > 1) {
+            vsf_eda_call_param_eda(__usrapp_frame_test_sub, depth - 1,
+                    __usrapp_frame_test_local_size(depth - 1));
+            break;
+        }
+        vsf_eda_return();
+        break;
+    case VSF_EVT_RETURN:
+        // local buffer MUST be kept during sub call
+        for (uint_fast16_t i = 0; i < local_size; i++) {
+            if (local[i] != __APP_FRAME_TEST_PATTERN(depth, local_size)) {
+                __usrapp_frame.errors++;
+                break;
+            }
+        }
+        vsf_eda_return();
+        break;
+    }
+}
+
+#if VSF_KERNEL_CFG_EDA_FRAME_STATISTICS == ENABLED
+static void __usrapp_frame_test_report(void)
+{
+    vsf_eda_frame_statistics_t stat;
+
+    for (uint_fast8_t i = 0; vsf_eda_frame_statistics(i, &stat); i++) {
+        vsf_trace(VSF_TRACE_INFO, "frame_test: class %d local %d, %d allocated, %d recycled, %d used(max %d), %d free, %d failed" VSF_TRACE_CFG_LINEEND,
+                i, stat.local_size, stat.alloc_cnt, stat.recycle_cnt,
+                stat.used_cnt, stat.max_used_cnt, stat.free_cnt, stat.fail_cnt);
+    }
+}
+#endif
+
+static void __usrapp_frame_test_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
+{
+    switch (evt) {
+    case VSF_EVT_INIT:
+        __usrapp_frame.start_tick = vsf_systimer_get();
+        // fall through
+    case VSF_EVT_RETURN:
+        if (__usrapp_frame.rounds < APP_FRAME_TEST_CFG_ROUNDS) {
+            __usrapp_frame.rounds++;
+            vsf_eda_call_param_eda(__usrapp_frame_test_sub, APP_FRAME_TEST_CFG_DEPTH,
+                    __usrapp_frame_test_local_size(APP_FRAME_TEST_CFG_DEPTH));
+            break;
+        }
+
+        uint_fast32_t us = vsf_systimer_tick_to_us(vsf_systimer_get() - __usrapp_frame.start_tick);
+        vsf_trace(VSF_TRACE_INFO, "frame_test: %d calls/s, %d errors" VSF_TRACE_CFG_LINEEND,
+                (int)((uint64_t)__usrapp_frame.calls * 1000000 / (us ? us : 1)),
+                (int)__usrapp_frame.errors);
+#if VSF_KERNEL_CFG_EDA_FRAME_STATISTICS == ENABLED
+        __usrapp_frame_test_report();
+#endif
+        vsf_eda_return();
+        break;
+    }
+}
+
+void usrapp_frame_test_start(void)
+{
+    memset(&__usrapp_frame, 0, sizeof(__usrapp_frame));
+
+    const vsf_eda_cfg_t cfg = {
+        .fn.evthandler  = __usrapp_frame_test_evthandler,
+        .priority       = vsf_prio_0,
+    };
+    vsf_eda_start(&__usrapp_frame.eda, (vsf_eda_cfg_t *)&cfg);
+}
+
+#if APP_USE_LINUX_DEMO == ENABLED
+int kernel_frame_test_main(int argc, char *argv[])
+{
+    usrapp_frame_test_start();
+    return 0;
+}
+#endif
+
+#endif
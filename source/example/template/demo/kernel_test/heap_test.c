@@ -0,0 +1,198 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+/*============================ INCLUDES ======================================*/
+
+#include "vsf.h"
+
+#if APP_USE_KERNEL_TEST == ENABLED && VSF_USE_HEAP == ENABLED
+
+/*============================ MACROS ========================================*/
+
+#ifndef APP_HEAP_TEST_CFG_SLOT_NUM
+#   define APP_HEAP_TEST_CFG_SLOT_NUM       256
+#endif
+#ifndef APP_HEAP_TEST_CFG_OPS
+#   define APP_HEAP_TEST_CFG_OPS            100000
+#endif
+// region of the private tlsf, allocated from VSF_HEAP
+#ifndef APP_HEAP_TEST_CFG_TLSF_SIZE
+#   define APP_HEAP_TEST_CFG_TLSF_SIZE      (256 * 1024)
+#endif
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+
+typedef struct usrapp_heap_test_op_t {
+    const char *name;
+    void * (*malloc)(uint_fast32_t size);
+    void (*free)(void *buffer);
+    // optional, called with live buffers before they are freed
+    void (*report)(void);
+} usrapp_heap_test_op_t;
+
+typedef struct usrapp_heap_test_t {
+    vsf_tlsf_t tlsf;
+    struct {
+        uint8_t *buffer;
+        uint32_t size;
+    } slot[APP_HEAP_TEST_CFG_SLOT_NUM];
+    uint32_t seed;
+} usrapp_heap_test_t;
+
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ LOCAL VARIABLES ===============================*/
+
+static NO_INIT usrapp_heap_test_t __usrapp_heap;
+
+/*============================ PROTOTYPES ====================================*/
+/*============================ IMPLEMENTATION ================================*/
+
+static void * __usrapp_heap_tlsf_malloc(uint_fast32_t size)
+{
+    return vsf_tlsf_malloc_aligned(&__usrapp_heap.tlsf, size, 0);
+}
+
+static void __usrapp_heap_tlsf_free(void *buffer)
+{
+    vsf_tlsf_free(&__usrapp_heap.tlsf, buffer);
+}
+
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+static void __usrapp_heap_report(void)
+{
+    vsf_heap_statistics_t statistics;
+
+    vsf_heap_statistics(&statistics);
+    vsf_trace(VSF_TRACE_INFO, "heap_test: VSF_HEAP used %d/%d, max %d, %d free blocks, largest %d, fragmentation %d%%\r\n",
+            (int)statistics.used_size, (int)statistics.all_size, (int)statistics.max_used_size,
+            (int)statistics.free_num, (int)statistics.largest_free_size, (int)statistics.fragmentation);
+    vsf_trace(VSF_TRACE_INFO, "heap_test: VSF_HEAP %d allocated, %d freed, %d failed\r\n",
+            (int)statistics.alloc_cnt, (int)statistics.free_cnt, (int)statistics.fail_cnt);
+}
+#endif
+
+static uint_fast32_t __usrapp_heap_rand(void)
+{
+    __usrapp_heap.seed = __usrapp_heap.seed * 1103515245UL + 12345;
+    return __usrapp_heap.seed >> 8;
+}
+
+// 70% in [8, 128), 25% in [128, 1024), 5% in [1024, 8192)
+static uint_fast32_t __usrapp_heap_rand_size(void)
+{
+    uint_fast32_t r = __usrapp_heap_rand() % 100;
+    if (r < 70) {
+        return 8 + __usrapp_heap_rand() % 120;
+    } else if (r < 95) {
+        return 128 + __usrapp_heap_rand() % 896;
+    } else {
+        return 1024 + __usrapp_heap_rand() % 7168;
+    }
+}
+
+static void __usrapp_heap_test_run(const usrapp_heap_test_op_t *op)
+{
+    vsf_systimer_cnt_t start_tick, op_tick, max_tick = 0;
+    uint_fast32_t idx, fails = 0, total_us;
+    uintptr_t lowest = (uintptr_t)-1, highest = 0;
+    uint_fast32_t live = 0;
+
+    memset(__usrapp_heap.slot, 0, sizeof(__usrapp_heap.slot));
+    __usrapp_heap.seed = 0x5eed;
+
+    // random malloc/free mix, every slot is freed if allocated, or allocated if free
+    start_tick = vsf_systimer_get();
+    for (uint_fast32_t i = 0; i < APP_HEAP_TEST_CFG_OPS; i++) {
+        idx = __usrapp_heap_rand() % APP_HEAP_TEST_CFG_SLOT_NUM;
+
+        op_tick = vsf_systimer_get();
+        if (__usrapp_heap.slot[idx].buffer != NULL) {
+            op->free(__usrapp_heap.slot[idx].buffer);
+            __usrapp_heap.slot[idx].buffer = NULL;
+        } else {
+            __usrapp_heap.slot[idx].size = __usrapp_heap_rand_size();
+            __usrapp_heap.slot[idx].buffer = op->malloc(__usrapp_heap.slot[idx].size);
+            if (NULL == __usrapp_heap.slot[idx].buffer) {
+                fails++;
+            }
+        }
+        op_tick = vsf_systimer_get() - op_tick;
+        max_tick = max(max_tick, op_tick);
+    }
+    total_us = vsf_systimer_tick_to_us(vsf_systimer_get() - start_tick);
+    if (op->report != NULL) {
+        op->report();
+    }
+
+    // fragmentation: address span of the live buffers against the live bytes
+    for (idx = 0; idx < APP_HEAP_TEST_CFG_SLOT_NUM; idx++) {
+        if (__usrapp_heap.slot[idx].buffer != NULL) {
+            lowest = min(lowest, (uintptr_t)__usrapp_heap.slot[idx].buffer);
+            highest = max(highest, (uintptr_t)__usrapp_heap.slot[idx].buffer + __usrapp_heap.slot[idx].size);
+            live += __usrapp_heap.slot[idx].size;
+            op->free(__usrapp_heap.slot[idx].buffer);
+        }
+    }
+
+    vsf_trace(VSF_TRACE_INFO, "heap_test: %s %d ops, avg %d ns, max %d us, %d fails, span %d%% of live %d bytes\r\n",
+            op->name, APP_HEAP_TEST_CFG_OPS,
+            (int)((uint64_t)total_us * 1000 / APP_HEAP_TEST_CFG_OPS),
+            (int)vsf_systimer_tick_to_us(max_tick), (int)fails,
+            live ? (int)((uint64_t)(highest - lowest) * 100 / live) : 0, (int)live);
+}
+
+void usrapp_heap_test_start(void)
+{
+    const usrapp_heap_test_op_t ops[] = {
+        {
+            .name       = "VSF_HEAP",
+            .malloc     = VSF_HEAP.Malloc,
+            .free       = VSF_HEAP.Free,
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+            .report     = __usrapp_heap_report,
+#endif
+        },
+        {
+            .name       = "tlsf",
+            .malloc     = __usrapp_heap_tlsf_malloc,
+            .free       = __usrapp_heap_tlsf_free,
+        },
+    };
+    uint8_t *region = vsf_heap_malloc(APP_HEAP_TEST_CFG_TLSF_SIZE);
+
+    if (NULL == region) {
+        vsf_trace(VSF_TRACE_ERROR, "heap_test: fail to allocate tlsf region\r\n");
+        return;
+    }
+    vsf_tlsf_init(&__usrapp_heap.tlsf);
+    vsf_tlsf_add(&__usrapp_heap.tlsf, region, APP_HEAP_TEST_CFG_TLSF_SIZE);
+
+    for (int i = 0; i < dimof(ops); i++) {
+        __usrapp_heap_test_run(&ops[i]);
+    }
+    vsf_heap_free(region);
+}
+
+#if APP_USE_LINUX_DEMO == ENABLED
+int kernel_heap_test_main(int argc, char *argv[])
+{
+    usrapp_heap_test_start();
+    return 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,281 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+/*============================ INCLUDES ======================================*/
+
+#include "vsf.h"
+
+#if APP_USE_KERNEL_TEST == ENABLED && VSF_USE_POOL == ENABLED
+
+/*============================ MACROS ========================================*/
+
+// workers on every priority allocate and free items of one shared pool, pool
+//  is smaller than (worker_num * hold_num) so that it will be exhausted
+#ifndef APP_POOL_TEST_CFG_WORKER_NUM
+#   define APP_POOL_TEST_CFG_WORKER_NUM     4
+#endif
+#ifndef APP_POOL_TEST_CFG_HOLD_NUM
+#   define APP_POOL_TEST_CFG_HOLD_NUM       8
+#endif
+#ifndef APP_POOL_TEST_CFG_ITEM_NUM
+#   define APP_POOL_TEST_CFG_ITEM_NUM       (APP_POOL_TEST_CFG_WORKER_NUM * APP_POOL_TEST_CFG_HOLD_NUM / 2)
+#endif
+// alloc and free of every worker
+#ifndef APP_POOL_TEST_CFG_OPS
+#   define APP_POOL_TEST_CFG_OPS            1000000
+#endif
+// ops of every worker in one evt
+#define __APP_POOL_TEST_BATCH               1000
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+
+#if VSF_OS_CFG_PRIORITY_NUM > 1
+#   define __APP_POOL_TEST_WORKER_PRIO(__idx)                                   \
+            (vsf_prio_t)(vsf_prio_0 + ((__idx) % VSF_OS_CFG_PRIORITY_NUM))
+#else
+#   define __APP_POOL_TEST_WORKER_PRIO(__idx)       vsf_prio_0
+#endif
+
+/*============================ TYPES =========================================*/
+
+typedef struct usrapp_pool_test_item_t {
+    // owner and seq are stamped after allocated, and checked before freed
+    uint32_t owner;
+    uint32_t seq;
+    uint32_t payload[6];
+} usrapp_pool_test_item_t;
+
+dcl_vsf_pool(usrapp_pool_test_locked_pool)
+def_vsf_pool(usrapp_pool_test_locked_pool, usrapp_pool_test_item_t)
+dcl_vsf_pool(usrapp_pool_test_lock_free_pool)
+def_vsf_pool(usrapp_pool_test_lock_free_pool, usrapp_pool_test_item_t)
+
+typedef struct usrapp_pool_test_ops_t {
+    const char *name;
+    usrapp_pool_test_item_t * (*alloc)(void);
+    void (*free)(usrapp_pool_test_item_t *item);
+    uint_fast32_t (*count)(void);
+} usrapp_pool_test_ops_t;
+
+typedef struct usrapp_pool_test_worker_t {
+    vsf_eda_t eda;
+    usrapp_pool_test_item_t *hold[APP_POOL_TEST_CFG_HOLD_NUM];
+    uint32_t seq;
+    uint32_t remain;
+    uint32_t empty;
+    uint32_t seed;
+} usrapp_pool_test_worker_t;
+
+typedef struct usrapp_pool_test_t {
+    usrapp_pool_test_worker_t worker[APP_POOL_TEST_CFG_WORKER_NUM];
+    const usrapp_pool_test_ops_t *ops;
+    vsf_pool(usrapp_pool_test_locked_pool) locked_pool;
+    vsf_pool(usrapp_pool_test_lock_free_pool) lock_free_pool;
+
+    uint8_t ops_idx;
+    uint8_t running;
+    uint32_t errors;
+    vsf_systimer_cnt_t start_tick;
+} usrapp_pool_test_t;
+
+/*============================ PROTOTYPES ====================================*/
+
+static usrapp_pool_test_item_t * __usrapp_pool_locked_alloc(void);
+static void __usrapp_pool_locked_free(usrapp_pool_test_item_t *item);
+static uint_fast32_t __usrapp_pool_locked_count(void);
+static usrapp_pool_test_item_t * __usrapp_pool_lock_free_alloc(void);
+static void __usrapp_pool_lock_free_free(usrapp_pool_test_item_t *item);
+static uint_fast32_t __usrapp_pool_lock_free_count(void);
+
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ LOCAL VARIABLES ===============================*/
+
+static NO_INIT usrapp_pool_test_t __usrapp_pool;
+
+static const usrapp_pool_test_ops_t __usrapp_pool_ops[] = {
+    {
+        .name   = "locked",
+        .alloc  = __usrapp_pool_locked_alloc,
+        .free   = __usrapp_pool_locked_free,
+        .count  = __usrapp_pool_locked_count,
+    },
+    {
+        .name   = "lock-free",
+        .alloc  = __usrapp_pool_lock_free_alloc,
+        .free   = __usrapp_pool_lock_free_free,
+        .count  = __usrapp_pool_lock_free_count,
+    },
+};
+
+/*============================ IMPLEMENTATION ================================*/
+
+imp_vsf_pool(usrapp_pool_test_locked_pool, usrapp_pool_test_item_t)
+imp_vsf_pool_lock_free(usrapp_pool_test_lock_free_pool, usrapp_pool_test_item_t)
+
+static usrapp_pool_test_item_t * __usrapp_pool_locked_alloc(void)
+{
+    return VSF_POOL_ALLOC(usrapp_pool_test_locked_pool, &__usrapp_pool.locked_pool);
+}
+
+static void __usrapp_pool_locked_free(usrapp_pool_test_item_t *item)
+{
+    VSF_POOL_FREE(usrapp_pool_test_locked_pool, &__usrapp_pool.locked_pool, item);
+}
+
+static uint_fast32_t __usrapp_pool_locked_count(void)
+{
+    return VSF_POOL_ITEM_COUNT(usrapp_pool_test_locked_pool, &__usrapp_pool.locked_pool);
+}
+
+static usrapp_pool_test_item_t * __usrapp_pool_lock_free_alloc(void)
+{
+    return VSF_POOL_ALLOC(usrapp_pool_test_lock_free_pool, &__usrapp_pool.lock_free_pool);
+}
+
+static void __usrapp_pool_lock_free_free(usrapp_pool_test_item_t *item)
+{
+    VSF_POOL_FREE(usrapp_pool_test_lock_free_pool, &__usrapp_pool.lock_free_pool, item);
+}
+
+static uint_fast32_t __usrapp_pool_lock_free_count(void)
+{
+    return VSF_POOL_ITEM_COUNT(usrapp_pool_test_lock_free_pool, &__usrapp_pool.lock_free_pool);
+}
+
+static void __usrapp_pool_test_start(void);
+
+static void __usrapp_pool_test_done(void)
+{
+    const usrapp_pool_test_ops_t *ops = __usrapp_pool.ops;
+    uint_fast32_t us = vsf_systimer_tick_to_us(vsf_systimer_get() - __usrapp_pool.start_tick);
+    uint_fast32_t empty = 0;
+
+    for (int i = 0; i < dimof(__usrapp_pool.worker); i++) {
+        empty += __usrapp_pool.worker[i].empty;
+    }
+    // all items MUST be returned
+    if (ops->count() != APP_POOL_TEST_CFG_ITEM_NUM) {
+        __usrapp_pool.errors++;
+    }
+
+    vsf_trace(VSF_TRACE_INFO, "pool_test: %s %d ops/s, %d empty, %d errors" VSF_TRACE_CFG_LINEEND,
+            ops->name,
+            (int)((uint64_t)APP_POOL_TEST_CFG_WORKER_NUM * APP_POOL_TEST_CFG_OPS * 1000000 / (us ? us : 1)),
+            (int)empty, (int)__usrapp_pool.errors);
+
+    if (++__usrapp_pool.ops_idx < dimof(__usrapp_pool_ops)) {
+        __usrapp_pool_test_start();
+    }
+}
+
+static void __usrapp_pool_worker_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
+{
+    usrapp_pool_test_worker_t *worker = (usrapp_pool_test_worker_t *)eda;
+    const usrapp_pool_test_ops_t *ops = __usrapp_pool.ops;
+    uint_fast32_t owner = worker - &__usrapp_pool.worker[0];
+    usrapp_pool_test_item_t *item;
+    uint_fast32_t num, idx;
+
+    if (evt != VSF_EVT_USER) {
+        return;
+    }
+
+    num = min(worker->remain, __APP_POOL_TEST_BATCH);
+    worker->remain -= num;
+    while (num-- > 0) {
+        worker->seed = worker->seed * 1103515245 + 12345;
+        idx = (worker->seed >> 16) % APP_POOL_TEST_CFG_HOLD_NUM;
+        item = worker->hold[idx];
+        if (item != NULL) {
+            // item MUST not be allocated by others while held
+            if ((item->owner != owner) || (item->seq != item->payload[0])) {
+                __usrapp_pool.errors++;
+            }
+            ops->free(item);
+            worker->hold[idx] = NULL;
+        } else {
+            item = ops->alloc();
+            if (NULL == item) {
+                worker->empty++;
+                continue;
+            }
+            item->owner = owner;
+            item->seq = item->payload[0] = worker->seq++;
+            worker->hold[idx] = item;
+        }
+    }
+
+    if (worker->remain > 0) {
+        vsf_eda_post_evt(eda, VSF_EVT_USER);
+        return;
+    }
+
+    for (idx = 0; idx < APP_POOL_TEST_CFG_HOLD_NUM; idx++) {
+        if (worker->hold[idx] != NULL) {
+            ops->free(worker->hold[idx]);
+            worker->hold[idx] = NULL;
+        }
+    }
+    vsf_protect_t orig = vsf_protect_int();
+        bool is_last = 0 == --__usrapp_pool.running;
+    vsf_unprotect_int(orig);
+    if (is_last) {
+        __usrapp_pool_test_done();
+    }
+}
+
+static void __usrapp_pool_test_start(void)
+{
+    __usrapp_pool.ops = &__usrapp_pool_ops[__usrapp_pool.ops_idx];
+    __usrapp_pool.errors = 0;
+    __usrapp_pool.running = dimof(__usrapp_pool.worker);
+    __usrapp_pool.start_tick = vsf_systimer_get();
+    for (int i = 0; i < dimof(__usrapp_pool.worker); i++) {
+        __usrapp_pool.worker[i].remain = APP_POOL_TEST_CFG_OPS;
+        __usrapp_pool.worker[i].empty = 0;
+        vsf_eda_post_evt(&__usrapp_pool.worker[i].eda, VSF_EVT_USER);
+    }
+}
+
+void usrapp_pool_test_start(void)
+{
+    memset(&__usrapp_pool, 0, sizeof(__usrapp_pool));
+
+    VSF_POOL_INIT(usrapp_pool_test_locked_pool, &__usrapp_pool.locked_pool,
+            APP_POOL_TEST_CFG_ITEM_NUM);
+    VSF_POOL_INIT(usrapp_pool_test_lock_free_pool, &__usrapp_pool.lock_free_pool,
+            APP_POOL_TEST_CFG_ITEM_NUM);
+
+    for (int i = 0; i < dimof(__usrapp_pool.worker); i++) {
+        const vsf_eda_cfg_t cfg = {
+            .fn.evthandler  = __usrapp_pool_worker_evthandler,
+            .priority       = __APP_POOL_TEST_WORKER_PRIO(i),
+        };
+        __usrapp_pool.worker[i].seed = i + 1;
+        vsf_eda_start(&__usrapp_pool.worker[i].eda, (vsf_eda_cfg_t *)&cfg);
+    }
+    __usrapp_pool_test_start();
+}
+
+#if APP_USE_LINUX_DEMO == ENABLED
+int kernel_pool_test_main(int argc, char *argv[])
+{
+    usrapp_pool_test_start();
+    return 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,108 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+/*============================ INCLUDES ======================================*/
+
+#include "vsf.h"
+
+#if APP_USE_KERNEL_TEST == ENABLED && VSF_KERNEL_CFG_CALLBACK_TIMER == ENABLED
+
+/*============================ MACROS ========================================*/
+
+#ifndef APP_TIMQ_TEST_CFG_TIMER_NUM
+#   define APP_TIMQ_TEST_CFG_TIMER_NUM      10000
+#endif
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+
+typedef struct usrapp_timq_test_t {
+    vsf_callback_timer_t timer[APP_TIMQ_TEST_CFG_TIMER_NUM];
+    uint32_t fired;
+    vsf_systimer_cnt_t start_tick;
+} usrapp_timq_test_t;
+
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ LOCAL VARIABLES ===============================*/
+
+static NO_INIT usrapp_timq_test_t __usrapp_timq;
+
+/*============================ PROTOTYPES ====================================*/
+/*============================ IMPLEMENTATION ================================*/
+
+// timeouts scattered in [1, 4096] ms
+static uint_fast32_t __usrapp_timq_get_timeout(uint_fast32_t idx)
+{
+    return 1 + ((idx * 2654435761UL) >> 20) % 4096;
+}
+
+static uint_fast32_t __usrapp_timq_elapsed_us(vsf_systimer_cnt_t start_tick)
+{
+    return vsf_systimer_tick_to_us(vsf_systimer_get() - start_tick);
+}
+
+static void __usrapp_timq_on_timer(vsf_callback_timer_t *timer)
+{
+    if (++__usrapp_timq.fired == APP_TIMQ_TEST_CFG_TIMER_NUM) {
+        vsf_trace(VSF_TRACE_INFO, "timq_test: %d timers fired in %d ms\r\n",
+                APP_TIMQ_TEST_CFG_TIMER_NUM,
+                __usrapp_timq_elapsed_us(__usrapp_timq.start_tick) / 1000);
+    }
+}
+
+void usrapp_timq_test_start(void)
+{
+    vsf_callback_timer_t *timer = __usrapp_timq.timer;
+    vsf_systimer_cnt_t start_tick;
+    uint_fast32_t arm_us, cancel_us;
+
+    for (uint_fast32_t i = 0; i < dimof(__usrapp_timq.timer); i++) {
+        vsf_callback_timer_init(&timer[i]);
+        timer[i].on_timer = __usrapp_timq_on_timer;
+    }
+    __usrapp_timq.fired = 0;
+
+    start_tick = vsf_systimer_get();
+    for (uint_fast32_t i = 0; i < dimof(__usrapp_timq.timer); i++) {
+        vsf_callback_timer_add_ms(&timer[i], __usrapp_timq_get_timeout(i));
+    }
+    arm_us = __usrapp_timq_elapsed_us(start_tick);
+
+    start_tick = vsf_systimer_get();
+    for (uint_fast32_t i = 0; i < dimof(__usrapp_timq.timer); i++) {
+        vsf_callback_timer_remove(&timer[i]);
+    }
+    cancel_us = __usrapp_timq_elapsed_us(start_tick);
+
+    vsf_trace(VSF_TRACE_INFO, "timq_test: arm %d timers in %d us, cancel in %d us\r\n",
+            APP_TIMQ_TEST_CFG_TIMER_NUM, arm_us, cancel_us);
+
+    // arm again and let them expire
+    __usrapp_timq.start_tick = vsf_systimer_get();
+    for (uint_fast32_t i = 0; i < dimof(__usrapp_timq.timer); i++) {
+        vsf_callback_timer_add_ms(&timer[i], __usrapp_timq_get_timeout(i));
+    }
+}
+
+#if APP_USE_LINUX_DEMO == ENABLED
+int kernel_timq_test_main(int argc, char *argv[])
+{
+    usrapp_timq_test_start();
+    return 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,92 @@
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if VSF_USE_LINUX == ENABLED && VSF_USE_TCPIP == ENABLED && APP_USE_LINUX_CHECKSUM_BENCH_DEMO == ENABLED
+
+#include "component/tcpip/checksum/vsf_inet_checksum.h"
+
+// byte-wise implementation previously used in vsfip, as reference
+static uint_fast16_t __checksum_bench_ref(uint8_t *data, uint_fast32_t len)
+{
+    uint_fast32_t checksum = 0;
+
+    while (len > 1) {
+        checksum += get_unaligned_be16(data);
+        data += 2;
+        len -= 2;
+    }
+    if (1 == len) {
+        checksum += (uint_fast16_t)(*data) << 8;
+    }
+    checksum = (checksum & 0xFFFF) + (checksum >> 16);
+    checksum = (checksum & 0xFFFF) + (checksum >> 16);
+    return (uint_fast16_t)checksum;
+}
+
+// return throughput in MB/s, mode: 0 - reference, 1 - vk_inet_chksum,
+//  2 - memcpy + reference, 3 - vk_inet_chksum_copy
+static uint32_t __checksum_bench_run(int mode, uint8_t *dst, uint8_t *src, uint32_t size, uint32_t total)
+{
+    volatile uint_fast16_t result = 0;
+    uint32_t count = total / size;
+    uint64_t start = vsf_systimer_get_us(), elapse;
+
+    for (uint32_t i = 0; i < count; i++) {
+        switch (mode) {
+        case 0: result += __checksum_bench_ref(src, size);                      break;
+        case 1: result += vk_inet_chksum(src, size);                            break;
+        case 2: memcpy(dst, src, size); result += __checksum_bench_ref(dst, size); break;
+        case 3: result += vk_inet_chksum_copy(dst, src, size);                  break;
+        }
+    }
+    elapse = vsf_systimer_get_us() - start;
+    return elapse ? (uint32_t)((uint64_t)count * size / elapse) : 0;
+}
+
+int checksum_bench_main(int argc, char *argv[])
+{
+    static const uint32_t __sizes[] = { 40, 64, 576, 1460, 1500, 16 * 1024, 64 * 1024 };
+    uint32_t total = 256 * 1024 * 1024;
+    uint8_t *src, *dst;
+
+    if (argc > 2) {
+        printf("format: %s [total_bytes]\r\n", argv[0]);
+        return -1;
+    }
+    if (argc >= 2) {
+        total = strtoul(argv[1], NULL, 0);
+    }
+
+    src = malloc(64 * 1024 + 8);
+    dst = malloc(64 * 1024 + 8);
+    if ((NULL == src) || (NULL == dst)) {
+        printf("not enough resources\r\n");
+        goto free_buffers;
+    }
+    for (uint32_t i = 0; i < 64 * 1024 + 8; i++) {
+        src[i] = (uint8_t)rand();
+    }
+
+    printf("size(offset)    ref      chksum   memcpy+ref  chksum_copy (MB/s)\r\n");
+    for (uint32_t i = 0; i < dimof(__sizes); i++) {
+        for (uint32_t offset = 0; offset < 2; offset++) {
+            printf("%6d(%d)  %8d  %8d  %8d    %8d\r\n", (int)__sizes[i], (int)offset,
+                (int)__checksum_bench_run(0, dst, src + offset, __sizes[i], total),
+                (int)__checksum_bench_run(1, dst, src + offset, __sizes[i], total),
+                (int)__checksum_bench_run(2, dst, src + offset, __sizes[i], total),
+                (int)__checksum_bench_run(3, dst, src + offset, __sizes[i], total));
+        }
+    }
+
+free_buffers:
+    if (src != NULL) {
+        free(src);
+    }
+    if (dst != NULL) {
+        free(dst);
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,688 @@
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if     VSF_USE_LINUX == ENABLED && APP_USE_LINUX_FATFS_TEST_DEMO == ENABLED       \
+    &&  VSF_FS_USE_FATFS == ENABLED && VSF_MAL_USE_MMAP_MAL == ENABLED
+
+// files are written through fatfs, then the image is unmounted and checked
+//  by parsing FAT and directories directly from the mal
+
+#define __FATFS_TEST_ROOT_FILE_NUM      12
+#define __FATFS_TEST_SUB_FILE_NUM       48
+#define __FATFS_TEST_SUB_DIR            "sub dir"
+#define __FATFS_TEST_MAX_PATH           64
+#define __FATFS_TEST_MAX_ERR_PRINT      16
+
+typedef struct __fatfs_test_entry_t {
+    char path[__FATFS_TEST_MAX_PATH];
+    bool is_dir;
+    bool is_deleted;
+    bool is_found;
+    uint32_t size;
+    // range cleared by resize or by write after the end of file
+    uint32_t zero_start;
+    uint32_t zero_end;
+} __fatfs_test_entry_t;
+
+typedef struct __fatfs_test_t {
+    struct {
+        implement_fatfs_info(512, 4);
+    } fatfs;
+    vk_mmap_mal_t mal;
+
+    __fatfs_test_entry_t entries[1 + __FATFS_TEST_ROOT_FILE_NUM + __FATFS_TEST_SUB_FILE_NUM];
+    uint32_t entry_num;
+    uint32_t err_num;
+
+    // parameters of the volume parsed from the image
+    uint8_t type;
+    uint8_t fat_num;
+    uint32_t sector_size;
+    uint32_t cluster_size;
+    uint32_t cluster_num;
+    uint32_t fat_sector;
+    uint32_t fat_size;
+    uint32_t root_sector;
+    uint32_t root_size;
+    uint32_t data_sector;
+    uint32_t root_cluster;
+    // 2 sectors of FAT, entries of FAT12 may cross sector boundary
+    uint32_t fat_cache_sector;
+    uint8_t fat_cache[1024];
+    // bitmap of clusters reached from directories
+    uint8_t *used;
+    uint8_t *buffer;
+} __fatfs_test_t;
+
+// long name assembled from lfn entries before the short entry
+typedef struct __fatfs_test_lfn_t {
+    char name[__FATFS_TEST_MAX_PATH];
+    uint8_t num;
+    uint8_t checksum;
+} __fatfs_test_lfn_t;
+
+static const uint32_t __fatfs_test_sizes[__FATFS_TEST_ROOT_FILE_NUM] = {
+    0, 1, 511, 512, 513, 4095, 4096, 4097, 65543, 200003, 1000000, 33,
+};
+
+static uint8_t __fatfs_test_pattern(const __fatfs_test_entry_t *entry, uint32_t offset)
+{
+    if ((offset >= entry->zero_start) && (offset < entry->zero_end)) {
+        return 0;
+    }
+    return (uint8_t)(offset + (offset >> 8) * 13 + entry->path[0] + strlen(entry->path));
+}
+
+static void __fatfs_test_error(__fatfs_test_t *test, const char *path, const char *reason)
+{
+    if (test->err_num++ < __FATFS_TEST_MAX_ERR_PRINT) {
+        printf("%s: %s\r\n", path, reason);
+    }
+}
+
+/*============================ write through fatfs ===========================*/
+
+// name of entry in its parent directory
+static const char * __fatfs_test_name(const __fatfs_test_entry_t *entry)
+{
+    const char *name = strrchr(entry->path, '/');
+    return (name != NULL) ? name + 1 : entry->path;
+}
+
+static vk_file_t * __fatfs_test_create(vk_file_t *dir, __fatfs_test_entry_t *entry)
+{
+    const char *name = __fatfs_test_name(entry);
+    vk_file_t *file;
+
+    vk_file_create(dir, name, entry->is_dir ? VSF_FILE_ATTR_DIRECTORY : VSF_FILE_ATTR_READ | VSF_FILE_ATTR_WRITE, 0);
+    if ((vsf_err_t)vsf_eda_get_return_value() != VSF_ERR_NONE) {
+        return NULL;
+    }
+    vk_file_open(dir, name, 0, &file);
+    return file;
+}
+
+static bool __fatfs_test_write(vk_file_t *file, __fatfs_test_entry_t *entry,
+            uint32_t offset, uint32_t size, uint8_t *buffer)
+{
+    for (uint32_t i = 0; i < size; i++) {
+        buffer[i] = __fatfs_test_pattern(entry, offset + i);
+    }
+    vk_file_write(file, offset, size, buffer);
+    return (int32_t)vsf_eda_get_return_value() == (int32_t)size;
+}
+
+// write the whole file in chunks of chunk_size
+static bool __fatfs_test_fill(vk_file_t *dir, __fatfs_test_entry_t *entry, uint32_t chunk_size, uint8_t *buffer)
+{
+    vk_file_t *file = __fatfs_test_create(dir, entry);
+    uint32_t size;
+    bool result = true;
+
+    if (NULL == file) {
+        return false;
+    }
+    for (uint32_t offset = 0; result && (offset < entry->size); offset += size) {
+        size = min(chunk_size, entry->size - offset);
+        result = __fatfs_test_write(file, entry, offset, size, buffer);
+    }
+    vk_file_close(file);
+    return result;
+}
+
+static bool __fatfs_test_resize(vk_file_t *dir, __fatfs_test_entry_t *entry, uint32_t size)
+{
+    vk_file_t *file;
+
+    vk_file_open(dir, __fatfs_test_name(entry), 0, &file);
+    if (NULL == file) {
+        return false;
+    }
+    vk_file_resize(file, size);
+    if ((vsf_err_t)vsf_eda_get_return_value() != VSF_ERR_NONE) {
+        vk_file_close(file);
+        return false;
+    }
+    if (size > entry->size) {
+        entry->zero_start = entry->size;
+        entry->zero_end = size;
+    }
+    entry->size = size;
+    vk_file_close(file);
+    return true;
+}
+
+// write size bytes at offset after the end of file
+static bool __fatfs_test_append(vk_file_t *dir, __fatfs_test_entry_t *entry,
+            uint32_t offset, uint32_t size, uint8_t *buffer)
+{
+    vk_file_t *file;
+    bool result;
+
+    vk_file_open(dir, __fatfs_test_name(entry), 0, &file);
+    if (NULL == file) {
+        return false;
+    }
+    entry->zero_start = entry->size;
+    entry->zero_end = offset;
+    entry->size = offset + size;
+    result = __fatfs_test_write(file, entry, offset, size, buffer);
+    vk_file_close(file);
+    return result;
+}
+
+static bool __fatfs_test_unlink(vk_file_t *dir, __fatfs_test_entry_t *entry)
+{
+    vk_file_unlink(dir, __fatfs_test_name(entry));
+    if ((vsf_err_t)vsf_eda_get_return_value() != VSF_ERR_NONE) {
+        return false;
+    }
+    entry->is_deleted = true;
+    return true;
+}
+
+static bool __fatfs_test_run(__fatfs_test_t *test, vk_file_t *root)
+{
+    __fatfs_test_entry_t *entry = test->entries, *files = &test->entries[1];
+    __fatfs_test_entry_t *sub_files = &files[__FATFS_TEST_ROOT_FILE_NUM];
+    vk_file_t *sub;
+    uint32_t i;
+
+    // sub directory with enough lfn entries to be extended over clusters
+    strcpy(entry->path, __FATFS_TEST_SUB_DIR);
+    entry->is_dir = true;
+    sub = __fatfs_test_create(root, entry);
+    if (NULL == sub) {
+        printf("fail to create %s\r\n", entry->path);
+        return false;
+    }
+    for (i = 0; i < __FATFS_TEST_SUB_FILE_NUM; i++) {
+        entry = &sub_files[i];
+        snprintf(entry->path, sizeof(entry->path), __FATFS_TEST_SUB_DIR "/file in sub dir %d.txt", (int)i);
+        entry->size = i * 100 + 1;
+        if (!__fatfs_test_fill(sub, entry, 97, test->buffer)) {
+            printf("fail to write %s\r\n", entry->path);
+            goto close_sub;
+        }
+    }
+
+    // files of sizes around sector and cluster boundaries, written in unaligned chunks
+    for (i = 0; i < __FATFS_TEST_ROOT_FILE_NUM; i++) {
+        entry = &files[i];
+        if (i & 1) {
+            snprintf(entry->path, sizeof(entry->path), "F%d.BIN", (int)i);
+        } else {
+            snprintf(entry->path, sizeof(entry->path), "long file name %d.dat", (int)i);
+        }
+        entry->size = __fatfs_test_sizes[i];
+        if (!__fatfs_test_fill(root, entry, 1000 + i * 37, test->buffer)) {
+            printf("fail to write %s\r\n", entry->path);
+            goto close_sub;
+        }
+    }
+
+    if (    !__fatfs_test_resize(root, &files[9], 70001)
+        ||  !__fatfs_test_resize(root, &files[8], 90000)
+        ||  !__fatfs_test_append(root, &files[6], 10000, 100, test->buffer)) {
+        printf("fail to resize or append\r\n");
+        goto close_sub;
+    }
+    for (i = 0; i < __FATFS_TEST_SUB_FILE_NUM; i += 2) {
+        if (!__fatfs_test_unlink(sub, &sub_files[i])) {
+            printf("fail to unlink %s\r\n", sub_files[i].path);
+            goto close_sub;
+        }
+    }
+    if (!__fatfs_test_unlink(root, &files[3]) || !__fatfs_test_unlink(root, &files[5])) {
+        printf("fail to unlink\r\n");
+        goto close_sub;
+    }
+    vk_file_close(sub);
+    return true;
+
+close_sub:
+    vk_file_close(sub);
+    return false;
+}
+
+/*============================ check image ===================================*/
+
+static bool __fatfs_test_read(__fatfs_test_t *test, uint64_t sector, uint32_t size, uint8_t *buffer)
+{
+    vk_mal_read(&test->mal.use_as__vk_mal_t, sector * test->sector_size, size, buffer);
+    return (int32_t)vsf_eda_get_return_value() == (int32_t)size;
+}
+
+static uint32_t __fatfs_test_get_fat(__fatfs_test_t *test, uint32_t cluster)
+{
+    uint32_t offset, sector, value;
+
+    switch (test->type) {
+    case 12:    offset = cluster + (cluster >> 1);  break;
+    case 16:    offset = cluster << 1;              break;
+    default:    offset = cluster << 2;              break;
+    }
+    sector = test->fat_sector + offset / test->sector_size;
+    offset %= test->sector_size;
+    if (sector != test->fat_cache_sector) {
+        if (!__fatfs_test_read(test, sector, 2 * test->sector_size, test->fat_cache)) {
+            __fatfs_test_error(test, "/", "fail to read FAT");
+            return 0;
+        }
+        test->fat_cache_sector = sector;
+    }
+
+    switch (test->type) {
+    case 12:
+        value = get_unaligned_le16(&test->fat_cache[offset]);
+        return (cluster & 1) ? value >> 4 : value & 0xFFF;
+    case 16:
+        return get_unaligned_le16(&test->fat_cache[offset]);
+    default:
+        return get_unaligned_le32(&test->fat_cache[offset]) & 0x0FFFFFFF;
+    }
+}
+
+static bool __fatfs_test_is_eoc(__fatfs_test_t *test, uint32_t value)
+{
+    switch (test->type) {
+    case 12:    return value >= 0xFF8;
+    case 16:    return value >= 0xFFF8;
+    default:    return value >= 0x0FFFFFF8;
+    }
+}
+
+static bool __fatfs_test_read_cluster(__fatfs_test_t *test, uint32_t cluster, uint8_t *buffer)
+{
+    uint32_t sectors_per_cluster = test->cluster_size / test->sector_size;
+    return __fatfs_test_read(test, test->data_sector + (uint64_t)(cluster - 2) * sectors_per_cluster,
+                test->cluster_size, buffer);
+}
+
+static bool __fatfs_test_parse_dbr(__fatfs_test_t *test, uint8_t *dbr)
+{
+    uint32_t reserved, total, root_entry;
+
+    test->sector_size = get_unaligned_le16(&dbr[11]);
+    test->cluster_size = dbr[13] * test->sector_size;
+    reserved = get_unaligned_le16(&dbr[14]);
+    test->fat_num = dbr[16];
+    root_entry = get_unaligned_le16(&dbr[17]);
+    total = get_unaligned_le16(&dbr[19]);
+    if (0 == total) {
+        total = get_unaligned_le32(&dbr[32]);
+    }
+    test->fat_size = get_unaligned_le16(&dbr[22]);
+    if (0 == test->fat_size) {
+        test->fat_size = get_unaligned_le32(&dbr[36]);
+    }
+    if (    (get_unaligned_le16(&dbr[510]) != 0xAA55) || (test->sector_size != 512)
+        ||  !test->cluster_size || !test->fat_num || !test->fat_size) {
+        return false;
+    }
+
+    test->fat_sector = reserved;
+    test->fat_cache_sector = 0;
+    test->root_sector = reserved + test->fat_num * test->fat_size;
+    test->root_size = (root_entry * 32 + test->sector_size - 1) / test->sector_size;
+    test->data_sector = test->root_sector + test->root_size;
+    test->cluster_num = (total - test->data_sector) / dbr[13];
+    test->type = (test->cluster_num < 4085) ? 12 : (test->cluster_num < 65525) ? 16 : 32;
+    test->root_cluster = (32 == test->type) ? get_unaligned_le32(&dbr[44]) : 0;
+    return true;
+}
+
+// mark clusters of the chain as used, returns number of clusters, or -1 if chain is broken
+static int32_t __fatfs_test_walk_chain(__fatfs_test_t *test, const char *path, uint32_t cluster)
+{
+    int32_t num = 0;
+
+    while (cluster != 0) {
+        if ((cluster < 2) || (cluster >= test->cluster_num + 2)) {
+            __fatfs_test_error(test, path, "chain points out of volume");
+            return -1;
+        }
+        if (test->used[cluster >> 3] & (1 << (cluster & 7))) {
+            __fatfs_test_error(test, path, "cross-linked cluster");
+            return -1;
+        }
+        test->used[cluster >> 3] |= 1 << (cluster & 7);
+        num++;
+
+        cluster = __fatfs_test_get_fat(test, cluster);
+        if (__fatfs_test_is_eoc(test, cluster)) {
+            break;
+        } else if (0 == cluster) {
+            __fatfs_test_error(test, path, "chain ends with free cluster");
+            return -1;
+        }
+    }
+    return num;
+}
+
+static __fatfs_test_entry_t * __fatfs_test_find(__fatfs_test_t *test, const char *path)
+{
+    for (uint32_t i = 0; i < test->entry_num; i++) {
+        if (!test->entries[i].is_deleted && !strcasecmp(test->entries[i].path, path)) {
+            return &test->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void __fatfs_test_check_file(__fatfs_test_t *test, __fatfs_test_entry_t *entry,
+            uint32_t cluster, uint32_t size)
+{
+    int32_t num = __fatfs_test_walk_chain(test, entry->path, cluster);
+    uint8_t *data;
+
+    if (num < 0) {
+        return;
+    }
+    if (size != entry->size) {
+        __fatfs_test_error(test, entry->path, "size mismatch");
+        return;
+    }
+    if ((uint32_t)num != (size + test->cluster_size - 1) / test->cluster_size) {
+        __fatfs_test_error(test, entry->path, "chain length does not match size");
+        return;
+    }
+    if (0 == num) {
+        return;
+    }
+
+    data = malloc(test->cluster_size);
+    if (NULL == data) {
+        __fatfs_test_error(test, entry->path, "not enough resources");
+        return;
+    }
+    for (uint32_t offset = 0; offset < size; offset += test->cluster_size) {
+        if (!__fatfs_test_read_cluster(test, cluster, data)) {
+            __fatfs_test_error(test, entry->path, "fail to read data");
+            break;
+        }
+        for (uint32_t i = 0; (i < test->cluster_size) && (offset + i < size); i++) {
+            if (data[i] != __fatfs_test_pattern(entry, offset + i)) {
+                __fatfs_test_error(test, entry->path, "data mismatch");
+                goto free_data;
+            }
+        }
+        cluster = __fatfs_test_get_fat(test, cluster);
+    }
+free_data:
+    free(data);
+}
+
+static void __fatfs_test_check_dir(__fatfs_test_t *test, const char *path,
+            uint32_t cluster, uint32_t parent_cluster);
+
+// returns false at the end of the directory
+static bool __fatfs_test_check_dentry(__fatfs_test_t *test, const char *path,
+            uint32_t cluster, uint32_t parent_cluster, uint8_t *dentry, __fatfs_test_lfn_t *lfn)
+{
+    static const uint8_t __lfn_offsets[13] = { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 };
+    char child[__FATFS_TEST_MAX_PATH];
+    __fatfs_test_entry_t *entry;
+    uint32_t child_cluster;
+    uint8_t checksum = 0;
+
+    if (0 == dentry[0]) {
+        return false;
+    } else if (0xE5 == dentry[0]) {
+        lfn->num = 0;
+        return true;
+    }
+
+    if (0x0F == dentry[11]) {
+        uint32_t idx = ((dentry[0] & 0x1F) - 1) * 13;
+
+        if (dentry[0] & 0x40) {
+            memset(lfn->name, 0, sizeof(lfn->name));
+            lfn->num = dentry[0] & 0x1F;
+            lfn->checksum = dentry[13];
+        } else if (!lfn->num || (dentry[13] != lfn->checksum)) {
+            __fatfs_test_error(test, path, "orphan lfn entry");
+            lfn->num = 0;
+            return true;
+        }
+        for (uint32_t i = 0; i < 13; i++) {
+            uint16_t ch = get_unaligned_le16(&dentry[__lfn_offsets[i]]);
+            if ((idx + i < sizeof(lfn->name) - 1) && (ch != 0) && (ch != 0xFFFF)) {
+                lfn->name[idx + i] = (char)ch;
+            }
+        }
+        return true;
+    } else if (dentry[11] & 0x08) {
+        // volume label
+        lfn->num = 0;
+        return true;
+    }
+
+    for (uint32_t i = 0; i < 11; i++) {
+        checksum = ((checksum & 1) << 7) + (checksum >> 1) + dentry[i];
+    }
+    if (lfn->num && (checksum != lfn->checksum)) {
+        __fatfs_test_error(test, path, "lfn checksum mismatch");
+    } else if (!lfn->num) {
+        char *cur = lfn->name;
+        for (uint32_t i = 0; (i < 8) && (dentry[i] != ' '); i++) {
+            *cur++ = (char)dentry[i];
+        }
+        if (dentry[8] != ' ') {
+            *cur++ = '.';
+            for (uint32_t i = 8; (i < 11) && (dentry[i] != ' '); i++) {
+                *cur++ = (char)dentry[i];
+            }
+        }
+        *cur = '\0';
+    }
+    lfn->num = 0;
+
+    child_cluster = (get_unaligned_le16(&dentry[20]) << 16) | get_unaligned_le16(&dentry[26]);
+    if (!strcmp(lfn->name, ".") || !strcmp(lfn->name, "..")) {
+        if (child_cluster != (('.' == lfn->name[1]) ? parent_cluster : cluster)) {
+            __fatfs_test_error(test, path, "dot entry points to wrong cluster");
+        }
+        return true;
+    }
+
+    if (cluster == test->root_cluster) {
+        snprintf(child, sizeof(child), "%s", lfn->name);
+    } else {
+        snprintf(child, sizeof(child), "%s/%s", path, lfn->name);
+    }
+    entry = __fatfs_test_find(test, child);
+    if (NULL == entry) {
+        __fatfs_test_error(test, child, "unexpected entry");
+        return true;
+    }
+    entry->is_found = true;
+    if (entry->is_dir != !!(dentry[11] & 0x10)) {
+        __fatfs_test_error(test, child, "type mismatch");
+    } else if (entry->is_dir) {
+        // ".." of directories in root points to cluster 0, even for FAT32
+        __fatfs_test_check_dir(test, child, child_cluster, (cluster == test->root_cluster) ? 0 : cluster);
+    } else {
+        __fatfs_test_check_file(test, entry, child_cluster, get_unaligned_le32(&dentry[28]));
+    }
+    return true;
+}
+
+static void __fatfs_test_check_dir(__fatfs_test_t *test, const char *path,
+            uint32_t cluster, uint32_t parent_cluster)
+{
+    __fatfs_test_lfn_t lfn = { .num = 0 };
+    uint32_t size, num, next, i;
+    uint8_t *buffer;
+    bool is_end = false;
+
+    if (0 == cluster) {
+        // fixed root directory of FAT12/16, read sector by sector
+        size = test->sector_size;
+        num = test->root_size;
+    } else {
+        int32_t chain_num = __fatfs_test_walk_chain(test, path, cluster);
+        if (chain_num <= 0) {
+            if (0 == chain_num) {
+                __fatfs_test_error(test, path, "directory without cluster");
+            }
+            return;
+        }
+        size = test->cluster_size;
+        num = chain_num;
+    }
+    buffer = malloc(size);
+    if (NULL == buffer) {
+        __fatfs_test_error(test, path, "not enough resources");
+        return;
+    }
+
+    for (next = cluster; !is_end && (num > 0); num--) {
+        if (    ((0 == cluster) && !__fatfs_test_read(test, test->root_sector + test->root_size - num, size, buffer))
+            ||  ((cluster != 0) && !__fatfs_test_read_cluster(test, next, buffer))) {
+            __fatfs_test_error(test, path, "fail to read directory");
+            break;
+        }
+        // entries in sub directories may change fat cache, so get next cluster first
+        if (cluster != 0) {
+            next = __fatfs_test_get_fat(test, next);
+        }
+        for (i = 0; i < size; i += 32) {
+            if (!__fatfs_test_check_dentry(test, path, cluster, parent_cluster, &buffer[i], &lfn)) {
+                is_end = true;
+                break;
+            }
+        }
+    }
+    free(buffer);
+}
+
+static void __fatfs_test_check(__fatfs_test_t *test)
+{
+    uint8_t *fat0 = test->buffer, *fat = test->buffer + 512;
+    uint32_t lost = 0;
+
+    if (!__fatfs_test_read(test, 0, 512, test->buffer) || !__fatfs_test_parse_dbr(test, test->buffer)) {
+        __fatfs_test_error(test, "/", "invalid dbr");
+        return;
+    }
+    printf("FAT%d, %d clusters of %d bytes\r\n", test->type, (int)test->cluster_num, (int)test->cluster_size);
+
+    // all FAT copies MUST be identical
+    for (uint32_t sector = 0; sector < test->fat_size; sector++) {
+        if (!__fatfs_test_read(test, test->fat_sector + sector, 512, fat0)) {
+            __fatfs_test_error(test, "/", "fail to read FAT");
+            return;
+        }
+        for (uint32_t i = 1; i < test->fat_num; i++) {
+            if (    !__fatfs_test_read(test, test->fat_sector + i * test->fat_size + sector, 512, fat)
+                ||  memcmp(fat, fat0, 512)) {
+                __fatfs_test_error(test, "/", "FAT copies differ");
+                break;
+            }
+        }
+    }
+
+    test->used = calloc(1, (test->cluster_num + 2 + 7) >> 3);
+    if (NULL == test->used) {
+        __fatfs_test_error(test, "/", "not enough resources");
+        return;
+    }
+    __fatfs_test_check_dir(test, "/", test->root_cluster, 0);
+    for (uint32_t i = 0; i < test->entry_num; i++) {
+        if (!test->entries[i].is_deleted && !test->entries[i].is_found) {
+            __fatfs_test_error(test, test->entries[i].path, "not found");
+        }
+    }
+    // clusters allocated in FAT but not reached from any directory
+    for (uint32_t i = 2; i < test->cluster_num + 2; i++) {
+        if (!(test->used[i >> 3] & (1 << (i & 7))) && (__fatfs_test_get_fat(test, i) != 0)) {
+            lost++;
+        }
+    }
+    if (lost > 0) {
+        printf("%d lost clusters\r\n", (int)lost);
+        test->err_num++;
+    }
+    free(test->used);
+}
+
+// image should be an empty FAT12/16/32 volume without partition table, eg: mkfs.fat -C image 65536
+int fatfs_test_main(int argc, char *argv[])
+{
+    __fatfs_test_t *test;
+    vk_file_t *dir = NULL;
+    int result = -1;
+
+    if (argc != 3) {
+        printf("format: %s host_image target_dir\r\n", argv[0]);
+        printf("  host_image is an empty FAT volume, eg: mkfs.fat -C image 65536\r\n");
+        return -1;
+    }
+
+    // malfs cache in fatfs info is too large for thread stack
+    test = calloc(1, sizeof(*test));
+    if (test != NULL) {
+        test->buffer = malloc(4096);
+    }
+    if ((NULL == test) || (NULL == test->buffer)) {
+        printf("not enough resources\r\n");
+        goto free_test;
+    }
+    test->entry_num = dimof(test->entries);
+
+    vk_file_open(NULL, argv[2], 0, &dir);
+    if ((NULL == dir) || !(dir->attr & VSF_FILE_ATTR_DIRECTORY)) {
+        printf("fail to open target_dir %s\r\n", argv[2]);
+        goto free_test;
+    }
+
+    test->mal.path = argv[1];
+    test->mal.drv = &vk_mmap_mal_drv;
+    test->mal.block_size = 512;
+    vk_mal_init(&test->mal.use_as__vk_mal_t);
+    if ((vsf_err_t)vsf_eda_get_return_value() != VSF_ERR_NONE) {
+        printf("fail to open host_image %s\r\n", argv[1]);
+        goto free_test;
+    }
+
+    test->fatfs.mal = &test->mal.use_as__vk_mal_t;
+    init_fatfs_info_ex((&test->fatfs), 512, 4, (&test->fatfs));
+    vk_fs_mount(dir, &vk_fatfs_op, &test->fatfs.use_as____vk_fatfs_info_t);
+    if ((vsf_err_t)vsf_eda_get_return_value() != VSF_ERR_NONE) {
+        printf("fail to mount host_image %s\r\n", argv[1]);
+        goto fini_mal;
+    }
+    if (!__fatfs_test_run(test, dir)) {
+        vk_fs_unmount(dir);
+        goto fini_mal;
+    }
+    // FAT updates and malfs cache are flushed in unmount
+    vk_fs_unmount(dir);
+
+    __fatfs_test_check(test);
+    if (test->err_num > 0) {
+        printf("%d errors\r\n", (int)test->err_num);
+    } else {
+        printf("image check passed\r\n");
+        result = 0;
+    }
+
+fini_mal:
+    vk_mal_fini(&test->mal.use_as__vk_mal_t);
+free_test:
+    if (dir != NULL) {
+        vk_file_close(dir);
+    }
+    if (test != NULL) {
+        if (test->buffer != NULL) {
+            free(test->buffer);
+        }
+        free(test);
+    }
+    return result;
+}
+
+#endif
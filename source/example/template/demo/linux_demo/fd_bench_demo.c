@@ -0,0 +1,188 @@
+#define __VSF_LINUX_CLASS_INHERIT__
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+
+#if VSF_USE_LINUX == ENABLED && APP_USE_LINUX_FD_BENCH_DEMO == ENABLED
+
+#define __FD_BENCH_IDLE_NUM             1000
+#define __FD_BENCH_READ_FD_NUM          500
+
+static int __fd_bench_fcntl(vsf_linux_fd_t *sfd, int cmd, long arg)
+{
+    return 0;
+}
+
+static ssize_t __fd_bench_read(vsf_linux_fd_t *sfd, void *buf, size_t count)
+{
+    return 0;
+}
+
+static ssize_t __fd_bench_write(vsf_linux_fd_t *sfd, void *buf, size_t count)
+{
+    return count;
+}
+
+static int __fd_bench_close(vsf_linux_fd_t *sfd)
+{
+    return 0;
+}
+
+// dummy fd, events are generated by vsf_linux_fd_rx_trigger
+static const vsf_linux_fd_op_t __fd_bench_fdop = {
+    .fn_fcntl           = __fd_bench_fcntl,
+    .fn_read            = __fd_bench_read,
+    .fn_write           = __fd_bench_write,
+    .fn_close           = __fd_bench_close,
+};
+
+int epoll_bench_main(int argc, char *argv[])
+{
+    struct epoll_event event, events[8];
+    struct pollfd *fds = NULL;
+    uint32_t count = 1000, i;
+    int epfd = -1, fdnum = 0, active, ret;
+    uint64_t start, elapse;
+
+    if (argc > 2) {
+        printf("format: %s [iterations]\r\n", argv[0]);
+        return -1;
+    }
+    if (argc >= 2) {
+        count = strtoul(argv[1], NULL, 0);
+    }
+
+    fds = malloc((__FD_BENCH_IDLE_NUM + 1) * sizeof(struct pollfd));
+    epfd = epoll_create1(0);
+    if ((NULL == fds) || (epfd < 0)) {
+        printf("not enough resources\r\n");
+        goto cleanup;
+    }
+
+    // idle fds first, the active one is the last
+    for (; fdnum <= __FD_BENCH_IDLE_NUM; fdnum++) {
+        fds[fdnum].fd = vsf_linux_create_fd(NULL, &__fd_bench_fdop);
+        if (fds[fdnum].fd < 0) {
+            printf("fail to create fd\r\n");
+            goto cleanup;
+        }
+        fds[fdnum].events = POLLIN;
+
+        event.events = EPOLLIN;
+        event.data.fd = fds[fdnum].fd;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, fds[fdnum].fd, &event);
+    }
+    active = fds[__FD_BENCH_IDLE_NUM].fd;
+    printf("%d idle fds, 1 active fd, %d iterations\r\n", __FD_BENCH_IDLE_NUM, (int)count);
+
+    start = vsf_systimer_get_us();
+    for (i = 0; i < count; i++) {
+        vsf_linux_fd_rx_trigger(active);
+        ret = epoll_wait(epfd, events, dimof(events), 0);
+        if ((ret != 1) || (events[0].data.fd != active)) {
+            printf("epoll_wait fail: %d\r\n", ret);
+            goto cleanup;
+        }
+        vsf_linux_fd_rx_pend(active);
+    }
+    elapse = vsf_systimer_get_us() - start;
+    printf("epoll_wait: %d ns/iteration\r\n", (int)(elapse * 1000 / count));
+
+    start = vsf_systimer_get_us();
+    for (i = 0; i < count; i++) {
+        vsf_linux_fd_rx_trigger(active);
+        ret = poll(fds, __FD_BENCH_IDLE_NUM + 1, 0);
+        if ((ret != 1) || !(fds[__FD_BENCH_IDLE_NUM].revents & POLLIN)) {
+            printf("poll fail: %d\r\n", ret);
+            goto cleanup;
+        }
+        vsf_linux_fd_rx_pend(active);
+    }
+    elapse = vsf_systimer_get_us() - start;
+    printf("poll:       %d ns/iteration\r\n", (int)(elapse * 1000 / count));
+
+    // timeout accuracy, nothing is ready
+    start = vsf_systimer_get_us();
+    ret = epoll_wait(epfd, events, dimof(events), 10);
+    elapse = vsf_systimer_get_us() - start;
+    printf("epoll_wait(10ms) returns %d after %d us\r\n", ret, (int)elapse);
+
+    start = vsf_systimer_get_us();
+    ret = poll(fds, __FD_BENCH_IDLE_NUM + 1, 10);
+    elapse = vsf_systimer_get_us() - start;
+    printf("poll(10ms) returns %d after %d us\r\n", ret, (int)elapse);
+
+cleanup:
+    if (epfd >= 0) {
+        close(epfd);
+    }
+    while (fdnum > 0) {
+        close(fds[--fdnum].fd);
+    }
+    if (fds != NULL) {
+        free(fds);
+    }
+    return 0;
+}
+
+int fd_bench_main(int argc, char *argv[])
+{
+    uint32_t count = 1000000, i;
+    int *fds, fdnum = 0, fd;
+    uint8_t buf[4];
+    uint64_t start, elapse;
+
+    if (argc > 2) {
+        printf("format: %s [iterations]\r\n", argv[0]);
+        return -1;
+    }
+    if (argc >= 2) {
+        count = strtoul(argv[1], NULL, 0);
+    }
+
+    fds = malloc(__FD_BENCH_READ_FD_NUM * sizeof(int));
+    if (NULL == fds) {
+        printf("not enough resources\r\n");
+        return -1;
+    }
+    for (; fdnum < __FD_BENCH_READ_FD_NUM; fdnum++) {
+        fds[fdnum] = vsf_linux_create_fd(NULL, &__fd_bench_fdop);
+        if (fds[fdnum] < 0) {
+            printf("fail to create fd\r\n");
+            goto cleanup;
+        }
+    }
+
+    fd = fds[__FD_BENCH_READ_FD_NUM - 1];
+    start = vsf_systimer_get_us();
+    for (i = 0; i < count; i++) {
+        read(fd, buf, sizeof(buf));
+    }
+    elapse = vsf_systimer_get_us() - start;
+    printf("read on fd %d: %d ns/call\r\n", fd, (int)(elapse * 1000 / count));
+
+    // lowest free fd is reused, dup shares the file until the last close
+    close(fds[0]);
+    fd = dup(fds[1]);
+    printf("dup(%d) = %d, expected %d\r\n", fds[1], fd, fds[0]);
+    close(fds[1]);
+    printf("read on dup fd after closing original: %d\r\n", (int)read(fd, buf, sizeof(buf)));
+    fds[1] = dup2(fd, fds[1]);
+    fds[0] = fd;
+    printf("dup2(%d, %d) = %d\r\n", fds[0], fds[1], fds[1]);
+    fd = fcntl(fds[1], F_DUPFD, 600);
+    printf("fcntl(%d, F_DUPFD, 600) = %d\r\n", fds[1], fd);
+    close(fd);
+
+cleanup:
+    while (fdnum > 0) {
+        close(fds[--fdnum]);
+    }
+    free(fds);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,661 @@
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#if VSF_USE_LINUX == ENABLED && APP_USE_LINUX_FS_BENCH_DEMO == ENABLED
+
+static int32_t __fs_bench_read(vk_file_t *file, uint64_t offset, uint32_t size, uint8_t *buff)
+{
+    vk_file_read(file, offset, size, buff);
+    return (int32_t)vsf_eda_get_return_value();
+}
+
+// random reads of block_size at sector aligned offsets, return average time in us
+static uint32_t __fs_bench_random(vk_file_t *file, uint8_t *buff, uint32_t block_size, uint32_t count)
+{
+    uint64_t start = vsf_systimer_get_us(), offset;
+    uint32_t sector_num = (uint32_t)(file->size >> 9);
+
+    srand(0);
+    for (uint32_t i = 0; i < count; i++) {
+        offset = (((uint64_t)rand() << 16) ^ rand()) % sector_num;
+        if (__fs_bench_read(file, offset << 9, block_size, buff) < 0) {
+            printf("fail to read at %llu\r\n", (unsigned long long)(offset << 9));
+            return 0;
+        }
+    }
+    return (uint32_t)((vsf_systimer_get_us() - start) / count);
+}
+
+int fs_bench_main(int argc, char *argv[])
+{
+    vk_file_t *file;
+    uint8_t *buff;
+    uint32_t block_size = 64 * 1024, count = 1000;
+    uint64_t offset, start, elapse;
+    int32_t rsize;
+
+    if ((argc < 2) || (argc > 4)) {
+        printf("format: %s file [block_size] [random_count]\r\n", argv[0]);
+        return -1;
+    }
+    if (argc >= 3) {
+        block_size = strtoul(argv[2], NULL, 0);
+    }
+    if (argc >= 4) {
+        count = strtoul(argv[3], NULL, 0);
+    }
+
+    buff = malloc(block_size);
+    if (NULL == buff) {
+        printf("not enough resources\r\n");
+        return -1;
+    }
+
+    vk_file_open(NULL, argv[1], 0, &file);
+    if (NULL == file) {
+        printf("fail to open %s\r\n", argv[1]);
+        free(buff);
+        return -1;
+    }
+    if (file->size < 512) {
+        printf("%s is too small\r\n", argv[1]);
+        goto close_file;
+    }
+
+    // random reads on a newly opened file walk the cluster chain from start
+    printf("random read(cold): %d us/read\r\n", (int)__fs_bench_random(file, buff, block_size, count));
+    printf("random read(warm): %d us/read\r\n", (int)__fs_bench_random(file, buff, block_size, count));
+
+    offset = 0;
+    start = vsf_systimer_get_us();
+    while ((rsize = __fs_bench_read(file, offset, block_size, buff)) > 0) {
+        offset += rsize;
+    }
+    elapse = vsf_systimer_get_us() - start;
+    printf("sequential read: %llu bytes in %llu ms, %llu KB/s\r\n",
+        (unsigned long long)offset, (unsigned long long)(elapse / 1000),
+        (unsigned long long)(elapse ? (offset * 1000000 / 1024 / elapse) : 0));
+
+close_file:
+    vk_file_close(file);
+    free(buff);
+    return 0;
+}
+
+/*============================ write bench ===================================*/
+
+#define __FS_WRITE_BENCH_MAX_WRITER     8
+
+typedef struct __fs_write_bench_writer_t {
+    vk_file_t *dir;
+    uint8_t *buff;
+    uint32_t block_num;
+    uint32_t block_size;
+    uint8_t idx;
+    char name[16];
+    int result;
+} __fs_write_bench_writer_t;
+
+static int32_t __fs_bench_write(vk_file_t *file, uint64_t offset, uint32_t size, uint8_t *buff)
+{
+    vk_file_write(file, offset, size, buff);
+    return (int32_t)vsf_eda_get_return_value();
+}
+
+// block n of writer idx is filled with (n + idx), so blocks shared by files will be detected
+static void * __fs_write_bench_thread(void *param)
+{
+    __fs_write_bench_writer_t *writer = param;
+    vk_file_t *file;
+
+    writer->result = -1;
+    vk_file_open(writer->dir, writer->name, 0, &file);
+    if (NULL == file) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < writer->block_num; i++) {
+        memset(writer->buff, (uint8_t)(i + writer->idx), writer->block_size);
+        if (__fs_bench_write(file, (uint64_t)i * writer->block_size, writer->block_size, writer->buff)
+                != (int32_t)writer->block_size) {
+            goto close_file;
+        }
+    }
+    writer->result = 0;
+close_file:
+    vk_file_close(file);
+    return NULL;
+}
+
+static bool __fs_write_bench_verify(__fs_write_bench_writer_t *writer)
+{
+    vk_file_t *file;
+    bool result = false;
+
+    vk_file_open(writer->dir, writer->name, 0, &file);
+    if (NULL == file) {
+        return false;
+    }
+    if (file->size != (uint64_t)writer->block_num * writer->block_size) {
+        goto close_file;
+    }
+    for (uint32_t i = 0; i < writer->block_num; i++) {
+        if (__fs_bench_read(file, (uint64_t)i * writer->block_size, writer->block_size, writer->buff)
+                != (int32_t)writer->block_size) {
+            goto close_file;
+        }
+        for (uint32_t j = 0; j < writer->block_size; j++) {
+            if (writer->buff[j] != (uint8_t)(i + writer->idx)) {
+                goto close_file;
+            }
+        }
+    }
+    result = true;
+close_file:
+    vk_file_close(file);
+    return result;
+}
+
+// writers write their own files in dir concurrently, files are verified and removed after written
+int fs_write_bench_main(int argc, char *argv[])
+{
+    __fs_write_bench_writer_t *writers;
+    pthread_t threads[__FS_WRITE_BENCH_MAX_WRITER];
+    uint32_t size = 4 * 1024 * 1024, block_size = 64 * 1024, writer_num = 1;
+    uint64_t total, elapse;
+    vk_file_t *dir;
+    int result = -1;
+
+    if ((argc < 2) || (argc > 5)) {
+        printf("format: %s dir [size_per_writer] [block_size] [writer_num]\r\n", argv[0]);
+        return -1;
+    }
+    if (argc >= 3) {
+        size = strtoul(argv[2], NULL, 0);
+    }
+    if (argc >= 4) {
+        block_size = strtoul(argv[3], NULL, 0);
+    }
+    if (argc >= 5) {
+        writer_num = strtoul(argv[4], NULL, 0);
+    }
+    if (    !block_size || (size < block_size)
+        ||  !writer_num || (writer_num > __FS_WRITE_BENCH_MAX_WRITER)) {
+        printf("invalid parameter\r\n");
+        return -1;
+    }
+
+    vk_file_open(NULL, argv[1], 0, &dir);
+    if (NULL == dir) {
+        printf("fail to open %s\r\n", argv[1]);
+        return -1;
+    }
+    writers = calloc(writer_num, sizeof(*writers));
+    if (NULL == writers) {
+        printf("not enough resources\r\n");
+        goto close_dir;
+    }
+    for (uint32_t i = 0; i < writer_num; i++) {
+        writers[i].dir = dir;
+        writers[i].block_num = size / block_size;
+        writers[i].block_size = block_size;
+        writers[i].idx = (uint8_t)i;
+        snprintf(writers[i].name, sizeof(writers[i].name), "wbench%d.bin", (int)i);
+        writers[i].buff = malloc(block_size);
+        if (NULL == writers[i].buff) {
+            printf("not enough resources\r\n");
+            goto free_writers;
+        }
+        // files are created before writers start, so that only writes run concurrently
+        vk_file_create(dir, writers[i].name, VSF_FILE_ATTR_READ | VSF_FILE_ATTR_WRITE, 0);
+    }
+
+    elapse = vsf_systimer_get_us();
+    for (uint32_t i = 0; i < writer_num; i++) {
+        pthread_create(&threads[i], NULL, __fs_write_bench_thread, &writers[i]);
+    }
+    for (uint32_t i = 0; i < writer_num; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    elapse = vsf_systimer_get_us() - elapse;
+    total = (uint64_t)writer_num * writers[0].block_num * block_size;
+    printf("sequential write: %d writers, %llu bytes in %llu ms, %llu KB/s\r\n", (int)writer_num,
+        (unsigned long long)total, (unsigned long long)(elapse / 1000),
+        (unsigned long long)(elapse ? (total * 1000000 / 1024 / elapse) : 0));
+
+    result = 0;
+    for (uint32_t i = 0; i < writer_num; i++) {
+        if (writers[i].result < 0) {
+            printf("fail to write %s\r\n", writers[i].name);
+            result = -1;
+        } else if (!__fs_write_bench_verify(&writers[i])) {
+            printf("fail to verify %s\r\n", writers[i].name);
+            result = -1;
+        }
+        vk_file_unlink(dir, writers[i].name);
+    }
+
+free_writers:
+    for (uint32_t i = 0; i < writer_num; i++) {
+        if (writers[i].buff != NULL) {
+            free(writers[i].buff);
+        }
+    }
+    free(writers);
+close_dir:
+    vk_file_close(dir);
+    return result;
+}
+
+/*============================ dentry cache bench ============================*/
+
+#define __FS_DCACHE_BENCH_DIR_NUM       100
+#define __FS_DCACHE_BENCH_FILE_NUM      100
+#define __FS_DCACHE_BENCH_HOT_NUM       16
+
+// open and close path, return true if path exists
+static bool __fs_dcache_bench_open(const char *path)
+{
+    vk_file_t *file;
+    vk_file_open(NULL, path, 0, &file);
+    if (file != NULL) {
+        vk_file_close(file);
+        return true;
+    }
+    return false;
+}
+
+static uint32_t __fs_dcache_bench_elapse(uint64_t start, uint32_t count)
+{
+    return (uint32_t)((vsf_systimer_get_us() - start) * 1000 / count);
+}
+
+int fs_dcache_bench_main(int argc, char *argv[])
+{
+    // names are held by vfs until unlinked
+    char **names = calloc(__FS_DCACHE_BENCH_DIR_NUM * (__FS_DCACHE_BENCH_FILE_NUM + 1), sizeof(char *));
+    char **dir_names = &names[__FS_DCACHE_BENCH_DIR_NUM * __FS_DCACHE_BENCH_FILE_NUM];
+    vk_file_t *root = NULL, *dir;
+    uint32_t count, missed = 0;
+    uint64_t start;
+    char path[64];
+    int result = -1;
+
+    if (NULL == names) {
+        printf("not enough resources\r\n");
+        return -1;
+    }
+
+    vk_file_create(NULL, "dcache_bench", VSF_FILE_ATTR_DIRECTORY, 0);
+    vk_file_open(NULL, "/dcache_bench", 0, &root);
+    if (NULL == root) {
+        printf("fail to create /dcache_bench\r\n");
+        goto free_names;
+    }
+    for (int i = 0; i < __FS_DCACHE_BENCH_DIR_NUM; i++) {
+        dir_names[i] = malloc(8);
+        if (NULL == dir_names[i]) {
+            goto cleanup;
+        }
+        snprintf(dir_names[i], 8, "d%02d", i);
+        vk_file_create(root, dir_names[i], VSF_FILE_ATTR_DIRECTORY, 0);
+        vk_file_open(root, dir_names[i], 0, &dir);
+        if (NULL == dir) {
+            goto cleanup;
+        }
+        for (int j = 0; j < __FS_DCACHE_BENCH_FILE_NUM; j++) {
+            char **name = &names[i * __FS_DCACHE_BENCH_FILE_NUM + j];
+            *name = malloc(8);
+            if (NULL == *name) {
+                vk_file_close(dir);
+                goto cleanup;
+            }
+            snprintf(*name, 8, "f%02d", j);
+            vk_file_create(dir, *name, VSF_FILE_ATTR_READ | VSF_FILE_ATTR_WRITE, 0);
+        }
+        vk_file_close(dir);
+    }
+
+    count = __FS_DCACHE_BENCH_DIR_NUM * __FS_DCACHE_BENCH_FILE_NUM;
+    start = vsf_systimer_get_us();
+    for (int i = 0; i < __FS_DCACHE_BENCH_DIR_NUM; i++) {
+        for (int j = 0; j < __FS_DCACHE_BENCH_FILE_NUM; j++) {
+            snprintf(path, sizeof(path), "/dcache_bench/d%02d/f%02d", i, j);
+            if (!__fs_dcache_bench_open(path)) {
+                missed++;
+            }
+        }
+    }
+    printf("open all %d files: %d ns/open\r\n", (int)count, (int)__fs_dcache_bench_elapse(start, count));
+
+    // small working set, should be served from dentry cache
+    start = vsf_systimer_get_us();
+    for (uint32_t n = 0; n < count; n++) {
+        snprintf(path, sizeof(path), "/dcache_bench/d%02d/f%02d", (int)(n % __FS_DCACHE_BENCH_HOT_NUM),
+                    (int)((n / __FS_DCACHE_BENCH_HOT_NUM) % __FS_DCACHE_BENCH_HOT_NUM));
+        if (!__fs_dcache_bench_open(path)) {
+            missed++;
+        }
+    }
+    printf("open hot set: %d ns/open\r\n", (int)__fs_dcache_bench_elapse(start, count));
+
+    start = vsf_systimer_get_us();
+    for (uint32_t n = 0; n < count; n++) {
+        snprintf(path, sizeof(path), "/dcache_bench/d%02d/none%02d", (int)(n % __FS_DCACHE_BENCH_HOT_NUM),
+                    (int)((n / __FS_DCACHE_BENCH_HOT_NUM) % __FS_DCACHE_BENCH_HOT_NUM));
+        if (__fs_dcache_bench_open(path)) {
+            missed++;
+        }
+    }
+    printf("negative lookup: %d ns/open\r\n", (int)__fs_dcache_bench_elapse(start, count));
+    if (missed > 0) {
+        printf("%d unexpected lookup results\r\n", (int)missed);
+    } else {
+        result = 0;
+    }
+
+cleanup:
+    if (root != NULL) {
+        for (int i = 0; i < __FS_DCACHE_BENCH_DIR_NUM; i++) {
+            if (NULL == dir_names[i]) {
+                break;
+            }
+            vk_file_open(root, dir_names[i], 0, &dir);
+            if (dir != NULL) {
+                for (int j = 0; j < __FS_DCACHE_BENCH_FILE_NUM; j++) {
+                    char *name = names[i * __FS_DCACHE_BENCH_FILE_NUM + j];
+                    if (name != NULL) {
+                        vk_file_unlink(dir, name);
+                    }
+                }
+                vk_file_close(dir);
+            }
+            vk_file_unlink(root, dir_names[i]);
+        }
+        vk_file_close(root);
+        vk_file_unlink(NULL, "dcache_bench");
+    }
+free_names:
+    for (int i = 0; i < __FS_DCACHE_BENCH_DIR_NUM * (__FS_DCACHE_BENCH_FILE_NUM + 1); i++) {
+        if (names[i] != NULL) {
+            free(names[i]);
+        }
+    }
+    free(names);
+    return result;
+}
+
+/*============================ aio mal bench =================================*/
+
+#if VSF_USE_MAL == ENABLED && VSF_MAL_USE_AIO_MAL == ENABLED
+typedef struct __aio_mal_bench_worker_t {
+    vsf_eda_t eda;
+    vk_mal_t *mal;
+    vsf_sem_t *done;
+    uint8_t *buff;
+    uint32_t block_size;
+    uint32_t remain;
+    uint32_t seed;
+    uint32_t failed;
+} __aio_mal_bench_worker_t;
+
+// each worker keeps one read in flight, so workers number is the queue depth
+static void __aio_mal_bench_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
+{
+    __aio_mal_bench_worker_t *worker = container_of(eda, __aio_mal_bench_worker_t, eda);
+    uint64_t block_num = worker->mal->size / worker->block_size;
+
+    switch (evt) {
+    case VSF_EVT_RETURN:
+        if ((int32_t)vsf_eda_get_return_value() != (int32_t)worker->block_size) {
+            worker->failed++;
+        }
+        // fall through
+    case VSF_EVT_INIT:
+        if (!worker->remain) {
+            vsf_eda_sem_post(worker->done);
+            vsf_eda_fini(eda);
+            break;
+        }
+        worker->remain--;
+        worker->seed = worker->seed * 1103515245 + 12345;
+        vk_mal_read(worker->mal, (worker->seed % block_num) * worker->block_size,
+                    worker->block_size, worker->buff);
+        break;
+    }
+}
+
+int aio_mal_bench_main(int argc, char *argv[])
+{
+    __aio_mal_bench_worker_t *workers;
+    vk_aio_mal_t *mal;
+    vsf_sem_t done;
+    uint32_t queue_depth = 16, count = 10000, block_size = 4096, failed = 0;
+    uint64_t elapse;
+    int result = -1;
+
+    if ((argc < 2) || (argc > 5)) {
+        printf("format: %s image [queue_depth] [count] [block_size]\r\n", argv[0]);
+        return -1;
+    }
+    if (argc >= 3) {
+        queue_depth = strtoul(argv[2], NULL, 0);
+    }
+    if (argc >= 4) {
+        count = strtoul(argv[3], NULL, 0);
+    }
+    if (argc >= 5) {
+        block_size = strtoul(argv[4], NULL, 0);
+    }
+    if (!queue_depth || !count || !block_size || (block_size % 512)) {
+        printf("invalid parameter\r\n");
+        return -1;
+    }
+
+    mal = calloc(1, sizeof(*mal));
+    workers = calloc(queue_depth, sizeof(*workers));
+    if ((NULL == mal) || (NULL == workers)) {
+        printf("not enough resources\r\n");
+        goto free_all;
+    }
+    mal->drv = &vk_aio_mal_drv;
+    mal->path = argv[1];
+    mal->block_size = block_size;
+    mal->is_direct = true;
+    mal->read_only = true;
+    vk_mal_init(&mal->use_as__vk_mal_t);
+    if (vsf_eda_get_return_value() != VSF_ERR_NONE) {
+        printf("fail to open %s\r\n", argv[1]);
+        goto free_all;
+    }
+    printf("%s: %llu bytes, %s, %s\r\n", argv[1], (unsigned long long)mal->size,
+        vk_aio_mal_is_uring(mal) ? "io_uring" : "thread pool",
+        mal->is_direct ? "direct" : "cached");
+
+    vsf_eda_sem_init(&done, 0);
+    for (uint32_t i = 0; i < queue_depth; i++) {
+        workers[i].buff = memalign(VSF_AIO_MAL_CFG_DIRECT_ALIGN, block_size);
+        if (NULL == workers[i].buff) {
+            printf("not enough resources\r\n");
+            goto fini_mal;
+        }
+        workers[i].mal = &mal->use_as__vk_mal_t;
+        workers[i].done = &done;
+        workers[i].block_size = block_size;
+        workers[i].remain = count / queue_depth + (i < (count % queue_depth) ? 1 : 0);
+        workers[i].seed = i;
+    }
+
+    elapse = vsf_systimer_get_us();
+    for (uint32_t i = 0; i < queue_depth; i++) {
+        vsf_eda_cfg_t cfg = {
+            .fn.evthandler  = __aio_mal_bench_evthandler,
+            .priority       = vsf_prio_0,
+        };
+        vsf_eda_start(&workers[i].eda, &cfg);
+    }
+    for (uint32_t i = 0; i < queue_depth; i++) {
+        vsf_thread_sem_pend(&done, -1);
+    }
+    elapse = vsf_systimer_get_us() - elapse;
+    for (uint32_t i = 0; i < queue_depth; i++) {
+        failed += workers[i].failed;
+    }
+
+    printf("queue depth %d: %d reads of %d bytes in %llu ms, %llu IOPS\r\n",
+        (int)queue_depth, (int)count, (int)block_size, (unsigned long long)(elapse / 1000),
+        (unsigned long long)(elapse ? ((uint64_t)count * 1000000 / elapse) : 0));
+    if (failed > 0) {
+        printf("%d reads failed\r\n", (int)failed);
+    } else {
+        result = 0;
+    }
+
+fini_mal:
+    vk_mal_fini(&mal->use_as__vk_mal_t);
+free_all:
+    if (workers != NULL) {
+        for (uint32_t i = 0; i < queue_depth; i++) {
+            if (workers[i].buff != NULL) {
+                free(workers[i].buff);
+            }
+        }
+        free(workers);
+    }
+    if (mal != NULL) {
+        free(mal);
+    }
+    return result;
+}
+#endif
+
+/*============================ fakefat32 bench ===============================*/
+
+#if VSF_USE_MAL == ENABLED && VSF_MAL_USE_FAKEFAT32_MAL == ENABLED
+#define __FAKEFAT32_BENCH_DIR_NUM       32
+#define __FAKEFAT32_BENCH_FILE_NUM      256
+// 8192 files of 120K in a 1G volume
+#define __FAKEFAT32_BENCH_FILE_SIZE     (120 * 1024)
+#define __FAKEFAT32_BENCH_VOLUME_SIZE   (1024 * 1024 * 1024)
+
+int fakefat32_bench_main(int argc, char *argv[])
+{
+    vk_fakefat32_mal_t *mal;
+    vk_fakefat32_file_t *dirs, *files;
+    char *names;
+    uint8_t *file_buff, *buff;
+    uint32_t block_size = 64 * 1024;
+    uint64_t addr, start, elapse;
+    int result = -1;
+
+    if (argc > 2) {
+        printf("format: %s [block_size]\r\n", argv[0]);
+        return -1;
+    }
+    if (argc >= 2) {
+        block_size = strtoul(argv[1], NULL, 0);
+    }
+    if (!block_size || (block_size % 512)) {
+        printf("invalid block_size\r\n");
+        return -1;
+    }
+
+    mal = calloc(1, sizeof(*mal));
+    dirs = calloc(__FAKEFAT32_BENCH_DIR_NUM, sizeof(*dirs));
+    files = calloc(__FAKEFAT32_BENCH_DIR_NUM * (__FAKEFAT32_BENCH_FILE_NUM + 2), sizeof(*files));
+    names = malloc((__FAKEFAT32_BENCH_DIR_NUM * (__FAKEFAT32_BENCH_FILE_NUM + 1)) * 16);
+    file_buff = malloc(__FAKEFAT32_BENCH_FILE_SIZE);
+    buff = malloc(block_size);
+    if (    (NULL == mal) || (NULL == dirs) || (NULL == files) || (NULL == names)
+        ||  (NULL == file_buff) || (NULL == buff)) {
+        printf("not enough resources\r\n");
+        goto free_all;
+    }
+
+    // all files share the same content
+    for (uint32_t i = 0; i < __FAKEFAT32_BENCH_FILE_SIZE; i++) {
+        file_buff[i] = (uint8_t)i;
+    }
+    for (uint32_t i = 0; i < __FAKEFAT32_BENCH_DIR_NUM; i++) {
+        vk_fakefat32_file_t *child = &files[i * (__FAKEFAT32_BENCH_FILE_NUM + 2)];
+        char *name = &names[i * (__FAKEFAT32_BENCH_FILE_NUM + 1) * 16];
+
+        snprintf(name, 16, "dir%02d", (int)i);
+        dirs[i].name = name;
+        dirs[i].attr = VSF_FILE_ATTR_DIRECTORY | VSF_FILE_ATTR_READ;
+        dirs[i].d.child = (vk_memfs_file_t *)child;
+        dirs[i].d.child_num = __FAKEFAT32_BENCH_FILE_NUM + 2;
+
+        child[0].name = ".";
+        child[0].attr = VSF_FILE_ATTR_DIRECTORY | VSF_FILE_ATTR_READ;
+        child[1].name = "..";
+        child[1].attr = VSF_FILE_ATTR_DIRECTORY | VSF_FILE_ATTR_READ;
+        for (uint32_t j = 0; j < __FAKEFAT32_BENCH_FILE_NUM; j++) {
+            name += 16;
+            snprintf(name, 16, "file%03d.bin", (int)j);
+            child[2 + j].name = name;
+            child[2 + j].size = __FAKEFAT32_BENCH_FILE_SIZE;
+            child[2 + j].attr = VSF_FILE_ATTR_READ;
+            child[2 + j].f.buff = file_buff;
+        }
+    }
+
+    mal->drv = &vk_fakefat32_mal_drv;
+    mal->sector_size = 512;
+    mal->sector_number = __FAKEFAT32_BENCH_VOLUME_SIZE / 512;
+    mal->sectors_per_cluster = 8;
+    mal->volume_id = 0x12345678;
+    mal->disk_id = 0x9ABCEF01;
+    mal->root.name = "ROOT";
+    mal->root.d.child = (vk_memfs_file_t *)dirs;
+    mal->root.d.child_num = __FAKEFAT32_BENCH_DIR_NUM;
+
+    start = vsf_systimer_get_us();
+    vk_mal_init(&mal->use_as__vk_mal_t);
+    if (vsf_eda_get_return_value() != VSF_ERR_NONE) {
+        printf("fail to initialize fakefat32\r\n");
+        goto free_all;
+    }
+    printf("init: %llu us\r\n", (unsigned long long)(vsf_systimer_get_us() - start));
+
+    start = vsf_systimer_get_us();
+    for (addr = 0; addr < __FAKEFAT32_BENCH_VOLUME_SIZE; addr += block_size) {
+        vk_mal_read(&mal->use_as__vk_mal_t, addr, block_size, buff);
+        if ((int32_t)vsf_eda_get_return_value() != (int32_t)block_size) {
+            printf("fail to read at %llu\r\n", (unsigned long long)addr);
+            goto fini_mal;
+        }
+    }
+    elapse = vsf_systimer_get_us() - start;
+    printf("sequential read: %llu bytes in %llu ms, %llu KB/s\r\n",
+        (unsigned long long)addr, (unsigned long long)(elapse / 1000),
+        (unsigned long long)(elapse ? (addr * 1000000 / 1024 / elapse) : 0));
+    result = 0;
+
+fini_mal:
+    vk_mal_fini(&mal->use_as__vk_mal_t);
+free_all:
+    if (buff != NULL) {
+        free(buff);
+    }
+    if (file_buff != NULL) {
+        free(file_buff);
+    }
+    if (names != NULL) {
+        free(names);
+    }
+    if (files != NULL) {
+        free(files);
+    }
+    if (dirs != NULL) {
+        free(dirs);
+    }
+    if (mal != NULL) {
+        free(mal);
+    }
+    return result;
+}
+#endif
+#endif
@@ -79,6 +79,9 @@ extern int awtk_main(int argc, char *argv[]);
 
 #if APP_USE_USBH_DEMO == ENABLED
 extern int usbh_main(int argc, char *argv[]);
+#   if APP_USE_USBH_BENCH_DEMO == ENABLED
+extern int usbh_bench_main(int argc, char *argv[]);
+#   endif
 #endif
 
 #if APP_USE_VSFIP_DEMO == ENABLED && VSF_USE_VSFIP == ENABLED
@@ -126,6 +129,9 @@ extern int usbd_uac_main(int argc, char *argv[]);
 #   endif
 #   if APP_USE_USBD_MSC_DEMO == ENABLED
 extern int usbd_msc_main(int argc, char *argv[]);
+#       if APP_USE_USBD_USBIP_BENCH_DEMO == ENABLED && VSF_USBD_USE_DCD_USBIP == ENABLED
+extern int usbip_bench_main(int argc, char *argv[]);
+#       endif
 #   endif
 #   if APP_USE_USBD_USER_DEMO == ENABLED
 extern int usbd_user_main(int argc, char *argv[]);
@@ -134,6 +140,38 @@ extern int usbd_user_main(int argc, char *argv[]);
 
 #if APP_USE_LINUX_MOUNT_FILE_DEMO == ENABLED
 extern int mount_file_main(int argc, char *argv[]);
+#   if VSF_MAL_USE_MMAP_MAL == ENABLED
+extern int mount_image_main(int argc, char *argv[]);
+#   endif
+#endif
+
+#if APP_USE_LINUX_FS_BENCH_DEMO == ENABLED
+extern int fs_bench_main(int argc, char *argv[]);
+extern int fs_write_bench_main(int argc, char *argv[]);
+extern int fs_dcache_bench_main(int argc, char *argv[]);
+#   if VSF_USE_MAL == ENABLED && VSF_MAL_USE_AIO_MAL == ENABLED
+extern int aio_mal_bench_main(int argc, char *argv[]);
+#   endif
+#   if VSF_USE_MAL == ENABLED && VSF_MAL_USE_FAKEFAT32_MAL == ENABLED
+extern int fakefat32_bench_main(int argc, char *argv[]);
+#   endif
+#endif
+
+#if APP_USE_LINUX_FATFS_TEST_DEMO == ENABLED && VSF_FS_USE_FATFS == ENABLED && VSF_MAL_USE_MMAP_MAL == ENABLED
+extern int fatfs_test_main(int argc, char *argv[]);
+#endif
+
+#if APP_USE_LINUX_CHECKSUM_BENCH_DEMO == ENABLED && VSF_USE_TCPIP == ENABLED
+extern int checksum_bench_main(int argc, char *argv[]);
+#endif
+
+#if APP_USE_LINUX_FD_BENCH_DEMO == ENABLED
+extern int epoll_bench_main(int argc, char *argv[]);
+extern int fd_bench_main(int argc, char *argv[]);
+#endif
+
+#if APP_USE_LINUX_NETDRV_BENCH_DEMO == ENABLED && VSF_USE_TCPIP == ENABLED && VSF_NETDRV_USE_LINUX == ENABLED
+extern int netdrv_bench_main(int argc, char *argv[]);
 #endif
 
 #if APP_USE_LINUX_DEMO == ENABLED && APP_USE_VSFVM_DEMO == ENABLED
@@ -158,6 +196,15 @@ extern void freetype_demo_init(void);
 
 #if APP_USE_KERNEL_TEST == ENABLED
 extern int kernel_sem_test_main(int argc, char *argv[]);
+extern int kernel_evtq_test_main(int argc, char *argv[]);
+extern int kernel_timq_test_main(int argc, char *argv[]);
+extern int kernel_heap_test_main(int argc, char *argv[]);
+extern int kernel_pool_test_main(int argc, char *argv[]);
+extern int kernel_frame_test_main(int argc, char *argv[]);
+#endif
+
+#if APP_USE_SCSI_TEST == ENABLED && VSF_USE_SCSI == ENABLED
+extern int scsi_test_main(int argc, char *argv[]);
 #endif
 
 #if APP_USE_JSON_DEMO == ENABLED
@@ -254,6 +301,9 @@ int vsf_linux_create_fhs(void)
     busybox_bind("/sbin/lsusb", lsusb_main);
     vsf_linux_libusb_startup();
 #endif
+#if APP_USE_USBH_DEMO == ENABLED && APP_USE_USBH_BENCH_DEMO == ENABLED
+    busybox_bind("/sbin/usbh_bench", usbh_bench_main);
+#endif
 
 #if APP_USE_NNOM_DEMO == ENABLED
     busybox_bind("/sbin/nnom", nnom_main);
@@ -297,6 +347,9 @@ int vsf_linux_create_fhs(void)
 #   endif
 #   if APP_USE_USBD_MSC_DEMO == ENABLED
     busybox_bind("/sbin/usbd_msc", usbd_msc_main);
+#       if APP_USE_USBD_USBIP_BENCH_DEMO == ENABLED && VSF_USBD_USE_DCD_USBIP == ENABLED
+    busybox_bind("/sbin/usbip_bench", usbip_bench_main);
+#       endif
 #   endif
 #   if APP_USE_USBD_USER_DEMO == ENABLED
     busybox_bind("/sbin/usbd_user", usbd_user_main);
@@ -304,6 +357,33 @@ int vsf_linux_create_fhs(void)
 #endif
 #if APP_USE_LINUX_MOUNT_FILE_DEMO == ENABLED
     busybox_bind("/sbin/mount_file", mount_file_main);
+#   if VSF_MAL_USE_MMAP_MAL == ENABLED
+    busybox_bind("/sbin/mount_image", mount_image_main);
+#   endif
+#endif
+#if APP_USE_LINUX_FS_BENCH_DEMO == ENABLED
+    busybox_bind("/sbin/fs_bench", fs_bench_main);
+    busybox_bind("/sbin/fs_write_bench", fs_write_bench_main);
+    busybox_bind("/sbin/fs_dcache_bench", fs_dcache_bench_main);
+#   if VSF_USE_MAL == ENABLED && VSF_MAL_USE_AIO_MAL == ENABLED
+    busybox_bind("/sbin/aio_mal_bench", aio_mal_bench_main);
+#   endif
+#   if VSF_USE_MAL == ENABLED && VSF_MAL_USE_FAKEFAT32_MAL == ENABLED
+    busybox_bind("/sbin/fakefat32_bench", fakefat32_bench_main);
+#   endif
+#endif
+#if APP_USE_LINUX_FATFS_TEST_DEMO == ENABLED && VSF_FS_USE_FATFS == ENABLED && VSF_MAL_USE_MMAP_MAL == ENABLED
+    busybox_bind("/sbin/fatfs_test", fatfs_test_main);
+#endif
+#if APP_USE_LINUX_CHECKSUM_BENCH_DEMO == ENABLED && VSF_USE_TCPIP == ENABLED
+    busybox_bind("/sbin/checksum_bench", checksum_bench_main);
+#endif
+#if APP_USE_LINUX_FD_BENCH_DEMO == ENABLED
+    busybox_bind("/sbin/epoll_bench", epoll_bench_main);
+    busybox_bind("/sbin/fd_bench", fd_bench_main);
+#endif
+#if APP_USE_LINUX_NETDRV_BENCH_DEMO == ENABLED && VSF_USE_TCPIP == ENABLED && VSF_NETDRV_USE_LINUX == ENABLED
+    busybox_bind("/sbin/netdrv_bench", netdrv_bench_main);
 #endif
 #if APP_USE_CPP_DEMO == ENABLED
     busybox_bind("/sbin/cpp_test", cpp_main);
@@ -323,6 +403,14 @@ int vsf_linux_create_fhs(void)
 #endif
 #if APP_USE_KERNEL_TEST == ENABLED
     busybox_bind("/sbin/sem_test", kernel_sem_test_main);
+    busybox_bind("/sbin/evtq_test", kernel_evtq_test_main);
+    busybox_bind("/sbin/timq_test", kernel_timq_test_main);
+    busybox_bind("/sbin/heap_test", kernel_heap_test_main);
+    busybox_bind("/sbin/pool_test", kernel_pool_test_main);
+    busybox_bind("/sbin/frame_test", kernel_frame_test_main);
+#endif
+#if APP_USE_SCSI_TEST == ENABLED && VSF_USE_SCSI == ENABLED
+    busybox_bind("/sbin/scsi_test", scsi_test_main);
 #endif
 #if APP_USE_JSON_DEMO == ENABLED
     busybox_bind("/sbin/json", json_main);
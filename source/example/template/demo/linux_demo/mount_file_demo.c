@@ -1,5 +1,6 @@
 #include <unistd.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #if VSF_USE_LINUX == ENABLED && APP_USE_LINUX_MOUNT_FILE_DEMO == ENABLED
 
@@ -63,4 +64,69 @@ cleanup:
     }
     return result;
 }
+
+#if VSF_MAL_USE_MMAP_MAL == ENABLED
+// mount image file on host, which is mapped into memory by mmap_mal
+int mount_image_main(int argc, char *argv[])
+{
+    vk_mmap_mal_t *mmap_mal;
+    vk_malfs_mounter_t mounter = { 0 };
+    int result = 0;
+
+    if ((argc < 3) || (argc > 4)) {
+        printf("format: %s host_image target_dir [window_size]\r\n", argv[0]);
+        return -1;
+    }
+
+    mmap_mal = calloc(1, sizeof(*mmap_mal));
+    if (NULL == mmap_mal) {
+        printf("not enough resources\r\n");
+        return -1;
+    }
+
+    vk_file_open(NULL, argv[2], 0, &mounter.dir);
+    if (NULL == mounter.dir) {
+        printf("fail to open target_dir %s\r\n", argv[2]);
+        result = -1;
+        goto cleanup;
+    }
+    if (!(mounter.dir->attr & VSF_FILE_ATTR_DIRECTORY)) {
+        printf("target_dir %s is not a directory\r\n", argv[2]);
+        result = -1;
+        goto cleanup;
+    }
+
+    // path is used by mmap_mal only in initialization
+    mmap_mal->path = argv[1];
+    mmap_mal->drv = &vk_mmap_mal_drv;
+    mmap_mal->block_size = 512;
+    if (argc >= 4) {
+        mmap_mal->window_size = strtoul(argv[3], NULL, 0);
+    }
+    vk_mal_init(&mmap_mal->use_as__vk_mal_t);
+    if ((vsf_err_t)vsf_eda_get_return_value() != VSF_ERR_NONE) {
+        printf("fail to open host_image %s\r\n", argv[1]);
+        result = -1;
+        goto cleanup;
+    }
+
+    mounter.mal = &mmap_mal->use_as__vk_mal_t;
+    vk_malfs_mount_mbr(&mounter);
+    if (mounter.err != VSF_ERR_NONE) {
+        printf("fail to mount host_image %s\r\n", argv[1]);
+        vk_mal_fini(&mmap_mal->use_as__vk_mal_t);
+        result = -1;
+        goto cleanup;
+    }
+
+cleanup:
+    if (result < 0) {
+        free(mmap_mal);
+    }
+    if (mounter.dir != NULL) {
+        vk_file_close(mounter.dir);
+    }
+    return result;
+}
+#endif
 #endif
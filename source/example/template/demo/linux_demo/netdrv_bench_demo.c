@@ -0,0 +1,239 @@
+#define __VSF_NETDRV_CLASS_INHERIT_NETIF__
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if     VSF_USE_LINUX == ENABLED && VSF_USE_TCPIP == ENABLED && VSF_NETDRV_USE_LINUX == ENABLED\
+    &&  APP_USE_LINUX_NETDRV_BENCH_DEMO == ENABLED
+
+// frame: ethernet header, 4-byte sequence number and padding
+#define __NETDRV_BENCH_MIN_FRAME_SIZE       60
+#define __NETDRV_BENCH_MAX_FRAME_SIZE       (1500 + TCPIP_ETH_HEADSIZE)
+// local experimental ethertype
+#define __NETDRV_BENCH_ETHTYPE              0x88B5
+// receiver is regarded as stalled if no frame arrives in this period
+#define __NETDRV_BENCH_STALL_MS             1000
+
+typedef struct __netdrv_bench_buf_t {
+    uint32_t size;
+    uint8_t buffer[VSF_NETDRV_LINUX_FRAME_SIZE];
+} __netdrv_bench_buf_t;
+
+typedef struct __netdrv_bench_t {
+    // netdrv[0] sends to netdrv[1] over the socketpair
+    vk_netdrv_linux_t netdrv[2];
+    bool is_running;
+
+    // frames are copied to tx ring in vk_netdrv_output, so one tx buffer is enough
+    __netdrv_bench_buf_t tx_buf;
+    // frames are consumed in on_inputted, so one rx buffer is enough
+    __netdrv_bench_buf_t rx_buf;
+
+    // updated in irq_thread of netdrv[1]
+    volatile uint32_t rx_num;
+    uint32_t rx_seq;
+    uint32_t rx_disorder;
+    uint64_t rx_end_us;
+} __netdrv_bench_t;
+
+static const uint8_t __netdrv_bench_mac[2][TCPIP_ETH_ADDRLEN] = {
+    { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 },
+    { 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 },
+};
+
+// vk_netdrv_linux_t contains tx/rx rings, too large for thread stack
+static __netdrv_bench_t __netdrv_bench;
+
+static void __netdrv_bench_on_outputted(void *netif, void *netbuf, vsf_err_t err)
+{
+}
+
+// called in irq context
+static void __netdrv_bench_on_inputted(void *netif, void *netbuf, uint_fast32_t size)
+{
+    __netdrv_bench_buf_t *buf = netbuf;
+    uint32_t seq = get_unaligned_le32(&buf->buffer[TCPIP_ETH_HEADSIZE]);
+
+    if (seq != __netdrv_bench.rx_seq) {
+        __netdrv_bench.rx_disorder++;
+    }
+    __netdrv_bench.rx_seq = seq + 1;
+    __netdrv_bench.rx_end_us = vsf_systimer_get_us();
+    __netdrv_bench.rx_num++;
+}
+
+static void * __netdrv_bench_alloc_buf(void *netif, uint_fast16_t len)
+{
+    __netdrv_bench.rx_buf.size = min(len, sizeof(__netdrv_bench.rx_buf.buffer));
+    return &__netdrv_bench.rx_buf;
+}
+
+static void __netdrv_bench_free_buf(void *netbuf)
+{
+}
+
+static void * __netdrv_bench_read_buf(void *netbuf, vsf_mem_t *mem)
+{
+    __netdrv_bench_buf_t *buf = netbuf;
+    mem->buffer = buf->buffer;
+    mem->size = buf->size;
+    return NULL;
+}
+
+static const vk_netdrv_adapter_op_t __netdrv_bench_adapter_op = {
+    .on_outputted   = __netdrv_bench_on_outputted,
+    .on_inputted    = __netdrv_bench_on_inputted,
+    .alloc_buf      = __netdrv_bench_alloc_buf,
+    .free_buf       = __netdrv_bench_free_buf,
+    .read_buf       = __netdrv_bench_read_buf,
+};
+
+static void __netdrv_bench_fini(int num)
+{
+    for (int i = 0; i < num; i++) {
+        __netdrv_bench.netdrv[i].is_connected = false;
+        vk_netdrv_fini(&__netdrv_bench.netdrv[i].use_as__vk_netdrv_t);
+    }
+    // resources are released asynchronously in irq_thread of netdrv_linux,
+    //  wait until fd is closed before netdrv can be initialized again
+    for (int i = 0; i < num; i++) {
+        while (__atomic_load_n(&__netdrv_bench.netdrv[i].fd, __ATOMIC_ACQUIRE) >= 0) {
+            usleep(1000);
+        }
+    }
+}
+
+static int __netdrv_bench_init(void)
+{
+    vk_netdrv_linux_t *linux_netdrv;
+    vk_netdrv_t *netdrv;
+    int fd[2], i;
+
+    if (vk_netdrv_linux_socketpair(fd) != VSF_ERR_NONE) {
+        printf("fail to create socketpair\r\n");
+        return -1;
+    }
+
+    for (i = 0; i < dimof(__netdrv_bench.netdrv); i++) {
+        linux_netdrv = &__netdrv_bench.netdrv[i];
+        netdrv = &linux_netdrv->use_as__vk_netdrv_t;
+
+        memset(linux_netdrv, 0, sizeof(*linux_netdrv));
+        linux_netdrv->mode = VSF_NETDRV_LINUX_MODE_SOCKETPAIR;
+        linux_netdrv->fd = fd[i];
+        netdrv->macaddr.size = TCPIP_ETH_ADDRLEN;
+        memcpy(netdrv->macaddr.addr_buf, __netdrv_bench_mac[i], TCPIP_ETH_ADDRLEN);
+        netdrv->mac_header_size = TCPIP_ETH_HEADSIZE;
+        netdrv->mtu = 1500 + TCPIP_ETH_HEADSIZE;
+        netdrv->hwtype = TCPIP_ETH_HWTYPE;
+        netdrv->adapter.netif = netdrv;
+        netdrv->adapter.op = &__netdrv_bench_adapter_op;
+        vk_netdrv_set_netlink_op(netdrv, &vk_netdrv_linux_netlink_op, NULL);
+    }
+    for (i = 0; i < dimof(__netdrv_bench.netdrv); i++) {
+        netdrv = &__netdrv_bench.netdrv[i].use_as__vk_netdrv_t;
+        if (vk_netdrv_init(netdrv) != VSF_ERR_NONE) {
+            printf("fail to initialize netdrv\r\n");
+            __netdrv_bench_fini(i);
+            return -1;
+        }
+        // not vk_netdrv_connect, which will call vsf_pnp_on_netdrv_connect,
+        //  and the netdrv will be taken by the tcpip stack of the application
+        netdrv->is_connected = true;
+    }
+    return 0;
+}
+
+static int __netdrv_bench_run(uint32_t frame_num, uint32_t frame_size)
+{
+    vk_netdrv_t *netdrv = &__netdrv_bench.netdrv[0].use_as__vk_netdrv_t;
+    __netdrv_bench_buf_t *buf = &__netdrv_bench.tx_buf;
+    uint32_t seq, rx_num, rx_last = 0, stall_ms = 0;
+    uint64_t start, elapse;
+
+    if (__netdrv_bench_init() < 0) {
+        return -1;
+    }
+    __netdrv_bench.rx_num = 0;
+    __netdrv_bench.rx_seq = 0;
+    __netdrv_bench.rx_disorder = 0;
+
+    memcpy(&buf->buffer[0], __netdrv_bench_mac[1], TCPIP_ETH_ADDRLEN);
+    memcpy(&buf->buffer[TCPIP_ETH_ADDRLEN], __netdrv_bench_mac[0], TCPIP_ETH_ADDRLEN);
+    put_unaligned_be16(__NETDRV_BENCH_ETHTYPE, &buf->buffer[2 * TCPIP_ETH_ADDRLEN]);
+    memset(&buf->buffer[TCPIP_ETH_HEADSIZE], 0x5A, frame_size - TCPIP_ETH_HEADSIZE);
+    buf->size = frame_size;
+
+    start = vsf_systimer_get_us();
+    for (seq = 0; seq < frame_num; seq++) {
+        // tx ring is full, wait for irq_thread to drain it
+        while (!vk_netdrv_can_output(netdrv)) {
+            usleep(1);
+        }
+        put_unaligned_le32(seq, &buf->buffer[TCPIP_ETH_HEADSIZE]);
+        if (vk_netdrv_output(netdrv, buf) != VSF_ERR_NONE) {
+            printf("fail to output frame %d\r\n", (int)seq);
+            break;
+        }
+    }
+
+    while ((rx_num = __netdrv_bench.rx_num) < frame_num) {
+        usleep(1000);
+        if (rx_num != rx_last) {
+            rx_last = rx_num;
+            stall_ms = 0;
+        } else if (++stall_ms >= __NETDRV_BENCH_STALL_MS) {
+            break;
+        }
+    }
+    elapse = rx_num ? __netdrv_bench.rx_end_us - start : 0;
+
+    printf("%4d bytes: %7d frames/s, %4d MB/s, lost %d, out of order %d\r\n", (int)frame_size,
+        elapse ? (int)((uint64_t)rx_num * 1000000 / elapse) : 0,
+        elapse ? (int)((uint64_t)rx_num * frame_size / elapse) : 0,
+        (int)(frame_num - rx_num), (int)__netdrv_bench.rx_disorder);
+
+    __netdrv_bench_fini(dimof(__netdrv_bench.netdrv));
+    return (rx_num == frame_num) && !__netdrv_bench.rx_disorder ? 0 : -1;
+}
+
+int netdrv_bench_main(int argc, char *argv[])
+{
+    static const uint32_t __sizes[] = { 60, 128, 512, 1024, __NETDRV_BENCH_MAX_FRAME_SIZE };
+    uint32_t frame_num = 100000, frame_size = 0;
+    int ret = 0;
+
+    if (argc > 3) {
+        printf("format: %s [frame_num] [frame_size]\r\n", argv[0]);
+        return -1;
+    }
+    if (argc >= 2) {
+        frame_num = strtoul(argv[1], NULL, 0);
+    }
+    if (argc >= 3) {
+        frame_size = strtoul(argv[2], NULL, 0);
+        if ((frame_size < __NETDRV_BENCH_MIN_FRAME_SIZE) || (frame_size > __NETDRV_BENCH_MAX_FRAME_SIZE)) {
+            printf("frame_size should be %d - %d\r\n", __NETDRV_BENCH_MIN_FRAME_SIZE, __NETDRV_BENCH_MAX_FRAME_SIZE);
+            return -1;
+        }
+    }
+    if (__netdrv_bench.is_running) {
+        printf("%s is already running\r\n", argv[0]);
+        return -1;
+    }
+    __netdrv_bench.is_running = true;
+
+    printf("netdrv_linux over socketpair, %d frames per size\r\n", (int)frame_num);
+    if (frame_size != 0) {
+        ret = __netdrv_bench_run(frame_num, frame_size);
+    } else {
+        for (int i = 0; (i < dimof(__sizes)) && !ret; i++) {
+            ret = __netdrv_bench_run(frame_num, __sizes[i]);
+        }
+    }
+
+    __netdrv_bench.is_running = false;
+    return ret;
+}
+
+#endif
@@ -139,7 +139,7 @@ static int __lwip_nslookup(int argc, char *argv[])
 int lwip_main(int argc, char *argv[])
 {
     struct dhcp *dhcp = &__usrapp_lwip.netif_dhcp;
-#if VSF_NETDRV_USE_WPCAP == ENABLED
+#if VSF_NETDRV_USE_WPCAP == ENABLED || VSF_NETDRV_USE_LINUX == ENABLED
     if (argc != 2) {
         printf("format: %s NETDRV_NAME\r\n", argv[0]);
         return -1;
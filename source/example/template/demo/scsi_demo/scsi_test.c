@@ -0,0 +1,151 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+/*============================ INCLUDES ======================================*/
+
+#include "vsf.h"
+
+#if APP_USE_SCSI_TEST == ENABLED && VSF_USE_SCSI == ENABLED
+
+/*============================ MACROS ========================================*/
+
+// pattern of bytes in the cdb not belonging to lba and transfer length
+#define __USRAPP_SCSI_TEST_FILL             0x5A
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+
+// layout of READ/WRITE cdb defined in SBC, independent of vk_scsi_get_rw_param
+typedef struct usrapp_scsi_test_layout_t {
+    uint8_t cdb_len;
+    uint8_t group_code;
+    uint8_t lba_offset;
+    uint8_t lba_size;
+    uint8_t len_offset;
+    uint8_t len_size;
+    uint64_t lba_mask;
+} usrapp_scsi_test_layout_t;
+
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ LOCAL VARIABLES ===============================*/
+
+static const usrapp_scsi_test_layout_t __usrapp_scsi_test_layouts[] = {
+    // 21-bit lba, upper 3 bits of byte 1 are reserved
+    { 6,    SCSI_GROUPCODE6,        1,  3,  4,  1,  0x1FFFFF },
+    { 10,   SCSI_GROUPCODE10_1,     2,  4,  7,  2,  0xFFFFFFFF },
+    { 12,   SCSI_GROUPCODE12,       2,  4,  6,  4,  0xFFFFFFFF },
+    { 16,   SCSI_GROUPCODE16,       2,  8,  10, 4,  0xFFFFFFFFFFFFFFFF },
+};
+
+static const uint64_t __usrapp_scsi_test_values[] = {
+    0, 1, 0x5A5A5A5A5A5A5A5A, 0x0123456789ABCDEF, 0xFEDCBA9876543210, 0xFFFFFFFFFFFFFFFF,
+};
+
+/*============================ PROTOTYPES ====================================*/
+/*============================ IMPLEMENTATION ================================*/
+
+static uint64_t __usrapp_scsi_test_get_be(const uint8_t *buf, uint_fast8_t size)
+{
+    uint64_t value = 0;
+    while (size-- > 0) {
+        value = (value << 8) | *buf++;
+    }
+    return value;
+}
+
+static bool __usrapp_scsi_test_is_field(const usrapp_scsi_test_layout_t *layout, uint_fast8_t idx)
+{
+    return  ((idx >= layout->lba_offset) && (idx < layout->lba_offset + layout->lba_size))
+        ||  ((idx >= layout->len_offset) && (idx < layout->len_offset + layout->len_size));
+}
+
+static bool __usrapp_scsi_test_rw_param(const usrapp_scsi_test_layout_t *layout,
+            scsi_cmd_code_t cmd_code, uint64_t lba, uint32_t len)
+{
+    uint8_t cbd[16];
+    uint64_t addr;
+    uint32_t size;
+
+    memset(cbd, __USRAPP_SCSI_TEST_FILL, sizeof(cbd));
+    cbd[0] = layout->group_code | cmd_code;
+    if (    !vk_scsi_set_rw_param(cbd, lba, len)
+        ||  !vk_scsi_get_rw_param(cbd, &addr, &size)
+        ||  (addr != lba) || (size != len)) {
+        return false;
+    }
+
+    // fields MUST be at the offsets defined in SBC, and other bytes untouched
+    if (    ((__usrapp_scsi_test_get_be(&cbd[layout->lba_offset], layout->lba_size) & layout->lba_mask) != lba)
+        ||  (__usrapp_scsi_test_get_be(&cbd[layout->len_offset], layout->len_size) != len)) {
+        return false;
+    }
+    for (uint_fast8_t i = 1; i < sizeof(cbd); i++) {
+        if (!__usrapp_scsi_test_is_field(layout, i) && (cbd[i] != __USRAPP_SCSI_TEST_FILL)) {
+            return false;
+        }
+    }
+    if ((6 == layout->cdb_len) && ((cbd[1] & 0xE0) != (__USRAPP_SCSI_TEST_FILL & 0xE0))) {
+        return false;
+    }
+    return true;
+}
+
+bool usrapp_scsi_test(void)
+{
+    const usrapp_scsi_test_layout_t *layout = __usrapp_scsi_test_layouts;
+    const scsi_cmd_code_t cmd_codes[] = { SCSI_CMDCODE_READ, SCSI_CMDCODE_WRITE };
+    uint8_t cbd[16] = { SCSI_CMDCODE_INQUIRY };
+    uint_fast32_t cnt = 0;
+    uint64_t addr, lba;
+    uint32_t size, len, len_mask;
+
+    for (uint_fast8_t i = 0; i < dimof(__usrapp_scsi_test_layouts); i++, layout++) {
+        len_mask = (layout->len_size >= 4) ? 0xFFFFFFFF : ((1UL << (layout->len_size * 8)) - 1);
+        for (uint_fast8_t j = 0; j < dimof(cmd_codes); j++) {
+            for (uint_fast8_t k = 0; k < dimof(__usrapp_scsi_test_values); k++) {
+                // transfer length and lba use different values
+                lba = __usrapp_scsi_test_values[k] & layout->lba_mask;
+                len = (uint32_t)__usrapp_scsi_test_values[dimof(__usrapp_scsi_test_values) - 1 - k] & len_mask;
+                if (!__usrapp_scsi_test_rw_param(layout, cmd_codes[j], lba, len)) {
+                    vsf_trace(VSF_TRACE_ERROR, "scsi_test: %d-byte %s fail, lba 0x%llx, length 0x%x\r\n",
+                        layout->cdb_len, SCSI_CMDCODE_READ == cmd_codes[j] ? "READ" : "WRITE",
+                        (unsigned long long)lba, (int)len);
+                    return false;
+                }
+                cnt++;
+            }
+        }
+    }
+
+    // non read/write commands MUST be rejected and left untouched
+    if (    vk_scsi_set_rw_param(cbd, 1, 1) || vk_scsi_get_rw_param(cbd, &addr, &size)
+        ||  (cbd[0] != SCSI_CMDCODE_INQUIRY) || cbd[1] || cbd[2] || cbd[4]) {
+        vsf_trace(VSF_TRACE_ERROR, "scsi_test: non read/write command is accepted\r\n");
+        return false;
+    }
+
+    vsf_trace(VSF_TRACE_INFO, "scsi_test: %d read/write param checks passed\r\n", (int)cnt);
+    return true;
+}
+
+#if APP_USE_LINUX_DEMO == ENABLED
+int scsi_test_main(int argc, char *argv[])
+{
+    return usrapp_scsi_test() ? 0 : -1;
+}
+#endif
+
+#endif
@@ -22,6 +22,19 @@
 #if APP_USE_SOCKET_DEMO == ENABLED && APP_USE_LINUX_DEMO == ENABLED && VSF_USE_TCPIP == ENABLED
 
 /*============================ MACROS ========================================*/
+
+#if     defined(__WIN__)
+#   define __socket_demo_socket_t       vk_socket_win_t
+#   define __socket_demo_socket_op      vk_socket_win_op
+#   define __socket_demo_socket_init    vk_socket_win_init
+#   define __socket_demo_socket_fini    vk_socket_win_fini
+#elif   defined(__LINUX__)
+#   define __socket_demo_socket_t       vk_socket_linux_t
+#   define __socket_demo_socket_op      vk_socket_linux_op
+#   define __socket_demo_socket_init    vk_socket_linux_init
+#   define __socket_demo_socket_fini    vk_socket_linux_fini
+#endif
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
 /*============================ GLOBAL VARIABLES ==============================*/
@@ -31,16 +44,16 @@
 
 int socket_main(int argc, char *argv[])
 {
-    const char *host = "www.baidu.com";
+    const char *host = argc > 1 ? argv[1] : "www.baidu.com";
 
-    vk_socket_win_t socket = {
-        .op     = &vk_socket_win_op,
+    __socket_demo_socket_t socket = {
+        .op     = &__socket_demo_socket_op,
     };
     vk_netdrv_addr_t addr;
 
-    vk_socket_win_init();
+    __socket_demo_socket_init();
 
-    vk_socket_set_default_op((vk_socket_op_t *)&vk_socket_win_op);
+    vk_socket_set_default_op((vk_socket_op_t *)&__socket_demo_socket_op);
     vk_dns_gethostbyname(host, &addr);
     printf("ip for %s is %d.%d.%d.%d\r\n", host,
                 addr.addr_buf[0], addr.addr_buf[1],
@@ -49,7 +62,7 @@ int socket_main(int argc, char *argv[])
     vk_socket_open(&socket.use_as__vk_socket_t, VSF_SOCKET_AF_INET, VSF_SOCKET_IPPROTO_TCP);
     vk_socket_close(&socket.use_as__vk_socket_t);
 
-    vk_socket_win_fini();
+    __socket_demo_socket_fini();
 
     return 0;
 }
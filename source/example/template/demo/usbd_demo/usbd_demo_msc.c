@@ -36,12 +36,21 @@
 #   define __APP_CFG_MSC_BULK_SIZE          64
 #endif
 
+// if non-zero, READ/WRITE are pipelined in this buffer instead of using stream
+#ifndef USRAPP_CFG_USBD_MSC_BUFFER_SIZE
+#   define USRAPP_CFG_USBD_MSC_BUFFER_SIZE  0
+#endif
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
 /*============================ GLOBAL VARIABLES ==============================*/
 /*============================ LOCAL VARIABLES ===============================*/
 
+#if USRAPP_CFG_USBD_MSC_BUFFER_SIZE > 0
+static uint8_t __user_usbd_msc_buffer[USRAPP_CFG_USBD_MSC_BUFFER_SIZE];
+#else
 describe_mem_stream(__user_usbd_msc_stream, 1024)
+#endif
 static const vk_virtual_scsi_param_t __usrapp_scsi_param = {
     .block_size             = USRAPP_CFG_FAKEFAT32_SECTOR_SIZE,
     .block_num              = USRAPP_CFG_FAKEFAT32_SIZE / USRAPP_CFG_FAKEFAT32_SECTOR_SIZE,
@@ -65,9 +74,15 @@ describe_usbd(__user_usbd_msc, APP_CFG_USBD_VID, APP_CFG_USBD_PID, USRAPP_CFG_US
     usbd_std_desc_table(__user_usbd_msc)
         usbd_func_str_desc_table(__user_usbd_msc, 0)
     usbd_func(__user_usbd_msc)
+#if USRAPP_CFG_USBD_MSC_BUFFER_SIZE > 0
+        mscbot_buffered_func(__user_usbd_msc, 0, 1, 1, 0,
+            &__usrapp_mal_scsi.use_as__vk_scsi_t,
+            __user_usbd_msc_buffer, sizeof(__user_usbd_msc_buffer))
+#else
         mscbot_func(__user_usbd_msc, 0, 1, 1, 0,
             &__usrapp_mal_scsi.use_as__vk_scsi_t,
             &__user_usbd_msc_stream.use_as__vsf_stream_t)
+#endif
     usbd_ifs(__user_usbd_msc)
         mscbot_ifs(__user_usbd_msc, 0)
 end_describe_usbd(__user_usbd_msc, VSF_USB_DC0)
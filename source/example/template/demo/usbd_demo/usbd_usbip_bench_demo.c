@@ -0,0 +1,458 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+/*============================ INCLUDES ======================================*/
+
+#include "vsf.h"
+
+#if     VSF_USE_USB_DEVICE == ENABLED && APP_USE_USBD_DEMO == ENABLED             \
+    &&  APP_USE_USBD_MSC_DEMO == ENABLED && APP_USE_USBD_USBIP_BENCH_DEMO == ENABLED\
+    &&  VSF_USBD_USE_DCD_USBIP == ENABLED && APP_USE_LINUX_DEMO == ENABLED      \
+    &&  VSF_USE_TCPIP == ENABLED && defined(__LINUX__)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*============================ MACROS ========================================*/
+
+// loopback usbip client for the usbip_dcd server started by usbd_msc
+#ifndef USRAPP_CFG_USBIP_BENCH_PORT
+#   define USRAPP_CFG_USBIP_BENCH_PORT          3240
+#endif
+#ifndef USRAPP_CFG_USBIP_BENCH_MAX_URB_NUM
+#   define USRAPP_CFG_USBIP_BENCH_MAX_URB_NUM   16
+#endif
+
+#define __USBIP_BENCH_VERSION                   0x0111
+#define __USBIP_BENCH_OP_REQ_DEVLIST            0x8005
+#define __USBIP_BENCH_OP_REQ_IMPORT             0x8003
+#define __USBIP_BENCH_CMD_SUBMIT                1
+#define __USBIP_BENCH_RET_SUBMIT                3
+#define __USBIP_BENCH_DEV_SIZE                  312
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+
+typedef struct usrapp_usbip_bench_t {
+    vk_socket_linux_t socket;
+    uint32_t devid;
+    uint32_t seqnum;
+    uint32_t tag;
+    uint8_t ep_in;
+    uint8_t ep_out;
+    // submits of one transfer are sent together, or nagle delays small headers
+    uint32_t tx_size;
+    uint8_t tx_buffer[(USRAPP_CFG_USBIP_BENCH_MAX_URB_NUM + 2) * 48 + 64];
+} usrapp_usbip_bench_t;
+
+/*============================ LOCAL VARIABLES ===============================*/
+/*============================ PROTOTYPES ====================================*/
+/*============================ IMPLEMENTATION ================================*/
+
+static vsf_err_t __usrapp_usbip_bench_connect(usrapp_usbip_bench_t *bench)
+{
+    vk_socket_addr_t addr = {
+        .port               = USRAPP_CFG_USBIP_BENCH_PORT,
+        .addr.size          = 4,
+        .addr.addr_buf      = { 127, 0, 0, 1 },
+    };
+
+    bench->socket.op = &vk_socket_linux_op;
+    if (VSF_ERR_NONE != vk_socket_open(&bench->socket.use_as__vk_socket_t,
+                VSF_SOCKET_AF_INET, VSF_SOCKET_IPPROTO_TCP)) {
+        return VSF_ERR_FAIL;
+    }
+    if (VSF_ERR_NONE != vk_socket_connect(&bench->socket.use_as__vk_socket_t, &addr)) {
+        vk_socket_close(&bench->socket.use_as__vk_socket_t);
+        return VSF_ERR_FAIL;
+    }
+    return VSF_ERR_NONE;
+}
+
+static vsf_err_t __usrapp_usbip_bench_send(usrapp_usbip_bench_t *bench, const void *buf, uint32_t size)
+{
+    return vk_socket_send(&bench->socket.use_as__vk_socket_t, buf, size, 0);
+}
+
+static vsf_err_t __usrapp_usbip_bench_recv(usrapp_usbip_bench_t *bench, void *buf, uint32_t size)
+{
+    size_t rsize;
+
+    while (size > 0) {
+        if (VSF_ERR_NONE != vk_socket_recv(&bench->socket.use_as__vk_socket_t, buf, size, 0)) {
+            return VSF_ERR_FAIL;
+        }
+        rsize = vk_socket_linux_get_rx_size(&bench->socket);
+        if (0 == rsize) {
+            return VSF_ERR_FAIL;
+        }
+        buf = (uint8_t *)buf + rsize;
+        size -= rsize;
+    }
+    return VSF_ERR_NONE;
+}
+
+static void __usrapp_usbip_bench_op_header(uint8_t *buf, uint16_t code)
+{
+    put_unaligned_be16(__USBIP_BENCH_VERSION, &buf[0]);
+    put_unaligned_be16(code, &buf[2]);
+    put_unaligned_be32(0, &buf[4]);
+}
+
+// import the first exported device, busid is returned in busid[32]
+static vsf_err_t __usrapp_usbip_bench_import(usrapp_usbip_bench_t *bench, char *busid)
+{
+    uint8_t buf[8 + __USBIP_BENCH_DEV_SIZE];
+    uint32_t devnum;
+
+    // OP_REQ_DEVLIST
+    if (VSF_ERR_NONE != __usrapp_usbip_bench_connect(bench)) {
+        printf("fail to connect to usbip server at port %d\r\n", USRAPP_CFG_USBIP_BENCH_PORT);
+        return VSF_ERR_FAIL;
+    }
+    __usrapp_usbip_bench_op_header(buf, __USBIP_BENCH_OP_REQ_DEVLIST);
+    if (    (VSF_ERR_NONE != __usrapp_usbip_bench_send(bench, buf, 8))
+        ||  (VSF_ERR_NONE != __usrapp_usbip_bench_recv(bench, buf, 12))
+        ||  (get_unaligned_be32(&buf[4]) != 0)) {
+        goto fail_close;
+    }
+    devnum = get_unaligned_be32(&buf[8]);
+    if (0 == devnum) {
+        printf("no device exported\r\n");
+        goto fail_close;
+    }
+    if (VSF_ERR_NONE != __usrapp_usbip_bench_recv(bench, buf, __USBIP_BENCH_DEV_SIZE)) {
+        goto fail_close;
+    }
+    memcpy(busid, &buf[256], 32);
+    busid[31] = '\0';
+    printf("device %s: %04X:%04X\r\n", busid,
+        get_unaligned_be16(&buf[256 + 32 + 12]), get_unaligned_be16(&buf[256 + 32 + 14]));
+    vk_socket_close(&bench->socket.use_as__vk_socket_t);
+
+    // OP_REQ_IMPORT, server closes the devlist connection, so connect again
+    if (VSF_ERR_NONE != __usrapp_usbip_bench_connect(bench)) {
+        return VSF_ERR_FAIL;
+    }
+    __usrapp_usbip_bench_op_header(buf, __USBIP_BENCH_OP_REQ_IMPORT);
+    memset(&buf[8], 0, 32);
+    strcpy((char *)&buf[8], busid);
+    if (    (VSF_ERR_NONE != __usrapp_usbip_bench_send(bench, buf, 8 + 32))
+        ||  (VSF_ERR_NONE != __usrapp_usbip_bench_recv(bench, buf, 8))
+        ||  (get_unaligned_be32(&buf[4]) != 0)
+        ||  (VSF_ERR_NONE != __usrapp_usbip_bench_recv(bench, &buf[8], __USBIP_BENCH_DEV_SIZE))) {
+        printf("fail to import %s\r\n", busid);
+        goto fail_close;
+    }
+    bench->devid = (get_unaligned_be32(&buf[8 + 256 + 32]) << 16)
+                |   get_unaligned_be32(&buf[8 + 256 + 32 + 4]);
+    return VSF_ERR_NONE;
+
+fail_close:
+    vk_socket_close(&bench->socket.use_as__vk_socket_t);
+    return VSF_ERR_FAIL;
+}
+
+static vsf_err_t __usrapp_usbip_bench_flush(usrapp_usbip_bench_t *bench)
+{
+    uint32_t size = bench->tx_size;
+
+    bench->tx_size = 0;
+    return __usrapp_usbip_bench_send(bench, bench->tx_buffer, size);
+}
+
+// queue a submit in tx_buffer, returns seqnum of the urb
+static uint32_t __usrapp_usbip_bench_submit(usrapp_usbip_bench_t *bench, uint8_t ep,
+            const uint8_t *setup, void *buffer, uint32_t size)
+{
+    uint8_t *header = &bench->tx_buffer[bench->tx_size];
+    uint32_t seqnum = bench->seqnum++;
+    bool is_in = !!(ep & USB_DIR_IN);
+
+    // only small out payloads, like CBW and control requests, are supported
+    ASSERT(is_in || (bench->tx_size + 48 + size <= sizeof(bench->tx_buffer)));
+    memset(header, 0, 48);
+
+    put_unaligned_be32(__USBIP_BENCH_CMD_SUBMIT, &header[0]);
+    put_unaligned_be32(seqnum, &header[4]);
+    put_unaligned_be32(bench->devid, &header[8]);
+    put_unaligned_be32(is_in ? 1 : 0, &header[12]);
+    put_unaligned_be32(ep & 0x0F, &header[16]);
+    put_unaligned_be32(size, &header[24]);
+    if (setup != NULL) {
+        memcpy(&header[40], setup, 8);
+    }
+    bench->tx_size += 48;
+    if (!is_in && (size > 0)) {
+        memcpy(&bench->tx_buffer[bench->tx_size], buffer, size);
+        bench->tx_size += size;
+    }
+    return seqnum;
+}
+
+// returns actual length, or -1 on error
+static int32_t __usrapp_usbip_bench_reply(usrapp_usbip_bench_t *bench, uint32_t seqnum,
+            void *buffer, uint32_t size)
+{
+    uint8_t header[48];
+    uint32_t actual_length;
+
+    if (    (VSF_ERR_NONE != __usrapp_usbip_bench_recv(bench, header, sizeof(header)))
+        ||  (get_unaligned_be32(&header[0]) != __USBIP_BENCH_RET_SUBMIT)
+        ||  (get_unaligned_be32(&header[4]) != seqnum)
+        ||  (get_unaligned_be32(&header[20]) != 0)) {
+        return -1;
+    }
+    actual_length = get_unaligned_be32(&header[24]);
+    if (get_unaligned_be32(&header[12])) {
+        if (    (actual_length > size)
+            ||  (VSF_ERR_NONE != __usrapp_usbip_bench_recv(bench, buffer, actual_length))) {
+            return -1;
+        }
+    }
+    return (int32_t)actual_length;
+}
+
+static int32_t __usrapp_usbip_bench_control(usrapp_usbip_bench_t *bench,
+            const uint8_t *setup, void *buffer)
+{
+    uint32_t size = get_unaligned_le16(&setup[6]);
+    uint32_t seqnum = __usrapp_usbip_bench_submit(bench, setup[0] & USB_DIR_IN, setup, buffer, size);
+    if (VSF_ERR_NONE != __usrapp_usbip_bench_flush(bench)) {
+        return -1;
+    }
+    return __usrapp_usbip_bench_reply(bench, seqnum, buffer, size);
+}
+
+// set configuration and find the bulk endpoints
+static vsf_err_t __usrapp_usbip_bench_configure(usrapp_usbip_bench_t *bench)
+{
+    uint8_t get_config[8] = { USB_DIR_IN, USB_REQ_GET_DESCRIPTOR, 0, USB_DT_CONFIG, 0, 0, 0, 0 };
+    uint8_t set_config[8] = { 0, USB_REQ_SET_CONFIGURATION, 0, 0, 0, 0, 0, 0 };
+    uint8_t desc[256], *cur;
+    int32_t size;
+
+    put_unaligned_le16(sizeof(desc), &get_config[6]);
+    size = __usrapp_usbip_bench_control(bench, get_config, desc);
+    if (size < USB_DT_CONFIG_SIZE) {
+        return VSF_ERR_FAIL;
+    }
+
+    bench->ep_in = bench->ep_out = 0;
+    for (cur = desc; (cur + 2 <= desc + size) && (cur[0] >= 2); cur += cur[0]) {
+        if ((USB_DT_ENDPOINT == cur[1]) && (USB_ENDPOINT_XFER_BULK == (cur[3] & 0x03))) {
+            if (cur[2] & USB_DIR_IN) {
+                bench->ep_in = cur[2];
+            } else {
+                bench->ep_out = cur[2];
+            }
+        }
+    }
+    if ((0 == bench->ep_in) || (0 == bench->ep_out)) {
+        printf("bulk endpoints not found\r\n");
+        return VSF_ERR_FAIL;
+    }
+
+    set_config[2] = desc[5];
+    return (__usrapp_usbip_bench_control(bench, set_config, NULL) < 0) ? VSF_ERR_FAIL : VSF_ERR_NONE;
+}
+
+// one bulk-only transfer, data stage is split into urb_num urbs in flight
+static vsf_err_t __usrapp_usbip_bench_bot(usrapp_usbip_bench_t *bench, const uint8_t *cdb,
+            uint8_t cdb_len, uint8_t *buffer, uint32_t size, uint32_t urb_num)
+{
+    uint32_t seqnum[USRAPP_CFG_USBIP_BENCH_MAX_URB_NUM], cbw_seqnum, csw_seqnum;
+    uint32_t slice = size / urb_num;
+    uint8_t cbw[31] = { 'U', 'S', 'B', 'C' }, csw[13];
+
+    put_unaligned_le32(bench->tag++, &cbw[4]);
+    put_unaligned_le32(size, &cbw[8]);
+    cbw[12] = USB_DIR_IN;
+    cbw[14] = cdb_len;
+    memcpy(&cbw[15], cdb, cdb_len);
+
+    cbw_seqnum = __usrapp_usbip_bench_submit(bench, bench->ep_out, NULL, cbw, sizeof(cbw));
+    for (uint32_t i = 0; i < urb_num; i++) {
+        seqnum[i] = __usrapp_usbip_bench_submit(bench, bench->ep_in, NULL, buffer + i * slice,
+                    (i == urb_num - 1) ? size - i * slice : slice);
+    }
+    csw_seqnum = __usrapp_usbip_bench_submit(bench, bench->ep_in, NULL, NULL, sizeof(csw));
+    if (VSF_ERR_NONE != __usrapp_usbip_bench_flush(bench)) {
+        return VSF_ERR_FAIL;
+    }
+
+    if (__usrapp_usbip_bench_reply(bench, cbw_seqnum, NULL, 0) != sizeof(cbw)) {
+        return VSF_ERR_FAIL;
+    }
+    for (uint32_t i = 0; i < urb_num; i++) {
+        if (__usrapp_usbip_bench_reply(bench, seqnum[i], buffer + i * slice,
+                    (i == urb_num - 1) ? size - i * slice : slice) < 0) {
+            return VSF_ERR_FAIL;
+        }
+    }
+    if (    (__usrapp_usbip_bench_reply(bench, csw_seqnum, csw, sizeof(csw)) != sizeof(csw))
+        ||  memcmp(csw, "USBS", 4) || (csw[12] != 0)) {
+        return VSF_ERR_FAIL;
+    }
+    return VSF_ERR_NONE;
+}
+
+static vsf_err_t __usrapp_usbip_bench_read10(usrapp_usbip_bench_t *bench, uint32_t lba,
+            uint32_t block_size, uint8_t *buffer, uint32_t size, uint32_t urb_num)
+{
+    uint8_t cdb[10] = { SCSI_CMDCODE_READ };
+
+    cdb[0] |= SCSI_GROUPCODE10_1;
+    put_unaligned_be32(lba, &cdb[2]);
+    put_unaligned_be16(size / block_size, &cdb[7]);
+    return __usrapp_usbip_bench_bot(bench, cdb, sizeof(cdb), buffer, size, urb_num);
+}
+
+static vsf_err_t __usrapp_usbip_bench_read16(usrapp_usbip_bench_t *bench, uint64_t lba,
+            uint32_t block_size, uint8_t *buffer, uint32_t size, uint32_t urb_num)
+{
+    uint8_t cdb[16] = { SCSI_CMDCODE_READ };
+
+    cdb[0] |= SCSI_GROUPCODE16;
+    put_unaligned_be64(lba, &cdb[2]);
+    put_unaligned_be32(size / block_size, &cdb[10]);
+    return __usrapp_usbip_bench_bot(bench, cdb, sizeof(cdb), buffer, size, urb_num);
+}
+
+int usbip_bench_main(int argc, char *argv[])
+{
+    usrapp_usbip_bench_t bench = { .seqnum = 1, .tag = 1 };
+    uint32_t urb_num = 4, size = 64 * 1024, count = 1024;
+    uint32_t block_size, block_num, lba, batch;
+    uint8_t *buffer = NULL, *verify = NULL;
+    uint8_t cdb[10] = { SCSI_CMDCODE_READ_CAPACITY | SCSI_GROUPCODE10_1 };
+    char busid[32];
+    uint64_t start, elapse;
+    int ret = -1;
+
+    if (argc > 4) {
+        printf("format: %s [urb_num] [transfer_size] [count]\r\n", argv[0]);
+        printf("  start usbd_msc with usbip_dcd first\r\n");
+        return -1;
+    }
+    if (argc >= 2) {
+        urb_num = strtoul(argv[1], NULL, 0);
+    }
+    if (argc >= 3) {
+        size = strtoul(argv[2], NULL, 0);
+    }
+    if (argc >= 4) {
+        count = strtoul(argv[3], NULL, 0);
+    }
+    if ((0 == urb_num) || (urb_num > USRAPP_CFG_USBIP_BENCH_MAX_URB_NUM) || (0 == size) || (0 == count)) {
+        printf("invalid parameter\r\n");
+        return -1;
+    }
+
+    if (VSF_ERR_NONE != vk_socket_linux_init()) {
+        printf("fail to initialize socket\r\n");
+        return -1;
+    }
+    if (VSF_ERR_NONE != __usrapp_usbip_bench_import(&bench, busid)) {
+        goto cleanup_socket;
+    }
+    if (VSF_ERR_NONE != __usrapp_usbip_bench_configure(&bench)) {
+        printf("fail to configure %s\r\n", busid);
+        goto cleanup;
+    }
+
+    uint8_t capacity[8];
+    if (VSF_ERR_NONE != __usrapp_usbip_bench_bot(&bench, cdb, sizeof(cdb), capacity, sizeof(capacity), 1)) {
+        printf("fail to read capacity\r\n");
+        goto cleanup;
+    }
+    block_num = get_unaligned_be32(&capacity[0]) + 1;
+    block_size = get_unaligned_be32(&capacity[4]);
+    size = (size + block_size - 1) / block_size * block_size;
+    if ((size / block_size > block_num) || (size / block_size > 0xFFFF)) {
+        printf("transfer size too large\r\n");
+        goto cleanup;
+    }
+    printf("%d blocks of %d bytes, %d urbs per %d-byte READ(10)\r\n",
+        (int)block_num, (int)block_size, (int)urb_num, (int)size);
+
+    buffer = malloc(size);
+    verify = malloc(size);
+    if ((NULL == buffer) || (NULL == verify)) {
+        printf("not enough resources\r\n");
+        goto cleanup;
+    }
+
+    // data split over urbs MUST match data read in one urb
+    if (    (VSF_ERR_NONE != __usrapp_usbip_bench_read10(&bench, 0, block_size, verify, size, 1))
+        ||  (VSF_ERR_NONE != __usrapp_usbip_bench_read10(&bench, 0, block_size, buffer, size, urb_num))
+        ||  memcmp(buffer, verify, size)) {
+        printf("verify failed\r\n");
+        goto cleanup;
+    }
+    // replies of many urbs are batched in one send, and resent from the middle after partial sends
+    batch = USRAPP_CFG_USBIP_BENCH_MAX_URB_NUM;
+    while ((size / block_size) % batch) {
+        batch--;
+    }
+    if (    (VSF_ERR_NONE != __usrapp_usbip_bench_read10(&bench, 0, block_size, buffer, size, batch))
+        ||  memcmp(buffer, verify, size)) {
+        printf("batched verify failed\r\n");
+        goto cleanup;
+    }
+    // READ(16) of the last blocks MUST match READ(10), device may split it by rewriting the cdb
+    lba = block_num - size / block_size;
+    if (    (VSF_ERR_NONE != __usrapp_usbip_bench_read10(&bench, lba, block_size, verify, size, 1))
+        ||  (VSF_ERR_NONE != __usrapp_usbip_bench_read16(&bench, lba, block_size, buffer, size, urb_num))
+        ||  memcmp(buffer, verify, size)) {
+        printf("READ(16) verify failed\r\n");
+        goto cleanup;
+    }
+
+    lba = 0;
+    start = vsf_systimer_get_us();
+    for (uint32_t i = 0; i < count; i++) {
+        if (VSF_ERR_NONE != __usrapp_usbip_bench_read10(&bench, lba, block_size, buffer, size, urb_num)) {
+            printf("fail to read at block %d\r\n", (int)lba);
+            goto cleanup;
+        }
+        lba += size / block_size;
+        if (lba + size / block_size > block_num) {
+            lba = 0;
+        }
+    }
+    elapse = vsf_systimer_get_us() - start;
+    printf("read: %llu bytes in %llu ms, %llu KB/s\r\n",
+        (unsigned long long)size * count, (unsigned long long)(elapse / 1000),
+        (unsigned long long)(elapse ? ((uint64_t)size * count * 1000000 / 1024 / elapse) : 0));
+    ret = 0;
+
+cleanup:
+    if (buffer != NULL) {
+        free(buffer);
+    }
+    if (verify != NULL) {
+        free(verify);
+    }
+    vk_socket_close(&bench.socket.use_as__vk_socket_t);
+cleanup_socket:
+    vk_socket_linux_fini();
+    return ret;
+}
+
+#endif
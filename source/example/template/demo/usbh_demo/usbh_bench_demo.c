@@ -0,0 +1,256 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+/*============================ INCLUDES ======================================*/
+
+#define __VSF_EDA_CLASS_INHERIT__
+#define __VSF_USBH_CLASS_IMPLEMENT_CLASS__
+#include "vsf.h"
+
+#if     VSF_USE_USB_HOST == ENABLED && APP_USE_USBH_DEMO == ENABLED             \
+    &&  APP_USE_USBH_BENCH_DEMO == ENABLED && APP_USE_LINUX_DEMO == ENABLED
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*============================ MACROS ========================================*/
+
+#if VSF_KERNEL_CFG_EDA_SUPPORT_ON_TERMINATE != ENABLED
+#   error "VSF_KERNEL_CFG_EDA_SUPPORT_ON_TERMINATE is required"
+#endif
+
+// default: linux g_zero gadget in source/sink mode
+#ifndef USRAPP_CFG_USBH_BENCH_VID
+#   define USRAPP_CFG_USBH_BENCH_VID            0x0525
+#endif
+#ifndef USRAPP_CFG_USBH_BENCH_PID
+#   define USRAPP_CFG_USBH_BENCH_PID            0xA4A0
+#endif
+#ifndef USRAPP_CFG_USBH_BENCH_MAX_URB_NUM
+#   define USRAPP_CFG_USBH_BENCH_MAX_URB_NUM    16
+#endif
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+
+typedef struct usrapp_usbh_bench_cfg_t {
+    uint32_t urb_num;
+    uint32_t xfer_size;
+    uint32_t total_size;
+} usrapp_usbh_bench_cfg_t;
+
+typedef struct usrapp_usbh_bench_t {
+    implement(vsf_eda_t)
+
+    vk_usbh_t *usbh;
+    vk_usbh_dev_t *dev;
+    uint8_t ep;
+    uint8_t pending;
+    uint8_t urb_num;
+    uint32_t xfer_size;
+    uint64_t submitted;
+    uint64_t received;
+    uint32_t err_cnt;
+    vsf_systimer_cnt_t start_tick;
+    vk_usbh_urb_t urb[USRAPP_CFG_USBH_BENCH_MAX_URB_NUM];
+} usrapp_usbh_bench_t;
+
+/*============================ LOCAL VARIABLES ===============================*/
+
+static const vk_usbh_dev_id_t __usrapp_usbh_bench_dev_id[] = {
+    { VSF_USBH_MATCH_VID_PID(USRAPP_CFG_USBH_BENCH_VID, USRAPP_CFG_USBH_BENCH_PID) },
+};
+
+static usrapp_usbh_bench_cfg_t __usrapp_usbh_bench_cfg = {
+    .urb_num    = 4,
+    .xfer_size  = 16 * 1024,
+    .total_size = 64 * 1024 * 1024,
+};
+
+/*============================ PROTOTYPES ====================================*/
+
+static void * __usrapp_usbh_bench_probe(vk_usbh_t *usbh, vk_usbh_dev_t *dev,
+            vk_usbh_ifs_parser_t *parser_ifs);
+static void __usrapp_usbh_bench_disconnect(vk_usbh_t *usbh, vk_usbh_dev_t *dev,
+            void *param);
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+// registered in usrapp_usbh_common_init
+const vk_usbh_class_drv_t usrapp_usbh_bench_drv = {
+    .name       = "usbh_bench",
+    .dev_id_num = dimof(__usrapp_usbh_bench_dev_id),
+    .dev_ids    = __usrapp_usbh_bench_dev_id,
+    .probe      = __usrapp_usbh_bench_probe,
+    .disconnect = __usrapp_usbh_bench_disconnect,
+};
+
+/*============================ IMPLEMENTATION ================================*/
+
+static void __usrapp_usbh_bench_report(usrapp_usbh_bench_t *bench)
+{
+    uint32_t elapse_ms = vsf_systimer_tick_to_ms(vsf_systimer_get_tick() - bench->start_tick);
+
+    printf("usbh_bench: %d urbs x %d bytes, %llu bytes in %d ms, %llu KB/s, %d errors\r\n",
+        bench->urb_num, (int)bench->xfer_size, (unsigned long long)bench->received,
+        (int)elapse_ms, (unsigned long long)(elapse_ms ? bench->received / elapse_ms : 0),
+        (int)bench->err_cnt);
+#if VSF_USBH_CFG_EP_STATISTICS == ENABLED
+    vk_usbh_ep_stat_t *stat = vk_usbh_get_ep_stat(bench->dev, bench->ep);
+    printf("usbh_bench: ep%02X submit %d, done %d, error %d, %llu bytes\r\n",
+        bench->ep, (int)stat->submit_cnt, (int)stat->done_cnt, (int)stat->err_cnt,
+        (unsigned long long)stat->bytes);
+#endif
+}
+
+static void __usrapp_usbh_bench_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
+{
+    usrapp_usbh_bench_t *bench = container_of(eda, usrapp_usbh_bench_t, use_as__vsf_eda_t);
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+        bench->start_tick = vsf_systimer_get_tick();
+        // keep all urbs in flight, so the hcd never waits for the class driver
+        for (uint_fast8_t i = 0; i < bench->urb_num; i++) {
+            if (VSF_ERR_NONE != vk_usbh_submit_urb(bench->usbh, &bench->urb[i])) {
+                break;
+            }
+            bench->submitted += bench->xfer_size;
+            bench->pending++;
+        }
+        break;
+    case VSF_EVT_MESSAGE: {
+            vk_usbh_urb_t urb = { .urb_hcd = vsf_eda_get_cur_msg() };
+
+            bench->pending--;
+            if (URB_OK == vk_usbh_urb_get_status(&urb)) {
+                bench->received += vk_usbh_urb_get_actual_length(&urb);
+            } else {
+                bench->err_cnt++;
+            }
+
+            if (bench->submitted < __usrapp_usbh_bench_cfg.total_size) {
+                // buffer is bound to the urb, no re-allocation on resubmit
+                if (VSF_ERR_NONE == vk_usbh_resubmit_urb(bench->usbh, &urb, bench->xfer_size)) {
+                    bench->submitted += bench->xfer_size;
+                    bench->pending++;
+                }
+            }
+            if (!bench->pending) {
+                __usrapp_usbh_bench_report(bench);
+            }
+        }
+        break;
+    }
+}
+
+static void __usrapp_usbh_bench_on_eda_terminate(vsf_eda_t *eda)
+{
+    usrapp_usbh_bench_t *bench = container_of(eda, usrapp_usbh_bench_t, use_as__vsf_eda_t);
+    vsf_usbh_free(bench);
+}
+
+static void * __usrapp_usbh_bench_probe(vk_usbh_t *usbh, vk_usbh_dev_t *dev,
+            vk_usbh_ifs_parser_t *parser_ifs)
+{
+    vk_usbh_ifs_alt_parser_t *parser_alt = &parser_ifs->parser_alt[parser_ifs->ifs->cur_alt];
+    struct usb_endpoint_desc_t *desc_ep = parser_alt->desc_ep;
+    usrapp_usbh_bench_t *bench;
+
+    for (int i = 0; i < parser_alt->num_of_ep; i++) {
+        if (    ((desc_ep->bmAttributes & USB_ENDPOINT_XFERTYPE_MASK) == USB_ENDPOINT_XFER_BULK)
+            &&  (desc_ep->bEndpointAddress & USB_DIR_MASK)) {
+            break;
+        }
+        desc_ep = (struct usb_endpoint_desc_t *)((uintptr_t)desc_ep + USB_DT_ENDPOINT_SIZE);
+        if (i == parser_alt->num_of_ep - 1) {
+            return NULL;
+        }
+    }
+
+    bench = vsf_usbh_malloc(sizeof(*bench));
+    if (NULL == bench) {
+        return NULL;
+    }
+    memset(bench, 0, sizeof(*bench));
+    bench->usbh = usbh;
+    bench->dev = dev;
+    bench->ep = desc_ep->bEndpointAddress;
+    bench->urb_num = min(__usrapp_usbh_bench_cfg.urb_num, USRAPP_CFG_USBH_BENCH_MAX_URB_NUM);
+    bench->xfer_size = __usrapp_usbh_bench_cfg.xfer_size;
+
+    for (uint_fast8_t i = 0; i < bench->urb_num; i++) {
+        vk_usbh_urb_prepare(&bench->urb[i], dev, desc_ep);
+        if (VSF_ERR_NONE != vk_usbh_alloc_urb_ex(usbh, dev, &bench->urb[i], bench->xfer_size)) {
+            while (i-- > 0) {
+                vk_usbh_free_urb(usbh, &bench->urb[i]);
+            }
+            vsf_usbh_free(bench);
+            return NULL;
+        }
+    }
+#if VSF_USBH_CFG_EP_STATISTICS == ENABLED
+    vk_usbh_reset_ep_stat(dev);
+#endif
+
+    bench->fn.evthandler = __usrapp_usbh_bench_evthandler;
+    bench->on_terminate = __usrapp_usbh_bench_on_eda_terminate;
+    vsf_eda_init(&bench->use_as__vsf_eda_t, vsf_prio_inherit, false);
+    return bench;
+}
+
+static void __usrapp_usbh_bench_disconnect(vk_usbh_t *usbh, vk_usbh_dev_t *dev, void *param)
+{
+    usrapp_usbh_bench_t *bench = param;
+
+    if (bench->pending) {
+        __usrapp_usbh_bench_report(bench);
+    }
+    for (uint_fast8_t i = 0; i < bench->urb_num; i++) {
+        vk_usbh_free_urb(usbh, &bench->urb[i]);
+    }
+    vsf_eda_fini(&bench->use_as__vsf_eda_t);
+}
+
+// parameters apply to the next attached device
+int usbh_bench_main(int argc, char *argv[])
+{
+    if (argc > 4) {
+        printf("format: %s [urb_num] [xfer_size] [total_size]\r\n", argv[0]);
+        return -1;
+    }
+    if (argc >= 2) {
+        __usrapp_usbh_bench_cfg.urb_num = strtoul(argv[1], NULL, 0);
+    }
+    if (argc >= 3) {
+        __usrapp_usbh_bench_cfg.xfer_size = strtoul(argv[2], NULL, 0);
+    }
+    if (argc >= 4) {
+        __usrapp_usbh_bench_cfg.total_size = strtoul(argv[3], NULL, 0);
+    }
+    if (    !__usrapp_usbh_bench_cfg.urb_num || !__usrapp_usbh_bench_cfg.xfer_size
+        ||  (__usrapp_usbh_bench_cfg.xfer_size > 0xFFFF)) {
+        printf("invalid parameter\r\n");
+        return -1;
+    }
+
+    printf("usbh_bench: waiting for %04X:%04X, benchmark starts on attach\r\n",
+        USRAPP_CFG_USBH_BENCH_VID, USRAPP_CFG_USBH_BENCH_PID);
+    return 0;
+}
+
+#endif
@@ -169,7 +169,7 @@ int vsfip_main(int argc, char *argv[])
     vsfip_init();
     vsfip_dnsc_init();
 
-#if VSF_NETDRV_USE_WPCAP == ENABLED
+#if VSF_NETDRV_USE_WPCAP == ENABLED || VSF_NETDRV_USE_LINUX == ENABLED
     if (argc != 2) {
         printf("format: %s NETDRV_NAME\r\n", argv[0]);
         return -1;
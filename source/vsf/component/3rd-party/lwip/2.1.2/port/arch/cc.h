@@ -61,6 +61,16 @@
             ASSERT(false);                                                      \
         } while (0)
 
+#if VSF_USE_TCPIP == ENABLED
+#   include "component/tcpip/checksum/vsf_inet_checksum.h"
+
+// optimized checksum and copy-and-checksum(used if LWIP_CHECKSUM_ON_COPY)
+#   define LWIP_CHKSUM(__data, __len)                                           \
+            vk_inet_chksum((__data), (__len))
+#   define LWIP_CHKSUM_COPY(__dst, __src, __len)                                \
+            vk_inet_chksum_copy((__dst), (__src), (__len))
+#endif
+
 #define PACK_STRUCT_FIELD(x) x PACKED
 #define PACK_STRUCT_STRUCT PACKED
 #define PACK_STRUCT_BEGIN
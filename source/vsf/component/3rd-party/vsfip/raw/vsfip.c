@@ -30,6 +30,7 @@
 #define __VSFIP_CLASS_IMPLEMENT
 #include "kernel/vsf_kernel.h"
 #include "./vsfip.h"
+#include "component/tcpip/checksum/vsf_inet_checksum.h"
 
 /*============================ MACROS ========================================*/
 
@@ -444,38 +445,20 @@ vsf_err_t vsfip_fini(void)
     return VSF_ERR_NONE;
 }
 
+// checksum in cpu endian
 static uint_fast16_t __vsfip_checksum(uint8_t *data, uint16_t len)
 {
-    uint_fast32_t checksum = 0;
-
-    while (len > 1) {
-        checksum += get_unaligned_be16(data);
-        data += 2;
-        len -= 2;
-    }
-    if (1 == len) {
-        checksum += (uint_fast16_t)(*data) << 8;
-    }
-    checksum = (checksum & 0xFFFF) + (checksum >> 16);
-    checksum = (checksum & 0xFFFF) + (checksum >> 16);
-    return (uint_fast16_t)checksum;
+    return be16_to_cpu(vk_inet_chksum(data, len));
 }
 
 static uint_fast16_t __vsfip_proto_checksum(vsfip_socket_t *socket, vsfip_netbuf_t *netbuf)
 {
-    uint_fast32_t checksum = __vsfip_checksum(netbuf->buf.buffer, netbuf->buf.size);
-    vsfip_ipaddr_t *local_addr = &netbuf->netif->ip4addr;
-    vsfip_ipaddr_t *remote_addr = &socket->remote_sockaddr.addr;
+    uint32_t checksum = vk_inet_csum_partial(netbuf->buf.buffer, netbuf->buf.size, 0);
 
-    checksum += get_unaligned_be16(&local_addr->addr_buf[0]);
-    checksum += get_unaligned_be16(&local_addr->addr_buf[2]);
-    checksum += get_unaligned_be16(&remote_addr->addr_buf[0]);
-    checksum += get_unaligned_be16(&remote_addr->addr_buf[2]);
-    checksum += socket->protocol;
-    checksum += netbuf->buf.size;
-    checksum = (checksum & 0xFFFF) + (checksum >> 16);
-    checksum = (checksum & 0xFFFF) + (checksum >> 16);
-    return (uint_fast16_t)checksum;
+    checksum = vk_inet_csum_pseudo_ip4(netbuf->netif->ip4addr.addr32,
+                socket->remote_sockaddr.addr.addr32, socket->protocol,
+                netbuf->buf.size, checksum);
+    return be16_to_cpu(vk_inet_csum_fold(checksum));
 }
 
 // ip
@@ -1702,10 +1685,8 @@ static void __vsfip_icmp_input(vsfip_netbuf_t *netbuf)
         iphead->checksum = cpu_to_be16(iphead->checksum);
 
         icmphead->type = VSFIP_ICMP_ECHO_REPLY;
-        icmphead->checksum += cpu_to_be16(VSFIP_ICMP_ECHO << 8);
-        if (icmphead->checksum >= cpu_to_be16(0xffff - (VSFIP_ICMP_ECHO << 8))) {
-            icmphead->checksum++;
-        }
+        icmphead->checksum = vk_inet_chksum_replace16(icmphead->checksum,
+                cpu_to_be16(VSFIP_ICMP_ECHO << 8), cpu_to_be16(VSFIP_ICMP_ECHO_REPLY << 8));
 
         if (NULL != vsfip_netbuf_header(netbuf, iph_hlen)) {
             vsfip_netif_ip_output(netbuf, false);
@@ -43,6 +43,13 @@
 #define FAT_ATTR_DIRECTORY              0x10
 #define FAT_ATTR_ARCHIVE                0x20
 
+// lfn entries are limited by the filename buffer in lookup, which is unicode
+#define FAT_LFN_CHARS                   13
+#define FAT_LFN_MAX_ENTRY               ((VSF_FATFS_CFG_MAX_FILENAME - 2) / (FAT_LFN_CHARS * 2))
+
+// 1980-01-01 00:00:00 for entries created, since there is no calendar time
+#define FAT_DEFAULT_DATE                ((1 << 5) | 1)
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
 
@@ -150,14 +157,66 @@ typedef struct vk_fatfs_read_local {
     uint32_t cur_run_sector;
 } vk_fatfs_read_local;
 
+typedef struct vk_fatfs_write_local {
+    uint32_t cur_cluster;
+    uint32_t cur_sector;
+    uint32_t cur_size;
+    uint32_t cur_run_size;
+    uint32_t cur_run_sector;
+    // zeros to write from the original end of file to offset
+    uint32_t gap_size;
+} vk_fatfs_write_local;
+
+typedef struct vk_fatfs_resize_local {
+    uint32_t cluster;
+    uint32_t next;
+} vk_fatfs_resize_local;
+
 typedef struct vk_fatfs_lookup_local {
     uint32_t cur_cluster;
     uint32_t cur_sector;
     char *filename;
     uint32_t cur_sector_in_cluster;
+    uint32_t cur_file_cluster;
+    uint32_t prev_sector;
     vk_fatfs_dentry_parser_t dparser;
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+    // location of entry from dentry cache to verify, 0 if not used
+    uint64_t cached;
+    uint32_t generation;
+#endif
 } vk_fatfs_lookup_local;
 
+typedef struct vk_fatfs_create_local {
+    // lfn entries and sfn entry to write, followed by a sector buffer
+    fatfs_dentry_t *entries;
+    vk_file_t *file;
+    uint32_t cur_cluster;
+    uint32_t cur_sector;
+    uint32_t cur_sector_in_cluster;
+    uint32_t cur_file_cluster;
+    // sectors of free entries found, and index of the first free entry
+    uint32_t sectors[3];
+    uint16_t first_index;
+    uint8_t sector_num;
+    uint8_t free_num;
+    uint8_t entry_num;
+    uint8_t basis_len;
+    // numeric tails used by other sfn entries with the same basis name,
+    //  and with the hashed basis name which is used if all tails of basis name are used
+    uint16_t tail_mask;
+    uint16_t hash_tail_mask;
+    char hash_basis[6];
+    bool is_end;
+    uint8_t cur_idx;
+} vk_fatfs_create_local;
+
+typedef struct vk_fatfs_unlink_local {
+    vk_fatfs_file_t *file;
+    vk_file_t *child;
+    uint8_t *buffer;
+} vk_fatfs_unlink_local;
+
 /*============================ PROTOTYPES ====================================*/
 
 dcl_vsf_peda_methods(static, __vk_fatfs_mount)
@@ -165,7 +224,10 @@ dcl_vsf_peda_methods(static, __vk_fatfs_unmount)
 dcl_vsf_peda_methods(static, __vk_fatfs_lookup)
 dcl_vsf_peda_methods(static, __vk_fatfs_read)
 dcl_vsf_peda_methods(static, __vk_fatfs_write)
+dcl_vsf_peda_methods(static, __vk_fatfs_resize)
 dcl_vsf_peda_methods(static, __vk_fatfs_close)
+dcl_vsf_peda_methods(static, __vk_fatfs_create)
+dcl_vsf_peda_methods(static, __vk_fatfs_unlink)
 
 /*============================ GLOBAL VARIABLES ==============================*/
 
@@ -182,16 +244,20 @@ const vk_fs_op_t vk_fatfs_op = {
 #endif
     .fop                    = {
         .read_local_size    = sizeof(vk_fatfs_read_local),
+        .write_local_size   = sizeof(vk_fatfs_write_local),
+        .resize_local_size  = sizeof(vk_fatfs_resize_local),
         .fn_read            = (vsf_peda_evthandler_t)vsf_peda_func(__vk_fatfs_read),
         .fn_write           = (vsf_peda_evthandler_t)vsf_peda_func(__vk_fatfs_write),
         .fn_close           = (vsf_peda_evthandler_t)vsf_peda_func(__vk_fatfs_close),
-        .fn_resize          = (vsf_peda_evthandler_t)vsf_peda_func(vk_dummyfs_not_support),
+        .fn_resize          = (vsf_peda_evthandler_t)vsf_peda_func(__vk_fatfs_resize),
     },
     .dop                    = {
         .lookup_local_size  = sizeof(vk_fatfs_lookup_local),
+        .create_local_size  = sizeof(vk_fatfs_create_local),
+        .unlink_local_size  = sizeof(vk_fatfs_unlink_local),
         .fn_lookup          = (vsf_peda_evthandler_t)vsf_peda_func(__vk_fatfs_lookup),
-        .fn_create          = (vsf_peda_evthandler_t)vsf_peda_func(vk_dummyfs_not_support),
-        .fn_unlink          = (vsf_peda_evthandler_t)vsf_peda_func(vk_dummyfs_not_support),
+        .fn_create          = (vsf_peda_evthandler_t)vsf_peda_func(__vk_fatfs_create),
+        .fn_unlink          = (vsf_peda_evthandler_t)vsf_peda_func(__vk_fatfs_unlink),
         .fn_chmod           = (vsf_peda_evthandler_t)vsf_peda_func(vk_dummyfs_not_support),
         .fn_rename          = (vsf_peda_evthandler_t)vsf_peda_func(vk_dummyfs_not_support),
     },
@@ -211,6 +277,11 @@ static const uint8_t __vk_fatfs_fat_bitsize[] = {
     [VSF_FAT_EX]    = 32,
 };
 
+// offsets of unicode characters in lfn entry
+static const uint8_t __vk_fatfs_lfn_offsets[FAT_LFN_CHARS] = {
+    1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30,
+};
+
 /*============================ IMPLEMENTATION ================================*/
 
 bool vk_fatfs_is_lfn(char *name)
@@ -278,7 +349,7 @@ static vsf_err_t __vk_fatfs_parse_dbr(__vk_fatfs_info_t *info, uint8_t *buff)
         if (    (   (sector_size != info->block_size)
                 ||  (   (sector_size != 512) && (sector_size != 1024)
                     &&  (sector_size != 2048) && (sector_size != 4096)))
-            ||  (!dbr->bpb.SecPerClus || !info->cluster_size_bits)
+            ||  (!dbr->bpb.SecPerClus || (dbr->bpb.SecPerClus & (dbr->bpb.SecPerClus - 1)))
             ||  !reserved_size
             ||  !info->fat_num
             ||  !sector_num
@@ -288,7 +359,7 @@ static vsf_err_t __vk_fatfs_parse_dbr(__vk_fatfs_info_t *info, uint8_t *buff)
 
         root_entry = le16_to_cpu(dbr->bpb.RootEntCnt);
         if (root_entry) {
-            info->root_size = ((root_entry >> 5) + sector_size - 1) / sector_size;
+            info->root_size = ((root_entry << 5) + sector_size - 1) / sector_size;
         } else {
             info->root_size = 0;
         }
@@ -296,8 +367,11 @@ static vsf_err_t __vk_fatfs_parse_dbr(__vk_fatfs_info_t *info, uint8_t *buff)
         info->fat_sector = reserved_size;
         info->root_sector = info->fat_sector + info->fat_num * info->fat_size;
         info->data_sector = info->root_sector + info->root_size;
-        // calculate cluster number: note that cluster starts from root_cluster
-        cluster_num = (sector_num - reserved_size) >> info->cluster_size_bits;
+        // calculate cluster number in data region, data region starts from cluster 2
+        if (sector_num <= info->data_sector) {
+            return VSF_ERR_FAIL;
+        }
+        cluster_num = (sector_num - info->data_sector) >> info->cluster_size_bits;
 
         // for FAT32 RootEntCnt MUST be 0
         if (!root_entry) {
@@ -315,15 +389,24 @@ static vsf_err_t __vk_fatfs_parse_dbr(__vk_fatfs_info_t *info, uint8_t *buff)
                 return VSF_ERR_FAIL;
             }
 
-            info->cluster_num = info->root.first_cluster + cluster_num;
+            info->fsinfo_sector = le16_to_cpu(dbr->fat32.bpb.FSInfo);
+            if ((info->fsinfo_sector >= reserved_size) || (0xFFFF == info->fsinfo_sector)) {
+                info->fsinfo_sector = 0;
+            }
+            info->cluster_num = cluster_num + 2;
         } else {
             // FAT12 or FAT16
             info->type = (cluster_num < 4085) ? VSF_FAT_12 : VSF_FAT_16;
 
             // root has no cluster
             info->root.first_cluster = 0;
+            info->fsinfo_sector = 0;
             info->cluster_num = cluster_num + 2;
         }
+
+        // clusters MUST be covered by FAT
+        tmp32 = ((uint64_t)info->fat_size << (info->sector_size_bits + 3)) / __vk_fatfs_fat_bitsize[info->type];
+        info->cluster_num = min(info->cluster_num, tmp32);
     } else {
         // bpb all 0, exFAT
         info->type = VSF_FAT_EX;
@@ -338,6 +421,7 @@ static vsf_err_t __vk_fatfs_parse_dbr(__vk_fatfs_info_t *info, uint8_t *buff)
         info->data_sector = info->root_sector;
         info->root.first_cluster = le32_to_cpu(dbr->exfat.bpb.RootClus);
         info->cluster_num = le32_to_cpu(dbr->exfat.bpb.ClusSecCount) + 2;
+        info->fsinfo_sector = 0;
 
         // SecBits CANNOT be smaller than 9, which is 512 byte
         // RootClus CANNOT be less than 2
@@ -351,7 +435,7 @@ static vsf_err_t __vk_fatfs_parse_dbr(__vk_fatfs_info_t *info, uint8_t *buff)
 
 static uint_fast32_t __vk_fatfs_clus2sec(__vk_fatfs_info_t *fsinfo, uint_fast32_t cluster)
 {
-    cluster -= fsinfo->root.first_cluster ? fsinfo->root.first_cluster : 2;
+    cluster -= 2;
     return fsinfo->data_sector + (cluster << fsinfo->cluster_size_bits);
 }
 
@@ -388,6 +472,547 @@ static bool __vk_fatfs_fat_entry_is_eof(__vk_fatfs_info_t *fsinfo, uint_fast32_t
     return (cluster >= (mask - 8)) && (cluster <= mask);
 }
 
+static bool __vk_fatfs_cluster_is_valid(__vk_fatfs_info_t *fsinfo, uint_fast32_t cluster)
+{
+    return  __vk_fatfs_fat_entry_is_valid(fsinfo, cluster)
+        &&  !__vk_fatfs_fat_entry_is_eof(fsinfo, cluster)
+        &&  ((cluster & 0x0FFFFFFF) < fsinfo->cluster_num);
+}
+
+static uint_fast32_t __vk_fatfs_fat_entry_eof(__vk_fatfs_info_t *fsinfo)
+{
+    uint_fast8_t fat_bit = __vk_fatfs_fat_bitsize[fsinfo->type];
+    return (32 == fat_bit) ? 0x0FFFFFFF : (1UL << fat_bit) - 1;
+}
+
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+static uint_fast32_t __vk_fatfs_extent_end(vk_fatfs_file_t *file, uint_fast16_t idx)
+{
+    return (idx + 1 < file->extent.num) ?
+                file->extent.extents[idx + 1].file_cluster : file->extent.cluster_num;
+}
+
+// get cluster of file_cluster from extents, 0 if not cached
+//  run(if not NULL) will be the number of contiguous clusters from file_cluster
+static uint_fast32_t __vk_fatfs_extent_get(vk_fatfs_file_t *file, uint_fast32_t file_cluster, uint32_t *run)
+{
+    vk_fatfs_extent_t *extents = file->extent.extents;
+    uint_fast16_t idx, low, high, mid;
+
+    if (file_cluster >= file->extent.cluster_num) {
+        return 0;
+    }
+
+    // try the hint and the next extent first for sequential access
+    idx = file->extent.hint;
+    if (file_cluster < extents[idx].file_cluster) {
+        low = 0;
+        high = idx;
+    } else if (file_cluster < __vk_fatfs_extent_end(file, idx)) {
+        goto found;
+    } else if (file_cluster < __vk_fatfs_extent_end(file, ++idx)) {
+        goto found;
+    } else {
+        low = idx + 1;
+        high = file->extent.num;
+    }
+
+    // search for the last extent starting before or at file_cluster in [low, high)
+    while (high - low > 1) {
+        mid = (low + high) >> 1;
+        if (extents[mid].file_cluster <= file_cluster) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    idx = low;
+
+found:
+    file->extent.hint = idx;
+    if (run != NULL) {
+        *run = __vk_fatfs_extent_end(file, idx) - file_cluster;
+    }
+    return extents[idx].cluster + file_cluster - extents[idx].file_cluster;
+}
+
+// cluster chain MUST be added in order, clusters out of order will be ignored
+static void __vk_fatfs_extent_add(vk_fatfs_file_t *file, uint_fast32_t file_cluster, uint_fast32_t cluster)
+{
+    vk_fatfs_extent_t *extent;
+
+    if (file_cluster != file->extent.cluster_num) {
+        return;
+    }
+
+    if (file->extent.num > 0) {
+        extent = &file->extent.extents[file->extent.num - 1];
+        if (cluster == extent->cluster + file_cluster - extent->file_cluster) {
+            file->extent.cluster_num++;
+            return;
+        }
+    }
+
+    if (file->extent.num >= file->extent.size) {
+        uint_fast16_t size;
+
+        if (file->extent.size >= VSF_FATFS_CFG_EXTENT_MAX_NUM) {
+            return;
+        }
+        if (!file->extent.size) {
+            size = min(4, VSF_FATFS_CFG_EXTENT_MAX_NUM);
+            extent = vsf_heap_malloc(size * sizeof(vk_fatfs_extent_t));
+        } else {
+            size = min(file->extent.size * 2, VSF_FATFS_CFG_EXTENT_MAX_NUM);
+            extent = vsf_heap_realloc(file->extent.extents, size * sizeof(vk_fatfs_extent_t));
+        }
+        if (NULL == extent) {
+            return;
+        }
+        file->extent.extents = extent;
+        file->extent.size = size;
+    }
+
+    extent = &file->extent.extents[file->extent.num++];
+    extent->file_cluster = file_cluster;
+    extent->cluster = cluster;
+    file->extent.cluster_num++;
+}
+
+static void __vk_fatfs_extent_init(__vk_fatfs_info_t *fsinfo, vk_fatfs_file_t *file)
+{
+    if (!file->extent.cluster_num && __vk_fatfs_cluster_is_valid(fsinfo, file->first_cluster)) {
+        __vk_fatfs_extent_add(file, 0, file->first_cluster & 0x0FFFFFFF);
+    }
+}
+
+static void __vk_fatfs_extent_fini(vk_fatfs_file_t *file)
+{
+    if (file->extent.extents != NULL) {
+        vsf_heap_free(file->extent.extents);
+    }
+    memset(&file->extent, 0, sizeof(file->extent));
+}
+
+// drop clusters from cluster_num in file
+static void __vk_fatfs_extent_truncate(vk_fatfs_file_t *file, uint_fast32_t cluster_num)
+{
+    if (file->extent.cluster_num > cluster_num) {
+        file->extent.cluster_num = cluster_num;
+        while ((file->extent.num > 0) && (file->extent.extents[file->extent.num - 1].file_cluster >= cluster_num)) {
+            file->extent.num--;
+        }
+        file->extent.hint = 0;
+    }
+    if (file->extent.last_file_cluster >= cluster_num) {
+        file->extent.last_cluster = 0;
+    }
+}
+#endif
+
+static bool __vk_fatfs_is_sfn_char(char ch)
+{
+    return isalnum((int)ch) || ((ch != '\0') && (strchr("$%'-_@~`!(){}^#&", ch) != NULL));
+}
+
+// convert name to sfn, return false if name is not a valid 8.3 name and lfn is needed
+//  lower case of name or extension is supported by LCase in sfn entry
+static bool __vk_fatfs_name_to_sfn(const char *name, char *sfn, uint8_t *lcase)
+{
+    const char *ext = strrchr(name, '.');
+    uint_fast8_t name_len, ext_len, lower, upper;
+
+    if (ext != NULL) {
+        name_len = ext - name;
+        ext_len = strlen(++ext);
+        if (!ext_len) {
+            return false;
+        }
+    } else {
+        name_len = strlen(name);
+        ext_len = 0;
+    }
+    if (!name_len || (name_len > 8) || (ext_len > 3)) {
+        return false;
+    }
+
+    memset(sfn, ' ', 11);
+    *lcase = 0;
+    for (uint_fast8_t part = 0; part < 2; part++) {
+        const char *cur = part ? ext : name;
+        uint_fast8_t len = part ? ext_len : name_len;
+
+        lower = upper = 0;
+        for (uint_fast8_t i = 0; i < len; i++) {
+            if (!__vk_fatfs_is_sfn_char(cur[i])) {
+                return false;
+            }
+            lower |= islower((int)cur[i]) ? 1 : 0;
+            upper |= isupper((int)cur[i]) ? 1 : 0;
+            sfn[(part ? 8 : 0) + i] = toupper((int)cur[i]);
+        }
+        if (lower && upper) {
+            return false;
+        } else if (lower) {
+            *lcase |= part ? 0x10 : 0x08;
+        }
+    }
+    return true;
+}
+
+// generate basis name of sfn for lfn, numeric tail is added after the basis name
+static uint_fast8_t __vk_fatfs_lfn_to_sfn_basis(const char *name, char *sfn)
+{
+    const char *ext;
+    uint_fast8_t len = 0;
+
+    // leading dots are not part of extension
+    while ('.' == *name) {
+        name++;
+    }
+    ext = strrchr(name, '.');
+
+    memset(sfn, ' ', 11);
+    for (const char *cur = name; (*cur != '\0') && (cur != ext) && (len < 6); cur++) {
+        if ((*cur != ' ') && (*cur != '.')) {
+            sfn[len++] = __vk_fatfs_is_sfn_char(*cur) ? toupper((int)*cur) : '_';
+        }
+    }
+    if (!len) {
+        sfn[len++] = '_';
+    }
+    if (ext != NULL) {
+        uint_fast8_t ext_len = 0;
+        for (const char *cur = ext + 1; (*cur != '\0') && (ext_len < 3); cur++) {
+            if (*cur != ' ') {
+                sfn[8 + ext_len++] = __vk_fatfs_is_sfn_char(*cur) ? toupper((int)*cur) : '_';
+            }
+        }
+    }
+    return len;
+}
+
+// return numeric tail of sfn if sfn is basis with numeric tail, 0 otherwise
+static uint_fast8_t __vk_fatfs_sfn_get_tail(const char *sfn, const char *basis,
+            uint_fast8_t basis_len, const char *ext)
+{
+    if (    memcmp(sfn, basis, basis_len) || ('~' != sfn[basis_len])
+        ||  (sfn[basis_len + 1] < '1') || (sfn[basis_len + 1] > '9')
+        ||  ((basis_len + 2 < 8) && (sfn[basis_len + 2] != ' '))
+        ||  memcmp(&sfn[8], ext, 3)) {
+        return 0;
+    }
+    return sfn[basis_len + 1] - '0';
+}
+
+static uint8_t __vk_fatfs_sfn_checksum(const char *sfn)
+{
+    uint8_t sum = 0;
+    for (uint_fast8_t i = 0; i < 11; i++) {
+        sum = ((sum & 1) << 7) + (sum >> 1) + (uint8_t)sfn[i];
+    }
+    return sum;
+}
+
+// fill lfn entries before the sfn entry, the last part of name is in the first entry
+static void __vk_fatfs_fill_lfn(fatfs_dentry_t *entries, uint_fast8_t lfn_num, const char *name)
+{
+    uint8_t checksum = __vk_fatfs_sfn_checksum(entries[lfn_num].fat.Name);
+    uint_fast32_t name_len = strlen(name), pos;
+    uint_fast16_t uchar;
+    uint8_t *buf;
+
+    for (uint_fast8_t i = 0; i < lfn_num; i++) {
+        buf = (uint8_t *)&entries[lfn_num - 1 - i];
+        memset(buf, 0, sizeof(fatfs_dentry_t));
+        buf[0] = (i + 1) | ((i + 1 == lfn_num) ? 0x40 : 0);
+        buf[11] = FAT_ATTR_LFN;
+        buf[13] = checksum;
+        for (uint_fast8_t j = 0; j < dimof(__vk_fatfs_lfn_offsets); j++) {
+            pos = i * FAT_LFN_CHARS + j;
+            uchar = (pos < name_len) ? (uint8_t)name[pos] : (pos == name_len) ? 0 : 0xFFFF;
+            put_unaligned_le16(uchar, &buf[__vk_fatfs_lfn_offsets[j]]);
+        }
+    }
+}
+
+static void __vk_fatfs_fill_sfn(fatfs_dentry_t *dentry, const char *name, uint_fast8_t attr, uint_fast32_t cluster)
+{
+    memset(dentry, 0, sizeof(*dentry));
+    memcpy(dentry->fat.Name, name, 11);
+    dentry->fat.Attr = attr;
+    dentry->fat.CrtData = cpu_to_le16(FAT_DEFAULT_DATE);
+    dentry->fat.LstAccData = cpu_to_le16(FAT_DEFAULT_DATE);
+    dentry->fat.WrtData = cpu_to_le16(FAT_DEFAULT_DATE);
+    dentry->fat.FstClusHi = cpu_to_le16(cluster >> 16);
+    dentry->fat.FstClusLo = cpu_to_le16(cluster & 0xFFFF);
+}
+
+static void __vk_fatfs_free_file(vk_fatfs_file_t *file)
+{
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+    __vk_fatfs_extent_fini(file);
+#endif
+    if (file->name != NULL) {
+        vsf_heap_free(file->name);
+    }
+    vk_file_free(&file->use_as__vk_file_t);
+}
+
+#if VSF_FATFS_CFG_FAT_CACHE_NUM > 0
+static uint8_t * __vk_fatfs_fat_cache_buff(__vk_fatfs_info_t *fsinfo, vk_fatfs_fat_cache_node_t *node)
+{
+    return &fsinfo->fat_cache.buffer[(node - fsinfo->fat_cache.nodes) << fsinfo->sector_size_bits];
+}
+
+static vk_fatfs_fat_cache_node_t * __vk_fatfs_fat_cache_find(__vk_fatfs_info_t *fsinfo, uint_fast32_t sector)
+{
+    vk_fatfs_fat_cache_node_t *node = fsinfo->fat_cache.nodes;
+
+    for (uint_fast8_t i = 0; i < fsinfo->fat_cache.number; i++, node++) {
+        if (!node->is_busy && (node->sector == sector)) {
+            node->access_tick = ++fsinfo->fat_cache.tick;
+            return node;
+        }
+    }
+    return NULL;
+}
+
+// get cached FAT sector, NULL if not cached
+static uint8_t * __vk_fatfs_fat_cache_get(__vk_fatfs_info_t *fsinfo, uint_fast32_t sector)
+{
+    vk_fatfs_fat_cache_node_t *node = __vk_fatfs_fat_cache_find(fsinfo, sector);
+    return (node != NULL) ? __vk_fatfs_fat_cache_buff(fsinfo, node) : NULL;
+}
+
+// get least recently used node to read FAT sector, NULL if all nodes are busy
+static vk_fatfs_fat_cache_node_t * __vk_fatfs_fat_cache_alloc(__vk_fatfs_info_t *fsinfo, uint_fast32_t sector)
+{
+    vk_fatfs_fat_cache_node_t *node = fsinfo->fat_cache.nodes, *least_node = NULL;
+
+    for (uint_fast8_t i = 0; i < fsinfo->fat_cache.number; i++, node++) {
+        if (    !node->is_busy
+            &&  ((NULL == least_node) || (node->access_tick < least_node->access_tick))) {
+            least_node = node;
+        }
+    }
+    if (least_node != NULL) {
+        least_node->sector = sector;
+        least_node->is_busy = true;
+    }
+    return least_node;
+}
+
+// drop other copies of FAT sector updated by node, including those still being read
+static void __vk_fatfs_fat_cache_invalidate(__vk_fatfs_info_t *fsinfo, vk_fatfs_fat_cache_node_t *node,
+            uint_fast32_t sector)
+{
+    vk_fatfs_fat_cache_node_t *cur = fsinfo->fat_cache.nodes;
+
+    for (uint_fast8_t i = 0; i < fsinfo->fat_cache.number; i++, cur++) {
+        if ((cur != node) && (cur->sector == sector)) {
+            cur->sector = 0;
+        }
+    }
+}
+
+static void __vk_fatfs_fat_cache_commit(__vk_fatfs_info_t *fsinfo, vk_fatfs_fat_cache_node_t *node,
+            uint_fast32_t sector)
+{
+    node->sector = sector;
+    node->access_tick = ++fsinfo->fat_cache.tick;
+    node->is_busy = false;
+}
+#endif
+
+static uint_fast32_t __vk_fatfs_fat_patch_entry(vk_fatfs_fat_patch_t *patch, uint_fast32_t cluster)
+{
+    if (!patch->next) {
+        return 0;
+    }
+    return (cluster - patch->cluster + 1 < patch->num) ? cluster + 1 : patch->next;
+}
+
+// get pending FAT entry of cluster, the latest update takes effect
+static bool __vk_fatfs_fat_patch_get(__vk_fatfs_info_t *fsinfo, uint_fast32_t cluster, uint32_t *entry)
+{
+    vk_fatfs_fat_patch_t *patch;
+
+    for (int_fast8_t i = fsinfo->patch_num - 1; i >= 0; i--) {
+        patch = &fsinfo->patches[i];
+        if ((cluster >= patch->cluster) && (cluster - patch->cluster < patch->num)) {
+            *entry = __vk_fatfs_fat_patch_entry(patch, cluster);
+            return true;
+        }
+    }
+    return false;
+}
+
+// add pending FAT update, false if no room and pending updates should be flushed first
+static bool __vk_fatfs_fat_patch_add(__vk_fatfs_info_t *fsinfo, uint_fast32_t cluster,
+            uint_fast32_t num, uint_fast32_t next)
+{
+    vk_fatfs_fat_patch_t *patch;
+
+    // only the latest update can be merged, earlier updates maybe overridden
+    if (fsinfo->patch_num > 0) {
+        patch = &fsinfo->patches[fsinfo->patch_num - 1];
+        if (patch->next && next) {
+            if ((1 == num) && (patch->cluster + patch->num - 1 == cluster)) {
+                // link the last cluster of the run
+                patch->next = next;
+                return true;
+            } else if ((patch->cluster + patch->num == cluster) && (patch->next == cluster)) {
+                // contiguous clusters appended to the run
+                patch->num += num;
+                patch->next = next;
+                return true;
+            }
+        } else if (!patch->next && !next && (patch->cluster + patch->num == cluster)) {
+            patch->num += num;
+            return true;
+        }
+    }
+
+    if (fsinfo->patch_num >= VSF_FATFS_CFG_FAT_PATCH_NUM) {
+        return false;
+    }
+    patch = &fsinfo->patches[fsinfo->patch_num++];
+    patch->cluster = cluster;
+    patch->num = num;
+    patch->next = next;
+    return true;
+}
+
+// get the first FAT sector(relative to FAT) to update from sector, 0xFFFFFFFF if none
+static uint_fast32_t __vk_fatfs_fat_patch_next_sector(__vk_fatfs_info_t *fsinfo, uint_fast32_t sector)
+{
+    uint_fast8_t fat_bit = __vk_fatfs_fat_bitsize[fsinfo->type];
+    uint_fast8_t sector_bits = fsinfo->sector_size_bits + 3;
+    uint_fast32_t result = 0xFFFFFFFF, first, last;
+    vk_fatfs_fat_patch_t *patch = fsinfo->patches;
+
+    for (uint_fast8_t i = 0; i < fsinfo->patch_num; i++, patch++) {
+        first = ((uint64_t)patch->cluster * fat_bit) >> sector_bits;
+        last = ((uint64_t)(patch->cluster + patch->num) * fat_bit - 1) >> sector_bits;
+        if (last >= sector) {
+            result = min(result, max(first, sector));
+        }
+    }
+    return result;
+}
+
+// set bits of FAT entry in buff of FAT sector(relative to FAT), 12-bit entry maybe across sectors
+static void __vk_fatfs_set_fat_entry(__vk_fatfs_info_t *fsinfo, uint8_t *buff, uint_fast32_t sector,
+            uint_fast32_t cluster, uint_fast32_t entry)
+{
+    uint_fast8_t fat_bit = __vk_fatfs_fat_bitsize[fsinfo->type];
+    int_fast32_t sector_size = 1 << fsinfo->sector_size_bits;
+    int_fast32_t pos = (int_fast32_t)((((uint64_t)cluster * fat_bit) >> 3) - ((uint64_t)sector << fsinfo->sector_size_bits));
+
+    switch (fsinfo->type) {
+    case VSF_FAT_12: {
+            uint_fast16_t value = (cluster & 1) ? entry << 4 : entry;
+            uint_fast16_t mask = (cluster & 1) ? 0xFFF0 : 0x0FFF;
+
+            for (uint_fast8_t i = 0; i < 2; i++, pos++, value >>= 8, mask >>= 8) {
+                if ((pos >= 0) && (pos < sector_size)) {
+                    buff[pos] = (buff[pos] & ~mask) | (value & mask);
+                }
+            }
+        }
+        break;
+    case VSF_FAT_16:
+        put_unaligned_le16(entry, &buff[pos]);
+        break;
+    case VSF_FAT_32:
+        // MSB 4-bit is reserved
+        entry = (get_unaligned_le32(&buff[pos]) & 0xF0000000) | (entry & 0x0FFFFFFF);
+        put_unaligned_le32(entry, &buff[pos]);
+        break;
+    default:
+        VSF_FS_ASSERT(false);
+        break;
+    }
+}
+
+// apply pending FAT updates in order to buff of FAT sector(relative to FAT)
+static void __vk_fatfs_fat_patch_apply(__vk_fatfs_info_t *fsinfo, uint_fast32_t sector, uint8_t *buff)
+{
+    uint_fast8_t fat_bit = __vk_fatfs_fat_bitsize[fsinfo->type];
+    uint_fast8_t sector_bits = fsinfo->sector_size_bits + 3;
+    // clusters with any bit in the sector
+    uint_fast32_t start = ((uint64_t)sector << sector_bits) / fat_bit;
+    uint_fast32_t end = (((uint64_t)(sector + 1) << sector_bits) + fat_bit - 1) / fat_bit;
+    uint_fast32_t cluster, cluster_end;
+    vk_fatfs_fat_patch_t *patch = fsinfo->patches;
+
+    for (uint_fast8_t i = 0; i < fsinfo->patch_num; i++, patch++) {
+        cluster = max(start, patch->cluster);
+        cluster_end = min(end, patch->cluster + patch->num);
+        for (; cluster < cluster_end; cluster++) {
+            __vk_fatfs_set_fat_entry(fsinfo, buff, sector, cluster,
+                        __vk_fatfs_fat_patch_entry(patch, cluster));
+        }
+    }
+}
+
+// get FAT entry without IO, from pending updates or cached FAT sectors
+static bool __vk_fatfs_get_fat_entry_cached(__vk_fatfs_info_t *fsinfo, uint_fast32_t cluster, uint32_t *entry)
+{
+    if (__vk_fatfs_fat_patch_get(fsinfo, cluster, entry)) {
+        return true;
+    }
+
+#if VSF_FATFS_CFG_FAT_CACHE_NUM > 0
+    uint_fast8_t fat_bit = __vk_fatfs_fat_bitsize[fsinfo->type];
+    uint_fast32_t sector_bit = 1 << (fsinfo->sector_size_bits + 3);
+    uint_fast64_t start_bit = (uint64_t)cluster * fat_bit;
+    uint_fast32_t start_bit_sec = start_bit & (sector_bit - 1);
+    uint8_t *buff;
+
+    if (start_bit_sec + fat_bit <= sector_bit) {
+        buff = __vk_fatfs_fat_cache_get(fsinfo, fsinfo->fat_sector + (start_bit >> (fsinfo->sector_size_bits + 3)));
+        if (buff != NULL) {
+            *entry = get_unaligned_le32(&buff[start_bit_sec >> 3]);
+            *entry = (*entry >> (start_bit & 7)) & (0xFFFFFFFF >> (32 - fat_bit));
+            return true;
+        }
+    }
+#endif
+    return false;
+}
+
+static void __vk_fatfs_init_cache(__vk_fatfs_info_t *fsinfo)
+{
+    fsinfo->free_cluster = 2;
+    fsinfo->patch_num = 0;
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+    vsf_eda_mutex_init(&fsinfo->fat_mutex);
+    vsf_eda_mutex_init(&fsinfo->dir_mutex);
+#endif
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+    memset(&fsinfo->root.extent, 0, sizeof(fsinfo->root.extent));
+#endif
+#if VSF_FATFS_CFG_FAT_CACHE_NUM > 0
+    memset(&fsinfo->fat_cache, 0, sizeof(fsinfo->fat_cache));
+#endif
+}
+
+static void __vk_fatfs_fini_cache(__vk_fatfs_info_t *fsinfo)
+{
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+    __vk_fatfs_extent_fini(&fsinfo->root);
+#endif
+#if VSF_FATFS_CFG_FAT_CACHE_NUM > 0
+    if (fsinfo->fat_cache.buffer != NULL) {
+        vsf_heap_free(fsinfo->fat_cache.buffer);
+        fsinfo->fat_cache.buffer = NULL;
+    }
+    fsinfo->fat_cache.number = 0;
+#endif
+}
+
 #if     __IS_COMPILER_GCC__
 #   pragma GCC diagnostic push
 #   pragma GCC diagnostic ignored "-Wcast-align"
@@ -413,17 +1038,19 @@ bool vk_fatfs_parse_dentry_fat(vk_fatfs_dentry_parser_t *parser)
             int i;
 
             if (entry->fat.Attr == FAT_ATTR_LFN) {
-                const uint8_t lfn_offsets[] = {1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30};
                 uint_fast8_t index = entry->fat.Name[0];
                 uint_fast8_t pos = ((index & 0x0F) - 1) * 13;
                 uint_fast16_t uchar;
                 uint8_t *buf = (uint8_t *)entry;
 
                 parser->lfn = index & 0x0F;
+                if ((index & 0xF0) == 0x40) {
+                    parser->lfn_num = parser->lfn;
+                }
                 ptr = parser->filename + (pos << 1);
 
-                for (uint_fast8_t i = 0; i < dimof(lfn_offsets); i++) {
-                    uchar = buf[lfn_offsets[i]] + (buf[lfn_offsets[i] + 1] << 8);
+                for (uint_fast8_t i = 0; i < dimof(__vk_fatfs_lfn_offsets); i++) {
+                    uchar = get_unaligned_le16(&buf[__vk_fatfs_lfn_offsets[i]]);
                     if (0 == uchar) {
                         break;
                     } else {
@@ -454,6 +1081,7 @@ bool vk_fatfs_parse_dentry_fat(vk_fatfs_dentry_parser_t *parser)
                         while (*uchar != 0) {
                             *ptr++ = *uchar++;
                         }
+                        *ptr = '\0';
                     }
 
                     parser->lfn = 0;
@@ -462,6 +1090,7 @@ bool vk_fatfs_parse_dentry_fat(vk_fatfs_dentry_parser_t *parser)
                 }
 
                 parser->lfn = 0;
+                parser->lfn_num = 0;
                 ptr = parser->filename;
                 lower = (entry->fat.LCase & 0x08) > 0;
                 for (i = 0; (i < 8) && (entry->fat.Name[i] != ' '); i++) {
@@ -494,18 +1123,6 @@ bool vk_fatfs_parse_dentry_fat(vk_fatfs_dentry_parser_t *parser)
     return parsed;
 }
 
-__vsf_component_peda_ifs_entry(__vk_fatfs_unmount, vk_fs_unmount)
-{
-    vsf_peda_begin();
-    vk_vfs_file_t *dir = (vk_vfs_file_t *)&vsf_this;
-    __vk_fatfs_info_t *fsinfo = dir->subfs.data;
-    __vk_malfs_info_t *malfs_info = &fsinfo->use_as____vk_malfs_info_t;
-
-    __vk_malfs_unmount(malfs_info);
-    vsf_eda_return();
-    vsf_peda_end();
-}
-
 #if __IS_COMPILER_IAR__
 //! statement is unreachable
 #   pragma diag_suppress=pe111
@@ -526,12 +1143,14 @@ __vsf_component_peda_ifs_entry(__vk_fatfs_mount, vk_fs_mount)
     switch (evt) {
     case VSF_EVT_INIT:
         __vk_malfs_init(malfs_info);
+        __vk_fatfs_init_cache(fsinfo);
         vsf_eda_frame_user_value_set(MOUNT_STATE_PARSE_DBR);
         __vk_malfs_read(malfs_info, 0, 1, NULL);
         break;
     case VSF_EVT_RETURN: {
             __vsf_frame_uint_t state;
             uint8_t *buff = (uint8_t *)vsf_eda_get_return_value();
+            vsf_err_t err;
 
             if (NULL == buff) {
                 VSF_FS_ASSERT(false);
@@ -542,12 +1161,24 @@ __vsf_component_peda_ifs_entry(__vk_fatfs_mount, vk_fs_mount)
             vsf_eda_frame_user_value_get(&state);
             switch (state) {
             case MOUNT_STATE_PARSE_DBR:
-                if (VSF_ERR_NONE != __vk_fatfs_parse_dbr(fsinfo, buff)) {
+                err = __vk_fatfs_parse_dbr(fsinfo, buff);
+                __vk_malfs_release(malfs_info, buff);
+                if (err != VSF_ERR_NONE) {
                 return_fail:
                     VSF_FS_ASSERT(false);
+                    __vk_fatfs_fini_cache(fsinfo);
                     vsf_eda_return(VSF_ERR_FAIL);
                     return;
                 }
+#if VSF_FATFS_CFG_FAT_CACHE_NUM > 0
+                // 4 more bytes for FAT entry parser which reads in 32-bit
+                fsinfo->fat_cache.buffer = vsf_heap_malloc(
+                    (VSF_FATFS_CFG_FAT_CACHE_NUM << fsinfo->sector_size_bits) + sizeof(uint32_t));
+                // run without FAT cache if no buffer available
+                if (fsinfo->fat_cache.buffer != NULL) {
+                    fsinfo->fat_cache.number = VSF_FATFS_CFG_FAT_CACHE_NUM;
+                }
+#endif
                 vsf_eda_frame_user_value_set(MOUNT_STATE_PARSE_ROOT);
                 __vk_malfs_read(malfs_info, fsinfo->root_sector, 1, NULL);
                 break;
@@ -556,6 +1187,7 @@ __vsf_component_peda_ifs_entry(__vk_fatfs_mount, vk_fs_mount)
                     malfs_info->volume_name = NULL;
                     if (VSF_FAT_EX == fsinfo->type) {
                         // TODO: parse VolID for exfat
+                        __vk_malfs_release(malfs_info, buff);
                         goto return_fail;
                     } else if (FAT_ATTR_VOLUME_ID == dentry->fat.Attr) {
                         fsinfo->fat_volume_name[11] = '\0';
@@ -568,6 +1200,7 @@ __vsf_component_peda_ifs_entry(__vk_fatfs_mount, vk_fs_mount)
                         }
                         malfs_info->volume_name = fsinfo->fat_volume_name;
                     }
+                    __vk_malfs_release(malfs_info, buff);
                     fsinfo->root.info = fsinfo;
                     dir->subfs.root = &fsinfo->root.use_as__vk_file_t;
                     vsf_eda_return(VSF_ERR_NONE);
@@ -585,6 +1218,7 @@ __vsf_component_peda_private_entry(__vk_fatfs_get_fat_entry,,
     uint32_t *entry;
     ,
     uint32_t cur_fat_bit;
+    void *cache_node;
 ) {
     vsf_peda_begin();
     enum {
@@ -597,9 +1231,16 @@ __vsf_component_peda_private_entry(__vk_fatfs_get_fat_entry,,
     uint_fast32_t start_bit = vsf_local.cluster * fat_bit;
     uint_fast32_t sector_bit = 1 << (fsinfo->sector_size_bits + 3);
     uint_fast32_t start_bit_sec = start_bit & (sector_bit - 1);
+    uint_fast32_t sector = fsinfo->fat_sector + (start_bit >> (fsinfo->sector_size_bits + 3));
+    uint8_t *buff = NULL;
+    bool is_pinned = false;
 
     switch (evt) {
     case VSF_EVT_INIT:
+        if (__vk_fatfs_get_fat_entry_cached(fsinfo, vsf_local.cluster, vsf_local.entry)) {
+            vsf_eda_return(VSF_ERR_NONE);
+            break;
+        }
         vsf_local.cur_fat_bit = 0;
         vsf_eda_frame_user_value_set(LOOKUP_FAT_STATE_START);
         // fall through
@@ -610,194 +1251,1639 @@ __vsf_component_peda_private_entry(__vk_fatfs_get_fat_entry,,
             case LOOKUP_FAT_STATE_START:
             read_fat_sector:
                 if (vsf_local.cur_fat_bit < fat_bit) {
-                    start_bit = fsinfo->fat_sector + (start_bit >> (fsinfo->sector_size_bits + 3));
-                    start_bit += vsf_local.cur_fat_bit ? 1 : 0;
+                    sector += vsf_local.cur_fat_bit ? 1 : 0;
 
+#if VSF_FATFS_CFG_FAT_CACHE_NUM > 0
+                    buff = __vk_fatfs_fat_cache_get(fsinfo, sector);
+                    if (buff != NULL) {
+                        goto parse_fat_sector;
+                    }
+                    // read into sector buffer of malfs if all cache nodes are busy
+                    vsf_local.cache_node = __vk_fatfs_fat_cache_alloc(fsinfo, sector);
+                    if (vsf_local.cache_node != NULL) {
+                        buff = __vk_fatfs_fat_cache_buff(fsinfo, vsf_local.cache_node);
+                    }
+#endif
                     vsf_eda_frame_user_value_set(LOOKUP_FAT_STATE_PARSE);
-                    __vk_malfs_read(malfs_info, start_bit, 1, NULL);
+                    __vk_malfs_read(malfs_info, sector, 1, buff);
+                    break;
                 }
+                vsf_eda_return(VSF_ERR_NONE);
                 break;
-            case LOOKUP_FAT_STATE_PARSE: {
-                    uint8_t *buff = (uint8_t *)vsf_eda_get_return_value();
-                    if (NULL == buff) {
-                        VSF_FS_ASSERT(false);
-                        vsf_eda_return(VSF_ERR_FAIL);
-                        break;
+            case LOOKUP_FAT_STATE_PARSE:
+                buff = (uint8_t *)vsf_eda_get_return_value();
+                // sector buffer of malfs is pinned until parsed
+                is_pinned = buff != NULL;
+#if VSF_FATFS_CFG_FAT_CACHE_NUM > 0
+                if (vsf_local.cache_node != NULL) {
+                    vk_fatfs_fat_cache_node_t *node = vsf_local.cache_node;
+                    bool is_stale = node->sector != sector + (vsf_local.cur_fat_bit ? 1 : 0);
+
+                    is_pinned = false;
+                    __vk_fatfs_fat_cache_commit(fsinfo, node, ((buff != NULL) && !is_stale) ? node->sector : 0);
+                    vsf_local.cache_node = NULL;
+                    if ((buff != NULL) && is_stale) {
+                        // sector is flushed while being read, read again
+                        goto read_fat_sector;
                     }
+                }
+#endif
+                if (NULL == buff) {
+                    VSF_FS_ASSERT(false);
+                    vsf_eda_return(VSF_ERR_FAIL);
+                    break;
+                }
 
-                    if (vsf_local.cur_fat_bit) {
-                        *vsf_local.entry |= get_unaligned_le32(buff) << vsf_local.cur_fat_bit;
-                        *vsf_local.entry &= (1 << fat_bit) - 1;
-                        vsf_eda_return(VSF_ERR_NONE);
-                        break;
+#if VSF_FATFS_CFG_FAT_CACHE_NUM > 0
+            parse_fat_sector:
+#endif
+                if (vsf_local.cur_fat_bit) {
+                    *vsf_local.entry |= get_unaligned_le32(buff) << vsf_local.cur_fat_bit;
+                    *vsf_local.entry &= 0xFFFFFFFF >> (32 - fat_bit);
+                    if (is_pinned) {
+                        __vk_malfs_release(malfs_info, buff);
                     }
+                    vsf_eda_return(VSF_ERR_NONE);
+                    break;
+                }
+
+                vsf_local.cur_fat_bit += min(fat_bit, sector_bit - start_bit_sec);
+                *vsf_local.entry = get_unaligned_le32(&buff[start_bit_sec >> 3]);
+                *vsf_local.entry = (*vsf_local.entry >> (start_bit & 7)) & (0xFFFFFFFF >> (32 - vsf_local.cur_fat_bit));
+                if (is_pinned) {
+                    __vk_malfs_release(malfs_info, buff);
+                }
+                goto read_fat_sector;
+            }
+        }
+    }
+    vsf_peda_end();
+}
+
+// write pending FAT updates to all FATs, each FAT sector is read and written once
+//  caller should hold fat_mutex
+__vsf_component_peda_private_entry(__vk_fatfs_flush_fat,,,
+    uint32_t sector;
+    uint8_t *buffer;
+    void *cache_node;
+    uint8_t fat_idx;
+) {
+    vsf_peda_begin();
+    enum {
+        FLUSH_FAT_STATE_READ,
+        FLUSH_FAT_STATE_WRITE,
+        FLUSH_FAT_STATE_READ_FSINFO,
+        FLUSH_FAT_STATE_WRITE_FSINFO,
+    };
+    __vk_fatfs_info_t *fsinfo = (__vk_fatfs_info_t *)&vsf_this;
+    __vk_malfs_info_t *malfs_info = &fsinfo->use_as____vk_malfs_info_t;
+    union {
+        uintptr_t value;
+        int_fast32_t size;
+        uint8_t *buffer;
+    } result;
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+        vsf_local.cache_node = NULL;
+        vsf_local.sector = __vk_fatfs_fat_patch_next_sector(fsinfo, 0);
+        goto flush_sector;
+    case VSF_EVT_RETURN: {
+            __vsf_frame_uint_t state;
+
+            result.value = vsf_eda_get_return_value();
+            vsf_eda_frame_user_value_get(&state);
+            switch (state) {
+            case FLUSH_FAT_STATE_READ:
+                if (NULL == result.buffer) {
+                    goto return_fail;
+                }
+                vsf_local.buffer = result.buffer;
+#if VSF_FATFS_CFG_FAT_CACHE_NUM > 0
+            update_sector:
+#endif
+                __vk_fatfs_fat_patch_apply(fsinfo, vsf_local.sector, vsf_local.buffer);
+                // the first FAT is written last, which unpins the sector buffer of malfs
+                vsf_local.fat_idx = fsinfo->fat_num;
+                goto write_sector;
+            case FLUSH_FAT_STATE_WRITE:
+                if (result.size < 0) {
+                    // sector buffer of malfs is still pinned if the first FAT is not written
+                    if ((vsf_local.fat_idx > 0) && (NULL == vsf_local.cache_node)) {
+                        __vk_malfs_release(malfs_info, vsf_local.buffer);
+                    }
+                    goto return_fail;
+                }
+            write_sector:
+                if (vsf_local.fat_idx > 0) {
+                    vsf_eda_frame_user_value_set(FLUSH_FAT_STATE_WRITE);
+                    __vk_malfs_write(malfs_info, fsinfo->fat_sector + --vsf_local.fat_idx * fsinfo->fat_size
+                                + vsf_local.sector, 1, vsf_local.buffer);
+                    break;
+                }
+#if VSF_FATFS_CFG_FAT_CACHE_NUM > 0
+                // copies read by others before the sector is written are out of date
+                __vk_fatfs_fat_cache_invalidate(fsinfo, vsf_local.cache_node, fsinfo->fat_sector + vsf_local.sector);
+                if (vsf_local.cache_node != NULL) {
+                    __vk_fatfs_fat_cache_commit(fsinfo, vsf_local.cache_node, fsinfo->fat_sector + vsf_local.sector);
+                    vsf_local.cache_node = NULL;
+                }
+#endif
+                vsf_local.sector = __vk_fatfs_fat_patch_next_sector(fsinfo, vsf_local.sector + 1);
+            flush_sector:
+                if (vsf_local.sector != 0xFFFFFFFF) {
+                    uint_fast32_t sector = fsinfo->fat_sector + vsf_local.sector;
+
+                    vsf_local.buffer = NULL;
+#if VSF_FATFS_CFG_FAT_CACHE_NUM > 0
+                    // cache node is busy until the sector is written to all FATs
+                    vsf_local.cache_node = __vk_fatfs_fat_cache_find(fsinfo, sector);
+                    if (vsf_local.cache_node != NULL) {
+                        ((vk_fatfs_fat_cache_node_t *)vsf_local.cache_node)->is_busy = true;
+                        vsf_local.buffer = __vk_fatfs_fat_cache_buff(fsinfo, vsf_local.cache_node);
+                        goto update_sector;
+                    }
+                    vsf_local.cache_node = __vk_fatfs_fat_cache_alloc(fsinfo, sector);
+                    if (vsf_local.cache_node != NULL) {
+                        vsf_local.buffer = __vk_fatfs_fat_cache_buff(fsinfo, vsf_local.cache_node);
+                    }
+#endif
+                    vsf_eda_frame_user_value_set(FLUSH_FAT_STATE_READ);
+                    __vk_malfs_read(malfs_info, sector, 1, vsf_local.buffer);
+                    break;
+                }
+
+                fsinfo->patch_num = 0;
+                if (fsinfo->fsinfo_sector) {
+                    // free cluster count and hint in FSInfo are not maintained, invalidate them
+                    vsf_eda_frame_user_value_set(FLUSH_FAT_STATE_READ_FSINFO);
+                    __vk_malfs_read(malfs_info, fsinfo->fsinfo_sector, 1, NULL);
+                    break;
+                }
+                vsf_eda_return(VSF_ERR_NONE);
+                break;
+            case FLUSH_FAT_STATE_READ_FSINFO:
+                if (NULL == result.buffer) {
+                    goto return_fail;
+                }
+                if (    (get_unaligned_le32(&result.buffer[0]) != 0x41615252)
+                    ||  (get_unaligned_le32(&result.buffer[484]) != 0x61417272)) {
+                    __vk_malfs_release(malfs_info, result.buffer);
+                    fsinfo->fsinfo_sector = 0;
+                    vsf_eda_return(VSF_ERR_NONE);
+                    break;
+                }
+                put_unaligned_le32(0xFFFFFFFF, &result.buffer[488]);
+                put_unaligned_le32(0xFFFFFFFF, &result.buffer[492]);
+                vsf_eda_frame_user_value_set(FLUSH_FAT_STATE_WRITE_FSINFO);
+                __vk_malfs_write(malfs_info, fsinfo->fsinfo_sector, 1, result.buffer);
+                break;
+            case FLUSH_FAT_STATE_WRITE_FSINFO:
+                if (result.size < 0) {
+                    goto return_fail;
+                }
+                fsinfo->fsinfo_sector = 0;
+                vsf_eda_return(VSF_ERR_NONE);
+                break;
+            }
+        }
+        break;
+    }
+    return;
+return_fail:
+#if VSF_FATFS_CFG_FAT_CACHE_NUM > 0
+    if (vsf_local.cache_node != NULL) {
+        // pending updates are kept, re-read the sector next time
+        __vk_fatfs_fat_cache_commit(fsinfo, vsf_local.cache_node, 0);
+        vsf_local.cache_node = NULL;
+    }
+#endif
+    vsf_eda_return(VSF_ERR_FAIL);
+    vsf_peda_end();
+}
+
+static void __vk_fatfs_fat_unlock(__vk_fatfs_info_t *fsinfo)
+{
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+    vsf_eda_mutex_leave(&fsinfo->fat_mutex);
+#endif
+}
+
+static void __vk_fatfs_dir_unlock(__vk_fatfs_info_t *fsinfo)
+{
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+    vsf_eda_mutex_leave(&fsinfo->dir_mutex);
+#endif
+}
 
-                    vsf_local.cur_fat_bit += min(fat_bit, sector_bit - start_bit_sec);
-                    *vsf_local.entry = get_unaligned_le32(&buff[start_bit_sec >> 3]);
-                    *vsf_local.entry = (*vsf_local.entry >> (start_bit & 7)) & ((1 << vsf_local.cur_fat_bit) - 1);
-                    goto read_fat_sector;
+// flush pending FAT updates for callers not holding fat_mutex
+__vsf_component_peda_private_entry(__vk_fatfs_commit_fat)
+{
+    vsf_peda_begin();
+    __vk_fatfs_info_t *fsinfo = (__vk_fatfs_info_t *)&vsf_this;
+    vsf_err_t err;
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+        if (VSF_ERR_NONE != vsf_eda_mutex_enter(&fsinfo->fat_mutex)) {
+            break;
+        }
+        // fall through
+    case VSF_EVT_SYNC:
+#endif
+        __vsf_component_call_peda(__vk_fatfs_flush_fat, err, fsinfo);
+        UNUSED_PARAM(err);
+        break;
+    case VSF_EVT_RETURN:
+        err = (vsf_err_t)vsf_eda_get_return_value();
+        __vk_fatfs_fat_unlock(fsinfo);
+        vsf_eda_return(err);
+        break;
+    }
+    vsf_peda_end();
+}
+
+// find a run of at most num free clusters, starting from the free cluster hint
+//  caller should hold fat_mutex until the run is claimed by __vk_fatfs_fat_patch_add
+__vsf_component_peda_private_entry(__vk_fatfs_alloc_clusters,,
+    uint32_t num;
+    uint32_t *cluster;
+    uint32_t *run;
+    ,
+    uint32_t cur_cluster;
+    uint32_t scanned;
+    uint32_t entry;
+) {
+    vsf_peda_begin();
+    __vk_fatfs_info_t *fsinfo = (__vk_fatfs_info_t *)&vsf_this;
+    vsf_err_t err;
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+        vsf_local.cur_cluster = fsinfo->free_cluster;
+        vsf_local.scanned = 0;
+        *vsf_local.run = 0;
+        break;
+    case VSF_EVT_RETURN:
+        if ((vsf_err_t)vsf_eda_get_return_value() != VSF_ERR_NONE) {
+            vsf_eda_return(VSF_ERR_FAIL);
+            return;
+        }
+        goto check_entry;
+    }
+
+    while (true) {
+        if (*vsf_local.run > 0) {
+            // run is not allowed to wrap around
+            if ((*vsf_local.run >= vsf_local.num) || (vsf_local.cur_cluster >= fsinfo->cluster_num)) {
+                break;
+            }
+        } else {
+            if (vsf_local.scanned >= fsinfo->cluster_num - 2) {
+                vsf_eda_return(VSF_ERR_NOT_ENOUGH_RESOURCES);
+                return;
+            }
+            if ((vsf_local.cur_cluster < 2) || (vsf_local.cur_cluster >= fsinfo->cluster_num)) {
+                vsf_local.cur_cluster = 2;
+            }
+        }
+
+        if (!__vk_fatfs_get_fat_entry_cached(fsinfo, vsf_local.cur_cluster, &vsf_local.entry)) {
+            __vsf_component_call_peda(__vk_fatfs_get_fat_entry, err, fsinfo,
+                .cluster = vsf_local.cur_cluster,
+                .entry = &vsf_local.entry,
+            );
+            UNUSED_PARAM(err);
+            return;
+        }
+
+    check_entry:
+        if (!(vsf_local.entry & 0x0FFFFFFF)) {
+            if (!*vsf_local.run) {
+                *vsf_local.cluster = vsf_local.cur_cluster;
+            }
+            (*vsf_local.run)++;
+        } else if (*vsf_local.run > 0) {
+            break;
+        }
+        vsf_local.cur_cluster++;
+        vsf_local.scanned++;
+    }
+
+    fsinfo->free_cluster = vsf_local.cur_cluster;
+    vsf_eda_return(VSF_ERR_NONE);
+    vsf_peda_end();
+}
+
+// get cluster of file_cluster in file, walk cluster chain from nearest cached cluster
+//  VSF_ERR_NOT_AVAILABLE if cluster chain is shorter, and cluster chain will be resolved
+__vsf_component_peda_private_entry(__vk_fatfs_get_cluster,,
+    uint32_t file_cluster;
+    uint32_t *cluster;
+    ,
+    uint32_t cur_file_cluster;
+    uint32_t next;
+) {
+    vsf_peda_begin();
+    vk_fatfs_file_t *file = (vk_fatfs_file_t *)&vsf_this;
+    __vk_fatfs_info_t *fsinfo = (__vk_fatfs_info_t *)file->info;
+    vsf_err_t err;
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+        if (!file->first_cluster) {
+            file->chain.num = 0;
+            file->chain.tail = 0;
+            vsf_eda_return(VSF_ERR_NOT_AVAILABLE);
+            break;
+        }
+        if (file->chain.tail) {
+            if (vsf_local.file_cluster >= file->chain.num) {
+                vsf_eda_return(VSF_ERR_NOT_AVAILABLE);
+                break;
+            } else if (vsf_local.file_cluster == file->chain.num - 1) {
+                *vsf_local.cluster = file->chain.tail;
+                vsf_eda_return(VSF_ERR_NONE);
+                break;
+            }
+        }
+
+        *vsf_local.cluster = file->first_cluster & 0x0FFFFFFF;
+        vsf_local.cur_file_cluster = 0;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+        __vk_fatfs_extent_init(fsinfo, file);
+        if (file->extent.cluster_num > 0) {
+            vsf_local.cur_file_cluster = min(vsf_local.file_cluster, file->extent.cluster_num - 1);
+            if (    file->extent.last_cluster
+                &&  (file->extent.last_file_cluster > vsf_local.cur_file_cluster)
+                &&  (file->extent.last_file_cluster <= vsf_local.file_cluster)) {
+                vsf_local.cur_file_cluster = file->extent.last_file_cluster;
+                *vsf_local.cluster = file->extent.last_cluster;
+            } else {
+                *vsf_local.cluster = __vk_fatfs_extent_get(file, vsf_local.cur_file_cluster, NULL);
+            }
+        }
+#endif
+        goto walk_chain;
+    case VSF_EVT_RETURN:
+        if ((vsf_err_t)vsf_eda_get_return_value() != VSF_ERR_NONE) {
+            vsf_eda_return(VSF_ERR_FAIL);
+            break;
+        }
+    next_cluster:
+        if (__vk_fatfs_fat_entry_is_eof(fsinfo, vsf_local.next)) {
+            file->chain.num = vsf_local.cur_file_cluster + 1;
+            file->chain.tail = *vsf_local.cluster;
+            vsf_eda_return(VSF_ERR_NOT_AVAILABLE);
+            break;
+        }
+        if (!__vk_fatfs_cluster_is_valid(fsinfo, vsf_local.next)) {
+            vsf_eda_return(VSF_ERR_FAIL);
+            break;
+        }
+
+        // remove MSB 4-bit for 32-bit FAT entry
+        *vsf_local.cluster = vsf_local.next & 0x0FFFFFFF;
+        vsf_local.cur_file_cluster++;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+        __vk_fatfs_extent_add(file, vsf_local.cur_file_cluster, *vsf_local.cluster);
+#endif
+    walk_chain:
+        if (vsf_local.cur_file_cluster < vsf_local.file_cluster) {
+            if (__vk_fatfs_get_fat_entry_cached(fsinfo, *vsf_local.cluster, &vsf_local.next)) {
+                goto next_cluster;
+            }
+            __vsf_component_call_peda(__vk_fatfs_get_fat_entry, err, fsinfo,
+                .cluster = *vsf_local.cluster,
+                .entry = &vsf_local.next,
+            );
+            UNUSED_PARAM(err);
+            break;
+        }
+
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+        if (vsf_local.file_cluster >= file->extent.cluster_num) {
+            file->extent.last_file_cluster = vsf_local.file_cluster;
+            file->extent.last_cluster = *vsf_local.cluster;
+        }
+#endif
+        vsf_eda_return(VSF_ERR_NONE);
+        break;
+    }
+    vsf_peda_end();
+}
+
+// extend cluster chain of file to cluster_num clusters, allocate in runs of contiguous clusters
+__vsf_component_peda_private_entry(__vk_fatfs_extend_chain,,
+    uint32_t cluster_num;
+    ,
+    uint32_t cluster;
+    uint32_t run;
+) {
+    vsf_peda_begin();
+    enum {
+        EXTEND_STATE_RESOLVE_CHAIN,
+        EXTEND_STATE_ALLOC,
+        EXTEND_STATE_FLUSH_FAT,
+    };
+    vk_fatfs_file_t *file = (vk_fatfs_file_t *)&vsf_this;
+    __vk_fatfs_info_t *fsinfo = (__vk_fatfs_info_t *)file->info;
+    vsf_err_t err;
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+        if (!file->first_cluster) {
+            file->chain.num = 0;
+            file->chain.tail = 0;
+        } else if (!file->chain.tail) {
+            vsf_eda_frame_user_value_set(EXTEND_STATE_RESOLVE_CHAIN);
+            __vsf_component_call_peda(__vk_fatfs_get_cluster, err, file,
+                .file_cluster = 0xFFFFFFFF,
+                .cluster = &vsf_local.cluster,
+            );
+            break;
+        }
+        goto alloc_run;
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+    case VSF_EVT_SYNC:
+        goto alloc_locked;
+#endif
+    case VSF_EVT_RETURN: {
+            __vsf_frame_uint_t state;
+
+            err = (vsf_err_t)vsf_eda_get_return_value();
+            vsf_eda_frame_user_value_get(&state);
+            switch (state) {
+            case EXTEND_STATE_RESOLVE_CHAIN:
+                if (err != VSF_ERR_NOT_AVAILABLE) {
+                    vsf_eda_return(VSF_ERR_FAIL);
+                    break;
+                }
+            alloc_run:
+                if (file->chain.num >= vsf_local.cluster_num) {
+                    vsf_eda_return(VSF_ERR_NONE);
+                    break;
+                }
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+                if (VSF_ERR_NONE != vsf_eda_mutex_enter(&fsinfo->fat_mutex)) {
+                    break;
+                }
+            alloc_locked:
+#endif
+                vsf_eda_frame_user_value_set(EXTEND_STATE_ALLOC);
+                __vsf_component_call_peda(__vk_fatfs_alloc_clusters, err, fsinfo,
+                    .num = vsf_local.cluster_num - file->chain.num,
+                    .cluster = &vsf_local.cluster,
+                    .run = &vsf_local.run,
+                );
+                break;
+            case EXTEND_STATE_ALLOC:
+            case EXTEND_STATE_FLUSH_FAT:
+                if (err != VSF_ERR_NONE) {
+                    __vk_fatfs_fat_unlock(fsinfo);
+                    vsf_eda_return(err);
+                    break;
+                }
+                // at most 2 updates to link the run, clusters in run are still free in FAT
+                if (fsinfo->patch_num + 2 > VSF_FATFS_CFG_FAT_PATCH_NUM) {
+                    vsf_eda_frame_user_value_set(EXTEND_STATE_FLUSH_FAT);
+                    __vsf_component_call_peda(__vk_fatfs_flush_fat, err, fsinfo);
+                    break;
+                }
+
+                if (file->chain.tail) {
+                    __vk_fatfs_fat_patch_add(fsinfo, file->chain.tail, 1, vsf_local.cluster);
+                } else {
+                    file->first_cluster = vsf_local.cluster;
+                    file->is_dirty = true;
+                }
+                __vk_fatfs_fat_patch_add(fsinfo, vsf_local.cluster, vsf_local.run, __vk_fatfs_fat_entry_eof(fsinfo));
+                __vk_fatfs_fat_unlock(fsinfo);
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                for (uint_fast32_t i = 0; i < vsf_local.run; i++) {
+                    __vk_fatfs_extent_add(file, file->chain.num + i, vsf_local.cluster + i);
+                }
+#endif
+                file->chain.num += vsf_local.run;
+                file->chain.tail = vsf_local.cluster + vsf_local.run - 1;
+                goto alloc_run;
+            }
+        }
+        break;
+    }
+    vsf_peda_end();
+}
+
+// free cluster chain from cluster, and terminate the chain at tail first if tail is not 0
+__vsf_component_peda_private_entry(__vk_fatfs_free_chain,,
+    uint32_t cluster;
+    uint32_t tail;
+    ,
+    uint32_t next;
+) {
+    vsf_peda_begin();
+    enum {
+        FREE_STATE_TERMINATE,
+        FREE_STATE_GET_NEXT,
+        FREE_STATE_FLUSH_FAT,
+    };
+    __vk_fatfs_info_t *fsinfo = (__vk_fatfs_info_t *)&vsf_this;
+    vsf_err_t err;
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+        if (VSF_ERR_NONE != vsf_eda_mutex_enter(&fsinfo->fat_mutex)) {
+            break;
+        }
+        // fall through
+    case VSF_EVT_SYNC:
+#endif
+        goto terminate_chain;
+    case VSF_EVT_RETURN: {
+            __vsf_frame_uint_t state;
+
+            err = (vsf_err_t)vsf_eda_get_return_value();
+            if (err != VSF_ERR_NONE) {
+                __vk_fatfs_fat_unlock(fsinfo);
+                vsf_eda_return(err);
+                break;
+            }
+
+            vsf_eda_frame_user_value_get(&state);
+            switch (state) {
+            case FREE_STATE_TERMINATE:
+            terminate_chain:
+                if (vsf_local.tail) {
+                    if (!__vk_fatfs_fat_patch_add(fsinfo, vsf_local.tail, 1, __vk_fatfs_fat_entry_eof(fsinfo))) {
+                        vsf_eda_frame_user_value_set(FREE_STATE_TERMINATE);
+                        __vsf_component_call_peda(__vk_fatfs_flush_fat, err, fsinfo);
+                        break;
+                    }
+                    vsf_local.tail = 0;
+                }
+                goto free_next;
+            case FREE_STATE_GET_NEXT:
+            case FREE_STATE_FLUSH_FAT:
+            free_cluster:
+                if (!__vk_fatfs_fat_patch_add(fsinfo, vsf_local.cluster, 1, 0)) {
+                    vsf_eda_frame_user_value_set(FREE_STATE_FLUSH_FAT);
+                    __vsf_component_call_peda(__vk_fatfs_flush_fat, err, fsinfo);
+                    break;
+                }
+                if (vsf_local.cluster < fsinfo->free_cluster) {
+                    fsinfo->free_cluster = vsf_local.cluster;
+                }
+                vsf_local.cluster = vsf_local.next & 0x0FFFFFFF;
+
+            free_next:
+                // stop at EOF, or at invalid cluster of a broken chain
+                if (!__vk_fatfs_cluster_is_valid(fsinfo, vsf_local.cluster)) {
+                    __vk_fatfs_fat_unlock(fsinfo);
+                    vsf_eda_return(VSF_ERR_NONE);
+                    break;
+                }
+                // get next cluster before the cluster is freed
+                if (__vk_fatfs_get_fat_entry_cached(fsinfo, vsf_local.cluster, &vsf_local.next)) {
+                    goto free_cluster;
+                }
+                vsf_eda_frame_user_value_set(FREE_STATE_GET_NEXT);
+                __vsf_component_call_peda(__vk_fatfs_get_fat_entry, err, fsinfo,
+                    .cluster = vsf_local.cluster,
+                    .entry = &vsf_local.next,
+                );
+                UNUSED_PARAM(err);
+                break;
+            }
+        }
+        break;
+    }
+    vsf_peda_end();
+}
+
+// flush pending FAT updates and update dentry of file
+__vsf_component_peda_private_entry(__vk_fatfs_sync_file)
+{
+    vsf_peda_begin();
+    enum {
+        SYNC_STATE_FLUSH_FAT,
+        SYNC_STATE_READ_DENTRY,
+        SYNC_STATE_WRITE_DENTRY,
+        SYNC_STATE_FLUSH_CACHE,
+    };
+    vk_fatfs_file_t *file = (vk_fatfs_file_t *)&vsf_this;
+    __vk_fatfs_info_t *fsinfo = (__vk_fatfs_info_t *)file->info;
+    __vk_malfs_info_t *malfs_info = &fsinfo->use_as____vk_malfs_info_t;
+    union {
+        uintptr_t value;
+        vsf_err_t err;
+        int_fast32_t size;
+        uint8_t *buffer;
+    } result;
+    vsf_err_t err;
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+        if (fsinfo->patch_num > 0) {
+            vsf_eda_frame_user_value_set(SYNC_STATE_FLUSH_FAT);
+            __vsf_component_call_peda(__vk_fatfs_commit_fat, err, fsinfo);
+            UNUSED_PARAM(err);
+            break;
+        }
+        goto update_dentry;
+    case VSF_EVT_RETURN: {
+            __vsf_frame_uint_t state;
+
+            result.value = vsf_eda_get_return_value();
+            vsf_eda_frame_user_value_get(&state);
+            switch (state) {
+            case SYNC_STATE_FLUSH_FAT:
+                if (result.err != VSF_ERR_NONE) {
+                    vsf_eda_return(result.err);
+                    break;
+                }
+            update_dentry:
+                if (!file->is_dirty || !file->dentry_sector) {
+                    goto flush_cache;
+                }
+                vsf_eda_frame_user_value_set(SYNC_STATE_READ_DENTRY);
+                __vk_malfs_read(malfs_info, file->dentry_sector, 1, NULL);
+                break;
+            case SYNC_STATE_READ_DENTRY:
+                if (NULL == result.buffer) {
+                    vsf_eda_return(VSF_ERR_FAIL);
+                    break;
+                } else {
+                    fatfs_dentry_t *dentry = (fatfs_dentry_t *)&result.buffer[file->dentry_offset];
+
+                    if (!(file->attr & VSF_FILE_ATTR_DIRECTORY)) {
+                        dentry->fat.FileSize = cpu_to_le32((uint32_t)file->size);
+                        dentry->fat.Attr |= FAT_ATTR_ARCHIVE;
+                    }
+                    dentry->fat.FstClusHi = cpu_to_le16(file->first_cluster >> 16);
+                    dentry->fat.FstClusLo = cpu_to_le16(file->first_cluster & 0xFFFF);
+                }
+                vsf_eda_frame_user_value_set(SYNC_STATE_WRITE_DENTRY);
+                __vk_malfs_write(malfs_info, file->dentry_sector, 1, result.buffer);
+                break;
+            case SYNC_STATE_WRITE_DENTRY:
+                if (result.size < 0) {
+                    vsf_eda_return(VSF_ERR_FAIL);
+                    break;
+                }
+                file->is_dirty = false;
+            flush_cache:
+                vsf_eda_frame_user_value_set(SYNC_STATE_FLUSH_CACHE);
+                __vk_malfs_flush(malfs_info);
+                break;
+            case SYNC_STATE_FLUSH_CACHE:
+                vsf_eda_return(result.err);
+                break;
+            }
+        }
+        break;
+    }
+    vsf_peda_end();
+}
+
+__vsf_component_peda_ifs_entry(__vk_fatfs_unmount, vk_fs_unmount)
+{
+    vsf_peda_begin();
+    vk_vfs_file_t *dir = (vk_vfs_file_t *)&vsf_this;
+    __vk_fatfs_info_t *fsinfo = dir->subfs.data;
+    __vk_malfs_info_t *malfs_info = &fsinfo->use_as____vk_malfs_info_t;
+    vsf_err_t err;
+
+    enum {
+        UNMOUNT_STATE_FLUSH_FAT_DONE,
+        UNMOUNT_STATE_FLUSH_CACHE_DONE,
+    };
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+        // FAT updates of files not closed
+        if (fsinfo->patch_num > 0) {
+            vsf_eda_frame_user_value_set(UNMOUNT_STATE_FLUSH_FAT_DONE);
+            __vsf_component_call_peda(__vk_fatfs_commit_fat, err, fsinfo);
+            UNUSED_PARAM(err);
+            break;
+        }
+        goto flush_cache;
+    case VSF_EVT_RETURN: {
+            __vsf_frame_uint_t state;
+
+            vsf_eda_frame_user_value_get(&state);
+            switch (state) {
+            case UNMOUNT_STATE_FLUSH_FAT_DONE:
+            flush_cache:
+                vsf_eda_frame_user_value_set(UNMOUNT_STATE_FLUSH_CACHE_DONE);
+                __vk_malfs_flush(malfs_info);
+                break;
+            case UNMOUNT_STATE_FLUSH_CACHE_DONE:
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+                vk_fs_dcache_invalidate_all(fsinfo);
+#endif
+                __vk_fatfs_fini_cache(fsinfo);
+                __vk_malfs_unmount(malfs_info);
+                vsf_eda_return();
+                break;
+            }
+        }
+        break;
+    }
+    vsf_peda_end();
+}
+
+__vsf_component_peda_ifs_entry(__vk_fatfs_lookup, vk_file_lookup,
+    implement(vk_fatfs_lookup_local)
+) {
+    vsf_peda_begin();
+    enum {
+        LOOKUP_STATE_READ_SECTOR,
+        LOOKUP_STATE_PARSE_SECTOR,
+        LOOKUP_STATE_READ_FAT,
+    };
+    vk_fatfs_file_t *dir = (vk_fatfs_file_t *)&vsf_this;
+    __vk_fatfs_info_t *fsinfo = (__vk_fatfs_info_t *)dir->info;
+    __vk_malfs_info_t *malfs_info = &fsinfo->use_as____vk_malfs_info_t;
+    const char *name = vsf_local.name;
+    vsf_err_t err = VSF_ERR_NONE;
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+        vsf_local.filename = vsf_heap_malloc(VSF_FATFS_CFG_MAX_FILENAME);
+        if (NULL == vsf_local.filename) {
+            err = VSF_ERR_NOT_ENOUGH_RESOURCES;
+            goto exit;
+        }
+        vsf_local.dparser.lfn = 0;
+        vsf_local.dparser.lfn_num = 0;
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+        vsf_local.cached = 0;
+        if ((name != NULL) && vk_fs_dcache_lookup(fsinfo, dir->first_cluster, name, &vsf_local.cached)) {
+            if (!vsf_local.cached) {
+                err = VSF_ERR_NOT_AVAILABLE;
+                goto exit;
+            }
+            // only the sector with the entry is parsed, cur_cluster is not used
+            vsf_local.cur_sector = vsf_local.cached >> 16;
+            goto read_sector;
+        }
+    scan_dir:
+        vsf_local.generation = vk_fs_dcache_get_generation(fsinfo, dir->first_cluster);
+#endif
+        vsf_local.cur_cluster = dir->first_cluster;
+        if (!dir->first_cluster) {
+            if ((fsinfo->type != VSF_FAT_12) && (fsinfo->type != VSF_FAT_16)) {
+                VSF_FS_ASSERT(false);
+                err = VSF_ERR_FAIL;
+                goto exit;
+            }
+            vsf_local.cur_sector = fsinfo->root_sector;
+        } else {
+            vsf_local.cur_sector = __vk_fatfs_clus2sec(fsinfo, vsf_local.cur_cluster);
+        }
+        vsf_local.cur_sector_in_cluster = 0;
+        vsf_local.cur_file_cluster = 0;
+        vsf_local.prev_sector = 0;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+        __vk_fatfs_extent_init(fsinfo, dir);
+#endif
+        goto read_sector;
+    case VSF_EVT_RETURN: {
+            __vsf_frame_uint_t state;
+            vsf_eda_frame_user_value_get(&state);
+            switch (state) {
+            case LOOKUP_STATE_READ_SECTOR:
+            read_sector:
+                vsf_eda_frame_user_value_set(LOOKUP_STATE_PARSE_SECTOR);
+                __vk_malfs_read(malfs_info, vsf_local.cur_sector, 1, NULL);
+                break;
+            case LOOKUP_STATE_PARSE_SECTOR: {
+                    fatfs_dentry_t *dentry = (fatfs_dentry_t *)vsf_eda_get_return_value();
+                    vk_fatfs_dentry_parser_t *dparser = &vsf_local.dparser;
+
+                    if (NULL == dentry) {
+                        goto exit;
+                    }
+
+                    if (fsinfo->type == VSF_FAT_EX) {
+                        __vk_malfs_release(malfs_info, (uint8_t *)dentry);
+                        err = VSF_ERR_NOT_SUPPORT;
+                        goto exit;
+                    }
+
+                    dparser->entry = (uint8_t *)dentry;
+                    dparser->entry_num = 1 << (fsinfo->sector_size_bits - 5);
+                    dparser->filename = vsf_local.filename;
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+                    if (vsf_local.cached) {
+                        uint_fast8_t start_idx = (vsf_local.cached >> 8) & 0xFF;
+                        dparser->entry += start_idx << 5;
+                        dparser->entry_num = (vsf_local.cached & 0xFF) - start_idx + 1;
+                    }
+#endif
+                    while (dparser->entry_num) {
+                        if (vk_fatfs_parse_dentry_fat(dparser)) {
+                            if (    (name && vk_file_is_match((char *)name, dparser->filename))
+                                ||  (!name && !vsf_local.idx--)) {
+
+                                // matched
+                                vk_fatfs_file_t *fatfs_file = (vk_fatfs_file_t *)vk_file_alloc(sizeof(vk_fatfs_file_t));
+                                if (NULL == fatfs_file) {
+                                fail_mem:
+                                    __vk_malfs_release(malfs_info, (uint8_t *)vsf_eda_get_return_value());
+                                    err = VSF_ERR_NOT_ENOUGH_RESOURCES;
+                                    goto exit;
+                                }
+
+                                uint_fast16_t filename_len;
+                                if (dparser->is_unicode) {
+                                    uint16_t *uchar = (uint16_t *)dparser->filename;
+                                    filename_len = 0;
+                                    while (*uchar++ != 0) {
+                                        filename_len += 2;
+                                    }
+                                    filename_len += 2;
+                                } else {
+                                    filename_len = strlen(dparser->filename) + 1;
+                                }
+
+                                fatfs_file->name = vsf_heap_malloc(filename_len);
+                                if (NULL == fatfs_file->name) {
+                                    vk_file_free(&fatfs_file->use_as__vk_file_t);
+                                    goto fail_mem;
+                                }
+                                memcpy(fatfs_file->name, dparser->filename, filename_len);
+
+                                dentry = (fatfs_dentry_t *)dparser->entry;
+                                fatfs_file->attr = (vk_file_attr_t)__vk_fatfs_parse_file_attr(dentry->fat.Attr);
+                                fatfs_file->coding = dparser->is_unicode ? VSF_FILE_NAME_CODING_UCS2 : VSF_FILE_NAME_CODING_UNKNOWN;
+                                fatfs_file->fsop = &vk_fatfs_op;
+                                fatfs_file->size = dentry->fat.FileSize;
+                                fatfs_file->info = fsinfo;
+                                fatfs_file->first_cluster = dentry->fat.FstClusLo + (dentry->fat.FstClusHi << 16);
+
+                                // save location of dentry for update and unlink
+                                uint_fast16_t sfn_idx = ((uint8_t *)dentry - (uint8_t *)vsf_eda_get_return_value()) >> 5;
+                                fatfs_file->dentry_sector = vsf_local.cur_sector;
+                                fatfs_file->dentry_offset = sfn_idx << 5;
+                                if (dparser->lfn_num > sfn_idx + (1 << (fsinfo->sector_size_bits - 5))) {
+                                    // lfn entries across more than 2 sectors are not located
+                                } else if (dparser->lfn_num > sfn_idx) {
+                                    // lfn entries start from previous sector
+                                    fatfs_file->lfn_sector = vsf_local.prev_sector;
+                                    fatfs_file->lfn_offset = (1 << fsinfo->sector_size_bits) - ((dparser->lfn_num - sfn_idx) << 5);
+                                } else if (dparser->lfn_num > 0) {
+                                    fatfs_file->lfn_sector = vsf_local.cur_sector;
+                                    fatfs_file->lfn_offset = (sfn_idx - dparser->lfn_num) << 5;
+                                }
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+                                // entries in one sector can be verified by reading only this sector
+                                if ((name != NULL) && !vsf_local.cached && (dparser->lfn_num <= sfn_idx)) {
+                                    vk_fs_dcache_add(fsinfo, dir->first_cluster, name,
+                                        ((uint64_t)vsf_local.cur_sector << 16) | ((sfn_idx - dparser->lfn_num) << 8) | sfn_idx,
+                                        vsf_local.generation);
+                                }
+#endif
+
+                                __vk_malfs_release(malfs_info, (uint8_t *)vsf_eda_get_return_value());
+                                *vsf_local.result = &fatfs_file->use_as__vk_file_t;
+                                goto exit;
+                            }
+                            dparser->entry += 32;
+                        } else if (dparser->entry_num > 0) {
+                            __vk_malfs_release(malfs_info, (uint8_t *)vsf_eda_get_return_value());
+                            goto not_found;
+                        } else {
+                            break;
+                        }
+                    }
+                    __vk_malfs_release(malfs_info, (uint8_t *)vsf_eda_get_return_value());
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+                    if (vsf_local.cached) {
+                        goto not_found;
+                    }
+#endif
+
+                    vsf_local.prev_sector = vsf_local.cur_sector;
+                    if (!vsf_local.cur_cluster) {
+                        // root of FAT12/FAT16 in fixed sectors
+                        if (vsf_local.cur_sector + 1 >= fsinfo->root_sector + fsinfo->root_size) {
+                            goto not_found;
+                        }
+                        vsf_local.cur_sector++;
+                        goto read_sector;
+                    } else if (vsf_local.cur_sector_in_cluster < ((1U << fsinfo->cluster_size_bits) - 1)) {
+                        // not found in current sector, find next sector
+                        vsf_local.cur_sector++;
+                        vsf_local.cur_sector_in_cluster++;
+                        goto read_sector;
+                    } else {
+                        vsf_err_t err;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                        uint_fast32_t cluster = __vk_fatfs_extent_get(dir, vsf_local.cur_file_cluster + 1, NULL);
+                        if (cluster) {
+                            vsf_local.cur_cluster = cluster;
+                            vsf_local.cur_file_cluster++;
+                            goto next_cluster;
+                        }
+#endif
+                        // not found in current cluster, find next cluster if exists
+                        vsf_eda_frame_user_value_set(LOOKUP_STATE_READ_FAT);
+                        __vsf_component_call_peda(__vk_fatfs_get_fat_entry, err, fsinfo,
+                            .cluster = vsf_local.cur_cluster,
+                            .entry = &vsf_local.cur_cluster,
+                        )
+                        UNUSED_PARAM(err);
+                    }
+                }
+                break;
+            case LOOKUP_STATE_READ_FAT:
+                if ((vsf_err_t)vsf_eda_get_return_value() != VSF_ERR_NONE) {
+                    err = VSF_ERR_NOT_AVAILABLE;
+                    goto exit;
+                }
+                if (    !__vk_fatfs_fat_entry_is_valid(fsinfo, vsf_local.cur_cluster)
+                    ||  __vk_fatfs_fat_entry_is_eof(fsinfo, vsf_local.cur_cluster)) {
+                not_found:
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+                    if (vsf_local.cached) {
+                        // entry in dentry cache is out of date
+                        vk_fs_dcache_invalidate(fsinfo, dir->first_cluster, name);
+                        vsf_local.cached = 0;
+                        vsf_local.dparser.lfn = 0;
+                        vsf_local.dparser.lfn_num = 0;
+                        goto scan_dir;
+                    }
+                    if (name != NULL) {
+                        vk_fs_dcache_add(fsinfo, dir->first_cluster, name, 0, vsf_local.generation);
+                    }
+#endif
+                    err = VSF_ERR_NOT_AVAILABLE;
+                    goto exit;
                 }
+
+                // remove MSB 4-bit for 32-bit FAT entry
+                vsf_local.cur_cluster &= 0x0FFFFFFF;
+                vsf_local.cur_file_cluster++;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                __vk_fatfs_extent_add(dir, vsf_local.cur_file_cluster, vsf_local.cur_cluster);
+            next_cluster:
+#endif
+                vsf_local.cur_sector = __vk_fatfs_clus2sec(fsinfo, vsf_local.cur_cluster);
+                vsf_local.cur_sector_in_cluster = 0;
+                goto read_sector;
             }
         }
+        break;
+    }
+    return;
+exit:
+    if (vsf_local.filename != NULL) {
+        vsf_heap_free(vsf_local.filename);
     }
+    vsf_eda_return(err);
     vsf_peda_end();
 }
 
-__vsf_component_peda_ifs_entry(__vk_fatfs_lookup, vk_file_lookup,
-    implement(vk_fatfs_lookup_local)
+__vsf_component_peda_ifs_entry(__vk_fatfs_create, vk_file_create,
+    implement(vk_fatfs_create_local)
 ) {
     vsf_peda_begin();
     enum {
-        LOOKUP_STATE_READ_SECTOR,
-        LOOKUP_STATE_PARSE_SECTOR,
-        LOOKUP_STATE_READ_FAT,
+        CREATE_STATE_LOCK_DIR,
+        CREATE_STATE_LOOKUP_DONE,
+        CREATE_STATE_PARSE_SECTOR,
+        CREATE_STATE_READ_FAT_DONE,
+        CREATE_STATE_EXTEND_DIR_DONE,
+        CREATE_STATE_ALLOC_DIR_DONE,
+        CREATE_STATE_LINK_DIR_DONE,
+        CREATE_STATE_CLEAR_CLUSTER,
+        CREATE_STATE_READ_ENTRY_SECTOR,
+        CREATE_STATE_WRITE_ENTRY_SECTOR,
+        CREATE_STATE_FLUSH_FAT_DONE,
+        CREATE_STATE_FLUSH_CACHE_DONE,
     };
+
     vk_fatfs_file_t *dir = (vk_fatfs_file_t *)&vsf_this;
     __vk_fatfs_info_t *fsinfo = (__vk_fatfs_info_t *)dir->info;
     __vk_malfs_info_t *malfs_info = &fsinfo->use_as____vk_malfs_info_t;
-    const char *name = vsf_local.name;
+    uint_fast16_t entries_per_sector = 1 << (fsinfo->sector_size_bits - 5);
+    uint8_t *sector_buffer = (uint8_t *)&vsf_local.entries[FAT_LFN_MAX_ENTRY + 1];
+    fatfs_dentry_t *sfn;
     vsf_err_t err = VSF_ERR_NONE;
+    union {
+        uintptr_t value;
+        vsf_err_t err;
+        int_fast32_t size;
+        uint8_t *buffer;
+    } result;
 
     switch (evt) {
     case VSF_EVT_INIT:
-        vsf_local.filename = vsf_heap_malloc(VSF_FATFS_CFG_MAX_FILENAME);
-        if (NULL == vsf_local.filename) {
-            err = VSF_ERR_NOT_ENOUGH_RESOURCES;
-            goto exit;
+        vsf_local.entries = NULL;
+        vsf_local.file = NULL;
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+        // free entries found MUST not be taken by other creators before written
+        vsf_eda_frame_user_value_set(CREATE_STATE_LOCK_DIR);
+        if (VSF_ERR_NONE != vsf_eda_mutex_enter(&fsinfo->dir_mutex)) {
+            break;
         }
-        vsf_local.cur_cluster = dir->first_cluster;
-        if (!dir->first_cluster) {
-            if ((fsinfo->type != VSF_FAT_12) && (fsinfo->type != VSF_FAT_16)) {
-                VSF_FS_ASSERT(false);
-                err = VSF_ERR_FAIL;
+    dir_locked:
+#endif
+        {
+            char sfn_name[11];
+            uint8_t lcase = 0;
+            uint_fast8_t lfn_num = 0;
+
+            if (fsinfo->type == VSF_FAT_EX) {
+                err = VSF_ERR_NOT_SUPPORT;
+                goto exit;
+            }
+            for (const char *cur = vsf_local.name; *cur != '\0'; cur++) {
+                if (((uint8_t)*cur < 0x20) || (strchr("\"*/:<>?\\|", *cur) != NULL)) {
+                    err = VSF_ERR_INVALID_PARAMETER;
+                    goto exit;
+                }
+            }
+
+            vsf_local.entries = vsf_heap_malloc((FAT_LFN_MAX_ENTRY + 1) * sizeof(fatfs_dentry_t)
+                                            + (1 << fsinfo->sector_size_bits));
+            if (NULL == vsf_local.entries) {
+                err = VSF_ERR_NOT_ENOUGH_RESOURCES;
+                goto exit;
+            }
+
+            if (!__vk_fatfs_name_to_sfn(vsf_local.name, sfn_name, &lcase)) {
+                uint16_t hash = 0;
+
+                lfn_num = (strlen(vsf_local.name) + FAT_LFN_CHARS - 1) / FAT_LFN_CHARS;
+                if (lfn_num > min(FAT_LFN_MAX_ENTRY, 20)) {
+                    err = VSF_ERR_INVALID_PARAMETER;
+                    goto exit;
+                }
+                vsf_local.basis_len = __vk_fatfs_lfn_to_sfn_basis(vsf_local.name, sfn_name);
+                vsf_local.tail_mask = 0;
+                vsf_local.hash_tail_mask = 0;
+
+                // hashed basis name: 2 characters of basis name and 4 hex digits of hash of lfn
+                for (const char *cur = vsf_local.name; *cur != '\0'; cur++) {
+                    hash = hash * 31 + (uint8_t)*cur;
+                }
+                vsf_local.hash_basis[0] = sfn_name[0];
+                vsf_local.hash_basis[1] = (vsf_local.basis_len > 1) ? sfn_name[1] : '_';
+                for (uint_fast8_t i = 0; i < 4; i++) {
+                    vsf_local.hash_basis[2 + i] = "0123456789ABCDEF"[(hash >> (12 - 4 * i)) & 0x0F];
+                }
+            }
+
+            vsf_local.entry_num = lfn_num + 1;
+            sfn = &vsf_local.entries[lfn_num];
+            __vk_fatfs_fill_sfn(sfn, sfn_name,
+                    (vsf_local.attr & VSF_FILE_ATTR_DIRECTORY) ? FAT_ATTR_DIRECTORY : FAT_ATTR_ARCHIVE, 0);
+            if (vsf_local.attr & VSF_FILE_ATTR_HIDDEN) {
+                sfn->fat.Attr |= FAT_ATTR_HIDDEN;
+            }
+            sfn->fat.LCase = lcase;
+
+            vsf_eda_frame_user_value_set(CREATE_STATE_LOOKUP_DONE);
+            __vsf_component_call_peda_ifs(vk_file_lookup, err, vsf_peda_func(__vk_fatfs_lookup),
+                                    sizeof(vk_fatfs_lookup_local), dir,
+                .name       = vsf_local.name,
+                .idx        = 0,
+                .result     = &vsf_local.file,
+            );
+            if (err != VSF_ERR_NONE) {
                 goto exit;
             }
-            vsf_local.cur_sector = fsinfo->root_sector;
-        } else {
-            vsf_local.cur_sector = __vk_fatfs_clus2sec(fsinfo, vsf_local.cur_cluster);
         }
-        vsf_local.cur_sector_in_cluster = 0;
-        vsf_local.dparser.lfn = 0;
-        vsf_eda_frame_user_value_set(LOOKUP_STATE_READ_SECTOR);
+        break;
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+    case VSF_EVT_SYNC: {
+            __vsf_frame_uint_t state;
 
-        // fall through
+            vsf_eda_frame_user_value_get(&state);
+            if (CREATE_STATE_LOCK_DIR == state) {
+                goto dir_locked;
+            }
+            goto alloc_dir;
+        }
+#endif
     case VSF_EVT_RETURN: {
             __vsf_frame_uint_t state;
+
+            result.value = vsf_eda_get_return_value();
             vsf_eda_frame_user_value_get(&state);
+            sfn = &vsf_local.entries[vsf_local.entry_num - 1];
             switch (state) {
-            case LOOKUP_STATE_READ_SECTOR:
+            case CREATE_STATE_LOOKUP_DONE:
+                if (vsf_local.file != NULL) {
+                    __vk_fatfs_free_file((vk_fatfs_file_t *)vsf_local.file);
+                    err = VSF_ERR_ALREADY_EXISTS;
+                    goto exit;
+                } else if ((result.err != VSF_ERR_NONE) && (result.err != VSF_ERR_NOT_AVAILABLE)) {
+                    err = result.err;
+                    goto exit;
+                }
+
+                // chain of dir maybe extended by other instances of the same directory
+                dir->chain.tail = 0;
+                vsf_local.cur_cluster = dir->first_cluster;
+                if (!dir->first_cluster) {
+                    vsf_local.cur_sector = fsinfo->root_sector;
+                } else {
+                    vsf_local.cur_sector = __vk_fatfs_clus2sec(fsinfo, vsf_local.cur_cluster);
+                }
+                vsf_local.cur_sector_in_cluster = 0;
+                vsf_local.cur_file_cluster = 0;
+                vsf_local.free_num = 0;
+                vsf_local.sector_num = 0;
+                vsf_local.is_end = false;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                __vk_fatfs_extent_init(fsinfo, dir);
+#endif
             read_sector:
-                vsf_eda_frame_user_value_set(LOOKUP_STATE_PARSE_SECTOR);
+                vsf_eda_frame_user_value_set(CREATE_STATE_PARSE_SECTOR);
                 __vk_malfs_read(malfs_info, vsf_local.cur_sector, 1, NULL);
                 break;
-            case LOOKUP_STATE_PARSE_SECTOR: {
-                    fatfs_dentry_t *dentry = (fatfs_dentry_t *)vsf_eda_get_return_value();
-                    vk_fatfs_dentry_parser_t *dparser = &vsf_local.dparser;
+            case CREATE_STATE_PARSE_SECTOR: {
+                    fatfs_dentry_t *dentry = (fatfs_dentry_t *)result.buffer;
+                    uint_fast8_t tail;
 
                     if (NULL == dentry) {
+                        err = VSF_ERR_FAIL;
                         goto exit;
                     }
 
-                    if (fsinfo->type == VSF_FAT_EX) {
-                        err = VSF_ERR_NOT_SUPPORT;
-                        goto exit;
+                    // find free entries for the new file, and check sfn entries till the end of directory
+                    for (uint_fast16_t i = 0; i < entries_per_sector; i++, dentry++) {
+                        if (!dentry->fat.Name[0]) {
+                            vsf_local.is_end = true;
+                        }
+                        if (vsf_local.is_end || ((char)0xE5 == dentry->fat.Name[0])) {
+                            if (vsf_local.free_num < vsf_local.entry_num) {
+                                if (!vsf_local.free_num) {
+                                    vsf_local.first_index = i;
+                                    vsf_local.sector_num = 0;
+                                }
+                                if (    !vsf_local.sector_num
+                                    ||  (vsf_local.sectors[vsf_local.sector_num - 1] != vsf_local.cur_sector)) {
+                                    VSF_FS_ASSERT(vsf_local.sector_num < dimof(vsf_local.sectors));
+                                    vsf_local.sectors[vsf_local.sector_num++] = vsf_local.cur_sector;
+                                }
+                                vsf_local.free_num++;
+                            }
+                            if (vsf_local.is_end && (vsf_local.free_num >= vsf_local.entry_num)) {
+                                __vk_malfs_release(malfs_info, result.buffer);
+                                goto entries_found;
+                            }
+                            continue;
+                        }
+
+                        if (vsf_local.free_num < vsf_local.entry_num) {
+                            vsf_local.free_num = 0;
+                        }
+                        // lfn and volume label entries
+                        if (dentry->fat.Attr & FAT_ATTR_VOLUME_ID) {
+                            continue;
+                        }
+                        if (1 == vsf_local.entry_num) {
+                            if (!memcmp(dentry->fat.Name, sfn->fat.Name, 11)) {
+                                __vk_malfs_release(malfs_info, result.buffer);
+                                err = VSF_ERR_ALREADY_EXISTS;
+                                goto exit;
+                            }
+                        } else {
+                            tail = __vk_fatfs_sfn_get_tail(dentry->fat.Name, sfn->fat.Name,
+                                        vsf_local.basis_len, sfn->fat.Ext);
+                            vsf_local.tail_mask |= 1 << tail;
+                            tail = __vk_fatfs_sfn_get_tail(dentry->fat.Name, vsf_local.hash_basis,
+                                        sizeof(vsf_local.hash_basis), sfn->fat.Ext);
+                            vsf_local.hash_tail_mask |= 1 << tail;
+                        }
                     }
+                    __vk_malfs_release(malfs_info, result.buffer);
 
-                    dparser->entry = (uint8_t *)dentry;
-                    dparser->entry_num = 1 << (fsinfo->sector_size_bits - 5);
-                    dparser->filename = vsf_local.filename;
-                    while (dparser->entry_num) {
-                        if (vk_fatfs_parse_dentry_fat(dparser)) {
-                            if (    (name && vk_file_is_match((char *)name, dparser->filename))
-                                ||  (!name && !vsf_local.idx--)) {
+                    if (!vsf_local.cur_cluster) {
+                        // root of FAT12/FAT16 in fixed sectors
+                        if (vsf_local.cur_sector + 1 >= fsinfo->root_sector + fsinfo->root_size) {
+                            goto dir_end;
+                        }
+                        vsf_local.cur_sector++;
+                        goto read_sector;
+                    } else if (vsf_local.cur_sector_in_cluster < ((1U << fsinfo->cluster_size_bits) - 1)) {
+                        vsf_local.cur_sector++;
+                        vsf_local.cur_sector_in_cluster++;
+                        goto read_sector;
+                    } else {
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                        uint_fast32_t cluster = __vk_fatfs_extent_get(dir, vsf_local.cur_file_cluster + 1, NULL);
+                        if (cluster) {
+                            vsf_local.cur_cluster = cluster;
+                            vsf_local.cur_file_cluster++;
+                            goto next_cluster;
+                        }
+#endif
+                        if (__vk_fatfs_get_fat_entry_cached(fsinfo, vsf_local.cur_cluster, &vsf_local.cur_cluster)) {
+                            goto check_next_cluster;
+                        }
+                        vsf_eda_frame_user_value_set(CREATE_STATE_READ_FAT_DONE);
+                        __vsf_component_call_peda(__vk_fatfs_get_fat_entry, err, fsinfo,
+                            .cluster = vsf_local.cur_cluster,
+                            .entry = &vsf_local.cur_cluster,
+                        );
+                        UNUSED_PARAM(err);
+                    }
+                }
+                break;
+            case CREATE_STATE_READ_FAT_DONE:
+                if (result.err != VSF_ERR_NONE) {
+                    err = VSF_ERR_FAIL;
+                    goto exit;
+                }
+            check_next_cluster:
+                if (__vk_fatfs_fat_entry_is_eof(fsinfo, vsf_local.cur_cluster)) {
+                    goto dir_end;
+                } else if (!__vk_fatfs_cluster_is_valid(fsinfo, vsf_local.cur_cluster)) {
+                    err = VSF_ERR_FAIL;
+                    goto exit;
+                }
 
-                                // matched
-                                vk_fatfs_file_t *fatfs_file = (vk_fatfs_file_t *)vk_file_alloc(sizeof(vk_fatfs_file_t));
-                                if (NULL == fatfs_file) {
-                                fail_mem:
-                                    err = VSF_ERR_NOT_ENOUGH_RESOURCES;
-                                    goto exit;
-                                }
+                // remove MSB 4-bit for 32-bit FAT entry
+                vsf_local.cur_cluster &= 0x0FFFFFFF;
+                vsf_local.cur_file_cluster++;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                __vk_fatfs_extent_add(dir, vsf_local.cur_file_cluster, vsf_local.cur_cluster);
+            next_cluster:
+#endif
+                vsf_local.cur_sector = __vk_fatfs_clus2sec(fsinfo, vsf_local.cur_cluster);
+                vsf_local.cur_sector_in_cluster = 0;
+                goto read_sector;
 
-                                uint_fast16_t filename_len;
-                                if (dparser->is_unicode) {
-                                    uint16_t *uchar = (uint16_t *)dparser->filename;
-                                    filename_len = 0;
-                                    while (*uchar++ != 0) {
-                                        filename_len += 2;
-                                    }
-                                    filename_len += 2;
-                                } else {
-                                    filename_len = strlen(dparser->filename) + 1;
-                                }
+            dir_end:
+                if (vsf_local.free_num >= vsf_local.entry_num) {
+                    goto entries_found;
+                } else if (!dir->first_cluster) {
+                    // root of FAT12/FAT16 can not be extended
+                    err = VSF_ERR_NOT_ENOUGH_RESOURCES;
+                    goto exit;
+                }
+                vsf_eda_frame_user_value_set(CREATE_STATE_EXTEND_DIR_DONE);
+                __vsf_component_call_peda(__vk_fatfs_extend_chain, err, dir,
+                    .cluster_num = vsf_local.cur_file_cluster + 2,
+                );
+                break;
+            case CREATE_STATE_EXTEND_DIR_DONE:
+                if (result.err != VSF_ERR_NONE) {
+                    err = result.err;
+                    goto exit;
+                }
+                vsf_local.cur_cluster = dir->chain.tail;
+                vsf_local.cur_file_cluster++;
+                goto clear_cluster;
+
+            entries_found:
+                if (vsf_local.entry_num > 1) {
+                    uint_fast8_t tail;
+
+                    for (tail = 1; (tail <= 9) && (vsf_local.tail_mask & (1 << tail)); tail++);
+                    if (tail <= 9) {
+                        sfn->fat.Name[vsf_local.basis_len] = '~';
+                        sfn->fat.Name[vsf_local.basis_len + 1] = '0' + tail;
+                    } else {
+                        for (tail = 1; (tail <= 9) && (vsf_local.hash_tail_mask & (1 << tail)); tail++);
+                        if (tail > 9) {
+                            err = VSF_ERR_NOT_ENOUGH_RESOURCES;
+                            goto exit;
+                        }
+                        memcpy(sfn->fat.Name, vsf_local.hash_basis, sizeof(vsf_local.hash_basis));
+                        sfn->fat.Name[6] = '~';
+                        sfn->fat.Name[7] = '0' + tail;
+                    }
+                    __vk_fatfs_fill_lfn(vsf_local.entries, vsf_local.entry_num - 1, vsf_local.name);
+                }
 
-                                fatfs_file->name = vsf_heap_malloc(filename_len);
-                                if (NULL == fatfs_file->name) {
-                                    vk_file_free(&fatfs_file->use_as__vk_file_t);
-                                    goto fail_mem;
-                                }
-                                memcpy(fatfs_file->name, dparser->filename, filename_len);
+                if (vsf_local.attr & VSF_FILE_ATTR_DIRECTORY) {
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+                    if (VSF_ERR_NONE != vsf_eda_mutex_enter(&fsinfo->fat_mutex)) {
+                        break;
+                    }
+                alloc_dir:
+#endif
+                    vsf_eda_frame_user_value_set(CREATE_STATE_ALLOC_DIR_DONE);
+                    __vsf_component_call_peda(__vk_fatfs_alloc_clusters, err, fsinfo,
+                        .num = 1,
+                        .cluster = &vsf_local.cur_cluster,
+                        .run = &vsf_local.cur_file_cluster,
+                    );
+                    break;
+                }
+                goto write_entries;
+            case CREATE_STATE_ALLOC_DIR_DONE:
+            case CREATE_STATE_LINK_DIR_DONE:
+                if (result.err != VSF_ERR_NONE) {
+                    __vk_fatfs_fat_unlock(fsinfo);
+                    err = result.err;
+                    goto exit;
+                }
+                if (!__vk_fatfs_fat_patch_add(fsinfo, vsf_local.cur_cluster, 1, __vk_fatfs_fat_entry_eof(fsinfo))) {
+                    vsf_eda_frame_user_value_set(CREATE_STATE_LINK_DIR_DONE);
+                    __vsf_component_call_peda(__vk_fatfs_flush_fat, err, fsinfo);
+                    break;
+                }
+                __vk_fatfs_fat_unlock(fsinfo);
+                sfn->fat.FstClusHi = cpu_to_le16(vsf_local.cur_cluster >> 16);
+                sfn->fat.FstClusLo = cpu_to_le16(vsf_local.cur_cluster & 0xFFFF);
+
+            clear_cluster:
+                // clear new cluster of directory, with dot entries if it's the new directory
+                vsf_local.cur_idx = 0;
+                memset(sector_buffer, 0, 1 << fsinfo->sector_size_bits);
+                if (vsf_local.free_num >= vsf_local.entry_num) {
+                    fatfs_dentry_t *dot = (fatfs_dentry_t *)sector_buffer;
+                    __vk_fatfs_fill_sfn(&dot[0], ".          ", FAT_ATTR_DIRECTORY, vsf_local.cur_cluster);
+                    __vk_fatfs_fill_sfn(&dot[1], "..         ", FAT_ATTR_DIRECTORY,
+                            (dir->first_cluster == fsinfo->root.first_cluster) ? 0 : dir->first_cluster);
+                }
+                goto write_clear_sector;
+            case CREATE_STATE_CLEAR_CLUSTER:
+                if (result.size < 0) {
+                    err = VSF_ERR_FAIL;
+                    goto exit;
+                }
+                if (!vsf_local.cur_idx++) {
+                    memset(sector_buffer, 0, 2 * sizeof(fatfs_dentry_t));
+                }
+                if (vsf_local.cur_idx >= (1 << fsinfo->cluster_size_bits)) {
+                    if (vsf_local.free_num >= vsf_local.entry_num) {
+                        goto write_entries;
+                    }
+                    // continue to find free entries in the new cluster of directory
+                    vsf_local.cur_sector = __vk_fatfs_clus2sec(fsinfo, vsf_local.cur_cluster);
+                    vsf_local.cur_sector_in_cluster = 0;
+                    goto read_sector;
+                }
+            write_clear_sector:
+                vsf_eda_frame_user_value_set(CREATE_STATE_CLEAR_CLUSTER);
+                __vk_malfs_write(malfs_info, __vk_fatfs_clus2sec(fsinfo, vsf_local.cur_cluster) + vsf_local.cur_idx,
+                            1, sector_buffer);
+                break;
 
-                                dentry = (fatfs_dentry_t *)dparser->entry;
-                                fatfs_file->attr = (vk_file_attr_t)__vk_fatfs_parse_file_attr(dentry->fat.Attr);
-                                fatfs_file->coding = dparser->is_unicode ? VSF_FILE_NAME_CODING_UCS2 : VSF_FILE_NAME_CODING_UNKNOWN;
-                                fatfs_file->fsop = &vk_fatfs_op;
-                                fatfs_file->size = dentry->fat.FileSize;
-                                fatfs_file->info = fsinfo;
-                                fatfs_file->first_cluster = dentry->fat.FstClusLo + (dentry->fat.FstClusHi << 16);
+            write_entries:
+                // free_num is reused as the number of entries written
+                vsf_local.cur_idx = 0;
+                vsf_local.free_num = 0;
+            read_entry_sector:
+                vsf_eda_frame_user_value_set(CREATE_STATE_READ_ENTRY_SECTOR);
+                __vk_malfs_read(malfs_info, vsf_local.sectors[vsf_local.cur_idx], 1, NULL);
+                break;
+            case CREATE_STATE_READ_ENTRY_SECTOR:
+                if (NULL == result.buffer) {
+                    err = VSF_ERR_FAIL;
+                    goto exit;
+                } else {
+                    uint_fast16_t start = vsf_local.cur_idx ? 0 : vsf_local.first_index;
+                    uint_fast16_t num = min(entries_per_sector - start, (uint_fast16_t)(vsf_local.entry_num - vsf_local.free_num));
+
+                    memcpy(&result.buffer[start * sizeof(fatfs_dentry_t)], &vsf_local.entries[vsf_local.free_num],
+                            num * sizeof(fatfs_dentry_t));
+                    vsf_local.free_num += num;
+                }
+                vsf_eda_frame_user_value_set(CREATE_STATE_WRITE_ENTRY_SECTOR);
+                __vk_malfs_write(malfs_info, vsf_local.sectors[vsf_local.cur_idx], 1, result.buffer);
+                break;
+            case CREATE_STATE_WRITE_ENTRY_SECTOR:
+                if (result.size < 0) {
+                    err = VSF_ERR_FAIL;
+                    goto exit;
+                }
+                if (++vsf_local.cur_idx < vsf_local.sector_num) {
+                    goto read_entry_sector;
+                }
+                if (fsinfo->patch_num > 0) {
+                    vsf_eda_frame_user_value_set(CREATE_STATE_FLUSH_FAT_DONE);
+                    __vsf_component_call_peda(__vk_fatfs_commit_fat, err, fsinfo);
+                    break;
+                }
+                goto flush_cache;
+            case CREATE_STATE_FLUSH_FAT_DONE:
+                if (result.err != VSF_ERR_NONE) {
+                    err = result.err;
+                    goto exit;
+                }
+            flush_cache:
+                vsf_eda_frame_user_value_set(CREATE_STATE_FLUSH_CACHE_DONE);
+                __vk_malfs_flush(malfs_info);
+                break;
+            case CREATE_STATE_FLUSH_CACHE_DONE:
+                err = result.err;
+                goto exit;
+            }
+        }
+        break;
+    }
+    return;
+exit:
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+    vk_fs_dcache_invalidate(fsinfo, dir->first_cluster, vsf_local.name);
+#endif
+    if (vsf_local.entries != NULL) {
+        vsf_heap_free(vsf_local.entries);
+    }
+    __vk_fatfs_dir_unlock(fsinfo);
+    vsf_eda_return(err);
+    vsf_peda_end();
+}
+
+__vsf_component_peda_ifs_entry(__vk_fatfs_unlink, vk_file_unlink,
+    implement(vk_fatfs_unlink_local)
+) {
+    vsf_peda_begin();
+    enum {
+        UNLINK_STATE_LOOKUP_DONE,
+        UNLINK_STATE_CHECK_EMPTY_DONE,
+        UNLINK_STATE_FREE_CHAIN_DONE,
+        UNLINK_STATE_READ_SFN_DONE,
+        UNLINK_STATE_WRITE_SFN_DONE,
+        UNLINK_STATE_READ_LFN_DONE,
+        UNLINK_STATE_WRITE_LFN_DONE,
+        UNLINK_STATE_FLUSH_DENTRY_DONE,
+        UNLINK_STATE_FLUSH_FAT_DONE,
+        UNLINK_STATE_FLUSH_CACHE_DONE,
+    };
+
+    vk_fatfs_file_t *dir = (vk_fatfs_file_t *)&vsf_this;
+    __vk_fatfs_info_t *fsinfo = (__vk_fatfs_info_t *)dir->info;
+    __vk_malfs_info_t *malfs_info = &fsinfo->use_as____vk_malfs_info_t;
+    vk_fatfs_file_t *file = vsf_local.file;
+    vsf_err_t err = VSF_ERR_NONE;
+    union {
+        uintptr_t value;
+        vsf_err_t err;
+        int_fast32_t size;
+        uint8_t *buffer;
+    } result;
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+        vsf_local.file = NULL;
+        vsf_local.child = NULL;
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+        if (VSF_ERR_NONE != vsf_eda_mutex_enter(&fsinfo->dir_mutex)) {
+            break;
+        }
+        // fall through
+    case VSF_EVT_SYNC:
+#endif
+        vsf_eda_frame_user_value_set(UNLINK_STATE_LOOKUP_DONE);
+        __vsf_component_call_peda_ifs(vk_file_lookup, err, vsf_peda_func(__vk_fatfs_lookup),
+                                sizeof(vk_fatfs_lookup_local), dir,
+            .name       = vsf_local.name,
+            .idx        = 0,
+            .result     = (vk_file_t **)&vsf_local.file,
+        );
+        if (err != VSF_ERR_NONE) {
+            goto exit;
+        }
+        break;
+    case VSF_EVT_RETURN: {
+            __vsf_frame_uint_t state;
 
-                                *vsf_local.result = &fatfs_file->use_as__vk_file_t;
-                                goto exit;
-                            }
-                            dparser->entry += 32;
-                        } else if (dparser->entry_num > 0) {
-                            err = VSF_ERR_NOT_AVAILABLE;
-                            goto exit;
-                        } else {
-                            break;
-                        }
+            result.value = vsf_eda_get_return_value();
+            vsf_eda_frame_user_value_get(&state);
+            switch (state) {
+            case UNLINK_STATE_LOOKUP_DONE:
+                if (NULL == file) {
+                    err = (result.err != VSF_ERR_NONE) ? result.err : VSF_ERR_NOT_AVAILABLE;
+                    goto exit;
+                }
+                if (file->attr & VSF_FILE_ATTR_DIRECTORY) {
+                    // entries other than dot entries means directory is not empty
+                    vsf_eda_frame_user_value_set(UNLINK_STATE_CHECK_EMPTY_DONE);
+                    __vsf_component_call_peda_ifs(vk_file_lookup, err, vsf_peda_func(__vk_fatfs_lookup),
+                                            sizeof(vk_fatfs_lookup_local), file,
+                        .name       = NULL,
+                        .idx        = 2,
+                        .result     = &vsf_local.child,
+                    );
+                    if (err != VSF_ERR_NONE) {
+                        goto exit;
                     }
-
-                    if (    (!vsf_local.cur_cluster && (vsf_local.cur_sector < fsinfo->root_size))
-                        ||  (vsf_local.cur_sector_in_cluster < ((1 << fsinfo->cluster_size_bits) - 1))) {
-                        // not found in current sector, find next sector
-                        vsf_local.cur_sector++;
-                        vsf_local.cur_sector_in_cluster++;
-                        goto read_sector;
-                    } else {
-                        vsf_err_t err;
-                        // not found in current cluster, find next cluster if exists
-                        vsf_eda_frame_user_value_set(LOOKUP_STATE_READ_FAT);
-                        __vsf_component_call_peda(__vk_fatfs_get_fat_entry, err, fsinfo,
-                            .cluster = vsf_local.cur_cluster,
-                            .entry = &vsf_local.cur_cluster,
-                        )
-                        UNUSED_PARAM(err);
+                    break;
+                }
+                goto free_chain;
+            case UNLINK_STATE_CHECK_EMPTY_DONE:
+                if (vsf_local.child != NULL) {
+                    __vk_fatfs_free_file((vk_fatfs_file_t *)vsf_local.child);
+                    err = VSF_ERR_NOT_ACCESSABLE;
+                    goto exit;
+                }
+            free_chain:
+                vsf_eda_frame_user_value_set(UNLINK_STATE_FREE_CHAIN_DONE);
+                __vsf_component_call_peda(__vk_fatfs_free_chain, err, fsinfo,
+                    .cluster = file->first_cluster & 0x0FFFFFFF,
+                    .tail = 0,
+                );
+                break;
+            case UNLINK_STATE_FREE_CHAIN_DONE:
+                if (result.err != VSF_ERR_NONE) {
+                    err = result.err;
+                    goto exit;
+                }
+                vsf_eda_frame_user_value_set(UNLINK_STATE_READ_SFN_DONE);
+                __vk_malfs_read(malfs_info, file->dentry_sector, 1, NULL);
+                break;
+            case UNLINK_STATE_READ_SFN_DONE:
+                if (NULL == result.buffer) {
+                    err = VSF_ERR_FAIL;
+                    goto exit;
+                }
+                result.buffer[file->dentry_offset] = 0xE5;
+                if (file->lfn_sector) {
+                    // lfn entries maybe start from previous sector
+                    uint_fast16_t offset = (file->lfn_sector == file->dentry_sector) ? file->lfn_offset : 0;
+                    for (; offset < file->dentry_offset; offset += 32) {
+                        result.buffer[offset] = 0xE5;
                     }
                 }
+                vsf_eda_frame_user_value_set(UNLINK_STATE_WRITE_SFN_DONE);
+                __vk_malfs_write(malfs_info, file->dentry_sector, 1, result.buffer);
                 break;
-            case LOOKUP_STATE_READ_FAT:
-                if (    ((vsf_err_t)vsf_eda_get_return_value() != VSF_ERR_NONE)
-                    ||  !__vk_fatfs_fat_entry_is_valid(fsinfo, vsf_local.cur_cluster)
-                    ||  __vk_fatfs_fat_entry_is_eof(fsinfo, vsf_local.cur_cluster)) {
-                    err = VSF_ERR_NOT_AVAILABLE;
+            case UNLINK_STATE_WRITE_SFN_DONE:
+                if (result.size < 0) {
+                    err = VSF_ERR_FAIL;
                     goto exit;
                 }
-
-                // remove MSB 4-bit for 32-bit FAT entry
-                vsf_local.cur_cluster &= 0x0FFFFFFF;
-                vsf_local.cur_sector = __vk_fatfs_clus2sec(fsinfo, vsf_local.cur_cluster);
-                vsf_local.cur_sector_in_cluster = 0;
-                goto read_sector;
+                if (file->lfn_sector && (file->lfn_sector != file->dentry_sector)) {
+                    vsf_eda_frame_user_value_set(UNLINK_STATE_READ_LFN_DONE);
+                    __vk_malfs_read(malfs_info, file->lfn_sector, 1, NULL);
+                    break;
+                }
+                goto flush_fat;
+            case UNLINK_STATE_READ_LFN_DONE:
+                if (NULL == result.buffer) {
+                    err = VSF_ERR_FAIL;
+                    goto exit;
+                }
+                // lfn entries till the end of the sector before sfn entry
+                for (uint_fast16_t offset = file->lfn_offset; offset < (1U << fsinfo->sector_size_bits); offset += 32) {
+                    result.buffer[offset] = 0xE5;
+                }
+                vsf_eda_frame_user_value_set(UNLINK_STATE_WRITE_LFN_DONE);
+                __vk_malfs_write(malfs_info, file->lfn_sector, 1, result.buffer);
+                break;
+            case UNLINK_STATE_WRITE_LFN_DONE:
+                if (result.size < 0) {
+                    err = VSF_ERR_FAIL;
+                    goto exit;
+                }
+            flush_fat:
+                // clusters are freed in FAT after dentry is removed
+                vsf_eda_frame_user_value_set(UNLINK_STATE_FLUSH_DENTRY_DONE);
+                __vk_malfs_flush(malfs_info);
+                break;
+            case UNLINK_STATE_FLUSH_DENTRY_DONE:
+                if (result.err != VSF_ERR_NONE) {
+                    err = result.err;
+                    goto exit;
+                }
+                if (fsinfo->patch_num > 0) {
+                    vsf_eda_frame_user_value_set(UNLINK_STATE_FLUSH_FAT_DONE);
+                    __vsf_component_call_peda(__vk_fatfs_commit_fat, err, fsinfo);
+                    break;
+                }
+                goto exit;
+            case UNLINK_STATE_FLUSH_FAT_DONE:
+                if (result.err != VSF_ERR_NONE) {
+                    err = result.err;
+                    goto exit;
+                }
+                vsf_eda_frame_user_value_set(UNLINK_STATE_FLUSH_CACHE_DONE);
+                __vk_malfs_flush(malfs_info);
+                break;
+            case UNLINK_STATE_FLUSH_CACHE_DONE:
+                err = result.err;
+                goto exit;
             }
         }
         break;
     }
     return;
 exit:
-    if (vsf_local.filename != NULL) {
-        vsf_heap_free(vsf_local.filename);
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+    vk_fs_dcache_invalidate(fsinfo, dir->first_cluster, vsf_local.name);
+#endif
+    if (vsf_local.file != NULL) {
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+        if (vsf_local.file->attr & VSF_FILE_ATTR_DIRECTORY) {
+            vk_fs_dcache_invalidate_dir(fsinfo, vsf_local.file->first_cluster);
+        }
+#endif
+        __vk_fatfs_free_file(vsf_local.file);
     }
+    __vk_fatfs_dir_unlock(fsinfo);
     vsf_eda_return(err);
     vsf_peda_end();
 }
@@ -811,13 +2897,25 @@ __vsf_component_peda_ifs_entry(__vk_fatfs_close, vk_file_close)
 {
     vsf_peda_begin();
     vk_fatfs_file_t *fatfs_file = (vk_fatfs_file_t *)&vsf_this;
+    vsf_err_t err;
 
-    // TODO: flush file buffer if enabled
-    if (fatfs_file->name != NULL) {
-        vsf_heap_free(fatfs_file->name);
+    switch (evt) {
+    case VSF_EVT_INIT:
+        __vsf_component_call_peda(__vk_fatfs_sync_file, err, fatfs_file);
+        UNUSED_PARAM(err);
+        break;
+    case VSF_EVT_RETURN:
+        // file will be freed by caller, even if sync failed
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+        __vk_fatfs_extent_fini(fatfs_file);
+#endif
+        if (fatfs_file->name != NULL) {
+            vsf_heap_free(fatfs_file->name);
+            fatfs_file->name = NULL;
+        }
+        vsf_eda_return(vsf_eda_get_return_value());
+        break;
     }
-    vk_file_free(&fatfs_file->use_as__vk_file_t);
-    vsf_eda_return(VSF_ERR_NONE);
     vsf_peda_end();
 }
 
@@ -836,16 +2934,44 @@ __vsf_component_peda_ifs_entry(__vk_fatfs_read, vk_file_read,
     vk_fatfs_file_t *fatfs_file = (vk_fatfs_file_t *)&vsf_this;
     __vk_fatfs_info_t *fsinfo = (__vk_fatfs_info_t *)fatfs_file->info;
     __vk_malfs_info_t *malfs_info = &fsinfo->use_as____vk_malfs_info_t;
-    uint32_t clustersize = 1 << (fsinfo->cluster_size_bits + fsinfo->sector_size_bits);
+    uint_fast8_t cluster_size_bits = fsinfo->cluster_size_bits + fsinfo->sector_size_bits;
+    uint32_t clustersize = 1 << cluster_size_bits;
+    uint32_t sectorsize = 1 << fsinfo->sector_size_bits;
 
     switch (evt) {
     case VSF_EVT_INIT:
-        if (vsf_local.size > (fatfs_file->size - vsf_local.offset)) {
+        if (vsf_local.offset >= fatfs_file->size) {
+            vsf_local.size = 0;
+        } else if (vsf_local.size > (fatfs_file->size - vsf_local.offset)) {
             vsf_local.size = fatfs_file->size - vsf_local.offset;
         }
+        vsf_local.cur_size = 0;
+        if (!vsf_local.size) {
+            vsf_eda_return(0);
+            break;
+        }
+
         // locate the first cluster for access
         vsf_local.cur_cluster = fatfs_file->first_cluster;
         vsf_local.cur_offset = 0;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+        __vk_fatfs_extent_init(fsinfo, fatfs_file);
+        if (fatfs_file->extent.cluster_num > 0) {
+            // start from the cached cluster nearest to offset
+            uint_fast32_t file_cluster = vsf_local.offset >> cluster_size_bits;
+            uint_fast32_t start_cluster = min(file_cluster, fatfs_file->extent.cluster_num - 1);
+
+            if (    fatfs_file->extent.last_cluster
+                &&  (fatfs_file->extent.last_file_cluster > start_cluster)
+                &&  (fatfs_file->extent.last_file_cluster <= file_cluster)) {
+                start_cluster = fatfs_file->extent.last_file_cluster;
+                vsf_local.cur_cluster = fatfs_file->extent.last_cluster;
+            } else {
+                vsf_local.cur_cluster = __vk_fatfs_extent_get(fatfs_file, start_cluster, NULL);
+            }
+            vsf_local.cur_offset = (uint64_t)start_cluster << cluster_size_bits;
+        }
+#endif
         vsf_eda_frame_user_value_set(READ_STATE_GET_FAT_ENTRY);
         // fall through
     case VSF_EVT_RETURN: {
@@ -865,7 +2991,7 @@ __vsf_component_peda_ifs_entry(__vk_fatfs_read, vk_file_read,
                     vsf_eda_return(result.err);
                     break;
                 }
-                if (!__vk_fatfs_fat_entry_is_valid(fsinfo, vsf_local.cur_cluster)) {
+                if (!__vk_fatfs_cluster_is_valid(fsinfo, vsf_local.cur_cluster)) {
                     vsf_eda_return(VSF_ERR_FAIL);
                     break;
                 }
@@ -873,6 +2999,9 @@ __vsf_component_peda_ifs_entry(__vk_fatfs_read, vk_file_read,
                 // remove MSB 4-bit for 32-bit FAT entry
                 vsf_local.cur_cluster &= 0x0FFFFFFF;
                 vsf_local.cur_offset += clustersize;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                __vk_fatfs_extent_add(fatfs_file, vsf_local.cur_offset >> cluster_size_bits, vsf_local.cur_cluster);
+#endif
                 // fall through
             case READ_STATE_GET_FAT_ENTRY:
                 if ((vsf_local.cur_offset + clustersize) <= vsf_local.offset) {
@@ -885,33 +3014,31 @@ __vsf_component_peda_ifs_entry(__vk_fatfs_read, vk_file_read,
                     UNUSED_PARAM(err);
                     break;
                 }
-
-                vsf_local.cur_size = 0;
-                vsf_local.cur_sector = __vk_fatfs_clus2sec(fsinfo, vsf_local.cur_cluster);
-                vsf_local.cur_sector += (vsf_local.offset & (clustersize - 1)) >> fsinfo->sector_size_bits;
-                vsf_local.cur_offset = vsf_local.offset & ~((1 << fsinfo->sector_size_bits) - 1);
                 vsf_eda_frame_user_value_set(READ_STATE_READ);
                 // fall through
             case READ_STATE_READ:
             read_next:
                 if (vsf_local.size) {
+                    uint_fast32_t sector_in_cluster = (vsf_local.offset & (clustersize - 1)) >> fsinfo->sector_size_bits;
                     uint8_t *buffer;
 
-                    if (vsf_local.cur_offset != vsf_local.offset) {
-                        // read first non-page-aligned data
-                        vsf_local.cur_run_size = vsf_local.size & ((1 << fsinfo->sector_size_bits) - 1);
-                        vsf_local.cur_run_sector = 1;
-                        buffer = NULL;
-                    } else if (vsf_local.size < (1 << fsinfo->sector_size_bits)) {
-                        // read last non-page-aligned data
-                        vsf_local.cur_run_size = vsf_local.size;
+                    vsf_local.cur_sector = __vk_fatfs_clus2sec(fsinfo, vsf_local.cur_cluster) + sector_in_cluster;
+                    if ((vsf_local.offset & (sectorsize - 1)) || (vsf_local.size < sectorsize)) {
+                        // read non-sector-aligned data in sector buffer of malfs
+                        vsf_local.cur_run_size = sectorsize - (vsf_local.offset & (sectorsize - 1));
+                        vsf_local.cur_run_size = min(vsf_local.cur_run_size, vsf_local.size);
                         vsf_local.cur_run_sector = 1;
                         buffer = NULL;
                     } else {
-                        // read page-aligned data in cluster
-                        // get remain sector in clusrer
-                        vsf_local.cur_run_sector =
-                            vsf_local.cur_sector & ((1 << fsinfo->cluster_size_bits) - 1);
+                        // read sector-aligned data in contiguous clusters to user buffer directly
+                        uint32_t cluster_run = 1;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                        if (!__vk_fatfs_extent_get(fatfs_file, vsf_local.offset >> cluster_size_bits, &cluster_run)) {
+                            cluster_run = 1;
+                        }
+                        cluster_run = min(cluster_run, (vsf_local.size >> cluster_size_bits) + 1);
+#endif
+                        vsf_local.cur_run_sector = (cluster_run << fsinfo->cluster_size_bits) - sector_in_cluster;
                         vsf_local.cur_run_sector = min(vsf_local.cur_run_sector,
                             vsf_local.size >> fsinfo->sector_size_bits);
                         vsf_local.cur_run_size = vsf_local.cur_run_sector << fsinfo->sector_size_bits;
@@ -922,6 +3049,15 @@ __vsf_component_peda_ifs_entry(__vk_fatfs_read, vk_file_read,
                     break;
                 }
 
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                if (vsf_local.cur_size) {
+                    uint_fast32_t file_cluster = (vsf_local.offset - 1) >> cluster_size_bits;
+                    if (file_cluster >= fatfs_file->extent.cluster_num) {
+                        fatfs_file->extent.last_file_cluster = file_cluster;
+                        fatfs_file->extent.last_cluster = vsf_local.cur_cluster;
+                    }
+                }
+#endif
                 vsf_eda_return(vsf_local.cur_size);
                 break;
             case READ_STATE_READ_DONE:
@@ -930,22 +3066,37 @@ __vsf_component_peda_ifs_entry(__vk_fatfs_read, vk_file_read,
                     break;
                 }
 
-                if (vsf_local.cur_offset != vsf_local.offset) {
-                    uint8_t *src = result.buffer;
-                    src += vsf_local.offset - vsf_local.cur_offset;
-                    memcpy(vsf_local.buff, src, vsf_local.cur_run_size);
-                    vsf_local.cur_offset += vsf_local.cur_run_size;
-                } else if (vsf_local.size < (1 << fsinfo->sector_size_bits)) {
-                    uint8_t *dst = vsf_local.buff + vsf_local.cur_size;
-                    memcpy(dst, result.buffer, vsf_local.cur_run_size);
+                if ((vsf_local.offset & (sectorsize - 1)) || (vsf_local.size < sectorsize)) {
+                    uint8_t *src = result.buffer + (vsf_local.offset & (sectorsize - 1));
+                    memcpy(vsf_local.buff + vsf_local.cur_size, src, vsf_local.cur_run_size);
+                    __vk_malfs_release(malfs_info, result.buffer);
                 }
                 vsf_local.cur_size += vsf_local.cur_run_size;
                 vsf_local.offset += vsf_local.cur_run_size;
                 vsf_local.size -= vsf_local.cur_run_size;
 
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                if (vsf_local.size) {
+                    // contiguous clusters maybe read in one run, locate the last cluster read
+                    uint_fast32_t cluster = __vk_fatfs_extent_get(fatfs_file,
+                                (vsf_local.offset - 1) >> cluster_size_bits, NULL);
+                    if (cluster) {
+                        vsf_local.cur_cluster = cluster;
+                    }
+                }
+#endif
+
                 // get next cluster if necessary
-                if (vsf_local.size && !(vsf_local.cur_sector & ((1 << fsinfo->cluster_size_bits) - 1))) {
+                if (vsf_local.size && !(vsf_local.offset & (clustersize - 1))) {
                     vsf_err_t err;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                    uint_fast32_t cluster = __vk_fatfs_extent_get(fatfs_file,
+                                vsf_local.offset >> cluster_size_bits, NULL);
+                    if (cluster) {
+                        vsf_local.cur_cluster = cluster;
+                        goto read_next;
+                    }
+#endif
                     vsf_eda_frame_user_value_set(READ_STATE_GET_NEXT_FAT_ENTRY_DONE);
                     __vsf_component_call_peda(__vk_fatfs_get_fat_entry, err, fsinfo,
                         .cluster = vsf_local.cur_cluster,
@@ -960,13 +3111,16 @@ __vsf_component_peda_ifs_entry(__vk_fatfs_read, vk_file_read,
                     vsf_eda_return(result.err);
                     break;
                 }
-                if (!__vk_fatfs_fat_entry_is_valid(fsinfo, vsf_local.cur_cluster)) {
+                if (!__vk_fatfs_cluster_is_valid(fsinfo, vsf_local.cur_cluster)) {
                     vsf_eda_return(VSF_ERR_FAIL);
                     break;
                 }
 
                 // remove MSB 4-bit for 32-bit FAT entry
-			    vsf_local.cur_cluster &= 0x0FFFFFFF;
+                vsf_local.cur_cluster &= 0x0FFFFFFF;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                __vk_fatfs_extent_add(fatfs_file, vsf_local.offset >> cluster_size_bits, vsf_local.cur_cluster);
+#endif
                 goto read_next;
             }
         }
@@ -974,9 +3128,350 @@ __vsf_component_peda_ifs_entry(__vk_fatfs_read, vk_file_read,
     vsf_peda_end();
 }
 
-__vsf_component_peda_ifs_entry(__vk_fatfs_write, vk_file_write)
-{
+// clusters for the whole write are allocated in runs before data is written,
+//  data between the original end of file and offset is cleared
+__vsf_component_peda_ifs_entry(__vk_fatfs_write, vk_file_write,
+    implement(vk_fatfs_write_local)
+) {
+    vsf_peda_begin();
+    enum {
+        WRITE_STATE_EXTEND_CHAIN_DONE,
+        WRITE_STATE_LOCATE_CLUSTER_DONE,
+        WRITE_STATE_READ_DONE,
+        WRITE_STATE_WRITE_DONE,
+        WRITE_STATE_GET_NEXT_FAT_ENTRY_DONE,
+    };
+
+    vk_fatfs_file_t *fatfs_file = (vk_fatfs_file_t *)&vsf_this;
+    __vk_fatfs_info_t *fsinfo = (__vk_fatfs_info_t *)fatfs_file->info;
+    __vk_malfs_info_t *malfs_info = &fsinfo->use_as____vk_malfs_info_t;
+    uint_fast8_t cluster_size_bits = fsinfo->cluster_size_bits + fsinfo->sector_size_bits;
+    uint32_t clustersize = 1 << cluster_size_bits;
+    uint32_t sectorsize = 1 << fsinfo->sector_size_bits;
+    vsf_err_t err;
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+        vsf_local.cur_size = 0;
+        if (fatfs_file->attr & VSF_FILE_ATTR_DIRECTORY) {
+            vsf_eda_return(VSF_ERR_NOT_SUPPORT);
+            break;
+        }
+        // file size is 32-bit in FAT
+        if (vsf_local.offset >= 0xFFFFFFFF) {
+            vsf_eda_return(VSF_ERR_INVALID_RANGE);
+            break;
+        }
+        vsf_local.size = min(vsf_local.size, 0xFFFFFFFF - vsf_local.offset);
+        vsf_local.gap_size = 0;
+        if (vsf_local.offset > fatfs_file->size) {
+            vsf_local.gap_size = vsf_local.offset - fatfs_file->size;
+            vsf_local.offset = fatfs_file->size;
+        } else if (!vsf_local.size) {
+            vsf_eda_return(0);
+            break;
+        }
+
+        vsf_eda_frame_user_value_set(WRITE_STATE_EXTEND_CHAIN_DONE);
+        __vsf_component_call_peda(__vk_fatfs_extend_chain, err, fatfs_file,
+            .cluster_num = (vsf_local.offset + vsf_local.gap_size + vsf_local.size + clustersize - 1) >> cluster_size_bits,
+        );
+        UNUSED_PARAM(err);
+        break;
+    case VSF_EVT_RETURN: {
+            union {
+                uintptr_t value;
+                vsf_err_t err;
+                int_fast32_t size;
+                uint8_t *buffer;
+            } result;
+            __vsf_frame_uint_t state;
+
+            result.value = vsf_eda_get_return_value();
+            vsf_eda_frame_user_value_get(&state);
+            switch (state) {
+            case WRITE_STATE_EXTEND_CHAIN_DONE:
+                if (result.err != VSF_ERR_NONE) {
+                    vsf_eda_return(result.err);
+                    break;
+                }
+                vsf_eda_frame_user_value_set(WRITE_STATE_LOCATE_CLUSTER_DONE);
+                __vsf_component_call_peda(__vk_fatfs_get_cluster, err, fatfs_file,
+                    .file_cluster = vsf_local.offset >> cluster_size_bits,
+                    .cluster = &vsf_local.cur_cluster,
+                );
+                UNUSED_PARAM(err);
+                break;
+            case WRITE_STATE_LOCATE_CLUSTER_DONE:
+                if (result.err != VSF_ERR_NONE) {
+                    vsf_eda_return(VSF_ERR_FAIL);
+                    break;
+                }
+            write_next:
+                if (vsf_local.gap_size || vsf_local.size) {
+                    uint_fast32_t sector_in_cluster = (vsf_local.offset & (clustersize - 1)) >> fsinfo->sector_size_bits;
+
+                    vsf_local.cur_sector = __vk_fatfs_clus2sec(fsinfo, vsf_local.cur_cluster) + sector_in_cluster;
+                    if (    vsf_local.gap_size
+                        ||  (vsf_local.offset & (sectorsize - 1)) || (vsf_local.size < sectorsize)) {
+                        // update non-sector-aligned data and zeros of gap in sector buffer of malfs
+                        vsf_local.cur_run_size = sectorsize - (vsf_local.offset & (sectorsize - 1));
+                        vsf_local.cur_run_size = min(vsf_local.cur_run_size,
+                                vsf_local.gap_size ? vsf_local.gap_size : vsf_local.size);
+                        vsf_local.cur_run_sector = 1;
+                        vsf_eda_frame_user_value_set(WRITE_STATE_READ_DONE);
+                        __vk_malfs_read(malfs_info, vsf_local.cur_sector, 1, NULL);
+                    } else {
+                        // write sector-aligned data in contiguous clusters from user buffer directly
+                        uint32_t cluster_run = 1;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                        if (!__vk_fatfs_extent_get(fatfs_file, vsf_local.offset >> cluster_size_bits, &cluster_run)) {
+                            cluster_run = 1;
+                        }
+                        cluster_run = min(cluster_run, (vsf_local.size >> cluster_size_bits) + 1);
+#endif
+                        vsf_local.cur_run_sector = (cluster_run << fsinfo->cluster_size_bits) - sector_in_cluster;
+                        vsf_local.cur_run_sector = min(vsf_local.cur_run_sector,
+                            vsf_local.size >> fsinfo->sector_size_bits);
+                        vsf_local.cur_run_size = vsf_local.cur_run_sector << fsinfo->sector_size_bits;
+                        vsf_eda_frame_user_value_set(WRITE_STATE_WRITE_DONE);
+                        __vk_malfs_write(malfs_info, vsf_local.cur_sector, vsf_local.cur_run_sector,
+                            vsf_local.buff + vsf_local.cur_size);
+                    }
+                    break;
+                }
+
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                {
+                    uint_fast32_t file_cluster = (vsf_local.offset - 1) >> cluster_size_bits;
+                    if (file_cluster >= fatfs_file->extent.cluster_num) {
+                        fatfs_file->extent.last_file_cluster = file_cluster;
+                        fatfs_file->extent.last_cluster = vsf_local.cur_cluster;
+                    }
+                }
+#endif
+                vsf_eda_return(vsf_local.cur_size);
+                break;
+            case WRITE_STATE_READ_DONE:
+                if (NULL == result.buffer) {
+                    vsf_eda_return(VSF_ERR_FAIL);
+                    break;
+                }
+                if (vsf_local.gap_size) {
+                    memset(result.buffer + (vsf_local.offset & (sectorsize - 1)), 0, vsf_local.cur_run_size);
+                } else {
+                    memcpy(result.buffer + (vsf_local.offset & (sectorsize - 1)),
+                        vsf_local.buff + vsf_local.cur_size, vsf_local.cur_run_size);
+                }
+                vsf_eda_frame_user_value_set(WRITE_STATE_WRITE_DONE);
+                __vk_malfs_write(malfs_info, vsf_local.cur_sector, 1, result.buffer);
+                break;
+            case WRITE_STATE_WRITE_DONE:
+                if (result.size < 0) {
+                    vsf_eda_return(VSF_ERR_FAIL);
+                    break;
+                }
+
+                if (vsf_local.gap_size) {
+                    vsf_local.gap_size -= vsf_local.cur_run_size;
+                } else {
+                    vsf_local.cur_size += vsf_local.cur_run_size;
+                    vsf_local.size -= vsf_local.cur_run_size;
+                }
+                vsf_local.offset += vsf_local.cur_run_size;
+                if (vsf_local.offset > fatfs_file->size) {
+                    fatfs_file->size = vsf_local.offset;
+                    fatfs_file->is_dirty = true;
+                }
+
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                if (vsf_local.gap_size || vsf_local.size) {
+                    // contiguous clusters maybe written in one run, locate the last cluster written
+                    uint_fast32_t cluster = __vk_fatfs_extent_get(fatfs_file,
+                                (vsf_local.offset - 1) >> cluster_size_bits, NULL);
+                    if (cluster) {
+                        vsf_local.cur_cluster = cluster;
+                    }
+                }
+#endif
+
+                // get next cluster if necessary
+                if ((vsf_local.gap_size || vsf_local.size) && !(vsf_local.offset & (clustersize - 1))) {
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                    uint_fast32_t cluster = __vk_fatfs_extent_get(fatfs_file,
+                                vsf_local.offset >> cluster_size_bits, NULL);
+                    if (cluster) {
+                        vsf_local.cur_cluster = cluster;
+                        goto write_next;
+                    }
+#endif
+                    if (__vk_fatfs_get_fat_entry_cached(fsinfo, vsf_local.cur_cluster, &vsf_local.cur_cluster)) {
+                        goto next_cluster;
+                    }
+                    vsf_eda_frame_user_value_set(WRITE_STATE_GET_NEXT_FAT_ENTRY_DONE);
+                    __vsf_component_call_peda(__vk_fatfs_get_fat_entry, err, fsinfo,
+                        .cluster = vsf_local.cur_cluster,
+                        .entry = &vsf_local.cur_cluster,
+                    );
+                    UNUSED_PARAM(err);
+                    break;
+                }
+                goto write_next;
+            case WRITE_STATE_GET_NEXT_FAT_ENTRY_DONE:
+                if (result.err < 0) {
+                    vsf_eda_return(result.err);
+                    break;
+                }
+            next_cluster:
+                // clusters are allocated before write, so chain MUST not end here
+                if (!__vk_fatfs_cluster_is_valid(fsinfo, vsf_local.cur_cluster)) {
+                    vsf_eda_return(VSF_ERR_FAIL);
+                    break;
+                }
+
+                // remove MSB 4-bit for 32-bit FAT entry
+                vsf_local.cur_cluster &= 0x0FFFFFFF;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                __vk_fatfs_extent_add(fatfs_file, vsf_local.offset >> cluster_size_bits, vsf_local.cur_cluster);
+#endif
+                goto write_next;
+            }
+        }
+        break;
+    }
+    vsf_peda_end();
+}
+
+__vsf_component_peda_ifs_entry(__vk_fatfs_resize, vk_file_resize,
+    implement(vk_fatfs_resize_local)
+) {
     vsf_peda_begin();
+    enum {
+        RESIZE_STATE_EXTEND_DONE,
+        RESIZE_STATE_LOCATE_CLUSTER_DONE,
+        RESIZE_STATE_GET_NEXT_DONE,
+        RESIZE_STATE_FREE_CHAIN_DONE,
+    };
+
+    vk_fatfs_file_t *fatfs_file = (vk_fatfs_file_t *)&vsf_this;
+    __vk_fatfs_info_t *fsinfo = (__vk_fatfs_info_t *)fatfs_file->info;
+    uint_fast8_t cluster_size_bits = fsinfo->cluster_size_bits + fsinfo->sector_size_bits;
+    uint32_t clustersize = 1 << cluster_size_bits;
+    uint_fast32_t cluster_num;
+    vsf_err_t err;
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+        if (fatfs_file->attr & VSF_FILE_ATTR_DIRECTORY) {
+            vsf_eda_return(VSF_ERR_NOT_SUPPORT);
+            break;
+        }
+        if (vsf_local.size > 0xFFFFFFFF) {
+            vsf_eda_return(VSF_ERR_INVALID_RANGE);
+            break;
+        }
+
+        cluster_num = (vsf_local.size + clustersize - 1) >> cluster_size_bits;
+        if (vsf_local.size > fatfs_file->size) {
+            // an empty write at the new end allocates and clears the extended data
+            vsf_eda_frame_user_value_set(RESIZE_STATE_EXTEND_DONE);
+            __vsf_component_call_peda_ifs(vk_file_write, err, vsf_peda_func(__vk_fatfs_write),
+                                    sizeof(vk_fatfs_write_local), fatfs_file,
+                .offset = vsf_local.size,
+                .size   = 0,
+                .buff   = NULL,
+            );
+            UNUSED_PARAM(err);
+            break;
+        } else if (!cluster_num) {
+            vsf_local.next = fatfs_file->first_cluster;
+            fatfs_file->first_cluster = 0;
+            fatfs_file->is_dirty = true;
+            fatfs_file->chain.num = 0;
+            fatfs_file->chain.tail = 0;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+            __vk_fatfs_extent_fini(fatfs_file);
+#endif
+            vsf_local.cluster = 0;
+            goto free_chain;
+        }
+
+        vsf_eda_frame_user_value_set(RESIZE_STATE_LOCATE_CLUSTER_DONE);
+        __vsf_component_call_peda(__vk_fatfs_get_cluster, err, fatfs_file,
+            .file_cluster = cluster_num - 1,
+            .cluster = &vsf_local.cluster,
+        );
+        UNUSED_PARAM(err);
+        break;
+    case VSF_EVT_RETURN: {
+            __vsf_frame_uint_t state;
+
+            err = (vsf_err_t)vsf_eda_get_return_value();
+            vsf_eda_frame_user_value_get(&state);
+            switch (state) {
+            case RESIZE_STATE_LOCATE_CLUSTER_DONE:
+                if (err != VSF_ERR_NONE) {
+                    vsf_eda_return(VSF_ERR_FAIL);
+                    break;
+                }
+                if (__vk_fatfs_get_fat_entry_cached(fsinfo, vsf_local.cluster, &vsf_local.next)) {
+                    goto truncate_chain;
+                }
+                vsf_eda_frame_user_value_set(RESIZE_STATE_GET_NEXT_DONE);
+                __vsf_component_call_peda(__vk_fatfs_get_fat_entry, err, fsinfo,
+                    .cluster = vsf_local.cluster,
+                    .entry = &vsf_local.next,
+                );
+                break;
+            case RESIZE_STATE_GET_NEXT_DONE:
+                if (err != VSF_ERR_NONE) {
+                    vsf_eda_return(err);
+                    break;
+                }
+            truncate_chain:
+                if (!__vk_fatfs_cluster_is_valid(fsinfo, vsf_local.next)) {
+                    // no clusters after the new end
+                    goto update_size;
+                }
+
+                cluster_num = (vsf_local.size + clustersize - 1) >> cluster_size_bits;
+                fatfs_file->chain.num = cluster_num;
+                fatfs_file->chain.tail = vsf_local.cluster;
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+                __vk_fatfs_extent_truncate(fatfs_file, cluster_num);
+#endif
+
+            free_chain:
+                // the new last cluster is terminated by free_chain
+                vsf_eda_frame_user_value_set(RESIZE_STATE_FREE_CHAIN_DONE);
+                __vsf_component_call_peda(__vk_fatfs_free_chain, err, fsinfo,
+                    .cluster = vsf_local.next & 0x0FFFFFFF,
+                    .tail = vsf_local.cluster,
+                );
+                break;
+            case RESIZE_STATE_EXTEND_DONE:
+                if ((int32_t)err < 0) {
+                    vsf_eda_return(err);
+                    break;
+                }
+                vsf_eda_return(VSF_ERR_NONE);
+                break;
+            case RESIZE_STATE_FREE_CHAIN_DONE:
+                if (err != VSF_ERR_NONE) {
+                    vsf_eda_return(err);
+                    break;
+                }
+            update_size:
+                if (fatfs_file->size != vsf_local.size) {
+                    fatfs_file->size = vsf_local.size;
+                    fatfs_file->is_dirty = true;
+                }
+                vsf_eda_return(VSF_ERR_NONE);
+                break;
+            }
+        }
+        break;
+    }
     vsf_peda_end();
 }
 
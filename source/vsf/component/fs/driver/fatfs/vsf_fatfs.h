@@ -39,6 +39,29 @@ extern "C" {
 
 /*============================ MACROS ========================================*/
 
+// cache cluster chain of opened files as extents of contiguous clusters
+#ifndef VSF_FATFS_CFG_EXTENT_CACHE
+#   define VSF_FATFS_CFG_EXTENT_CACHE       ENABLED
+#endif
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+// max number of extents cached for one file, further clusters are not cached
+#   ifndef VSF_FATFS_CFG_EXTENT_MAX_NUM
+#       define VSF_FATFS_CFG_EXTENT_MAX_NUM 1024
+#   endif
+#endif
+
+// number of FAT sectors cached for each volume, 0 to disable
+#ifndef VSF_FATFS_CFG_FAT_CACHE_NUM
+#   define VSF_FATFS_CFG_FAT_CACHE_NUM      2
+#endif
+
+// max number of pending FAT updates for each volume, clusters are allocated in
+//  runs and FAT is updated sector by sector when pending updates are full or
+//  file is closed
+#ifndef VSF_FATFS_CFG_FAT_PATCH_NUM
+#   define VSF_FATFS_CFG_FAT_PATCH_NUM      8
+#endif
+
 #define implement_fatfs_info(__block_size, __cache_num)                         \
     implement(__vk_fatfs_info_t)                                                \
     __implement_malfs_cache(__block_size, __cache_num)
@@ -77,10 +100,38 @@ typedef enum vk_fat_file_attr_t {
     VSF_FAT_FILE_ATTR_ARCHIVE = VSF_FILE_ATTR_EXT << 2,
 } vk_fat_file_attr_t;
 
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+// extent of contiguous clusters, ends at the start of the next extent
+typedef struct vk_fatfs_extent_t {
+    uint32_t file_cluster;
+    uint32_t cluster;
+} vk_fatfs_extent_t;
+#endif
+
+#if VSF_FATFS_CFG_FAT_CACHE_NUM > 0
+typedef struct vk_fatfs_fat_cache_node_t {
+    // 0 if not cached, FAT never starts from sector 0
+    //  sector being read if busy, cleared if the sector is updated before read done
+    uint32_t sector;
+    uint32_t access_tick;
+    bool is_busy;
+} vk_fatfs_fat_cache_node_t;
+#endif
+
+// pending update of FAT entries in [cluster, cluster + num), clusters are
+//  linked one by one and the last one links to next, or all freed if next is 0
+typedef struct vk_fatfs_fat_patch_t {
+    uint32_t cluster;
+    uint32_t num;
+    uint32_t next;
+} vk_fatfs_fat_patch_t;
+
 typedef struct vk_fatfs_dentry_parser_t {
     uint8_t *entry;
     int16_t entry_num;
     uint8_t lfn;
+    // number of lfn entries of the filename parsed
+    uint8_t lfn_num;
     bool is_unicode;
     char *filename;
 } vk_fatfs_dentry_parser_t;
@@ -96,7 +147,38 @@ def_simple_class(vk_fatfs_file_t) {
             uint32_t cluster;
             uint32_t fat_entry;
         } cur;
+
+        // location of the sfn entry, and the first lfn entry if lfn_sector is not 0
+        //  dentry_sector is 0 for root
+        uint32_t dentry_sector;
+        uint32_t lfn_sector;
+        uint16_t dentry_offset;
+        uint16_t lfn_offset;
+        // size or first_cluster changed, dentry will be updated on close
+        bool is_dirty;
+        // tail is 0 if not resolved, and first_cluster is not 0
+        struct {
+            uint32_t num;
+            uint32_t tail;
+        } chain;
     )
+
+#if VSF_FATFS_CFG_EXTENT_CACHE == ENABLED
+    private_member(
+        // cluster chain of [0, cluster_num) in file, allocated on demand
+        struct {
+            vk_fatfs_extent_t *extents;
+            uint32_t cluster_num;
+            uint16_t num;
+            uint16_t size;
+            // extent last accessed, sequential access will not search
+            uint16_t hint;
+            // last cluster read out of extents if extents are full
+            uint32_t last_file_cluster;
+            uint32_t last_cluster;
+        } extent;
+    )
+#endif
 };
 
 // memory layout:
@@ -130,7 +212,33 @@ def_simple_class(__vk_fatfs_info_t) {
         uint8_t sector_size_bits;
         uint8_t cluster_size_bits;
         uint8_t fat_num;
+
+        // FAT32 FSInfo sector, cleared after free count in FSInfo is invalidated
+        uint32_t fsinfo_sector;
+        // where to search for free clusters
+        uint32_t free_cluster;
+        uint8_t patch_num;
+        vk_fatfs_fat_patch_t patches[VSF_FATFS_CFG_FAT_PATCH_NUM];
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+        // held while FAT patches are updated, and from searching free clusters till they are claimed
+        vsf_mutex_t fat_mutex;
+        // held by create and unlink from searching directory entries till they are written
+        vsf_mutex_t dir_mutex;
+#endif
+    )
+
+#if VSF_FATFS_CFG_FAT_CACHE_NUM > 0
+    private_member(
+        // shared by all files in the volume, buffer is allocated in mount
+        struct {
+            uint8_t *buffer;
+            uint32_t tick;
+            // 0 if buffer is not available
+            uint8_t number;
+            vk_fatfs_fat_cache_node_t nodes[VSF_FATFS_CFG_FAT_CACHE_NUM];
+        } fat_cache;
     )
+#endif
 
     // vk_malfs_info_t must be the last in vk_fatfs_info_t
     public_member(
@@ -27,6 +27,9 @@
 #include "../../vsf_fs.h"
 
 /*============================ MACROS ========================================*/
+
+#define VSF_MALFS_CACHE_NODE_NONE       0xFFFF
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
 
@@ -84,11 +87,138 @@ static uint8_t * __vk_malfs_get_cache_buff(__vk_malfs_cache_t *cache, __vk_malfs
     return &buff[idx * cache->info->block_size];
 }
 
+static __vk_malfs_cache_node_t * __vk_malfs_get_cache_node(__vk_malfs_cache_t *cache, uint8_t *buff)
+{
+    uint8_t *cache_buff = (uint8_t *)&cache->nodes[cache->number];
+    if ((buff < cache_buff) || (buff >= &cache_buff[cache->number * cache->info->block_size])) {
+        return NULL;
+    }
+    return &cache->nodes[(buff - cache_buff) / cache->info->block_size];
+}
+
+static void __vk_malfs_cache_pin(__vk_malfs_cache_node_t *node)
+{
+    vsf_protect_t orig = vsf_protect_sched();
+    VSF_FS_ASSERT(node->pin_cnt < 0xFF);
+    node->pin_cnt++;
+    vsf_unprotect_sched(orig);
+}
+
+static void __vk_malfs_cache_unpin(__vk_malfs_cache_node_t *node)
+{
+    vsf_protect_t orig = vsf_protect_sched();
+    VSF_FS_ASSERT(node->pin_cnt > 0);
+    node->pin_cnt--;
+    vsf_unprotect_sched(orig);
+}
+
 void __vk_malfs_cache_init(__vk_malfs_info_t *info, __vk_malfs_cache_t *cache)
 {
     cache->info = info;
+    cache->seq_block_addr = (uint64_t)-1;
+    cache->clock_hand = 0;
+    memset(cache->nodes, 0, cache->number * sizeof(cache->nodes[0]));
+    for (uint_fast16_t i = 0; i < cache->number; i++) {
+        cache->nodes[i].hash_head = VSF_MALFS_CACHE_NODE_NONE;
+    }
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+    vsf_eda_mutex_init(&cache->mutex);
+#endif
+}
+
+static void __vk_malfs_cache_unlock(__vk_malfs_cache_t *cache)
+{
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+    vsf_eda_mutex_leave(&cache->mutex);
+#endif
+}
+
+static uint16_t * __vk_malfs_cache_get_bucket(__vk_malfs_cache_t *cache, uint_fast64_t block_addr)
+{
+    return &cache->nodes[block_addr % cache->number].hash_head;
+}
+
+static __vk_malfs_cache_node_t * __vk_malfs_cache_lookup(__vk_malfs_cache_t *cache, uint_fast64_t block_addr)
+{
+    uint_fast16_t idx = *__vk_malfs_cache_get_bucket(cache, block_addr);
+    __vk_malfs_cache_node_t *node;
+
+    while (idx != VSF_MALFS_CACHE_NODE_NONE) {
+        node = &cache->nodes[idx];
+        if (node->block_addr == block_addr) {
+            return node;
+        }
+        idx = node->hash_next;
+    }
+    return NULL;
+}
+
+static void __vk_malfs_cache_insert(__vk_malfs_cache_t *cache, __vk_malfs_cache_node_t *node)
+{
+    uint16_t *bucket = __vk_malfs_cache_get_bucket(cache, node->block_addr);
+
+    node->is_alloced = true;
+    node->hash_next = *bucket;
+    *bucket = node - cache->nodes;
+}
+
+static void __vk_malfs_cache_remove(__vk_malfs_cache_t *cache, __vk_malfs_cache_node_t *node)
+{
+    uint16_t *link = __vk_malfs_cache_get_bucket(cache, node->block_addr);
+    uint_fast16_t idx = node - cache->nodes;
+
+    while (*link != VSF_MALFS_CACHE_NODE_NONE) {
+        if (*link == idx) {
+            *link = node->hash_next;
+            break;
+        }
+        link = &cache->nodes[*link].hash_next;
+    }
+    node->is_alloced = false;
 }
 
+// clock algorithm: skip and clear nodes accessed since last passed, skip pinned nodes
+static __vk_malfs_cache_node_t * __vk_malfs_cache_get_victim(__vk_malfs_cache_t *cache)
+{
+    __vk_malfs_cache_node_t *node;
+
+    // all nodes are passed at most twice, the first pass clears is_accessed
+    for (uint_fast32_t i = 0; i < 2 * cache->number; i++) {
+        node = &cache->nodes[cache->clock_hand];
+        if (++cache->clock_hand >= cache->number) {
+            cache->clock_hand = 0;
+        }
+        if (node->pin_cnt) {
+            continue;
+        }
+        if (!node->is_alloced || !node->is_accessed) {
+            return node;
+        }
+        node->is_accessed = false;
+    }
+    return NULL;
+}
+
+#if VSF_MALFS_CFG_CACHE_WRITE_BACK == ENABLED
+// dirty nodes adjacent in both block address and cache buffer are written in one request
+static __vk_malfs_cache_node_t * __vk_malfs_cache_get_dirty_run(__vk_malfs_cache_t *cache,
+            __vk_malfs_cache_node_t *node, uint_fast16_t *num)
+{
+    __vk_malfs_cache_node_t *first = node, *last = node;
+
+    while (     (first > cache->nodes) && first[-1].is_alloced && first[-1].is_dirty
+            &&  (first[-1].block_addr + 1 == first->block_addr)) {
+        first--;
+    }
+    while (     (last < &cache->nodes[cache->number - 1]) && last[1].is_alloced && last[1].is_dirty
+            &&  (last[1].block_addr == last->block_addr + 1)) {
+        last++;
+    }
+    *num = last - first + 1;
+    return first;
+}
+#endif
+
 #if     __IS_COMPILER_GCC__
 #   pragma GCC diagnostic push
 #   pragma GCC diagnostic ignored "-Wcast-align"
@@ -97,124 +227,319 @@ void __vk_malfs_cache_init(__vk_malfs_info_t *info, __vk_malfs_cache_t *cache)
 #   pragma clang diagnostic ignored "-Wcast-align"
 #endif
 
-__vsf_component_peda_private_entry(__vk_malfs_alloc_cache,
-    uint64_t block_addr;
-    __vk_malfs_cache_node_t *result;
+#if VSF_MALFS_CFG_CACHE_WRITE_BACK == ENABLED
+// cache should be locked by caller
+__vsf_component_peda_private_entry(__vk_malfs_cache_writeback,
+    __vk_malfs_cache_node_t *node;
+    uint16_t num;
 ) {
     vsf_peda_begin();
     __vk_malfs_cache_t *cache = (__vk_malfs_cache_t *)&vsf_this;
     __vk_malfs_info_t *info = cache->info;
-    __vk_malfs_cache_node_t *nodes = cache->nodes;
+    __vk_malfs_cache_node_t *node;
+    uint_fast16_t num;
 
     switch (evt) {
-    case VSF_EVT_INIT: {
-            __vk_malfs_cache_node_t *least_node = nodes, *unalloced_node = NULL;
-            for (uint_fast16_t i = 0; i < cache->number; i++) {
-                if (nodes[i].is_alloced) {
-                    if (nodes[i].block_addr == vsf_local.block_addr) {
-                        vsf_eda_return(&nodes[i]);
-                        return;
-                    }
-                    if (nodes[i].access_time_sec < least_node->access_time_sec) {
-                        least_node = &nodes[i];
-                    }
-                } else if (NULL == unalloced_node) {
-                    unalloced_node = &nodes[i];
-                }
-            }
-            if (unalloced_node != NULL) {
-                unalloced_node->is_alloced = true;
-                vsf_eda_return(unalloced_node);
-                return;
-            }
-
-            vsf_local.result = least_node;
-            // missed, get least cache
-            // TODO: add bit to indicate the node is not currently used
-            if (!least_node->is_dirty) {
-                vsf_eda_return(least_node);
-                return;
-            }
-
-            least_node->is_dirty = false;
-            __vk_malfs_write(info, least_node->block_addr, 1, __vk_malfs_get_cache_buff(&info->cache, least_node));
-            break;
+    case VSF_EVT_INIT:
+        node = __vk_malfs_cache_get_dirty_run(cache, vsf_local.node, &num);
+        vsf_local.node = node;
+        vsf_local.num = num;
+        for (uint_fast16_t i = 0; i < num; i++) {
+            node[i].is_dirty = false;
         }
+        vk_mal_write(info->mal, info->block_size * node->block_addr,
+                    info->block_size * num, __vk_malfs_get_cache_buff(cache, node));
         break;
     case VSF_EVT_RETURN:
-        vsf_eda_return(vsf_local.result);
+        if ((int32_t)vsf_eda_get_return_value() < 0) {
+            for (uint_fast16_t i = 0; i < vsf_local.num; i++) {
+                vsf_local.node[i].is_dirty = true;
+            }
+            vsf_eda_return(VSF_ERR_FAIL);
+            break;
+        }
+        vsf_eda_return(VSF_ERR_NONE);
         break;
     }
     vsf_peda_end();
 }
+#endif
 
 __vsf_component_peda_private_entry(__vk_malfs_read,
     uint64_t block_addr;
     uint32_t block_num;
     uint8_t *buff;
+    __vk_malfs_cache_node_t *node;
 ) {
     vsf_peda_begin();
     __vk_malfs_info_t *info = (__vk_malfs_info_t *)&vsf_this;
+    __vk_malfs_cache_t *cache = &info->cache;
+    __vk_malfs_cache_node_t *node;
+    uint8_t *result = NULL;
     enum {
-        STATE_GET_CACHE,
-        STATE_COMMIT_READ,
-        STATE_FINISH_READ,
+        STATE_WRITEBACK,
+        STATE_READ_CACHE,
+        STATE_READ,
     };
 
     switch (evt) {
     case VSF_EVT_INIT:
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+        if (VSF_ERR_NONE != vsf_eda_mutex_enter(&cache->mutex)) {
+            break;
+        }
+        // fall through
+    case VSF_EVT_SYNC:
+#endif
         if (NULL == vsf_local.buff) {
             VSF_FS_ASSERT(1 == vsf_local.block_num);
-            vsf_eda_frame_user_value_set(STATE_GET_CACHE);
-            __vk_malfs_alloc_cache(info, &info->cache, vsf_local.block_addr);
-            return;
+            node = __vk_malfs_cache_lookup(cache, vsf_local.block_addr);
+            if (node != NULL) {
+                node->is_accessed = true;
+                __vk_malfs_cache_pin(node);
+                result = __vk_malfs_get_cache_buff(cache, node);
+                goto do_return;
+            }
+
+            node = __vk_malfs_cache_get_victim(cache);
+            if (NULL == node) {
+                goto do_return;
+            }
+            vsf_local.node = node;
+#if VSF_MALFS_CFG_CACHE_WRITE_BACK == ENABLED
+            if (node->is_alloced && node->is_dirty) {
+                vsf_err_t err;
+                vsf_eda_frame_user_value_set(STATE_WRITEBACK);
+                __vsf_component_call_peda(__vk_malfs_cache_writeback, err, cache,
+                    .node       = node,
+                );
+                UNUSED_PARAM(err);
+                break;
+            }
+#endif
+            goto read_cache;
         }
-        vsf_eda_frame_user_value_set(STATE_COMMIT_READ);
+
+        vsf_eda_frame_user_value_set(STATE_READ);
+        vk_mal_read(info->mal, info->block_size * vsf_local.block_addr,
+                    info->block_size * vsf_local.block_num, vsf_local.buff);
+        break;
     case VSF_EVT_RETURN: {
             __vsf_frame_uint_t state;
             vsf_eda_frame_user_value_get(&state);
             switch (state) {
-            case STATE_GET_CACHE: {
-                    __vk_malfs_cache_node_t *node = (__vk_malfs_cache_node_t *)vsf_eda_get_return_value();
-                    VSF_FS_ASSERT(node != NULL);
-                    vsf_local.buff = __vk_malfs_get_cache_buff(&info->cache, node);
+            case STATE_WRITEBACK:
+                if ((vsf_err_t)vsf_eda_get_return_value() != VSF_ERR_NONE) {
+                    goto do_return;
                 }
                 // fall through
-            case STATE_COMMIT_READ:
-                vsf_eda_frame_user_value_set(STATE_FINISH_READ);
-                vk_mal_read(info->mal, info->block_size * vsf_local.block_addr,
-                            info->block_size * vsf_local.block_num, vsf_local.buff);
-                break;
-            case STATE_FINISH_READ:
-                vsf_eda_return((int32_t)vsf_eda_get_return_value() > 0 ? vsf_local.buff : NULL);
+            read_cache: {
+                    uint_fast32_t num = 1;
+
+                    node = vsf_local.node;
+                    if (node->is_alloced) {
+                        __vk_malfs_cache_remove(cache, node);
+                    }
+                    if (vsf_local.block_addr == cache->seq_block_addr) {
+                        // sequential access, read ahead into following clean nodes
+                        uint_fast64_t block_remain = info->mal->size / info->block_size;
+                        uint_fast32_t max_num = VSF_MALFS_CFG_CACHE_READAHEAD_NUM;
+                        __vk_malfs_cache_node_t *next;
+
+                        block_remain = block_remain > vsf_local.block_addr ? block_remain - vsf_local.block_addr : 0;
+                        max_num = min(max_num, block_remain);
+                        while (num < max_num) {
+                            next = &node[num];
+                            if (    (next >= &cache->nodes[cache->number])
+                                ||  (next->is_alloced && (next->is_dirty || next->is_accessed || next->pin_cnt))
+                                ||  (__vk_malfs_cache_lookup(cache, vsf_local.block_addr + num) != NULL)) {
+                                break;
+                            }
+                            if (next->is_alloced) {
+                                __vk_malfs_cache_remove(cache, next);
+                            }
+                            num++;
+                        }
+                        cache->clock_hand = (node - cache->nodes + num) % cache->number;
+                    }
+                    for (uint_fast32_t i = 0; i < num; i++) {
+                        node[i].block_addr = vsf_local.block_addr + i;
+                    }
+                    vsf_local.block_num = num;
+                    cache->seq_block_addr = vsf_local.block_addr + num;
+
+                    vsf_eda_frame_user_value_set(STATE_READ_CACHE);
+                    vk_mal_read(info->mal, info->block_size * vsf_local.block_addr,
+                                info->block_size * num, __vk_malfs_get_cache_buff(cache, node));
+                }
                 break;
+            case STATE_READ_CACHE:
+                if ((int32_t)vsf_eda_get_return_value() > 0) {
+                    node = vsf_local.node;
+                    for (uint_fast32_t i = 0; i < vsf_local.block_num; i++) {
+                        node[i].is_dirty = false;
+                        node[i].is_accessed = false;
+                        __vk_malfs_cache_insert(cache, &node[i]);
+                    }
+                    node->is_accessed = true;
+                    __vk_malfs_cache_pin(node);
+                    result = __vk_malfs_get_cache_buff(cache, node);
+                }
+                goto do_return;
+            case STATE_READ:
+                if ((int32_t)vsf_eda_get_return_value() > 0) {
+#if VSF_MALFS_CFG_CACHE_WRITE_BACK == ENABLED
+                    // blocks not written back yet are newer than data in mal
+                    for (uint_fast32_t i = 0; i < vsf_local.block_num; i++) {
+                        node = __vk_malfs_cache_lookup(cache, vsf_local.block_addr + i);
+                        if ((node != NULL) && node->is_dirty) {
+                            memcpy(&vsf_local.buff[i * info->block_size],
+                                __vk_malfs_get_cache_buff(cache, node), info->block_size);
+                        }
+                    }
+#endif
+                    result = vsf_local.buff;
+                }
+                goto do_return;
+            }
+        }
+        break;
+    }
+    return;
+do_return:
+    __vk_malfs_cache_unlock(cache);
+    vsf_eda_return(result);
+    vsf_peda_end();
+}
+
+__vsf_component_peda_private_entry(__vk_malfs_write,
+    uint64_t block_addr;
+    uint32_t block_num;
+    uint8_t *buff;
+    // cache node pinned by read with NULL buff, unpinned after written
+    __vk_malfs_cache_node_t *pinned;
+) {
+    vsf_peda_begin();
+    __vk_malfs_info_t *info = (__vk_malfs_info_t *)&vsf_this;
+    __vk_malfs_cache_t *cache = &info->cache;
+    __vk_malfs_cache_node_t *node;
+    uint8_t *cache_buff;
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+        if (VSF_ERR_NONE != vsf_eda_mutex_enter(&cache->mutex)) {
+            break;
+        }
+        // fall through
+    case VSF_EVT_SYNC:
+#endif
+        // only writing the pinned buffer back to its own block unpins it
+        vsf_local.pinned = __vk_malfs_get_cache_node(cache, vsf_local.buff);
+        if (    (vsf_local.pinned != NULL)
+            &&  (!vsf_local.pinned->pin_cnt || (vsf_local.pinned->block_addr != vsf_local.block_addr))) {
+            vsf_local.pinned = NULL;
+        }
+        // keep cached blocks up to date
+        for (uint_fast32_t i = 0; i < vsf_local.block_num; i++) {
+            node = __vk_malfs_cache_lookup(cache, vsf_local.block_addr + i);
+            if (node != NULL) {
+                cache_buff = __vk_malfs_get_cache_buff(cache, node);
+                if (cache_buff != &vsf_local.buff[i * info->block_size]) {
+                    memcpy(cache_buff, &vsf_local.buff[i * info->block_size], info->block_size);
+                }
+#if VSF_MALFS_CFG_CACHE_WRITE_BACK == ENABLED
+                if (1 == vsf_local.block_num) {
+                    node->is_dirty = true;
+                    node->is_accessed = true;
+                    if (vsf_local.pinned != NULL) {
+                        __vk_malfs_cache_unpin(vsf_local.pinned);
+                    }
+                    __vk_malfs_cache_unlock(cache);
+                    vsf_eda_return(info->block_size);
+                    return;
+                }
+#endif
+                node->is_dirty = false;
             }
         }
+        vk_mal_write(info->mal, info->block_size * vsf_local.block_addr,
+                    info->block_size * vsf_local.block_num, vsf_local.buff);
+        break;
+    case VSF_EVT_RETURN:
+        if (vsf_local.pinned != NULL) {
+            __vk_malfs_cache_unpin(vsf_local.pinned);
+        }
+        __vk_malfs_cache_unlock(cache);
+        vsf_eda_return(vsf_eda_get_return_value());
         break;
     }
     vsf_peda_end();
 }
 
+__vsf_component_peda_private_entry(__vk_malfs_flush)
+{
+    vsf_peda_begin();
+    __vk_malfs_info_t *info = (__vk_malfs_info_t *)&vsf_this;
+    __vk_malfs_cache_t *cache = &info->cache;
+    vsf_err_t err = VSF_ERR_NONE;
+
+    switch (evt) {
+    case VSF_EVT_INIT:
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+        if (VSF_ERR_NONE != vsf_eda_mutex_enter(&cache->mutex)) {
+            break;
+        }
+        // fall through
+    case VSF_EVT_SYNC:
+#endif
+        goto flush_next;
+    case VSF_EVT_RETURN:
+        err = (vsf_err_t)vsf_eda_get_return_value();
+        if (err != VSF_ERR_NONE) {
+            goto do_return;
+        }
+    flush_next:
+#if VSF_MALFS_CFG_CACHE_WRITE_BACK == ENABLED
+        for (uint_fast16_t i = 0; i < cache->number; i++) {
+            if (cache->nodes[i].is_alloced && cache->nodes[i].is_dirty) {
+                __vsf_component_call_peda(__vk_malfs_cache_writeback, err, cache,
+                    .node       = &cache->nodes[i],
+                );
+                return;
+            }
+        }
+#endif
+        goto do_return;
+    }
+    return;
+do_return:
+    __vk_malfs_cache_unlock(cache);
+    vsf_eda_return(err);
+    vsf_peda_end();
+}
+
 #if     __IS_COMPILER_GCC__
 #   pragma GCC diagnostic pop
 #elif   __IS_COMPILER_LLVM__
 #   pragma clang diagnostic pop
 #endif
 
-vsf_err_t __vk_malfs_alloc_cache(__vk_malfs_info_t *info, __vk_malfs_cache_t *cache, uint_fast64_t block_addr)
+vsf_err_t __vk_malfs_read(__vk_malfs_info_t *info, uint_fast64_t block_addr, uint_fast32_t block_num, uint8_t *buff)
 {
     vsf_err_t err;
-    __vsf_component_call_peda(__vk_malfs_alloc_cache, err, cache,
+    __vsf_component_call_peda(__vk_malfs_read, err, info,
         .block_addr     = block_addr,
+        .block_num      = block_num,
+        .buff           = buff,
     )
     return err;
 }
 
-vsf_err_t __vk_malfs_read(__vk_malfs_info_t *info, uint_fast64_t block_addr, uint_fast32_t block_num, uint8_t *buff)
+vsf_err_t __vk_malfs_write(__vk_malfs_info_t *info, uint_fast64_t block_addr, uint_fast32_t block_num, uint8_t *buff)
 {
-    // TODO: add lock and unlock
     vsf_err_t err;
-    __vsf_component_call_peda(__vk_malfs_read, err, info,
+    __vsf_component_call_peda(__vk_malfs_write, err, info,
         .block_addr     = block_addr,
         .block_num      = block_num,
         .buff           = buff,
@@ -222,10 +547,18 @@ vsf_err_t __vk_malfs_read(__vk_malfs_info_t *info, uint_fast64_t block_addr, uin
     return err;
 }
 
-vsf_err_t __vk_malfs_write(__vk_malfs_info_t *info, uint_fast64_t block_addr, uint_fast32_t block_num, uint8_t *buff)
+void __vk_malfs_release(__vk_malfs_info_t *info, uint8_t *buff)
 {
-    // TODO: add lock and unlock
-    return vk_mal_write(info->mal, info->block_size * block_addr, info->block_size * block_num, buff);
+    __vk_malfs_cache_node_t *node = __vk_malfs_get_cache_node(&info->cache, buff);
+    VSF_FS_ASSERT(node != NULL);
+    __vk_malfs_cache_unpin(node);
+}
+
+vsf_err_t __vk_malfs_flush(__vk_malfs_info_t *info)
+{
+    vsf_err_t err;
+    __vsf_component_call_peda(__vk_malfs_flush, err, info)
+    return err;
 }
 
 #if VSF_USE_HEAP == ENABLED
@@ -306,7 +639,7 @@ __vsf_component_peda_private_entry(__vk_malfs_mount_mbr)
                     struct vk_malfs_fat_t {
                         vk_mim_mal_t fat_mal;
                         char root_name[6];
-                        implement_fatfs_info(512, 1);
+                        implement_fatfs_info(512, VSF_MALFS_CFG_MOUNT_CACHE_NUM);
                     };
                     typedef struct vk_malfs_fat_t vk_malfs_fat_t;
 
@@ -324,7 +657,7 @@ __vsf_component_peda_private_entry(__vk_malfs_mount_mbr)
                     malfs_fat->fat_mal.offset = le32_to_cpu(dpt->sectors_preceding) * 512;
                     malfs_fat->fat_mal.size = le32_to_cpu(dpt->sectors_in_partition) * 512;
                     malfs_fat->mal = &malfs_fat->fat_mal.use_as__vk_mal_t;
-                    init_fatfs_info_ex(malfs_fat, 512, 1, malfs_fat);
+                    init_fatfs_info_ex(malfs_fat, 512, VSF_MALFS_CFG_MOUNT_CACHE_NUM, malfs_fat);
 
                     mounter->mount_state = VSF_MOUNT_STATE_CREATE_ROOT;
                     strcpy(malfs_fat->root_name, "root");
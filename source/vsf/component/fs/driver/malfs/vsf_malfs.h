@@ -42,6 +42,23 @@ extern "C" {
 
 /*============================ MACROS ========================================*/
 
+// blocks updated in cache are written back to mal when evicted or flushed,
+//  instead of being written through immediately
+#ifndef VSF_MALFS_CFG_CACHE_WRITE_BACK
+#   define VSF_MALFS_CFG_CACHE_WRITE_BACK   ENABLED
+#endif
+
+// max number of blocks read into cache in one request when sequential access
+//  is detected, 1 to disable readahead
+#ifndef VSF_MALFS_CFG_CACHE_READAHEAD_NUM
+#   define VSF_MALFS_CFG_CACHE_READAHEAD_NUM    8
+#endif
+
+// number of cache blocks for each partition mounted by vk_malfs_mount_mbr
+#ifndef VSF_MALFS_CFG_MOUNT_CACHE_NUM
+#   define VSF_MALFS_CFG_MOUNT_CACHE_NUM    8
+#endif
+
 #define __implement_malfs_cache(__size, __number)                               \
     __vk_malfs_cache_node_t __cache_nodes[__number];                            \
     uint8_t __buffer[__size * __number];
@@ -56,9 +73,17 @@ dcl_simple_class(vk_malfs_mounter_t)
 
 typedef struct __vk_malfs_cache_node_t {
     uint64_t block_addr;
-    uint32_t access_time_sec    : 30;
-    uint32_t is_dirty           : 1;
-    uint32_t is_alloced         : 1;
+    // next node in the same hash bucket
+    uint16_t hash_next;
+    // first node in the hash bucket with the same index as this node
+    uint16_t hash_head;
+    uint16_t is_alloced         : 1;
+    uint16_t is_dirty           : 1;
+    // accessed since last passed by clock hand
+    uint16_t is_accessed        : 1;
+    // number of buffers returned by read with NULL buff and not yet written or released,
+    //  pinned node is never evicted or refilled by readahead
+    uint8_t pin_cnt;
 } __vk_malfs_cache_node_t;
 
 def_simple_class(__vk_malfs_cache_t) {
@@ -69,6 +94,12 @@ def_simple_class(__vk_malfs_cache_t) {
 
     private_member(
         __vk_malfs_info_t *info;
+        // next block to read if access is sequential
+        uint64_t seq_block_addr;
+        uint16_t clock_hand;
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+        vsf_mutex_t mutex;
+#endif
     )
 };
 
@@ -140,10 +171,17 @@ def_simple_class(vk_malfs_mounter_t) {
 
 extern void __vk_malfs_init(__vk_malfs_info_t *info);
 extern void __vk_malfs_cache_init(__vk_malfs_info_t *info, __vk_malfs_cache_t *cache);
-// read/write/get_cache will lock/unlock automatically
-extern vsf_err_t __vk_malfs_alloc_cache(__vk_malfs_info_t *info, __vk_malfs_cache_t *cache, uint_fast64_t block_addr);
+// read/write/flush will lock/unlock automatically
+// read with NULL buff returns the cache buffer of the block pinned in cache,
+//  it can be modified and written back to the same block by write, which also
+//  unpins the buffer, or should be unpinned by __vk_malfs_release if not written.
+// read with NULL buff returns NULL if all cache nodes are pinned.
 extern vsf_err_t __vk_malfs_read(__vk_malfs_info_t *info, uint_fast64_t block_addr, uint_fast32_t block_num, uint8_t *buff);
 extern vsf_err_t __vk_malfs_write(__vk_malfs_info_t *info, uint_fast64_t block_addr, uint_fast32_t block_num, uint8_t *buff);
+// unpin the cache buffer returned by read with NULL buff
+extern void __vk_malfs_release(__vk_malfs_info_t *info, uint8_t *buff);
+// write dirty blocks in cache to mal, should be called before unmount
+extern vsf_err_t __vk_malfs_flush(__vk_malfs_info_t *info);
 extern void __vk_malfs_unmount(__vk_malfs_info_t *info);
 
 #if VSF_USE_HEAP == ENABLED
@@ -99,6 +99,10 @@ __vsf_component_peda_ifs_entry(__vk_memfs_mount, vk_fs_mount)
     VSF_FS_ASSERT((fsinfo != NULL) && (fsinfo->root.d.child_size >= sizeof(vk_memfs_file_t)));
     fsinfo->root.attr = VSF_FILE_ATTR_DIRECTORY;
     __vk_memfs_init(fsinfo, &fsinfo->root);
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+    // entries of previous memfs in the same memory
+    vk_fs_dcache_invalidate_all((void *)&vk_memfs_op);
+#endif
     dir->subfs.root = &fsinfo->root.use_as__vk_file_t;
     vsf_eda_return(VSF_ERR_NONE);
     vsf_peda_end();
@@ -113,6 +117,16 @@ __vsf_component_peda_ifs_entry(__vk_memfs_lookup, vk_file_lookup)
     uint_fast32_t idx = vsf_local.idx;
     bool found = false;
 
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+    uint64_t value;
+    if ((name != NULL) && vk_fs_dcache_lookup((void *)&vk_memfs_op, (uintptr_t)dir, name, &value)) {
+        child = (vk_memfs_file_t *)(uintptr_t)value;
+        found = child != NULL;
+        goto do_return;
+    }
+    uint32_t generation = vk_fs_dcache_get_generation((void *)&vk_memfs_op, (uintptr_t)dir);
+#endif
+
     for (uint_fast16_t i = 0; i < dir->d.child_num; i++) {
         if (    (name && vk_file_is_match((char *)name, child->name))
             ||  (!name && !idx)) {
@@ -122,7 +136,13 @@ __vsf_component_peda_ifs_entry(__vk_memfs_lookup, vk_file_lookup)
         idx--;
         child = (vk_memfs_file_t *)((uintptr_t)child + dir->d.child_size);
     }
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+    if (name != NULL) {
+        vk_fs_dcache_add((void *)&vk_memfs_op, (uintptr_t)dir, name, found ? (uintptr_t)child : 0, generation);
+    }
 
+do_return:
+#endif
     if (found) {
         *vsf_local.result = &child->use_as__vk_file_t;
         vsf_eda_return(VSF_ERR_NONE);
@@ -40,13 +40,39 @@
 
 //#define VSF_FS_REF_TRACE            ENABLED
 
+#define VSF_FS_DENTRY_NONE          0xFFFF
+// number of generation counters, directories are hashed to them
+#define VSF_FS_DENTRY_GEN_NUM       16
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
 
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+typedef struct __vk_fs_dentry_t {
+    vsf_dlist_node_t lru_node;
+    void *fs;
+    uintptr_t dir;
+    uint64_t value;
+    uint32_t hash;
+    uint16_t hash_next;
+    char name[VSF_FS_CFG_DENTRY_CACHE_NAME_LEN];
+} __vk_fs_dentry_t;
+#endif
+
 typedef struct __vk_fs_t {
     struct {
         vsf_crit_t lock;
     } open;
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+    struct {
+        // most recently used first, unused entries at tail
+        vsf_dlist_t lru_list;
+        uint16_t bucket[VSF_FS_CFG_DENTRY_CACHE_NUM];
+        __vk_fs_dentry_t entries[VSF_FS_CFG_DENTRY_CACHE_NUM];
+        // increased when entries of directories hashed here are invalidated
+        uint32_t generation[VSF_FS_DENTRY_GEN_NUM];
+    } dcache;
+#endif
     vk_vfs_file_t rootfs;
 } __vk_fs_t;
 
@@ -235,12 +261,241 @@ vk_file_t * __vk_file_get_fs_parent(vk_file_t *file)
     return parent;
 }
 
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+static void __vk_fs_dcache_init(void)
+{
+    vsf_dlist_init(&__vk_fs.dcache.lru_list);
+    for (uint_fast16_t i = 0; i < VSF_FS_CFG_DENTRY_CACHE_NUM; i++) {
+        __vk_fs.dcache.bucket[i] = VSF_FS_DENTRY_NONE;
+        vsf_dlist_add_to_tail(__vk_fs_dentry_t, lru_node, &__vk_fs.dcache.lru_list, &__vk_fs.dcache.entries[i]);
+    }
+}
+
+static char __vk_fs_dcache_fold(char ch)
+{
+    return ((ch >= 'A') && (ch <= 'Z')) ? ch - 'A' + 'a' : ch;
+}
+
+// length of the first path component, 0 if it can not be cached
+static uint_fast16_t __vk_fs_dcache_get_namelen(const char *name)
+{
+    const char *ptr = name;
+    while ((*ptr != '\0') && !vk_file_is_div(*ptr)) {
+        ptr++;
+    }
+    return (ptr - name < VSF_FS_CFG_DENTRY_CACHE_NAME_LEN) ? ptr - name : 0;
+}
+
+// FNV-1a on case folded name, so all cases of a name are in the same bucket
+static uint32_t __vk_fs_dcache_hash(void *fs, uintptr_t dir, const char *name, uint_fast16_t len)
+{
+    uint32_t hash = 2166136261UL ^ (uint32_t)(uintptr_t)fs;
+    hash = (hash * 16777619UL) ^ (uint32_t)dir;
+    while (len-- > 0) {
+        hash = (hash * 16777619UL) ^ (uint8_t)__vk_fs_dcache_fold(*name++);
+    }
+    return hash;
+}
+
+static uint32_t * __vk_fs_dcache_generation(void *fs, uintptr_t dir)
+{
+    return &__vk_fs.dcache.generation[__vk_fs_dcache_hash(fs, dir, NULL, 0) % VSF_FS_DENTRY_GEN_NUM];
+}
+
+static bool __vk_fs_dcache_is_match(__vk_fs_dentry_t *dentry, const char *name, uint_fast16_t len, bool is_nocase)
+{
+    if (dentry->name[len] != '\0') {
+        return false;
+    }
+    if (!is_nocase) {
+        return !memcmp(dentry->name, name, len);
+    }
+    for (uint_fast16_t i = 0; i < len; i++) {
+        if (__vk_fs_dcache_fold(dentry->name[i]) != __vk_fs_dcache_fold(name[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static __vk_fs_dentry_t * __vk_fs_dcache_find(void *fs, uintptr_t dir, const char *name, uint_fast16_t len, uint32_t hash)
+{
+    uint_fast16_t idx = __vk_fs.dcache.bucket[hash % VSF_FS_CFG_DENTRY_CACHE_NUM];
+    __vk_fs_dentry_t *dentry;
+
+    while (idx != VSF_FS_DENTRY_NONE) {
+        dentry = &__vk_fs.dcache.entries[idx];
+        if (    (dentry->hash == hash) && (dentry->fs == fs) && (dentry->dir == dir)
+            &&  __vk_fs_dcache_is_match(dentry, name, len, false)) {
+            return dentry;
+        }
+        idx = dentry->hash_next;
+    }
+    return NULL;
+}
+
+static void __vk_fs_dcache_unhash(__vk_fs_dentry_t *dentry)
+{
+    uint16_t *link = &__vk_fs.dcache.bucket[dentry->hash % VSF_FS_CFG_DENTRY_CACHE_NUM];
+    uint_fast16_t idx = dentry - __vk_fs.dcache.entries;
+
+    while (*link != VSF_FS_DENTRY_NONE) {
+        if (*link == idx) {
+            *link = dentry->hash_next;
+            break;
+        }
+        link = &__vk_fs.dcache.entries[*link].hash_next;
+    }
+    dentry->fs = NULL;
+}
+
+static void __vk_fs_dcache_remove(__vk_fs_dentry_t *dentry)
+{
+    __vk_fs_dcache_unhash(dentry);
+    vsf_dlist_remove(__vk_fs_dentry_t, lru_node, &__vk_fs.dcache.lru_list, dentry);
+    vsf_dlist_add_to_tail(__vk_fs_dentry_t, lru_node, &__vk_fs.dcache.lru_list, dentry);
+}
+
+bool vk_fs_dcache_lookup(void *fs, uintptr_t dir, const char *name, uint64_t *value)
+{
+    uint_fast16_t len = __vk_fs_dcache_get_namelen(name);
+    __vk_fs_dentry_t *dentry;
+    uint32_t hash;
+
+    VSF_FS_ASSERT((fs != NULL) && (value != NULL));
+    if (!len) {
+        return false;
+    }
+
+    hash = __vk_fs_dcache_hash(fs, dir, name, len);
+    vsf_protect_t orig = vsf_protect_sched();
+        dentry = __vk_fs_dcache_find(fs, dir, name, len, hash);
+        if (dentry != NULL) {
+            *value = dentry->value;
+            vsf_dlist_remove(__vk_fs_dentry_t, lru_node, &__vk_fs.dcache.lru_list, dentry);
+            vsf_dlist_add_to_head(__vk_fs_dentry_t, lru_node, &__vk_fs.dcache.lru_list, dentry);
+        }
+    vsf_unprotect_sched(orig);
+    return dentry != NULL;
+}
+
+uint32_t vk_fs_dcache_get_generation(void *fs, uintptr_t dir)
+{
+    uint32_t generation;
+
+    vsf_protect_t orig = vsf_protect_sched();
+        generation = *__vk_fs_dcache_generation(fs, dir);
+    vsf_unprotect_sched(orig);
+    return generation;
+}
+
+void vk_fs_dcache_add(void *fs, uintptr_t dir, const char *name, uint64_t value, uint32_t generation)
+{
+    uint_fast16_t len = __vk_fs_dcache_get_namelen(name);
+    __vk_fs_dentry_t *dentry;
+    uint32_t hash;
+
+    VSF_FS_ASSERT(fs != NULL);
+    if (!len) {
+        return;
+    }
+
+    hash = __vk_fs_dcache_hash(fs, dir, name, len);
+    vsf_protect_t orig = vsf_protect_sched();
+        // dir is changed while looking up, result of the lookup may be out of date
+        if (*__vk_fs_dcache_generation(fs, dir) != generation) {
+            vsf_unprotect_sched(orig);
+            return;
+        }
+
+        dentry = __vk_fs_dcache_find(fs, dir, name, len, hash);
+        if (NULL == dentry) {
+            // least recently used or unused entry
+            vsf_dlist_remove_tail(__vk_fs_dentry_t, lru_node, &__vk_fs.dcache.lru_list, dentry);
+            if (dentry->fs != NULL) {
+                __vk_fs_dcache_unhash(dentry);
+            }
+
+            dentry->fs = fs;
+            dentry->dir = dir;
+            dentry->hash = hash;
+            memcpy(dentry->name, name, len);
+            dentry->name[len] = '\0';
+            dentry->hash_next = __vk_fs.dcache.bucket[hash % VSF_FS_CFG_DENTRY_CACHE_NUM];
+            __vk_fs.dcache.bucket[hash % VSF_FS_CFG_DENTRY_CACHE_NUM] = dentry - __vk_fs.dcache.entries;
+        } else {
+            vsf_dlist_remove(__vk_fs_dentry_t, lru_node, &__vk_fs.dcache.lru_list, dentry);
+        }
+        dentry->value = value;
+        vsf_dlist_add_to_head(__vk_fs_dentry_t, lru_node, &__vk_fs.dcache.lru_list, dentry);
+    vsf_unprotect_sched(orig);
+}
+
+void vk_fs_dcache_invalidate(void *fs, uintptr_t dir, const char *name)
+{
+    uint_fast16_t len = __vk_fs_dcache_get_namelen(name), idx;
+    __vk_fs_dentry_t *dentry;
+    uint32_t hash;
+
+    if (!len) {
+        return;
+    }
+
+    hash = __vk_fs_dcache_hash(fs, dir, name, len);
+    vsf_protect_t orig = vsf_protect_sched();
+        (*__vk_fs_dcache_generation(fs, dir))++;
+        idx = __vk_fs.dcache.bucket[hash % VSF_FS_CFG_DENTRY_CACHE_NUM];
+        while (idx != VSF_FS_DENTRY_NONE) {
+            dentry = &__vk_fs.dcache.entries[idx];
+            idx = dentry->hash_next;
+            if (    (dentry->hash == hash) && (dentry->fs == fs) && (dentry->dir == dir)
+                &&  __vk_fs_dcache_is_match(dentry, name, len, true)) {
+                __vk_fs_dcache_remove(dentry);
+            }
+        }
+    vsf_unprotect_sched(orig);
+}
+
+static void __vk_fs_dcache_invalidate(void *fs, uintptr_t dir, bool is_all)
+{
+    __vk_fs_dentry_t *dentry = __vk_fs.dcache.entries;
+
+    vsf_protect_t orig = vsf_protect_sched();
+        if (is_all) {
+            for (uint_fast16_t i = 0; i < VSF_FS_DENTRY_GEN_NUM; i++) {
+                __vk_fs.dcache.generation[i]++;
+            }
+        } else {
+            (*__vk_fs_dcache_generation(fs, dir))++;
+        }
+        for (uint_fast16_t i = 0; i < VSF_FS_CFG_DENTRY_CACHE_NUM; i++, dentry++) {
+            if ((dentry->fs == fs) && (is_all || (dentry->dir == dir))) {
+                __vk_fs_dcache_remove(dentry);
+            }
+        }
+    vsf_unprotect_sched(orig);
+}
+
+void vk_fs_dcache_invalidate_dir(void *fs, uintptr_t dir)
+{
+    __vk_fs_dcache_invalidate(fs, dir, false);
+}
+
+void vk_fs_dcache_invalidate_all(void *fs)
+{
+    __vk_fs_dcache_invalidate(fs, 0, true);
+}
+#endif
+
 void vk_fs_init(void)
 {
     memset(&__vk_fs, 0, sizeof(__vk_fs));
     __vk_fs.rootfs.attr = VSF_FILE_ATTR_DIRECTORY;
     __vk_fs.rootfs.fsop = &vk_vfs_op;
     vsf_eda_crit_init(&__vk_fs.open.lock);
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+    __vk_fs_dcache_init();
+#endif
 }
 
 #if     __IS_COMPILER_GCC__
@@ -535,6 +790,20 @@ vsf_err_t vk_file_write(vk_file_t *file, uint_fast64_t addr, uint_fast32_t size,
     return err;
 }
 
+vsf_err_t vk_file_resize(vk_file_t *file, uint_fast64_t size)
+{
+    vsf_err_t err;
+    VSF_FS_ASSERT(file != NULL);
+    VSF_FS_ASSERT(file->attr & VSF_FILE_ATTR_WRITE);
+    VSF_FS_ASSERT(file->fsop != NULL);
+    VSF_FS_ASSERT(file->fsop->fop.fn_resize != NULL);
+
+    __vsf_component_call_peda_ifs(vk_file_resize, err, file->fsop->fop.fn_resize, file->fsop->fop.resize_local_size, file,
+        .size       = size,
+    );
+    return err;
+}
+
 vsf_err_t vk_file_create(vk_file_t *dir, const char *name, vk_file_attr_t attr, uint_fast64_t size)
 {
     vsf_err_t err;
@@ -592,13 +861,28 @@ static vk_vfs_file_t * __vk_vfs_lookup_imp(vk_vfs_file_t *dir, const char *name,
 {
     vk_vfs_file_t *child;
     uint32_t tmp_idx;
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+    uint32_t generation;
+#endif
 
     if (NULL == idx) {
         VSF_FS_ASSERT(name != NULL);
         idx = &tmp_idx;
     }
 
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+    if (name != NULL) {
+        uint64_t value;
+        if (vk_fs_dcache_lookup(&__vk_fs, (uintptr_t)dir, name, &value)) {
+            return (vk_vfs_file_t *)(uintptr_t)value;
+        }
+    }
+#endif
+
     vsf_protect_t orig = vsf_protect_sched();
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+        generation = *__vk_fs_dcache_generation(&__vk_fs, (uintptr_t)dir);
+#endif
         vsf_dlist_peek_head(vk_vfs_file_t, use_as__vsf_dlist_node_t, &dir->d.child_list, child);
         while (child != NULL) {
             if (    (name && vk_file_is_match((char *)name, child->name))
@@ -609,6 +893,12 @@ static vk_vfs_file_t * __vk_vfs_lookup_imp(vk_vfs_file_t *dir, const char *name,
             vsf_dlist_peek_next(vk_vfs_file_t, use_as__vsf_dlist_node_t, child, child);
         }
     vsf_unprotect_sched(orig);
+
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+    if (name != NULL) {
+        vk_fs_dcache_add(&__vk_fs, (uintptr_t)dir, name, (uintptr_t)child, generation);
+    }
+#endif
     return child;
 }
 
@@ -704,10 +994,29 @@ __vsf_component_peda_ifs_entry(__vk_vfs_create, vk_file_create)
 {
     vsf_peda_begin();
     vk_vfs_file_t *dir = (vk_vfs_file_t *)&vsf_this;
-    vk_vfs_file_t *new_file = __vk_vfs_lookup_imp(dir, vsf_local.name, NULL);
+    vk_vfs_file_t *new_file;
     vsf_protect_t orig;
     vsf_err_t err = VSF_ERR_NONE;
 
+    if (VSF_EVT_RETURN == evt) {
+        err = (vsf_err_t)vsf_eda_get_return_value();
+        goto do_return;
+    }
+    if (dir->attr & VSF_VFS_FILE_ATTR_MOUNTED) {
+        VSF_FS_ASSERT(dir->subfs.op->dop.fn_create != NULL);
+        __vsf_component_call_peda_ifs(vk_file_create, err, dir->subfs.op->dop.fn_create, dir->subfs.op->dop.create_local_size, dir->subfs.root,
+            .name   = vsf_local.name,
+            .attr   = vsf_local.attr,
+            .size   = vsf_local.size,
+        );
+        if (VSF_ERR_NONE == err) {
+            return;
+        }
+        err = VSF_ERR_NOT_ENOUGH_RESOURCES;
+        goto do_return;
+    }
+
+    new_file = __vk_vfs_lookup_imp(dir, vsf_local.name, NULL);
     if (new_file != NULL) {
         err = VSF_ERR_ALREADY_EXISTS;
         goto do_return;
@@ -726,6 +1035,9 @@ __vsf_component_peda_ifs_entry(__vk_vfs_create, vk_file_create)
     orig = vsf_protect_sched();
         vsf_dlist_add_to_tail(vk_vfs_file_t, use_as__vsf_dlist_node_t, &dir->d.child_list, new_file);
     vsf_unprotect_sched(orig);
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+    vk_fs_dcache_invalidate(&__vk_fs, (uintptr_t)dir, new_file->name);
+#endif
     // avoid to be freed
 #if VSF_FS_REF_TRACE == ENABLED
     vsf_trace_debug("create vfs %s" VSF_TRACE_CFG_LINEEND, new_file->name);
@@ -763,10 +1075,18 @@ __vsf_component_peda_ifs_entry(__vk_vfs_unlink, vk_file_unlink)
                 vsf_protect_t orig = vsf_protect_sched();
                     vsf_dlist_remove(vk_vfs_file_t, use_as__vsf_dlist_node_t, &dir->d.child_list, child);
                 vsf_unprotect_sched(orig);
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+                vk_fs_dcache_invalidate(&__vk_fs, (uintptr_t)dir, child->name);
+                if (child->attr & VSF_FILE_ATTR_DIRECTORY) {
+                    vk_fs_dcache_invalidate_dir(&__vk_fs, (uintptr_t)child);
+                }
+#endif
                 vk_file_free(&child->use_as__vk_file_t);
             }
             err = (NULL == child) ? VSF_ERR_NOT_AVAILABLE : VSF_ERR_NONE;
         }
+        vsf_eda_return(err);
+        break;
     case VSF_EVT_RETURN:
         if (dir->attr & VSF_VFS_FILE_ATTR_MOUNTED) {
             err = (vsf_err_t)vsf_eda_get_return_value();
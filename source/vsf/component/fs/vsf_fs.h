@@ -54,6 +54,20 @@ extern "C" {
 #   define VSF_FS_CFG_TIME              ENABLED
 #endif
 
+// cache of names looked up by fs drivers, including names not found
+#ifndef VSF_FS_CFG_DENTRY_CACHE
+#   define VSF_FS_CFG_DENTRY_CACHE      DISABLED
+#endif
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+#   ifndef VSF_FS_CFG_DENTRY_CACHE_NUM
+#       define VSF_FS_CFG_DENTRY_CACHE_NUM          64
+#   endif
+// names not shorter than this are not cached
+#   ifndef VSF_FS_CFG_DENTRY_CACHE_NAME_LEN
+#       define VSF_FS_CFG_DENTRY_CACHE_NAME_LEN     32
+#   endif
+#endif
+
 #if defined(VSF_FS_CFG_MALLOC) && !defined(VSF_FS_CFG_FREE)
 #   error VSF_FS_CFG_FREE must be defined
 #endif
@@ -253,6 +267,9 @@ __vsf_component_peda_ifs(vk_file_write,
     uint32_t        size;
     uint8_t         *buff;
 )
+__vsf_component_peda_ifs(vk_file_resize,
+    uint64_t        size;
+)
 __vsf_component_peda_ifs(vk_file_close)
 __vsf_component_peda_ifs(vk_file_sync)
 #endif
@@ -278,6 +295,7 @@ extern vsf_err_t vk_file_unlink(vk_file_t *dir, const char *name);
 extern vsf_err_t vk_file_close(vk_file_t *file);
 extern vsf_err_t vk_file_read(vk_file_t *file, uint_fast64_t addr, uint_fast32_t size, uint8_t *buff);
 extern vsf_err_t vk_file_write(vk_file_t *file, uint_fast64_t addr, uint_fast32_t size, uint8_t *buff);
+extern vsf_err_t vk_file_resize(vk_file_t *file, uint_fast64_t size);
 #if VSF_FS_CFG_USE_CACHE == ENABLED
 extern vsf_err_t vk_file_sync(vk_file_t *file);
 #endif
@@ -297,6 +315,21 @@ extern void vk_file_free(vk_file_t *file);
 
 extern void vk_fs_return(vk_file_t *file, vsf_err_t err);
 
+#if VSF_FS_CFG_DENTRY_CACHE == ENABLED
+// dentry cache for fs drivers, entries are keyed by fs, dir and the first
+//  path component of name, and recycled in LRU order
+// value is defined by fs driver, 0 means that the name does not exist
+extern bool vk_fs_dcache_lookup(void *fs, uintptr_t dir, const char *name, uint64_t *value);
+// get generation of dir before scanning dir for name, and pass it to
+//  vk_fs_dcache_add, the add is dropped if dir is invalidated in between
+extern uint32_t vk_fs_dcache_get_generation(void *fs, uintptr_t dir);
+extern void vk_fs_dcache_add(void *fs, uintptr_t dir, const char *name, uint64_t value, uint32_t generation);
+// name is compared case-insensitively for invalidation
+extern void vk_fs_dcache_invalidate(void *fs, uintptr_t dir, const char *name);
+extern void vk_fs_dcache_invalidate_dir(void *fs, uintptr_t dir);
+extern void vk_fs_dcache_invalidate_all(void *fs);
+#endif
+
 dcl_vsf_peda_methods(extern, vk_dummyfs_succeed)
 dcl_vsf_peda_methods(extern, vk_dummyfs_not_support)
 #endif
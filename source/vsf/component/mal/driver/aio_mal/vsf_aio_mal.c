@@ -0,0 +1,752 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+/*============================ INCLUDES ======================================*/
+
+// for O_DIRECT, MUST be defined before any header of host
+#ifndef _GNU_SOURCE
+#   define _GNU_SOURCE
+#endif
+
+#include "../../vsf_mal_cfg.h"
+
+#if VSF_USE_MAL == ENABLED && VSF_MAL_USE_AIO_MAL == ENABLED
+
+#define __VSF_MAL_CLASS_INHERIT__
+#define __VSF_AIO_MAL_CLASS_IMPLEMENT
+
+#include "../../vsf_mal.h"
+#include "./vsf_aio_mal.h"
+
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#if VSF_AIO_MAL_CFG_IO_URING == ENABLED
+#   include <sys/mman.h>
+#   include <linux/io_uring.h>
+#   if VSF_ARCH_CFG_EPOLL == ENABLED
+#       include <sys/epoll.h>
+#       include <sys/eventfd.h>
+#   endif
+#endif
+
+/*============================ MACROS ========================================*/
+
+#if VSF_KERNEL_CFG_SUPPORT_SYNC != ENABLED
+#   error VSF_KERNEL_CFG_SUPPORT_SYNC is needed to use aio_mal
+#endif
+
+#if VSF_AIO_MAL_CFG_QUEUE_DEPTH > VSF_SYNC_MAX
+#   error VSF_AIO_MAL_CFG_QUEUE_DEPTH is too large
+#endif
+
+#if VSF_AIO_MAL_CFG_DEBUG == ENABLED
+#   define __vk_aio_mal_trace(...)                                              \
+            vsf_trace_debug("aio_mal: " __VA_ARGS__)
+#else
+#   define __vk_aio_mal_trace(...)
+#endif
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+
+enum {
+    // all host threads of the aio_mal exited
+    VSF_EVT_AIO_MAL_EXITED      = VSF_EVT_USER + 0,
+};
+
+typedef struct __vk_aio_mal_req_t {
+    vsf_eda_t *eda;
+    uint8_t *buff;
+    // buffer used by host, buff or bounce
+    uint8_t *xfer;
+    // aligned buffer for O_DIRECT if buff is not aligned
+    uint8_t *bounce;
+    uint32_t bounce_size;
+    uint32_t size;
+    uint64_t addr;
+    int32_t result;
+    bool is_write;
+    bool is_busy;
+} __vk_aio_mal_req_t;
+
+typedef struct __vk_aio_mal_worker_t {
+    vsf_arch_irq_thread_t irq_thread;
+    struct __vk_aio_mal_ctx_t *ctx;
+} __vk_aio_mal_worker_t;
+
+typedef struct __vk_aio_mal_ctx_t {
+    vk_aio_mal_t *mal;
+    int fd;
+    bool is_uring;
+    // running host threads
+    uint8_t thread_num;
+    // protect the submission queue shared with host threads
+    pthread_mutex_t lock;
+
+#if VSF_AIO_MAL_CFG_IO_URING == ENABLED
+    struct {
+        int fd;
+        void *sq_ring;
+        void *cq_ring;
+        size_t sq_ring_size;
+        size_t cq_ring_size;
+        struct io_uring_sqe *sqes;
+        size_t sqes_size;
+        unsigned *sq_tail;
+        unsigned *sq_mask;
+        unsigned *sq_array;
+        unsigned *cq_head;
+        unsigned *cq_tail;
+        unsigned *cq_mask;
+        struct io_uring_cqe *cqes;
+#   if VSF_ARCH_CFG_EPOLL == ENABLED
+        // eventfd signaled on completion
+        vsf_arch_epoll_source_t source;
+#   else
+        __vk_aio_mal_worker_t worker;
+#   endif
+    } uring;
+#endif
+
+    struct {
+        pthread_cond_t cond;
+        bool is_exiting;
+        uint32_t head;
+        uint32_t tail;
+        __vk_aio_mal_req_t *pending[VSF_AIO_MAL_CFG_QUEUE_DEPTH];
+        __vk_aio_mal_worker_t worker[VSF_AIO_MAL_CFG_THREAD_NUM];
+    } pool;
+
+    __vk_aio_mal_req_t req[VSF_AIO_MAL_CFG_QUEUE_DEPTH];
+} __vk_aio_mal_ctx_t;
+
+/*============================ PROTOTYPES ====================================*/
+
+static uint_fast32_t __vk_aio_mal_blksz(vk_mal_t *mal, uint_fast64_t addr, uint_fast32_t size, vsf_mal_op_t op);
+dcl_vsf_peda_methods(static, __vk_aio_mal_init)
+dcl_vsf_peda_methods(static, __vk_aio_mal_fini)
+dcl_vsf_peda_methods(static, __vk_aio_mal_read)
+dcl_vsf_peda_methods(static, __vk_aio_mal_write)
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+#if     __IS_COMPILER_GCC__
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wcast-function-type"
+#endif
+
+const vk_mal_drv_t vk_aio_mal_drv = {
+    .blksz          = __vk_aio_mal_blksz,
+    .init           = (vsf_peda_evthandler_t)vsf_peda_func(__vk_aio_mal_init),
+    .fini           = (vsf_peda_evthandler_t)vsf_peda_func(__vk_aio_mal_fini),
+    .read           = (vsf_peda_evthandler_t)vsf_peda_func(__vk_aio_mal_read),
+    .write          = (vsf_peda_evthandler_t)vsf_peda_func(__vk_aio_mal_write),
+};
+
+#if     __IS_COMPILER_GCC__
+#   pragma GCC diagnostic pop
+#endif
+
+/*============================ LOCAL VARIABLES ===============================*/
+/*============================ IMPLEMENTATION ================================*/
+
+static uint_fast32_t __vk_aio_mal_blksz(vk_mal_t *mal, uint_fast64_t addr, uint_fast32_t size, vsf_mal_op_t op)
+{
+    return ((vk_aio_mal_t *)mal)->block_size;
+}
+
+bool vk_aio_mal_is_uring(vk_aio_mal_t *pthis)
+{
+    VSF_MAL_ASSERT((pthis != NULL) && (pthis->ctx != NULL));
+    return ((__vk_aio_mal_ctx_t *)pthis->ctx)->is_uring;
+}
+
+// called in irq context of host thread
+static void __vk_aio_mal_complete(__vk_aio_mal_req_t *req, int32_t result)
+{
+    req->result = result;
+    vsf_eda_post_msg(req->eda, req);
+}
+
+// called in irq context of host thread
+static void __vk_aio_mal_on_exited(__vk_aio_mal_ctx_t *ctx)
+{
+    bool is_all_exited;
+
+    pthread_mutex_lock(&ctx->lock);
+        is_all_exited = !--ctx->thread_num;
+    pthread_mutex_unlock(&ctx->lock);
+    if (is_all_exited) {
+        vsf_eda_post_evt(ctx->mal->fini_eda, VSF_EVT_AIO_MAL_EXITED);
+    }
+}
+
+/*----------------------------------------------------------------------------*
+ * thread pool                                                                *
+ *----------------------------------------------------------------------------*/
+
+static int32_t __vk_aio_mal_pool_do(__vk_aio_mal_ctx_t *ctx, __vk_aio_mal_req_t *req)
+{
+    uint8_t *buff = req->xfer;
+    uint64_t addr = req->addr;
+    uint32_t remain = req->size;
+    ssize_t cur_size;
+
+    while (remain > 0) {
+        if (req->is_write) {
+            cur_size = pwrite(ctx->fd, buff, remain, (off_t)addr);
+        } else {
+            cur_size = pread(ctx->fd, buff, remain, (off_t)addr);
+        }
+        if (cur_size <= 0) {
+            if ((cur_size < 0) && (EINTR == errno)) {
+                continue;
+            }
+            return VSF_ERR_FAIL;
+        }
+        buff += cur_size;
+        addr += cur_size;
+        remain -= cur_size;
+    }
+    return req->size;
+}
+
+static void __vk_aio_mal_pool_thread(void *arg)
+{
+    __vk_aio_mal_worker_t *worker = container_of(arg, __vk_aio_mal_worker_t, irq_thread);
+    __vk_aio_mal_ctx_t *ctx = worker->ctx;
+    __vk_aio_mal_req_t *req;
+    int32_t result;
+
+    __vsf_arch_irq_set_background(&worker->irq_thread);
+    while (1) {
+        pthread_mutex_lock(&ctx->lock);
+            while (!ctx->pool.is_exiting && (ctx->pool.head == ctx->pool.tail)) {
+                pthread_cond_wait(&ctx->pool.cond, &ctx->lock);
+            }
+            if (ctx->pool.head == ctx->pool.tail) {
+                pthread_mutex_unlock(&ctx->lock);
+                break;
+            }
+            req = ctx->pool.pending[ctx->pool.head++ % dimof(ctx->pool.pending)];
+        pthread_mutex_unlock(&ctx->lock);
+
+        result = __vk_aio_mal_pool_do(ctx, req);
+        __vsf_arch_irq_start(&worker->irq_thread);
+            __vk_aio_mal_complete(req, result);
+        __vsf_arch_irq_end(&worker->irq_thread, false);
+    }
+
+    __vsf_arch_irq_start(&worker->irq_thread);
+        __vk_aio_mal_on_exited(ctx);
+    __vsf_arch_irq_end(&worker->irq_thread, false);
+    __vsf_arch_irq_fini(&worker->irq_thread);
+}
+
+static vsf_err_t __vk_aio_mal_pool_init(__vk_aio_mal_ctx_t *ctx)
+{
+    if (pthread_cond_init(&ctx->pool.cond, NULL) != 0) {
+        return VSF_ERR_FAIL;
+    }
+    ctx->pool.is_exiting = false;
+    ctx->pool.head = ctx->pool.tail = 0;
+    ctx->thread_num = dimof(ctx->pool.worker);
+    for (uint_fast8_t i = 0; i < dimof(ctx->pool.worker); i++) {
+        ctx->pool.worker[i].ctx = ctx;
+        __vsf_arch_irq_init(&ctx->pool.worker[i].irq_thread, "aio_mal",
+                    __vk_aio_mal_pool_thread, vsf_arch_prio_0);
+    }
+    return VSF_ERR_NONE;
+}
+
+static vsf_err_t __vk_aio_mal_pool_submit(__vk_aio_mal_ctx_t *ctx, __vk_aio_mal_req_t *req)
+{
+    pthread_mutex_lock(&ctx->lock);
+        ctx->pool.pending[ctx->pool.tail++ % dimof(ctx->pool.pending)] = req;
+    pthread_mutex_unlock(&ctx->lock);
+    pthread_cond_signal(&ctx->pool.cond);
+    return VSF_ERR_NONE;
+}
+
+static void __vk_aio_mal_pool_exit(__vk_aio_mal_ctx_t *ctx)
+{
+    pthread_mutex_lock(&ctx->lock);
+        ctx->pool.is_exiting = true;
+    pthread_mutex_unlock(&ctx->lock);
+    pthread_cond_broadcast(&ctx->pool.cond);
+}
+
+/*----------------------------------------------------------------------------*
+ * io_uring                                                                   *
+ *----------------------------------------------------------------------------*/
+
+#if VSF_AIO_MAL_CFG_IO_URING == ENABLED
+static int __vk_aio_mal_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+// reap completions, return false if the exit request is reaped
+static bool __vk_aio_mal_uring_reap(__vk_aio_mal_ctx_t *ctx)
+{
+    unsigned head = *ctx->uring.cq_head;
+    unsigned tail = __atomic_load_n(ctx->uring.cq_tail, __ATOMIC_ACQUIRE);
+    struct io_uring_cqe *cqe;
+    bool is_running = true;
+
+    while (head != tail) {
+        cqe = &ctx->uring.cqes[head & *ctx->uring.cq_mask];
+        if (0 == cqe->user_data) {
+            is_running = false;
+        } else {
+            __vk_aio_mal_req_t *req = (__vk_aio_mal_req_t *)(uintptr_t)cqe->user_data;
+            // short transfer is not expected on regular files
+            __vk_aio_mal_complete(req, cqe->res == (int32_t)req->size ? cqe->res : VSF_ERR_FAIL);
+        }
+        head++;
+    }
+    __atomic_store_n(ctx->uring.cq_head, head, __ATOMIC_RELEASE);
+    return is_running;
+}
+
+#   if VSF_ARCH_CFG_EPOLL == ENABLED
+static void __vk_aio_mal_uring_on_eventfd(vsf_arch_epoll_source_t *source, uint32_t events)
+{
+    __vk_aio_mal_ctx_t *ctx = container_of(source, __vk_aio_mal_ctx_t, uring.source);
+    uint64_t cnt;
+
+    // eventfd is non-blocking, read to clear it before reaping
+    if (read(source->fd, &cnt, sizeof(cnt)) == sizeof(cnt)) {
+        __vk_aio_mal_uring_reap(ctx);
+    }
+}
+#   else
+static void __vk_aio_mal_uring_thread(void *arg)
+{
+    __vk_aio_mal_worker_t *worker = container_of(arg, __vk_aio_mal_worker_t, irq_thread);
+    __vk_aio_mal_ctx_t *ctx = worker->ctx;
+    bool is_running = true;
+
+    __vsf_arch_irq_set_background(&worker->irq_thread);
+    while (is_running) {
+        if (__vk_aio_mal_uring_enter(ctx->uring.fd, 0, 1, IORING_ENTER_GETEVENTS) < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+        }
+
+        __vsf_arch_irq_start(&worker->irq_thread);
+            is_running = __vk_aio_mal_uring_reap(ctx);
+            if (!is_running) {
+                __vk_aio_mal_on_exited(ctx);
+            }
+        __vsf_arch_irq_end(&worker->irq_thread, false);
+    }
+    __vsf_arch_irq_fini(&worker->irq_thread);
+}
+#   endif
+
+static vsf_err_t __vk_aio_mal_uring_submit_sqe(__vk_aio_mal_ctx_t *ctx, uint8_t opcode,
+            uint64_t addr, uint32_t size, uint8_t *buff, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe;
+    unsigned tail, idx;
+    int ret;
+
+    pthread_mutex_lock(&ctx->lock);
+        tail = *ctx->uring.sq_tail;
+        idx = tail & *ctx->uring.sq_mask;
+        sqe = &ctx->uring.sqes[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->fd = ctx->fd;
+        sqe->off = addr;
+        sqe->addr = (uintptr_t)buff;
+        sqe->len = size;
+        sqe->user_data = user_data;
+        ctx->uring.sq_array[idx] = idx;
+        __atomic_store_n(ctx->uring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+        do {
+            ret = __vk_aio_mal_uring_enter(ctx->uring.fd, 1, 0, 0);
+        } while ((ret < 0) && (EINTR == errno));
+    pthread_mutex_unlock(&ctx->lock);
+    return ret < 0 ? VSF_ERR_FAIL : VSF_ERR_NONE;
+}
+
+static void __vk_aio_mal_uring_fini(__vk_aio_mal_ctx_t *ctx)
+{
+    if (ctx->uring.sqes != NULL) {
+        munmap(ctx->uring.sqes, ctx->uring.sqes_size);
+    }
+    if ((ctx->uring.cq_ring != NULL) && (ctx->uring.cq_ring != ctx->uring.sq_ring)) {
+        munmap(ctx->uring.cq_ring, ctx->uring.cq_ring_size);
+    }
+    if (ctx->uring.sq_ring != NULL) {
+        munmap(ctx->uring.sq_ring, ctx->uring.sq_ring_size);
+    }
+#   if VSF_ARCH_CFG_EPOLL == ENABLED
+    if (ctx->uring.source.fd >= 0) {
+        close(ctx->uring.source.fd);
+    }
+#   endif
+    close(ctx->uring.fd);
+    ctx->uring.fd = -1;
+}
+
+static vsf_err_t __vk_aio_mal_uring_init(__vk_aio_mal_ctx_t *ctx)
+{
+    struct io_uring_params params = { 0 };
+    uint8_t *sq_ring, *cq_ring;
+
+    ctx->uring.fd = (int)syscall(__NR_io_uring_setup, VSF_AIO_MAL_CFG_QUEUE_DEPTH, &params);
+    if (ctx->uring.fd < 0) {
+        __vk_aio_mal_trace("io_uring is not supported, use thread pool" VSF_TRACE_CFG_LINEEND);
+        return VSF_ERR_NOT_SUPPORT;
+    }
+#   if VSF_ARCH_CFG_EPOLL == ENABLED
+    ctx->uring.source.fd = -1;
+#   endif
+
+    ctx->uring.sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ctx->uring.cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ctx->uring.sq_ring_size = ctx->uring.cq_ring_size =
+            max(ctx->uring.sq_ring_size, ctx->uring.cq_ring_size);
+    }
+    sq_ring = mmap(NULL, ctx->uring.sq_ring_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ctx->uring.fd, IORING_OFF_SQ_RING);
+    if (MAP_FAILED == sq_ring) {
+        goto fail;
+    }
+    ctx->uring.sq_ring = sq_ring;
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        cq_ring = sq_ring;
+    } else {
+        cq_ring = mmap(NULL, ctx->uring.cq_ring_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ctx->uring.fd, IORING_OFF_CQ_RING);
+        if (MAP_FAILED == cq_ring) {
+            goto fail;
+        }
+    }
+    ctx->uring.cq_ring = cq_ring;
+    ctx->uring.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ctx->uring.sqes = mmap(NULL, ctx->uring.sqes_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ctx->uring.fd, IORING_OFF_SQES);
+    if (MAP_FAILED == ctx->uring.sqes) {
+        ctx->uring.sqes = NULL;
+        goto fail;
+    }
+
+    ctx->uring.sq_tail = (unsigned *)(sq_ring + params.sq_off.tail);
+    ctx->uring.sq_mask = (unsigned *)(sq_ring + params.sq_off.ring_mask);
+    ctx->uring.sq_array = (unsigned *)(sq_ring + params.sq_off.array);
+    ctx->uring.cq_head = (unsigned *)(cq_ring + params.cq_off.head);
+    ctx->uring.cq_tail = (unsigned *)(cq_ring + params.cq_off.tail);
+    ctx->uring.cq_mask = (unsigned *)(cq_ring + params.cq_off.ring_mask);
+    ctx->uring.cqes = (struct io_uring_cqe *)(cq_ring + params.cq_off.cqes);
+
+#   if VSF_ARCH_CFG_EPOLL == ENABLED
+    ctx->uring.source.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (    (ctx->uring.source.fd < 0)
+        ||  (syscall(__NR_io_uring_register, ctx->uring.fd, IORING_REGISTER_EVENTFD,
+                    &ctx->uring.source.fd, 1) != 0)) {
+        goto fail;
+    }
+    ctx->uring.source.events = EPOLLIN;
+    ctx->uring.source.handler = __vk_aio_mal_uring_on_eventfd;
+    if (__vsf_arch_epoll_add(&ctx->uring.source) != VSF_ERR_NONE) {
+        goto fail;
+    }
+    ctx->thread_num = 0;
+#   else
+    ctx->thread_num = 1;
+    ctx->uring.worker.ctx = ctx;
+    __vsf_arch_irq_init(&ctx->uring.worker.irq_thread, "aio_mal_uring",
+                __vk_aio_mal_uring_thread, vsf_arch_prio_0);
+#   endif
+    return VSF_ERR_NONE;
+
+fail:
+    __vk_aio_mal_uring_fini(ctx);
+    return VSF_ERR_FAIL;
+}
+#endif
+
+/*----------------------------------------------------------------------------*
+ * request                                                                    *
+ *----------------------------------------------------------------------------*/
+
+static vsf_err_t __vk_aio_mal_submit(vk_aio_mal_t *pthis, bool is_write,
+            uint_fast64_t addr, uint_fast32_t size, uint8_t *buff)
+{
+    __vk_aio_mal_ctx_t *ctx = pthis->ctx;
+    __vk_aio_mal_req_t *req = NULL;
+    vsf_protect_t orig;
+
+    VSF_MAL_ASSERT((size > 0) && ((addr + size) <= pthis->size));
+    VSF_MAL_ASSERT(!(addr % pthis->block_size) && !(size % pthis->block_size));
+
+    // req_sem is pended, so there MUST be free request
+    orig = vsf_protect_sched();
+        for (uint_fast16_t i = 0; i < dimof(ctx->req); i++) {
+            if (!ctx->req[i].is_busy) {
+                req = &ctx->req[i];
+                req->is_busy = true;
+                break;
+            }
+        }
+    vsf_unprotect_sched(orig);
+    VSF_MAL_ASSERT(req != NULL);
+
+    req->eda = vsf_eda_get_cur();
+    req->is_write = is_write;
+    req->addr = addr;
+    req->size = size;
+    req->buff = req->xfer = buff;
+    if (pthis->is_direct && ((uintptr_t)buff & (VSF_AIO_MAL_CFG_DIRECT_ALIGN - 1))) {
+        if (req->bounce_size < size) {
+            if (req->bounce != NULL) {
+                free(req->bounce);
+                req->bounce_size = 0;
+            }
+            if (posix_memalign((void **)&req->bounce, VSF_AIO_MAL_CFG_DIRECT_ALIGN, size) != 0) {
+                req->bounce = NULL;
+                goto fail;
+            }
+            req->bounce_size = size;
+        }
+        if (is_write) {
+            memcpy(req->bounce, buff, size);
+        }
+        req->xfer = req->bounce;
+    }
+
+#if VSF_AIO_MAL_CFG_IO_URING == ENABLED
+    if (ctx->is_uring) {
+        if (__vk_aio_mal_uring_submit_sqe(ctx, is_write ? IORING_OP_WRITE : IORING_OP_READ,
+                    addr, size, req->xfer, (uintptr_t)req) != VSF_ERR_NONE) {
+            goto fail;
+        }
+        return VSF_ERR_NONE;
+    }
+#endif
+    return __vk_aio_mal_pool_submit(ctx, req);
+
+fail:
+    req->is_busy = false;
+    return VSF_ERR_FAIL;
+}
+
+static void __vk_aio_mal_rw(vk_aio_mal_t *pthis, vsf_evt_t evt, bool is_write,
+            uint_fast64_t addr, uint_fast32_t size, uint8_t *buff)
+{
+    switch (evt) {
+    case VSF_EVT_INIT:
+        if (VSF_ERR_NONE != vsf_eda_sem_pend(&pthis->req_sem, -1)) {
+            break;
+        }
+        // fall through
+    case VSF_EVT_SYNC:
+        if (VSF_ERR_NONE != __vk_aio_mal_submit(pthis, is_write, addr, size, buff)) {
+            vsf_eda_sem_post(&pthis->req_sem);
+            vsf_eda_return(VSF_ERR_FAIL);
+        }
+        break;
+    case VSF_EVT_MESSAGE: {
+            __vk_aio_mal_req_t *req = vsf_eda_get_cur_msg();
+            int32_t result = req->result;
+
+            VSF_MAL_ASSERT(req != NULL);
+            if (!is_write && (result > 0) && (req->xfer != req->buff)) {
+                memcpy(req->buff, req->xfer, req->size);
+            }
+            req->is_busy = false;
+            vsf_eda_sem_post(&pthis->req_sem);
+            vsf_eda_return(result);
+        }
+        break;
+    }
+}
+
+static void __vk_aio_mal_free(vk_aio_mal_t *pthis)
+{
+    __vk_aio_mal_ctx_t *ctx = pthis->ctx;
+
+#if VSF_AIO_MAL_CFG_IO_URING == ENABLED
+    if (ctx->is_uring) {
+        __vk_aio_mal_uring_fini(ctx);
+    } else
+#endif
+    {
+        pthread_cond_destroy(&ctx->pool.cond);
+    }
+    for (uint_fast16_t i = 0; i < dimof(ctx->req); i++) {
+        if (ctx->req[i].bounce != NULL) {
+            free(ctx->req[i].bounce);
+        }
+    }
+    if (ctx->fd >= 0) {
+        close(ctx->fd);
+    }
+    pthread_mutex_destroy(&ctx->lock);
+    free(ctx);
+    pthis->ctx = NULL;
+}
+
+__vsf_component_peda_ifs_entry(__vk_aio_mal_init, vk_mal_init)
+{
+    vsf_peda_begin();
+    vk_aio_mal_t *pthis = (vk_aio_mal_t *)&vsf_this;
+    __vk_aio_mal_ctx_t *ctx;
+    struct stat st;
+    int flags;
+
+    VSF_MAL_ASSERT((pthis != NULL) && (pthis->path != NULL) && (pthis->block_size > 0));
+    VSF_MAL_ASSERT(!pthis->is_direct || !(pthis->block_size % 512));
+
+    ctx = calloc(1, sizeof(*ctx));
+    if (NULL == ctx) {
+        vsf_eda_return(VSF_ERR_NOT_ENOUGH_RESOURCES);
+        return;
+    }
+    ctx->mal = pthis;
+    pthread_mutex_init(&ctx->lock, NULL);
+    pthis->ctx = ctx;
+
+    flags = pthis->read_only ? O_RDONLY : O_RDWR | O_CREAT;
+    ctx->fd = open(pthis->path, flags | (pthis->is_direct ? O_DIRECT : 0), 0644);
+    if ((ctx->fd < 0) && pthis->is_direct && (EINVAL == errno)) {
+        // file systems like tmpfs do not support O_DIRECT
+        __vk_aio_mal_trace("O_DIRECT is not supported for %s" VSF_TRACE_CFG_LINEEND, pthis->path);
+        pthis->is_direct = false;
+        ctx->fd = open(pthis->path, flags, 0644);
+    }
+    if (ctx->fd < 0) {
+        __vk_aio_mal_trace("fail to open %s" VSF_TRACE_CFG_LINEEND, pthis->path);
+        goto fail;
+    }
+    if (fstat(ctx->fd, &st) != 0) {
+        goto fail;
+    }
+    if (!pthis->size) {
+        pthis->size = st.st_size;
+    } else if (pthis->size > (uint64_t)st.st_size) {
+        if (pthis->read_only || (ftruncate(ctx->fd, (off_t)pthis->size) != 0)) {
+            goto fail;
+        }
+    }
+    pthis->size -= pthis->size % pthis->block_size;
+    if (!pthis->size) {
+        goto fail;
+    }
+
+#if VSF_AIO_MAL_CFG_IO_URING == ENABLED
+    ctx->is_uring = VSF_ERR_NONE == __vk_aio_mal_uring_init(ctx);
+    if (!ctx->is_uring)
+#endif
+    {
+        if (__vk_aio_mal_pool_init(ctx) != VSF_ERR_NONE) {
+            goto fail;
+        }
+    }
+
+    vsf_eda_sem_init(&pthis->req_sem, VSF_AIO_MAL_CFG_QUEUE_DEPTH);
+    pthis->feature = VSF_MAL_READABLE | (pthis->read_only ? 0 : VSF_MAL_WRITABLE);
+    vsf_eda_return(VSF_ERR_NONE);
+    return;
+
+fail:
+    // host threads are not started if failed
+    __vk_aio_mal_free(pthis);
+    vsf_eda_return(VSF_ERR_FAIL);
+    vsf_peda_end();
+}
+
+__vsf_component_peda_ifs_entry(__vk_aio_mal_fini, vk_mal_fini)
+{
+    vsf_peda_begin();
+    vk_aio_mal_t *pthis = (vk_aio_mal_t *)&vsf_this;
+    __vk_aio_mal_ctx_t *ctx = pthis->ctx;
+
+    VSF_MAL_ASSERT(pthis != NULL);
+    switch (evt) {
+    case VSF_EVT_INIT:
+        if (NULL == ctx) {
+            vsf_eda_return(VSF_ERR_NONE);
+            break;
+        }
+        // all requests MUST be completed before fini
+        pthis->fini_eda = vsf_eda_get_cur();
+#if VSF_AIO_MAL_CFG_IO_URING == ENABLED
+        if (ctx->is_uring) {
+#   if VSF_ARCH_CFG_EPOLL == ENABLED
+            __vsf_arch_epoll_del(&ctx->uring.source);
+            goto free_ctx;
+#   else
+            // completion thread exits when the request with user_data 0 is reaped
+            if (__vk_aio_mal_uring_submit_sqe(ctx, IORING_OP_NOP, 0, 0, NULL, 0) != VSF_ERR_NONE) {
+                // completion thread can not be stopped, leave ctx to it
+                vsf_eda_return(VSF_ERR_FAIL);
+            }
+            break;
+#   endif
+        }
+#endif
+        __vk_aio_mal_pool_exit(ctx);
+        break;
+    case VSF_EVT_AIO_MAL_EXITED:
+        goto free_ctx;
+    }
+    return;
+
+free_ctx:
+    if (!pthis->read_only) {
+        fdatasync(ctx->fd);
+    }
+    __vk_aio_mal_free(pthis);
+    vsf_eda_return(VSF_ERR_NONE);
+    vsf_peda_end();
+}
+
+__vsf_component_peda_ifs_entry(__vk_aio_mal_read, vk_mal_read)
+{
+    vsf_peda_begin();
+    vk_aio_mal_t *pthis = (vk_aio_mal_t *)&vsf_this;
+    VSF_MAL_ASSERT(pthis != NULL);
+    __vk_aio_mal_rw(pthis, evt, false, vsf_local.addr, vsf_local.size, vsf_local.buff);
+    vsf_peda_end();
+}
+
+__vsf_component_peda_ifs_entry(__vk_aio_mal_write, vk_mal_write)
+{
+    vsf_peda_begin();
+    vk_aio_mal_t *pthis = (vk_aio_mal_t *)&vsf_this;
+    VSF_MAL_ASSERT(pthis != NULL);
+    if (pthis->read_only) {
+        vsf_eda_return(VSF_ERR_NOT_SUPPORT);
+        return;
+    }
+    __vk_aio_mal_rw(pthis, evt, true, vsf_local.addr, vsf_local.size, vsf_local.buff);
+    vsf_peda_end();
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef __VSF_AIO_MAL_H__
+#define __VSF_AIO_MAL_H__
+
+/*============================ INCLUDES ======================================*/
+
+#include "../../vsf_mal_cfg.h"
+
+#if VSF_USE_MAL == ENABLED && VSF_MAL_USE_AIO_MAL == ENABLED
+
+#include "kernel/vsf_kernel.h"
+
+#if     defined(__VSF_AIO_MAL_CLASS_IMPLEMENT)
+#   undef __VSF_AIO_MAL_CLASS_IMPLEMENT
+#   define __PLOOC_CLASS_IMPLEMENT__
+#endif
+
+#include "utilities/ooc_class.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================ MACROS ========================================*/
+
+// max number of requests in flight for one aio_mal
+#ifndef VSF_AIO_MAL_CFG_QUEUE_DEPTH
+#   define VSF_AIO_MAL_CFG_QUEUE_DEPTH      32
+#endif
+
+// use io_uring if supported by host, or requests are served by a thread pool
+#ifndef VSF_AIO_MAL_CFG_IO_URING
+#   define VSF_AIO_MAL_CFG_IO_URING         ENABLED
+#endif
+
+// number of threads for each aio_mal if io_uring is not used
+#ifndef VSF_AIO_MAL_CFG_THREAD_NUM
+#   define VSF_AIO_MAL_CFG_THREAD_NUM       4
+#endif
+
+// buffer alignment required by O_DIRECT, unaligned buffers are bounced
+#ifndef VSF_AIO_MAL_CFG_DIRECT_ALIGN
+#   define VSF_AIO_MAL_CFG_DIRECT_ALIGN     4096
+#endif
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+
+dcl_simple_class(vk_aio_mal_t)
+
+// mal on image file of host, requests from different edas are in flight at the
+//  same time, and completed in irq context of the host thread
+// size of vk_mal_t: 0 to use size of the image file
+def_simple_class(vk_aio_mal_t) {
+    public_member(
+        implement(vk_mal_t)
+        // path of the image file on host
+        const char *path;
+        // should be multiple of 512 if is_direct
+        uint32_t block_size;
+        // bypass page cache of host, fall back to cached io if not supported
+        bool is_direct;
+        bool read_only;
+    )
+
+    private_member(
+        // host context, defined in vsf_aio_mal.c
+        void *ctx;
+        vsf_sem_t req_sem;
+        vsf_eda_t *fini_eda;
+    )
+};
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+extern const vk_mal_drv_t vk_aio_mal_drv;
+
+/*============================ PROTOTYPES ====================================*/
+
+// valid after initialized
+extern bool vk_aio_mal_is_uring(vk_aio_mal_t *pthis);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif      // VSF_USE_MAL && VSF_MAL_USE_AIO_MAL
+#endif      // __VSF_AIO_MAL_H__
@@ -56,6 +56,13 @@
 
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
+
+typedef struct __vk_fakefat32_index_t {
+    uint32_t first_cluster;
+    uint32_t cluster_num;
+    vk_fakefat32_file_t *file;
+} __vk_fakefat32_index_t;
+
 /*============================ PROTOTYPES ====================================*/
 
 static uint_fast32_t __vk_fakefat32_mal_blksz(vk_mal_t *mal, uint_fast64_t addr, uint_fast32_t size, vsf_mal_op_t op);
@@ -240,6 +247,105 @@ static vk_fakefat32_file_t * __vk_fakefat32_get_file_by_cluster(
     return NULL;
 }
 
+static uint_fast32_t __vk_fakefat32_calc_file_clusters(vk_fakefat32_mal_t *pthis, vk_fakefat32_file_t *file)
+{
+    uint_fast32_t cluster_size = pthis->sector_size * pthis->sectors_per_cluster;
+    return ((uint64_t)file->size + cluster_size - 1) / cluster_size;
+}
+
+static uint_fast32_t __vk_fakefat32_count_files(vk_fakefat32_file_t *file)
+{
+    uint_fast32_t file_num = 1;
+
+    if ((file->d.child != NULL) && (file->attr & VSF_FILE_ATTR_DIRECTORY)) {
+        vk_fakefat32_file_t *child = (vk_fakefat32_file_t *)file->d.child;
+        for (uint_fast32_t i = 0; i < file->d.child_num; i++, child++) {
+            file_num += __vk_fakefat32_count_files(child);
+        }
+    }
+    return file_num;
+}
+
+static void __vk_fakefat32_index_add(vk_fakefat32_mal_t *pthis, vk_fakefat32_file_t *file)
+{
+    uint_fast32_t clusters = __vk_fakefat32_calc_file_clusters(pthis, file);
+
+    if (clusters && (pthis->index_num < pthis->index_size)) {
+        __vk_fakefat32_index_t *index = &pthis->index[pthis->index_num++];
+        index->first_cluster = file->first_cluster;
+        index->cluster_num = clusters;
+        index->file = file;
+    }
+    if ((file->d.child != NULL) && (file->attr & VSF_FILE_ATTR_DIRECTORY)) {
+        vk_fakefat32_file_t *child = (vk_fakefat32_file_t *)file->d.child;
+        for (uint_fast32_t i = 0; i < file->d.child_num; i++, child++) {
+            __vk_fakefat32_index_add(pthis, child);
+        }
+    }
+}
+
+static void __vk_fakefat32_index_build(vk_fakefat32_mal_t *pthis)
+{
+    __vk_fakefat32_index_t *index = pthis->index, tmp;
+    uint_fast32_t j;
+
+    if (NULL == index) {
+        return;
+    }
+
+    pthis->index_num = 0;
+    __vk_fakefat32_index_add(pthis, &pthis->root);
+
+    // clusters are allocated in the order of tree walking at init, and host
+    //  seldom moves files, so insertion sort is fast on the almost sorted array
+    for (uint_fast32_t i = 1; i < pthis->index_num; i++) {
+        tmp = index[i];
+        for (j = i; (j > 0) && (index[j - 1].first_cluster > tmp.first_cluster); j--) {
+            index[j] = index[j - 1];
+        }
+        index[j] = tmp;
+    }
+}
+
+// get file containing the cluster, next_cluster is the cluster after the file
+//  if found, or the first cluster of the next file if not found
+static vk_fakefat32_file_t * __vk_fakefat32_lookup(vk_fakefat32_mal_t *pthis,
+            uint_fast32_t cluster, uint_fast32_t *next_cluster)
+{
+    __vk_fakefat32_index_t *index = pthis->index;
+    vk_fakefat32_file_t *file;
+
+    if (NULL == index) {
+        file = __vk_fakefat32_get_file_by_cluster(pthis, &pthis->root, 1, cluster);
+        *next_cluster = (NULL == file) ? cluster + 1 :
+            file->first_cluster + __vk_fakefat32_calc_file_clusters(pthis, file);
+        return file;
+    }
+
+    // find the first file ending after the cluster
+    uint_fast32_t head = 0, tail = pthis->index_num, mid;
+    while (head < tail) {
+        mid = head + ((tail - head) >> 1);
+        if ((index[mid].first_cluster + index[mid].cluster_num) <= cluster) {
+            head = mid + 1;
+        } else {
+            tail = mid;
+        }
+    }
+
+    if (head >= pthis->index_num) {
+        *next_cluster = 0xFFFFFFFF;
+        return NULL;
+    }
+    index = &index[head];
+    if (index->first_cluster > cluster) {
+        *next_cluster = index->first_cluster;
+        return NULL;
+    }
+    *next_cluster = index->first_cluster + index->cluster_num;
+    return index->file;
+}
+
 static bool __vk_fakefat32_file_is_lfn(vk_fakefat32_file_t *file)
 {
     return vk_fatfs_is_lfn(file->name);
@@ -376,7 +482,15 @@ static vsf_err_t __vk_fakefat32_init(vk_fakefat32_mal_t *pthis)
 
         pthis->root.attr = (vk_file_attr_t)(VSF_FILE_ATTR_DIRECTORY | VSF_FILE_ATTR_READ | VSF_FILE_ATTR_WRITE);
         pthis->root.parent = NULL;
-        return __vk_fakefat32_init_recursion(pthis, &pthis->root, &cur_cluster);
+        if (__vk_fakefat32_init_recursion(pthis, &pthis->root, &cur_cluster) != VSF_ERR_NONE) {
+            return VSF_ERR_FAIL;
+        }
+    }
+    if (NULL == pthis->index) {
+        pthis->index_size = __vk_fakefat32_count_files(&pthis->root);
+        // index is optional, tree is searched if not enough resources
+        pthis->index = VSF_FS_CFG_MALLOC(pthis->index_size * sizeof(__vk_fakefat32_index_t));
+        __vk_fakefat32_index_build(pthis);
     }
     return VSF_ERR_NONE;
 }
@@ -562,14 +676,16 @@ vsf_component_peda_ifs_entry(__vk_fakefat32_dir_write, vk_memfs_callback_write)
 {
     vsf_peda_begin();
     vk_fakefat32_file_t *file = (vk_fakefat32_file_t *)&vsf_this;
+    vk_fakefat32_mal_t *mal = file->mal;
     uint8_t *buff = vsf_local.buff;
     uint_fast16_t child_num;
+    bool is_changed = false;
 
     uint_fast32_t page_size = file->mal->sector_size;
     vk_fakefat32_file_t *file_temp, *file_match;
     uint8_t *entry;
     uint_fast32_t want_size;
-    uint_fast16_t want_first_cluster;
+    uint_fast32_t want_first_cluster;
     vk_fatfs_dentry_parser_t dparser;
 
     child_num = file->d.child_num;
@@ -610,6 +726,7 @@ vsf_component_peda_ifs_entry(__vk_fakefat32_dir_write, vk_memfs_callback_write)
             }
             file_match->first_cluster = want_first_cluster;
             memcpy(&file_match->record, &entry[13], sizeof(file_match->record));
+            is_changed = true;
 
 fakefat32_dir_write_next:
             dparser.entry += 32;
@@ -618,11 +735,54 @@ fakefat32_dir_write_next:
             break;
         }
     }
+    if (is_changed) {
+        __vk_fakefat32_index_build(mal);
+    }
     vsf_eda_return(vsf_local.size);
     vsf_peda_end();
 }
 
-static vsf_err_t __vk_fakefat32_read(vk_fakefat32_mal_t *pthis, uint_fast64_t addr, uint8_t *buff)
+static void __vk_fakefat32_fill_fat(vk_fakefat32_mal_t *pthis, uint_fast32_t cluster_index,
+            uint32_t *buff32, uint_fast32_t num)
+{
+    uint_fast32_t root_cluster = FAKEFAT32_ROOT_CLUSTER;
+    uint_fast32_t next_cluster, cur_num;
+    vk_fakefat32_file_t *file;
+
+    while (num && (cluster_index < root_cluster)) {
+        *buff32++ = (0 == cluster_index) ? FAT32_FAT_START : FAT32_FAT_INVALID;
+        num--;
+        cluster_index++;
+    }
+
+    while (num) {
+        file = __vk_fakefat32_lookup(pthis, cluster_index, &next_cluster);
+        if (NULL == file) {
+            // free clusters till next file
+            cur_num = min(num, next_cluster - cluster_index);
+            memset(buff32, 0, cur_num * 4);
+            buff32 += cur_num;
+            num -= cur_num;
+            cluster_index += cur_num;
+        } else {
+            while (num && (cluster_index < next_cluster)) {
+                if (cluster_index == (next_cluster - 1)) {
+                    // last cluster
+                    *buff32++ = FAT32_FAT_FILEEND;
+                } else {
+                    *buff32++ = cluster_index + 1;
+                }
+                num--;
+                cluster_index++;
+            }
+        }
+    }
+}
+
+// read sectors at addr, rsize is the size read if VSF_ERR_NONE is returned,
+//  one sector is read by file callback if VSF_ERR_NOT_READY is returned
+static vsf_err_t __vk_fakefat32_read(vk_fakefat32_mal_t *pthis, uint_fast64_t addr,
+            uint_fast32_t size, uint8_t *buff, uint_fast32_t *rsize)
 {
     uint_fast32_t page_size = pthis->sector_size;
     uint_fast32_t block_addr = addr / page_size;
@@ -630,6 +790,7 @@ static vsf_err_t __vk_fakefat32_read(vk_fakefat32_mal_t *pthis, uint_fast64_t ad
     uint_fast32_t cluster_size = pthis->sectors_per_cluster * pthis->sector_size;
     uint_fast32_t root_cluster = FAKEFAT32_ROOT_CLUSTER;
 
+    *rsize = page_size;
     if (block_addr < (FAKEFAT32_HIDDEN_SECTORS + FAKEFAT32_RES_SECTORS + FAKEFAT32_FAT_NUM * fat_sectors)) {
         memset(buff, 0, page_size);
     }
@@ -708,60 +869,43 @@ static vsf_err_t __vk_fakefat32_read(vk_fakefat32_mal_t *pthis, uint_fast64_t ad
     } else if (block_addr < (FAKEFAT32_HIDDEN_SECTORS + FAKEFAT32_RES_SECTORS)) {
         // other reserved sectors, all data is 0
     } else if (block_addr < (FAKEFAT32_FAT_NUM * fat_sectors + FAKEFAT32_RES_SECTORS + FAKEFAT32_HIDDEN_SECTORS)) {
-        // FAT
+        // FAT, sectors to the end of current FAT are generated in one pass
         uint_fast32_t fat_sector = (block_addr - FAKEFAT32_HIDDEN_SECTORS - FAKEFAT32_RES_SECTORS) % fat_sectors;
-        uint_fast32_t max_cluster = page_size / 4;
-        uint_fast32_t remain_size = page_size;
-        uint_fast32_t cluster_index = fat_sector * max_cluster;
-        uint32_t *buff32 = (uint32_t *)buff;
-
-        while (remain_size && (cluster_index < root_cluster)) {
-            *buff32++ = (0 == cluster_index) ? FAT32_FAT_START : FAT32_FAT_INVALID;
-            remain_size -= 4;
-            cluster_index++;
-        }
-
-        while (remain_size) {
-            vk_fakefat32_file_t *file = NULL;
-
-            file = __vk_fakefat32_get_file_by_cluster(pthis, &pthis->root, 1, cluster_index);
-            if (NULL == file) {
-                // file not found
-                *buff32++ = 0;
-                remain_size -= 4;
-                cluster_index++;
-            } else {
-                // file found
-                uint_fast32_t cluster_offset = cluster_index - file->first_cluster;
-                uint_fast32_t file_clusters = ((uint64_t)file->size + cluster_size - 1) / cluster_size;
-
-                while (remain_size && (cluster_offset < file_clusters)) {
-                    if (cluster_offset == (file_clusters - 1)) {
-                        // last cluster
-                        *buff32++ = FAT32_FAT_FILEEND;
-                    } else {
-                        *buff32++ = cluster_index + 1;
-                    }
+        uint_fast32_t sectors = min(size / page_size, fat_sectors - fat_sector);
 
-                    remain_size -= 4;
-                    cluster_offset++;
-                    cluster_index++;
-                }
-            }
-        }
+        __vk_fakefat32_fill_fat(pthis, fat_sector * (page_size / 4), (uint32_t *)buff,
+                    sectors * (page_size / 4));
+        *rsize = sectors * page_size;
     } else {
         // Clusters
         uint_fast32_t sectors_to_root = block_addr - FAKEFAT32_HIDDEN_SECTORS - FAKEFAT32_RES_SECTORS - FAKEFAT32_FAT_NUM * fat_sectors;
         uint_fast32_t cluster_index = root_cluster + sectors_to_root / pthis->sectors_per_cluster;
-        vk_fakefat32_file_t *file = NULL;
-
-        file = __vk_fakefat32_get_file_by_cluster(pthis, &pthis->root, 1, cluster_index);
-        if ((file != NULL) && (file->attr & VSF_FILE_ATTR_READ)) {
-            uint_fast32_t addr_offset = pthis->sector_size *
+        uint_fast32_t next_cluster;
+        uint_fast64_t run_size;
+        vk_fakefat32_file_t *file;
+
+        file = __vk_fakefat32_lookup(pthis, cluster_index, &next_cluster);
+        // size from addr to next_cluster, sectors in the run are served in one pass
+        run_size = (uint_fast64_t)(next_cluster - cluster_index) * cluster_size
+                -   (sectors_to_root % pthis->sectors_per_cluster) * page_size;
+        run_size = min(run_size, size);
+
+        if ((NULL == file) || !(file->attr & VSF_FILE_ATTR_READ)) {
+            // free clusters or unreadable file
+            memset(buff, 0, run_size);
+            *rsize = run_size;
+        } else {
+            uint_fast64_t addr_offset = (uint_fast64_t)pthis->sector_size *
                     (sectors_to_root - pthis->sectors_per_cluster * (file->first_cluster - root_cluster));
 
             if ((file->f.buff != NULL) && !(file->attr & VSF_FILE_ATTR_DIRECTORY)) {
-                memcpy(buff, &file->f.buff[addr_offset], page_size);
+                // data after the end of file is 0
+                uint_fast64_t copy_size = addr_offset < file->size ?
+                        min(run_size, file->size - addr_offset) : 0;
+
+                memcpy(buff, &file->f.buff[addr_offset], copy_size);
+                memset(buff + copy_size, 0, run_size - copy_size);
+                *rsize = run_size;
             } else if (file->callback.read != NULL) {
                 vsf_err_t err;
                 __vsf_component_call_peda_ifs(vk_memfs_callback_read, err, file->callback.read, 0, file,
@@ -771,6 +915,8 @@ static vsf_err_t __vk_fakefat32_read(vk_fakefat32_mal_t *pthis, uint_fast64_t ad
                 );
                 UNUSED_PARAM(err);
                 return VSF_ERR_NOT_READY;
+            } else {
+                memset(buff, 0, page_size);
             }
         }
     }
@@ -794,6 +940,7 @@ static vsf_err_t __vk_fakefat32_write(vk_fakefat32_mal_t *pthis, uint_fast64_t a
     uint_fast32_t cluster_index = FAKEFAT32_ROOT_CLUSTER + (block_addr -
                     FAKEFAT32_HIDDEN_SECTORS - FAKEFAT32_RES_SECTORS -
                     FAKEFAT32_FAT_NUM * fat_sectors) / pthis->sectors_per_cluster;
+    uint_fast32_t next_cluster;
     vk_fakefat32_file_t *file = NULL;
 
     // Hidden sectors, Reserved sectors, FAT can not be written
@@ -805,7 +952,7 @@ static vsf_err_t __vk_fakefat32_write(vk_fakefat32_mal_t *pthis, uint_fast64_t a
         return VSF_ERR_NONE;
     }
 
-    file = __vk_fakefat32_get_file_by_cluster(pthis, &pthis->root, 1, cluster_index);
+    file = __vk_fakefat32_lookup(pthis, cluster_index, &next_cluster);
     if ((file != NULL) && (file->attr & VSF_FILE_ATTR_WRITE)) {
         uint_fast32_t addr_offset = pthis->sector_size *
             (sectors_to_root - pthis->sectors_per_cluster * (file->first_cluster - root_cluster));
@@ -863,6 +1010,10 @@ __vsf_component_peda_ifs_entry(__vk_fakefat32_mal_fini, vk_mal_fini)
     vk_fakefat32_mal_t *pthis = (vk_fakefat32_mal_t *)&vsf_this;
 
     VSF_MAL_ASSERT(pthis != NULL);
+    if (pthis->index != NULL) {
+        VSF_FS_CFG_FREE(pthis->index);
+        pthis->index = NULL;
+    }
     vsf_eda_return(VSF_ERR_NONE);
     vsf_peda_end();
 }
@@ -871,6 +1022,7 @@ __vsf_component_peda_ifs_entry(__vk_fakefat32_mal_read, vk_mal_read)
 {
     vsf_peda_begin();
     vk_fakefat32_mal_t *pthis = (vk_fakefat32_mal_t *)&vsf_this;
+    uint_fast32_t rsize;
 
     VSF_MAL_ASSERT(pthis != NULL);
 
@@ -878,11 +1030,13 @@ __vsf_component_peda_ifs_entry(__vk_fakefat32_mal_read, vk_mal_read)
     case VSF_EVT_RETURN: {
             int32_t result = (int32_t)vsf_eda_get_return_value();
             if (result >= 0) {
+                // file callback reads one sector
+                rsize = pthis->sector_size;
             read_finish:
-                vsf_local.size -= pthis->sector_size;
-                vsf_local.addr += pthis->sector_size;
-                vsf_local.buff += pthis->sector_size;
-                vsf_local.rsize += pthis->sector_size;
+                vsf_local.size -= rsize;
+                vsf_local.addr += rsize;
+                vsf_local.buff += rsize;
+                vsf_local.rsize += rsize;
             } else {
                 vsf_eda_return(result);
                 break;
@@ -893,7 +1047,7 @@ __vsf_component_peda_ifs_entry(__vk_fakefat32_mal_read, vk_mal_read)
         vsf_local.rsize = 0;
     next:
         if (vsf_local.size > 0) {
-            vsf_err_t err = __vk_fakefat32_read(pthis, vsf_local.addr, vsf_local.buff);
+            vsf_err_t err = __vk_fakefat32_read(pthis, vsf_local.addr, vsf_local.size, vsf_local.buff, &rsize);
             if (VSF_ERR_NONE == err) {
                 goto read_finish;
             } else if (VSF_ERR_NOT_READY == err) {
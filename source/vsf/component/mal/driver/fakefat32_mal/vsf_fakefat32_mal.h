@@ -82,7 +82,7 @@ def_simple_class(vk_fakefat32_mal_t) {
         implement(vk_mal_t)
 
         uint16_t sector_size;
-        uint16_t sector_number;
+        uint32_t sector_number;
         uint8_t sectors_per_cluster;
 
         uint32_t volume_id;
@@ -91,6 +91,14 @@ def_simple_class(vk_fakefat32_mal_t) {
         vk_fakefat32_file_t root;
         vsf_err_t err;
     )
+
+    private_member(
+        // cluster ranges of files sorted by first cluster, built at init and
+        //  when host changes the directories, NULL to search the tree
+        struct __vk_fakefat32_index_t *index;
+        uint32_t index_size;
+        uint32_t index_num;
+    )
 };
 
 /*============================ GLOBAL VARIABLES ==============================*/
@@ -0,0 +1,349 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+/*============================ INCLUDES ======================================*/
+
+#include "../../vsf_mal_cfg.h"
+
+#if VSF_USE_MAL == ENABLED && VSF_MAL_USE_MMAP_MAL == ENABLED
+
+#define __VSF_MAL_CLASS_INHERIT__
+#define __VSF_MMAP_MAL_CLASS_IMPLEMENT
+
+#include "../../vsf_mal.h"
+#include "./vsf_mmap_mal.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*============================ MACROS ========================================*/
+
+#if VSF_MMAP_MAL_CFG_DEBUG == ENABLED
+#   define __vk_mmap_mal_trace(...)                                             \
+            vsf_trace_debug("mmap_mal: " __VA_ARGS__)
+#else
+#   define __vk_mmap_mal_trace(...)
+#endif
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+/*============================ PROTOTYPES ====================================*/
+
+static uint_fast32_t __vk_mmap_mal_blksz(vk_mal_t *mal, uint_fast64_t addr, uint_fast32_t size, vsf_mal_op_t op);
+static bool __vk_mmap_mal_buffer(vk_mal_t *mal, uint_fast64_t addr, uint_fast32_t size, vsf_mal_op_t op, vsf_mem_t *mem);
+dcl_vsf_peda_methods(static, __vk_mmap_mal_init)
+dcl_vsf_peda_methods(static, __vk_mmap_mal_fini)
+dcl_vsf_peda_methods(static, __vk_mmap_mal_read)
+dcl_vsf_peda_methods(static, __vk_mmap_mal_write)
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+#if     __IS_COMPILER_GCC__
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wcast-function-type"
+#endif
+
+const vk_mal_drv_t vk_mmap_mal_drv = {
+    .blksz          = __vk_mmap_mal_blksz,
+    .buffer         = __vk_mmap_mal_buffer,
+    .init           = (vsf_peda_evthandler_t)vsf_peda_func(__vk_mmap_mal_init),
+    .fini           = (vsf_peda_evthandler_t)vsf_peda_func(__vk_mmap_mal_fini),
+    .read           = (vsf_peda_evthandler_t)vsf_peda_func(__vk_mmap_mal_read),
+    .write          = (vsf_peda_evthandler_t)vsf_peda_func(__vk_mmap_mal_write),
+};
+
+#if     __IS_COMPILER_GCC__
+#   pragma GCC diagnostic pop
+#endif
+
+/*============================ LOCAL VARIABLES ===============================*/
+/*============================ IMPLEMENTATION ================================*/
+
+static uint_fast32_t __vk_mmap_mal_blksz(vk_mal_t *mal, uint_fast64_t addr, uint_fast32_t size, vsf_mal_op_t op)
+{
+    return ((vk_mmap_mal_t *)mal)->block_size;
+}
+
+static bool __vk_mmap_mal_map(vk_mmap_mal_t *pthis, __vk_mmap_mal_window_t *window, uint64_t addr, uint32_t size)
+{
+    int prot = pthis->read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+    void *buffer = mmap(NULL, size, prot, MAP_SHARED, pthis->fd, (off_t)addr);
+    if (MAP_FAILED == buffer) {
+        __vk_mmap_mal_trace("fail to map 0x%llx, size 0x%x" VSF_TRACE_CFG_LINEEND,
+                    (unsigned long long)addr, (unsigned int)size);
+        return false;
+    }
+    window->buffer = buffer;
+    window->addr = addr;
+    window->size = size;
+    window->is_dirty = false;
+    return true;
+}
+
+static void __vk_mmap_mal_unmap(vk_mmap_mal_t *pthis, __vk_mmap_mal_window_t *window)
+{
+    if (window->buffer != NULL) {
+        // written data is kept in page cache of host after unmapped
+        if (window->is_dirty) {
+            pthis->is_dirty = true;
+        }
+        munmap(window->buffer, window->size);
+        window->buffer = NULL;
+    }
+    if (pthis->pinned == window) {
+        pthis->pinned = NULL;
+    }
+}
+
+// get window containing addr, map it if not mapped
+static __vk_mmap_mal_window_t * __vk_mmap_mal_get_window(vk_mmap_mal_t *pthis, uint_fast64_t addr)
+{
+    __vk_mmap_mal_window_t *window;
+    uint_fast64_t window_addr;
+    uint_fast8_t idx;
+
+    if (!pthis->window_size) {
+        // the whole image is mapped in window[0] when initialized
+        return &pthis->window[0];
+    }
+
+    window_addr = addr - addr % pthis->window_size;
+    for (idx = 0; idx < dimof(pthis->window); idx++) {
+        window = &pthis->window[idx];
+        if ((window->buffer != NULL) && (window->addr == window_addr)) {
+            return window;
+        }
+    }
+
+    // replace windows in round robin, but the window pinned by prepared buffer
+    for (idx = 0; idx < dimof(pthis->window); idx++) {
+        window = &pthis->window[pthis->victim_idx];
+        pthis->victim_idx = (pthis->victim_idx + 1) % dimof(pthis->window);
+        if (window != pthis->pinned) {
+            __vk_mmap_mal_unmap(pthis, window);
+            if (__vk_mmap_mal_map(pthis, window, window_addr,
+                    min(pthis->window_size, pthis->size - window_addr))) {
+                return window;
+            }
+            return NULL;
+        }
+    }
+    __vk_mmap_mal_trace("all windows are pinned" VSF_TRACE_CFG_LINEEND);
+    return NULL;
+}
+
+static bool __vk_mmap_mal_buffer(vk_mal_t *mal, uint_fast64_t addr, uint_fast32_t size, vsf_mal_op_t op, vsf_mem_t *mem)
+{
+    vk_mmap_mal_t *pthis = (vk_mmap_mal_t *)mal;
+    __vk_mmap_mal_window_t *window;
+
+    if ((VSF_MAL_OP_WRITE == op) && pthis->read_only) {
+        return false;
+    }
+    // previous prepared buffer is not used, release its window
+    pthis->pinned = NULL;
+    window = __vk_mmap_mal_get_window(pthis, addr);
+    if ((NULL == window) || (addr + size > window->addr + window->size)) {
+        return false;
+    }
+    // keep window mapped until buffer is passed to read/write
+    if (pthis->window_size > 0) {
+        pthis->pinned = window;
+    }
+    mem->buffer = &window->buffer[addr - window->addr];
+    mem->size = size;
+    return true;
+}
+
+static int_fast32_t __vk_mmap_mal_rw(vk_mmap_mal_t *pthis, uint_fast64_t addr,
+            uint_fast32_t size, uint8_t *buff, bool is_write)
+{
+    __vk_mmap_mal_window_t *window;
+    uint_fast32_t remain = size, cur_size;
+    uint8_t *mem;
+
+    VSF_MAL_ASSERT((size > 0) && ((addr + size) <= pthis->size));
+    while (remain > 0) {
+        window = __vk_mmap_mal_get_window(pthis, addr);
+        if (NULL == window) {
+            return VSF_ERR_FAIL;
+        }
+
+        mem = &window->buffer[addr - window->addr];
+        cur_size = min(remain, window->size - (addr - window->addr));
+        if (buff == mem) {
+            // buffer from vk_mal_prepare_buffer, zero copy
+            if (pthis->pinned == window) {
+                pthis->pinned = NULL;
+            }
+        } else if (is_write) {
+            memcpy(mem, buff, cur_size);
+        } else {
+            memcpy(buff, mem, cur_size);
+        }
+        if (is_write) {
+            window->is_dirty = true;
+        }
+
+        addr += cur_size;
+        buff += cur_size;
+        remain -= cur_size;
+    }
+    return size;
+}
+
+vsf_err_t vk_mmap_mal_sync(vk_mmap_mal_t *pthis)
+{
+    __vk_mmap_mal_window_t *window;
+    vsf_err_t err = VSF_ERR_NONE;
+
+    VSF_MAL_ASSERT(pthis != NULL);
+    for (uint_fast8_t i = 0; i < dimof(pthis->window); i++) {
+        window = &pthis->window[i];
+        if ((window->buffer != NULL) && window->is_dirty) {
+            if (msync(window->buffer, window->size, MS_SYNC) != 0) {
+                err = VSF_ERR_FAIL;
+            } else {
+                window->is_dirty = false;
+            }
+        }
+    }
+    // data written in windows already unmapped
+    if (pthis->is_dirty) {
+        if (fdatasync(pthis->fd) != 0) {
+            err = VSF_ERR_FAIL;
+        } else {
+            pthis->is_dirty = false;
+        }
+    }
+    return err;
+}
+
+#if     __IS_COMPILER_GCC__
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wcast-align"
+#elif   __IS_COMPILER_LLVM__
+#   pragma clang diagnostic push
+#   pragma clang diagnostic ignored "-Wcast-align"
+#endif
+
+__vsf_component_peda_ifs_entry(__vk_mmap_mal_init, vk_mal_init)
+{
+    vsf_peda_begin();
+    vk_mmap_mal_t *pthis = (vk_mmap_mal_t *)&vsf_this;
+    struct stat st;
+
+    VSF_MAL_ASSERT((pthis != NULL) && (pthis->path != NULL) && (pthis->block_size > 0));
+    VSF_MAL_ASSERT(!(pthis->window_size % sysconf(_SC_PAGESIZE)));
+    memset(pthis->window, 0, sizeof(pthis->window));
+    pthis->pinned = NULL;
+    pthis->victim_idx = 0;
+    pthis->is_dirty = false;
+
+    // image fd is not inherited by processes spawned on host
+    pthis->fd = pthis->read_only ?  open(pthis->path, O_RDONLY | O_CLOEXEC)
+                                :   open(pthis->path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (pthis->fd < 0) {
+        __vk_mmap_mal_trace("fail to open %s" VSF_TRACE_CFG_LINEEND, pthis->path);
+        vsf_eda_return(VSF_ERR_FAIL);
+        return;
+    }
+    if (fstat(pthis->fd, &st) != 0) {
+        goto fail;
+    }
+    if (!pthis->size) {
+        pthis->size = st.st_size;
+    } else if (pthis->size > (uint64_t)st.st_size) {
+        if (pthis->read_only || (ftruncate(pthis->fd, (off_t)pthis->size) != 0)) {
+            goto fail;
+        }
+    }
+    pthis->size -= pthis->size % pthis->block_size;
+    if (!pthis->size) {
+        goto fail;
+    }
+
+    if (!pthis->window_size) {
+        if (    (pthis->size > (size_t)-1)
+            ||  !__vk_mmap_mal_map(pthis, &pthis->window[0], 0, pthis->size)) {
+            goto fail;
+        }
+    }
+
+    pthis->feature = VSF_MAL_READABLE | (pthis->read_only ? 0 : VSF_MAL_WRITABLE);
+    vsf_eda_return(VSF_ERR_NONE);
+    return;
+
+fail:
+    close(pthis->fd);
+    pthis->fd = -1;
+    vsf_eda_return(VSF_ERR_FAIL);
+    vsf_peda_end();
+}
+
+__vsf_component_peda_ifs_entry(__vk_mmap_mal_fini, vk_mal_fini)
+{
+    vsf_peda_begin();
+    vk_mmap_mal_t *pthis = (vk_mmap_mal_t *)&vsf_this;
+    vsf_err_t err = VSF_ERR_NONE;
+
+    VSF_MAL_ASSERT(pthis != NULL);
+    if (pthis->fd >= 0) {
+        if (!pthis->read_only) {
+            err = vk_mmap_mal_sync(pthis);
+        }
+        for (uint_fast8_t i = 0; i < dimof(pthis->window); i++) {
+            __vk_mmap_mal_unmap(pthis, &pthis->window[i]);
+        }
+        close(pthis->fd);
+        pthis->fd = -1;
+    }
+    vsf_eda_return(err);
+    vsf_peda_end();
+}
+
+__vsf_component_peda_ifs_entry(__vk_mmap_mal_read, vk_mal_read)
+{
+    vsf_peda_begin();
+    vk_mmap_mal_t *pthis = (vk_mmap_mal_t *)&vsf_this;
+    VSF_MAL_ASSERT(pthis != NULL);
+    vsf_eda_return(__vk_mmap_mal_rw(pthis, vsf_local.addr, vsf_local.size, vsf_local.buff, false));
+    vsf_peda_end();
+}
+
+__vsf_component_peda_ifs_entry(__vk_mmap_mal_write, vk_mal_write)
+{
+    vsf_peda_begin();
+    vk_mmap_mal_t *pthis = (vk_mmap_mal_t *)&vsf_this;
+    VSF_MAL_ASSERT(pthis != NULL);
+    if (pthis->read_only) {
+        vsf_eda_return(VSF_ERR_NOT_SUPPORT);
+        return;
+    }
+    vsf_eda_return(__vk_mmap_mal_rw(pthis, vsf_local.addr, vsf_local.size, vsf_local.buff, true));
+    vsf_peda_end();
+}
+
+#if     __IS_COMPILER_GCC__
+#   pragma GCC diagnostic pop
+#elif   __IS_COMPILER_LLVM__
+#   pragma clang diagnostic pop
+#endif
+
+#endif
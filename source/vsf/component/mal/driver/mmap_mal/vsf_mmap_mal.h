@@ -0,0 +1,99 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef __VSF_MMAP_MAL_H__
+#define __VSF_MMAP_MAL_H__
+
+/*============================ INCLUDES ======================================*/
+
+#include "../../vsf_mal_cfg.h"
+
+#if VSF_USE_MAL == ENABLED && VSF_MAL_USE_MMAP_MAL == ENABLED
+
+#if     defined(__VSF_MMAP_MAL_CLASS_IMPLEMENT)
+#   undef __VSF_MMAP_MAL_CLASS_IMPLEMENT
+#   define __PLOOC_CLASS_IMPLEMENT__
+#endif
+
+#include "utilities/ooc_class.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================ MACROS ========================================*/
+
+// max number of windows mapped at the same time if window_size is not 0
+#ifndef VSF_MMAP_MAL_CFG_WINDOW_NUM
+#   define VSF_MMAP_MAL_CFG_WINDOW_NUM      4
+#endif
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+
+dcl_simple_class(vk_mmap_mal_t)
+
+typedef struct __vk_mmap_mal_window_t {
+    uint8_t *buffer;
+    uint64_t addr;
+    uint32_t size;
+    bool is_dirty;
+} __vk_mmap_mal_window_t;
+
+// mal on image file of host, read/write is served by memcpy from mapped memory
+//  and vk_mal_prepare_buffer returns the mapped memory directly
+// size of vk_mal_t: 0 to use size of the image file, or the image file will be
+//  created or extended to size if it's shorter
+def_simple_class(vk_mmap_mal_t) {
+    public_member(
+        implement(vk_mal_t)
+        // path of the image file on host
+        const char *path;
+        uint32_t block_size;
+        // size of mapped windows, should be aligned to page size of host
+        //  0 to map the whole image, which is the fastest if address space is enough
+        uint32_t window_size;
+        bool read_only;
+    )
+
+    private_member(
+        int fd;
+        uint8_t victim_idx;
+        // data written in windows unmapped is not synced
+        bool is_dirty;
+        __vk_mmap_mal_window_t window[VSF_MMAP_MAL_CFG_WINDOW_NUM];
+        // window of the buffer returned by vk_mal_prepare_buffer and not yet
+        //  read/written, released if not used before the next prepare
+        __vk_mmap_mal_window_t *pinned;
+    )
+};
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+extern const vk_mal_drv_t vk_mmap_mal_drv;
+
+/*============================ PROTOTYPES ====================================*/
+
+// flush written data in mapped windows to the image file on host
+extern vsf_err_t vk_mmap_mal_sync(vk_mmap_mal_t *pthis);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif      // VSF_USE_MAL && VSF_MAL_USE_MMAP_MAL
+#endif      // __VSF_MMAP_MAL_H__
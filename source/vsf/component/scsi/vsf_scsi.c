@@ -123,7 +123,8 @@ bool vk_scsi_get_rw_param(uint8_t *cbd, uint64_t *addr, uint32_t *size)
     if ((SCSI_CMDCODE_READ == cmd_code) || (SCSI_CMDCODE_WRITE == cmd_code)) {
         switch (group_code) {
         case SCSI_GROUPCODE6:
-            *addr = get_unaligned_be16(&cbd[2]);
+            // 21-bit lba in byte 1..3
+            *addr = get_unaligned_be32(&cbd[0]) & 0x1FFFFF;
             *size = cbd[4];
             break;
         case SCSI_GROUPCODE10_1:
@@ -132,7 +133,7 @@ bool vk_scsi_get_rw_param(uint8_t *cbd, uint64_t *addr, uint32_t *size)
             break;
         case SCSI_GROUPCODE16:
             *addr = get_unaligned_be64(&cbd[2]);
-            *size = get_unaligned_be32(&cbd[7]);
+            *size = get_unaligned_be32(&cbd[10]);
             break;
         case SCSI_GROUPCODE12:
             *addr = get_unaligned_be32(&cbd[2]);
@@ -146,4 +147,36 @@ bool vk_scsi_get_rw_param(uint8_t *cbd, uint64_t *addr, uint32_t *size)
     return false;
 }
 
+// layout MUST match vk_scsi_get_rw_param
+bool vk_scsi_set_rw_param(uint8_t *cbd, uint64_t addr, uint32_t size)
+{
+    scsi_group_code_t group_code = (scsi_group_code_t)(cbd[0] & 0xE0);
+    scsi_cmd_code_t cmd_code = (scsi_cmd_code_t)(cbd[0] & 0x1F);
+    if ((SCSI_CMDCODE_READ == cmd_code) || (SCSI_CMDCODE_WRITE == cmd_code)) {
+        switch (group_code) {
+        case SCSI_GROUPCODE6:
+            cbd[1] = (cbd[1] & 0xE0) | ((addr >> 16) & 0x1F);
+            put_unaligned_be16(addr, &cbd[2]);
+            cbd[4] = size;
+            break;
+        case SCSI_GROUPCODE10_1:
+            put_unaligned_be32(addr, &cbd[2]);
+            put_unaligned_be16(size, &cbd[7]);
+            break;
+        case SCSI_GROUPCODE16:
+            put_unaligned_be64(addr, &cbd[2]);
+            put_unaligned_be32(size, &cbd[10]);
+            break;
+        case SCSI_GROUPCODE12:
+            put_unaligned_be32(addr, &cbd[2]);
+            put_unaligned_be32(size, &cbd[6]);
+            break;
+        default:
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
 #endif
@@ -164,6 +164,7 @@ extern vsf_err_t vk_scsi_execute_stream(vk_scsi_t *pthis, uint8_t *cbd, vsf_stre
 
 #ifdef __VSF_SCSI_CLASS_INHERIT__
 extern bool vk_scsi_get_rw_param(uint8_t *scsi_cmd, uint64_t *addr, uint32_t *size);
+extern bool vk_scsi_set_rw_param(uint8_t *scsi_cmd, uint64_t addr, uint32_t size);
 extern uint_fast8_t vk_scsi_get_command_len(uint8_t *cbd);
 #endif
 
@@ -0,0 +1,272 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+/*============================ INCLUDES ======================================*/
+
+#include "component/tcpip/vsf_tcpip_cfg.h"
+
+#if VSF_USE_TCPIP == ENABLED
+
+#include "./vsf_inet_checksum.h"
+
+/*============================ MACROS ========================================*/
+
+// use SSE2/AVX2 if enabled in compiler options(-msse2/-mavx2)
+#ifndef VSF_INET_CHECKSUM_CFG_SIMD
+#   define VSF_INET_CHECKSUM_CFG_SIMD       ENABLED
+#endif
+
+#if VSF_INET_CHECKSUM_CFG_SIMD == ENABLED && defined(__AVX2__)
+#   include <immintrin.h>
+#   define __VSF_INET_CHECKSUM_AVX2
+#   define __VSF_INET_CHECKSUM_BLOCK_SIZE   64
+#elif VSF_INET_CHECKSUM_CFG_SIMD == ENABLED && defined(__SSE2__)
+#   include <emmintrin.h>
+#   define __VSF_INET_CHECKSUM_SSE2
+#   define __VSF_INET_CHECKSUM_BLOCK_SIZE   32
+#else
+#   define __VSF_INET_CHECKSUM_BLOCK_SIZE   16
+#endif
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+
+// value of a single byte at even offset, as a 16-bit word in memory order
+#if __BYTE_ORDER == __BIG_ENDIAN
+#   define __vk_inet_csum_byte(__byte)      ((uint_fast32_t)(__byte) << 8)
+#else
+#   define __vk_inet_csum_byte(__byte)      ((uint_fast32_t)(__byte))
+#endif
+
+#define __vk_inet_csum_swap16(__value)                                          \
+            ((uint16_t)(((__value) >> 8) | ((__value) << 8)))
+
+/*============================ TYPES =========================================*/
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ LOCAL VARIABLES ===============================*/
+/*============================ PROTOTYPES ====================================*/
+/*============================ IMPLEMENTATION ================================*/
+
+// src MUST be 4-byte aligned, len MUST be multiple of __VSF_INET_CHECKSUM_BLOCK_SIZE,
+//  dst can be NULL if no copy is needed
+#if defined(__VSF_INET_CHECKSUM_AVX2)
+static uint64_t __vk_inet_csum_block(uint8_t *dst, const uint8_t *src, uint_fast32_t len)
+{
+    __m256i zero = _mm256_setzero_si256(), acc0 = zero, acc1 = zero, v0, v1;
+    uint64_t lane[4];
+
+    // 32-bit words are zero-extended to 64-bit lanes, no overflow
+    for (; len > 0; len -= 64, src += 64) {
+        v0 = _mm256_loadu_si256((const __m256i *)src);
+        v1 = _mm256_loadu_si256((const __m256i *)(src + 32));
+        if (dst != NULL) {
+            _mm256_storeu_si256((__m256i *)dst, v0);
+            _mm256_storeu_si256((__m256i *)(dst + 32), v1);
+            dst += 64;
+        }
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v0, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v0, zero));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v1, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v1, zero));
+    }
+    _mm256_storeu_si256((__m256i *)lane, _mm256_add_epi64(acc0, acc1));
+    return lane[0] + lane[1] + lane[2] + lane[3];
+}
+#elif defined(__VSF_INET_CHECKSUM_SSE2)
+static uint64_t __vk_inet_csum_block(uint8_t *dst, const uint8_t *src, uint_fast32_t len)
+{
+    __m128i zero = _mm_setzero_si128(), acc0 = zero, acc1 = zero, v0, v1;
+    uint64_t lane[2];
+
+    // 32-bit words are zero-extended to 64-bit lanes, no overflow
+    for (; len > 0; len -= 32, src += 32) {
+        v0 = _mm_loadu_si128((const __m128i *)src);
+        v1 = _mm_loadu_si128((const __m128i *)(src + 16));
+        if (dst != NULL) {
+            _mm_storeu_si128((__m128i *)dst, v0);
+            _mm_storeu_si128((__m128i *)(dst + 16), v1);
+            dst += 32;
+        }
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v0, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v0, zero));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v1, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v1, zero));
+    }
+    _mm_storeu_si128((__m128i *)lane, _mm_add_epi64(acc0, acc1));
+    return lane[0] + lane[1];
+}
+#else
+static uint64_t __vk_inet_csum_block(uint8_t *dst, const uint8_t *src, uint_fast32_t len)
+{
+    const uint32_t *ptr = (const uint32_t *)src;
+    uint64_t acc0 = 0, acc1 = 0;
+    uint32_t w0, w1, w2, w3;
+
+    // 2 accumulators to break the dependency chain of adds
+    if (dst != NULL) {
+        for (; len > 0; len -= 16, ptr += 4, dst += 16) {
+            w0 = ptr[0]; w1 = ptr[1]; w2 = ptr[2]; w3 = ptr[3];
+            memcpy(&dst[0], &w0, 4);
+            memcpy(&dst[4], &w1, 4);
+            memcpy(&dst[8], &w2, 4);
+            memcpy(&dst[12], &w3, 4);
+            acc0 += w0; acc1 += w1; acc0 += w2; acc1 += w3;
+        }
+    } else {
+        for (; len > 0; len -= 16, ptr += 4) {
+            acc0 += ptr[0]; acc1 += ptr[1]; acc0 += ptr[2]; acc1 += ptr[3];
+        }
+    }
+    return acc0 + acc1;
+}
+#endif
+
+static uint32_t __vk_inet_csum_do(uint8_t *dst, const uint8_t *src, uint_fast32_t len, uint32_t sum)
+{
+    uint_fast32_t block_len, first = 0, result;
+    bool is_odd = false;
+    uint64_t acc = 0;
+    uint32_t w32;
+    uint16_t w16;
+
+    if (0 == len) {
+        return sum;
+    }
+
+    // odd leading byte shifts the word pairing, sum the rest and swap later
+    if ((uintptr_t)src & 1) {
+        is_odd = true;
+        first = *src++;
+        if (dst != NULL) {
+            *dst++ = (uint8_t)first;
+        }
+        len--;
+    }
+    if ((len >= 2) && ((uintptr_t)src & 2)) {
+        w16 = *(const uint16_t *)src;
+        if (dst != NULL) {
+            memcpy(dst, &w16, 2);
+            dst += 2;
+        }
+        acc += w16;
+        src += 2;
+        len -= 2;
+    }
+
+    block_len = len & ~(uint_fast32_t)(__VSF_INET_CHECKSUM_BLOCK_SIZE - 1);
+    if (block_len > 0) {
+        acc += __vk_inet_csum_block(dst, src, block_len);
+        src += block_len;
+        if (dst != NULL) {
+            dst += block_len;
+        }
+        len -= block_len;
+    }
+
+    for (; len >= 4; len -= 4, src += 4) {
+        w32 = *(const uint32_t *)src;
+        if (dst != NULL) {
+            memcpy(dst, &w32, 4);
+            dst += 4;
+        }
+        acc += w32;
+    }
+    if (len >= 2) {
+        w16 = *(const uint16_t *)src;
+        if (dst != NULL) {
+            memcpy(dst, &w16, 2);
+            dst += 2;
+        }
+        acc += w16;
+        src += 2;
+        len -= 2;
+    }
+    if (len > 0) {
+        if (dst != NULL) {
+            *dst = *src;
+        }
+        acc += __vk_inet_csum_byte(*src);
+    }
+
+    // fold 64-bit to 32-bit with end-around carry
+    acc = (acc & 0xFFFFFFFF) + (acc >> 32);
+    acc = (acc & 0xFFFFFFFF) + (acc >> 32);
+    result = (uint_fast32_t)acc;
+    if (is_odd) {
+        result = vk_inet_csum_fold(result);
+        result = __vk_inet_csum_swap16(result) + __vk_inet_csum_byte(first);
+    }
+    return vk_inet_csum_add(sum, result);
+}
+
+uint32_t vk_inet_csum_add(uint32_t sum, uint32_t sum2)
+{
+    sum += sum2;
+    return sum + (sum < sum2);
+}
+
+uint16_t vk_inet_csum_fold(uint32_t sum)
+{
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)sum;
+}
+
+uint32_t vk_inet_csum_partial(const void *buf, uint_fast32_t len, uint32_t sum)
+{
+    return __vk_inet_csum_do(NULL, buf, len, sum);
+}
+
+uint32_t vk_inet_csum_partial_copy(void *dst, const void *src, uint_fast32_t len, uint32_t sum)
+{
+    VSF_TCPIP_ASSERT((dst != NULL) || (0 == len));
+    return __vk_inet_csum_do(dst, src, len, sum);
+}
+
+uint32_t vk_inet_csum_pseudo_ip4(uint32_t src, uint32_t dst, uint8_t proto, uint16_t len, uint32_t sum)
+{
+    uint64_t acc = (uint64_t)sum + src + dst + cpu_to_be16(proto) + cpu_to_be16(len);
+    acc = (acc & 0xFFFFFFFF) + (acc >> 32);
+    acc = (acc & 0xFFFFFFFF) + (acc >> 32);
+    return (uint32_t)acc;
+}
+
+uint16_t vk_inet_chksum(const void *buf, uint_fast32_t len)
+{
+    return vk_inet_csum_fold(__vk_inet_csum_do(NULL, buf, len, 0));
+}
+
+uint16_t vk_inet_chksum_copy(void *dst, const void *src, uint_fast32_t len)
+{
+    return vk_inet_csum_fold(__vk_inet_csum_do(dst, src, len, 0));
+}
+
+// HC' = ~(~HC + ~m + m')
+uint16_t vk_inet_chksum_replace16(uint16_t chksum, uint16_t from, uint16_t to)
+{
+    uint32_t sum = (uint16_t)~chksum + (uint32_t)(uint16_t)~from + to;
+    return (uint16_t)~vk_inet_csum_fold(sum);
+}
+
+uint16_t vk_inet_chksum_replace32(uint16_t chksum, uint32_t from, uint32_t to)
+{
+    uint64_t acc = (uint16_t)~chksum + (uint64_t)(uint32_t)~from + to;
+    acc = (acc & 0xFFFFFFFF) + (acc >> 32);
+    acc = (acc & 0xFFFFFFFF) + (acc >> 32);
+    return (uint16_t)~vk_inet_csum_fold((uint32_t)acc);
+}
+
+#endif      // VSF_USE_TCPIP
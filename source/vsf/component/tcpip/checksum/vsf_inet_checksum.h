@@ -0,0 +1,67 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef __VSF_INET_CHECKSUM_H__
+#define __VSF_INET_CHECKSUM_H__
+
+/*============================ INCLUDES ======================================*/
+
+#include "component/tcpip/vsf_tcpip_cfg.h"
+
+#if VSF_USE_TCPIP == ENABLED
+
+#include "hal/vsf_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================ MACROS ========================================*/
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ PROTOTYPES ====================================*/
+
+// Internet checksum(RFC 1071) helpers
+//  sums are ones' complement sums of 16-bit words in memory order, so they can
+//  be stored to or compared with the checksum fields directly
+
+// accumulate len bytes of buf to sum, result is not folded
+extern uint32_t vk_inet_csum_partial(const void *buf, uint_fast32_t len, uint32_t sum);
+// copy len bytes from src to dst and accumulate them to sum
+extern uint32_t vk_inet_csum_partial_copy(void *dst, const void *src, uint_fast32_t len, uint32_t sum);
+// accumulate IPv4 pseudo header, src/dst are in network order
+extern uint32_t vk_inet_csum_pseudo_ip4(uint32_t src, uint32_t dst, uint8_t proto, uint16_t len, uint32_t sum);
+extern uint32_t vk_inet_csum_add(uint32_t sum, uint32_t sum2);
+// fold sum to 16-bit, NOT inverted
+extern uint16_t vk_inet_csum_fold(uint32_t sum);
+
+// folded sum of buf, same as LWIP_CHKSUM
+extern uint16_t vk_inet_chksum(const void *buf, uint_fast32_t len);
+// copy and return folded sum, same as LWIP_CHKSUM_COPY
+extern uint16_t vk_inet_chksum_copy(void *dst, const void *src, uint_fast32_t len);
+
+// incremental update of checksum field when a 16/32-bit field is rewritten(RFC 1624)
+extern uint16_t vk_inet_chksum_replace16(uint16_t chksum, uint16_t from, uint16_t to);
+extern uint16_t vk_inet_chksum_replace32(uint16_t chksum, uint32_t from, uint32_t to);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif      // VSF_USE_TCPIP
+#endif      // __VSF_INET_CHECKSUM_H__
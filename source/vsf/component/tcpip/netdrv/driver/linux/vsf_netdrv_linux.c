@@ -0,0 +1,530 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+/*============================ INCLUDES ======================================*/
+
+// for recvmmsg/sendmmsg
+#ifndef _GNU_SOURCE
+#   define _GNU_SOURCE
+#endif
+
+#include "../../../vsf_tcpip_cfg.h"
+
+#if VSF_USE_TCPIP == ENABLED && VSF_NETDRV_USE_LINUX == ENABLED
+
+#define __VSF_NETDRV_CLASS_INHERIT_NETLINK__
+#define __VSF_NETDRV_LINUX_CLASS_IMPLEMENT
+#include "../../vsf_netdrv.h"
+
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <linux/if_tun.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+/*============================ MACROS ========================================*/
+
+#ifndef VSF_NETDRV_LINUX_CFG_TRACE
+#   define VSF_NETDRV_LINUX_CFG_TRACE           DISABLED
+#endif
+
+// minimum ethernet frame size without fcs
+#define __VSF_NETDRV_LINUX_MIN_FRAME_SIZE       60
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+/*============================ LOCAL VARIABLES ===============================*/
+/*============================ PROTOTYPES ====================================*/
+
+static vsf_err_t __vk_netdrv_linux_netlink_init(vk_netdrv_t *netdrv);
+static vsf_err_t __vk_netdrv_linux_netlink_fini(vk_netdrv_t *netdrv);
+static bool __vk_netdrv_linux_netlink_can_output(vk_netdrv_t *netdrv);
+static vsf_err_t __vk_netdrv_linux_netlink_output(vk_netdrv_t *netdrv, void *netbuf);
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+const struct vk_netlink_op_t vk_netdrv_linux_netlink_op = {
+    .init       = __vk_netdrv_linux_netlink_init,
+    .fini       = __vk_netdrv_linux_netlink_fini,
+    .can_output = __vk_netdrv_linux_netlink_can_output,
+    .output     = __vk_netdrv_linux_netlink_output,
+};
+
+/*============================ IMPLEMENTATION ================================*/
+
+vsf_err_t vk_netdrv_linux_socketpair(int fd[2])
+{
+    return socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fd) < 0 ? VSF_ERR_FAIL : VSF_ERR_NONE;
+}
+
+static int __vk_netdrv_linux_open_tap(char *name)
+{
+    struct ifreq ifr = { 0 };
+    int fd = open("/dev/net/tun", O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+    if (ioctl(fd, TUNSETIFF, &ifr) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+#if VSF_NETDRV_LINUX_CFG_PACKET_MMAP == ENABLED
+static void __vk_netdrv_linux_setup_rx_ring(vk_netdrv_linux_t *linux_netdrv)
+{
+    int version = TPACKET_V2;
+    struct tpacket_req req;
+    uint32_t frame_size = 1, block_size = getpagesize();
+
+    while (frame_size < TPACKET_ALIGN(TPACKET2_HDRLEN) + VSF_NETDRV_LINUX_FRAME_SIZE) {
+        frame_size <<= 1;
+    }
+    if (block_size < frame_size) {
+        block_size = frame_size;
+    }
+    req.tp_frame_size = frame_size;
+    req.tp_frame_nr = VSF_NETDRV_LINUX_CFG_PACKET_MMAP_FRAME_NUM;
+    req.tp_block_size = block_size;
+    req.tp_block_nr = req.tp_frame_nr * frame_size / block_size;
+    req.tp_frame_nr = req.tp_block_nr * block_size / frame_size;
+
+    if (    (setsockopt(linux_netdrv->fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+        ||  (setsockopt(linux_netdrv->fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0)) {
+        goto fallback;
+    }
+    linux_netdrv->rx_ring_size = req.tp_block_nr * block_size;
+    linux_netdrv->rx_ring = mmap(NULL, linux_netdrv->rx_ring_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_LOCKED, linux_netdrv->fd, 0);
+    if (MAP_FAILED == linux_netdrv->rx_ring) {
+        // release the ring in kernel
+        memset(&req, 0, sizeof(req));
+        setsockopt(linux_netdrv->fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+        goto fallback;
+    }
+    linux_netdrv->rx_ring_frame_size = frame_size;
+    linux_netdrv->rx_ring_pos = 0;
+    return;
+
+fallback:
+    vsf_trace_warning("netdrv_linux: PACKET_MMAP not available, use recvmmsg" VSF_TRACE_CFG_LINEEND);
+    linux_netdrv->rx_ring = NULL;
+}
+#endif
+
+static int __vk_netdrv_linux_open_packet(vk_netdrv_linux_t *linux_netdrv)
+{
+    struct sockaddr_ll addr = { 0 };
+    struct packet_mreq mreq = { 0 };
+    int fd = socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, htons(ETH_P_ALL));
+    if (fd < 0) {
+        return -1;
+    }
+
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_ALL);
+    addr.sll_ifindex = if_nametoindex(linux_netdrv->name);
+    if ((0 == addr.sll_ifindex) || (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)) {
+        close(fd);
+        return -1;
+    }
+    // virtual mac address is not the mac of the host interface
+    mreq.mr_ifindex = addr.sll_ifindex;
+    mreq.mr_type = PACKET_MR_PROMISC;
+    setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
+#ifdef PACKET_IGNORE_OUTGOING
+    // frames sent from this host, including other instances on the same interface
+    int ignore_outgoing = 1;
+    setsockopt(fd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &ignore_outgoing, sizeof(ignore_outgoing));
+#endif
+
+    linux_netdrv->fd = fd;
+#if VSF_NETDRV_LINUX_CFG_PACKET_MMAP == ENABLED
+    __vk_netdrv_linux_setup_rx_ring(linux_netdrv);
+#endif
+    return fd;
+}
+
+static void __vk_netdrv_linux_close(vk_netdrv_linux_t *linux_netdrv)
+{
+#if VSF_NETDRV_LINUX_CFG_PACKET_MMAP == ENABLED
+    if (linux_netdrv->rx_ring != NULL) {
+        munmap(linux_netdrv->rx_ring, linux_netdrv->rx_ring_size);
+        linux_netdrv->rx_ring = NULL;
+    }
+#endif
+    if (linux_netdrv->wakeup_fd[0] >= 0) {
+        close(linux_netdrv->wakeup_fd[0]);
+        close(linux_netdrv->wakeup_fd[1]);
+        linux_netdrv->wakeup_fd[0] = linux_netdrv->wakeup_fd[1] = -1;
+    }
+    // fd is closed last, user can check it to know that netdrv is not used any more
+    if (linux_netdrv->fd >= 0) {
+        close(linux_netdrv->fd);
+        __atomic_store_n(&linux_netdrv->fd, -1, __ATOMIC_RELEASE);
+    }
+}
+
+// called in irq context
+static void __vk_netdrv_linux_input(vk_netdrv_linux_t *linux_netdrv, const uint8_t *pkt_data, int_fast32_t pkt_len)
+{
+    const uint8_t bcast_addr[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+    const uint8_t ipv4mcast_addr[] = {0x01, 0x00, 0x5e};
+    const uint8_t ipv6mcast_addr[] = {0x33, 0x33};
+    void *netbuf;
+
+    if (pkt_len < 14) {
+        return;
+    }
+    // source is self, feedback packets?
+    if (!memcmp(pkt_data + 6, linux_netdrv->macaddr.addr_buf, 6)) {
+        return;
+    }
+    // my mac or broad-cast/multi-case
+    if (    memcmp(pkt_data, linux_netdrv->macaddr.addr_buf, 6)
+        &&  memcmp(pkt_data, bcast_addr, 6)
+        &&  memcmp(pkt_data, ipv6mcast_addr, 2)
+        &&  (memcmp(pkt_data, ipv4mcast_addr, 3) || (pkt_data[3] & 0x80))) {
+        return;
+    }
+
+#if VSF_NETDRV_LINUX_CFG_TRACE == ENABLED
+    vsf_trace_debug("netdrv_linux_rx:" VSF_TRACE_CFG_LINEEND);
+    vsf_trace_buffer(VSF_TRACE_DEBUG, (void *)pkt_data, pkt_len);
+#endif
+
+    netbuf = vk_netdrv_alloc_buf(&linux_netdrv->use_as__vk_netdrv_t);
+    if (netbuf != NULL) {
+        vsf_mem_t mem;
+        void *netbuf_cur = netbuf;
+        int_fast32_t len = pkt_len;
+        size_t cur_size;
+
+        do {
+            netbuf_cur = vk_netdrv_read_buf(&linux_netdrv->use_as__vk_netdrv_t, netbuf_cur, &mem);
+            cur_size = min(mem.size, len);
+            memcpy(mem.buffer, pkt_data, cur_size);
+            len -= cur_size;
+            pkt_data += cur_size;
+        } while ((netbuf_cur != NULL) && (len > 0));
+
+        vk_netdrv_on_inputted(&linux_netdrv->use_as__vk_netdrv_t, netbuf, pkt_len);
+    }
+}
+
+// return number of frames received into rx_buffer
+static int __vk_netdrv_linux_recv(vk_netdrv_linux_t *linux_netdrv)
+{
+    int num = 0;
+
+    if (VSF_NETDRV_LINUX_MODE_TAP == linux_netdrv->mode) {
+        // tap is not a socket, read frame by frame until drained
+        ssize_t len;
+        for (; num < VSF_NETDRV_LINUX_CFG_BATCH; num++) {
+            len = read(linux_netdrv->fd, linux_netdrv->rx_buffer[num], VSF_NETDRV_LINUX_FRAME_SIZE);
+            if (len <= 0) {
+                break;
+            }
+            linux_netdrv->rx_len[num] = len;
+        }
+    } else {
+        struct mmsghdr msgs[VSF_NETDRV_LINUX_CFG_BATCH];
+        struct iovec iov[VSF_NETDRV_LINUX_CFG_BATCH];
+
+        memset(msgs, 0, sizeof(msgs));
+        for (int i = 0; i < VSF_NETDRV_LINUX_CFG_BATCH; i++) {
+            iov[i].iov_base = linux_netdrv->rx_buffer[i];
+            iov[i].iov_len = VSF_NETDRV_LINUX_FRAME_SIZE;
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        num = recvmmsg(linux_netdrv->fd, msgs, VSF_NETDRV_LINUX_CFG_BATCH, MSG_DONTWAIT, NULL);
+        for (int i = 0; i < num; i++) {
+            // zero-length message is end of stream after peer of socketpair is closed
+            if (0 == msgs[i].msg_len) {
+                num = i;
+                break;
+            }
+            // truncated frames are dropped in __vk_netdrv_linux_input
+            linux_netdrv->rx_len[i] = (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) ? 0 : msgs[i].msg_len;
+        }
+    }
+    return num < 0 ? 0 : num;
+}
+
+#if VSF_NETDRV_LINUX_CFG_PACKET_MMAP == ENABLED
+// frames are passed to stack directly from the ring, return false if ring is empty
+static bool __vk_netdrv_linux_rx_ring(vk_netdrv_linux_t *linux_netdrv)
+{
+    vsf_arch_irq_thread_t *irq_thread = &linux_netdrv->irq_thread;
+    uint_fast16_t frame_num = linux_netdrv->rx_ring_size / linux_netdrv->rx_ring_frame_size;
+    uint_fast16_t pos = linux_netdrv->rx_ring_pos, num = 0;
+    struct tpacket2_hdr *hdr;
+
+    __vsf_arch_irq_start(irq_thread);
+        while (num < VSF_NETDRV_LINUX_CFG_BATCH) {
+            hdr = (struct tpacket2_hdr *)(linux_netdrv->rx_ring + pos * linux_netdrv->rx_ring_frame_size);
+            if (!(__atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER)) {
+                break;
+            }
+            __vk_netdrv_linux_input(linux_netdrv, (uint8_t *)hdr + hdr->tp_mac, hdr->tp_snaplen);
+            __atomic_store_n(&hdr->tp_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+            pos = (pos + 1) % frame_num;
+            num++;
+        }
+    __vsf_arch_irq_end(irq_thread, false);
+
+    linux_netdrv->rx_ring_pos = pos;
+    return num > 0;
+}
+#endif
+
+static void __vk_netdrv_linux_rx(vk_netdrv_linux_t *linux_netdrv)
+{
+    vsf_arch_irq_thread_t *irq_thread = &linux_netdrv->irq_thread;
+    int num;
+
+#if VSF_NETDRV_LINUX_CFG_PACKET_MMAP == ENABLED
+    if (linux_netdrv->rx_ring != NULL) {
+        while (__vk_netdrv_linux_rx_ring(linux_netdrv));
+        return;
+    }
+#endif
+
+    // all frames received in one batch are inputted in one irq
+    while ((num = __vk_netdrv_linux_recv(linux_netdrv)) > 0) {
+        __vsf_arch_irq_start(irq_thread);
+            for (int i = 0; i < num; i++) {
+                __vk_netdrv_linux_input(linux_netdrv, linux_netdrv->rx_buffer[i], linux_netdrv->rx_len[i]);
+            }
+        __vsf_arch_irq_end(irq_thread, false);
+        if (num < VSF_NETDRV_LINUX_CFG_BATCH) {
+            break;
+        }
+    }
+}
+
+// return false if fd is not writable
+static bool __vk_netdrv_linux_tx(vk_netdrv_linux_t *linux_netdrv)
+{
+    uint_fast16_t head = linux_netdrv->tx_head, tail, num;
+    int sent;
+
+    while (head != (tail = __atomic_load_n(&linux_netdrv->tx_tail, __ATOMIC_ACQUIRE))) {
+        if (VSF_NETDRV_LINUX_MODE_TAP == linux_netdrv->mode) {
+            if (write(linux_netdrv->fd, linux_netdrv->tx_buffer[head], linux_netdrv->tx_len[head]) < 0) {
+                if ((EAGAIN == errno) || (EWOULDBLOCK == errno)) {
+                    return false;
+                }
+            }
+            sent = 1;
+        } else {
+            struct mmsghdr msgs[VSF_NETDRV_LINUX_CFG_BATCH];
+            struct iovec iov[VSF_NETDRV_LINUX_CFG_BATCH];
+            uint_fast16_t idx = head;
+
+            memset(msgs, 0, sizeof(msgs));
+            for (num = 0; (num < VSF_NETDRV_LINUX_CFG_BATCH) && (idx != tail); num++) {
+                iov[num].iov_base = linux_netdrv->tx_buffer[idx];
+                iov[num].iov_len = linux_netdrv->tx_len[idx];
+                msgs[num].msg_hdr.msg_iov = &iov[num];
+                msgs[num].msg_hdr.msg_iovlen = 1;
+                idx = (idx + 1) % VSF_NETDRV_LINUX_CFG_TX_NUM;
+            }
+            sent = sendmmsg(linux_netdrv->fd, msgs, num, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (sent < 0) {
+                if ((EAGAIN == errno) || (EWOULDBLOCK == errno) || (ENOBUFS == errno)) {
+                    return false;
+                }
+                // drop the frame which can not be sent
+                sent = 1;
+            }
+        }
+        head = (head + sent) % VSF_NETDRV_LINUX_CFG_TX_NUM;
+        __atomic_store_n(&linux_netdrv->tx_head, head, __ATOMIC_RELEASE);
+        // pairs with the fence in output, tx_tail is re-read after tx_head is published,
+        //  so either this thread sees the new frame, or output sees the ring drained and wakes it up
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+    return true;
+}
+
+static void __vk_netdrv_linux_netlink_thread(void *arg)
+{
+    vsf_arch_irq_thread_t *irq_thread = arg;
+    vk_netdrv_linux_t *linux_netdrv = container_of(irq_thread, vk_netdrv_linux_t, irq_thread);
+    struct pollfd fds[2];
+    bool is_tx_blocked = false;
+    uint8_t dummy[16];
+
+    __vsf_arch_irq_set_background(irq_thread);
+
+    VSF_TCPIP_ASSERT(6 == linux_netdrv->macaddr.size);
+    fds[0].fd = linux_netdrv->fd;
+    fds[1].fd = linux_netdrv->wakeup_fd[0];
+    fds[1].events = POLLIN;
+    while (!__atomic_load_n(&linux_netdrv->is_closing, __ATOMIC_ACQUIRE)) {
+        fds[0].events = POLLIN | (is_tx_blocked ? POLLOUT : 0);
+        if (poll(fds, dimof(fds), -1) < 0) {
+            continue;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            while (read(linux_netdrv->wakeup_fd[0], dummy, sizeof(dummy)) > 0);
+        }
+        if (fds[0].revents & POLLIN) {
+            __vk_netdrv_linux_rx(linux_netdrv);
+        }
+        // peer of socketpair is closed and frames left are drained, stop polling fd,
+        //  frames to output will be dropped with EPIPE
+        if (fds[0].revents & POLLHUP) {
+            fds[0].fd = -1;
+        }
+        is_tx_blocked = !__vk_netdrv_linux_tx(linux_netdrv);
+    }
+
+    __vk_netdrv_linux_close(linux_netdrv);
+    __vsf_arch_irq_fini(irq_thread);
+}
+
+static vsf_err_t __vk_netdrv_linux_netlink_init(vk_netdrv_t *netdrv)
+{
+    vk_netdrv_linux_t *linux_netdrv = (vk_netdrv_linux_t *)netdrv;
+
+    linux_netdrv->wakeup_fd[0] = linux_netdrv->wakeup_fd[1] = -1;
+#if VSF_NETDRV_LINUX_CFG_PACKET_MMAP == ENABLED
+    linux_netdrv->rx_ring = NULL;
+#endif
+    switch (linux_netdrv->mode) {
+    case VSF_NETDRV_LINUX_MODE_TAP:
+        linux_netdrv->fd = __vk_netdrv_linux_open_tap(linux_netdrv->name);
+        break;
+    case VSF_NETDRV_LINUX_MODE_PACKET:
+        linux_netdrv->fd = __vk_netdrv_linux_open_packet(linux_netdrv);
+        break;
+    case VSF_NETDRV_LINUX_MODE_SOCKETPAIR:
+        // fd is provided by user
+        break;
+    default:
+        linux_netdrv->fd = -1;
+        break;
+    }
+    if (linux_netdrv->fd < 0) {
+        vsf_trace_error("netdrv_linux: fail to open %s, errno %d" VSF_TRACE_CFG_LINEEND,
+                linux_netdrv->name != NULL ? linux_netdrv->name : "", errno);
+        return VSF_ERR_FAIL;
+    }
+
+    if (    (fcntl(linux_netdrv->fd, F_SETFL, fcntl(linux_netdrv->fd, F_GETFL) | O_NONBLOCK) < 0)
+        ||  (pipe2(linux_netdrv->wakeup_fd, O_NONBLOCK | O_CLOEXEC) < 0)) {
+        __vk_netdrv_linux_close(linux_netdrv);
+        return VSF_ERR_FAIL;
+    }
+
+    __atomic_store_n(&linux_netdrv->is_closing, false, __ATOMIC_RELEASE);
+    linux_netdrv->tx_head = linux_netdrv->tx_tail = 0;
+    __vsf_arch_irq_init(&linux_netdrv->irq_thread, "netdrv_linux", __vk_netdrv_linux_netlink_thread, VSF_NETDRV_LINUX_CFG_HW_PRIORITY);
+    return VSF_ERR_NONE;
+}
+
+static void __vk_netdrv_linux_wakeup(vk_netdrv_linux_t *linux_netdrv)
+{
+    uint8_t dummy = 0;
+    write(linux_netdrv->wakeup_fd[1], &dummy, 1);
+}
+
+static vsf_err_t __vk_netdrv_linux_netlink_fini(vk_netdrv_t *netdrv)
+{
+    vk_netdrv_linux_t *linux_netdrv = (vk_netdrv_linux_t *)netdrv;
+
+    // fds are closed in irq_thread
+    if (linux_netdrv->wakeup_fd[1] >= 0) {
+        __atomic_store_n(&linux_netdrv->is_closing, true, __ATOMIC_RELEASE);
+        __vk_netdrv_linux_wakeup(linux_netdrv);
+    }
+    return VSF_ERR_NONE;
+}
+
+static bool __vk_netdrv_linux_netlink_can_output(vk_netdrv_t *netdrv)
+{
+    vk_netdrv_linux_t *linux_netdrv = (vk_netdrv_linux_t *)netdrv;
+    uint_fast16_t tail_next = (linux_netdrv->tx_tail + 1) % VSF_NETDRV_LINUX_CFG_TX_NUM;
+    return tail_next != __atomic_load_n(&linux_netdrv->tx_head, __ATOMIC_ACQUIRE);
+}
+
+static vsf_err_t __vk_netdrv_linux_netlink_output(vk_netdrv_t *netdrv, void *netbuf)
+{
+    vk_netdrv_linux_t *linux_netdrv = (vk_netdrv_linux_t *)netdrv;
+    uint_fast16_t tail = linux_netdrv->tx_tail, head;
+    uint8_t *buffer = linux_netdrv->tx_buffer[tail];
+    uint_fast32_t size = 0;
+    void *netbuf_cur = netbuf;
+    vsf_mem_t mem;
+
+    if (!__vk_netdrv_linux_netlink_can_output(netdrv)) {
+        return VSF_ERR_NOT_ENOUGH_RESOURCES;
+    }
+
+    do {
+        netbuf_cur = vk_netdrv_read_buf(netdrv, netbuf_cur, &mem);
+        if (size + mem.size > VSF_NETDRV_LINUX_FRAME_SIZE) {
+            VSF_TCPIP_ASSERT(false);
+            return VSF_ERR_FAIL;
+        }
+        memcpy(&buffer[size], mem.buffer, mem.size);
+        size += mem.size;
+    } while (netbuf_cur != NULL);
+
+#if VSF_NETDRV_LINUX_CFG_TRACE == ENABLED
+    vsf_trace_debug("netdrv_linux_tx:" VSF_TRACE_CFG_LINEEND);
+    vsf_trace_buffer(VSF_TRACE_DEBUG, buffer, size);
+#endif
+
+    if (size < __VSF_NETDRV_LINUX_MIN_FRAME_SIZE) {
+        memset(&buffer[size], 0, __VSF_NETDRV_LINUX_MIN_FRAME_SIZE - size);
+        size = __VSF_NETDRV_LINUX_MIN_FRAME_SIZE;
+    }
+    linux_netdrv->tx_len[tail] = size;
+
+    __atomic_store_n(&linux_netdrv->tx_tail, (tail + 1) % VSF_NETDRV_LINUX_CFG_TX_NUM, __ATOMIC_RELEASE);
+    // pairs with the fence in __vk_netdrv_linux_tx, tx_head MUST be read after tx_tail is published
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    head = __atomic_load_n(&linux_netdrv->tx_head, __ATOMIC_ACQUIRE);
+    // irq_thread drains all queued frames, so only wakeup if it has drained up to this frame,
+    //  and may be sleeping in poll
+    if (head == tail) {
+        __vk_netdrv_linux_wakeup(linux_netdrv);
+    }
+
+    // frame is copied to tx ring, netbuf can be released now
+    vk_netdrv_on_outputted(&linux_netdrv->use_as__vk_netdrv_t, netbuf, size);
+    return VSF_ERR_NONE;
+}
+
+#endif      // VSF_USE_TCPIP && VSF_NETDRV_USE_LINUX
@@ -0,0 +1,122 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef __VSF_NETDRV_LINUX_H__
+#define __VSF_NETDRV_LINUX_H__
+
+/*============================ INCLUDES ======================================*/
+
+#include "../../../vsf_tcpip_cfg.h"
+
+#if VSF_USE_TCPIP == ENABLED && VSF_NETDRV_USE_LINUX == ENABLED
+
+#if     defined(__VSF_NETDRV_LINUX_CLASS_IMPLEMENT)
+#   undef __VSF_NETDRV_LINUX_CLASS_IMPLEMENT
+#   define __PLOOC_CLASS_IMPLEMENT__
+#endif
+
+#include "utilities/ooc_class.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================ MACROS ========================================*/
+
+// max frames received/sent in one recvmmsg/sendmmsg
+#ifndef VSF_NETDRV_LINUX_CFG_BATCH
+#   define VSF_NETDRV_LINUX_CFG_BATCH               16
+#endif
+
+// frames can be queued for output
+#ifndef VSF_NETDRV_LINUX_CFG_TX_NUM
+#   define VSF_NETDRV_LINUX_CFG_TX_NUM              32
+#endif
+
+// PACKET_MMAP rx ring for packet mode, fall back to recvmmsg if not available
+#ifndef VSF_NETDRV_LINUX_CFG_PACKET_MMAP
+#   define VSF_NETDRV_LINUX_CFG_PACKET_MMAP         ENABLED
+#endif
+#ifndef VSF_NETDRV_LINUX_CFG_PACKET_MMAP_FRAME_NUM
+#   define VSF_NETDRV_LINUX_CFG_PACKET_MMAP_FRAME_NUM   256
+#endif
+
+#define VSF_NETDRV_LINUX_FRAME_SIZE                 (1500 + 14 + 4)
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+
+typedef enum vk_netdrv_linux_mode_t {
+    // attach to TAP device named by name, created if not exists
+    VSF_NETDRV_LINUX_MODE_TAP,
+    // raw AF_PACKET socket on host interface named by name, needs CAP_NET_RAW
+    VSF_NETDRV_LINUX_MODE_PACKET,
+    // SOCK_SEQPACKET socket in fd, normally one end of vk_netdrv_linux_socketpair,
+    //  no privileges required
+    VSF_NETDRV_LINUX_MODE_SOCKETPAIR,
+} vk_netdrv_linux_mode_t;
+
+dcl_simple_class(vk_netdrv_linux_t)
+
+def_simple_class(vk_netdrv_linux_t) {
+    public_member(
+        implement(vk_netdrv_t)
+        vk_netdrv_linux_mode_t mode;
+        char *name;
+        // set to -1 in irq_thread after all resources are released in vk_netdrv_fini
+        int fd;
+    )
+    private_member(
+        vsf_arch_irq_thread_t irq_thread;
+        int wakeup_fd[2];
+        bool is_closing;
+
+        // tx ring, written in vsf, read in irq_thread
+        uint16_t tx_head;
+        uint16_t tx_tail;
+        uint16_t tx_len[VSF_NETDRV_LINUX_CFG_TX_NUM];
+        uint8_t tx_buffer[VSF_NETDRV_LINUX_CFG_TX_NUM][VSF_NETDRV_LINUX_FRAME_SIZE];
+
+        uint8_t rx_buffer[VSF_NETDRV_LINUX_CFG_BATCH][VSF_NETDRV_LINUX_FRAME_SIZE];
+        uint16_t rx_len[VSF_NETDRV_LINUX_CFG_BATCH];
+    )
+#if VSF_NETDRV_LINUX_CFG_PACKET_MMAP == ENABLED
+    private_member(
+        uint8_t *rx_ring;
+        uint32_t rx_ring_size;
+        uint16_t rx_ring_frame_size;
+        uint16_t rx_ring_pos;
+    )
+#endif
+};
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+extern const struct vk_netlink_op_t vk_netdrv_linux_netlink_op;
+
+/*============================ PROTOTYPES ====================================*/
+
+// create a pair of connected SOCK_SEQPACKET sockets for VSF_NETDRV_LINUX_MODE_SOCKETPAIR,
+//  each end can be assigned to a netdrv in this process or passed to a child process
+extern vsf_err_t vk_netdrv_linux_socketpair(int fd[2]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif      // VSF_USE_TCPIP && VSF_NETDRV_USE_LINUX
+#endif      // __VSF_NETDRV_LINUX_H__
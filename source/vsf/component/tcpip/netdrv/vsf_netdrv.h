@@ -163,6 +163,9 @@ extern vsf_err_t vk_netdrv_output(vk_netdrv_t *netdrv, void *netbuf);
 #if VSF_NETDRV_USE_WPCAP == ENABLED
 #   include "./driver/wpcap/vsf_netdrv_wpcap.h"
 #endif
+#if VSF_NETDRV_USE_LINUX == ENABLED
+#   include "./driver/linux/vsf_netdrv_linux.h"
+#endif
 
 #undef __VSF_NETDRV_CLASS_IMPLEMENT
 #undef __VSF_NETDRV_CLASS_INHERIT_NETLINK__
@@ -0,0 +1,675 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+/*============================ INCLUDES ======================================*/
+
+// for accept4
+#ifndef _GNU_SOURCE
+#   define _GNU_SOURCE
+#endif
+
+#include "component/tcpip/vsf_tcpip_cfg.h"
+
+#if VSF_USE_TCPIP == ENABLED && defined(__LINUX__)
+
+#define __VSF_SOCKET_CLASS_INHERIT__
+#define __VSF_SOCKET_LINUX_CLASS_IMPLEMENT
+#include "../../vsf_socket.h"
+
+#include "kernel/vsf_kernel.h"
+
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+/*============================ MACROS ========================================*/
+
+#if VSF_KERNEL_CFG_SUPPORT_SYNC != ENABLED
+#   error VSF_KERNEL_CFG_SUPPORT_SYNC is needed to use socket_linux
+#endif
+
+#define __VSF_SOCKET_LINUX_EVENTS       (EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET)
+#define __VSF_SOCKET_LINUX_RX_EVENTS    (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)
+#define __VSF_SOCKET_LINUX_TX_EVENTS    (EPOLLOUT | EPOLLHUP | EPOLLERR)
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+
+typedef struct vk_socket_linux_local_t {
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+    vsf_arch_epoll_source_t barrier_source;
+#else
+    vsf_arch_irq_thread_t epoll_thread;
+    int epfd;
+    int barrier_fd;
+#endif
+    // sockets removed from epoll are released after the barrier is passed
+    struct {
+        vsf_mutex_t mutex;
+        vsf_eda_t *eda;
+    } barrier;
+
+    // getaddrinfo is blocking, run in dedicated thread
+    struct {
+        vsf_arch_irq_thread_t irq_thread;
+        vsf_arch_irq_request_t irq_request;
+        vsf_mutex_t mutex;
+        vsf_eda_t *eda;
+        const char *name;
+        vk_netdrv_addr_t addr;
+        int ret;
+    } dns;
+
+    bool is_inited;
+    bool is_started;
+} vk_socket_linux_local_t;
+
+/*============================ PROTOTYPES ====================================*/
+
+static vsf_err_t __vk_socket_linux_socket(vk_socket_t *socket, int family, int protocol);
+static vsf_err_t __vk_socket_linux_close(vk_socket_t *socket);
+static vsf_err_t __vk_socket_linux_bind(vk_socket_t *socket, const vk_socket_addr_t *addr);
+static vsf_err_t __vk_socket_linux_listen(vk_socket_t *socket, int backlog);
+static vsf_err_t __vk_socket_linux_connect(vk_socket_t *socket, const vk_socket_addr_t *remote_addr);
+static vsf_err_t __vk_socket_linux_accept(vk_socket_t *socket, vk_socket_addr_t *remote_addr);
+static vsf_err_t __vk_socket_linux_send(vk_socket_t *socket, const void *buf, size_t len, int flags,
+                                    const vk_socket_addr_t *remote_addr);
+static vsf_err_t __vk_socket_linux_recv(vk_socket_t *socket, void *buf, size_t len, int flags,
+                                    const vk_socket_addr_t *remote_addr);
+
+static vsf_err_t __vk_dns_linux_gethostbyname(const char *name, vk_netdrv_addr_t *addr);
+
+/*============================ GLOBAL VARIABLES ==============================*/
+
+const vk_socket_op_t vk_socket_linux_op = {
+    .feature                = VSF_SOCKET_THREAD,
+    .socket                 = __vk_socket_linux_socket,
+    .close                  = __vk_socket_linux_close,
+    .bind                   = __vk_socket_linux_bind,
+    .listen                 = __vk_socket_linux_listen,
+    .connect                = __vk_socket_linux_connect,
+    .accept                 = __vk_socket_linux_accept,
+    .send                   = __vk_socket_linux_send,
+    .recv                   = __vk_socket_linux_recv,
+
+    .protocols              = {
+        .dns                = {
+            .gethostbyname  = __vk_dns_linux_gethostbyname,
+        },
+    },
+};
+
+/*============================ LOCAL VARIABLES ===============================*/
+
+static vk_socket_linux_local_t __vk_socket_linux;
+
+/*============================ IMPLEMENTATION ================================*/
+
+/*----------------------------------------------------------------------------*
+ * epoll                                                                      *
+ *----------------------------------------------------------------------------*/
+
+// called in irq context
+static void __vk_socket_linux_on_events(vk_socket_linux_t *socket_linux, uint32_t events)
+{
+    vsf_eda_t *eda;
+
+    socket_linux->events |= events;
+    if ((events & __VSF_SOCKET_LINUX_RX_EVENTS) && (socket_linux->rx_eda != NULL)) {
+        eda = socket_linux->rx_eda;
+        socket_linux->rx_eda = NULL;
+        vsf_eda_post_evt(eda, VSF_EVT_USER);
+    }
+    if ((events & __VSF_SOCKET_LINUX_TX_EVENTS) && (socket_linux->tx_eda != NULL)) {
+        eda = socket_linux->tx_eda;
+        socket_linux->tx_eda = NULL;
+        vsf_eda_post_evt(eda, VSF_EVT_USER);
+    }
+}
+
+// called in irq context
+static void __vk_socket_linux_on_barrier(int fd)
+{
+    uint64_t cnt;
+    vsf_eda_t *eda;
+
+    if (read(fd, &cnt, sizeof(cnt)) == sizeof(cnt)) {
+        eda = __vk_socket_linux.barrier.eda;
+        if (eda != NULL) {
+            __vk_socket_linux.barrier.eda = NULL;
+            vsf_eda_post_evt(eda, VSF_EVT_USER);
+        }
+    }
+}
+
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+static void __vk_socket_linux_on_source(vsf_arch_epoll_source_t *source, uint32_t events)
+{
+    __vk_socket_linux_on_events(container_of(source, vk_socket_linux_t, source), events);
+}
+
+static void __vk_socket_linux_on_barrier_source(vsf_arch_epoll_source_t *source, uint32_t events)
+{
+    __vk_socket_linux_on_barrier(source->fd);
+}
+#else
+static void __vk_socket_linux_epoll_thread(void *arg)
+{
+    vsf_arch_irq_thread_t *irq_thread = arg;
+    struct epoll_event events[VSF_SOCKET_LINUX_CFG_EPOLL_EVENT_NUM];
+    int num;
+
+    __vsf_arch_irq_set_background(irq_thread);
+
+    while (1) {
+        num = epoll_wait(__vk_socket_linux.epfd, events, dimof(events), -1);
+        if (num <= 0) {
+            continue;
+        }
+
+        // all ready sockets are serviced in one irq context
+        __vsf_arch_irq_start(irq_thread);
+            for (int i = 0; i < num; i++) {
+                if (NULL == events[i].data.ptr) {
+                    __vk_socket_linux_on_barrier(__vk_socket_linux.barrier_fd);
+                } else {
+                    __vk_socket_linux_on_events(events[i].data.ptr, events[i].events);
+                }
+            }
+        __vsf_arch_irq_end(irq_thread, false);
+    }
+}
+#endif
+
+static vsf_err_t __vk_socket_linux_epoll_add(vk_socket_linux_t *socket_linux)
+{
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+    socket_linux->source.fd = socket_linux->fd;
+    socket_linux->source.events = __VSF_SOCKET_LINUX_EVENTS;
+    socket_linux->source.handler = __vk_socket_linux_on_source;
+    return __vsf_arch_epoll_add(&socket_linux->source);
+#else
+    struct epoll_event event = {
+        .events     = __VSF_SOCKET_LINUX_EVENTS,
+        .data.ptr   = socket_linux,
+    };
+    return epoll_ctl(__vk_socket_linux.epfd, EPOLL_CTL_ADD, socket_linux->fd, &event) ?
+                VSF_ERR_FAIL : VSF_ERR_NONE;
+#endif
+}
+
+static void __vk_socket_linux_epoll_del(vk_socket_linux_t *socket_linux)
+{
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+    __vsf_arch_epoll_del(&socket_linux->source);
+#else
+    epoll_ctl(__vk_socket_linux.epfd, EPOLL_CTL_DEL, socket_linux->fd, NULL);
+#endif
+
+    // events of the socket may have been fetched by the epoll thread before removed,
+    //  wait until the epoll thread passes the barrier, then the socket can be released
+    vsf_thread_mutex_enter(&__vk_socket_linux.barrier.mutex, -1);
+        uint64_t cnt = 1;
+        __vk_socket_linux.barrier.eda = vsf_eda_get_cur();
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+        while (write(__vk_socket_linux.barrier_source.fd, &cnt, sizeof(cnt)) != sizeof(cnt));
+#else
+        while (write(__vk_socket_linux.barrier_fd, &cnt, sizeof(cnt)) != sizeof(cnt));
+#endif
+        vsf_thread_wfe(VSF_EVT_USER);
+    vsf_thread_mutex_leave(&__vk_socket_linux.barrier.mutex);
+}
+
+// clear events before trying the operation, new events will come if it would block
+static void __vk_socket_linux_consume(vk_socket_linux_t *socket_linux, uint32_t events)
+{
+    vsf_protect_t orig = vsf_protect_int();
+        socket_linux->events &= ~events;
+    vsf_unprotect_int(orig);
+}
+
+static void __vk_socket_linux_wait(vk_socket_linux_t *socket_linux, uint32_t events)
+{
+    vsf_eda_t **eda = (events & EPOLLOUT) ? &socket_linux->tx_eda : &socket_linux->rx_eda;
+
+    vsf_protect_t orig = vsf_protect_int();
+    if (socket_linux->events & events) {
+        vsf_unprotect_int(orig);
+        return;
+    }
+    VSF_TCPIP_ASSERT(NULL == *eda);
+    *eda = vsf_eda_get_cur();
+    vsf_unprotect_int(orig);
+    vsf_thread_wfe(VSF_EVT_USER);
+}
+
+/*----------------------------------------------------------------------------*
+ * dns                                                                        *
+ *----------------------------------------------------------------------------*/
+
+static void __vk_socket_linux_dns_thread(void *arg)
+{
+    vsf_arch_irq_thread_t *irq_thread = arg;
+    struct addrinfo hints = { 0 }, *result;
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    __vsf_arch_irq_set_background(irq_thread);
+
+    while (1) {
+        __vsf_arch_irq_request_pend(&__vk_socket_linux.dns.irq_request);
+
+        __vk_socket_linux.dns.ret = getaddrinfo(__vk_socket_linux.dns.name, NULL, &hints, &result);
+        if (0 == __vk_socket_linux.dns.ret) {
+            vk_netdrv_addr_t *addr = &__vk_socket_linux.dns.addr;
+            switch (result->ai_family) {
+            case AF_INET:
+                addr->size = 4;
+                addr->addr32 = ((struct sockaddr_in *)result->ai_addr)->sin_addr.s_addr;
+                break;
+            case AF_INET6:
+                VSF_TCPIP_ASSERT(sizeof(struct in6_addr) <= sizeof(addr->addr_buf));
+                addr->size = sizeof(struct in6_addr);
+                memcpy(addr->addr_buf, &((struct sockaddr_in6 *)result->ai_addr)->sin6_addr, addr->size);
+                break;
+            default:
+                __vk_socket_linux.dns.ret = EAI_FAMILY;
+                break;
+            }
+            freeaddrinfo(result);
+        }
+
+        __vsf_arch_irq_start(irq_thread);
+            vsf_eda_post_evt(__vk_socket_linux.dns.eda, VSF_EVT_USER);
+        __vsf_arch_irq_end(irq_thread, false);
+    }
+
+    __vsf_arch_irq_fini(irq_thread);
+}
+
+static vsf_err_t __vk_dns_linux_gethostbyname(const char *name, vk_netdrv_addr_t *addr)
+{
+    int ret;
+
+    VSF_TCPIP_ASSERT(__vk_socket_linux.is_started);
+
+    vsf_thread_mutex_enter(&__vk_socket_linux.dns.mutex, -1);
+        __vk_socket_linux.dns.eda = vsf_eda_get_cur();
+        __vk_socket_linux.dns.name = name;
+        __vsf_arch_irq_request_send(&__vk_socket_linux.dns.irq_request);
+        vsf_thread_wfe(VSF_EVT_USER);
+        ret = __vk_socket_linux.dns.ret;
+        if ((0 == ret) && (addr != NULL)) {
+            *addr = __vk_socket_linux.dns.addr;
+        }
+    vsf_thread_mutex_leave(&__vk_socket_linux.dns.mutex);
+    return ret != 0 ? VSF_ERR_FAIL : VSF_ERR_NONE;
+}
+
+/*----------------------------------------------------------------------------*
+ * socket                                                                     *
+ *----------------------------------------------------------------------------*/
+
+vsf_err_t vk_socket_linux_init(void)
+{
+    if (!__vk_socket_linux.is_inited) {
+        int barrier_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (barrier_fd < 0) {
+            return VSF_ERR_FAIL;
+        }
+
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+        __vk_socket_linux.barrier_source.fd = barrier_fd;
+        __vk_socket_linux.barrier_source.events = EPOLLIN;
+        __vk_socket_linux.barrier_source.handler = __vk_socket_linux_on_barrier_source;
+        if (__vsf_arch_epoll_add(&__vk_socket_linux.barrier_source) != VSF_ERR_NONE) {
+            close(barrier_fd);
+            return VSF_ERR_FAIL;
+        }
+#else
+        struct epoll_event event = {
+            .events     = EPOLLIN,
+            .data.ptr   = NULL,
+        };
+        __vk_socket_linux.barrier_fd = barrier_fd;
+        __vk_socket_linux.epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (    (__vk_socket_linux.epfd < 0)
+            ||  epoll_ctl(__vk_socket_linux.epfd, EPOLL_CTL_ADD, barrier_fd, &event)) {
+            if (__vk_socket_linux.epfd >= 0) {
+                close(__vk_socket_linux.epfd);
+            }
+            close(barrier_fd);
+            return VSF_ERR_FAIL;
+        }
+        __vsf_arch_irq_init(&__vk_socket_linux.epoll_thread, "socket_linux_epoll",
+                    __vk_socket_linux_epoll_thread, VSF_SOCKET_LINUX_CFG_HW_PRIORITY);
+#endif
+
+        __vk_socket_linux.is_inited = true;
+        vsf_eda_mutex_init(&__vk_socket_linux.barrier.mutex);
+        vsf_eda_mutex_init(&__vk_socket_linux.dns.mutex);
+        __vsf_arch_irq_request_init(&__vk_socket_linux.dns.irq_request);
+        __vsf_arch_irq_init(&__vk_socket_linux.dns.irq_thread, "socket_linux_dns",
+                    __vk_socket_linux_dns_thread, VSF_SOCKET_LINUX_CFG_HW_PRIORITY);
+    }
+
+    VSF_TCPIP_ASSERT(!__vk_socket_linux.is_started);
+    __vk_socket_linux.is_started = true;
+    return VSF_ERR_NONE;
+}
+
+vsf_err_t vk_socket_linux_fini(void)
+{
+    VSF_TCPIP_ASSERT(__vk_socket_linux.is_started);
+    __vk_socket_linux.is_started = false;
+    return VSF_ERR_NONE;
+}
+
+static socklen_t __vk_socket_linux_to_sockaddr(const vk_socket_addr_t *addr,
+                    int family, struct sockaddr_storage *sockaddr)
+{
+    memset(sockaddr, 0, sizeof(*sockaddr));
+    switch (family) {
+    case AF_INET: {
+            struct sockaddr_in *sockaddr_in = (struct sockaddr_in *)sockaddr;
+            sockaddr_in->sin_family = AF_INET;
+            sockaddr_in->sin_addr.s_addr = addr->addr.addr32;
+            sockaddr_in->sin_port = htons(addr->port);
+            return sizeof(*sockaddr_in);
+        }
+    case AF_INET6: {
+            struct sockaddr_in6 *sockaddr_in6 = (struct sockaddr_in6 *)sockaddr;
+            sockaddr_in6->sin6_family = AF_INET6;
+            memcpy(&sockaddr_in6->sin6_addr, addr->addr.addr_buf, sizeof(sockaddr_in6->sin6_addr));
+            sockaddr_in6->sin6_port = htons(addr->port);
+            return sizeof(*sockaddr_in6);
+        }
+    default:
+        VSF_TCPIP_ASSERT(false);
+        return 0;
+    }
+}
+
+static void __vk_socket_linux_from_sockaddr(vk_socket_addr_t *addr,
+                    const struct sockaddr_storage *sockaddr)
+{
+    switch (sockaddr->ss_family) {
+    case AF_INET: {
+            const struct sockaddr_in *sockaddr_in = (const struct sockaddr_in *)sockaddr;
+            addr->addr.size = 4;
+            addr->addr.addr32 = sockaddr_in->sin_addr.s_addr;
+            addr->port = ntohs(sockaddr_in->sin_port);
+        }
+        break;
+    case AF_INET6: {
+            const struct sockaddr_in6 *sockaddr_in6 = (const struct sockaddr_in6 *)sockaddr;
+            addr->addr.size = sizeof(sockaddr_in6->sin6_addr);
+            memcpy(addr->addr.addr_buf, &sockaddr_in6->sin6_addr, addr->addr.size);
+            addr->port = ntohs(sockaddr_in6->sin6_port);
+        }
+        break;
+    }
+}
+
+static vsf_err_t __vk_socket_linux_attach(vk_socket_linux_t *socket_linux, int fd,
+                    int family, int protocol)
+{
+    socket_linux->fd = fd;
+    socket_linux->accepted_fd = -1;
+    socket_linux->family = family;
+    socket_linux->protocol = protocol;
+    socket_linux->rx_size = 0;
+    socket_linux->events = 0;
+    socket_linux->rx_eda = NULL;
+    socket_linux->tx_eda = NULL;
+
+    if (__vk_socket_linux_epoll_add(socket_linux) != VSF_ERR_NONE) {
+        close(fd);
+        return VSF_ERR_FAIL;
+    }
+    socket_linux->is_inited = true;
+    return VSF_ERR_NONE;
+}
+
+static vsf_err_t __vk_socket_linux_socket(vk_socket_t *s, int family, int protocol)
+{
+    VSF_TCPIP_ASSERT(__vk_socket_linux.is_started);
+    vk_socket_linux_t *socket_linux = (vk_socket_linux_t *)s;
+    VSF_TCPIP_ASSERT(!socket_linux->is_inited);
+
+    int type, fd;
+    switch (protocol) {
+    case VSF_SOCKET_IPPROTO_TCP:    type = SOCK_STREAM; break;
+    case VSF_SOCKET_IPPROTO_UDP:    type = SOCK_DGRAM;  break;
+    default:                        VSF_TCPIP_ASSERT(false); return VSF_ERR_NOT_SUPPORT;
+    }
+
+    fd = socket(family, type | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol);
+    if (fd < 0) {
+        return VSF_ERR_FAIL;
+    }
+    return __vk_socket_linux_attach(socket_linux, fd, family, protocol);
+}
+
+static vsf_err_t __vk_socket_linux_close(vk_socket_t *s)
+{
+    VSF_TCPIP_ASSERT(__vk_socket_linux.is_started);
+    vk_socket_linux_t *socket_linux = (vk_socket_linux_t *)s;
+    VSF_TCPIP_ASSERT(socket_linux->is_inited);
+    VSF_TCPIP_ASSERT((NULL == socket_linux->rx_eda) && (NULL == socket_linux->tx_eda));
+
+    __vk_socket_linux_epoll_del(socket_linux);
+    if (socket_linux->accepted_fd >= 0) {
+        close(socket_linux->accepted_fd);
+    }
+    socket_linux->is_inited = false;
+    return close(socket_linux->fd) < 0 ? VSF_ERR_FAIL : VSF_ERR_NONE;
+}
+
+static vsf_err_t __vk_socket_linux_bind(vk_socket_t *s, const vk_socket_addr_t *addr)
+{
+    VSF_TCPIP_ASSERT(__vk_socket_linux.is_started);
+    vk_socket_linux_t *socket_linux = (vk_socket_linux_t *)s;
+    VSF_TCPIP_ASSERT(socket_linux->is_inited);
+
+    struct sockaddr_storage sockaddr;
+    socklen_t socklen = __vk_socket_linux_to_sockaddr(addr, socket_linux->family, &sockaddr);
+    return bind(socket_linux->fd, (const struct sockaddr *)&sockaddr, socklen) < 0 ?
+                VSF_ERR_FAIL : VSF_ERR_NONE;
+}
+
+static vsf_err_t __vk_socket_linux_listen(vk_socket_t *s, int backlog)
+{
+    VSF_TCPIP_ASSERT(__vk_socket_linux.is_started);
+    vk_socket_linux_t *socket_linux = (vk_socket_linux_t *)s;
+    VSF_TCPIP_ASSERT(socket_linux->is_inited);
+
+    return listen(socket_linux->fd, backlog) < 0 ? VSF_ERR_FAIL : VSF_ERR_NONE;
+}
+
+static vsf_err_t __vk_socket_linux_connect(vk_socket_t *s, const vk_socket_addr_t *remote_addr)
+{
+    VSF_TCPIP_ASSERT(__vk_socket_linux.is_started);
+    vk_socket_linux_t *socket_linux = (vk_socket_linux_t *)s;
+    VSF_TCPIP_ASSERT(socket_linux->is_inited);
+
+    struct sockaddr_storage sockaddr;
+    socklen_t socklen = __vk_socket_linux_to_sockaddr(remote_addr, socket_linux->family, &sockaddr);
+    int err;
+
+    // unconnected socket reports EPOLLOUT | EPOLLHUP, clear them
+    __vk_socket_linux_consume(socket_linux, __VSF_SOCKET_LINUX_TX_EVENTS);
+    if (connect(socket_linux->fd, (const struct sockaddr *)&sockaddr, socklen) < 0) {
+        if (errno != EINPROGRESS) {
+            return VSF_ERR_FAIL;
+        }
+
+        __vk_socket_linux_wait(socket_linux, __VSF_SOCKET_LINUX_TX_EVENTS);
+        socklen = sizeof(err);
+        if (    (getsockopt(socket_linux->fd, SOL_SOCKET, SO_ERROR, &err, &socklen) < 0)
+            ||  (err != 0)) {
+            return VSF_ERR_FAIL;
+        }
+    }
+    return VSF_ERR_NONE;
+}
+
+static vsf_err_t __vk_socket_linux_accept(vk_socket_t *s, vk_socket_addr_t *remote_addr)
+{
+    VSF_TCPIP_ASSERT(__vk_socket_linux.is_started);
+    vk_socket_linux_t *socket_linux = (vk_socket_linux_t *)s;
+    VSF_TCPIP_ASSERT(socket_linux->is_inited);
+
+    struct sockaddr_storage sockaddr;
+    socklen_t socklen;
+    int fd;
+
+    while (1) {
+        __vk_socket_linux_consume(socket_linux, __VSF_SOCKET_LINUX_RX_EVENTS);
+        socklen = sizeof(sockaddr);
+        fd = accept4(socket_linux->fd, (struct sockaddr *)&sockaddr, &socklen,
+                    SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0) {
+            break;
+        } else if (EINTR == errno) {
+            continue;
+        } else if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+            return VSF_ERR_FAIL;
+        }
+        __vk_socket_linux_wait(socket_linux, __VSF_SOCKET_LINUX_RX_EVENTS);
+    }
+
+    // connection not claimed by vk_socket_linux_accept is dropped
+    if (socket_linux->accepted_fd >= 0) {
+        close(socket_linux->accepted_fd);
+    }
+    socket_linux->accepted_fd = fd;
+    if (remote_addr != NULL) {
+        __vk_socket_linux_from_sockaddr(remote_addr, &sockaddr);
+    }
+    return VSF_ERR_NONE;
+}
+
+vsf_err_t vk_socket_linux_accept(vk_socket_linux_t *socket_linux,
+                    vk_socket_linux_t *new_socket, vk_socket_addr_t *remote_addr)
+{
+    VSF_TCPIP_ASSERT((new_socket != NULL) && !new_socket->is_inited);
+
+    vsf_err_t err = __vk_socket_linux_accept(&socket_linux->use_as__vk_socket_t, remote_addr);
+    if (VSF_ERR_NONE == err) {
+        int fd = socket_linux->accepted_fd;
+        socket_linux->accepted_fd = -1;
+        err = __vk_socket_linux_attach(new_socket, fd, socket_linux->family, socket_linux->protocol);
+    }
+    return err;
+}
+
+static vsf_err_t __vk_socket_linux_send(vk_socket_t *s, const void *buf, size_t len, int flags,
+                                    const vk_socket_addr_t *remote_addr)
+{
+    VSF_TCPIP_ASSERT(__vk_socket_linux.is_started);
+    vk_socket_linux_t *socket_linux = (vk_socket_linux_t *)s;
+    VSF_TCPIP_ASSERT(socket_linux->is_inited);
+
+    struct sockaddr_storage sockaddr;
+    socklen_t socklen = 0;
+    ssize_t ret;
+
+    if (remote_addr != NULL) {
+        socklen = __vk_socket_linux_to_sockaddr(remote_addr, socket_linux->family, &sockaddr);
+    }
+    flags |= MSG_NOSIGNAL;
+
+    // stream socket sends all data, datagram socket sends one datagram
+    while (1) {
+        __vk_socket_linux_consume(socket_linux, __VSF_SOCKET_LINUX_TX_EVENTS);
+        ret = sendto(socket_linux->fd, buf, len, flags,
+                    socklen > 0 ? (const struct sockaddr *)&sockaddr : NULL, socklen);
+        if (ret >= 0) {
+            if (    (socket_linux->protocol != VSF_SOCKET_IPPROTO_TCP)
+                ||  ((size_t)ret >= len)) {
+                return VSF_ERR_NONE;
+            }
+            buf = (const uint8_t *)buf + ret;
+            len -= ret;
+            continue;
+        } else if (EINTR == errno) {
+            continue;
+        } else if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+            return VSF_ERR_FAIL;
+        }
+        __vk_socket_linux_wait(socket_linux, __VSF_SOCKET_LINUX_TX_EVENTS);
+    }
+}
+
+// source address is written back to remote_addr if not NULL
+static vsf_err_t __vk_socket_linux_recv(vk_socket_t *s, void *buf, size_t len, int flags,
+                                    const vk_socket_addr_t *remote_addr)
+{
+    VSF_TCPIP_ASSERT(__vk_socket_linux.is_started);
+    vk_socket_linux_t *socket_linux = (vk_socket_linux_t *)s;
+    VSF_TCPIP_ASSERT(socket_linux->is_inited);
+
+    struct sockaddr_storage sockaddr;
+    socklen_t socklen;
+    bool is_wait_all = !!(flags & MSG_WAITALL);
+    ssize_t ret;
+
+    // socket is non-blocking, MSG_WAITALL is implemented here
+    flags &= ~MSG_WAITALL;
+    socket_linux->rx_size = 0;
+
+    while (1) {
+        __vk_socket_linux_consume(socket_linux, __VSF_SOCKET_LINUX_RX_EVENTS);
+        socklen = sizeof(sockaddr);
+        ret = recvfrom(socket_linux->fd, (uint8_t *)buf + socket_linux->rx_size,
+                    len - socket_linux->rx_size, flags, (struct sockaddr *)&sockaddr, &socklen);
+        if (ret > 0) {
+            if ((remote_addr != NULL) && (socklen > 0)) {
+                __vk_socket_linux_from_sockaddr((vk_socket_addr_t *)remote_addr, &sockaddr);
+            }
+            socket_linux->rx_size += ret;
+            if (    !is_wait_all
+                ||  (socket_linux->protocol != VSF_SOCKET_IPPROTO_TCP)
+                ||  (socket_linux->rx_size >= len)) {
+                return VSF_ERR_NONE;
+            }
+            continue;
+        } else if (0 == ret) {
+            // closed by peer, or zero-length datagram
+            return VSF_ERR_NONE;
+        } else if (EINTR == errno) {
+            continue;
+        } else if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+            return VSF_ERR_FAIL;
+        }
+        __vk_socket_linux_wait(socket_linux, __VSF_SOCKET_LINUX_RX_EVENTS);
+    }
+}
+
+size_t vk_socket_linux_get_rx_size(vk_socket_linux_t *socket_linux)
+{
+    return socket_linux->rx_size;
+}
+
+#endif      // VSF_USE_TCPIP && __LINUX__
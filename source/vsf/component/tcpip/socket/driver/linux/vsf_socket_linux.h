@@ -0,0 +1,107 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef __VSF_SOCKET_LINUX_H__
+#define __VSF_SOCKET_LINUX_H__
+
+/*============================ INCLUDES ======================================*/
+
+#include "component/tcpip/vsf_tcpip_cfg.h"
+
+#if VSF_USE_TCPIP == ENABLED && defined(__LINUX__)
+
+#include "utilities/vsf_utilities.h"
+#include "hal/arch/vsf_arch.h"
+#include "kernel/vsf_kernel.h"
+
+#if     defined(__VSF_SOCKET_LINUX_CLASS_IMPLEMENT)
+#   undef __VSF_SOCKET_LINUX_CLASS_IMPLEMENT
+#   define __PLOOC_CLASS_IMPLEMENT__
+#endif
+
+#include "utilities/ooc_class.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================ MACROS ========================================*/
+
+// max events handled in one irq of the epoll thread,
+//  not used if sockets are serviced by the epoll thread of the arch
+#ifndef VSF_SOCKET_LINUX_CFG_EPOLL_EVENT_NUM
+#   define VSF_SOCKET_LINUX_CFG_EPOLL_EVENT_NUM     64
+#endif
+
+#ifndef VSF_SOCKET_LINUX_CFG_HW_PRIORITY
+#   define VSF_SOCKET_LINUX_CFG_HW_PRIORITY         vsf_arch_prio_0
+#endif
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+
+dcl_simple_class(vk_socket_linux_t)
+
+def_simple_class(vk_socket_linux_t) {
+    public_member(
+        implement(vk_socket_t)
+    )
+    private_member(
+        bool is_inited;
+
+        int family;
+        int protocol;
+        int fd;
+        // connection accepted by accept operation, claimed by vk_socket_linux_accept
+        int accepted_fd;
+        // size of the last received data
+        size_t rx_size;
+
+        // epoll events not consumed yet, set in irq context
+        uint32_t events;
+        vsf_eda_t *rx_eda;
+        vsf_eda_t *tx_eda;
+    )
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+    private_member(
+        vsf_arch_epoll_source_t source;
+    )
+#endif
+};
+
+/*============================ INCLUDES ======================================*/
+/*============================ GLOBAL VARIABLES ==============================*/
+
+extern const vk_socket_op_t vk_socket_linux_op;
+
+/*============================ PROTOTYPES ====================================*/
+
+extern vsf_err_t vk_socket_linux_init(void);
+extern vsf_err_t vk_socket_linux_fini(void);
+
+// accept a connection on socket, and open new_socket for it
+extern vsf_err_t vk_socket_linux_accept(vk_socket_linux_t *socket,
+                    vk_socket_linux_t *new_socket, vk_socket_addr_t *remote_addr);
+// size of data received by last recv/recvfrom, 0 means connection closed by peer
+extern size_t vk_socket_linux_get_rx_size(vk_socket_linux_t *socket);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif      // VSF_USE_TCPIP && __LINUX__
+#endif      // __VSF_SOCKET_LINUX_H__
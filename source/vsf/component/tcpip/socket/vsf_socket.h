@@ -137,6 +137,9 @@ extern vsf_err_t vk_dns_gethostbyname(const char *name, vk_netdrv_addr_t *addr);
 #if defined(__WIN__)
 #   include "./driver/win/vsf_socket_win.h"
 #endif
+#if defined(__LINUX__)
+#   include "./driver/linux/vsf_socket_linux.h"
+#endif
 
 #endif      // VSF_USE_TCPIP
 #endif      // __VSF_NETDRV_H__
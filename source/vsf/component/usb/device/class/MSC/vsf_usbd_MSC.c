@@ -23,6 +23,7 @@
 
 #define __VSF_EDA_CLASS_INHERIT__
 #define __VSF_USBD_CLASS_INHERIT__
+#define __VSF_SCSI_CLASS_INHERIT__
 #define __VSF_USBD_MSC_CLASS_IMPLEMENT
 
 #include "kernel/vsf_kernel.h"
@@ -35,6 +36,8 @@
 
 enum {
     VSF_EVT_EXECUTE = VSF_EVT_USER + 0,
+    VSF_EVT_PIPELINE_SCSI_DONE,
+    VSF_EVT_PIPELINE_USB_DONE,
 };
 
 /*============================ PROTOTYPES ====================================*/
@@ -55,6 +58,7 @@ const vk_usbd_class_op_t vk_usbd_msc = {
 static void __vk_usbd_msc_send_csw(void *p);
 static void __vk_usbd_msc_on_cbw(void *p);
 static void __vk_usbd_msc_on_idle(void *p);
+static void __vk_usbd_msc_pipeline_kick(vk_usbd_msc_t *msc);
 
 /*============================ IMPLEMENTATION ================================*/
 
@@ -109,6 +113,134 @@ static void __vk_usbd_msc_on_data_in(void *p)
     __vk_usbd_msc_send_csw(msc);
 }
 
+static void __vk_usbd_msc_on_pipeline_data(void *p)
+{
+    vsf_eda_post_evt(&((vk_usbd_msc_t *)p)->eda, VSF_EVT_PIPELINE_USB_DONE);
+}
+
+static uint8_t * __vk_usbd_msc_pipeline_slice(vk_usbd_msc_t *msc, uint_fast32_t pos)
+{
+    uint_fast32_t idx = (pos / msc->pipeline.slice_size) % VSF_USBD_MSC_CFG_PIPELINE_BUFFER_NUM;
+    return &msc->buffer[idx * msc->pipeline.slice_size];
+}
+
+static bool __vk_usbd_msc_pipeline_start(vk_usbd_msc_t *msc)
+{
+    vk_usbd_msc_pipeline_t *pipeline = &msc->pipeline;
+    usb_msc_cbw_t *cbw = &msc->ctx.cbw;
+    bool is_in = (cbw->bmCBWFlags & USB_DIR_MASK) == USB_DIR_IN;
+    uint_fast32_t total = le32_to_cpu(cbw->dCBWDataTransferLength);
+    uint_fast32_t slice_size;
+    uint64_t addr;
+    uint32_t block_num;
+
+    if (    (NULL == msc->buffer)
+        ||  !vk_scsi_get_rw_param(cbw->CBWCB, &addr, &block_num)
+        ||  (0 == block_num) || (total % block_num)
+        ||  (is_in != ((cbw->CBWCB[0] & 0x1F) == SCSI_CMDCODE_READ))) {
+        return false;
+    }
+
+    pipeline->block_size = total / block_num;
+    slice_size = msc->buffer_size / VSF_USBD_MSC_CFG_PIPELINE_BUFFER_NUM;
+    slice_size -= slice_size % pipeline->block_size;
+    if (0 == slice_size) {
+        return false;
+    }
+
+    memcpy(pipeline->cbd, cbw->CBWCB, sizeof(pipeline->cbd));
+    pipeline->addr = addr;
+    pipeline->slice_size = slice_size;
+    pipeline->total = total;
+    pipeline->scsi_pos = pipeline->scsi_done = 0;
+    pipeline->usb_pos = pipeline->usb_done = 0;
+    pipeline->is_in = is_in;
+    pipeline->is_scsi_busy = false;
+    pipeline->is_usb_busy = false;
+    pipeline->is_failed = false;
+    __vk_usbd_msc_pipeline_kick(msc);
+    return true;
+}
+
+static void __vk_usbd_msc_pipeline_kick(vk_usbd_msc_t *msc)
+{
+    vk_usbd_msc_pipeline_t *pipeline = &msc->pipeline;
+    uint_fast32_t window = VSF_USBD_MSC_CFG_PIPELINE_BUFFER_NUM * pipeline->slice_size;
+    uint_fast32_t size;
+    bool is_ready;
+
+    if (pipeline->is_failed) {
+        if (!pipeline->is_scsi_busy && !pipeline->is_usb_busy) {
+            msc->ctx.csw.dCSWDataResidue = cpu_to_le32(pipeline->total - pipeline->usb_done);
+            __vk_usbd_msc_error(msc, USB_MSC_CSW_FAIL);
+        }
+        return;
+    }
+
+    // for READ, scsi fills slices for usb; for WRITE, usb fills slices for scsi
+    if (!pipeline->is_scsi_busy && (pipeline->scsi_pos < pipeline->total)) {
+        is_ready = pipeline->is_in ?
+                (pipeline->scsi_pos - pipeline->usb_done < window)
+            :   (pipeline->scsi_pos < pipeline->usb_done);
+        if (is_ready) {
+            size = min(pipeline->slice_size, pipeline->total - pipeline->scsi_pos);
+            vk_scsi_set_rw_param(pipeline->cbd,
+                    pipeline->addr + pipeline->scsi_pos / pipeline->block_size,
+                    size / pipeline->block_size);
+            pipeline->mem.buffer = __vk_usbd_msc_pipeline_slice(msc, pipeline->scsi_pos);
+            pipeline->mem.size = size;
+            pipeline->scsi_pos += size;
+            pipeline->is_scsi_busy = true;
+            vsf_eda_post_evt(&msc->scsi_eda, VSF_EVT_EXECUTE);
+        }
+    }
+
+    if (!pipeline->is_usb_busy && (pipeline->usb_pos < pipeline->total)) {
+        is_ready = pipeline->is_in ?
+                (pipeline->usb_pos < pipeline->scsi_done)
+            :   (pipeline->usb_pos - pipeline->scsi_done < window);
+        if (is_ready) {
+            vk_usbd_trans_t *trans = &msc->ep_stream.use_as__vk_usbd_trans_t;
+
+            size = min(pipeline->slice_size, pipeline->total - pipeline->usb_pos);
+            trans->buffer = __vk_usbd_msc_pipeline_slice(msc, pipeline->usb_pos);
+            trans->size = size;
+            trans->on_finish = __vk_usbd_msc_on_pipeline_data;
+            trans->param = msc;
+            pipeline->usb_pos += size;
+            pipeline->is_usb_busy = true;
+            if (pipeline->is_in) {
+                trans->ep = msc->ep_in;
+                vk_usbd_ep_send(msc->dev, trans);
+            } else {
+                trans->ep = msc->ep_out;
+                vk_usbd_ep_recv(msc->dev, trans);
+            }
+        }
+    }
+
+    if ((pipeline->scsi_done == pipeline->total) && (pipeline->usb_done == pipeline->total)) {
+        msc->ctx.csw.dCSWDataResidue = 0;
+        msc->ctx.csw.dCSWStatus = USB_MSC_CSW_OK;
+        __vk_usbd_msc_send_csw(msc);
+    }
+}
+
+static void __vk_usbd_msc_scsi_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
+{
+    vk_usbd_msc_t *msc = container_of(eda, vk_usbd_msc_t, scsi_eda);
+
+    switch (evt) {
+    case VSF_EVT_EXECUTE:
+        vk_scsi_execute(msc->scsi, msc->pipeline.cbd, &msc->pipeline.mem);
+        break;
+    case VSF_EVT_RETURN:
+        msc->pipeline.scsi_result = vsf_eda_get_return_value();
+        vsf_eda_post_evt(&msc->eda, VSF_EVT_PIPELINE_SCSI_DONE);
+        break;
+    }
+}
+
 static void __vk_usbd_msc_on_cbw(void *p)
 {
     vk_usbd_msc_t *msc = p;
@@ -126,17 +258,19 @@ static void __vk_usbd_msc_on_cbw(void *p)
         return;
     }
 
-    if (    vk_scsi_prepare_buffer(msc->scsi, msc->ctx.cbw.CBWCB, &trans->use_as__vsf_mem_t)
-        &&  ((cbw->bmCBWFlags & USB_DIR_MASK) == USB_DIR_OUT)
-        &&  (cbw->dCBWDataTransferLength > 0)) {
+    if (!vk_scsi_prepare_buffer(msc->scsi, msc->ctx.cbw.CBWCB, &trans->use_as__vsf_mem_t)) {
+        // trans->buffer still points to cbw, clear it to select pipeline or stream mode
+        trans->buffer = NULL;
+    } else if (     ((cbw->bmCBWFlags & USB_DIR_MASK) == USB_DIR_OUT)
+                &&  (cbw->dCBWDataTransferLength > 0)) {
 
         trans->ep = msc->ep_out;
         trans->on_finish = __vk_usbd_msc_on_data_out;
         trans->param = msc;
         vk_usbd_ep_recv(msc->dev, trans);
-    } else {
-        vsf_eda_post_evt(&msc->eda, VSF_EVT_EXECUTE);
+        return;
     }
+    vsf_eda_post_evt(&msc->eda, VSF_EVT_EXECUTE);
 }
 
 static void __vk_usbd_msc_on_idle(void *p)
@@ -199,11 +333,30 @@ static void __vk_usbd_msc_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
             }
         }
         break;
+    case VSF_EVT_PIPELINE_SCSI_DONE:
+        msc->pipeline.is_scsi_busy = false;
+        if (msc->pipeline.scsi_result < 0) {
+            msc->pipeline.is_failed = true;
+        } else {
+            msc->pipeline.scsi_done = msc->pipeline.scsi_pos;
+        }
+        __vk_usbd_msc_pipeline_kick(msc);
+        break;
+    case VSF_EVT_PIPELINE_USB_DONE:
+        msc->pipeline.is_usb_busy = false;
+        msc->pipeline.usb_done = msc->pipeline.usb_pos - trans->size;
+        if (trans->size > 0) {
+            msc->pipeline.is_failed = true;
+        }
+        __vk_usbd_msc_pipeline_kick(msc);
+        break;
     case VSF_EVT_EXECUTE:
         if (cbw->dCBWDataTransferLength > 0) {
             if (trans->buffer != NULL) {
                 msc->is_stream = false;
                 vk_scsi_execute(msc->scsi, cbw->CBWCB, &trans->use_as__vsf_mem_t);
+            } else if (__vk_usbd_msc_pipeline_start(msc)) {
+                msc->is_stream = false;
             } else if (msc->stream != NULL) {
                 msc->is_stream = true;
                 msc->ep_stream.stream = msc->stream;
@@ -244,6 +397,12 @@ static vsf_err_t __vk_usbd_msc_init(vk_usbd_dev_t *dev, vk_usbd_ifs_t *ifs)
     msc->ep_stream.zlp = false;
     msc->ep_stream.callback.param = msc;
 
+    msc->scsi_eda.fn.evthandler = __vk_usbd_msc_scsi_evthandler;
+#if VSF_KERNEL_CFG_EDA_SUPPORT_ON_TERMINATE == ENABLED
+    msc->scsi_eda.on_terminate = NULL;
+#endif
+    vsf_eda_init(&msc->scsi_eda, VSF_USBD_CFG_EDA_PRIORITY, false);
+
     msc->eda.fn.evthandler = __vk_usbd_msc_evthandler;
 #if VSF_KERNEL_CFG_EDA_SUPPORT_ON_TERMINATE == ENABLED
     msc->eda.on_terminate = NULL;
@@ -44,6 +44,12 @@ extern "C" {
 #   error msc uses scsi!!!
 #endif
 
+// number of slices the buffer is split into for pipelined READ/WRITE,
+//  one slice is accessed by scsi while another one is transferred by usb
+#ifndef VSF_USBD_MSC_CFG_PIPELINE_BUFFER_NUM
+#   define VSF_USBD_MSC_CFG_PIPELINE_BUFFER_NUM         2
+#endif
+
 
 
 #define USB_MSC_PARAM(__BULK_IN_EP, __BULK_OUT_EP, __MAX_LUN, __SCSI_DEV, __STREAM)\
@@ -53,6 +59,10 @@ extern "C" {
             .scsi               = (__SCSI_DEV),                                 \
             .stream             = (__STREAM),
 
+#define USB_MSC_PARAM_BUFFER(__BUFFER, __BUFFER_SIZE)                           \
+            .buffer             = (__BUFFER),                                   \
+            .buffer_size        = (__BUFFER_SIZE),
+
 #define USB_MSC_IFS_NUM             1
 #define USB_MSCBOT_IFS_NUM          USB_MSC_IFS_NUM
 #define USB_MSC_IFS(__MSC_PARAM)    USB_IFS(&vk_usbd_msc, &(__MSC_PARAM))
@@ -67,6 +77,12 @@ extern "C" {
                 USB_MSC_PARAM((__bulk_in_ep), (__bulk_out_ep), (__max_lun), (__scsi_dev), (__stream))\
             };
 
+#define __mscbot_buffered_func(__name, __func_id, __bulk_in_ep, __bulk_out_ep, __max_lun, __scsi_dev, __buffer, __buffer_size)\
+            vk_usbd_msc_t __##__name##_MSC##__func_id = {                       \
+                USB_MSC_PARAM((__bulk_in_ep), (__bulk_out_ep), (__max_lun), (__scsi_dev), NULL)\
+                USB_MSC_PARAM_BUFFER((__buffer), (__buffer_size))               \
+            };
+
 #define __msc_ifs(__name, __func_id)                                            \
             USB_MSC_IFS(__##__name##_MSC##__func_id)
 
@@ -74,6 +90,8 @@ extern "C" {
             __mscbot_desc(__name, (__ifs), (__i_func), (__bulk_in_ep), (__bulk_out_ep), (__bulk_ep_size))
 #define mscbot_func(__name, __func_id, __bulk_in_ep, __bulk_out_ep, __max_lun, __scsi_dev, __stream)\
             __mscbot_func(__name, __func_id, (__bulk_in_ep), (__bulk_out_ep), (__max_lun), (__scsi_dev), (__stream))
+#define mscbot_buffered_func(__name, __func_id, __bulk_in_ep, __bulk_out_ep, __max_lun, __scsi_dev, __buffer, __buffer_size)\
+            __mscbot_buffered_func(__name, __func_id, (__bulk_in_ep), (__bulk_out_ep), (__max_lun), (__scsi_dev), (__buffer), (__buffer_size))
 #define mscbot_ifs(__name, __func_id)                                           \
             __msc_ifs(__name, __func_id)
 
@@ -93,11 +111,34 @@ typedef union vk_usbd_msc_scsi_ctx_t {
     };
 } vk_usbd_msc_scsi_ctx_t;
 
+// READ/WRITE split into slices, scsi and usb work on different slices
+//  *_pos are bytes issued, *_done are bytes finished
+typedef struct vk_usbd_msc_pipeline_t {
+    uint8_t cbd[16];
+    vsf_mem_t mem;
+    uint64_t addr;
+    uint32_t block_size;
+    uint32_t slice_size;
+    uint32_t total;
+    uint32_t scsi_pos;
+    uint32_t scsi_done;
+    uint32_t usb_pos;
+    uint32_t usb_done;
+    int32_t scsi_result;
+    uint8_t is_in           : 1;
+    uint8_t is_scsi_busy    : 1;
+    uint8_t is_usb_busy     : 1;
+    uint8_t is_failed       : 1;
+} vk_usbd_msc_pipeline_t;
+
 def_simple_class(vk_usbd_msc_t) {
 
     private_member(
         vsf_eda_t eda;
+        // scsi commands of the pipeline run in scsi_eda, so that eda is free to handle usb events
+        vsf_eda_t scsi_eda;
         vk_usbd_msc_scsi_ctx_t ctx;
+        vk_usbd_msc_pipeline_t pipeline;
         vk_usbd_dev_t *dev;
         vk_usbd_ep_stream_t ep_stream;
         uint8_t is_inited   : 1;
@@ -110,6 +151,9 @@ def_simple_class(vk_usbd_msc_t) {
         const uint8_t max_lun;
         vk_scsi_t *scsi;
         vsf_stream_t *stream;
+        // optional buffer for pipelined READ/WRITE if scsi can not provide buffer
+        uint8_t *buffer;
+        uint32_t buffer_size;
     )
 };
 
@@ -28,11 +28,28 @@
 #include "kernel/vsf_kernel.h"
 #include "./vsf_usbip_dcd.h"
 
-#include <Windows.h>
+#if VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_WIN
+#   include <Windows.h>
+#elif VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_POSIX
+#   include <sys/socket.h>
+#   include <sys/uio.h>
+#   include <netinet/in.h>
+#   include <netinet/tcp.h>
+#   if VSF_ARCH_CFG_EPOLL == ENABLED
+#       include <sys/epoll.h>
+#   else
+#       include <poll.h>
+#   endif
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <errno.h>
+#endif
 
 /*============================ MACROS ========================================*/
 
 #define VSF_USBIP_VERSION                       0x0111
+// size of usbip_header, USBIP_RET_SUBMIT/USBIP_RET_UNLINK are padded to it
+#define VSF_USBIP_HEADER_SIZE                   48
 
 /*============================ MACROFIED FUNCTIONS ===========================*/
 
@@ -135,6 +152,43 @@ typedef struct vk_usbip_server_backend_t {
     vk_usbip_server_backend_irq_thread_t tx;
 } vk_usbip_server_backend_t;
 
+#elif VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_POSIX
+
+typedef struct vk_usbip_server_backend_t {
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+    // serviced in irq context of the epoll thread of the arch
+    vsf_arch_epoll_source_t wakeup_source;
+    vsf_arch_epoll_source_t listener_source;
+    vsf_arch_epoll_source_t socket_source;
+#else
+    vsf_arch_irq_thread_t irq_thread;
+#endif
+    vk_usbip_server_t *server;
+
+    int listener_socket;
+    int socket;
+    // written by server to wake up the backend
+    int wakeup_pipe[2];
+
+    // requests from server, taken by the backend thread in irq context
+    vsf_mem_t rx_req;
+    vsf_mem_t tx_req;
+    bool is_to_close;
+
+    // requests in progress, accessed by the backend thread only
+    vsf_mem_t rx;
+    vsf_mem_t tx;
+    uint32_t rx_pos;
+    uint32_t tx_pos;
+    // urbs being sent, urb_sent is the sent size of the head urb
+    vsf_dlist_t urb_list;
+    uint32_t urb_sent;
+
+    uint32_t rx_cache_pos;
+    uint32_t rx_cache_size;
+    uint8_t rx_cache[VSF_USBIP_DCD_CFG_POSIX_RX_CACHE_SIZE];
+} vk_usbip_server_backend_t;
+
 #endif
 
 /*============================ PROTOTYPES ====================================*/
@@ -146,7 +200,8 @@ static vsf_err_t __vk_usbip_server_done_urb(vk_usbip_server_t *server, vk_usbip_
 
 static vk_usbip_server_t __vk_usbip_server;
 
-#if VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_WIN
+#if     VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_WIN          \
+    ||  VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_POSIX
 static vk_usbip_server_backend_t __vk_usbip_server_backend;
 #endif
 
@@ -351,6 +406,480 @@ static void __vk_usbip_server_backend_send_urb(vk_usbip_urb_t *urb)
     __vk_usbip_server_backend.tx.mem.buffer = NULL;
     __vsf_arch_irq_request_send(&__vk_usbip_server_backend.tx.irq_request);
 }
+#elif VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_POSIX
+
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+// backend is always in irq context of the epoll thread of the arch
+#   define __vk_usbip_server_backend_irq_start(__backend)
+#   define __vk_usbip_server_backend_irq_end(__backend)
+#else
+#   define __vk_usbip_server_backend_irq_start(__backend)                       \
+            __vsf_arch_irq_start(&(__backend)->irq_thread)
+#   define __vk_usbip_server_backend_irq_end(__backend)                         \
+            __vsf_arch_irq_end(&(__backend)->irq_thread, false)
+#endif
+
+static bool __vk_usbip_server_backend_is_again(void)
+{
+    return (EAGAIN == errno) || (EWOULDBLOCK == errno) || (EINTR == errno);
+}
+
+static void __vk_usbip_server_backend_post_evt(vk_usbip_server_backend_t *backend, vsf_evt_t evt)
+{
+    __vk_usbip_server_backend_irq_start(backend);
+        vsf_eda_post_evt(&backend->server->teda.use_as__vsf_eda_t, evt);
+    __vk_usbip_server_backend_irq_end(backend);
+}
+
+static uint_fast32_t __vk_usbip_server_backend_urb_data_size(vk_usbip_urb_t *urb)
+{
+    if (!urb->is_unlinked && urb->req.direction) {
+        return be32_to_cpu(urb->rep.actual_length);
+    }
+    return 0;
+}
+
+// take requests from server, returns true if server wants to close the session
+static bool __vk_usbip_server_backend_fetch(vk_usbip_server_backend_t *backend)
+{
+    vk_usbip_server_t *server = backend->server;
+    vk_usbip_urb_t *urb;
+    bool is_to_close;
+
+    __vk_usbip_server_backend_irq_start(backend);
+        if (backend->rx_req.buffer != NULL) {
+            backend->rx = backend->rx_req;
+            backend->rx_pos = 0;
+            backend->rx_req.buffer = NULL;
+        }
+        if (backend->tx_req.buffer != NULL) {
+            backend->tx = backend->tx_req;
+            backend->tx_pos = 0;
+            backend->tx_req.buffer = NULL;
+        }
+        // take all done urbs, they will be sent in batch
+        while (1) {
+            vsf_dlist_remove_head(vk_usbip_urb_t, urb_node_ep, &server->urb_done_list, urb);
+            if (NULL == urb) {
+                break;
+            }
+            if (backend->socket < 0) {
+                __vk_usbip_server_done_urb(server, urb);
+            } else {
+                vsf_dlist_add_to_tail(vk_usbip_urb_t, urb_node_ep, &backend->urb_list, urb);
+            }
+        }
+        is_to_close = backend->is_to_close;
+        backend->is_to_close = false;
+    __vk_usbip_server_backend_irq_end(backend);
+    return is_to_close;
+}
+
+static void __vk_usbip_server_backend_close_session(vk_usbip_server_backend_t *backend)
+{
+    vk_usbip_server_t *server = backend->server;
+    vk_usbip_urb_t *urb;
+
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+    __vsf_arch_epoll_del(&backend->socket_source);
+#endif
+    close(backend->socket);
+    backend->socket = -1;
+    backend->rx.buffer = NULL;
+    backend->tx.buffer = NULL;
+    backend->rx_cache_pos = backend->rx_cache_size = 0;
+    backend->urb_sent = 0;
+
+    __vk_usbip_server_backend_irq_start(backend);
+        backend->rx_req.buffer = NULL;
+        backend->tx_req.buffer = NULL;
+        backend->is_to_close = false;
+        while (1) {
+            vsf_dlist_remove_head(vk_usbip_urb_t, urb_node_ep, &backend->urb_list, urb);
+            if (NULL == urb) {
+                break;
+            }
+            __vk_usbip_server_done_urb(server, urb);
+        }
+        vsf_eda_post_evt(&server->teda.use_as__vsf_eda_t, VSF_USBIP_SERVER_EVT_BACKEND_DISCONNECTED);
+    __vk_usbip_server_backend_irq_end(backend);
+}
+
+// returns VSF_ERR_FAIL if the session is broken
+static vsf_err_t __vk_usbip_server_backend_do_rx(vk_usbip_server_backend_t *backend)
+{
+    uint_fast32_t size;
+    ssize_t ret;
+
+    if (NULL == backend->rx.buffer) {
+        return VSF_ERR_NONE;
+    }
+
+    while (backend->rx_pos < backend->rx.size) {
+        size = backend->rx.size - backend->rx_pos;
+        if (backend->rx_cache_pos < backend->rx_cache_size) {
+            size = min(size, backend->rx_cache_size - backend->rx_cache_pos);
+            memcpy(backend->rx.buffer + backend->rx_pos, &backend->rx_cache[backend->rx_cache_pos], size);
+            backend->rx_cache_pos += size;
+            backend->rx_pos += size;
+            continue;
+        }
+
+        // small requests are read through rx_cache, so one recv gets several headers
+        if (size >= sizeof(backend->rx_cache)) {
+            ret = recv(backend->socket, backend->rx.buffer + backend->rx_pos, size, 0);
+        } else {
+            ret = recv(backend->socket, backend->rx_cache, sizeof(backend->rx_cache), 0);
+        }
+        if (ret < 0) {
+            return __vk_usbip_server_backend_is_again() ? VSF_ERR_NONE : VSF_ERR_FAIL;
+        } else if (0 == ret) {
+            return VSF_ERR_FAIL;
+        }
+
+        if (size >= sizeof(backend->rx_cache)) {
+            backend->rx_pos += ret;
+        } else {
+            backend->rx_cache_pos = 0;
+            backend->rx_cache_size = ret;
+        }
+    }
+
+    __vk_usbip_server_backend_irq_start(backend);
+        __vk_usbip_server_trace_rx(backend->rx.buffer, backend->rx.size);
+        backend->rx.buffer = NULL;
+        vsf_eda_post_evt(&backend->server->teda.use_as__vsf_eda_t, VSF_USBIP_SERVER_EVT_BACKEND_RECV_DONE);
+    __vk_usbip_server_backend_irq_end(backend);
+    return VSF_ERR_NONE;
+}
+
+// returns VSF_ERR_FAIL if the session is broken
+static vsf_err_t __vk_usbip_server_backend_do_tx(vk_usbip_server_backend_t *backend)
+{
+    static const uint8_t __padding[VSF_USBIP_HEADER_SIZE - sizeof(((vk_usbip_urb_t *)NULL)->rep)] = { 0 };
+    struct iovec iov[3 * VSF_USBIP_DCD_CFG_POSIX_URB_BATCH];
+    struct msghdr msg = { 0 };
+    vk_usbip_server_t *server = backend->server;
+    vk_usbip_urb_t *urb;
+    uint_fast32_t size, skip;
+    ssize_t ret;
+
+    while (backend->tx.buffer != NULL) {
+        if (backend->tx_pos < backend->tx.size) {
+            ret = send(backend->socket, backend->tx.buffer + backend->tx_pos,
+                        backend->tx.size - backend->tx_pos, MSG_NOSIGNAL);
+            if (ret < 0) {
+                return __vk_usbip_server_backend_is_again() ? VSF_ERR_NONE : VSF_ERR_FAIL;
+            }
+            backend->tx_pos += ret;
+            continue;
+        }
+
+        __vk_usbip_server_backend_irq_start(backend);
+            __vk_usbip_server_trace_tx(backend->tx.buffer, backend->tx.size);
+            backend->tx.buffer = NULL;
+            vsf_eda_post_evt(&server->teda.use_as__vsf_eda_t, VSF_USBIP_SERVER_EVT_BACKEND_SEND_DONE);
+        __vk_usbip_server_backend_irq_end(backend);
+    }
+
+    while (!vsf_dlist_is_empty(&backend->urb_list)) {
+        // header, padding and data of several urbs in one sendmsg
+        msg.msg_iov = iov;
+        msg.msg_iovlen = 0;
+        __vsf_dlist_foreach_unsafe(vk_usbip_urb_t, urb_node_ep, &backend->urb_list) {
+            if (msg.msg_iovlen + 3 > dimof(iov)) {
+                break;
+            }
+            iov[msg.msg_iovlen].iov_base = &_->rep;
+            iov[msg.msg_iovlen++].iov_len = sizeof(_->rep);
+            iov[msg.msg_iovlen].iov_base = (void *)__padding;
+            iov[msg.msg_iovlen++].iov_len = sizeof(__padding);
+            size = __vk_usbip_server_backend_urb_data_size(_);
+            if (size > 0) {
+                iov[msg.msg_iovlen].iov_base = _->dynmem.buffer;
+                iov[msg.msg_iovlen++].iov_len = size;
+            }
+        }
+
+        // skip the part of head urb already sent
+        skip = backend->urb_sent;
+        while (skip >= msg.msg_iov[0].iov_len) {
+            skip -= msg.msg_iov[0].iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        msg.msg_iov[0].iov_base = (uint8_t *)msg.msg_iov[0].iov_base + skip;
+        msg.msg_iov[0].iov_len -= skip;
+
+        ret = sendmsg(backend->socket, &msg, MSG_NOSIGNAL);
+        if (ret < 0) {
+            return __vk_usbip_server_backend_is_again() ? VSF_ERR_NONE : VSF_ERR_FAIL;
+        }
+
+        ret += backend->urb_sent;
+        __vk_usbip_server_backend_irq_start(backend);
+            while (1) {
+                vsf_dlist_peek_head(vk_usbip_urb_t, urb_node_ep, &backend->urb_list, urb);
+                if (NULL == urb) {
+                    break;
+                }
+                size = __vk_usbip_server_backend_urb_data_size(urb);
+                if (ret < VSF_USBIP_HEADER_SIZE + size) {
+                    break;
+                }
+                ret -= VSF_USBIP_HEADER_SIZE + size;
+
+                vsf_dlist_remove_head(vk_usbip_urb_t, urb_node_ep, &backend->urb_list, urb);
+                __vk_usbip_server_trace_tx(&urb->rep, VSF_USBIP_HEADER_SIZE);
+                if (size > 0) {
+                    __vk_usbip_server_trace_tx(urb->dynmem.buffer, size);
+                }
+                __vk_usbip_server_done_urb(server, urb);
+            }
+        __vk_usbip_server_backend_irq_end(backend);
+        backend->urb_sent = ret;
+    }
+    return VSF_ERR_NONE;
+}
+
+static bool __vk_usbip_server_backend_is_rx_pending(vk_usbip_server_backend_t *backend)
+{
+    return backend->rx.buffer != NULL;
+}
+
+static bool __vk_usbip_server_backend_is_tx_pending(vk_usbip_server_backend_t *backend)
+{
+    return (backend->tx.buffer != NULL) || !vsf_dlist_is_empty(&backend->urb_list);
+}
+
+static void __vk_usbip_server_backend_listen(vk_usbip_server_backend_t *backend)
+{
+    vk_usbip_server_t *server = backend->server;
+    int optval = 1;
+
+    server->err = VSF_ERR_NONE;
+    backend->listener_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if ((backend->listener_socket < 0) || (backend->wakeup_pipe[0] < 0)) {
+        server->err = VSF_ERR_FAIL;
+        return;
+    }
+
+    struct sockaddr_in sin = {
+        .sin_family             = AF_INET,
+        .sin_port               = htons(server->port),
+        .sin_addr.s_addr        = htonl(INADDR_ANY),
+    };
+    setsockopt(backend->listener_socket, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
+    // non-blocking, so accept on a stale ready event will not block
+    if (    fcntl(backend->listener_socket, F_SETFL, O_NONBLOCK)
+        ||  bind(backend->listener_socket, (struct sockaddr *)&sin, sizeof(sin))
+        ||  listen(backend->listener_socket, 1)) {
+        server->err = VSF_ERR_FAIL;
+    }
+}
+
+static void __vk_usbip_server_backend_accept(vk_usbip_server_backend_t *backend)
+{
+    int optval = 1;
+    int socket = accept(backend->listener_socket, NULL, NULL);
+
+    if (socket >= 0) {
+        // replies are small and latency sensitive, disable nagle
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+#if VSF_USBIP_DCD_CFG_POSIX_SNDBUF_SIZE > 0
+        optval = VSF_USBIP_DCD_CFG_POSIX_SNDBUF_SIZE;
+        setsockopt(socket, SOL_SOCKET, SO_SNDBUF, &optval, sizeof(optval));
+#endif
+        fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+        backend->socket_source.fd = socket;
+        backend->socket_source.events = 0;
+        if (__vsf_arch_epoll_add(&backend->socket_source) != VSF_ERR_NONE) {
+            close(socket);
+            return;
+        }
+#endif
+        backend->socket = socket;
+        __vk_usbip_server_backend_post_evt(backend, VSF_USBIP_SERVER_EVT_BACKEND_CONNECTED);
+    }
+}
+
+// take requests from server and transfer until the socket would block
+static void __vk_usbip_server_backend_process(vk_usbip_server_backend_t *backend)
+{
+    bool is_to_close = __vk_usbip_server_backend_fetch(backend);
+
+    if (backend->socket >= 0) {
+        if (    is_to_close
+            ||  (__vk_usbip_server_backend_do_rx(backend) != VSF_ERR_NONE)
+            ||  (__vk_usbip_server_backend_do_tx(backend) != VSF_ERR_NONE)) {
+            __vk_usbip_server_backend_close_session(backend);
+            // done urbs queued while closing are completed without socket
+            __vk_usbip_server_backend_fetch(backend);
+        }
+    }
+}
+
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+static void __vk_usbip_server_backend_set_events(vsf_arch_epoll_source_t *source, uint32_t events)
+{
+    if (source->events != events) {
+        source->events = events;
+        __vsf_arch_epoll_mod(source);
+    }
+}
+
+static void __vk_usbip_server_backend_on_event(vsf_arch_epoll_source_t *source, uint32_t events)
+{
+    vk_usbip_server_backend_t *backend = &__vk_usbip_server_backend;
+    uint8_t dummy[16];
+    ssize_t ret;
+
+    if (source == &backend->wakeup_source) {
+        while (read(backend->wakeup_pipe[0], dummy, sizeof(dummy)) > 0);
+    } else if (source == &backend->listener_source) {
+        if ((backend->socket < 0) && (events & EPOLLIN)) {
+            __vk_usbip_server_backend_accept(backend);
+        }
+    } else if ((backend->socket >= 0) && (events & (EPOLLERR | EPOLLHUP)) && !(events & EPOLLIN)) {
+        // events may be of a session closed earlier in the same irq, check the socket
+        ret = recv(backend->socket, dummy, 1, MSG_PEEK | MSG_DONTWAIT);
+        if ((0 == ret) || ((ret < 0) && !__vk_usbip_server_backend_is_again())) {
+            __vk_usbip_server_backend_close_session(backend);
+        }
+    }
+
+    __vk_usbip_server_backend_process(backend);
+
+    // level triggered, only wait for what is pending
+    __vk_usbip_server_backend_set_events(&backend->listener_source,
+            (backend->socket < 0) ? EPOLLIN : 0);
+    if (backend->socket >= 0) {
+        __vk_usbip_server_backend_set_events(&backend->socket_source,
+                (__vk_usbip_server_backend_is_rx_pending(backend) ? EPOLLIN : 0)
+            |   (__vk_usbip_server_backend_is_tx_pending(backend) ? EPOLLOUT : 0));
+    }
+}
+#else
+static void __vk_usbip_server_backend_thread(void *arg)
+{
+    vk_usbip_server_backend_t *backend = container_of(arg, vk_usbip_server_backend_t, irq_thread);
+    vk_usbip_server_t *server = backend->server;
+    struct pollfd fds[2];
+    uint8_t dummy[16];
+
+    __vsf_arch_irq_set_background(&backend->irq_thread);
+
+    __vk_usbip_server_backend_listen(backend);
+    __vk_usbip_server_backend_post_evt(backend, VSF_USBIP_SERVER_EVT_BACKEND_INIT_DONE);
+    if (server->err != VSF_ERR_NONE) {
+        __vsf_arch_irq_fini(&backend->irq_thread);
+        return;
+    }
+
+    while (1) {
+        __vk_usbip_server_backend_process(backend);
+
+        fds[0].fd = backend->wakeup_pipe[0];
+        fds[0].events = POLLIN;
+        if (backend->socket < 0) {
+            fds[1].fd = backend->listener_socket;
+            fds[1].events = POLLIN;
+        } else {
+            fds[1].fd = backend->socket;
+            fds[1].events = 0;
+            if (__vk_usbip_server_backend_is_rx_pending(backend)) {
+                fds[1].events |= POLLIN;
+            }
+            if (__vk_usbip_server_backend_is_tx_pending(backend)) {
+                fds[1].events |= POLLOUT;
+            }
+        }
+        if (poll(fds, dimof(fds), -1) <= 0) {
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            while (read(backend->wakeup_pipe[0], dummy, sizeof(dummy)) > 0);
+        }
+        if (backend->socket < 0) {
+            if (fds[1].revents & POLLIN) {
+                __vk_usbip_server_backend_accept(backend);
+            }
+        } else if ((fds[1].revents & (POLLERR | POLLHUP | POLLNVAL)) && !(fds[1].revents & POLLIN)) {
+            __vk_usbip_server_backend_close_session(backend);
+        }
+    }
+}
+#endif
+
+static void __vk_usbip_server_backend_wakeup(void)
+{
+    uint8_t dummy = 0;
+    // pipe is non-blocking, if it's full, the backend thread will wake up anyway
+    if (write(__vk_usbip_server_backend.wakeup_pipe[1], &dummy, 1) < 0) {
+    }
+}
+
+static void __vk_usbip_server_backend_init(vk_usbip_server_t *server)
+{
+    vk_usbip_server_backend_t *backend = &__vk_usbip_server_backend;
+    int *wakeup_pipe = backend->wakeup_pipe;
+
+    backend->server = server;
+    backend->listener_socket = -1;
+    backend->socket = -1;
+    if (    pipe(wakeup_pipe)
+        ||  fcntl(wakeup_pipe[0], F_SETFL, O_NONBLOCK)
+        ||  fcntl(wakeup_pipe[1], F_SETFL, O_NONBLOCK)) {
+        wakeup_pipe[0] = wakeup_pipe[1] = -1;
+    }
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+    __vk_usbip_server_backend_listen(backend);
+    if (VSF_ERR_NONE == server->err) {
+        backend->wakeup_source.fd = wakeup_pipe[0];
+        backend->wakeup_source.events = EPOLLIN;
+        backend->wakeup_source.handler = __vk_usbip_server_backend_on_event;
+        backend->listener_source.fd = backend->listener_socket;
+        backend->listener_source.events = EPOLLIN;
+        backend->listener_source.handler = __vk_usbip_server_backend_on_event;
+        backend->socket_source.handler = __vk_usbip_server_backend_on_event;
+        if (    (__vsf_arch_epoll_add(&backend->wakeup_source) != VSF_ERR_NONE)
+            ||  (__vsf_arch_epoll_add(&backend->listener_source) != VSF_ERR_NONE)) {
+            server->err = VSF_ERR_FAIL;
+        }
+    }
+    vsf_eda_post_evt(&server->teda.use_as__vsf_eda_t, VSF_USBIP_SERVER_EVT_BACKEND_INIT_DONE);
+#else
+    __vsf_arch_irq_init(&backend->irq_thread, "usbip_server",
+        __vk_usbip_server_backend_thread, VSF_USBD_CFG_HW_PRIORITY);
+#endif
+}
+
+static void __vk_usbip_server_backend_close(void)
+{
+    __vk_usbip_server_backend.is_to_close = true;
+    __vk_usbip_server_backend_wakeup();
+}
+
+static void __vk_usbip_server_backend_recv(uint8_t *buff, uint_fast32_t size)
+{
+    __vk_usbip_server_backend.rx_req.buffer = buff;
+    __vk_usbip_server_backend.rx_req.size = size;
+    __vk_usbip_server_backend_wakeup();
+}
+
+static void __vk_usbip_server_backend_send(uint8_t *buff, uint_fast32_t size)
+{
+    __vk_usbip_server_backend.tx_req.buffer = buff;
+    __vk_usbip_server_backend.tx_req.size = size;
+    __vk_usbip_server_backend_wakeup();
+}
+
+static void __vk_usbip_server_backend_send_urb(vk_usbip_urb_t *urb)
+{
+    __vk_usbip_server_backend_wakeup();
+}
 #elif VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_VSF
 // TODO: use vsf tcp stream as backend
 #elif VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_LIB
@@ -570,6 +1099,25 @@ static void __vk_usbip_server_get_descriptor(vk_usbip_server_t *server,
     __vk_usbip_server_control_msg(server, &req, buffer);
 }
 
+static void __vk_usbip_server_free_urbs(vk_usbip_server_t *server)
+{
+    vk_usbip_urb_t *urb;
+    vsf_protect_t orig;
+
+    do {
+        orig = vsf_protect_int();
+            vsf_dlist_remove_head(vk_usbip_urb_t, urb_node_ep, &server->urb_free_list, urb);
+        vsf_unprotect_int(orig);
+        if (urb != NULL) {
+            vsf_dlist_remove(vk_usbip_urb_t, urb_node, &server->urb_list, urb);
+            if (urb->dynmem.buffer != NULL) {
+                vsf_heap_free(urb->dynmem.buffer);
+            }
+            VSF_POOL_FREE(vk_usbip_urb_poll, &__vk_usbip_server.urb_pool, urb);
+        }
+    } while (urb != NULL);
+}
+
 static void __vk_usbip_server_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
 {
     vk_usbip_server_t *server = container_of(eda, vk_usbip_server_t, teda);
@@ -583,18 +1131,7 @@ static void __vk_usbip_server_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
         __vk_usbip_server_backend_init(server);
         // fall through
     case VSF_EVT_TIMER:
-        do {
-            orig = vsf_protect_int();
-                vsf_dlist_remove_head(vk_usbip_urb_t, urb_node_ep, &server->urb_free_list, urb);
-            vsf_unprotect_int(orig);
-            if (urb != NULL) {
-                vsf_dlist_remove(vk_usbip_urb_t, urb_node, &server->urb_list, urb);
-                if (urb->dynmem.buffer != NULL) {
-                    vsf_heap_free(urb->dynmem.buffer);
-                }
-                VSF_POOL_FREE(vk_usbip_urb_poll, &__vk_usbip_server.urb_pool, urb);
-            }
-        } while (urb != NULL);
+        __vk_usbip_server_free_urbs(server);
         vsf_teda_set_timer_ms(100);
         break;
     case VSF_USBIP_SERVER_EVT_BACKEND_INIT_DONE:
@@ -654,6 +1191,9 @@ static void __vk_usbip_server_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
                 switch (server->command) {
                 case USBIP_CMD_SUBMIT:
                     __vk_usbip_server_trace("recv USBIP_CMD_SUBMIT" VSF_TRACE_CFG_LINEEND);
+                    // done urbs are freed here too, or a fast client fills the heap
+                    //  with urbs waiting for the timer
+                    __vk_usbip_server_free_urbs(server);
                     urb = VSF_POOL_ALLOC(vk_usbip_urb_poll, &server->urb_pool);
                     VSF_USB_ASSERT(urb != NULL);
 
@@ -43,9 +43,30 @@ extern "C" {
 #define VSF_USBIP_DCD_CFG_BACKEND_WIN   1
 #define VSF_USBIP_DCD_CFG_BACKEND_VSF   2
 #define VSF_USBIP_DCD_CFG_BACKEND_LIB   3
+#define VSF_USBIP_DCD_CFG_BACKEND_POSIX 4
 
 #ifndef VSF_USBIP_DCD_CFG_BACKEND
-#   define VSF_USBIP_DCD_CFG_BACKEND    VSF_USBIP_DCD_CFG_BACKEND_WIN
+#   if defined(__LINUX__)
+#       define VSF_USBIP_DCD_CFG_BACKEND    VSF_USBIP_DCD_CFG_BACKEND_POSIX
+#   else
+#       define VSF_USBIP_DCD_CFG_BACKEND    VSF_USBIP_DCD_CFG_BACKEND_WIN
+#   endif
+#endif
+
+#if VSF_USBIP_DCD_CFG_BACKEND == VSF_USBIP_DCD_CFG_BACKEND_POSIX
+// max number of urb replies sent in one sendmsg
+#   ifndef VSF_USBIP_DCD_CFG_POSIX_URB_BATCH
+#       define VSF_USBIP_DCD_CFG_POSIX_URB_BATCH        16
+#   endif
+// commands and headers are read from socket through this cache
+#   ifndef VSF_USBIP_DCD_CFG_POSIX_RX_CACHE_SIZE
+#       define VSF_USBIP_DCD_CFG_POSIX_RX_CACHE_SIZE    4096
+#   endif
+// SO_SNDBUF of the connection, 0 to use the system default
+//  a small value forces partial sends of replies, used to test resending
+#   ifndef VSF_USBIP_DCD_CFG_POSIX_SNDBUF_SIZE
+#       define VSF_USBIP_DCD_CFG_POSIX_SNDBUF_SIZE      0
+#   endif
 #endif
 
 #ifndef VSF_USBIP_DCD_CFG_PATH
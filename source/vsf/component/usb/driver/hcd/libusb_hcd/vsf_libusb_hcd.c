@@ -181,6 +181,31 @@ int LIBUSB_CALL libusb_interrupt_transfer(libusb_device_handle *dev_handle,
 
 #define VSF_EVT_LIBUSB_HCD_BASE                     ((VSF_EVT_USER + 0x100) & ~0xFF)
 
+// async mode: transfers are submitted by libusb async APIs, and reaped by one
+//  event thread, instead of one blocking irq thread per urb
+#ifndef VSF_LIBUSB_HCD_CFG_ASYNC_EN
+#   ifdef LIBUSB_API_VERSION
+#       define VSF_LIBUSB_HCD_CFG_ASYNC_EN          ENABLED
+#   else
+#       define VSF_LIBUSB_HCD_CFG_ASYNC_EN          DISABLED
+#   endif
+#endif
+
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN == ENABLED
+#   ifndef LIBUSB_API_VERSION
+#       error "VSF_LIBUSB_HCD_CFG_ASYNC_EN requires libusb 1.0"
+#   endif
+// max transfers in flight for one endpoint, urbs exceeding are queued in hcd
+#   ifndef VSF_LIBUSB_HCD_CFG_EP_INFLIGHT_NUM
+#       define VSF_LIBUSB_HCD_CFG_EP_INFLIGHT_NUM   8
+#   endif
+#   if VSF_USBH_CFG_ISO_EN == ENABLED
+#       define __VSF_LIBUSB_HCD_ISO_PACKET_NUM      VSF_USBH_CFG_ISO_PACKET_LIMIT
+#   else
+#       define __VSF_LIBUSB_HCD_ISO_PACKET_NUM      0
+#   endif
+#endif
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 
 #define VSF_LIBUSB_HCD_DEF_DEV(__N, __BIT)                                      \
@@ -212,14 +237,27 @@ typedef struct vk_libusb_hcd_dev_t {
             uint8_t is_attaching    : 1;
             uint8_t is_detaching    : 1;
             uint8_t is_detached     : 1;
+            uint8_t is_configuring  : 1;
         };
     } evt_mask;
 
     vsf_arch_irq_thread_t irq_thread;
     vsf_arch_irq_request_t irq_request;
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN == ENABLED
+    // set_configuration urb, interfaces are claimed in irq_thread
+    vk_usbh_hcd_urb_t *config_urb;
+    bool is_close_pending;
+    uint16_t inflight_num;
+    // [dir_in1out0][endpoint]
+    uint8_t ep_inflight[2][16];
+    vsf_dlist_t ep_queue[2][16];
+#else
     vsf_dlist_t urb_pending_list;
+#endif
 } vk_libusb_hcd_dev_t;
 
+typedef struct vk_libusb_hcd_urb_t vk_libusb_hcd_urb_t;
+
 typedef struct vk_libusb_hcd_t {
     libusb_context *ctx;
 
@@ -232,11 +270,38 @@ typedef struct vk_libusb_hcd_t {
     vsf_eda_t *init_eda;
     vsf_arch_irq_thread_t init_thread;
     vsf_teda_t teda;
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN == ENABLED
+    vsf_arch_irq_thread_t event_thread;
+    // urbs done in event_thread, only accessed in event_thread
+    vk_libusb_hcd_urb_t *reaped_head, *reaped_tail;
+    // urbs to be notified in batch in hcd task
+    vk_libusb_hcd_urb_t *done_head, *done_tail;
+#else
     vsf_sem_t sem;
     vsf_dlist_t urb_list;
+#endif
 } vk_libusb_hcd_t;
 
-typedef struct vk_libusb_hcd_urb_t {
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN == ENABLED
+struct vk_libusb_hcd_urb_t {
+    vsf_dlist_node_t ep_node;
+    vk_libusb_hcd_urb_t *done_next;
+    vk_libusb_hcd_dev_t *libusb_dev;
+    struct libusb_transfer *transfer;
+    // setup packet + data for control transfer
+    uint8_t *ctrl_buffer;
+
+    enum {
+        VSF_LIBUSB_HCD_URB_STATE_IDLE,
+        VSF_LIBUSB_HCD_URB_STATE_QUEUED,
+        VSF_LIBUSB_HCD_URB_STATE_SUBMITTED,
+        VSF_LIBUSB_HCD_URB_STATE_COMPLETING,
+        VSF_LIBUSB_HCD_URB_STATE_TO_FREE,
+    } state;
+    bool is_inflight;
+};
+#else
+struct vk_libusb_hcd_urb_t {
     vsf_dlist_node_t urb_node;
     vsf_dlist_node_t urb_pending_node;
 
@@ -253,12 +318,14 @@ typedef struct vk_libusb_hcd_urb_t {
 
     vsf_arch_irq_thread_t irq_thread;
     vsf_arch_irq_request_t irq_request;
-} vk_libusb_hcd_urb_t;
+};
+#endif
 
 typedef enum vk_libusb_hcd_evt_t {
     VSF_EVT_LIBUSB_HCD_ATTACH           = VSF_EVT_LIBUSB_HCD_BASE + 0x100,
     VSF_EVT_LIBUSB_HCD_DETACH           = VSF_EVT_LIBUSB_HCD_BASE + 0x200,
     VSF_EVT_LIBUSB_HCD_READY            = VSF_EVT_LIBUSB_HCD_BASE + 0x300,
+    VSF_EVT_LIBUSB_HCD_DONE             = VSF_EVT_LIBUSB_HCD_BASE + 0x400,
 } vk_libusb_hcd_evt_t;
 
 /*============================ PROTOTYPES ====================================*/
@@ -278,6 +345,10 @@ static vsf_err_t __vk_libusb_hcd_reset_dev(vk_usbh_hcd_t *hcd, vk_usbh_hcd_dev_t
 static bool __vk_libusb_hcd_is_dev_reset(vk_usbh_hcd_t *hcd, vk_usbh_hcd_dev_t *dev);
 
 static void __vk_libusb_hcd_dev_thread(void *arg);
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN == ENABLED
+static void __vk_libusb_hcd_event_thread(void *arg);
+static void __vk_libusb_hcd_urb_done(vk_libusb_hcd_urb_t *head, vk_libusb_hcd_urb_t *tail);
+#endif
 
 /*============================ GLOBAL VARIABLES ==============================*/
 
@@ -468,6 +539,16 @@ static int __vk_libusb_hcd_init(void)
         libusb_dev->evt_mask.value = 0;
         libusb_dev->handle = NULL;
         libusb_dev->addr = -1;
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN == ENABLED
+        libusb_dev->is_close_pending = false;
+        libusb_dev->inflight_num = 0;
+        memset(libusb_dev->ep_inflight, 0, sizeof(libusb_dev->ep_inflight));
+        for (int j = 0; j < dimof(libusb_dev->ep_queue); j++) {
+            for (int k = 0; k < dimof(libusb_dev->ep_queue[0]); k++) {
+                vsf_dlist_init(&libusb_dev->ep_queue[j][k]);
+            }
+        }
+#endif
 
         __vsf_arch_irq_request_init(&libusb_dev->irq_request);
 #if VSF_LIBUSB_HCD_CFG_TRACE_IRQ_EN == ENABLED
@@ -482,9 +563,27 @@ static int __vk_libusb_hcd_init(void)
                 __vk_libusb_hcd_hotplug_cb, NULL, NULL);
         }
     }
+
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN == ENABLED
+    __vsf_arch_irq_init(&__vk_libusb_hcd.event_thread, "libusb_hcd_event", __vk_libusb_hcd_event_thread, param->priority);
+#endif
     return 0;
 }
 
+static void __vk_libusb_hcd_claim_interfaces(vk_libusb_hcd_dev_t *libusb_dev, int config)
+{
+    struct libusb_config_descriptor *config_desc;
+
+    if (LIBUSB_SUCCESS == libusb_get_config_descriptor_by_value(
+                libusb_get_device(libusb_dev->handle), config, &config_desc)) {
+        for (uint8_t i = 0; i < config_desc->bNumInterfaces; i++) {
+            libusb_claim_interface(libusb_dev->handle, i);
+        }
+        libusb_free_config_descriptor(config_desc);
+    }
+}
+
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN != ENABLED
 // TODO: call libusb_claim_interface for non-control transfer
 static int __vk_libusb_hcd_submit_urb_do(vk_usbh_hcd_urb_t *urb)
 {
@@ -546,6 +645,7 @@ static int __vk_libusb_hcd_submit_urb_do(vk_usbh_hcd_urb_t *urb)
     }
     return LIBUSB_ERROR_INVALID_PARAM;
 }
+#endif
 
 static void __vk_libusb_hcd_dev_thread(void *arg)
 {
@@ -578,9 +678,91 @@ static void __vk_libusb_hcd_dev_thread(void *arg)
             libusb_reset_device(libusb_dev->handle);
             libusb_dev->evt_mask.is_resetting = false;
         }
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN == ENABLED
+        if (libusb_dev->evt_mask.is_configuring) {
+            vk_usbh_hcd_urb_t *urb = libusb_dev->config_urb;
+            vk_libusb_hcd_urb_t *libusb_urb = (vk_libusb_hcd_urb_t *)urb->priv;
+
+            __vk_libusb_hcd_claim_interfaces(libusb_dev, urb->setup_packet.wValue);
+            libusb_dev->evt_mask.is_configuring = false;
+            urb->status = URB_OK;
+            urb->actual_length = 0;
+            __vsf_arch_irq_start(irq_thread);
+                __vk_libusb_hcd_urb_done(libusb_urb, libusb_urb);
+            __vsf_arch_irq_end(irq_thread, false);
+        }
+#endif
     }
 }
 
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN == ENABLED
+static int __vk_libusb_hcd_transfer_status(enum libusb_transfer_status status)
+{
+    switch (status) {
+    case LIBUSB_TRANSFER_COMPLETED:     return URB_OK;
+    case LIBUSB_TRANSFER_TIMED_OUT:     return LIBUSB_ERROR_TIMEOUT;
+    case LIBUSB_TRANSFER_CANCELLED:     return LIBUSB_ERROR_INTERRUPTED;
+    case LIBUSB_TRANSFER_STALL:         return LIBUSB_ERROR_PIPE;
+    case LIBUSB_TRANSFER_NO_DEVICE:     return LIBUSB_ERROR_NO_DEVICE;
+    case LIBUSB_TRANSFER_OVERFLOW:      return LIBUSB_ERROR_OVERFLOW;
+    default:                            return LIBUSB_ERROR_IO;
+    }
+}
+
+// called in event_thread, in libusb_handle_events
+static void LIBUSB_CALL __vk_libusb_hcd_transfer_cb(struct libusb_transfer *transfer)
+{
+    vk_usbh_hcd_urb_t *urb = transfer->user_data;
+    vk_libusb_hcd_urb_t *libusb_urb = (vk_libusb_hcd_urb_t *)urb->priv;
+
+    urb->status = __vk_libusb_hcd_transfer_status(transfer->status);
+    urb->actual_length = transfer->actual_length;
+#if VSF_USBH_CFG_ISO_EN == ENABLED
+    if (LIBUSB_TRANSFER_TYPE_ISOCHRONOUS == transfer->type) {
+        urb->actual_length = 0;
+        for (int i = 0; i < transfer->num_iso_packets; i++) {
+            urb->iso_packet.frame_desc[i].actual_length = transfer->iso_packet_desc[i].actual_length;
+            urb->iso_packet.frame_desc[i].status = __vk_libusb_hcd_transfer_status(transfer->iso_packet_desc[i].status);
+            urb->actual_length += transfer->iso_packet_desc[i].actual_length;
+        }
+    }
+#endif
+#if VSF_LIBUSB_HCD_CFG_REMOVE_ON_ERROR == ENABLED
+    if (LIBUSB_TRANSFER_NO_DEVICE == transfer->status) {
+        __vk_libusb_hcd_on_left(libusb_urb->libusb_dev);
+    }
+#endif
+
+    libusb_urb->done_next = NULL;
+    if (NULL == __vk_libusb_hcd.reaped_head) {
+        __vk_libusb_hcd.reaped_head = libusb_urb;
+    } else {
+        __vk_libusb_hcd.reaped_tail->done_next = libusb_urb;
+    }
+    __vk_libusb_hcd.reaped_tail = libusb_urb;
+}
+
+static void __vk_libusb_hcd_event_thread(void *arg)
+{
+    vsf_arch_irq_thread_t *irq_thread = arg;
+    struct timeval tv;
+
+    __vsf_arch_irq_set_background(irq_thread);
+    while (1) {
+        tv.tv_sec = 0;
+        tv.tv_usec = 100 * 1000;
+        libusb_handle_events_timeout_completed(__vk_libusb_hcd.ctx, &tv, NULL);
+
+        // all urbs reaped in one round are notified to hcd task in one event
+        if (__vk_libusb_hcd.reaped_head != NULL) {
+            __vsf_arch_irq_start(irq_thread);
+                __vk_libusb_hcd_urb_done(__vk_libusb_hcd.reaped_head, __vk_libusb_hcd.reaped_tail);
+            __vsf_arch_irq_end(irq_thread, false);
+            __vk_libusb_hcd.reaped_head = __vk_libusb_hcd.reaped_tail = NULL;
+        }
+    }
+}
+#else
 static void __vk_libusb_hcd_urb_thread(void *arg)
 {
     vsf_arch_irq_thread_t *irq_thread = arg;
@@ -626,17 +808,7 @@ static void __vk_libusb_hcd_urb_thread(void *arg)
                     // set configuration is handled here
                     if (    ((USB_RECIP_DEVICE | USB_DIR_OUT) == setup->bRequestType)
                         &&  (USB_REQ_SET_CONFIGURATION == setup->bRequest)) {
-
-                        int config = setup->wValue;
-                        struct libusb_config_descriptor *config_desc;
-
-                        if (LIBUSB_SUCCESS == libusb_get_config_descriptor_by_value(
-                                    libusb_get_device(libusb_dev->handle), config, &config_desc)) {
-                            for (uint8_t i = 0; i < config_desc->bNumInterfaces; i++) {
-                                libusb_claim_interface(libusb_dev->handle, i);
-                            }
-                            libusb_free_config_descriptor(config_desc);
-                        }
+                        __vk_libusb_hcd_claim_interfaces(libusb_dev, setup->wValue);
                     }
                 }
             }
@@ -678,6 +850,7 @@ static void __vk_libusb_hcd_urb_thread(void *arg)
         }
     }
 }
+#endif
 
 static void __vk_libusb_hcd_init_thread(void *arg)
 {
@@ -713,11 +886,173 @@ static void __vk_libusb_hcd_init_thread(void *arg)
     __vsf_arch_irq_fini(irq_thread);
 }
 
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN == ENABLED
+static void __vk_libusb_hcd_free_urb_do(vk_usbh_hcd_urb_t *urb)
+{
+    vk_libusb_hcd_urb_t *libusb_urb = (vk_libusb_hcd_urb_t *)urb->priv;
+#if VSF_LIBUSB_HCD_CFG_TRACE_URB_EN == ENABLED
+    __vk_libusb_hcd_trace_urb(urb, "freed");
+#endif
+    vk_usbh_hcd_urb_free_buffer(urb);
+    libusb_free_transfer(libusb_urb->transfer);
+    vk_usbh_hcd_urb_pool_free(__vk_libusb_hcd.hcd, urb);
+}
 
+// urbs linked by done_next, will be processed in batch in hcd task
+static void __vk_libusb_hcd_urb_done(vk_libusb_hcd_urb_t *head, vk_libusb_hcd_urb_t *tail)
+{
+    bool is_to_notify;
 
+    tail->done_next = NULL;
+    vsf_protect_t orig = vsf_protect_int();
+        is_to_notify = NULL == __vk_libusb_hcd.done_head;
+        if (is_to_notify) {
+            __vk_libusb_hcd.done_head = head;
+        } else {
+            __vk_libusb_hcd.done_tail->done_next = head;
+        }
+        __vk_libusb_hcd.done_tail = tail;
+    vsf_unprotect_int(orig);
 
+    if (is_to_notify) {
+        vsf_eda_post_evt(&__vk_libusb_hcd.teda.use_as__vsf_eda_t, VSF_EVT_LIBUSB_HCD_DONE);
+    }
+}
 
+static void __vk_libusb_hcd_close_dev(vk_libusb_hcd_dev_t *libusb_dev)
+{
+    libusb_dev->is_close_pending = false;
+    libusb_dev->evt_mask.is_detached = true;
+    __vsf_arch_irq_request_send(&libusb_dev->irq_request);
+}
+
+static void __vk_libusb_hcd_submit_transfer(vk_usbh_hcd_urb_t *urb)
+{
+    vk_libusb_hcd_urb_t *libusb_urb = (vk_libusb_hcd_urb_t *)urb->priv;
+    vk_libusb_hcd_dev_t *libusb_dev = libusb_urb->libusb_dev;
+    struct libusb_transfer *transfer = libusb_urb->transfer;
+    vk_usbh_pipe_t pipe = urb->pipe;
+    unsigned char ep = (pipe.dir_in1out0 ? 0x80 : 0x00) | pipe.endpoint;
+    int err = LIBUSB_ERROR_NO_MEM;
 
+    switch (pipe.type) {
+    case USB_ENDPOINT_XFER_CONTROL: {
+            struct usb_ctrlrequest_t *setup = &urb->setup_packet;
+
+            libusb_urb->ctrl_buffer = vsf_usbh_malloc(LIBUSB_CONTROL_SETUP_SIZE + setup->wLength);
+            if (NULL == libusb_urb->ctrl_buffer) {
+                goto complete;
+            }
+            memcpy(libusb_urb->ctrl_buffer, setup, LIBUSB_CONTROL_SETUP_SIZE);
+            if (!(setup->bRequestType & USB_DIR_IN) && (setup->wLength > 0)) {
+                memcpy(libusb_urb->ctrl_buffer + LIBUSB_CONTROL_SETUP_SIZE, urb->buffer, setup->wLength);
+            }
+            libusb_fill_control_transfer(transfer, libusb_dev->handle, libusb_urb->ctrl_buffer,
+                    __vk_libusb_hcd_transfer_cb, urb, urb->timeout);
+        }
+        break;
+    case USB_ENDPOINT_XFER_ISOC:
+#if VSF_USBH_CFG_ISO_EN == ENABLED
+        VSF_USB_ASSERT(urb->iso_packet.number_of_packets <= __VSF_LIBUSB_HCD_ISO_PACKET_NUM);
+        libusb_fill_iso_transfer(transfer, libusb_dev->handle, ep, urb->buffer, urb->transfer_length,
+                urb->iso_packet.number_of_packets, __vk_libusb_hcd_transfer_cb, urb, urb->timeout);
+        for (uint_fast32_t i = 0; i < urb->iso_packet.number_of_packets; i++) {
+            transfer->iso_packet_desc[i].length = urb->iso_packet.frame_desc[i].length;
+        }
+        break;
+#else
+        err = LIBUSB_ERROR_NOT_SUPPORTED;
+        goto complete;
+#endif
+    case USB_ENDPOINT_XFER_BULK:
+        libusb_fill_bulk_transfer(transfer, libusb_dev->handle, ep, urb->buffer,
+                urb->transfer_length, __vk_libusb_hcd_transfer_cb, urb, urb->timeout);
+        break;
+    case USB_ENDPOINT_XFER_INT:
+        libusb_fill_interrupt_transfer(transfer, libusb_dev->handle, ep, urb->buffer,
+                urb->transfer_length, __vk_libusb_hcd_transfer_cb, urb, urb->timeout);
+        break;
+    }
+    if (pipe.type != USB_ENDPOINT_XFER_ISOC) {
+        transfer->num_iso_packets = 0;
+    }
+    transfer->flags = ((urb->transfer_flags & URB_SHORT_NOT_OK) ? LIBUSB_TRANSFER_SHORT_NOT_OK : 0)
+                    | ((urb->transfer_flags & URB_ZERO_PACKET) ? LIBUSB_TRANSFER_ADD_ZERO_PACKET : 0);
+
+    err = libusb_submit_transfer(transfer);
+    if (LIBUSB_SUCCESS == err) {
+#if VSF_LIBUSB_HCD_CFG_TRACE_URB_EN == ENABLED
+        __vk_libusb_hcd_trace_urb(urb, "submitted");
+#endif
+        libusb_urb->state = VSF_LIBUSB_HCD_URB_STATE_SUBMITTED;
+        libusb_urb->is_inflight = true;
+        libusb_dev->ep_inflight[pipe.dir_in1out0][pipe.endpoint]++;
+        libusb_dev->inflight_num++;
+        return;
+    }
+
+complete:
+    urb->status = err;
+    urb->actual_length = 0;
+    libusb_urb->state = VSF_LIBUSB_HCD_URB_STATE_COMPLETING;
+    __vk_libusb_hcd_urb_done(libusb_urb, libusb_urb);
+}
+
+static void __vk_libusb_hcd_ep_release(vk_libusb_hcd_dev_t *libusb_dev, vk_usbh_pipe_t pipe)
+{
+    vk_libusb_hcd_urb_t *libusb_urb;
+
+    libusb_dev->ep_inflight[pipe.dir_in1out0][pipe.endpoint]--;
+    libusb_dev->inflight_num--;
+
+    vsf_dlist_remove_head(vk_libusb_hcd_urb_t, ep_node,
+            &libusb_dev->ep_queue[pipe.dir_in1out0][pipe.endpoint], libusb_urb);
+    if (libusb_urb != NULL) {
+        __vk_libusb_hcd_submit_transfer(container_of(libusb_urb, vk_usbh_hcd_urb_t, priv));
+    } else if (libusb_dev->is_close_pending && !libusb_dev->inflight_num) {
+        __vk_libusb_hcd_close_dev(libusb_dev);
+    }
+}
+
+static void __vk_libusb_hcd_process_done(void)
+{
+    vk_libusb_hcd_urb_t *libusb_urb, *libusb_urb_next;
+    vk_usbh_hcd_urb_t *urb;
+
+    vsf_protect_t orig = vsf_protect_int();
+        libusb_urb = __vk_libusb_hcd.done_head;
+        __vk_libusb_hcd.done_head = __vk_libusb_hcd.done_tail = NULL;
+    vsf_unprotect_int(orig);
+
+    for (; libusb_urb != NULL; libusb_urb = libusb_urb_next) {
+        libusb_urb_next = libusb_urb->done_next;
+        urb = container_of(libusb_urb, vk_usbh_hcd_urb_t, priv);
+
+        if (libusb_urb->is_inflight) {
+            libusb_urb->is_inflight = false;
+            __vk_libusb_hcd_ep_release(libusb_urb->libusb_dev, urb->pipe);
+        }
+        if (libusb_urb->ctrl_buffer != NULL) {
+            if (    (libusb_urb->state != VSF_LIBUSB_HCD_URB_STATE_TO_FREE)
+                &&  (urb->setup_packet.bRequestType & USB_DIR_IN) && (urb->actual_length > 0)) {
+                memcpy(urb->buffer, libusb_urb->ctrl_buffer + LIBUSB_CONTROL_SETUP_SIZE, urb->actual_length);
+            }
+            vsf_usbh_free(libusb_urb->ctrl_buffer);
+            libusb_urb->ctrl_buffer = NULL;
+        }
+
+        if (VSF_LIBUSB_HCD_URB_STATE_TO_FREE == libusb_urb->state) {
+            __vk_libusb_hcd_free_urb_do(urb);
+        } else {
+#if VSF_LIBUSB_HCD_CFG_TRACE_URB_EN == ENABLED
+            __vk_libusb_hcd_trace_urb(urb, "notify");
+#endif
+            libusb_urb->state = VSF_LIBUSB_HCD_URB_STATE_IDLE;
+            vk_usbh_hcd_urb_complete(urb);
+        }
+    }
+}
+#else
 static bool __vk_libusb_hcd_free_urb_do(vk_usbh_hcd_urb_t *urb)
 {
     vk_libusb_hcd_urb_t *libusb_urb = (vk_libusb_hcd_urb_t *)urb->priv;
@@ -733,10 +1068,11 @@ static bool __vk_libusb_hcd_free_urb_do(vk_usbh_hcd_urb_t *urb)
         __vk_libusb_hcd_trace_urb(urb, "freed");
 #endif
         vk_usbh_hcd_urb_free_buffer(urb);
-        vsf_usbh_free(urb);
+        vk_usbh_hcd_urb_pool_free(__vk_libusb_hcd.hcd, urb);
         return true;
     }
 }
+#endif
 
 static void __vk_libusb_hcd_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
 {
@@ -744,6 +1080,14 @@ static void __vk_libusb_hcd_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
 
     switch (evt) {
     case VSF_EVT_INIT:
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN == ENABLED
+        __vk_libusb_hcd.done_head = __vk_libusb_hcd.done_tail = NULL;
+        vsf_teda_set_timer_ms(100);
+        break;
+    case VSF_EVT_LIBUSB_HCD_DONE:
+        __vk_libusb_hcd_process_done();
+        break;
+#else
         vsf_dlist_init(&__vk_libusb_hcd.urb_list);
         vsf_eda_sem_init(&__vk_libusb_hcd.sem, 0);
         vsf_teda_set_timer_ms(100);
@@ -818,6 +1162,7 @@ static void __vk_libusb_hcd_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
             goto wait_next_urb;
         }
         break;
+#endif
     case VSF_EVT_TIMER:
         if (__vk_libusb_hcd.new_mask != 0) {
             vk_usbh_t *usbh = (vk_usbh_t *)libusb->hcd;
@@ -825,7 +1170,11 @@ static void __vk_libusb_hcd_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
                 int idx = ffz(~__vk_libusb_hcd.new_mask);
                 VSF_USB_ASSERT(idx < dimof(__vk_libusb_hcd.devs));
                 vk_libusb_hcd_dev_t *libusb_dev = &__vk_libusb_hcd.devs[idx];
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN == ENABLED
+                VSF_USB_ASSERT(!libusb_dev->inflight_num);
+#else
                 VSF_USB_ASSERT(vsf_dlist_is_empty(&libusb_dev->urb_pending_list));
+#endif
                 __vk_libusb_hcd.cur_dev_idx = idx;
                 __vk_libusb_hcd.new_mask &= ~(1 << idx);
                 libusb_dev->addr = 0;
@@ -835,6 +1184,7 @@ static void __vk_libusb_hcd_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
         }
         vsf_teda_set_timer_ms(100);
         break;
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN != ENABLED
     case VSF_EVT_MESSAGE: {
             vk_usbh_hcd_urb_t *urb = vsf_eda_get_cur_msg();
             VSF_USB_ASSERT((urb != NULL) && urb->pipe.is_pipe);
@@ -876,12 +1226,13 @@ static void __vk_libusb_hcd_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
                 __vk_libusb_hcd_trace_urb(urb, "notify");
 #endif
 
-                vsf_eda_post_msg(urb->eda_caller, urb);
+                vk_usbh_hcd_urb_complete(urb);
                 libusb_urb->state = VSF_LIBUSB_HCD_URB_STATE_IDLE;
                 libusb_urb->is_msg_processed = true;
             }
         }
         break;
+#endif
     default: {
             int idx = evt & 0xFF;
             VSF_USB_ASSERT(idx < dimof(__vk_libusb_hcd.devs));
@@ -897,10 +1248,20 @@ static void __vk_libusb_hcd_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
                 if (libusb_dev->state != VSF_LIBUSB_HCD_DEV_STATE_DETACHED) {
                     libusb_dev->state = VSF_LIBUSB_HCD_DEV_STATE_DETACHED;
                     vk_usbh_disconnect_device((vk_usbh_t *)libusb->hcd, libusb_dev->dev);
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN == ENABLED
+                    libusb_dev->evt_mask.is_detaching = false;
+                    // device can only be closed after all transfers are reaped
+                    if (libusb_dev->inflight_num > 0) {
+                        libusb_dev->is_close_pending = true;
+                    } else {
+                        __vk_libusb_hcd_close_dev(libusb_dev);
+                    }
+#else
                     vsf_dlist_init(&libusb_dev->urb_pending_list);
                     libusb_dev->evt_mask.is_detached = true;
                     libusb_dev->evt_mask.is_detaching = false;
                     __vsf_arch_irq_request_send(&libusb_dev->irq_request);
+#endif
                 } else {
                     libusb_dev->evt_mask.is_detaching = false;
                 }
@@ -967,10 +1328,110 @@ static void __vk_libusb_hcd_free_device(vk_usbh_hcd_t *hcd, vk_usbh_hcd_dev_t *d
     dev->dev_priv = NULL;
 }
 
+#if VSF_LIBUSB_HCD_CFG_ASYNC_EN == ENABLED
 static vk_usbh_hcd_urb_t * __vk_libusb_hcd_alloc_urb(vk_usbh_hcd_t *hcd)
 {
     uint_fast32_t size = sizeof(vk_usbh_hcd_urb_t) + sizeof(vk_libusb_hcd_urb_t);
-    vk_usbh_hcd_urb_t *urb = vsf_usbh_malloc(size);
+    vk_usbh_hcd_urb_t *urb = vk_usbh_hcd_urb_pool_alloc(hcd, size, 0);
+
+    if (urb != NULL) {
+        memset(urb, 0, size);
+
+        vk_libusb_hcd_urb_t *libusb_urb = (vk_libusb_hcd_urb_t *)urb->priv;
+        libusb_urb->transfer = libusb_alloc_transfer(__VSF_LIBUSB_HCD_ISO_PACKET_NUM);
+        if (NULL == libusb_urb->transfer) {
+            vk_usbh_hcd_urb_pool_free(hcd, urb);
+            return NULL;
+        }
+        vsf_dlist_init_node(vk_libusb_hcd_urb_t, ep_node, libusb_urb);
+    }
+    return urb;
+}
+
+static void __vk_libusb_hcd_free_urb(vk_usbh_hcd_t *hcd, vk_usbh_hcd_urb_t *urb)
+{
+    vk_libusb_hcd_urb_t *libusb_urb = (vk_libusb_hcd_urb_t *)urb->priv;
+    vk_usbh_pipe_t pipe = urb->pipe;
+
+#if VSF_LIBUSB_HCD_CFG_TRACE_URB_EN == ENABLED
+    __vk_libusb_hcd_trace_urb(urb, "to free");
+#endif
+    switch (libusb_urb->state) {
+    case VSF_LIBUSB_HCD_URB_STATE_QUEUED:
+        vsf_dlist_remove(vk_libusb_hcd_urb_t, ep_node,
+                &libusb_urb->libusb_dev->ep_queue[pipe.dir_in1out0][pipe.endpoint], libusb_urb);
+        // fall through
+    case VSF_LIBUSB_HCD_URB_STATE_IDLE:
+        __vk_libusb_hcd_free_urb_do(urb);
+        break;
+    case VSF_LIBUSB_HCD_URB_STATE_SUBMITTED:
+        // freed in hcd task after cancelled transfer is reaped
+        libusb_urb->state = VSF_LIBUSB_HCD_URB_STATE_TO_FREE;
+        libusb_cancel_transfer(libusb_urb->transfer);
+        break;
+    case VSF_LIBUSB_HCD_URB_STATE_COMPLETING:
+        libusb_urb->state = VSF_LIBUSB_HCD_URB_STATE_TO_FREE;
+        break;
+    case VSF_LIBUSB_HCD_URB_STATE_TO_FREE:
+        break;
+    }
+}
+
+static vsf_err_t __vk_libusb_hcd_submit_urb(vk_usbh_hcd_t *hcd, vk_usbh_hcd_urb_t *urb)
+{
+    vk_libusb_hcd_urb_t *libusb_urb = (vk_libusb_hcd_urb_t *)urb->priv;
+    vk_libusb_hcd_dev_t *libusb_dev = urb->dev_hcd->dev_priv;
+    vk_usbh_pipe_t pipe = urb->pipe;
+
+    if ((NULL == libusb_dev) || (libusb_dev->state != VSF_LIBUSB_HCD_DEV_STATE_ATTACHED)) {
+        return VSF_ERR_FAIL;
+    }
+    libusb_urb->libusb_dev = libusb_dev;
+    libusb_urb->ctrl_buffer = NULL;
+    libusb_urb->is_inflight = false;
+
+    if (USB_ENDPOINT_XFER_CONTROL == pipe.type) {
+        struct usb_ctrlrequest_t *setup = &urb->setup_packet;
+
+        if ((USB_RECIP_DEVICE | USB_DIR_OUT) == setup->bRequestType) {
+            // set address is emulated, because device is already addressed by host
+            if (USB_REQ_SET_ADDRESS == setup->bRequest) {
+                VSF_USB_ASSERT(0 == libusb_dev->addr);
+                libusb_dev->addr = setup->wValue;
+                urb->status = URB_OK;
+                urb->actual_length = 0;
+                libusb_urb->state = VSF_LIBUSB_HCD_URB_STATE_COMPLETING;
+                __vk_libusb_hcd_urb_done(libusb_urb, libusb_urb);
+                return VSF_ERR_NONE;
+            }
+            // set configuration will claim interfaces, which is blocking
+            if (USB_REQ_SET_CONFIGURATION == setup->bRequest) {
+                libusb_urb->state = VSF_LIBUSB_HCD_URB_STATE_COMPLETING;
+                libusb_dev->config_urb = urb;
+                libusb_dev->evt_mask.is_configuring = true;
+                __vsf_arch_irq_request_send(&libusb_dev->irq_request);
+                return VSF_ERR_NONE;
+            }
+        }
+    }
+
+    if (libusb_dev->ep_inflight[pipe.dir_in1out0][pipe.endpoint] >= VSF_LIBUSB_HCD_CFG_EP_INFLIGHT_NUM) {
+        libusb_urb->state = VSF_LIBUSB_HCD_URB_STATE_QUEUED;
+        vsf_dlist_add_to_tail(vk_libusb_hcd_urb_t, ep_node,
+                &libusb_dev->ep_queue[pipe.dir_in1out0][pipe.endpoint], libusb_urb);
+#if VSF_LIBUSB_HCD_CFG_TRACE_URB_EN == ENABLED
+        __vk_libusb_hcd_trace_urb(urb, "enqueued+");
+#endif
+        return VSF_ERR_NONE;
+    }
+    __vk_libusb_hcd_submit_transfer(urb);
+    return VSF_ERR_NONE;
+}
+#else
+static vk_usbh_hcd_urb_t * __vk_libusb_hcd_alloc_urb(vk_usbh_hcd_t *hcd)
+{
+    uint_fast32_t size = sizeof(vk_usbh_hcd_urb_t) + sizeof(vk_libusb_hcd_urb_t);
+    vk_usbh_hcd_urb_t *urb = vk_usbh_hcd_urb_pool_alloc(hcd, size, 0);
 
     if (urb != NULL) {
         memset(urb, 0, size);
@@ -1021,6 +1482,7 @@ static vsf_err_t __vk_libusb_hcd_submit_urb(vk_usbh_hcd_t *hcd, vk_usbh_hcd_urb_
     vsf_eda_sem_post(&__vk_libusb_hcd.sem);
     return VSF_ERR_NONE;
 }
+#endif
 
 static vsf_err_t __vk_libusb_hcd_relink_urb(vk_usbh_hcd_t *hcd, vk_usbh_hcd_urb_t *urb)
 {
@@ -321,6 +321,7 @@ typedef struct vk_ohci_t {
     implement(ohci_hcca_t);
 
     vsf_eda_t eda;
+    vk_usbh_hcd_t *hcd;
     ohci_regs_t *regs;
 
     ohci_hcd_state_t state;
@@ -352,7 +353,7 @@ struct ohci_urb_t {
 
 /*============================ PROTOTYPES ====================================*/
 
-static void __ohci_free_urb_do(vk_usbh_hcd_urb_t *urb);
+static void __ohci_free_urb_do(vk_usbh_hcd_t *hcd, vk_usbh_hcd_urb_t *urb);
 
 static vsf_err_t __ohci_init_evthandler(vsf_eda_t *eda, vsf_evt_t evt, vk_usbh_hcd_t *hcd);
 static vsf_err_t __ohci_fini(vk_usbh_hcd_t *hcd);
@@ -854,7 +855,7 @@ static void __ohci_finish_unlinks(vk_ohci_t *ohci)
                 __ohci_ed_fini(urb_ohci);
                 urb_ohci->state &= ~(URB_PRIV_EDSKIP | URB_PRIV_WAIT_COMPLETE);
 
-                vsf_eda_post_msg(urb->eda_caller, urb);
+                vk_usbh_hcd_urb_complete(urb);
             }
         } else {
             // TODO: no vsf_slist API to get &ed->node.next
@@ -988,7 +989,7 @@ static void ohci_td_takeback(vk_ohci_t *ohci, ohci_td_t *td)
             urb_ohci->state |= URB_PRIV_WAIT_COMPLETE;
             __ohci_ed_start_unlink(ohci, urb_ohci);
         } else {
-            vsf_eda_post_msg(urb->eda_caller, urb);
+            vk_usbh_hcd_urb_complete(urb);
         }
     }
 }
@@ -1079,6 +1080,7 @@ static void __ohci_ed_free_evthanlder(vsf_eda_t *eda, vsf_evt_t evt)
 {
     switch (evt) {
         case VSF_EVT_MESSAGE: {
+            vk_ohci_t *ohci = container_of(eda, vk_ohci_t, eda);
             ohci_ed_t *ed, *ed_dellist = vsf_eda_get_cur_msg();
             vk_usbh_hcd_urb_t *urb;
             ohci_urb_t *urb_ohci;
@@ -1090,7 +1092,7 @@ static void __ohci_ed_free_evthanlder(vsf_eda_t *eda, vsf_evt_t evt)
                 urb_ohci = ed->td_dummy->urb_ohci;
                 urb = container_of(urb_ohci, vk_usbh_hcd_urb_t, priv);
                 __ohci_ed_fini(urb_ohci);
-                __ohci_free_urb_do(urb);
+                __ohci_free_urb_do(ohci->hcd, urb);
             }
         }
         break;
@@ -1118,6 +1120,7 @@ static vsf_err_t __ohci_init_evthandler(vsf_eda_t *eda, vsf_evt_t evt, vk_usbh_h
             VSF_USB_ASSERT(false);
             return VSF_ERR_NOT_ENOUGH_RESOURCES;
         }
+        ohci->hcd = hcd;
 
         {
             usb_hc_ip_cfg_t cfg = {
@@ -1192,7 +1195,7 @@ static vk_usbh_hcd_urb_t * __ohci_alloc_urb(vk_usbh_hcd_t *hcd)
     VSF_USB_ASSERT(hcd != NULL);
 
     size = sizeof(ohci_ed_t) + sizeof(vk_usbh_hcd_urb_t) + sizeof(ohci_urb_t);
-    ed = vsf_usbh_malloc_aligned(size, 16);
+    ed = vk_usbh_hcd_urb_pool_alloc(hcd, size, 16);
     if (ed) {
         memset(ed, 0, size);
         urb = (vk_usbh_hcd_urb_t *)(ed + 1);
@@ -1202,11 +1205,11 @@ static vk_usbh_hcd_urb_t * __ohci_alloc_urb(vk_usbh_hcd_t *hcd)
     return urb;
 }
 
-static void __ohci_free_urb_do(vk_usbh_hcd_urb_t *urb)
+static void __ohci_free_urb_do(vk_usbh_hcd_t *hcd, vk_usbh_hcd_urb_t *urb)
 {
     ohci_urb_t *urb_ohci = (ohci_urb_t *)urb->priv;
     vk_usbh_hcd_urb_free_buffer(urb);
-    vsf_usbh_free(urb_ohci->ed);
+    vk_usbh_hcd_urb_pool_free(hcd, urb_ohci->ed);
 }
 
 static void __ohci_free_urb(vk_usbh_hcd_t *hcd, vk_usbh_hcd_urb_t *urb)
@@ -1228,7 +1231,7 @@ static void __ohci_free_urb(vk_usbh_hcd_t *hcd, vk_usbh_hcd_urb_t *urb)
             __ohci_ed_start_unlink(ohci, urb_ohci);
         }
     } else {
-        __ohci_free_urb_do(urb);
+        __ohci_free_urb_do(hcd, urb);
     }
 }
 
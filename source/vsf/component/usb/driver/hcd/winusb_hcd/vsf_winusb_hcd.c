@@ -627,7 +627,7 @@ static bool __vk_winusb_hcd_free_urb_do(vk_usbh_hcd_urb_t *urb)
         return false;
     } else {
         vk_usbh_hcd_urb_free_buffer(urb);
-        vsf_usbh_free(urb);
+        vk_usbh_hcd_urb_pool_free(__vk_winusb_hcd.hcd, urb);
         return true;
     }
 }
@@ -749,7 +749,7 @@ static void __vk_winusb_hcd_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
                     winusb_urb->is_msg_processed = true;
                 }
             } else {
-                vsf_eda_post_msg(urb->eda_caller, urb);
+                vk_usbh_hcd_urb_complete(urb);
                 winusb_urb->state = VSF_WINUSB_HCD_URB_STATE_IDLE;
                 winusb_urb->is_msg_processed = true;
             }
@@ -840,7 +840,7 @@ static void __vk_winusb_hcd_free_device(vk_usbh_hcd_t *hcd, vk_usbh_hcd_dev_t *d
 static vk_usbh_hcd_urb_t * __vk_winusb_hcd_alloc_urb(vk_usbh_hcd_t *hcd)
 {
     uint_fast32_t size = sizeof(vk_usbh_hcd_urb_t) + sizeof(vk_winusb_hcd_urb_t);
-    vk_usbh_hcd_urb_t *urb = vsf_usbh_malloc(size);
+    vk_usbh_hcd_urb_t *urb = vk_usbh_hcd_urb_pool_alloc(hcd, size, 0);
 
     if (urb != NULL) {
         memset(urb, 0, size);
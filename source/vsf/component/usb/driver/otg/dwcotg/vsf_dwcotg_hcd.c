@@ -618,7 +618,7 @@ static void __vk_dwcotg_hcd_channel_interrupt(vk_dwcotg_hcd_t *dwcotg_hcd, uint_
                 urb_done_check_stall:
                     urb->status = is_stall ? URB_FAIL : URB_OK;
                 urb_done:
-                    vsf_eda_post_msg(urb->eda_caller, urb);
+                    vk_usbh_hcd_urb_complete(urb);
                 }
                 break;
             case USB_ENDPOINT_XFER_INT:
@@ -450,7 +450,7 @@ static void __vk_musb_fdrc_hcd_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
                 urb_finish:
                     musb_urb->state = MUSB_FDRC_URB_STATE_IDLE;
                     vsf_slist_remove(vk_musb_fdrc_urb_t, urb_node, &musb->dev_priv.urb_list, musb_urb);
-                    vsf_eda_post_msg(urb->eda_caller, urb);
+                    vk_usbh_hcd_urb_complete(urb);
                 }
                 break;
             }
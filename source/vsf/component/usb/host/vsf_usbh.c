@@ -38,9 +38,18 @@
 
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
+
+typedef struct vk_usbh_mem_node_t {
+    vsf_slist_node_t node;
+} vk_usbh_mem_node_t;
+
 /*============================ GLOBAL VARIABLES ==============================*/
 /*============================ LOCAL VARIABLES ===============================*/
 
+#if VSF_USBH_CFG_BUFFER_POOL_EN == ENABLED
+static vk_usbh_mem_pool_t __vk_usbh_buffer_pool[VSF_USBH_CFG_BUFFER_POOL_CLASS_NUM];
+#endif
+
 #if VSF_USBH_CFG_ENABLE_ROOT_HUB == ENABLED
 /* usb 2.0 root hub device descriptor */
 static const uint8_t __vk_usb_rh_dev_descriptor[18] = {
@@ -219,16 +228,129 @@ void vk_usbh_urb_set_pipe(vk_usbh_urb_t *urb, vk_usbh_pipe_t pipe)
     }
 }
 
+static void * __vk_usbh_mem_pool_get(vk_usbh_mem_pool_t *pool)
+{
+    vk_usbh_mem_node_t *mem;
+    vsf_protect_t orig = vsf_protect_int();
+        vsf_slist_stack_pop(vk_usbh_mem_node_t, node, &pool->free_list, mem);
+        if (mem != NULL) {
+            pool->free_cnt--;
+        }
+    vsf_unprotect_int(orig);
+    return mem;
+}
+
+static bool __vk_usbh_mem_pool_put(vk_usbh_mem_pool_t *pool, uint_fast16_t max_cnt, void *mem)
+{
+    vk_usbh_mem_node_t *node = mem;
+    bool is_cached = false;
+    vsf_protect_t orig = vsf_protect_int();
+        if (pool->free_cnt < max_cnt) {
+            vsf_slist_init_node(vk_usbh_mem_node_t, node, node);
+            vsf_slist_stack_push(vk_usbh_mem_node_t, node, &pool->free_list, node);
+            pool->free_cnt++;
+            is_cached = true;
+        }
+    vsf_unprotect_int(orig);
+    return is_cached;
+}
+
+void * vk_usbh_hcd_urb_pool_alloc(vk_usbh_hcd_t *hcd, uint_fast32_t size,
+            uint_fast32_t align)
+{
+    VSF_USB_ASSERT((hcd != NULL) && (size >= sizeof(vk_usbh_mem_node_t)));
+#if VSF_USBH_CFG_URB_POOL_SIZE > 0
+    void *mem = __vk_usbh_mem_pool_get(&hcd->urb_pool);
+    if (mem != NULL) {
+        return mem;
+    }
+#endif
+    return align ? vsf_usbh_malloc_aligned(size, align) : vsf_usbh_malloc(size);
+}
+
+void vk_usbh_hcd_urb_pool_free(vk_usbh_hcd_t *hcd, void *mem)
+{
+    VSF_USB_ASSERT((hcd != NULL) && (mem != NULL));
+#if VSF_USBH_CFG_URB_POOL_SIZE > 0
+    if (__vk_usbh_mem_pool_put(&hcd->urb_pool, VSF_USBH_CFG_URB_POOL_SIZE, mem)) {
+        return;
+    }
+#endif
+    vsf_usbh_free(mem);
+}
+
+#if VSF_USBH_CFG_EP_STATISTICS == ENABLED
+static vk_usbh_ep_stat_t * __vk_usbh_urb_get_ep_stat(vk_usbh_hcd_urb_t *urb_hcd)
+{
+    vk_usbh_dev_t *dev = container_of(urb_hcd->dev_hcd, vk_usbh_dev_t, use_as__vk_usbh_hcd_dev_t);
+    return &dev->ep_stat[urb_hcd->pipe.dir_in1out0][urb_hcd->pipe.endpoint];
+}
+
+vk_usbh_ep_stat_t * vk_usbh_get_ep_stat(vk_usbh_dev_t *dev, uint_fast8_t ep)
+{
+    VSF_USB_ASSERT(dev != NULL);
+    return &dev->ep_stat[(ep & USB_DIR_MASK) ? 1 : 0][ep & 0x0F];
+}
+
+void vk_usbh_reset_ep_stat(vk_usbh_dev_t *dev)
+{
+    VSF_USB_ASSERT(dev != NULL);
+    memset(dev->ep_stat, 0, sizeof(dev->ep_stat));
+}
+#endif
+
+vsf_err_t vk_usbh_hcd_urb_complete(vk_usbh_hcd_urb_t *urb_hcd)
+{
+    VSF_USB_ASSERT(urb_hcd != NULL);
+#if VSF_USBH_CFG_EP_STATISTICS == ENABLED
+    if (urb_hcd->dev_hcd != NULL) {
+        vk_usbh_ep_stat_t *stat = __vk_usbh_urb_get_ep_stat(urb_hcd);
+        if (URB_OK == urb_hcd->status) {
+            stat->done_cnt++;
+            stat->bytes += urb_hcd->actual_length;
+        } else {
+            stat->err_cnt++;
+        }
+    }
+#endif
+    return vsf_eda_post_msg(urb_hcd->eda_caller, urb_hcd);
+}
+
+#if VSF_USBH_CFG_BUFFER_POOL_EN == ENABLED
+static uint_fast8_t __vk_usbh_buffer_pool_idx(uint_fast32_t size)
+{
+    uint_fast8_t idx = 0;
+    for (uint_fast32_t class_size = VSF_USBH_CFG_BUFFER_POOL_MIN_SIZE;
+            (class_size < size) && (idx < VSF_USBH_CFG_BUFFER_POOL_CLASS_NUM);
+            class_size <<= 2, idx++);
+    return idx;
+}
+#endif
+
 static void __vk_usbh_urb_reset_buffer(vk_usbh_hcd_urb_t *urb_hcd)
 {
     urb_hcd->buffer = NULL;
     urb_hcd->transfer_length = 0;
     urb_hcd->free_buffer = NULL;
+    urb_hcd->buffer_size = 0;
 }
 
 void vk_usbh_hcd_urb_free_buffer(vk_usbh_hcd_urb_t *urb_hcd)
 {
     VSF_USB_ASSERT(urb_hcd != NULL);
+#if VSF_USBH_CFG_BUFFER_POOL_EN == ENABLED
+    // buffer from pool is saved in free_buffer_param, buffer maybe changed by user
+    if (urb_hcd->buffer_size > 0) {
+        void *buffer = urb_hcd->free_buffer_param;
+        uint_fast8_t idx = __vk_usbh_buffer_pool_idx(urb_hcd->buffer_size);
+
+        VSF_USB_ASSERT(idx < VSF_USBH_CFG_BUFFER_POOL_CLASS_NUM);
+        if (!__vk_usbh_mem_pool_put(&__vk_usbh_buffer_pool[idx],
+                    VSF_USBH_CFG_BUFFER_POOL_SIZE, buffer)) {
+            vsf_usbh_free(buffer);
+        }
+    } else
+#endif
     if (urb_hcd->buffer && (urb_hcd->free_buffer != NULL)) {
         urb_hcd->free_buffer(urb_hcd->free_buffer_param);
     }
@@ -243,8 +365,34 @@ static void __vk_usbh_free_buffer(void *buffer)
 void * vk_usbh_hcd_urb_alloc_buffer(vk_usbh_hcd_urb_t *urb_hcd, uint_fast16_t size)
 {
     VSF_USB_ASSERT((urb_hcd != NULL) && (size > 0));
+#if VSF_USBH_CFG_BUFFER_POOL_EN == ENABLED
+    // keep current pool buffer if it's large enough
+    if (urb_hcd->buffer_size >= size) {
+        urb_hcd->buffer = urb_hcd->free_buffer_param;
+        urb_hcd->transfer_length = size;
+        return urb_hcd->buffer;
+    }
+#endif
     vk_usbh_hcd_urb_free_buffer(urb_hcd);
-    urb_hcd->buffer = vsf_usbh_malloc(size);
+#if VSF_USBH_CFG_BUFFER_POOL_EN == ENABLED
+    uint_fast8_t idx = __vk_usbh_buffer_pool_idx(size);
+    if (idx < VSF_USBH_CFG_BUFFER_POOL_CLASS_NUM) {
+        uint_fast32_t class_size = VSF_USBH_CFG_BUFFER_POOL_MIN_SIZE << (idx << 1);
+        void *buffer = __vk_usbh_mem_pool_get(&__vk_usbh_buffer_pool[idx]);
+        if (NULL == buffer) {
+            buffer = vsf_usbh_malloc_aligned(class_size, VSF_USBH_CFG_BUFFER_ALIGN);
+            if (NULL == buffer) {
+                return NULL;
+            }
+        }
+        urb_hcd->buffer = buffer;
+        urb_hcd->transfer_length = size;
+        urb_hcd->buffer_size = class_size;
+        urb_hcd->free_buffer_param = buffer;
+        return buffer;
+    }
+#endif
+    urb_hcd->buffer = vsf_usbh_malloc_aligned(size, VSF_USBH_CFG_BUFFER_ALIGN);
     urb_hcd->transfer_length = size;
     urb_hcd->free_buffer = __vk_usbh_free_buffer;
     urb_hcd->free_buffer_param = urb_hcd->buffer;
@@ -371,6 +519,19 @@ vsf_err_t vk_usbh_alloc_urb(vk_usbh_t *usbh, vk_usbh_dev_t *dev, vk_usbh_urb_t *
     }
 }
 
+vsf_err_t vk_usbh_alloc_urb_ex(vk_usbh_t *usbh, vk_usbh_dev_t *dev,
+            vk_usbh_urb_t *urb, uint_fast16_t buffer_size)
+{
+    vsf_err_t err = vk_usbh_alloc_urb(usbh, dev, urb);
+    if ((VSF_ERR_NONE == err) && (buffer_size > 0)) {
+        if (NULL == vk_usbh_urb_alloc_buffer(urb, buffer_size)) {
+            vk_usbh_free_urb(usbh, urb);
+            return VSF_ERR_NOT_ENOUGH_RESOURCES;
+        }
+    }
+    return err;
+}
+
 void vk_usbh_free_urb(vk_usbh_t *usbh, vk_usbh_urb_t *urb)
 {
     VSF_USB_ASSERT((usbh != NULL) && (urb != NULL));
@@ -613,7 +774,7 @@ static vsf_err_t __vk_usbh_rh_submit_urb(vk_usbh_hcd_t *hcd, vk_usbh_hcd_urb_t *
 
 complete:
     urb_hcd->status = URB_OK;
-    return vsf_eda_post_msg(urb_hcd->eda_caller, urb_hcd);
+    return vk_usbh_hcd_urb_complete(urb_hcd);
 
 error:
     urb_hcd->status = URB_FAIL;
@@ -636,6 +797,9 @@ static vsf_err_t __vk_usbh_submit_urb_imp(vk_usbh_t *usbh, vk_usbh_urb_t *urb, v
     }
 
     urb_hcd->actual_length = 0;
+#if VSF_USBH_CFG_EP_STATISTICS == ENABLED
+    __vk_usbh_urb_get_ep_stat(urb_hcd)->submit_cnt++;
+#endif
 #if VSF_USBH_CFG_ENABLE_ROOT_HUB == ENABLED
     if (urb_hcd->dev_hcd == &usbh->dev_rh->use_as__vk_usbh_hcd_dev_t) {
         return __vk_usbh_rh_submit_urb(&usbh->use_as__vk_usbh_hcd_t, urb_hcd);
@@ -661,6 +825,16 @@ vsf_err_t vk_usbh_submit_urb(vk_usbh_t *usbh, vk_usbh_urb_t *urb)
     return __vk_usbh_submit_urb_imp(usbh, urb, NULL);
 }
 
+vsf_err_t vk_usbh_resubmit_urb(vk_usbh_t *usbh, vk_usbh_urb_t *urb, uint_fast32_t size)
+{
+    VSF_USB_ASSERT(vk_usbh_urb_is_alloced(urb));
+    vk_usbh_hcd_urb_t *urb_hcd = urb->urb_hcd;
+    VSF_USB_ASSERT(     (urb_hcd->buffer != NULL)
+                    &&  (!urb_hcd->buffer_size || (size <= urb_hcd->buffer_size)));
+    urb_hcd->transfer_length = size;
+    return __vk_usbh_submit_urb_imp(usbh, urb, NULL);
+}
+
 vsf_err_t vk_usbh_submit_urb_flags(vk_usbh_t *usbh, vk_usbh_urb_t *urb, uint_fast16_t flags)
 {
     VSF_USB_ASSERT(vk_usbh_urb_is_alloced(urb));
@@ -1181,6 +1355,10 @@ vsf_err_t vk_usbh_init(vk_usbh_t *usbh)
     VSF_USB_ASSERT((usbh != NULL) && (usbh->drv != NULL));
 
     vsf_slist_init(&usbh->class_list);
+#if VSF_USBH_CFG_URB_POOL_SIZE > 0
+    vsf_slist_init(&usbh->urb_pool.free_list);
+    usbh->urb_pool.free_cnt = 0;
+#endif
     vsf_bitmap_reset(&usbh->device_bitmap, VSF_USBH_CFG_MAX_DEVICE);
     vsf_bitmap_set(&usbh->device_bitmap, 0);
 
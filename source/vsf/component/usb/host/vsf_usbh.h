@@ -83,6 +83,39 @@ extern "C" {
 #   define VSF_USBH_CFG_MAX_DEVICE      127
 #endif
 
+// max idle urbs cached in the urb pool of each hcd, 0 to disable
+#ifndef VSF_USBH_CFG_URB_POOL_SIZE
+#   define VSF_USBH_CFG_URB_POOL_SIZE   8
+#endif
+
+// alignment of transfer buffers from vk_usbh_urb_alloc_buffer,
+//  set to cache line size if hcd DMA requires
+#ifndef VSF_USBH_CFG_BUFFER_ALIGN
+#   define VSF_USBH_CFG_BUFFER_ALIGN    4
+#endif
+
+#ifndef VSF_USBH_CFG_BUFFER_POOL_EN
+#   define VSF_USBH_CFG_BUFFER_POOL_EN  ENABLED
+#endif
+
+#if VSF_USBH_CFG_BUFFER_POOL_EN == ENABLED
+// size of class n is VSF_USBH_CFG_BUFFER_POOL_MIN_SIZE << (2 * n)
+#   ifndef VSF_USBH_CFG_BUFFER_POOL_MIN_SIZE
+#       define VSF_USBH_CFG_BUFFER_POOL_MIN_SIZE    64
+#   endif
+#   ifndef VSF_USBH_CFG_BUFFER_POOL_CLASS_NUM
+#       define VSF_USBH_CFG_BUFFER_POOL_CLASS_NUM   4
+#   endif
+// max idle buffers cached in each size class
+#   ifndef VSF_USBH_CFG_BUFFER_POOL_SIZE
+#       define VSF_USBH_CFG_BUFFER_POOL_SIZE        4
+#   endif
+#endif
+
+#ifndef VSF_USBH_CFG_EP_STATISTICS
+#   define VSF_USBH_CFG_EP_STATISTICS   DISABLED
+#endif
+
 #ifdef VSF_USBH_CFG_HEAP
 #   undef vsf_usbh_malloc
 #   undef vsf_usbh_malloc_aligned
@@ -259,6 +292,20 @@ typedef struct vk_usbh_class_t {
     vsf_slist_node_t node;
 } vk_usbh_class_t;
 
+typedef struct vk_usbh_mem_pool_t {
+    vsf_slist_t free_list;
+    uint16_t free_cnt;
+} vk_usbh_mem_pool_t;
+
+#if VSF_USBH_CFG_EP_STATISTICS == ENABLED
+typedef struct vk_usbh_ep_stat_t {
+    uint32_t submit_cnt;
+    uint32_t done_cnt;
+    uint32_t err_cnt;
+    uint64_t bytes;
+} vk_usbh_ep_stat_t;
+#endif
+
 typedef struct vk_usbh_pipe_t {
     union {
         struct {
@@ -324,6 +371,12 @@ def_simple_class(vk_usbh_hcd_t) {
     private_member(
         void *priv;
     )
+
+#if VSF_USBH_CFG_URB_POOL_SIZE > 0
+    private_member(
+        vk_usbh_mem_pool_t urb_pool;
+    )
+#endif
 };
 
 #if VSF_USBH_CFG_ISO_EN == ENABLED
@@ -382,6 +435,8 @@ def_simple_class(vk_usbh_hcd_urb_t) {
         void *buffer;
         void (*free_buffer)(void *param);
         void *free_buffer_param;
+        // size of the buffer from buffer pool, 0 for other buffers
+        uint32_t buffer_size;
 
         union {
             struct usb_ctrlrequest_t setup_packet;
@@ -467,6 +522,13 @@ def_simple_class(vk_usbh_dev_t) {
         uint8_t maxchild    : 4;
         uint8_t index       : 4;
     )
+
+#if VSF_USBH_CFG_EP_STATISTICS == ENABLED
+    protected_member(
+        // [dir_in1out0][endpoint]
+        vk_usbh_ep_stat_t ep_stat[2][16];
+    )
+#endif
 };
 
 #ifdef __cplusplus
@@ -524,6 +586,12 @@ extern void vk_usbh_register_class(vk_usbh_t *usbh, vk_usbh_class_t *c);
 #if defined(__VSF_USBH_CLASS_IMPLEMENT) || defined(__VSF_USBH_CLASS_IMPLEMENT_HCD__)
 // APIs to be called by hcd drivers
 void vk_usbh_hcd_urb_free_buffer(vk_usbh_hcd_urb_t *urb_hcd);
+// memory of hcd urbs, size and align MUST be the same for the same hcd
+extern void * vk_usbh_hcd_urb_pool_alloc(vk_usbh_hcd_t *hcd, uint_fast32_t size,
+            uint_fast32_t align);
+extern void vk_usbh_hcd_urb_pool_free(vk_usbh_hcd_t *hcd, void *mem);
+// notify urb done to the caller eda, instead of posting message directly
+extern vsf_err_t vk_usbh_hcd_urb_complete(vk_usbh_hcd_urb_t *urb_hcd);
 #endif
 
 #if defined(__VSF_USBH_CLASS_IMPLEMENT_HUB__)
@@ -548,6 +616,9 @@ extern bool vk_usbh_urb_is_alloced(vk_usbh_urb_t *urb);
 extern vk_usbh_pipe_t vk_usbh_urb_get_pipe(vk_usbh_urb_t *urb);
 extern void vk_usbh_urb_set_pipe(vk_usbh_urb_t *urb, vk_usbh_pipe_t pipe);
 extern vsf_err_t vk_usbh_alloc_urb(vk_usbh_t *usbh, vk_usbh_dev_t *dev, vk_usbh_urb_t *urb);
+// alloc urb with a bound buffer, which is kept until urb is freed
+extern vsf_err_t vk_usbh_alloc_urb_ex(vk_usbh_t *usbh, vk_usbh_dev_t *dev,
+            vk_usbh_urb_t *urb, uint_fast16_t buffer_size);
 extern void vk_usbh_free_urb(vk_usbh_t *usbh, vk_usbh_urb_t *urb);
 extern void * vk_usbh_urb_alloc_buffer(vk_usbh_urb_t *urb, uint_fast16_t size);
 extern void vk_usbh_urb_free_buffer(vk_usbh_urb_t *urb);
@@ -563,6 +634,8 @@ extern void vk_usbh_reset_dev(vk_usbh_t *usbh, vk_usbh_dev_t *dev);
 extern vsf_err_t vk_usbh_submit_urb(vk_usbh_t *usbh, vk_usbh_urb_t *urb);
 extern vsf_err_t vk_usbh_submit_urb_flags(vk_usbh_t *usbh, vk_usbh_urb_t *urb, uint_fast16_t flags);
 extern vsf_err_t vk_usbh_submit_urb_ex(vk_usbh_t *usbh, vk_usbh_urb_t *urb, uint_fast16_t flags, vsf_eda_t *eda);
+// resubmit urb with the bound buffer
+extern vsf_err_t vk_usbh_resubmit_urb(vk_usbh_t *usbh, vk_usbh_urb_t *urb, uint_fast32_t size);
 
 #if VSF_USBH_CFG_ISO_EN == ENABLED
 extern vsf_err_t vk_usbh_submit_urb_iso(vk_usbh_t *usbh, vk_usbh_urb_t *urb, uint_fast8_t start_frame);
@@ -592,6 +665,12 @@ extern vsf_err_t vk_usbh_get_extra_descriptor(uint8_t *buf, uint_fast16_t size,
 
 extern usb_endpoint_desc_t * vk_usbh_get_next_ep_descriptor(
         usb_endpoint_desc_t *desc_ep, uint_fast16_t size);
+
+#if VSF_USBH_CFG_EP_STATISTICS == ENABLED
+// ep is endpoint address, including direction bit
+extern vk_usbh_ep_stat_t * vk_usbh_get_ep_stat(vk_usbh_dev_t *dev, uint_fast8_t ep);
+extern void vk_usbh_reset_ep_stat(vk_usbh_dev_t *dev);
+#endif
 #endif
 
 #ifdef __cplusplus
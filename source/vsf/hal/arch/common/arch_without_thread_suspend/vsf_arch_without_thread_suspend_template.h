@@ -17,16 +17,34 @@
 
 /*============================ INCLUDES ======================================*/
 /*============================ MACROS ========================================*/
+
+// number of host threads that run irq context concurrently, 1 for uni-core
+#ifndef VSF_ARCH_CFG_CORE_NUM
+#   define VSF_ARCH_CFG_CORE_NUM        1
+#endif
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
 
 typedef struct vsf_arch_irq_thread_common_t {
     const char name[32];
     vsf_arch_irq_entry_t entry;
+#if VSF_ARCH_CFG_CORE_NUM > 1
+    uint8_t core;
+#endif
 } vsf_arch_irq_thread_common_t;
 
 /*============================ GLOBAL VARIABLES ==============================*/
 /*============================ LOCAL VARIABLES ===============================*/
 /*============================ PROTOTYPES ====================================*/
 
+#if VSF_ARCH_CFG_CORE_NUM > 1
+extern uint_fast8_t vsf_arch_get_core_id(void);
+extern void __vsf_arch_wakeup(void);
+extern void vsf_arch_smp_lock(void);
+extern void vsf_arch_smp_unlock(void);
+extern vsf_gint_state_t vsf_arch_smp_protect_int(void);
+extern void vsf_arch_smp_unprotect_int(vsf_gint_state_t orig);
+#endif
+
 /* EOF */
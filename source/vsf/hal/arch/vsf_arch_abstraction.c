@@ -243,7 +243,8 @@ uint_fast8_t vsf_clz(uint_fast32_t a)
         num += __optimal_bit_sz;
     } while (--word_size);
 
-    return num;
+    // remove leading zeros beyond 32-bit if uintalu_t is wider
+    return num - (((32 + __optimal_bit_sz - 1) / __optimal_bit_sz) * __optimal_bit_sz - 32);
 }
 #endif
 
@@ -266,7 +267,8 @@ WEAK(vsf_msb)
 int_fast8_t vsf_msb(uint_fast32_t a)
 {
     int_fast8_t word_size = (32 + __optimal_bit_sz - 1) / __optimal_bit_sz;
-    int_fast8_t index = 31, temp;
+    // index of the msb in the highest word, uintalu_t can be wider than 32-bit
+    int_fast8_t index = word_size * __optimal_bit_sz - 1, temp;
     uintalu_t* src = (uintalu_t*)&a + (word_size - 1);
 
     do {
@@ -361,7 +363,7 @@ static void __default_code_region_atom_code_on_enter(void *obj_ptr, void *local_
     UNUSED_PARAM(local_ptr);
 
     ASSERT(NULL != local_ptr);
-    (*state_ptr) = vsf_disable_interrupt();
+    (*state_ptr) = vsf_protect_int();
 }
 
 static void __default_code_region_atom_code_on_leave(void *obj_ptr,void *local_ptr)
@@ -373,7 +375,7 @@ static void __default_code_region_atom_code_on_leave(void *obj_ptr,void *local_p
 
     ASSERT(NULL != local_ptr);
 
-    vsf_set_interrupt(*state_ptr);
+    vsf_unprotect_int(*state_ptr);
 }
 
 /*----------------------------------------------------------------------------*
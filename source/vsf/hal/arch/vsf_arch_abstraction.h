@@ -162,16 +162,16 @@ extern void put_unaligned_be##__bitlen(uint_fast##__bitlen##_t, void *);
 #   if !defined(__STDC_VERSION__) || __STDC_VERSION__ < 199901L
 #       define __vsf_interrupt_safe(__code)                                     \
         {                                                                       \
-            vsf_gint_state_t gint_state = vsf_disable_interrupt();              \
+            vsf_gint_state_t gint_state = vsf_protect_int();                    \
                 __code;                                                         \
-            vsf_set_interrupt(gint_state);                                      \
+            vsf_unprotect_int(gint_state);                                      \
         }
 #   else
 #       define __vsf_interrupt_safe(...)                                        \
         {                                                                       \
-            vsf_gint_state_t gint_state = vsf_disable_interrupt();              \
+            vsf_gint_state_t gint_state = vsf_protect_int();                    \
                 __VA_ARGS__;                                                    \
-            vsf_set_interrupt(gint_state);                                      \
+            vsf_unprotect_int(gint_state);                                      \
         }
 #   endif
 #endif
@@ -186,8 +186,14 @@ extern void put_unaligned_be##__bitlen(uint_fast##__bitlen##_t, void *);
 
 
 #define vsf_protect_t                       uint_fast32_t
-#define vsf_protect_interrupt()             vsf_disable_interrupt()
-#define vsf_unprotect_interrupt(__state)    vsf_set_interrupt(__state)
+#if defined(VSF_ARCH_CFG_CORE_NUM) && VSF_ARCH_CFG_CORE_NUM > 1
+// interrupt is masked per core, data shared between cores needs smp lock
+#   define vsf_protect_interrupt()          vsf_arch_smp_protect_int()
+#   define vsf_unprotect_interrupt(__state) vsf_arch_smp_unprotect_int(__state)
+#else
+#   define vsf_protect_interrupt()          vsf_disable_interrupt()
+#   define vsf_unprotect_interrupt(__state) vsf_set_interrupt(__state)
+#endif
 #define vsf_protect_none()                  (0)
 #define vsf_unprotect_none(__state)         UNUSED_PARAM(__state)
 
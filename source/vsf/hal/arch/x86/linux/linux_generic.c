@@ -25,10 +25,16 @@
 #include <signal.h>
 #include <time.h>
 #include <pthread.h>
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+#   include <sys/epoll.h>
+#   include <sys/eventfd.h>
+#   include <sys/timerfd.h>
+#endif
 
 /*============================ MACROS ========================================*/
 
-#if VSF_ARCH_PRI_NUM != 1 || VSF_ARCH_SWI_NUM != 0
+#if     VSF_ARCH_PRI_NUM != VSF_ARCH_CFG_CORE_NUM                               \
+    ||  VSF_ARCH_SWI_NUM != (VSF_ARCH_CFG_CORE_NUM - 1)
 #   error "linux support parameter error!"
 #endif
 
@@ -36,8 +42,17 @@
 #   define VSF_ARCH_CFG_THREAD_NUM          32
 #endif
 
+// every thread in the pool holds a start_request, so more are needed for
+//  wakeup, systimer, swi and drivers
 #ifndef VSF_ARCH_CFG_IRQ_REQUEST_NUM
-#   define VSF_ARCH_CFG_IRQ_REQUEST_NUM     32
+#   define VSF_ARCH_CFG_IRQ_REQUEST_NUM     (2 * VSF_ARCH_CFG_THREAD_NUM)
+#endif
+
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+// max number of ready sources handled in one irq context
+#   ifndef VSF_ARCH_CFG_EPOLL_EVENT_NUM
+#       define VSF_ARCH_CFG_EPOLL_EVENT_NUM 16
+#   endif
 #endif
 
 #ifndef VSF_ARCH_CFG_TRACE_FUNC
@@ -66,6 +81,7 @@
 #define __vsf_arch_crit_init(__crit)        pthread_mutex_init(&(__crit), NULL)
 #define __vsf_arch_crit_enter(__crit)       pthread_mutex_lock(&(__crit))
 #define __vsf_arch_crit_leave(__crit)       pthread_mutex_unlock(&(__crit))
+#define __vsf_arch_thread_local             __thread
 
 /*============================ TYPES =========================================*/
 
@@ -82,11 +98,33 @@ static vsf_err_t __vsf_arch_create_irq_thread(vsf_arch_irq_thread_t *irq_thread,
 
 /*============================ TYPES =========================================*/
 
+#if VSF_ARCH_SWI_NUM > 0
+typedef struct vsf_arch_swi_ctx_t {
+    implement(vsf_arch_irq_thread_t);
+    vsf_arch_irq_request_t request;
+    bool inited;
+
+    vsf_swi_handler_t *handler;
+    void *param;
+} vsf_arch_swi_ctx_t;
+#endif
+
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+typedef struct vsf_arch_epoll_ctx_t {
+    implement(vsf_arch_irq_thread_t);
+    int epfd;
+} vsf_arch_epoll_ctx_t;
+
+typedef struct vsf_arch_systimer_ctx_t {
+    vsf_arch_epoll_source_t timerfd;
+} vsf_arch_systimer_ctx_t;
+#else
 typedef struct vsf_arch_systimer_ctx_t {
     implement(vsf_arch_irq_thread_t);
     vsf_arch_irq_request_t timer_request;
     struct timespec ts;
 } vsf_arch_systimer_ctx_t;
+#endif
 
 dcl_vsf_bitmap(vsf_arch_thread_bitmap, VSF_ARCH_CFG_THREAD_NUM)
 
@@ -99,10 +137,16 @@ typedef struct vsf_arch_thread_t {
 
 dcl_vsf_bitmap(vsf_arch_irq_request_bitmap, VSF_ARCH_CFG_IRQ_REQUEST_NUM)
 
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+typedef struct vsf_arch_irq_request_priv_t {
+    int evtfd;
+} vsf_arch_irq_request_priv_t;
+#else
 typedef struct vsf_arch_irq_request_priv_t {
     pthread_cond_t cond;
     pthread_mutex_t mutex;
 } vsf_arch_irq_request_priv_t;
+#endif
 
 typedef struct vsf_arch_t {
     struct {
@@ -114,6 +158,12 @@ typedef struct vsf_arch_t {
         vsf_bitmap(vsf_arch_irq_request_bitmap) bitmap;
     } irq_request;
 
+#if VSF_ARCH_SWI_NUM > 0
+    vsf_arch_swi_ctx_t swi[VSF_ARCH_SWI_NUM];
+#endif
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+    vsf_arch_epoll_ctx_t epoll;
+#endif
     vsf_arch_systimer_ctx_t systimer;
 } vsf_arch_t;
 
@@ -147,23 +197,32 @@ void __vsf_arch_irq_request_init(vsf_arch_irq_request_t *request)
             vsf_bitmap_set(&__vsf_arch.irq_request.bitmap, request->id);
         }
     __vsf_arch_crit_leave(__vsf_arch_common.lock);
-    VSF_ARCH_ASSERT(request->id >= 0);
+    VSF_ARCH_ASSERT((request->id >= 0) && (request->id < VSF_ARCH_CFG_IRQ_REQUEST_NUM));
 
+    request->is_triggered = false;
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+    __vsf_arch.irq_request.pool[request->id].evtfd = eventfd(0, EFD_CLOEXEC);
+    VSF_ARCH_ASSERT(__vsf_arch.irq_request.pool[request->id].evtfd >= 0);
+#else
     pthread_cond_t *cond = &__vsf_arch.irq_request.pool[request->id].cond;
     pthread_mutex_t *mutex = &__vsf_arch.irq_request.pool[request->id].mutex;
 
-    request->is_triggered = false;
     pthread_mutex_init(mutex, NULL);
     pthread_cond_init(cond, NULL);
+#endif
     request->is_inited = true;
 }
 
 void __vsf_arch_irq_request_fini(vsf_arch_irq_request_t *request)
 {
     VSF_HAL_ASSERT(request->is_inited);
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+    close(__vsf_arch.irq_request.pool[request->id].evtfd);
+#else
     pthread_cond_t *cond = &__vsf_arch.irq_request.pool[request->id].cond;
 
     pthread_cond_destroy(cond);
+#endif
 
     __vsf_arch_crit_enter(__vsf_arch_common.lock);
         vsf_bitmap_clear(&__vsf_arch.irq_request.bitmap, request->id);
@@ -172,6 +231,30 @@ void __vsf_arch_irq_request_fini(vsf_arch_irq_request_t *request)
     request->is_inited = false;
 }
 
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+// counter of eventfd is cleared by read, so multiple sends before pend are
+//  merged into one trigger, which is the same as the condition version
+void __vsf_arch_irq_request_pend(vsf_arch_irq_request_t *request)
+{
+    VSF_HAL_ASSERT(request->is_inited);
+    int evtfd = __vsf_arch.irq_request.pool[request->id].evtfd;
+    uint64_t cnt;
+
+    vsf_arch_request_trace("irq_request%d pend\n", __vsf_arch_get_thread_idx(request->arch_thread));
+    while (read(evtfd, &cnt, sizeof(cnt)) != sizeof(cnt));
+    vsf_arch_request_trace("irq_request%d got\n", __vsf_arch_get_thread_idx(request->arch_thread));
+}
+
+void __vsf_arch_irq_request_send(vsf_arch_irq_request_t *request)
+{
+    VSF_HAL_ASSERT(request->is_inited);
+    int evtfd = __vsf_arch.irq_request.pool[request->id].evtfd;
+    uint64_t cnt = 1;
+
+    vsf_arch_request_trace("irq_request%d send\n", __vsf_arch_get_thread_idx(request->arch_thread));
+    while (write(evtfd, &cnt, sizeof(cnt)) != sizeof(cnt));
+}
+#else
 void __vsf_arch_irq_request_pend(vsf_arch_irq_request_t *request)
 {
     VSF_HAL_ASSERT(request->is_inited);
@@ -205,26 +288,30 @@ void __vsf_arch_irq_request_send(vsf_arch_irq_request_t *request)
     pthread_cond_signal(cond);
     vsf_arch_request_trace("irq_request%d sent\n", idx);
 }
+#endif
 
 static void * __vsf_arch_irq_entry(void *arg)
 {
     vsf_arch_thread_t *thread = arg;
+    vsf_arch_irq_thread_t *irq_thread;
     int idx = __vsf_arch_get_thread_idx(thread);
 
+    pthread_detach(pthread_self());
     thread->start_request.arch_thread = thread;
-    __vsf_arch_irq_request_pend(&thread->start_request);
-
-    vsf_arch_irq_thread_t *irq_thread = thread->param;
-    vsf_arch_irq_trace("irq_thread_start %s\n", irq_thread->name);
-    if (irq_thread->entry != NULL) {
-        irq_thread->entry(irq_thread);
-    }
+    // threads in pool are reused after the irq_thread exits
+    while (1) {
+        __vsf_arch_irq_request_pend(&thread->start_request);
 
-    __vsf_arch_crit_enter(__vsf_arch_common.lock);
-        vsf_bitmap_clear(&__vsf_arch.thread.bitmap, idx);
-    __vsf_arch_crit_leave(__vsf_arch_common.lock);
+        irq_thread = thread->param;
+        vsf_arch_irq_trace("irq_thread_start %s\n", irq_thread->name);
+        if (irq_thread->entry != NULL) {
+            irq_thread->entry(irq_thread);
+        }
 
-    pthread_detach(pthread_self());
+        __vsf_arch_crit_enter(__vsf_arch_common.lock);
+            vsf_bitmap_clear(&__vsf_arch.thread.bitmap, idx);
+        __vsf_arch_crit_leave(__vsf_arch_common.lock);
+    }
     return NULL;
 }
 
@@ -257,12 +344,174 @@ void __vsf_arch_irq_sleep(uint32_t ms)
     usleep(ms * 1000);
 }
 
+/*----------------------------------------------------------------------------*
+ * Epoll Implementation                                                       *
+ *----------------------------------------------------------------------------*/
+
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+static void __vsf_arch_epoll_thread(void *arg)
+{
+    vsf_arch_epoll_ctx_t *ctx = arg;
+    struct epoll_event events[VSF_ARCH_CFG_EPOLL_EVENT_NUM];
+    vsf_arch_epoll_source_t *source;
+    int num;
+
+    __vsf_arch_irq_set_background(&ctx->use_as__vsf_arch_irq_thread_t);
+    while (1) {
+        num = epoll_wait(ctx->epfd, events, dimof(events), -1);
+        if (num <= 0) {
+            continue;
+        }
+
+        // all ready sources are serviced in one irq context
+        __vsf_arch_irq_start(&ctx->use_as__vsf_arch_irq_thread_t);
+            for (int i = 0; i < num; i++) {
+                source = events[i].data.ptr;
+                source->handler(source, events[i].events);
+            }
+        __vsf_arch_irq_end(&ctx->use_as__vsf_arch_irq_thread_t, false);
+    }
+}
+
+static vsf_err_t __vsf_arch_epoll_ctl(int op, vsf_arch_epoll_source_t *source)
+{
+    struct epoll_event event = {
+        .events     = source->events,
+        .data.ptr   = source,
+    };
+    VSF_HAL_ASSERT(source->handler != NULL);
+    return epoll_ctl(__vsf_arch.epoll.epfd, op, source->fd, &event) ? VSF_ERR_FAIL : VSF_ERR_NONE;
+}
+
+vsf_err_t __vsf_arch_epoll_add(vsf_arch_epoll_source_t *source)
+{
+    return __vsf_arch_epoll_ctl(EPOLL_CTL_ADD, source);
+}
+
+vsf_err_t __vsf_arch_epoll_mod(vsf_arch_epoll_source_t *source)
+{
+    return __vsf_arch_epoll_ctl(EPOLL_CTL_MOD, source);
+}
+
+void __vsf_arch_epoll_del(vsf_arch_epoll_source_t *source)
+{
+    epoll_ctl(__vsf_arch.epoll.epfd, EPOLL_CTL_DEL, source->fd, NULL);
+}
+#endif
+
+/*----------------------------------------------------------------------------*
+ * SWI Implementation                                                         *
+ *----------------------------------------------------------------------------*/
+
+#if VSF_ARCH_SWI_NUM > 0
+static void __vsf_arch_swi_thread(void *arg)
+{
+    vsf_arch_swi_ctx_t *ctx = arg;
+
+    __vsf_arch_irq_set_background(&ctx->use_as__vsf_arch_irq_thread_t);
+    while (1) {
+        __vsf_arch_irq_request_pend(&ctx->request);
+
+        __vsf_arch_irq_start(&ctx->use_as__vsf_arch_irq_thread_t);
+            if (ctx->handler != NULL) {
+                ctx->handler(ctx->param);
+            }
+        __vsf_arch_irq_end(&ctx->use_as__vsf_arch_irq_thread_t, false);
+    }
+}
+
+/*! \brief initialise a software interrupt
+ *! \param idx the index of the software interrupt, swi idx runs on core (idx + 1)
+ *! \return initialization result in vsf_err_t
+ */
+vsf_err_t vsf_arch_swi_init(uint_fast8_t idx, vsf_arch_prio_t priority,
+    vsf_swi_handler_t *handler, void *param)
+{
+    if (idx < dimof(__vsf_arch.swi)) {
+        vsf_arch_swi_ctx_t *ctx = &__vsf_arch.swi[idx];
+
+        ctx->handler = handler;
+        ctx->param = param;
+        if (!ctx->inited) {
+            char swi_name[8];
+
+            ctx->inited = true;
+            sprintf(swi_name, "swi%d", idx);
+            __vsf_arch_irq_request_init(&ctx->request);
+            __vsf_arch_irq_init_on_core(&ctx->use_as__vsf_arch_irq_thread_t,
+                        swi_name, __vsf_arch_swi_thread, idx + 1);
+        }
+        return VSF_ERR_NONE;
+    }
+    VSF_HAL_ASSERT(false);
+    return VSF_ERR_INVALID_PARAMETER;
+}
+
+/*! \brief trigger a software interrupt
+ *! \param idx the index of the software interrupt
+ */
+void vsf_arch_swi_trigger(uint_fast8_t idx)
+{
+    if (idx < dimof(__vsf_arch.swi)) {
+        __vsf_arch_irq_request_send(&__vsf_arch.swi[idx].request);
+        return;
+    }
+    VSF_HAL_ASSERT(false);
+}
+#endif
+
 /*----------------------------------------------------------------------------*
  * Systimer Timer Implementation                                              *
  *----------------------------------------------------------------------------*/
 
 #if VSF_SYSTIMER_CFG_IMPL_MODE == VSF_SYSTIMER_IMPL_REQUEST_RESPONSE
 
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+static void __vsf_systimer_on_timerfd(vsf_arch_epoll_source_t *source, uint32_t events)
+{
+    uint64_t expirations;
+
+    // timerfd is non-blocking, read to clear the expiration
+    if (read(source->fd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+        vsf_systimer_cnt_t tick = vsf_systimer_get();
+        vsf_systimer_timeout_evt_hanlder(tick);
+    }
+}
+
+/*! \brief initialise SysTick to generate a system timer
+ *! \param frequency the target tick frequency in Hz
+ *! \return initialization result in vsf_err_t
+ */
+vsf_err_t vsf_systimer_init(void)
+{
+    vsf_arch_epoll_source_t *source = &__vsf_arch.systimer.timerfd;
+
+    source->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (source->fd < 0) {
+        VSF_HAL_ASSERT(false);
+        return VSF_ERR_FAIL;
+    }
+    source->events = EPOLLIN;
+    source->handler = __vsf_systimer_on_timerfd;
+    return VSF_ERR_NONE;
+}
+
+vsf_err_t vsf_systimer_start(void)
+{
+    return __vsf_arch_epoll_add(&__vsf_arch.systimer.timerfd);
+}
+
+bool vsf_systimer_set(vsf_systimer_cnt_t due)
+{
+    // timerfd is armed directly, zero it_value will disarm the timer
+    struct itimerspec its = {
+        .it_value.tv_sec    = due / 1000000,
+        .it_value.tv_nsec   = (due % 1000000) * 1000 + 1,
+    };
+    timerfd_settime(__vsf_arch.systimer.timerfd.fd, TFD_TIMER_ABSTIME, &its, NULL);
+    return true;
+}
+#else
 static void __vsf_systimer_on_notify(union sigval s)
 {
     vsf_arch_systimer_ctx_t *ctx = &__vsf_arch.systimer;
@@ -318,6 +567,15 @@ vsf_err_t vsf_systimer_start(void)
     return VSF_ERR_NONE;
 }
 
+bool vsf_systimer_set(vsf_systimer_cnt_t due)
+{
+    __vsf_arch.systimer.ts.tv_sec = due / 1000000;
+    __vsf_arch.systimer.ts.tv_nsec = (due % 1000000) * 1000;
+    __vsf_arch_irq_request_send(&__vsf_arch.systimer.timer_request);
+    return true;
+}
+#endif
+
 void vsf_systimer_set_idle(void)
 {
 }
@@ -329,14 +587,6 @@ vsf_systimer_cnt_t vsf_systimer_get(void)
     return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
 }
 
-bool vsf_systimer_set(vsf_systimer_cnt_t due)
-{
-    __vsf_arch.systimer.ts.tv_sec = due / 1000000;
-    __vsf_arch.systimer.ts.tv_nsec = (due % 1000000) * 1000;
-    __vsf_arch_irq_request_send(&__vsf_arch.systimer.timer_request);
-    return true;
-}
-
 bool vsf_systimer_is_due(vsf_systimer_cnt_t due)
 {
     return (vsf_systimer_get() >= due);
@@ -383,6 +633,14 @@ bool vsf_arch_low_level_init(void)
     vsf_bitmap_clear(&__vsf_arch.irq_request.bitmap, VSF_ARCH_CFG_IRQ_REQUEST_NUM);
     vsf_bitmap_clear(&__vsf_arch.thread.bitmap, VSF_ARCH_CFG_THREAD_NUM);
 
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+    __vsf_arch.epoll.epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (__vsf_arch.epoll.epfd < 0) {
+        VSF_HAL_ASSERT(false);
+        return false;
+    }
+#endif
+
     // __vsf_arch_low_level_init MUST be called before using __vsf_arch_common.lock
     __vsf_arch_low_level_init();
 
@@ -393,6 +651,11 @@ bool vsf_arch_low_level_init(void)
             return false;
         }
     }
+
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+    __vsf_arch_irq_init(&__vsf_arch.epoll.use_as__vsf_arch_irq_thread_t,
+                "epoll", __vsf_arch_epoll_thread, vsf_arch_prio_0);
+#endif
     return true;
 }
 
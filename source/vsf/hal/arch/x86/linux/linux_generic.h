@@ -44,11 +44,22 @@ extern "C" {
 #   define __BYTE_ORDER                    __LITTLE_ENDIAN
 #endif
 
+/*! \note VSF_ARCH_CFG_CORE_NUM > 1 enables smp mode:
+ *!       core0 runs the por(idle) thread and emulated hardware irqs,
+ *!       core n(n > 0) is a host worker thread running swi(n - 1), which polls
+ *!       the evtq of vsf_prio_n when VSF_OS_CFG_ADD_EVTQ_TO_IDLE is enabled.
+ *!       So edas are pinned to cores by priority, and migrated by
+ *!       vsf_eda_set_priority.
+ */
+#ifndef VSF_ARCH_CFG_CORE_NUM
+#   define VSF_ARCH_CFG_CORE_NUM        1
+#endif
+
 #ifndef VSF_ARCH_PRI_NUM
-#   define VSF_ARCH_PRI_NUM             1
+#   define VSF_ARCH_PRI_NUM             VSF_ARCH_CFG_CORE_NUM
 #endif
-#if VSF_ARCH_PRI_NUM != 1
-#   error VSF_ARCH_PRI_NUM MUST be 1 for linux
+#if VSF_ARCH_PRI_NUM != VSF_ARCH_CFG_CORE_NUM
+#   error VSF_ARCH_PRI_NUM MUST be VSF_ARCH_CFG_CORE_NUM for linux
 #endif
 
 #ifndef VSF_SYSTIMER_CFG_IMPL_MODE
@@ -57,14 +68,27 @@ extern "C" {
 
 // software interrupt provided by arch
 #ifndef VSF_ARCH_SWI_NUM
-#   define VSF_ARCH_SWI_NUM             0
+#   define VSF_ARCH_SWI_NUM             (VSF_ARCH_CFG_CORE_NUM - 1)
+#endif
+#if VSF_ARCH_SWI_NUM != (VSF_ARCH_CFG_CORE_NUM - 1)
+#   error VSF_ARCH_SWI_NUM MUST be (VSF_ARCH_CFG_CORE_NUM - 1) for linux
 #endif
-#if VSF_ARCH_SWI_NUM != 0
-#   error VSF_ARCH_SWI_NUM MUST be 0 for linux
+
+/*! \note VSF_ARCH_CFG_EPOLL enables epoll based irq emulation:
+ *!       irq_request is implemented by eventfd, and fd based irq sources,
+ *!       including the systimer implemented by timerfd, are serviced by one
+ *!       epoll irq thread instead of one blocking thread per source.
+ */
+#ifndef VSF_ARCH_CFG_EPOLL
+#   define VSF_ARCH_CFG_EPOLL           DISABLED
 #endif
 
 #define VSF_ARCH_STACK_PAGE_SIZE        4096
 #define VSF_ARCH_STACK_GUARDIAN_SIZE    4096
+// x64 abi requires 16-byte aligned stack, libc uses aligned sse access on stack
+#ifndef VSF_ARCH_CFG_STACK_ALIGN_BIT
+#   define VSF_ARCH_CFG_STACK_ALIGN_BIT 4
+#endif
 
 /*============================ MACROFIED FUNCTIONS ===========================*/
 
@@ -72,7 +96,12 @@ extern "C" {
             VSF_ARCH_PRIO_##__N = (__N),                                        \
             vsf_arch_prio_##__N = (__N),
 
-#define vsf_arch_wakeup()
+#if VSF_ARCH_CFG_CORE_NUM > 1
+// evtq of core0 can be posted from other cores, wake up the por thread
+#   define vsf_arch_wakeup()            __vsf_arch_wakeup()
+#else
+#   define vsf_arch_wakeup()
+#endif
 
 /*============================ TYPES =========================================*/
 
@@ -102,6 +131,17 @@ def_simple_class(vsf_arch_irq_request_t) {
 
 typedef volatile bool vsf_gint_state_t;
 
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+typedef struct vsf_arch_epoll_source_t vsf_arch_epoll_source_t;
+typedef void (*vsf_arch_epoll_handler_t)(vsf_arch_epoll_source_t *source, uint32_t events);
+// handler is called in irq context of the epoll irq thread with ready events
+struct vsf_arch_epoll_source_t {
+    int fd;
+    uint32_t events;
+    vsf_arch_epoll_handler_t handler;
+};
+#endif
+
 /*============================ INCLUDES ======================================*/
 
 #include "hal/arch/common/arch_without_thread_suspend/vsf_arch_without_thread_suspend_template.h"
@@ -132,6 +172,13 @@ extern void __vsf_arch_irq_set_background(vsf_arch_irq_thread_t *irq_thread);
 extern void __vsf_arch_irq_start(vsf_arch_irq_thread_t *irq_thread);
 extern void __vsf_arch_irq_end(vsf_arch_irq_thread_t *irq_thread, bool is_terminate);
 
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+extern vsf_err_t __vsf_arch_epoll_add(vsf_arch_epoll_source_t *source);
+extern vsf_err_t __vsf_arch_epoll_mod(vsf_arch_epoll_source_t *source);
+// MUST NOT be called in handler of other sources
+extern void __vsf_arch_epoll_del(vsf_arch_epoll_source_t *source);
+#endif
+
 static ALWAYS_INLINE void vsf_arch_set_stack(uintptr_t stack)
 {
 #if     defined(__CPU_X86__)
@@ -27,6 +27,10 @@
 #endif
 #include "hal/arch/vsf_arch.h"
 #include <unistd.h>
+#if VSF_ARCH_CFG_EPOLL == ENABLED
+#   include <sys/epoll.h>
+#   include <sys/ioctl.h>
+#endif
 
 /*============================ MACROS ========================================*/
 
@@ -62,6 +66,9 @@ static const vsf_stream_op_t __vsf_x86_debug_stream_tx_op = {
 };
 static uint8_t __vsf_x86_debug_stream_rx_buff[VSF_DEBUG_STREAM_CFG_RX_BUF_SIZE];
 static vsf_arch_irq_thread_t __vsf_x86_debug_stream_rx_irq;
+#       if VSF_ARCH_CFG_EPOLL == ENABLED
+static vsf_arch_epoll_source_t __vsf_x86_debug_stream_rx_source;
+#       endif
 #   endif
 #endif
 
@@ -123,9 +130,38 @@ static void __vsf_x86_debug_stream_rx_irqhandler(void *arg)
     }
 }
 
+#       if VSF_ARCH_CFG_EPOLL == ENABLED
+static void __vsf_x86_debug_stream_on_rx(vsf_arch_epoll_source_t *source, uint32_t events)
+{
+    uint8_t buf[64];
+    ssize_t rsize;
+    int avail;
+
+    if ((ioctl(source->fd, FIONREAD, &avail) < 0) || (avail <= 0)) {
+        // EOF or error, stop polling
+        __vsf_arch_epoll_del(source);
+        return;
+    }
+
+    rsize = read(source->fd, buf, min(avail, sizeof(buf)));
+    if (rsize > 0) {
+        VSF_STREAM_WRITE(&VSF_DEBUG_STREAM_RX, buf, rsize);
+    }
+}
+#       endif
+
 static void __vsf_x86_debug_stream_init(void)
 {
     VSF_STREAM_CONNECT_TX(&VSF_DEBUG_STREAM_RX);
+#       if VSF_ARCH_CFG_EPOLL == ENABLED
+    __vsf_x86_debug_stream_rx_source.fd = STDIN_FILENO;
+    __vsf_x86_debug_stream_rx_source.events = EPOLLIN;
+    __vsf_x86_debug_stream_rx_source.handler = __vsf_x86_debug_stream_on_rx;
+    // regular files can not be polled, fall back to the blocking rx thread
+    if (VSF_ERR_NONE == __vsf_arch_epoll_add(&__vsf_x86_debug_stream_rx_source)) {
+        return;
+    }
+#       endif
     __vsf_arch_irq_init(&__vsf_x86_debug_stream_rx_irq, "debug_stream_rx",
         __vsf_x86_debug_stream_rx_irqhandler, vsf_arch_prio_0);
 }
@@ -62,9 +62,12 @@ static void __vsf_eda_queue_notify(vsf_eda_queue_t *this_ptr, bool tx, vsf_prote
         eda->state.bits.is_sync_got = true;
         vsf_unprotect_sched(orig);
 
-        vsf_eda_post_evt(eda, VSF_EVT_SYNC);
+        vsf_err_t err = vsf_eda_post_evt(eda, VSF_EVT_SYNC);
         // do not check result of vsf_eda_post_evt
-        //  because it may fail if time-outted and VSF_EVT_TIMER in queue
+        //  because it may fail if time-outted and VSF_EVT_TIMER in queue,
+        //  but evtq MUST not be full
+        VSF_KERNEL_ASSERT(err != VSF_ERR_NOT_ENOUGH_RESOURCES);
+        UNUSED_PARAM(err);
     } else {
 #if VSF_KERNEL_CFG_QUEUE_MULTI_TX_EN == ENABLED
         if (tx) {
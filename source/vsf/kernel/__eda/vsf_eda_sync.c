@@ -318,7 +318,9 @@ void vsf_eda_sync_cancel(vsf_sync_t *this_ptr)
         if (eda != NULL) {
             eda->state.bits.is_sync_got = true;
             vsf_unprotect_sched(origlevel);
-            __vsf_eda_post_evt_ex(eda, VSF_EVT_SYNC_CANCEL, true);
+            vsf_err_t err = __vsf_eda_post_evt_ex(eda, VSF_EVT_SYNC_CANCEL, true);
+            VSF_KERNEL_ASSERT(!err);
+            UNUSED_PARAM(err);
         } else {
             vsf_unprotect_sched(origlevel);
         }
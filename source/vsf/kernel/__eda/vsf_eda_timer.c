@@ -177,7 +177,7 @@ static void __vsf_timer_init(void)
     vsf_timq_init(&__vsf_eda.timer.timq);
 #if VSF_KERNEL_CFG_CALLBACK_TIMER == ENABLED
     vsf_callback_timq_init(&__vsf_eda.timer.callback_timq);
-    vsf_callback_timq_init(&__vsf_eda.timer.callback_timq_done);
+    vsf_dlist_init(&__vsf_eda.timer.callback_timq_done);
 #endif
 }
 
@@ -187,6 +187,7 @@ static void __vsf_teda_timer_enqueue(vsf_teda_t *this_ptr, vsf_timer_tick_t due)
     VSF_KERNEL_ASSERT((this_ptr != NULL) && !this_ptr->use_as__vsf_eda_t.state.bits.is_timed);
     this_ptr->due = due;
 
+    vsf_timq_advance(&__vsf_eda.timer.timq, vsf_systimer_get_tick());
     vsf_timq_insert(&__vsf_eda.timer.timq, this_ptr);
     this_ptr->use_as__vsf_eda_t.state.bits.is_timed = true;
 #if     VSF_KERNEL_CFG_EDA_SUPPORT_SUB_CALL == ENABLED                      \
@@ -206,6 +207,7 @@ void vsf_callback_timer_init(vsf_callback_timer_t *timer)
 SECTION(".text.vsf.kernel.vsf_callback_timer_add")
 vsf_err_t vsf_callback_timer_add(vsf_callback_timer_t *timer, uint_fast32_t tick)
 {
+    vsf_callback_timer_t *first;
     vsf_protect_t lock_status;
     VSF_KERNEL_ASSERT(timer != NULL);
 
@@ -216,12 +218,12 @@ vsf_err_t vsf_callback_timer_add(vsf_callback_timer_t *timer, uint_fast32_t tick
         }
 
         timer->due = tick + vsf_systimer_get_tick();
+        vsf_callback_timq_advance(&__vsf_eda.timer.callback_timq, timer->due - tick);
         vsf_callback_timq_insert(&__vsf_eda.timer.callback_timq, timer);
 
-        if (NULL == timer->timer_node.prev) {
+        vsf_callback_timq_peek(&__vsf_eda.timer.callback_timq, first);
+        if (first == timer) {
             __vsf_teda_cancel_timer(&__vsf_eda.teda);
-
-            vsf_callback_timq_peek(&__vsf_eda.timer.callback_timq, timer);
             __vsf_teda_set_timer_imp(&__vsf_eda.teda, timer->due);
         }
     vsf_unprotect_sched(lock_status);
@@ -252,8 +254,9 @@ vsf_err_t vsf_callback_timer_remove(vsf_callback_timer_t *timer)
 
     lock_status = vsf_protect_sched();
         if (timer->due != 0) {
-            timer->due = 0;
+            // due is used to locate the timer in timing wheel, clear it after removed
             vsf_callback_timq_remove(&__vsf_eda.timer.callback_timq, timer);
+            timer->due = 0;
         }
     vsf_unprotect_sched(lock_status);
     return VSF_ERR_NONE;
@@ -36,7 +36,11 @@
 typedef struct vsf_local_t {
 #if __VSF_KERNEL_CFG_EVTQ_EN == ENABLED
     struct {
+#   if __VSF_KERNEL_CFG_SMP == ENABLED
+        vsf_evtq_t          *cur[VSF_ARCH_CFG_CORE_NUM];
+#   else
         vsf_evtq_t          *cur;
+#   endif
     } evtq;
 #else
     vsf_evtq_ctx_t          cur;
@@ -59,7 +63,7 @@ typedef struct vsf_local_t {
     struct {
 #   if VSF_KERNEL_CFG_CALLBACK_TIMER == ENABLED
         vsf_timer_queue_t   callback_timq;
-        vsf_timer_queue_t   callback_timq_done;
+        vsf_dlist_t         callback_timq_done;
 #   endif
 
         vsf_timer_queue_t   timq;
@@ -110,6 +114,10 @@ SECTION(".text.vsf.kernel.vsf_eda_new_frame")
 extern __vsf_eda_frame_t * vsf_eda_new_frame(size_t local_size);
 SECTION(".text.vsf.kernel.vsf_eda_free_frame")
 extern void vsf_eda_free_frame(__vsf_eda_frame_t *frame);
+#if VSF_KERNEL_CFG_EDA_FRAME_CACHE == ENABLED
+SECTION(".text.vsf.kernel.vsf_eda_renew_frame")
+extern __vsf_eda_frame_t * vsf_eda_renew_frame(__vsf_eda_frame_t *frame, size_t local_size);
+#endif
 
 extern void vsf_kernel_err_report(enum vsf_kernel_error_t err);
 
@@ -247,14 +255,22 @@ void __vsf_dispatch_evt(vsf_eda_t *this_ptr, vsf_evt_t evt)
 SECTION(".text.vsf.kernel.__vsf_get_cur_evtq")
 vsf_evtq_t * __vsf_get_cur_evtq(void)
 {
+#   if __VSF_KERNEL_CFG_SMP == ENABLED
+    return __vsf_eda.evtq.cur[vsf_arch_get_core_id()];
+#   else
     return __vsf_eda.evtq.cur;
+#   endif
 }
 
 SECTION(".text.vsf.kernel.__vsf_set_cur_evtq")
 vsf_evtq_t * __vsf_set_cur_evtq(vsf_evtq_t *evtq)
 {
     vsf_evtq_t *evtq_old = __vsf_get_cur_evtq();
+#   if __VSF_KERNEL_CFG_SMP == ENABLED
+    __vsf_eda.evtq.cur[vsf_arch_get_core_id()] = evtq;
+#   else
     __vsf_eda.evtq.cur = evtq;
+#   endif
     return evtq_old;
 }
 
@@ -444,7 +460,12 @@ bool __vsf_eda_return(uintptr_t return_value)
     if (this_ptr->state.bits.is_use_frame) {
         frame = __vsf_eda_pop(&this_ptr->fn.frame_list);
         VSF_KERNEL_ASSERT(frame != NULL);
+#   if VSF_KERNEL_CFG_EDA_FRAME_CACHE == ENABLED
+        vsf_eda_free_frame(this_ptr->frame_cache);
+        this_ptr->frame_cache = frame;
+#   else
         vsf_eda_free_frame(frame);
+#   endif
         frame = this_ptr->fn.frame;
 
     #if VSF_KERNEL_USE_SIMPLE_SHELL == ENABLED
@@ -471,7 +492,10 @@ bool __vsf_eda_return(uintptr_t return_value)
             }
         }
 
-        vsf_eda_post_evt(this_ptr, VSF_EVT_RETURN);
+        // caller will never be resumed if VSF_EVT_RETURN is lost
+        vsf_err_t err = vsf_eda_post_evt(this_ptr, VSF_EVT_RETURN);
+        VSF_KERNEL_ASSERT(err != VSF_ERR_NOT_ENOUGH_RESOURCES);
+        UNUSED_PARAM(err);
         return false;
     }
 #endif      // VSF_KERNEL_CFG_EDA_SUPPORT_SUB_CALL
@@ -483,7 +507,9 @@ SECTION(".text.vsf.kernel.vsf_eda_yield")
 void vsf_eda_yield(void)
 {
     vsf_eda_t *this_ptr = vsf_eda_get_cur();
-    vsf_eda_post_evt(this_ptr, VSF_EVT_YIELD);
+    vsf_err_t err = vsf_eda_post_evt(this_ptr, VSF_EVT_YIELD);
+    VSF_KERNEL_ASSERT(err != VSF_ERR_NOT_ENOUGH_RESOURCES);
+    UNUSED_PARAM(err);
 }
 
 #if VSF_KERNEL_CFG_EDA_SUPPORT_SUB_CALL == ENABLED
@@ -614,7 +640,12 @@ vsf_err_t __vsf_eda_call_eda_ex(uintptr_t func,
 
     __vsf_eda_frame_t *frame = NULL;
     if (is_sub_call) {
+#   if VSF_KERNEL_CFG_EDA_FRAME_CACHE == ENABLED
+        frame = vsf_eda_renew_frame(this_ptr->frame_cache, state.local_size);
+        this_ptr->frame_cache = NULL;
+#   else
         frame = vsf_eda_new_frame(state.local_size);
+#   endif
         if (NULL == frame) {
             VSF_KERNEL_ASSERT(false);
             return VSF_ERR_NOT_ENOUGH_RESOURCES;
@@ -831,6 +862,10 @@ static void __vsf_eda_init( vsf_eda_t *this_ptr,
 #if VSF_KERNEL_CFG_EDA_SUPPORT_FSM == ENABLED
     this_ptr->fsm_return_state = fsm_rt_on_going;
 #endif
+#if     VSF_KERNEL_CFG_EDA_SUPPORT_SUB_CALL == ENABLED                          \
+    &&  VSF_KERNEL_CFG_EDA_FRAME_CACHE == ENABLED
+    this_ptr->frame_cache = NULL;
+#endif
 }
 
 SECTION(".text.vsf.kernel.eda")
@@ -923,6 +958,12 @@ vsf_err_t vsf_eda_fini(vsf_eda_t *this_ptr)
     __vsf_teda_cancel_timer((vsf_teda_t *)this_ptr);
 #endif
 
+#if     VSF_KERNEL_CFG_EDA_SUPPORT_SUB_CALL == ENABLED                          \
+    &&  VSF_KERNEL_CFG_EDA_FRAME_CACHE == ENABLED
+    vsf_eda_free_frame(this_ptr->frame_cache);
+    this_ptr->frame_cache = NULL;
+#endif
+
     vsf_evtq_on_eda_fini(this_ptr);
     return VSF_ERR_NONE;
 }
@@ -989,6 +1030,7 @@ static void __vsf_kernel_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
 #if VSF_KERNEL_CFG_EDA_SUPPORT_TIMER == ENABLED
     vsf_teda_t *teda;
     vsf_protect_t origlevel;
+    vsf_err_t err;
 #endif
 
     VSF_KERNEL_ASSERT(eda != NULL);
@@ -1003,13 +1045,13 @@ static void __vsf_kernel_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
             vsf_callback_timer_t *timer;
             vsf_dlist_t *done_queue = &__vsf_eda.timer.callback_timq_done;
 
-            vsf_callback_timq_dequeue(done_queue, timer);
+            vsf_dlist_queue_dequeue(vsf_callback_timer_t, timer_node, done_queue, timer);
             while (timer != NULL) {
                 timer->due = 0;
                 if (timer->on_timer != NULL) {
                     timer->on_timer(timer);
                 }
-                vsf_callback_timq_dequeue(done_queue, timer);
+                vsf_dlist_queue_dequeue(vsf_callback_timer_t, timer_node, done_queue, timer);
             }
         }
         break;
@@ -1018,6 +1060,7 @@ static void __vsf_kernel_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
         // TODO: kernel_evthandler is running at vsf_prio_highest
         //   need to call vsf_protect_sched?
         origlevel = vsf_protect_sched();
+        vsf_timq_advance(&__vsf_eda.timer.timq, vsf_systimer_get_tick());
         vsf_timq_peek(&__vsf_eda.timer.timq, teda);
         while ((teda != NULL) && __vsf_timer_is_due(teda->due)) {
             vsf_timq_dequeue(&__vsf_eda.timer.timq, teda);
@@ -1031,12 +1074,13 @@ static void __vsf_kernel_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
                 vsf_dlist_t *done_queue = &__vsf_eda.timer.callback_timq_done;
 
                 origlevel = vsf_protect_sched();
+                vsf_callback_timq_advance(&__vsf_eda.timer.callback_timq, vsf_systimer_get_tick());
                 vsf_callback_timq_peek(&__vsf_eda.timer.callback_timq, timer);
                 while ((timer != NULL) && __vsf_timer_is_due(timer->due)) {
                     vsf_callback_timq_dequeue(&__vsf_eda.timer.callback_timq, timer);
                     vsf_unprotect_sched(origlevel);
 
-                    vsf_callback_timq_enqueue(done_queue, timer);
+                    vsf_dlist_queue_enqueue(vsf_callback_timer_t, timer_node, done_queue, timer);
 
                     origlevel = vsf_protect_sched();
                     vsf_callback_timq_peek(&__vsf_eda.timer.callback_timq, timer);
@@ -1046,12 +1090,15 @@ static void __vsf_kernel_evthandler(vsf_eda_t *eda, vsf_evt_t evt)
                     __vsf_teda_timer_enqueue((vsf_teda_t *)eda, timer->due);
                 }
                 vsf_unprotect_sched(origlevel);
-                vsf_eda_post_evt(&teda->use_as__vsf_eda_t, VSF_EVT_USER);
+                err = vsf_eda_post_evt(&teda->use_as__vsf_eda_t, VSF_EVT_USER);
             } else
 #   endif
             {
-                vsf_eda_post_evt(&teda->use_as__vsf_eda_t, VSF_EVT_TIMER);
+                err = vsf_eda_post_evt(&teda->use_as__vsf_eda_t, VSF_EVT_TIMER);
             }
+            // timer is already dequeued, the teda will wait forever if the evt is lost
+            VSF_KERNEL_ASSERT(err != VSF_ERR_NOT_ENOUGH_RESOURCES);
+            UNUSED_PARAM(err);
 
             origlevel = vsf_protect_sched();
             vsf_timq_peek(&__vsf_eda.timer.timq, teda);
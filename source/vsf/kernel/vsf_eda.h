@@ -724,6 +724,12 @@ def_simple_class(vsf_eda_t) {
         } fn;
         uintptr_t                   return_value;
     )
+#   if VSF_KERNEL_CFG_EDA_FRAME_CACHE == ENABLED
+    protected_member(
+        // last frame returned by sub call, reused by next sub call
+        __vsf_eda_frame_t           *frame_cache;
+    )
+#   endif
 #else
     protected_member(
         union {
@@ -66,6 +66,10 @@ struct vsf_evt_node_t {
 #else
 
 struct vsf_evt_node_t {
+#if defined(__VSF_OS_CFG_EVTQ_MPSC)
+    // sequence of the ring slot, position when free, position + 1 when published
+    uint32_t seq;
+#endif
     vsf_eda_t *eda;
 
 #if VSF_KERNEL_CFG_SUPPORT_EVT_MESSAGE == ENABLED
@@ -84,8 +88,20 @@ struct vsf_evtq_t {
     uint8_t bitsize;
 
     // private
+#if defined(__VSF_OS_CFG_EVTQ_MPSC)
+    uint32_t head;                  // consumer only
+    uint32_t tail;                  // producers, updated by CAS, bit 31 is set while overflow is used
+    struct {
+        vsf_evt_node_t node[VSF_OS_CFG_EVTQ_OVERFLOW_SIZE];
+        uint8_t head;
+        uint8_t tail;
+        // number of nodes in overflow, accessed atomically out of protection
+        uint8_t cnt;
+    } overflow;
+#else
     uint8_t head;
     uint8_t tail;
+#endif
     vsf_evtq_ctx_t cur;
 };
 
@@ -29,7 +29,7 @@
 
 #include "./vsf_os.h"
 
-#ifdef __VSF_OS_CFG_EVTQ_ARRAY
+#if defined(__VSF_OS_CFG_EVTQ_ARRAY) && !defined(__VSF_OS_CFG_EVTQ_MPSC)
 
 /*============================ MACROS ========================================*/
 /*============================ MACROFIED FUNCTIONS ===========================*/
@@ -113,8 +113,8 @@ static vsf_err_t __vsf_evtq_post(vsf_eda_t *eda, uintptr_t value, bool force)
     tail = evtq->tail;
     tail_next = (tail + 1) & mask;
     if (tail_next == evtq->head) {
+        // evtq full, let the poster handle it
         vsf_unprotect_int(orig);
-        VSF_KERNEL_ASSERT(false);
         return VSF_ERR_NOT_ENOUGH_RESOURCES;
     }
     evtq->tail = tail_next;
@@ -0,0 +1,400 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+/*============================ INCLUDES ======================================*/
+
+#include "kernel/vsf_kernel_cfg.h"
+
+#if VSF_USE_KERNEL == ENABLED
+
+#include "./vsf_kernel_common.h"
+
+#define __VSF_EDA_CLASS_IMPLEMENT
+#include "./vsf_eda.h"
+#include "./vsf_evtq.h"
+
+#include "./vsf_os.h"
+
+#ifdef __VSF_OS_CFG_EVTQ_MPSC
+
+/*============================ MACROS ========================================*/
+
+#if !__IS_COMPILER_SUPPORT_GNUC_EXTENSION__
+#   error "VSF_OS_CFG_EVTQ_LOCK_FREE depends on gnu __atomic builtins"
+#endif
+
+// set in tail while overflow is not empty, so once an evt goes to overflow,
+//  no slot can be taken in the ring until overflow is drained by the consumer,
+//  positions in tail and seq of nodes are 31-bit
+#define __VSF_EVTQ_OVERFLOW                 0x80000000UL
+#define __VSF_EVTQ_POS_MASK                 0x7FFFFFFFUL
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+
+#define __vsf_evtq_load(__ptr)              __atomic_load_n((__ptr), __ATOMIC_ACQUIRE)
+#define __vsf_evtq_store(__ptr, __value)    __atomic_store_n((__ptr), (__value), __ATOMIC_RELEASE)
+#define __vsf_evtq_cas(__ptr, __exp_ptr, __value)                               \
+            __atomic_compare_exchange_n((__ptr), (__exp_ptr), (__value), true,  \
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define __vsf_evtq_inc(__ptr)               __atomic_add_fetch((__ptr), 1, __ATOMIC_ACQ_REL)
+#define __vsf_evtq_dec(__ptr)               __atomic_sub_fetch((__ptr), 1, __ATOMIC_ACQ_REL)
+
+#define __vsf_evtq_pos(__pos)               ((__pos) & __VSF_EVTQ_POS_MASK)
+// signed distance of 31-bit positions
+#define __vsf_evtq_diff(__a, __b)           ((int_fast32_t)((int32_t)(((__a) - (__b)) << 1) >> 1))
+
+/*============================ TYPES =========================================*/
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ LOCAL VARIABLES ===============================*/
+/*============================ PROTOTYPES ====================================*/
+
+SECTION(".text.vsf.kernel.eda")
+extern void vsf_eda_on_terminate(vsf_eda_t *this_ptr);
+
+SECTION(".text.vsf.kernel.eda")
+extern void __vsf_dispatch_evt(vsf_eda_t *this_ptr, vsf_evt_t evt);
+
+extern vsf_evtq_t *__vsf_os_evtq_get(vsf_prio_t priority);
+extern vsf_err_t __vsf_os_evtq_activate(vsf_evtq_t *this_ptr);
+extern vsf_err_t __vsf_os_evtq_init(vsf_evtq_t *this_ptr);
+
+/*============================ IMPLEMENTATION ================================*/
+
+void vsf_evtq_on_eda_init(vsf_eda_t *this_ptr)
+{
+    this_ptr->evt_cnt = 0;
+}
+
+static bool __vsf_eda_terminate(vsf_eda_t *this_ptr)
+{
+    bool terminate;
+
+    VSF_KERNEL_ASSERT(this_ptr != NULL);
+
+    terminate = !__vsf_evtq_load(&this_ptr->evt_cnt);
+    if (terminate) {
+        vsf_eda_on_terminate(this_ptr);
+    }
+    return terminate;
+}
+
+void vsf_evtq_on_eda_fini(vsf_eda_t *this_ptr)
+{
+    if (!__vsf_eda_terminate((vsf_eda_t *)this_ptr)) {
+        this_ptr->state.bits.is_to_exit = true;
+    }
+}
+
+vsf_err_t vsf_evtq_init(vsf_evtq_t *this_ptr)
+{
+    uint_fast32_t size;
+
+    VSF_KERNEL_ASSERT(this_ptr != NULL);
+    size = 1UL << this_ptr->bitsize;
+
+    this_ptr->cur.eda = NULL;
+    this_ptr->cur.evt = VSF_EVT_INVALID;
+    this_ptr->cur.msg = (uintptr_t)NULL;
+    this_ptr->head = 0;
+    this_ptr->tail = 0;
+    for (uint_fast32_t i = 0; i < size; i++) {
+        this_ptr->node[i].seq = i;
+    }
+    this_ptr->overflow.head = 0;
+    this_ptr->overflow.tail = 0;
+    this_ptr->overflow.cnt = 0;
+    return __vsf_os_evtq_init(this_ptr);
+}
+
+#if VSF_KERNEL_CFG_SUPPORT_EVT_MESSAGE == ENABLED
+static void __vsf_evtq_fill_node(vsf_evt_node_t *node, vsf_eda_t *eda, vsf_evt_t evt, void *msg)
+{
+    node->eda = eda;
+    node->evt = evt;
+    node->msg = msg;
+}
+#else
+static void __vsf_evtq_fill_node(vsf_evt_node_t *node, vsf_eda_t *eda, uintptr_t value)
+{
+    node->eda = eda;
+    node->evt_union.value = value;
+}
+#endif
+
+// slow path: ring is full or heavily contended, post under interrupt protection
+//  if overflow is also full, the evt is dropped and the poster gets the error
+//  overflow flag in tail is set before the node is added, so producers which
+//  read tail before will fail in CAS and follow to overflow
+#if VSF_KERNEL_CFG_SUPPORT_EVT_MESSAGE == ENABLED
+static vsf_err_t __vsf_evtq_post_overflow(vsf_evtq_t *evtq, vsf_eda_t *eda, vsf_evt_t evt, void *msg)
+#else
+static vsf_err_t __vsf_evtq_post_overflow(vsf_evtq_t *evtq, vsf_eda_t *eda, uintptr_t value)
+#endif
+{
+    vsf_protect_t orig = vsf_protect_int();
+        __atomic_fetch_or(&evtq->tail, __VSF_EVTQ_OVERFLOW, __ATOMIC_ACQ_REL);
+        if (evtq->overflow.cnt >= dimof(evtq->overflow.node)) {
+            vsf_unprotect_int(orig);
+            __vsf_evtq_dec(&eda->evt_cnt);
+            return VSF_ERR_NOT_ENOUGH_RESOURCES;
+        }
+#if VSF_KERNEL_CFG_SUPPORT_EVT_MESSAGE == ENABLED
+        __vsf_evtq_fill_node(&evtq->overflow.node[evtq->overflow.tail], eda, evt, msg);
+#else
+        __vsf_evtq_fill_node(&evtq->overflow.node[evtq->overflow.tail], eda, value);
+#endif
+        if (++evtq->overflow.tail >= dimof(evtq->overflow.node)) {
+            evtq->overflow.tail = 0;
+        }
+        __vsf_evtq_inc(&evtq->overflow.cnt);
+    vsf_unprotect_int(orig);
+
+    return __vsf_os_evtq_activate(evtq);
+}
+
+#if VSF_KERNEL_CFG_SUPPORT_EVT_MESSAGE == ENABLED
+static vsf_err_t __vsf_evtq_post(vsf_eda_t *eda, vsf_evt_t evt, void *msg, bool force)
+#else
+static vsf_err_t __vsf_evtq_post(vsf_eda_t *eda, uintptr_t value, bool force)
+#endif
+{
+    vsf_evtq_t *evtq;
+    vsf_evt_node_t *node;
+    uint32_t pos, seq, mask;
+    int_fast32_t diff;
+
+    VSF_KERNEL_ASSERT(eda != NULL);
+    evtq = __vsf_os_evtq_get((vsf_prio_t)eda->priority);
+    mask = (1UL << evtq->bitsize) - 1;
+
+    // evt_cnt is increased before the node is visible to the consumer
+#if VSF_KERNEL_CFG_SUPPORT_SYNC == ENABLED
+    if (eda->state.bits.is_limitted && !force) {
+        uint8_t evt_cnt = 0;
+        if (!__vsf_evtq_cas(&eda->evt_cnt, &evt_cnt, 1)) {
+            return VSF_ERR_FAIL;
+        }
+    } else
+#endif
+    {
+        __vsf_evtq_inc(&eda->evt_cnt);
+    }
+
+    // keep evts in order, use overflow until it's drained by the consumer,
+    //  overflow flag is in tail, so the check and the slot claim is one CAS
+    pos = __atomic_load_n(&evtq->tail, __ATOMIC_RELAXED);
+    for (uint_fast8_t retry = 0; retry < VSF_OS_CFG_EVTQ_MPSC_RETRY; retry++) {
+        if (pos & __VSF_EVTQ_OVERFLOW) {
+            break;
+        }
+        node = &evtq->node[pos & mask];
+        seq = __vsf_evtq_load(&node->seq);
+        diff = __vsf_evtq_diff(seq, pos);
+
+        if (0 == diff) {
+            // on failure, pos is updated to current tail by cas
+            if (__vsf_evtq_cas(&evtq->tail, &pos, __vsf_evtq_pos(pos + 1))) {
+#if VSF_KERNEL_CFG_SUPPORT_EVT_MESSAGE == ENABLED
+                __vsf_evtq_fill_node(node, eda, evt, msg);
+#else
+                __vsf_evtq_fill_node(node, eda, value);
+#endif
+                __vsf_evtq_store(&node->seq, __vsf_evtq_pos(pos + 1));
+                return __vsf_os_evtq_activate(evtq);
+            }
+        } else if (diff < 0) {
+            // ring full
+            break;
+        } else {
+            pos = __atomic_load_n(&evtq->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+#if VSF_KERNEL_CFG_SUPPORT_EVT_MESSAGE == ENABLED
+    return __vsf_evtq_post_overflow(evtq, eda, evt, msg);
+#else
+    return __vsf_evtq_post_overflow(evtq, eda, value);
+#endif
+}
+
+vsf_err_t vsf_evtq_post_evt_ex(vsf_eda_t *this_ptr, vsf_evt_t evt, bool force)
+{
+#if VSF_KERNEL_CFG_SUPPORT_EVT_MESSAGE == ENABLED
+    return __vsf_evtq_post(this_ptr, evt, NULL, force);
+#else
+    return __vsf_evtq_post(this_ptr, (uintptr_t)((evt << 1) | 1), force);
+#endif
+}
+
+vsf_err_t vsf_evtq_post_evt(vsf_eda_t *this_ptr, vsf_evt_t evt)
+{
+    return vsf_evtq_post_evt_ex(this_ptr, evt, false);
+}
+
+vsf_err_t vsf_evtq_post_msg(vsf_eda_t *this_ptr, void *msg)
+{
+#if VSF_KERNEL_CFG_SUPPORT_EVT_MESSAGE == ENABLED
+    return __vsf_evtq_post(this_ptr, VSF_EVT_MESSAGE, msg, false);
+#else
+    return __vsf_evtq_post(this_ptr, (uintptr_t)msg, false);
+#endif
+}
+
+#if VSF_KERNEL_CFG_SUPPORT_EVT_MESSAGE == ENABLED
+vsf_err_t vsf_evtq_post_evt_msg(vsf_eda_t *this_ptr, vsf_evt_t evt, void *msg)
+{
+    return __vsf_evtq_post(this_ptr, evt, msg, false);
+}
+#endif
+
+bool vsf_evtq_is_empty(vsf_evtq_t *this_ptr)
+{
+    uint32_t mask = (1UL << this_ptr->bitsize) - 1;
+    uint32_t head = this_ptr->head;
+
+    return  (__vsf_evtq_load(&this_ptr->node[head & mask].seq) != __vsf_evtq_pos(head + 1))
+        &&  (0 == __vsf_evtq_load(&this_ptr->overflow.cnt));
+}
+
+static vsf_evt_t __vsf_evtq_node_get_evt(vsf_evt_node_t *node)
+{
+#if VSF_KERNEL_CFG_SUPPORT_EVT_MESSAGE == ENABLED
+    return node->evt;
+#else
+    uintptr_t value = node->evt_union.value;
+    return (value & 1) ? (vsf_evt_t)(value >> 1) : VSF_EVT_MESSAGE;
+#endif
+}
+
+// called by the consumer only, so published nodes can be modified safely
+void vsf_evtq_clean_evt(vsf_evt_t evt)
+{
+    vsf_eda_t *eda = vsf_eda_get_cur();
+    VSF_KERNEL_ASSERT(eda != NULL);
+    vsf_evtq_t *evtq = __vsf_os_evtq_get((vsf_prio_t)eda->priority);
+    uint32_t mask = (1UL << evtq->bitsize) - 1;
+    uint32_t pos = evtq->head, tail = __vsf_evtq_pos(__vsf_evtq_load(&evtq->tail));
+    vsf_evt_node_t *node;
+    vsf_protect_t orig;
+
+    for (; pos != tail; pos = __vsf_evtq_pos(pos + 1)) {
+        node = &evtq->node[pos & mask];
+        if (__vsf_evtq_load(&node->seq) != __vsf_evtq_pos(pos + 1)) {
+            // reserved by a producer, but not yet published
+            continue;
+        }
+        if ((node->eda == eda) && (__vsf_evtq_node_get_evt(node) == evt)) {
+            node->eda = NULL;
+            __vsf_evtq_dec(&eda->evt_cnt);
+        }
+    }
+
+    orig = vsf_protect_int();
+        uint_fast8_t idx = evtq->overflow.head;
+        for (uint_fast8_t i = 0; i < evtq->overflow.cnt; i++) {
+            node = &evtq->overflow.node[idx];
+            if ((node->eda == eda) && (__vsf_evtq_node_get_evt(node) == evt)) {
+                node->eda = NULL;
+                __vsf_evtq_dec(&eda->evt_cnt);
+            }
+            if (++idx >= dimof(evtq->overflow.node)) {
+                idx = 0;
+            }
+        }
+    vsf_unprotect_int(orig);
+}
+
+static bool __vsf_evtq_dequeue(vsf_evtq_t *this_ptr, vsf_evt_node_t *node_out)
+{
+    uint32_t mask = (1UL << this_ptr->bitsize) - 1;
+    uint32_t pos = this_ptr->head;
+    vsf_evt_node_t *node = &this_ptr->node[pos & mask];
+
+    if (__vsf_evtq_load(&node->seq) == __vsf_evtq_pos(pos + 1)) {
+        *node_out = *node;
+        this_ptr->head = __vsf_evtq_pos(pos + 1);
+        // release the slot for the producer of the next round
+        __vsf_evtq_store(&node->seq, __vsf_evtq_pos(pos + mask + 1));
+        return true;
+    }
+
+    if (__vsf_evtq_load(&this_ptr->overflow.cnt) > 0) {
+        bool result = false;
+        vsf_protect_t orig = vsf_protect_int();
+            // slots taken before overflow is used are earlier, wait until they are published
+            if (pos == __vsf_evtq_pos(__vsf_evtq_load(&this_ptr->tail))) {
+                *node_out = this_ptr->overflow.node[this_ptr->overflow.head];
+                if (++this_ptr->overflow.head >= dimof(this_ptr->overflow.node)) {
+                    this_ptr->overflow.head = 0;
+                }
+                if (0 == __vsf_evtq_dec(&this_ptr->overflow.cnt)) {
+                    __atomic_fetch_and(&this_ptr->tail, __VSF_EVTQ_POS_MASK, __ATOMIC_ACQ_REL);
+                }
+                result = true;
+            }
+        vsf_unprotect_int(orig);
+        return result;
+    }
+    return false;
+}
+
+vsf_err_t vsf_evtq_poll(vsf_evtq_t *this_ptr)
+{
+    vsf_evt_node_t node;
+    vsf_eda_t *eda;
+
+    VSF_KERNEL_ASSERT(this_ptr != NULL);
+
+    while (__vsf_evtq_dequeue(this_ptr, &node)) {
+        eda = node.eda;
+
+        if (eda != NULL) {
+            // cur is only accessed by the consumer, no protection necessary
+            if (!eda->state.bits.is_to_exit) {
+                this_ptr->cur.eda = eda;
+#if VSF_KERNEL_CFG_SUPPORT_EVT_MESSAGE == ENABLED
+                this_ptr->cur.evt = node.evt;
+                this_ptr->cur.msg = (uintptr_t)node.msg;
+#else
+                {
+                    uintptr_t value = node.evt_union.value;
+                    if (value & 1) {
+                        this_ptr->cur.evt = (vsf_evt_t)(value >> 1);
+                        this_ptr->cur.msg = (uintptr_t)NULL;
+                    } else {
+                        this_ptr->cur.evt = VSF_EVT_MESSAGE;
+                        this_ptr->cur.msg = value;
+                    }
+                }
+#endif
+                __vsf_dispatch_evt(eda, this_ptr->cur.evt);
+            }
+
+            this_ptr->cur.eda = NULL;
+            this_ptr->cur.evt = VSF_EVT_INVALID;
+            this_ptr->cur.msg = (uintptr_t)NULL;
+            __vsf_evtq_dec(&eda->evt_cnt);
+
+            if (eda->state.bits.is_to_exit) {
+                __vsf_eda_terminate(eda);
+            }
+        }
+    }
+    return VSF_ERR_NONE;
+}
+#endif
+#endif
@@ -59,6 +59,9 @@
 #define VSF_KERNEL_CFG_TIMER_MODE_TICK                      0
 #define VSF_KERNEL_CFG_TIMER_MODE_TICKLESS                  1
 
+#define VSF_KERNEL_CFG_TIMER_QUEUE_DLIST                    0
+#define VSF_KERNEL_CFG_TIMER_QUEUE_WHEEL                    1
+
 #ifndef VSF_KERNEL_CFG_EDA_SUPPORT_TIMER
 #   define VSF_KERNEL_CFG_EDA_SUPPORT_TIMER                 ENABLED
 #endif
@@ -69,6 +72,24 @@
 #   ifndef VSF_KERNEL_CFG_TIMER_MODE
 #       define VSF_KERNEL_CFG_TIMER_MODE                    VSF_KERNEL_CFG_TIMER_MODE_TICKLESS
 #   endif
+
+//  sorted dlist: O(n) insert, hierarchical timing wheel: O(1) insert/remove
+#   ifndef VSF_KERNEL_CFG_TIMER_QUEUE
+#       define VSF_KERNEL_CFG_TIMER_QUEUE                   VSF_KERNEL_CFG_TIMER_QUEUE_DLIST
+#   endif
+#   if VSF_KERNEL_CFG_TIMER_QUEUE == VSF_KERNEL_CFG_TIMER_QUEUE_WHEEL
+//  range of the wheel is (1 << (LEVEL * BITSIZE)) ticks, farther timers are
+//      kept in an unsorted list and re-inserted when the wheel wraps
+#       ifndef VSF_KERNEL_CFG_TIMER_WHEEL_LEVEL
+#           define VSF_KERNEL_CFG_TIMER_WHEEL_LEVEL         6
+#       endif
+#       ifndef VSF_KERNEL_CFG_TIMER_WHEEL_BITSIZE
+#           define VSF_KERNEL_CFG_TIMER_WHEEL_BITSIZE       5
+#       endif
+#       if VSF_KERNEL_CFG_TIMER_WHEEL_BITSIZE > 5
+#           error "VSF_KERNEL_CFG_TIMER_WHEEL_BITSIZE MUST be <= 5, slot bitmap is 32-bit"
+#       endif
+#   endif
 #else
 #   ifndef VSF_KERNEL_CFG_CALLBACK_TIMER
 #       define VSF_KERNEL_CFG_CALLBACK_TIMER                DISABLED
@@ -105,6 +126,31 @@ not what you want, please disable VSF_KERNEL_CFG_EDA_SUPPORT_FSM."
 #   ifndef __VSF_KERNEL_CFG_EDA_FRAME_POOL
 #       define __VSF_KERNEL_CFG_EDA_FRAME_POOL              ENABLED
 #   endif
+
+//  frames are allocated from size-classed slabs fed on heap, class i serves
+//      local size up to (1 << (VSF_KERNEL_CFG_EDA_FRAME_SLAB_MIN_LOCAL_BIT + i)),
+//      larger frames are allocated from heap. Frames in slabs are not returned
+//      to heap.
+#   ifndef VSF_KERNEL_CFG_EDA_FRAME_SLAB
+#       define VSF_KERNEL_CFG_EDA_FRAME_SLAB                DISABLED
+#   endif
+#   if VSF_KERNEL_CFG_EDA_FRAME_SLAB == ENABLED
+#       ifndef VSF_KERNEL_CFG_EDA_FRAME_SLAB_CLASS_NUM
+#           define VSF_KERNEL_CFG_EDA_FRAME_SLAB_CLASS_NUM  4
+#       endif
+#       ifndef VSF_KERNEL_CFG_EDA_FRAME_SLAB_MIN_LOCAL_BIT
+#           define VSF_KERNEL_CFG_EDA_FRAME_SLAB_MIN_LOCAL_BIT  4
+#       endif
+#   endif
+//  per-class statistics of frames, refer to vsf_eda_frame_statistics
+#   ifndef VSF_KERNEL_CFG_EDA_FRAME_STATISTICS
+#       define VSF_KERNEL_CFG_EDA_FRAME_STATISTICS          DISABLED
+#   endif
+//  the last frame returned by sub call is kept in the eda, and reused by next
+//      sub call if the size class matches
+#   ifndef VSF_KERNEL_CFG_EDA_FRAME_CACHE
+#       define VSF_KERNEL_CFG_EDA_FRAME_CACHE               DISABLED
+#   endif
 #endif
 
 #ifndef VSF_KERNEL_CFG_EDA_SUPPORT_ON_TERMINATE
@@ -252,12 +298,35 @@ VSF_OS_CFG_ADD_EVTQ_TO_IDLE"
 #       ifndef VSF_OS_CFG_EVTQ_BITSIZE
 #           define VSF_OS_CFG_EVTQ_BITSIZE                  4
 #       endif
+
+//  lock-free mpsc backend shares the node array of evtq_array
+#       ifndef VSF_OS_CFG_EVTQ_LOCK_FREE
+#           define VSF_OS_CFG_EVTQ_LOCK_FREE                DISABLED
+#       endif
+#       if VSF_OS_CFG_EVTQ_LOCK_FREE == ENABLED
+#           define __VSF_OS_CFG_EVTQ_MPSC
+#           ifndef VSF_OS_CFG_EVTQ_MPSC_RETRY
+#               define VSF_OS_CFG_EVTQ_MPSC_RETRY           8
+#           endif
+//  posting to a full evtq returns VSF_ERR_NOT_ENOUGH_RESOURCES instead of assert
+#           ifndef VSF_OS_CFG_EVTQ_OVERFLOW_SIZE
+#               define VSF_OS_CFG_EVTQ_OVERFLOW_SIZE        16
+#           endif
+#       endif
 #   endif
 #else
 #   undef VSF_KERNEL_CFG_SUPPORT_DYNAMIC_PRIOTIRY
 #   define VSF_KERNEL_CFG_SUPPORT_DYNAMIC_PRIOTIRY          DISABLED
 #endif
 
+// smp: evtq of vsf_prio_n is polled by core n, provided by arch
+#if defined(VSF_ARCH_CFG_CORE_NUM) && VSF_ARCH_CFG_CORE_NUM > 1
+#   if __VSF_KERNEL_CFG_EVTQ_EN != ENABLED
+#       error "smp arch requires VSF_KERNEL_CFG_ALLOW_KERNEL_BEING_PREEMPTED"
+#   endif
+#   define __VSF_KERNEL_CFG_SMP                             ENABLED
+#endif
+
 #if __VSF_KERNEL_CFG_EVTQ_EN == ENABLED
 #   ifndef VSF_KERNEL_CFG_SUPPORT_EVT_MESSAGE
 #       define VSF_KERNEL_CFG_SUPPORT_EVT_MESSAGE           ENABLED
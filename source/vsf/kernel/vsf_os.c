@@ -33,7 +33,26 @@
 #include "hal/vsf_hal.h"
 
 /*============================ MACROS ========================================*/
+
+#if __VSF_KERNEL_CFG_EDA_FRAME_POOL == ENABLED
+#   if VSF_KERNEL_CFG_EDA_FRAME_SLAB == ENABLED
+#       if VSF_POOL_CFG_FEED_ON_HEAP != ENABLED
+#           error "VSF_KERNEL_CFG_EDA_FRAME_SLAB depends on VSF_POOL_CFG_FEED_ON_HEAP"
+#       endif
+#       define __VSF_EDA_FRAME_SLAB_NUM     VSF_KERNEL_CFG_EDA_FRAME_SLAB_CLASS_NUM
+#   else
+#       define __VSF_EDA_FRAME_SLAB_NUM     0
+#   endif
+#endif
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
+
+// frame with local buffer and watermark
+#define __vsf_eda_frame_size(__local_size)                                      \
+            (sizeof(__vsf_eda_frame_t) + (__local_size) + sizeof(uintalu_t))
+#define __vsf_eda_frame_slab_local_size(__idx)                                  \
+            ((size_t)1 << (VSF_KERNEL_CFG_EDA_FRAME_SLAB_MIN_LOCAL_BIT + (__idx)))
+
 /*============================ TYPES =========================================*/
 
 typedef struct vsf_os_t {
@@ -44,6 +63,13 @@ typedef struct vsf_os_t {
 #endif
 #if __VSF_KERNEL_CFG_EDA_FRAME_POOL == ENABLED
     vsf_pool(vsf_eda_frame_pool) eda_frame_pool;
+#   if VSF_KERNEL_CFG_EDA_FRAME_SLAB == ENABLED
+    vsf_pool_t eda_frame_slab[__VSF_EDA_FRAME_SLAB_NUM];
+#   endif
+#   if VSF_KERNEL_CFG_EDA_FRAME_STATISTICS == ENABLED
+    // the last one is for frames allocated from heap
+    vsf_eda_frame_statistics_t eda_frame_statistics[__VSF_EDA_FRAME_SLAB_NUM + 1];
+#   endif
 #endif
     const vsf_kernel_resource_t *res_ptr;
 } vsf_os_t;
@@ -81,57 +107,173 @@ extern const vsf_kernel_resource_t * vsf_kernel_get_resource_on_init(void);
 //implement_vsf_pool(vsf_eda_frame_pool, __vsf_eda_frame_t)
 #define __name vsf_eda_frame_pool
 #define __type __vsf_eda_frame_t
+#if VSF_POOL_CFG_LOCK_FREE == ENABLED
+#   define __lock_free
+#endif
 #include "service/pool/impl_vsf_pool.inc"
 
 
+// class of aligned local_size, __VSF_EDA_FRAME_SLAB_NUM for heap
+static uint_fast8_t __vsf_eda_frame_class(size_t local_size)
+{
+#if VSF_KERNEL_CFG_EDA_FRAME_SLAB == ENABLED
+    uint_fast8_t idx;
+    if (local_size <= __vsf_eda_frame_slab_local_size(0)) {
+        return 0;
+    }
+    idx = vsf_msb(local_size - 1) + 1 - VSF_KERNEL_CFG_EDA_FRAME_SLAB_MIN_LOCAL_BIT;
+    return min(idx, __VSF_EDA_FRAME_SLAB_NUM);
+#else
+    return __VSF_EDA_FRAME_SLAB_NUM;
+#endif
+}
+
+#if VSF_KERNEL_CFG_EDA_FRAME_STATISTICS == ENABLED
+static void __vsf_eda_frame_statistics_update(uint_fast8_t idx, bool is_alloc, bool is_recycle)
+{
+    vsf_eda_frame_statistics_t *stat = &__vsf_os.eda_frame_statistics[idx];
+    vsf_protect_t orig = vsf_protect_int();
+        if (is_recycle) {
+            stat->recycle_cnt++;
+        } else if (is_alloc) {
+            stat->alloc_cnt++;
+            if (++stat->used_cnt > stat->max_used_cnt) {
+                stat->max_used_cnt = stat->used_cnt;
+            }
+        } else {
+            stat->used_cnt--;
+        }
+    vsf_unprotect_int(orig);
+}
+
+bool vsf_eda_frame_statistics(uint_fast8_t idx, vsf_eda_frame_statistics_t *stat)
+{
+    VSF_KERNEL_ASSERT(stat != NULL);
+    if (idx > __VSF_EDA_FRAME_SLAB_NUM) {
+        return false;
+    }
+
+    vsf_protect_t orig = vsf_protect_int();
+        *stat = __vsf_os.eda_frame_statistics[idx];
+    vsf_unprotect_int(orig);
+#   if VSF_KERNEL_CFG_EDA_FRAME_SLAB == ENABLED
+    if (idx < __VSF_EDA_FRAME_SLAB_NUM) {
+        stat->local_size = __vsf_eda_frame_slab_local_size(idx);
+        stat->free_cnt = vsf_pool_get_count(&__vsf_os.eda_frame_slab[idx]);
+    } else
+#   endif
+    {
+        stat->local_size = 0;
+        stat->free_cnt = 0;
+    }
+    return true;
+}
+#endif
+
+static __vsf_eda_frame_t * __vsf_eda_frame_init(__vsf_eda_frame_t *frame, size_t local_size)
+{
+    //! this is important, don't remove it.
+    memset(frame, 0, __vsf_eda_frame_size(local_size));
+
+    //! add watermark for local buffer overflow detection,
+    //! please never remove this!!! as local size could be zero
+    *(uintalu_t *)
+        (   (uintptr_t)frame
+        +   sizeof(__vsf_eda_frame_t)
+        +   local_size) = 0xDEADBEEF;
+
+    frame->state.local_size = local_size;
+    //vsf_slist_init_node(__vsf_eda_frame_t, use_as__vsf_slist_node_t, frame);
+    return frame;
+}
+
 SECTION(".text.vsf.kernel.vsf_eda_new_frame")
 __vsf_eda_frame_t * vsf_eda_new_frame(size_t local_size)
 {
+    __vsf_eda_frame_t *frame;
+    uint_fast8_t idx;
+
     //! make sure local_size is aligned with sizeof(uintalu_t);
     local_size = (local_size + sizeof(uintalu_t) - 1) & ~ (sizeof(uintalu_t) - 1);
-    /* todo: add smart pool support in the future */
-#if 0
-    __vsf_eda_frame_t *frame =
-            VSF_POOL_ALLOC(vsf_eda_frame_pool, &__vsf_os.eda_frame_pool);
-#else
-    __vsf_eda_frame_t *frame =
-            vsf_heap_malloc_aligned(sizeof(__vsf_eda_frame_t) + local_size + sizeof(uintalu_t),
-                                    sizeof(uintalu_t));
+    idx = __vsf_eda_frame_class(local_size);
+#if VSF_KERNEL_CFG_EDA_FRAME_SLAB == ENABLED
+    if (idx < __VSF_EDA_FRAME_SLAB_NUM) {
+        frame = (__vsf_eda_frame_t *)vsf_pool_alloc(&__vsf_os.eda_frame_slab[idx]);
+    } else
 #endif
+    {
+        frame = vsf_heap_malloc_aligned(__vsf_eda_frame_size(local_size), sizeof(uintalu_t));
+    }
 
-    if (frame != NULL) {
-        //! this is important, don't remove it.
-        memset(frame, 0, sizeof(__vsf_eda_frame_t) + local_size + sizeof(uintalu_t));
-
-        //! add watermark for local buffer overflow detection,
-        //! please never remove this!!! as local size could be zero
-        *(uintalu_t *)
-            (   (uintptr_t)frame
-            +   sizeof(__vsf_eda_frame_t)
-            +   local_size) = 0xDEADBEEF;
-
-        frame->state.local_size = local_size;
-        //vsf_slist_init_node(__vsf_eda_frame_t, use_as__vsf_slist_node_t, frame);
+    if (NULL == frame) {
+#if VSF_KERNEL_CFG_EDA_FRAME_STATISTICS == ENABLED
+        vsf_protect_t orig = vsf_protect_int();
+            __vsf_os.eda_frame_statistics[idx].fail_cnt++;
+        vsf_unprotect_int(orig);
+#endif
+        return NULL;
     }
-    return frame;
+#if VSF_KERNEL_CFG_EDA_FRAME_STATISTICS == ENABLED
+    __vsf_eda_frame_statistics_update(idx, true, false);
+#endif
+    return __vsf_eda_frame_init(frame, local_size);
 }
 
 SECTION(".text.vsf.kernel.vsf_eda_free_frame")
 void vsf_eda_free_frame(__vsf_eda_frame_t *frame)
 {
-    /* todo: add smart pool support in the future */
-#if 0
-    VSF_POOL_FREE(vsf_eda_frame_pool, &__vsf_os.eda_frame_pool, frame);
-#else
-    vsf_heap_free(frame);
+    uint_fast8_t idx;
+
+    if (NULL == frame) {
+        return;
+    }
+
+    idx = __vsf_eda_frame_class(frame->state.local_size);
+#if VSF_KERNEL_CFG_EDA_FRAME_STATISTICS == ENABLED
+    __vsf_eda_frame_statistics_update(idx, false, false);
+#endif
+#if VSF_KERNEL_CFG_EDA_FRAME_SLAB == ENABLED
+    if (idx < __VSF_EDA_FRAME_SLAB_NUM) {
+        vsf_pool_free(&__vsf_os.eda_frame_slab[idx], (uintptr_t)frame);
+        return;
+    }
 #endif
+    vsf_heap_free(frame);
+}
+
+#if VSF_KERNEL_CFG_EDA_FRAME_CACHE == ENABLED
+// reuse frame if it's in the same class as local_size, else free it and allocate a new one
+SECTION(".text.vsf.kernel.vsf_eda_renew_frame")
+__vsf_eda_frame_t * vsf_eda_renew_frame(__vsf_eda_frame_t *frame, size_t local_size)
+{
+    uint_fast8_t idx;
+
+    if (frame != NULL) {
+        local_size = (local_size + sizeof(uintalu_t) - 1) & ~ (sizeof(uintalu_t) - 1);
+        idx = __vsf_eda_frame_class(local_size);
+        // frames from heap are reused only if local_size is the same
+        if (    (idx == __vsf_eda_frame_class(frame->state.local_size))
+            &&  (   (idx < __VSF_EDA_FRAME_SLAB_NUM)
+                ||  (local_size == frame->state.local_size))) {
+#   if VSF_KERNEL_CFG_EDA_FRAME_STATISTICS == ENABLED
+            __vsf_eda_frame_statistics_update(idx, true, true);
+#   endif
+            return __vsf_eda_frame_init(frame, local_size);
+        }
+        vsf_eda_free_frame(frame);
+    }
+    return vsf_eda_new_frame(local_size);
 }
 #endif
+#endif
 
 #ifdef __VSF_OS_CFG_EVTQ_LIST
 //implement_vsf_pool( vsf_evt_node_pool, vsf_evt_node_t)
 #define __name vsf_evt_node_pool
 #define __type vsf_evt_node_t
+#if VSF_POOL_CFG_LOCK_FREE == ENABLED
+#   define __lock_free
+#endif
 #include "service/pool/impl_vsf_pool.inc"
 #endif
 
@@ -169,6 +311,18 @@ static void __vsf_kernel_os_init(void)
             sizeof(vsf_pool_item(vsf_eda_frame_pool)) * __vsf_os.res_ptr->frame_stack.frame_cnt
         );
     } while(0);
+
+#   if VSF_KERNEL_CFG_EDA_FRAME_SLAB == ENABLED
+    for (uint_fast8_t i = 0; i < __VSF_EDA_FRAME_SLAB_NUM; i++) {
+        vsf_pool_cfg_t cfg = {
+            .pool_name_str = (const uint8_t *)"eda_frame_slab",
+        };
+        // slabs are lock-free if supported
+        __vsf_pool_lock_free_init(&__vsf_os.eda_frame_slab[i],
+                __vsf_eda_frame_size(__vsf_eda_frame_slab_local_size(i)),
+                sizeof(uintalu_t), &cfg);
+    }
+#   endif
 #endif
 
 //#if __VSF_OS_SWI_NUM > 0
@@ -336,9 +490,18 @@ void __vsf_os_free_evt_node(vsf_evt_node_t *pnode)
 vsf_sched_lock_status_t vsf_forced_sched_lock(void)
 {
     if (__vsf_os_is_inited) {
+#   if __VSF_KERNEL_CFG_SMP == ENABLED
+        vsf_sched_lock_status_t origlevel = vsf_set_base_priority(
+            __vsf_os.res_ptr->arch.os_swi_priorities_ptr[
+                __vsf_os.res_ptr->arch.swi_priority_cnt - 1]);
+        // base priority is per core, lock out the schedulers on other cores
+        vsf_arch_smp_lock();
+        return origlevel;
+#   else
         return vsf_set_base_priority(
             __vsf_os.res_ptr->arch.os_swi_priorities_ptr[
                 __vsf_os.res_ptr->arch.swi_priority_cnt - 1]);
+#   endif
     }
     return vsf_arch_prio_0;
 }
@@ -346,6 +509,9 @@ vsf_sched_lock_status_t vsf_forced_sched_lock(void)
 void vsf_forced_sched_unlock(vsf_sched_lock_status_t origlevel)
 {
     if (__vsf_os_is_inited) {
+#   if __VSF_KERNEL_CFG_SMP == ENABLED
+        vsf_arch_smp_unlock();
+#   endif
         vsf_set_base_priority(origlevel);
     }
 }
@@ -143,6 +143,23 @@ typedef struct vsf_kernel_resource_t {
 #endif
 } vsf_kernel_resource_t;
 
+#if     VSF_KERNEL_CFG_EDA_SUPPORT_SUB_CALL == ENABLED                          \
+    &&  VSF_KERNEL_CFG_EDA_FRAME_STATISTICS == ENABLED
+typedef struct vsf_eda_frame_statistics_t {
+    // max local size of the class, 0 for the heap class
+    uint16_t local_size;
+    // free frames kept in the slab of the class
+    uint16_t free_cnt;
+    // frames in use, including frames kept by eda frame cache
+    uint16_t used_cnt;
+    uint16_t max_used_cnt;
+    uint32_t alloc_cnt;
+    // sub calls served by eda frame cache, not counted in alloc_cnt
+    uint32_t recycle_cnt;
+    uint32_t fail_cnt;
+} vsf_eda_frame_statistics_t;
+#endif
+
 /*============================ GLOBAL VARIABLES ==============================*/
 
 #if __VSF_OS_SWI_NUM > 0
@@ -166,6 +183,14 @@ extern void vsf_forced_sched_unlock(vsf_sched_lock_status_t origlevel);
 // vsf_sleep can only be called in vsf_plug_in_on_kernel_idle
 extern void vsf_sleep(void);
 
+#if     VSF_KERNEL_CFG_EDA_SUPPORT_SUB_CALL == ENABLED                          \
+    &&  VSF_KERNEL_CFG_EDA_FRAME_STATISTICS == ENABLED
+// idx: 0 .. VSF_KERNEL_CFG_EDA_FRAME_SLAB_CLASS_NUM - 1 for slab classes,
+//  VSF_KERNEL_CFG_EDA_FRAME_SLAB_CLASS_NUM(0 if slab is disabled) for heap.
+//  return false if idx is invalid
+extern bool vsf_eda_frame_statistics(uint_fast8_t idx, vsf_eda_frame_statistics_t *stat);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
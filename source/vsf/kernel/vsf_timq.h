@@ -26,7 +26,11 @@
 
 #if VSF_KERNEL_CFG_EDA_SUPPORT_TIMER == ENABLED
 
-#   include "./vsf_timq_dlist.h"
+#   if VSF_KERNEL_CFG_TIMER_QUEUE == VSF_KERNEL_CFG_TIMER_QUEUE_WHEEL
+#       include "./vsf_timq_wheel.h"
+#   else
+#       include "./vsf_timq_dlist.h"
+#   endif
 // todo: impelement vsf_timq_rbtree.h
 
 #endif
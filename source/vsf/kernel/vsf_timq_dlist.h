@@ -56,6 +56,9 @@ extern "C" {
                 (__queue),                                                      \
                 (__teda))
 
+// sorted queue does not need to be advanced
+#define vsf_timq_advance(__queue, __tick)
+
 
 
 #define vsf_callback_timq_init(__queue)     vsf_dlist_init(__queue)
@@ -91,6 +94,8 @@ extern "C" {
                 (__queue),                                                      \
                 (__timer))
 
+#define vsf_callback_timq_advance(__queue, __tick)
+
 /*============================ TYPES =========================================*/
 
 typedef vsf_dlist_t vsf_timer_queue_t;
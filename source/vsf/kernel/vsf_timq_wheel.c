@@ -0,0 +1,272 @@
+/****************************************************************************
+*   Copyright (C) 2009 - 2019 by Simon Qian <SimonQian@SimonQian.com>       *
+*                                                                           *
+*  Licensed under the Apache License, Version 2.0 (the "License");          *
+*  you may not use this file except in compliance with the License.         *
+*  You may obtain a copy of the License at                                  *
+*                                                                           *
+*     http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                           *
+*  Unless required by applicable law or agreed to in writing, software      *
+*  distributed under the License is distributed on an "AS IS" BASIS,        *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+*  See the License for the specific language governing permissions and      *
+*  limitations under the License.                                           *
+*                                                                           *
+****************************************************************************/
+
+/*============================ INCLUDES ======================================*/
+
+#include "kernel/vsf_kernel_cfg.h"
+
+#if     VSF_USE_KERNEL == ENABLED && VSF_KERNEL_CFG_EDA_SUPPORT_TIMER == ENABLED\
+    &&  VSF_KERNEL_CFG_TIMER_QUEUE == VSF_KERNEL_CFG_TIMER_QUEUE_WHEEL
+
+#include "./vsf_kernel_common.h"
+#include "./vsf_timq.h"
+
+/*============================ MACROS ========================================*/
+
+#define __VSF_TIMER_WHEEL_LEVEL             VSF_KERNEL_CFG_TIMER_WHEEL_LEVEL
+#define __VSF_TIMER_WHEEL_BITS              VSF_KERNEL_CFG_TIMER_WHEEL_BITSIZE
+#define __VSF_TIMER_WHEEL_MASK              (__VSF_TIMER_WHEEL_SLOT_NUM - 1)
+#define __VSF_TIMER_WHEEL_RANGE_BITS        (__VSF_TIMER_WHEEL_LEVEL * __VSF_TIMER_WHEEL_BITS)
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+
+#define __vsf_timer_wheel_low_mask(__bits)                                      \
+            (((vsf_systimer_cnt_t)1 << (__bits)) - 1)
+
+/*============================ TYPES =========================================*/
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ LOCAL VARIABLES ===============================*/
+/*============================ PROTOTYPES ====================================*/
+/*============================ IMPLEMENTATION ================================*/
+
+static vsf_systimer_cnt_t __vsf_timer_wheel_get_due(vsf_timer_wheel_t *wheel, vsf_dlist_node_t *node)
+{
+    return *(vsf_systimer_cnt_t *)((uintptr_t)node + wheel->due_offset);
+}
+
+// wrap-safe (a < b)
+static bool __vsf_timer_wheel_is_before(vsf_systimer_cnt_t a, vsf_systimer_cnt_t b)
+{
+    return (vsf_systimer_cnt_t)(a - b) > ((vsf_systimer_cnt_t)-1 >> 1);
+}
+
+// the list a timer is linked in depends only on its due and wheel->cur,
+//  so it's not necessary to save the position in the timer
+static vsf_dlist_t * __vsf_timer_wheel_locate(vsf_timer_wheel_t *wheel,
+        vsf_systimer_cnt_t due, int_fast8_t *level, uint_fast8_t *idx)
+{
+    uint_fast8_t shift;
+
+    *level = -1;
+    if (__vsf_timer_wheel_is_before(due, wheel->cur)) {
+        return &wheel->expired;
+    }
+    for (uint_fast8_t i = 0; i < __VSF_TIMER_WHEEL_LEVEL; i++) {
+        shift = i * __VSF_TIMER_WHEEL_BITS;
+        if ((due >> (shift + __VSF_TIMER_WHEEL_BITS)) == (wheel->cur >> (shift + __VSF_TIMER_WHEEL_BITS))) {
+            *level = i;
+            *idx = (due >> shift) & __VSF_TIMER_WHEEL_MASK;
+            return &wheel->slot[i][*idx];
+        }
+    }
+    return &wheel->far;
+}
+
+static void __vsf_timer_wheel_link(vsf_timer_wheel_t *wheel, vsf_dlist_node_t *node)
+{
+    int_fast8_t level;
+    uint_fast8_t idx;
+    vsf_dlist_t *list = __vsf_timer_wheel_locate(wheel,
+                __vsf_timer_wheel_get_due(wheel, node), &level, &idx);
+
+    __vsf_dlist_add_to_tail_imp(list, node);
+    if (level >= 0) {
+        wheel->bitmap[level] |= 1UL << idx;
+    }
+}
+
+static vsf_dlist_node_t * __vsf_timer_wheel_get_first(vsf_timer_wheel_t *wheel, vsf_dlist_t *list)
+{
+    vsf_dlist_node_t *node = list->head, *first = node;
+
+    for (; node != NULL; node = node->next) {
+        if (__vsf_timer_wheel_is_before(__vsf_timer_wheel_get_due(wheel, node),
+                                        __vsf_timer_wheel_get_due(wheel, first))) {
+            first = node;
+        }
+    }
+    return first;
+}
+
+// start of the next slot which need to be processed, after wheel->cur
+static vsf_systimer_cnt_t __vsf_timer_wheel_get_next(vsf_timer_wheel_t *wheel)
+{
+    uint_fast8_t shift, pos;
+    uint32_t bitmap;
+
+    for (uint_fast8_t i = 0; i < __VSF_TIMER_WHEEL_LEVEL; i++) {
+        shift = i * __VSF_TIMER_WHEEL_BITS;
+        pos = (wheel->cur >> shift) & __VSF_TIMER_WHEEL_MASK;
+        bitmap = wheel->bitmap[i] & (uint32_t)~((2UL << pos) - 1);
+        if (bitmap) {
+            return (wheel->cur & ~__vsf_timer_wheel_low_mask(shift + __VSF_TIMER_WHEEL_BITS))
+                |   ((vsf_systimer_cnt_t)vsf_ffs(bitmap) << shift);
+        }
+    }
+    // nothing in the wheel, next wrap of the wheel
+    return (wheel->cur | __vsf_timer_wheel_low_mask(__VSF_TIMER_WHEEL_RANGE_BITS)) + 1;
+}
+
+static void __vsf_timer_wheel_relink(vsf_timer_wheel_t *wheel, vsf_dlist_t *list)
+{
+    vsf_dlist_t tmp = *list;
+    vsf_dlist_node_t *node;
+
+    vsf_dlist_init(list);
+    while ((node = __vsf_dlist_remove_head_imp(&tmp)) != NULL) {
+        __vsf_timer_wheel_link(wheel, node);
+    }
+}
+
+// move timers in slots reached by wheel->cur to lower levels
+static void __vsf_timer_wheel_cascade(vsf_timer_wheel_t *wheel)
+{
+    uint_fast8_t shift, pos;
+
+    if (!(wheel->cur & __vsf_timer_wheel_low_mask(__VSF_TIMER_WHEEL_RANGE_BITS))) {
+        __vsf_timer_wheel_relink(wheel, &wheel->far);
+    }
+    for (uint_fast8_t i = __VSF_TIMER_WHEEL_LEVEL - 1; i > 0; i--) {
+        shift = i * __VSF_TIMER_WHEEL_BITS;
+        if (wheel->cur & __vsf_timer_wheel_low_mask(shift)) {
+            continue;
+        }
+
+        pos = (wheel->cur >> shift) & __VSF_TIMER_WHEEL_MASK;
+        if (wheel->bitmap[i] & (1UL << pos)) {
+            wheel->bitmap[i] &= ~(1UL << pos);
+            __vsf_timer_wheel_relink(wheel, &wheel->slot[i][pos]);
+        }
+    }
+}
+
+void __vsf_timer_wheel_init(vsf_timer_wheel_t *wheel, uint_fast16_t due_offset)
+{
+    VSF_KERNEL_ASSERT(__VSF_TIMER_WHEEL_RANGE_BITS < (sizeof(vsf_systimer_cnt_t) << 3));
+
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->due_offset = due_offset;
+}
+
+void __vsf_timer_wheel_insert(vsf_timer_wheel_t *wheel, vsf_dlist_node_t *node)
+{
+    vsf_systimer_cnt_t due = __vsf_timer_wheel_get_due(wheel, node);
+
+    if (__vsf_timer_wheel_is_before(due, wheel->cur)) {
+        __vsf_dlist_add_to_tail_imp(&wheel->expired, node);
+        return;
+    }
+
+    __vsf_timer_wheel_link(wheel, node);
+    wheel->count++;
+    // next is NULL if unknown, will be searched in peek
+    if (    (wheel->next != NULL)
+        &&  __vsf_timer_wheel_is_before(due, __vsf_timer_wheel_get_due(wheel, wheel->next))) {
+        wheel->next = node;
+    }
+}
+
+void __vsf_timer_wheel_remove(vsf_timer_wheel_t *wheel, vsf_dlist_node_t *node)
+{
+    int_fast8_t level;
+    uint_fast8_t idx;
+    vsf_dlist_t *list = __vsf_timer_wheel_locate(wheel,
+                __vsf_timer_wheel_get_due(wheel, node), &level, &idx);
+
+    VSF_KERNEL_ASSERT(__vsf_dlist_is_in_imp(list, node));
+    __vsf_dlist_remove_imp(list, node);
+    if (list != &wheel->expired) {
+        wheel->count--;
+        if ((level >= 0) && vsf_dlist_is_empty(list)) {
+            wheel->bitmap[level] &= ~(1UL << idx);
+        }
+    }
+    if (wheel->next == node) {
+        wheel->next = NULL;
+    }
+}
+
+vsf_dlist_node_t * __vsf_timer_wheel_peek(vsf_timer_wheel_t *wheel)
+{
+    uint_fast8_t shift, pos;
+    uint32_t bitmap;
+
+    if (!vsf_dlist_is_empty(&wheel->expired)) {
+        return wheel->expired.head;
+    }
+    if ((wheel->next != NULL) || (0 == wheel->count)) {
+        return wheel->next;
+    }
+
+    for (uint_fast8_t i = 0; i < __VSF_TIMER_WHEEL_LEVEL; i++) {
+        shift = i * __VSF_TIMER_WHEEL_BITS;
+        pos = (wheel->cur >> shift) & __VSF_TIMER_WHEEL_MASK;
+        // slot at pos of upper levels is always cascaded
+        bitmap = wheel->bitmap[i] & (uint32_t)~((((0 == i) ? 1UL : 2UL) << pos) - 1);
+        if (bitmap) {
+            vsf_dlist_t *list = &wheel->slot[i][vsf_ffs(bitmap)];
+            // timers in level-0 slot have the same due
+            wheel->next = (0 == i) ? list->head : __vsf_timer_wheel_get_first(wheel, list);
+            return wheel->next;
+        }
+    }
+    wheel->next = __vsf_timer_wheel_get_first(wheel, &wheel->far);
+    return wheel->next;
+}
+
+vsf_dlist_node_t * __vsf_timer_wheel_dequeue(vsf_timer_wheel_t *wheel)
+{
+    vsf_dlist_node_t *node = __vsf_timer_wheel_peek(wheel);
+    if (node != NULL) {
+        __vsf_timer_wheel_remove(wheel, node);
+    }
+    return node;
+}
+
+void __vsf_timer_wheel_advance(vsf_timer_wheel_t *wheel, vsf_systimer_cnt_t tick)
+{
+    vsf_systimer_cnt_t target = tick + 1, next;
+    vsf_dlist_t *list;
+    vsf_dlist_node_t *node;
+    uint_fast8_t pos;
+
+    while (__vsf_timer_wheel_is_before(wheel->cur, target)) {
+        if (0 == wheel->count) {
+            wheel->cur = target;
+            break;
+        }
+
+        // expire timers in current level-0 slot in batch
+        pos = wheel->cur & __VSF_TIMER_WHEEL_MASK;
+        if (wheel->bitmap[0] & (1UL << pos)) {
+            wheel->bitmap[0] &= ~(1UL << pos);
+            list = &wheel->slot[0][pos];
+            while ((node = __vsf_dlist_remove_head_imp(list)) != NULL) {
+                __vsf_dlist_add_to_tail_imp(&wheel->expired, node);
+                wheel->count--;
+            }
+            wheel->next = NULL;
+        }
+
+        // skip empty slots
+        next = __vsf_timer_wheel_get_next(wheel);
+        wheel->cur = __vsf_timer_wheel_is_before(target, next) ? target : next;
+        __vsf_timer_wheel_cascade(wheel);
+    }
+}
+
+#endif
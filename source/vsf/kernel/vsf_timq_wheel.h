@@ -0,0 +1,120 @@
+/****************************************************************************
+*   Copyright (C) 2009 - 2019 by Simon Qian <SimonQian@SimonQian.com>       *
+*                                                                           *
+*  Licensed under the Apache License, Version 2.0 (the "License");          *
+*  you may not use this file except in compliance with the License.         *
+*  You may obtain a copy of the License at                                  *
+*                                                                           *
+*     http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                           *
+*  Unless required by applicable law or agreed to in writing, software      *
+*  distributed under the License is distributed on an "AS IS" BASIS,        *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+*  See the License for the specific language governing permissions and      *
+*  limitations under the License.                                           *
+*                                                                           *
+****************************************************************************/
+
+#ifndef __VSF_TIMQ_WHEEL_H__
+#define __VSF_TIMQ_WHEEL_H__
+
+/*============================ INCLUDES ======================================*/
+#include "kernel/vsf_kernel_cfg.h"
+
+#if VSF_USE_KERNEL == ENABLED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================ MACROS ========================================*/
+
+#define __VSF_TIMER_WHEEL_SLOT_NUM          (1UL << VSF_KERNEL_CFG_TIMER_WHEEL_BITSIZE)
+
+// __node_expr is evaluated only once
+#define __vsf_timer_wheel_ref(__host_type, __node_expr, __item_ref_ptr)         \
+    do {                                                                        \
+        vsf_dlist_node_t *__vsf_timer_wheel_node = (__node_expr);               \
+        __vsf_dlist_ref_safe(__host_type, timer_node,                           \
+                __vsf_timer_wheel_node, (__item_ref_ptr));                      \
+    } while (0)
+
+#define vsf_timq_init(__queue)                                                  \
+        __vsf_timer_wheel_init((__queue),                                       \
+                offset_of(vsf_teda_t, due) - offset_of(vsf_teda_t, timer_node))
+
+#define vsf_timq_insert(__queue, __teda)                                        \
+        __vsf_timer_wheel_insert((__queue), &(__teda)->timer_node)
+
+#define vsf_timq_remove(__queue, __teda)                                        \
+        __vsf_timer_wheel_remove((__queue), &(__teda)->timer_node)
+
+#define vsf_timq_peek(__queue, __teda)                                          \
+        __vsf_timer_wheel_ref(vsf_teda_t, __vsf_timer_wheel_peek(__queue), (__teda))
+
+#define vsf_timq_dequeue(__queue, __teda)                                       \
+        __vsf_timer_wheel_ref(vsf_teda_t, __vsf_timer_wheel_dequeue(__queue), (__teda))
+
+// move all timers due before __tick to the expired list, call before peek
+#define vsf_timq_advance(__queue, __tick)                                       \
+        __vsf_timer_wheel_advance((__queue), (__tick))
+
+
+
+#define vsf_callback_timq_init(__queue)                                         \
+        __vsf_timer_wheel_init((__queue),                                       \
+                offset_of(vsf_callback_timer_t, due)                            \
+            -   offset_of(vsf_callback_timer_t, timer_node))
+
+#define vsf_callback_timq_insert(__queue, __timer)                              \
+        __vsf_timer_wheel_insert((__queue), &(__timer)->timer_node)
+
+#define vsf_callback_timq_remove(__queue, __timer)                              \
+        __vsf_timer_wheel_remove((__queue), &(__timer)->timer_node)
+
+#define vsf_callback_timq_peek(__queue, __timer)                                \
+        __vsf_timer_wheel_ref(vsf_callback_timer_t, __vsf_timer_wheel_peek(__queue), (__timer))
+
+#define vsf_callback_timq_dequeue(__queue, __timer)                             \
+        __vsf_timer_wheel_ref(vsf_callback_timer_t, __vsf_timer_wheel_dequeue(__queue), (__timer))
+
+#define vsf_callback_timq_advance(__queue, __tick)                              \
+        __vsf_timer_wheel_advance((__queue), (__tick))
+
+/*============================ TYPES =========================================*/
+
+/*
+ * Hierarchical timing wheel with cascading:
+ *  level n slot covers (1 << (n * BITSIZE)) ticks, a timer is linked in the
+ *  lowest level whose window covers its due and is moved down when the wheel
+ *  reaches its slot. Timers in a level-0 slot share the same due.
+ */
+typedef struct vsf_timer_wheel_t {
+    vsf_systimer_cnt_t cur;         // timers due before cur are in expired
+    vsf_dlist_node_t *next;         // cached earliest pending timer
+    uint32_t count;
+    uint16_t due_offset;            // offset of due from the node in the host
+    uint32_t bitmap[VSF_KERNEL_CFG_TIMER_WHEEL_LEVEL];
+    vsf_dlist_t slot[VSF_KERNEL_CFG_TIMER_WHEEL_LEVEL][__VSF_TIMER_WHEEL_SLOT_NUM];
+    vsf_dlist_t far;                // out of range of the wheel, unsorted
+    vsf_dlist_t expired;
+} vsf_timer_wheel_t;
+
+typedef vsf_timer_wheel_t vsf_timer_queue_t;
+
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ PROTOTYPES ====================================*/
+
+extern void __vsf_timer_wheel_init(vsf_timer_wheel_t *wheel, uint_fast16_t due_offset);
+extern void __vsf_timer_wheel_insert(vsf_timer_wheel_t *wheel, vsf_dlist_node_t *node);
+extern void __vsf_timer_wheel_remove(vsf_timer_wheel_t *wheel, vsf_dlist_node_t *node);
+extern vsf_dlist_node_t * __vsf_timer_wheel_peek(vsf_timer_wheel_t *wheel);
+extern vsf_dlist_node_t * __vsf_timer_wheel_dequeue(vsf_timer_wheel_t *wheel);
+extern void __vsf_timer_wheel_advance(vsf_timer_wheel_t *wheel, vsf_systimer_cnt_t tick);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+#endif
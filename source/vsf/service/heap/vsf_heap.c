@@ -21,10 +21,18 @@
 #include "utilities/vsf_utilities.h"
 #include "hal/arch/vsf_arch.h"
 
-#if VSF_USE_HEAP == ENABLED
+#if VSF_USE_HEAP == ENABLED && VSF_HEAP_CFG_ALGORITHM == VSF_HEAP_CFG_ALGORITHM_FREELIST
 #if defined(VSF_HEAP_CFG_ATOM_ACCESS_DEPENDENCY)
 #   include VSF_HEAP_CFG_ATOM_ACCESS_DEPENDENCY
 #endif
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+#   if VSF_USE_TRACE == ENABLED
+#       include "service/trace/vsf_trace.h"
+#   endif
+#   if __IS_COMPILER_MSVC__
+#       include <intrin.h>
+#   endif
+#endif
 
 
 #if __IS_COMPILER_LLVM__ || __IS_COMPILER_ARM_COMPILER_6__
@@ -44,6 +52,12 @@
 #endif
 #define VSF_HEAP_CFG_MCB_ALIGN              (1 << VSF_HEAP_CFG_MCB_ALIGN_BIT)
 
+// cache classifies freed buffers by usable size, which is meaningless if the
+//  granularity of mcb is larger than the smallest class
+#if VSF_HEAP_CFG_CACHE == ENABLED && VSF_HEAP_CFG_MCB_ALIGN_BIT > VSF_HEAP_CFG_CACHE_MIN_BIT
+#   error VSF_HEAP_CFG_CACHE needs VSF_HEAP_CFG_MCB_ALIGN_BIT <= VSF_HEAP_CFG_CACHE_MIN_BIT, use VSF_HEAP_CFG_ALGORITHM_TLSF instead
+#endif
+
 #if VSF_HEAP_CFG_MCB_MAGIC_EN == ENABLED
 #   define VSF_HEAP_MCB_MAGIC               0x1ea01ea0
 #endif
@@ -52,22 +66,16 @@
 #   define VSF_HEAP_CFG_FREELIST_NUM        1
 #endif
 
-
-
-#ifndef VSF_HEAP_CFG_PROTECT_LEVEL
-/*! \note   By default, the driver tries to make all APIs interrupt-safe,
- *!
- *!         in the case when you want to disable it,
- *!         please use following macro:
- *!         #define VSF_HEAP_CFG_PROTECT_LEVEL  none
- *!
- *!         in the case when you want to use scheduler-safe,
- *!         please use following macro:
- *!         #define VSF_HEAP_CFG_PROTECT_LEVEL  scheduler
- *!
- *!         NOTE: This macro should be defined in vsf_usr_cfg.h
- */
-#   define VSF_HEAP_CFG_PROTECT_LEVEL           interrupt
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+#   if __IS_COMPILER_GCC__ || __IS_COMPILER_LLVM__ || __IS_COMPILER_ARM_COMPILER_6__
+#       define __vsf_heap_get_caller()      __builtin_return_address(0)
+#   elif __IS_COMPILER_ARM_COMPILER_5__
+#       define __vsf_heap_get_caller()      ((void *)__return_address())
+#   elif __IS_COMPILER_MSVC__
+#       define __vsf_heap_get_caller()      _ReturnAddress()
+#   else
+#       define __vsf_heap_get_caller()      NULL
+#   endif
 #endif
 
 /*============================ MACROFIED FUNCTIONS ===========================*/
@@ -90,11 +98,30 @@ typedef struct vsf_heap_mcb_t {
     } linear;
 
     vsf_dlist_node_t list;
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+    // can not share list, which is used to check if mcb is allocated
+    vsf_dlist_node_t allocated_node;
+    void *caller;
+#endif
 } vsf_heap_mcb_t;
 
 typedef struct vsf_heap_t {
     // one more as terminator
     vsf_dlist_t freelist[VSF_HEAP_CFG_FREELIST_NUM + 1];
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+    vsf_dlist_t allocated;
+#endif
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+    struct {
+        vsf_heap_freelist_statistics_t freelist[VSF_HEAP_CFG_FREELIST_NUM];
+        uint32_t all_size;
+        uint32_t free_size;
+        uint32_t max_used_size;
+        uint32_t alloc_cnt;
+        uint32_t free_cnt;
+        uint32_t fail_cnt;
+    } statistics;
+#endif
 } vsf_heap_t;
 
 /*============================ GLOBAL VARIABLES ==============================*/
@@ -102,6 +129,7 @@ typedef struct vsf_heap_t {
 const i_heap_t VSF_HEAP = {
     .Init           = &vsf_heap_init,
     .Add            = &vsf_heap_add,
+    .AddMemory      = &vsf_heap_add_memory,
     .MallocAligned  = &vsf_heap_malloc_aligned,
     .Malloc         = &vsf_heap_malloc,
     .ReallocAligned = &vsf_heap_realloc_aligned,
@@ -116,6 +144,11 @@ static NO_INIT vsf_heap_t __vsf_heap;
 /*============================ PROTOTYPES ====================================*/
 
 extern vsf_dlist_t * vsf_heap_get_freelist(vsf_dlist_t *freelist, uint_fast8_t freelist_num, uint_fast32_t size);
+#if VSF_HEAP_CFG_CACHE == ENABLED
+extern void * __vsf_heap_cache_malloc(uint_fast32_t size);
+extern bool __vsf_heap_cache_free(void *buffer);
+extern void __vsf_heap_cache_init(void);
+#endif
 
 /*============================ IMPLEMENTATION ================================*/
 
@@ -192,12 +225,37 @@ static bool __vsf_heap_mcb_is_allocated(vsf_heap_mcb_t *mcb)
     return !vsf_dlist_is_in(vsf_heap_mcb_t, list, freelist, mcb);
 }
 
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+static void __vsf_heap_statistics_add_free(vsf_dlist_t *freelist, uint_fast32_t size)
+{
+    vsf_heap_freelist_statistics_t *statistics =
+        &__vsf_heap.statistics.freelist[freelist - &__vsf_heap.freelist[0]];
+
+    statistics->free_size += size;
+    statistics->free_num++;
+    __vsf_heap.statistics.free_size += size;
+}
+
+static void __vsf_heap_statistics_remove_free(vsf_dlist_t *freelist, uint_fast32_t size)
+{
+    vsf_heap_freelist_statistics_t *statistics =
+        &__vsf_heap.statistics.freelist[freelist - &__vsf_heap.freelist[0]];
+
+    statistics->free_size -= size;
+    statistics->free_num--;
+    __vsf_heap.statistics.free_size -= size;
+}
+#endif
+
 static void __vsf_heap_mcb_remove_from_freelist(vsf_heap_mcb_t *mcb)
 {
     uint_fast32_t size = __vsf_mcb_get_size(mcb);
     vsf_dlist_t *freelist = __vsf_heap_get_freelist(size);
 
     vsf_dlist_remove(vsf_heap_mcb_t, list, freelist, mcb);
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+    __vsf_heap_statistics_remove_free(freelist, size);
+#endif
 }
 
 static void __vsf_heap_mcb_add_to_freelist(vsf_heap_mcb_t *mcb)
@@ -206,6 +264,20 @@ static void __vsf_heap_mcb_add_to_freelist(vsf_heap_mcb_t *mcb)
     vsf_dlist_t *freelist = __vsf_heap_get_freelist(size);
 
     vsf_dlist_add_to_head(vsf_heap_mcb_t, list, freelist, mcb);
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+    __vsf_heap_statistics_add_free(freelist, size);
+#endif
+}
+
+static void __vsf_heap_mcb_append_to_freelist(vsf_heap_mcb_t *mcb)
+{
+    uint_fast32_t size = __vsf_mcb_get_size(mcb);
+    vsf_dlist_t *freelist = __vsf_heap_get_freelist(size);
+
+    vsf_dlist_add_to_tail(vsf_heap_mcb_t, list, freelist, mcb);
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+    __vsf_heap_statistics_add_free(freelist, size);
+#endif
 }
 
 static vsf_heap_mcb_t * __vsf_heap_get_mcb(uint8_t *buffer)
@@ -218,6 +290,21 @@ static vsf_heap_mcb_t * __vsf_heap_get_mcb(uint8_t *buffer)
     return (vsf_heap_mcb_t *)addr;
 }
 
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+static void __vsf_heap_mcb_set_allocated(vsf_heap_mcb_t *mcb, void *caller)
+{
+    mcb->caller = caller;
+    vsf_dlist_add_to_head(vsf_heap_mcb_t, allocated_node, &__vsf_heap.allocated, mcb);
+}
+
+static void __vsf_heap_set_caller(void *buffer, void *caller)
+{
+    if (buffer != NULL) {
+        __vsf_heap_get_mcb((uint8_t *)buffer)->caller = caller;
+    }
+}
+#endif
+
 static void * __vsf_heap_mcb_malloc(vsf_heap_mcb_t *mcb, uint_fast32_t size,
             uint_fast32_t alignment)
 {
@@ -245,24 +332,29 @@ static void * __vsf_heap_mcb_malloc(vsf_heap_mcb_t *mcb, uint_fast32_t size,
         vsf_heap_mcb_t *mcb_new;
         uint_fast32_t margin_size, temp_size;
 
-        __vsf_heap_mcb_remove_from_freelist(mcb);
         mcb_new = __vsf_heap_get_mcb(buffer);
         margin_size = (uint8_t *)mcb_new - (uint8_t *)mcb;
 
+        // mcb MUST stay in freelist until it's allocated, or re-adding it to
+        //  the head of the freelist being searched may make the search endless
         if (0 == margin_size) {
+            __vsf_heap_mcb_remove_from_freelist(mcb);
             temp_size = mcb->linear.prev;
         } else if (margin_size <= sizeof(vsf_heap_mcb_t)) {
-            __vsf_heap_mcb_add_to_freelist(mcb);
             unaligned_size = alignment;
             goto fix_alignment;
         } else {
             // split mcb
+            __vsf_heap_mcb_remove_from_freelist(mcb);
             temp_size = mcb->linear.next = margin_size >> VSF_HEAP_CFG_MCB_ALIGN_BIT;
             __vsf_heap_mcb_add_to_freelist(mcb);
         }
 
         __vsf_heap_mcb_init(mcb_new);
         mcb_new->linear.prev = temp_size;
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+        __vsf_heap_mcb_set_allocated(mcb_new, NULL);
+#endif
         mcb_new->linear.next =
             ((buffer - (uint8_t *)mcb_new) + buffer_size) >> VSF_HEAP_CFG_MCB_ALIGN_BIT;
         mcb = __vsf_heap_mcb_get_next(mcb_new);
@@ -300,6 +392,12 @@ static void __vsf_heap_mcb_free(vsf_heap_mcb_t *mcb)
     vsf_heap_mcb_t *mcb_tmp;
     vsf_protect_t state;
 
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+    state = __vsf_heap_protect();
+        vsf_dlist_remove(vsf_heap_mcb_t, allocated_node, &__vsf_heap.allocated, mcb);
+    __vsf_heap_unprotect(state);
+#endif
+
     if (mcb->linear.next != 0) {
         state = __vsf_heap_protect();
             mcb_tmp = __vsf_heap_mcb_get_next(mcb);
@@ -335,6 +433,9 @@ static void __vsf_heap_mcb_free(vsf_heap_mcb_t *mcb)
 
     state = __vsf_heap_protect();
         __vsf_heap_mcb_add_to_freelist(mcb);
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+        __vsf_heap.statistics.free_cnt++;
+#endif
     __vsf_heap_unprotect(state);
 }
 
@@ -352,6 +453,13 @@ static void * __vsf_heap_freelist_malloc(vsf_dlist_t *plist, uint_fast32_t size,
                 vsf_dlist_peek_next(vsf_heap_mcb_t, list, mcb, mcb);
             }
         }
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+        if (buffer != NULL) {
+            uint_fast32_t used_size = __vsf_heap.statistics.all_size - __vsf_heap.statistics.free_size;
+            __vsf_heap.statistics.max_used_size = max(__vsf_heap.statistics.max_used_size, used_size);
+            __vsf_heap.statistics.alloc_cnt++;
+        }
+#endif
     __vsf_heap_unprotect(state);
     return buffer;
 }
@@ -359,6 +467,9 @@ static void * __vsf_heap_freelist_malloc(vsf_dlist_t *plist, uint_fast32_t size,
 void vsf_heap_init(void)
 {
     memset(&__vsf_heap, 0, sizeof(__vsf_heap));
+#if VSF_HEAP_CFG_CACHE == ENABLED
+    __vsf_heap_cache_init();
+#endif
 }
 
 void vsf_heap_add(uint8_t *heap, uint_fast32_t size)
@@ -370,6 +481,10 @@ void vsf_heap_add(uint8_t *heap, uint_fast32_t size)
 
     VSF_SERVICE_ASSERT(NULL != heap);
 
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+    uint_fast32_t free_size = __vsf_heap.statistics.free_size;
+#endif
+
 #if VSF_HEAP_CFG_ADD_MERGE_EN == ENABLED
 /*********************************New features*********************************/
     bool             find_neighbor_again = false,
@@ -447,10 +562,7 @@ label_peek_next:
 
 label_add_to_front:
 
-                offset = mcb_new->linear.next << VSF_HEAP_CFG_MCB_ALIGN_BIT;
-                vsf_dlist_add_to_tail(  vsf_heap_mcb_t, list,
-                                        __vsf_heap_get_freelist(offset),
-                                        mcb_new);
+                __vsf_heap_mcb_append_to_freelist(mcb_new);
 
             } else if (0 == __vsf_heap_mcb_get_next(mcb)->linear.next) {
                 goto label_tall;
@@ -500,10 +612,7 @@ label_tall:
 
 label_add_to_back:
 
-                offset = mcb_prev->linear.next << VSF_HEAP_CFG_MCB_ALIGN_BIT;
-                vsf_dlist_add_to_tail(  vsf_heap_mcb_t, list,
-                                        __vsf_heap_get_freelist(offset),
-                                        mcb_prev);
+                __vsf_heap_mcb_append_to_freelist(mcb_prev);
 
             } else {
                 goto label_peek_next;
@@ -542,15 +651,18 @@ label_first_add:
         __vsf_heap_mcb_init(mcb);
         mcb->linear.next = offset;
 
-        offset <<= VSF_HEAP_CFG_MCB_ALIGN_BIT;
-            vsf_dlist_add_to_tail(  vsf_heap_mcb_t, list,
-                                    __vsf_heap_get_freelist(offset),
-                                    mcb);
+            __vsf_heap_mcb_append_to_freelist(mcb);
         __vsf_heap_unprotect(state);
 
 #if VSF_HEAP_CFG_ADD_MERGE_EN == ENABLED
     }
 #endif
+
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+    state = __vsf_heap_protect();
+        __vsf_heap.statistics.all_size += __vsf_heap.statistics.free_size - free_size;
+    __vsf_heap_unprotect(state);
+#endif
 }
 
 void vsf_heap_add_memory(vsf_mem_t mem)
@@ -558,7 +670,7 @@ void vsf_heap_add_memory(vsf_mem_t mem)
     vsf_heap_add(mem.buffer, (uint_fast32_t)mem.size);
 }
 
-void * vsf_heap_malloc_aligned(uint_fast32_t size, uint_fast32_t alignment)
+static void * __vsf_heap_malloc_aligned(uint_fast32_t size, uint_fast32_t alignment)
 {
     vsf_dlist_t *freelist = __vsf_heap_get_freelist(size + sizeof(vsf_heap_mcb_t));
     void *buffer;
@@ -575,16 +687,40 @@ void * vsf_heap_malloc_aligned(uint_fast32_t size, uint_fast32_t alignment)
         }
         freelist++;
     }
+
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+    vsf_protect_t state = __vsf_heap_protect();
+        __vsf_heap.statistics.fail_cnt++;
+    __vsf_heap_unprotect(state);
+#endif
     return NULL;
 }
 
+void * vsf_heap_malloc_aligned(uint_fast32_t size, uint_fast32_t alignment)
+{
+    void *buffer = __vsf_heap_malloc_aligned(size, alignment);
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+    __vsf_heap_set_caller(buffer, __vsf_heap_get_caller());
+#endif
+    return buffer;
+}
+
 void * vsf_heap_malloc(uint_fast32_t size)
 {
-    return vsf_heap_malloc_aligned(size, 0);
+    void *buffer;
+#if VSF_HEAP_CFG_CACHE == ENABLED
+    buffer = __vsf_heap_cache_malloc(size);
+#else
+    buffer = __vsf_heap_malloc_aligned(size, 0);
+#endif
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+    __vsf_heap_set_caller(buffer, __vsf_heap_get_caller());
+#endif
+    return buffer;
 }
 
 //Adjust the allocated memory size(Custom alignment)
-void * vsf_heap_realloc_aligned(void *buffer, uint_fast32_t size, uint_fast32_t alignment)
+static void * __vsf_heap_realloc_aligned(void *buffer, uint_fast32_t size, uint_fast32_t alignment)
 {
     void             *new_buffer;
     vsf_heap_mcb_t *mcb, *mcb_new;
@@ -602,13 +738,10 @@ void * vsf_heap_realloc_aligned(void *buffer, uint_fast32_t size, uint_fast32_t
     if (memory_size >= size) {
 realloc:
 
-        state = __vsf_heap_protect();
-
+        // the split mcb MUST be aligned to mcb, sizes in mcb are in unit of it
         addr = (uintptr_t)buffer + size;
-        addr += alignment - 1;
-        addr &= ~(alignment - 1);
-
-        __vsf_heap_unprotect(state);
+        addr += VSF_HEAP_CFG_MCB_ALIGN - 1;
+        addr &= ~(VSF_HEAP_CFG_MCB_ALIGN - 1);
 
         margin_size = memory_size - addr + (uintptr_t)buffer;
         if (margin_size > sizeof(vsf_heap_mcb_t)) {
@@ -622,12 +755,11 @@ realloc:
             mcb_new->linear.prev = mcb->linear.next - margin_size;
             mcb->linear.next = mcb_new->linear.prev;
 
-            __vsf_heap_unprotect(state);
-
             mcb = __vsf_heap_mcb_get_next(mcb_new);
             if (__vsf_heap_mcb_is_allocated(mcb)) {
                 mcb->linear.prev = mcb_new->linear.next;
             } else {
+                __vsf_heap_mcb_remove_from_freelist(mcb);
                 mcb_new->linear.next += mcb->linear.next;
 
 #if VSF_HEAP_CFG_MCB_MAGIC_EN == ENABLED
@@ -638,6 +770,8 @@ realloc:
                 mcb->linear.prev = mcb_new->linear.next;
             }
             __vsf_heap_mcb_add_to_freelist(mcb_new);
+
+            __vsf_heap_unprotect(state);
         }
 
         return buffer;
@@ -646,7 +780,10 @@ realloc:
 
         if (__vsf_heap_mcb_is_allocated(mcb_new)) {
 get_new:
-            new_buffer = vsf_heap_malloc_aligned(size, alignment);
+            new_buffer = __vsf_heap_malloc_aligned(size, alignment);
+            if (NULL == new_buffer) {
+                return NULL;
+            }
             memcpy(new_buffer, buffer, memory_size);
             vsf_heap_free(buffer);
 
@@ -658,6 +795,7 @@ get_new:
 
                 state = __vsf_heap_protect();
 
+                __vsf_heap_mcb_remove_from_freelist(mcb_new);
                 mcb->linear.next += mcb_new->linear.next;
                 mcb_new = __vsf_heap_mcb_get_next(mcb_new);
                 mcb_new->linear.prev = mcb->linear.next;
@@ -674,13 +812,27 @@ get_new:
     }
 }
 
+void * vsf_heap_realloc_aligned(void *buffer, uint_fast32_t size, uint_fast32_t alignment)
+{
+    buffer = __vsf_heap_realloc_aligned(buffer, size, alignment);
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+    __vsf_heap_set_caller(buffer, __vsf_heap_get_caller());
+#endif
+    return buffer;
+}
+
 //Adjust the allocated memory size(aligned to sizeof(uintalu_t))
 void * vsf_heap_realloc(void *buffer, uint_fast32_t size)
 {
-    return vsf_heap_realloc_aligned(buffer, size, sizeof(uintalu_t));
+    buffer = __vsf_heap_realloc_aligned(buffer, size, sizeof(uintalu_t));
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+    __vsf_heap_set_caller(buffer, __vsf_heap_get_caller());
+#endif
+    return buffer;
 }
 
-void vsf_heap_free(void *buffer)
+// free to heap bypassing cache
+void __vsf_heap_free(void *buffer)
 {
     vsf_heap_mcb_t *mcb;
 
@@ -694,6 +846,28 @@ void vsf_heap_free(void *buffer)
     __vsf_heap_mcb_free(mcb);
 }
 
+void vsf_heap_free(void *buffer)
+{
+#if VSF_HEAP_CFG_CACHE == ENABLED
+#   if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+    __vsf_heap_set_caller(buffer, NULL);
+#   endif
+    if (__vsf_heap_cache_free(buffer)) {
+        return;
+    }
+#endif
+    __vsf_heap_free(buffer);
+}
+
+uint_fast32_t vsf_heap_size(void *buffer)
+{
+    vsf_heap_mcb_t *mcb;
+
+    VSF_SERVICE_ASSERT(buffer != NULL);
+    mcb = __vsf_heap_get_mcb((uint8_t *)buffer);
+    return __vsf_mcb_get_size(mcb) - ((uint8_t *)buffer - (uint8_t *)mcb);
+}
+
 //           pos
 // |--------------------------------|
 // |   head   |   free   |   tail   |
@@ -705,6 +879,9 @@ bool vsf_heap_partial_free(void *buffer, uint_fast32_t pos, uint_fast32_t size)
     uint8_t *buffer_tmp;
     uint_fast32_t all_size;
     uint_fast32_t unaligned_size;
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+    vsf_protect_t state;
+#endif
 
     VSF_SERVICE_ASSERT(buffer != NULL);
     mcb = __vsf_heap_get_mcb((uint8_t *)buffer);
@@ -731,6 +908,11 @@ bool vsf_heap_partial_free(void *buffer, uint_fast32_t pos, uint_fast32_t size)
         mcb_free = (vsf_heap_mcb_t *)buffer_tmp;
         __vsf_heap_mcb_init(mcb_free);
         __vsf_heap_mcb_set_next(mcb, mcb_free);
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+        state = __vsf_heap_protect();
+            __vsf_heap_mcb_set_allocated(mcb_free, mcb->caller);
+        __vsf_heap_unprotect(state);
+#endif
     } else {
         mcb_free = mcb;
     }
@@ -744,6 +926,11 @@ bool vsf_heap_partial_free(void *buffer, uint_fast32_t pos, uint_fast32_t size)
         }
         __vsf_heap_mcb_init(mcb_tail);
         __vsf_heap_mcb_set_next(mcb_free, mcb_tail);
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+        state = __vsf_heap_protect();
+            __vsf_heap_mcb_set_allocated(mcb_tail, mcb->caller);
+        __vsf_heap_unprotect(state);
+#endif
     } else {
         mcb_tail = mcb_free;
     }
@@ -753,6 +940,118 @@ bool vsf_heap_partial_free(void *buffer, uint_fast32_t pos, uint_fast32_t size)
     return true;
 }
 
+#if VSF_HEAP_CFG_STATISTICS == ENABLED || VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+static bool __vsf_heap_walk_mcb(vsf_heap_mcb_t *mcb, vsf_heap_block_info_t *info,
+            vsf_heap_walker_t *walker, void *param)
+{
+    info->buffer = &mcb[1];
+    info->size = __vsf_mcb_get_size(mcb);
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+    info->caller = info->is_allocated ? mcb->caller : NULL;
+#endif
+    return walker(param, info);
+}
+
+void vsf_heap_walk(vsf_heap_walker_t *walker, void *param)
+{
+    vsf_heap_block_info_t info = { 0 };
+    bool is_continue = true;
+
+    VSF_SERVICE_ASSERT(walker != NULL);
+    vsf_protect_t state = __vsf_heap_protect();
+        for (uint_fast8_t i = 0; is_continue && (i < VSF_HEAP_CFG_FREELIST_NUM); i++) {
+            info.freelist = i;
+            __vsf_dlist_foreach_unsafe(vsf_heap_mcb_t, list, &__vsf_heap.freelist[i]) {
+                if (!(is_continue = __vsf_heap_walk_mcb(_, &info, walker, param))) {
+                    break;
+                }
+            }
+        }
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+        info.is_allocated = true;
+        info.freelist = 0;
+        if (is_continue) {
+            __vsf_dlist_foreach_unsafe(vsf_heap_mcb_t, allocated_node, &__vsf_heap.allocated) {
+                if (!__vsf_heap_walk_mcb(_, &info, walker, param)) {
+                    break;
+                }
+            }
+        }
+#endif
+    __vsf_heap_unprotect(state);
+}
+#endif
+
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+static bool __vsf_heap_statistics_walker(void *param, vsf_heap_block_info_t *info)
+{
+    vsf_heap_statistics_t *statistics = param;
+    if (!info->is_allocated) {
+        statistics->largest_free_size = max(statistics->largest_free_size, info->size);
+    }
+    return true;
+}
+
+void vsf_heap_statistics(vsf_heap_statistics_t *statistics)
+{
+    uint_fast32_t free_size;
+
+    VSF_SERVICE_ASSERT(statistics != NULL);
+    memset(statistics, 0, sizeof(*statistics));
+    vsf_heap_walk(__vsf_heap_statistics_walker, statistics);
+
+    vsf_protect_t state = __vsf_heap_protect();
+        free_size = __vsf_heap.statistics.free_size;
+        statistics->all_size = __vsf_heap.statistics.all_size;
+        statistics->used_size = __vsf_heap.statistics.all_size - free_size;
+        statistics->max_used_size = __vsf_heap.statistics.max_used_size;
+        statistics->alloc_cnt = __vsf_heap.statistics.alloc_cnt;
+        statistics->free_cnt = __vsf_heap.statistics.free_cnt;
+        statistics->fail_cnt = __vsf_heap.statistics.fail_cnt;
+        for (uint_fast8_t i = 0; i < VSF_HEAP_CFG_FREELIST_NUM; i++) {
+            statistics->free_num += __vsf_heap.statistics.freelist[i].free_num;
+        }
+    __vsf_heap_unprotect(state);
+
+    if (free_size > 0) {
+        statistics->fragmentation = 100 - (uint8_t)((uint64_t)statistics->largest_free_size * 100 / free_size);
+    }
+}
+
+bool vsf_heap_freelist_statistics(uint_fast8_t freelist, vsf_heap_freelist_statistics_t *statistics)
+{
+    VSF_SERVICE_ASSERT(statistics != NULL);
+    if (freelist >= VSF_HEAP_CFG_FREELIST_NUM) {
+        return false;
+    }
+
+    vsf_protect_t state = __vsf_heap_protect();
+        *statistics = __vsf_heap.statistics.freelist[freelist];
+    __vsf_heap_unprotect(state);
+    return true;
+}
+#endif
+
+#if VSF_HEAP_CFG_TRACE_CALLER == ENABLED && VSF_USE_TRACE == ENABLED
+static bool __vsf_heap_dump_walker(void *param, vsf_heap_block_info_t *info)
+{
+    uint_fast32_t *size = param;
+    if (info->is_allocated) {
+        vsf_trace_debug("heap: %p %d bytes, caller %p\r\n", info->buffer, (int)info->size, info->caller);
+        *size += info->size;
+    }
+    return true;
+}
+
+// trace in heap protection, for debug only
+void vsf_heap_dump_allocated(void)
+{
+    uint_fast32_t size = 0;
+    vsf_heap_walk(__vsf_heap_dump_walker, &size);
+    vsf_trace_debug("heap: %d bytes allocated\r\n", (int)size);
+}
+#endif
+
 
 #if __IS_COMPILER_LLVM__ || __IS_COMPILER_ARM_COMPILER_6__
 #   pragma clang diagnostic pop
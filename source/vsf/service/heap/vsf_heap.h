@@ -21,6 +21,7 @@
 /*============================ INCLUDES ======================================*/
 #include "service/vsf_service_cfg.h"
 #include "utilities/vsf_utilities.h"
+#include "./vsf_tlsf.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,6 +37,92 @@ extern "C" {
 #       define VSF_HEAP_SIZE    (128 * 1024)
 #   endif
 
+// heap algorithm of VSF_HEAP
+//  FREELIST: first fit in freelists, smallest footprint
+//  TLSF: two-level segregated fit, O(1) malloc/free, refer to vsf_tlsf.h
+#   define VSF_HEAP_CFG_ALGORITHM_FREELIST  0
+#   define VSF_HEAP_CFG_ALGORITHM_TLSF      1
+#   ifndef VSF_HEAP_CFG_ALGORITHM
+#       define VSF_HEAP_CFG_ALGORITHM   VSF_HEAP_CFG_ALGORITHM_FREELIST
+#   endif
+
+#   ifndef VSF_HEAP_CFG_PROTECT_LEVEL
+/*! \note   By default, the driver tries to make all APIs interrupt-safe,
+ *!
+ *!         in the case when you want to disable it,
+ *!         please use following macro:
+ *!         #define VSF_HEAP_CFG_PROTECT_LEVEL  none
+ *!
+ *!         in the case when you want to use scheduler-safe,
+ *!         please use following macro:
+ *!         #define VSF_HEAP_CFG_PROTECT_LEVEL  scheduler
+ *!
+ *!         NOTE: This macro should be defined in vsf_usr_cfg.h
+ */
+#       define VSF_HEAP_CFG_PROTECT_LEVEL   interrupt
+#   endif
+
+/*! \note   small object caches in front of the heap
+ *!         vsf_heap_malloc and vsf_heap_free of small buffers are served by the
+ *!         cache of current priority without taking the heap protection.
+ *!         Edas of the same priority never preempt each other, so the cache is
+ *!         only protected by VSF_HEAP_CFG_CACHE_PROTECT_LEVEL against
+ *!         interrupts, set it to interrupt if heap is used in interrupt.
+ *!         Threads are edas, so threads of a priority share one cache instead
+ *!         of having their own: it's as contention-free as per-thread caches,
+ *!         buffers freed by another thread of the priority are reused at once,
+ *!         and memory held by caches is bounded by priorities, not threads.
+ *!         Cached buffers are refilled from and drained to the heap in batch.
+ *!         Freed buffers are classified by usable size, so freelist heap needs
+ *!         VSF_HEAP_CFG_MCB_ALIGN_BIT <= VSF_HEAP_CFG_CACHE_MIN_BIT.
+ */
+#   ifndef VSF_HEAP_CFG_CACHE
+#       define VSF_HEAP_CFG_CACHE       DISABLED
+#   endif
+#   if VSF_HEAP_CFG_CACHE == ENABLED
+#       ifndef VSF_HEAP_CFG_CACHE_PROTECT_LEVEL
+#           define VSF_HEAP_CFG_CACHE_PROTECT_LEVEL     none
+#       endif
+// size classes are (1 << VSF_HEAP_CFG_CACHE_MIN_BIT) << n, n in [0, CLASS_NUM)
+#       ifndef VSF_HEAP_CFG_CACHE_MIN_BIT
+#           define VSF_HEAP_CFG_CACHE_MIN_BIT           4
+#       endif
+#       ifndef VSF_HEAP_CFG_CACHE_CLASS_NUM
+#           define VSF_HEAP_CFG_CACHE_CLASS_NUM         6
+#       endif
+// max buffers cached for every class
+#       ifndef VSF_HEAP_CFG_CACHE_DEPTH
+#           define VSF_HEAP_CFG_CACHE_DEPTH             16
+#       endif
+// buffers refilled from or drained to heap at a time
+#       ifndef VSF_HEAP_CFG_CACHE_BATCH
+#           define VSF_HEAP_CFG_CACHE_BATCH             8
+#       endif
+// max bytes cached in one cache
+#       ifndef VSF_HEAP_CFG_CACHE_MAX_SIZE
+#           define VSF_HEAP_CFG_CACHE_MAX_SIZE          (8 * 1024)
+#       endif
+#   endif
+
+/*! \note   statistics of heap, including used size and its high-water mark,
+ *!         allocation counters, per-freelist free size and fragmentation.
+ *!         VSF_HEAP_CFG_TRACE_CALLER records the caller of every allocated
+ *!         buffer in its mcb, so that leaks can be dumped by
+ *!         vsf_heap_dump_allocated. FREELIST algorithm only.
+ *!         The walk API is available if any of them is enabled.
+ */
+#   ifndef VSF_HEAP_CFG_STATISTICS
+#       define VSF_HEAP_CFG_STATISTICS          DISABLED
+#   endif
+#   ifndef VSF_HEAP_CFG_TRACE_CALLER
+#       define VSF_HEAP_CFG_TRACE_CALLER        DISABLED
+#   endif
+#   if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+#       if VSF_HEAP_CFG_ALGORITHM != VSF_HEAP_CFG_ALGORITHM_FREELIST
+#           error VSF_HEAP_CFG_TRACE_CALLER is only supported by VSF_HEAP_CFG_ALGORITHM_FREELIST
+#       endif
+#   endif
+
 #if 0
 /*! \brief free a target memory which belongs to a bigger memory chunk previouly
  *!        allocated from the heap
@@ -66,6 +153,59 @@ def_interface(i_heap_t)
 end_def_interface(i_heap_t)
 //! @}
 
+#if VSF_HEAP_CFG_CACHE == ENABLED
+typedef struct vsf_heap_cache_t {
+    // bytes cached, in size of class
+    uint32_t size;
+    struct {
+        uint8_t num;
+        void *buffer[VSF_HEAP_CFG_CACHE_DEPTH];
+    } magazine[VSF_HEAP_CFG_CACHE_CLASS_NUM];
+} vsf_heap_cache_t;
+#endif
+
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+typedef struct vsf_heap_statistics_t {
+    // sizes include the control blocks
+    uint32_t all_size;
+    uint32_t used_size;
+    uint32_t max_used_size;
+    uint32_t largest_free_size;
+    uint32_t free_num;
+    // 0 if all free memory is in one block, approaching 100 if scattered
+    uint8_t fragmentation;
+
+    uint32_t alloc_cnt;
+    uint32_t free_cnt;
+    uint32_t fail_cnt;
+} vsf_heap_statistics_t;
+
+typedef struct vsf_heap_freelist_statistics_t {
+    uint32_t free_size;
+    uint32_t free_num;
+} vsf_heap_freelist_statistics_t;
+#endif
+
+#if VSF_HEAP_CFG_STATISTICS == ENABLED || VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+
+typedef struct vsf_heap_block_info_t {
+    void *buffer;
+    uint32_t size;
+    bool is_allocated;
+    // index of the freelist of a free block
+    uint8_t freelist;
+#   if VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+    // caller of malloc/realloc, NULL if the buffer is freed to cache
+    void *caller;
+#   endif
+} vsf_heap_block_info_t;
+
+/*! \note  walker is called in heap protection, MUST be short and MUST NOT call
+ *!        heap APIs, return false to stop walking
+ */
+typedef bool vsf_heap_walker_t(void *param, vsf_heap_block_info_t *info);
+#endif
+
 /*============================ GLOBAL VARIABLES ==============================*/
 
 extern const i_heap_t VSF_HEAP;
@@ -85,6 +225,33 @@ extern void * vsf_heap_malloc(uint_fast32_t size);
 extern void * vsf_heap_realloc_aligned(void *buffer, uint_fast32_t size, uint_fast32_t alignment);
 extern void * vsf_heap_realloc(void *buffer, uint_fast32_t size);
 extern void vsf_heap_free(void *buffer);
+//! \brief get the usable size of an allocated buffer
+extern uint_fast32_t vsf_heap_size(void *buffer);
+
+#if VSF_HEAP_CFG_CACHE == ENABLED
+/*! \brief return all buffers in the cache to heap
+ *! \note caller MUST own the cache, eg: cache of current priority, or a
+ *!       private cache returned by vsf_heap_get_cache
+ */
+extern void vsf_heap_cache_flush(vsf_heap_cache_t *cache);
+#endif
+
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+extern void vsf_heap_statistics(vsf_heap_statistics_t *statistics);
+//! \retval false if freelist is out of range
+extern bool vsf_heap_freelist_statistics(uint_fast8_t freelist, vsf_heap_freelist_statistics_t *statistics);
+#endif
+
+#if VSF_HEAP_CFG_STATISTICS == ENABLED || VSF_HEAP_CFG_TRACE_CALLER == ENABLED
+/*! \brief walk free blocks, and allocated blocks if VSF_HEAP_CFG_TRACE_CALLER
+ *!        is enabled
+ */
+extern void vsf_heap_walk(vsf_heap_walker_t *walker, void *param);
+#   if VSF_HEAP_CFG_TRACE_CALLER == ENABLED && VSF_USE_TRACE == ENABLED
+//! \brief dump allocated buffers and their callers by vsf_trace
+extern void vsf_heap_dump_allocated(void);
+#   endif
+#endif
 
 /*! \brief partially free a target memory
  *! \param buffer the address of the target memory chunk
@@ -0,0 +1,242 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+/*============================ INCLUDES ======================================*/
+#include "service/vsf_service_cfg.h"
+#include "vsf_heap.h"
+#include "utilities/vsf_utilities.h"
+#include "hal/arch/vsf_arch.h"
+
+#if VSF_USE_HEAP == ENABLED && VSF_HEAP_CFG_CACHE == ENABLED
+
+#if VSF_USE_KERNEL == ENABLED
+#   include "kernel/vsf_kernel.h"
+#endif
+
+/*============================ MACROS ========================================*/
+
+#if VSF_HEAP_CFG_CACHE_BATCH > VSF_HEAP_CFG_CACHE_DEPTH
+#   error VSF_HEAP_CFG_CACHE_BATCH MUST be <= VSF_HEAP_CFG_CACHE_DEPTH
+#endif
+
+// one cache for every priority, shared by all edas and threads of the priority
+#if VSF_USE_KERNEL == ENABLED && __VSF_KERNEL_CFG_EVTQ_EN == ENABLED
+#   define __VSF_HEAP_CACHE_NUM             VSF_OS_CFG_PRIORITY_NUM
+#else
+#   define __VSF_HEAP_CACHE_NUM             1
+#endif
+
+#define __VSF_HEAP_CACHE_MAX_CLASS_SIZE                                         \
+            ((uint_fast32_t)1 << (VSF_HEAP_CFG_CACHE_MIN_BIT + VSF_HEAP_CFG_CACHE_CLASS_NUM - 1))
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+
+#define __vsf_heap_protect                  vsf_protect(VSF_HEAP_CFG_PROTECT_LEVEL)
+#define __vsf_heap_unprotect                vsf_unprotect(VSF_HEAP_CFG_PROTECT_LEVEL)
+#define __vsf_heap_cache_protect            vsf_protect(VSF_HEAP_CFG_CACHE_PROTECT_LEVEL)
+#define __vsf_heap_cache_unprotect          vsf_unprotect(VSF_HEAP_CFG_CACHE_PROTECT_LEVEL)
+
+#define __vsf_heap_cache_class_size(__idx)                                      \
+            ((uint_fast32_t)1 << (VSF_HEAP_CFG_CACHE_MIN_BIT + (__idx)))
+
+/*============================ TYPES =========================================*/
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ LOCAL VARIABLES ===============================*/
+
+static NO_INIT vsf_heap_cache_t __vsf_heap_cache[__VSF_HEAP_CACHE_NUM];
+
+/*============================ PROTOTYPES ====================================*/
+
+extern vsf_heap_cache_t * vsf_heap_get_cache(vsf_heap_cache_t *cache, uint_fast8_t cache_num);
+extern void __vsf_heap_free(void *buffer);
+#if VSF_USE_KERNEL == ENABLED && __VSF_KERNEL_CFG_EVTQ_EN == ENABLED
+extern vsf_evtq_t * __vsf_get_cur_evtq(void);
+extern vsf_prio_t __vsf_os_evtq_get_priority(vsf_evtq_t *this_ptr);
+#endif
+
+/*============================ IMPLEMENTATION ================================*/
+
+/*! \note   by default, cache of current priority is used, and NULL(not cached)
+ *!         if not running in any priority. Override to use private caches,
+ *!         eg: per-thread cache saved in thread context, owner of the private
+ *!         cache should call vsf_heap_cache_flush before it's destroyed.
+ */
+#ifndef WEAK_VSF_HEAP_GET_CACHE
+WEAK(vsf_heap_get_cache)
+vsf_heap_cache_t * vsf_heap_get_cache(vsf_heap_cache_t *cache, uint_fast8_t cache_num)
+{
+    UNUSED_PARAM(cache_num);
+#if VSF_USE_KERNEL == ENABLED && __VSF_KERNEL_CFG_EVTQ_EN == ENABLED
+    vsf_evtq_t *evtq = __vsf_get_cur_evtq();
+    if (NULL == evtq) {
+        return NULL;
+    }
+    return &cache[__vsf_os_evtq_get_priority(evtq)];
+#else
+    return cache;
+#endif
+}
+#endif
+
+static vsf_heap_cache_t * __vsf_heap_cache_get(void)
+{
+    return vsf_heap_get_cache(__vsf_heap_cache, dimof(__vsf_heap_cache));
+}
+
+// free buffers to heap in one heap protection
+static void __vsf_heap_cache_drain(void **buffer, uint_fast8_t num)
+{
+    vsf_protect_t state = __vsf_heap_protect();
+        while (num-- > 0) {
+            __vsf_heap_free(*buffer++);
+        }
+    __vsf_heap_unprotect(state);
+}
+
+void __vsf_heap_cache_init(void)
+{
+    memset(__vsf_heap_cache, 0, sizeof(__vsf_heap_cache));
+}
+
+void vsf_heap_cache_flush(vsf_heap_cache_t *cache)
+{
+    vsf_protect_t state;
+
+    VSF_SERVICE_ASSERT(cache != NULL);
+    for (uint_fast8_t i = 0; i < VSF_HEAP_CFG_CACHE_CLASS_NUM; i++) {
+        state = __vsf_heap_cache_protect();
+            __vsf_heap_cache_drain(cache->magazine[i].buffer, cache->magazine[i].num);
+            cache->size -= cache->magazine[i].num * __vsf_heap_cache_class_size(i);
+            cache->magazine[i].num = 0;
+        __vsf_heap_cache_unprotect(state);
+    }
+}
+
+void * __vsf_heap_cache_malloc(uint_fast32_t size)
+{
+    vsf_heap_cache_t *cache;
+    void *buffer[VSF_HEAP_CFG_CACHE_BATCH];
+    uint_fast32_t class_size, room;
+    uint_fast8_t idx, num;
+    vsf_protect_t state;
+
+    if ((size > __VSF_HEAP_CACHE_MAX_CLASS_SIZE) || (NULL == (cache = __vsf_heap_cache_get()))) {
+        return vsf_heap_malloc_aligned(size, 0);
+    }
+
+    idx = (size <= (1 << VSF_HEAP_CFG_CACHE_MIN_BIT)) ? 0 :
+                vsf_msb(size - 1) + 1 - VSF_HEAP_CFG_CACHE_MIN_BIT;
+    class_size = __vsf_heap_cache_class_size(idx);
+
+    state = __vsf_heap_cache_protect();
+        if (cache->magazine[idx].num > 0) {
+            buffer[0] = cache->magazine[idx].buffer[--cache->magazine[idx].num];
+            cache->size -= class_size;
+            __vsf_heap_cache_unprotect(state);
+            return buffer[0];
+        }
+        room = (VSF_HEAP_CFG_CACHE_MAX_SIZE - min(cache->size, VSF_HEAP_CFG_CACHE_MAX_SIZE)) / class_size;
+    __vsf_heap_cache_unprotect(state);
+
+    // refill in one heap protection, one for the caller and others for the cache
+    room = min(room + 1, VSF_HEAP_CFG_CACHE_BATCH);
+    state = __vsf_heap_protect();
+        for (num = 0; num < room; num++) {
+            buffer[num] = vsf_heap_malloc_aligned(class_size, 0);
+            if (NULL == buffer[num]) {
+                break;
+            }
+        }
+    __vsf_heap_unprotect(state);
+
+    if (0 == num) {
+        // heap maybe exhausted by cached buffers, flush and retry
+        vsf_heap_cache_flush(cache);
+        return vsf_heap_malloc_aligned(size, 0);
+    }
+
+    state = __vsf_heap_cache_protect();
+        room = VSF_HEAP_CFG_CACHE_DEPTH - cache->magazine[idx].num;
+        room = min(room, num - 1);
+        memcpy(&cache->magazine[idx].buffer[cache->magazine[idx].num], &buffer[1], room * sizeof(void *));
+        cache->magazine[idx].num += room;
+        cache->size += room * class_size;
+    __vsf_heap_cache_unprotect(state);
+
+    if (room < num - 1) {
+        __vsf_heap_cache_drain(&buffer[1 + room], num - 1 - room);
+    }
+    return buffer[0];
+}
+
+// return false if buffer is not cached, and should be freed to heap
+bool __vsf_heap_cache_free(void *buffer)
+{
+    vsf_heap_cache_t *cache;
+    void *drain[VSF_HEAP_CFG_CACHE_BATCH];
+    uint_fast32_t size, class_size;
+    uint_fast8_t idx, num;
+    vsf_protect_t state;
+
+    // buffer maybe the tail part of vsf_heap_partial_free, which is not aligned
+    if (((uintptr_t)buffer & (sizeof(uintalu_t) - 1)) || (NULL == (cache = __vsf_heap_cache_get()))) {
+        return false;
+    }
+
+    // buffers of any source are cached in the largest class they can serve
+    size = vsf_heap_size(buffer);
+    if ((size < (1 << VSF_HEAP_CFG_CACHE_MIN_BIT)) || (size >= 2 * __VSF_HEAP_CACHE_MAX_CLASS_SIZE)) {
+        return false;
+    }
+    idx = vsf_msb(size) - VSF_HEAP_CFG_CACHE_MIN_BIT;
+    class_size = __vsf_heap_cache_class_size(idx);
+
+    state = __vsf_heap_cache_protect();
+        if (    (cache->magazine[idx].num < VSF_HEAP_CFG_CACHE_DEPTH)
+            &&  (cache->size + class_size <= VSF_HEAP_CFG_CACHE_MAX_SIZE)) {
+            cache->magazine[idx].buffer[cache->magazine[idx].num++] = buffer;
+            cache->size += class_size;
+            __vsf_heap_cache_unprotect(state);
+            return true;
+        }
+
+        // drain the oldest buffers of the class to make room
+        num = min(cache->magazine[idx].num, VSF_HEAP_CFG_CACHE_BATCH);
+        memcpy(drain, cache->magazine[idx].buffer, num * sizeof(void *));
+        cache->magazine[idx].num -= num;
+        memmove(cache->magazine[idx].buffer, &cache->magazine[idx].buffer[num],
+                cache->magazine[idx].num * sizeof(void *));
+        cache->size -= num * class_size;
+
+        if (cache->size + class_size <= VSF_HEAP_CFG_CACHE_MAX_SIZE) {
+            cache->magazine[idx].buffer[cache->magazine[idx].num++] = buffer;
+            cache->size += class_size;
+        } else if (num < VSF_HEAP_CFG_CACHE_BATCH) {
+            // cache is full of other classes
+            drain[num++] = buffer;
+        } else {
+            __vsf_heap_cache_unprotect(state);
+            __vsf_heap_cache_drain(drain, num);
+            return false;
+        }
+    __vsf_heap_cache_unprotect(state);
+
+    __vsf_heap_cache_drain(drain, num);
+    return true;
+}
+
+#endif      // VSF_USE_HEAP && VSF_HEAP_CFG_CACHE
@@ -0,0 +1,735 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+/*============================ INCLUDES ======================================*/
+#include "service/vsf_service_cfg.h"
+#include "vsf_heap.h"
+#include "utilities/vsf_utilities.h"
+#include "hal/arch/vsf_arch.h"
+
+#if VSF_USE_HEAP == ENABLED
+
+#if __IS_COMPILER_LLVM__ || __IS_COMPILER_ARM_COMPILER_6__
+#   pragma clang diagnostic push
+#   pragma clang diagnostic ignored "-Wcast-align"
+#endif
+
+#if __IS_COMPILER_GCC__
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wcast-align"
+#endif
+
+/*============================ MACROS ========================================*/
+
+#define VSF_TLSF_BLOCK_FREE                 (1 << 0)
+#define VSF_TLSF_BLOCK_PREV_FREE            (1 << 1)
+#define VSF_TLSF_BLOCK_FLAGS                (VSF_TLSF_BLOCK_FREE | VSF_TLSF_BLOCK_PREV_FREE)
+
+// header of used block, next_free/prev_free are overlapped with the payload
+#define VSF_TLSF_HEADER_SIZE                (2 * sizeof(uintptr_t))
+// payload of free block MUST hold next_free/prev_free
+#define VSF_TLSF_PAYLOAD_MIN                (sizeof(vsf_tlsf_block_t) - VSF_TLSF_HEADER_SIZE)
+// msb of payload size MUST be lower than VSF_HEAP_CFG_TLSF_FL_MAX_BIT
+#define VSF_TLSF_PAYLOAD_MAX                (((uintptr_t)1 << VSF_HEAP_CFG_TLSF_FL_MAX_BIT) - VSF_TLSF_ALIGN)
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+
+#define __vsf_tlsf_align_up(__v, __align)                                       \
+            (((uintptr_t)(__v) + (__align) - 1) & ~((uintptr_t)(__align) - 1))
+#define __vsf_tlsf_align_down(__v, __align)                                     \
+            ((uintptr_t)(__v) & ~((uintptr_t)(__align) - 1))
+
+#define __vsf_heap_protect                  vsf_protect(VSF_HEAP_CFG_PROTECT_LEVEL)
+#define __vsf_heap_unprotect                vsf_unprotect(VSF_HEAP_CFG_PROTECT_LEVEL)
+
+/*============================ TYPES =========================================*/
+/*============================ GLOBAL VARIABLES ==============================*/
+
+#if VSF_HEAP_CFG_ALGORITHM == VSF_HEAP_CFG_ALGORITHM_TLSF
+const i_heap_t VSF_HEAP = {
+    .Init           = &vsf_heap_init,
+    .Add            = &vsf_heap_add,
+    .AddMemory      = &vsf_heap_add_memory,
+    .MallocAligned  = &vsf_heap_malloc_aligned,
+    .Malloc         = &vsf_heap_malloc,
+    .ReallocAligned = &vsf_heap_realloc_aligned,
+    .Realloc        = &vsf_heap_realloc,
+    .Free           = &vsf_heap_free
+};
+#endif
+
+/*============================ LOCAL VARIABLES ===============================*/
+
+#if VSF_HEAP_CFG_ALGORITHM == VSF_HEAP_CFG_ALGORITHM_TLSF
+static NO_INIT vsf_tlsf_t __vsf_heap;
+#   if VSF_HEAP_CFG_STATISTICS == ENABLED
+static NO_INIT struct {
+    uint32_t max_used_size;
+    uint32_t alloc_cnt;
+    uint32_t free_cnt;
+    uint32_t fail_cnt;
+} __vsf_heap_statistics;
+#   endif
+#endif
+
+/*============================ PROTOTYPES ====================================*/
+
+#if VSF_HEAP_CFG_ALGORITHM == VSF_HEAP_CFG_ALGORITHM_TLSF && VSF_HEAP_CFG_CACHE == ENABLED
+extern void * __vsf_heap_cache_malloc(uint_fast32_t size);
+extern bool __vsf_heap_cache_free(void *buffer);
+extern void __vsf_heap_cache_init(void);
+#endif
+
+/*============================ IMPLEMENTATION ================================*/
+
+static uintptr_t __vsf_tlsf_block_size(vsf_tlsf_block_t *block)
+{
+    return block->size & ~(uintptr_t)VSF_TLSF_BLOCK_FLAGS;
+}
+
+static void __vsf_tlsf_block_set_size(vsf_tlsf_block_t *block, uintptr_t size)
+{
+    block->size = size | (block->size & VSF_TLSF_BLOCK_FLAGS);
+}
+
+static bool __vsf_tlsf_block_is_free(vsf_tlsf_block_t *block)
+{
+    return !!(block->size & VSF_TLSF_BLOCK_FREE);
+}
+
+static bool __vsf_tlsf_block_is_prev_free(vsf_tlsf_block_t *block)
+{
+    return !!(block->size & VSF_TLSF_BLOCK_PREV_FREE);
+}
+
+static uint8_t * __vsf_tlsf_block_payload(vsf_tlsf_block_t *block)
+{
+    return (uint8_t *)block + VSF_TLSF_HEADER_SIZE;
+}
+
+// buffer may be unaligned if it's the tail part of vsf_tlsf_partial_free
+static vsf_tlsf_block_t * __vsf_tlsf_block_from_ptr(void *buffer)
+{
+    return (vsf_tlsf_block_t *)(__vsf_tlsf_align_down(buffer, VSF_TLSF_ALIGN) - VSF_TLSF_HEADER_SIZE);
+}
+
+static vsf_tlsf_block_t * __vsf_tlsf_block_next(vsf_tlsf_block_t *block)
+{
+    return (vsf_tlsf_block_t *)(__vsf_tlsf_block_payload(block) + __vsf_tlsf_block_size(block));
+}
+
+static vsf_tlsf_block_t * __vsf_tlsf_block_link_next(vsf_tlsf_block_t *block)
+{
+    vsf_tlsf_block_t *next = __vsf_tlsf_block_next(block);
+    next->prev_phys = block;
+    return next;
+}
+
+static void __vsf_tlsf_block_mark_free(vsf_tlsf_block_t *block)
+{
+    vsf_tlsf_block_t *next = __vsf_tlsf_block_link_next(block);
+    next->size |= VSF_TLSF_BLOCK_PREV_FREE;
+    block->size |= VSF_TLSF_BLOCK_FREE;
+}
+
+static void __vsf_tlsf_block_mark_used(vsf_tlsf_block_t *block)
+{
+    vsf_tlsf_block_t *next = __vsf_tlsf_block_next(block);
+    next->size &= ~(uintptr_t)VSF_TLSF_BLOCK_PREV_FREE;
+    block->size &= ~(uintptr_t)VSF_TLSF_BLOCK_FREE;
+}
+
+static void __vsf_tlsf_mapping_insert(uintptr_t size, uint_fast8_t *fl, uint_fast8_t *sl)
+{
+    if (size < (1 << VSF_TLSF_FL_SHIFT)) {
+        // small blocks are linearly mapped in fl 0
+        *fl = 0;
+        *sl = size >> VSF_TLSF_ALIGN_BITS;
+    } else {
+        uint_fast8_t msb = vsf_msb(size);
+        *sl = (size >> (msb - VSF_HEAP_CFG_TLSF_SL_BITS)) ^ VSF_TLSF_SL_COUNT;
+        *fl = msb - VSF_TLSF_FL_SHIFT + 1;
+    }
+}
+
+// round up to the next class, so that any block in the class found is large enough
+static void __vsf_tlsf_mapping_search(uintptr_t size, uint_fast8_t *fl, uint_fast8_t *sl)
+{
+    if (size >= (1 << VSF_TLSF_FL_SHIFT)) {
+        size += ((uintptr_t)1 << (vsf_msb(size) - VSF_HEAP_CFG_TLSF_SL_BITS)) - 1;
+    }
+    __vsf_tlsf_mapping_insert(size, fl, sl);
+}
+
+static vsf_tlsf_block_t * __vsf_tlsf_search_suitable(vsf_tlsf_t *tlsf, uint_fast8_t *fl, uint_fast8_t *sl)
+{
+    uint_fast32_t sl_map, fl_map;
+
+    if (*fl >= VSF_TLSF_FL_COUNT) {
+        return NULL;
+    }
+
+    sl_map = tlsf->sl_bitmap[*fl] & (~(uint32_t)0 << *sl);
+    if (!sl_map) {
+        fl_map = (*fl + 1 < 32) ? tlsf->fl_bitmap & (~(uint32_t)0 << (*fl + 1)) : 0;
+        if (!fl_map) {
+            return NULL;
+        }
+        *fl = vsf_ffs(fl_map);
+        sl_map = tlsf->sl_bitmap[*fl];
+    }
+    *sl = vsf_ffs(sl_map);
+    return tlsf->blocks[*fl][*sl];
+}
+
+static void __vsf_tlsf_remove_free(vsf_tlsf_t *tlsf, vsf_tlsf_block_t *block)
+{
+    vsf_tlsf_block_t *prev = block->prev_free, *next = block->next_free;
+    uint_fast8_t fl, sl;
+
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+    tlsf->free_size -= __vsf_tlsf_block_size(block) + VSF_TLSF_HEADER_SIZE;
+#endif
+    if (next != NULL) {
+        next->prev_free = prev;
+    }
+    if (prev != NULL) {
+        prev->next_free = next;
+    } else {
+        __vsf_tlsf_mapping_insert(__vsf_tlsf_block_size(block), &fl, &sl);
+        VSF_SERVICE_ASSERT(tlsf->blocks[fl][sl] == block);
+        tlsf->blocks[fl][sl] = next;
+        if (NULL == next) {
+            tlsf->sl_bitmap[fl] &= ~(1UL << sl);
+            if (!tlsf->sl_bitmap[fl]) {
+                tlsf->fl_bitmap &= ~(1UL << fl);
+            }
+        }
+    }
+}
+
+static void __vsf_tlsf_insert_free(vsf_tlsf_t *tlsf, vsf_tlsf_block_t *block)
+{
+    vsf_tlsf_block_t *head;
+    uint_fast8_t fl, sl;
+
+    __vsf_tlsf_mapping_insert(__vsf_tlsf_block_size(block), &fl, &sl);
+    head = tlsf->blocks[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head != NULL) {
+        head->prev_free = block;
+    }
+    tlsf->blocks[fl][sl] = block;
+    tlsf->sl_bitmap[fl] |= 1UL << sl;
+    tlsf->fl_bitmap |= 1UL << fl;
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+    tlsf->free_size += __vsf_tlsf_block_size(block) + VSF_TLSF_HEADER_SIZE;
+#endif
+}
+
+static bool __vsf_tlsf_block_can_split(vsf_tlsf_block_t *block, uintptr_t size)
+{
+    return __vsf_tlsf_block_size(block) >= size + sizeof(vsf_tlsf_block_t);
+}
+
+// split block at size, the remaining part is marked free but not inserted
+static vsf_tlsf_block_t * __vsf_tlsf_block_split(vsf_tlsf_block_t *block, uintptr_t size)
+{
+    vsf_tlsf_block_t *remaining = (vsf_tlsf_block_t *)(__vsf_tlsf_block_payload(block) + size);
+
+    remaining->size = __vsf_tlsf_block_size(block) - size - VSF_TLSF_HEADER_SIZE;
+    remaining->prev_phys = block;
+    __vsf_tlsf_block_set_size(block, size);
+    __vsf_tlsf_block_mark_free(remaining);
+    return remaining;
+}
+
+static vsf_tlsf_block_t * __vsf_tlsf_block_absorb(vsf_tlsf_block_t *prev, vsf_tlsf_block_t *block)
+{
+    __vsf_tlsf_block_set_size(prev, __vsf_tlsf_block_size(prev)
+                + __vsf_tlsf_block_size(block) + VSF_TLSF_HEADER_SIZE);
+    __vsf_tlsf_block_link_next(prev);
+    return prev;
+}
+
+static vsf_tlsf_block_t * __vsf_tlsf_merge_prev(vsf_tlsf_t *tlsf, vsf_tlsf_block_t *block)
+{
+    if (__vsf_tlsf_block_is_prev_free(block)) {
+        vsf_tlsf_block_t *prev = block->prev_phys;
+        VSF_SERVICE_ASSERT((prev != NULL) && __vsf_tlsf_block_is_free(prev));
+        __vsf_tlsf_remove_free(tlsf, prev);
+        block = __vsf_tlsf_block_absorb(prev, block);
+    }
+    return block;
+}
+
+static vsf_tlsf_block_t * __vsf_tlsf_merge_next(vsf_tlsf_t *tlsf, vsf_tlsf_block_t *block)
+{
+    vsf_tlsf_block_t *next = __vsf_tlsf_block_next(block);
+    if (__vsf_tlsf_block_is_free(next)) {
+        __vsf_tlsf_remove_free(tlsf, next);
+        block = __vsf_tlsf_block_absorb(block, next);
+    }
+    return block;
+}
+
+// trim the tail of a free block which will be used
+static void __vsf_tlsf_trim_free(vsf_tlsf_t *tlsf, vsf_tlsf_block_t *block, uintptr_t size)
+{
+    if (__vsf_tlsf_block_can_split(block, size)) {
+        vsf_tlsf_block_t *remaining = __vsf_tlsf_block_split(block, size);
+        __vsf_tlsf_insert_free(tlsf, remaining);
+    }
+}
+
+// trim the tail of a used block, and merge the trimmed part with the next block
+static void __vsf_tlsf_trim_used(vsf_tlsf_t *tlsf, vsf_tlsf_block_t *block, uintptr_t size)
+{
+    if (__vsf_tlsf_block_can_split(block, size)) {
+        vsf_tlsf_block_t *remaining = __vsf_tlsf_block_split(block, size);
+        remaining = __vsf_tlsf_merge_next(tlsf, remaining);
+        __vsf_tlsf_insert_free(tlsf, remaining);
+    }
+}
+
+// trim the head of a free block, the head part is returned to tlsf
+static vsf_tlsf_block_t * __vsf_tlsf_trim_free_leading(vsf_tlsf_t *tlsf, vsf_tlsf_block_t *block, uintptr_t size)
+{
+    vsf_tlsf_block_t *remaining = __vsf_tlsf_block_split(block, size - VSF_TLSF_HEADER_SIZE);
+    remaining->size |= VSF_TLSF_BLOCK_PREV_FREE;
+    __vsf_tlsf_insert_free(tlsf, block);
+    return remaining;
+}
+
+// return 0 if size is too large
+static uintptr_t __vsf_tlsf_adjust_size(uint_fast32_t size)
+{
+    if (size > VSF_TLSF_PAYLOAD_MAX) {
+        return 0;
+    }
+    size = __vsf_tlsf_align_up(size, VSF_TLSF_ALIGN);
+    return max(size, VSF_TLSF_PAYLOAD_MIN);
+}
+
+void vsf_tlsf_init(vsf_tlsf_t *tlsf)
+{
+    VSF_SERVICE_ASSERT(tlsf != NULL);
+    memset(tlsf, 0, sizeof(*tlsf));
+}
+
+void vsf_tlsf_add(vsf_tlsf_t *tlsf, uint8_t *buffer, uint_fast32_t size)
+{
+    vsf_tlsf_block_t *block, *sentinel;
+    uintptr_t unaligned_size, chunk_size;
+
+    VSF_SERVICE_ASSERT((tlsf != NULL) && (buffer != NULL));
+
+    unaligned_size = __vsf_tlsf_align_up(buffer, VSF_TLSF_ALIGN) - (uintptr_t)buffer;
+    if (size <= unaligned_size) {
+        return;
+    }
+    buffer += unaligned_size;
+    size = __vsf_tlsf_align_down(size - unaligned_size, VSF_TLSF_ALIGN);
+
+    // every chunk is a free block followed by a zero-sized used sentinel block,
+    //  so coalescing will never go beyond the chunk
+    while (size >= VSF_TLSF_HEADER_SIZE + VSF_TLSF_PAYLOAD_MIN + VSF_TLSF_HEADER_SIZE) {
+        chunk_size = min(size, VSF_TLSF_PAYLOAD_MAX + 2 * VSF_TLSF_HEADER_SIZE);
+
+        block = (vsf_tlsf_block_t *)buffer;
+        block->prev_phys = NULL;
+        block->size = chunk_size - 2 * VSF_TLSF_HEADER_SIZE;
+        sentinel = __vsf_tlsf_block_next(block);
+        sentinel->size = 0;
+        __vsf_tlsf_block_mark_free(block);
+        __vsf_tlsf_insert_free(tlsf, block);
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+        tlsf->all_size += chunk_size - VSF_TLSF_HEADER_SIZE;
+#endif
+
+        buffer += chunk_size;
+        size -= chunk_size;
+    }
+}
+
+void * vsf_tlsf_malloc_aligned(vsf_tlsf_t *tlsf, uint_fast32_t size, uint_fast32_t alignment)
+{
+    vsf_tlsf_block_t *block;
+    uintptr_t adjusted_size, search_size, gap;
+    uint_fast8_t fl, sl;
+
+    VSF_SERVICE_ASSERT((tlsf != NULL) && !(alignment & (alignment - 1)));
+
+    adjusted_size = __vsf_tlsf_adjust_size(size);
+    if (!adjusted_size) {
+        return NULL;
+    }
+
+    // over-allocate for large alignment, leading gap will be a free block
+    search_size = adjusted_size;
+    if (alignment > VSF_TLSF_ALIGN) {
+        search_size += alignment + sizeof(vsf_tlsf_block_t);
+        if (search_size > VSF_TLSF_PAYLOAD_MAX) {
+            return NULL;
+        }
+    }
+
+    __vsf_tlsf_mapping_search(search_size, &fl, &sl);
+    block = __vsf_tlsf_search_suitable(tlsf, &fl, &sl);
+    if (NULL == block) {
+        return NULL;
+    }
+    VSF_SERVICE_ASSERT(__vsf_tlsf_block_size(block) >= search_size);
+    __vsf_tlsf_remove_free(tlsf, block);
+
+    if (alignment > VSF_TLSF_ALIGN) {
+        uint8_t *payload = __vsf_tlsf_block_payload(block);
+        gap = __vsf_tlsf_align_up(payload, alignment) - (uintptr_t)payload;
+        if (gap != 0) {
+            // leading gap MUST be large enough for a free block
+            if (gap < sizeof(vsf_tlsf_block_t)) {
+                gap = __vsf_tlsf_align_up(payload + sizeof(vsf_tlsf_block_t), alignment)
+                    - (uintptr_t)payload;
+            }
+            block = __vsf_tlsf_trim_free_leading(tlsf, block, gap);
+        }
+    }
+
+    __vsf_tlsf_trim_free(tlsf, block, adjusted_size);
+    __vsf_tlsf_block_mark_used(block);
+    return __vsf_tlsf_block_payload(block);
+}
+
+void vsf_tlsf_free(vsf_tlsf_t *tlsf, void *buffer)
+{
+    vsf_tlsf_block_t *block;
+
+    VSF_SERVICE_ASSERT((tlsf != NULL) && (buffer != NULL));
+    block = __vsf_tlsf_block_from_ptr(buffer);
+    VSF_SERVICE_ASSERT(!__vsf_tlsf_block_is_free(block));
+
+    __vsf_tlsf_block_mark_free(block);
+    block = __vsf_tlsf_merge_prev(tlsf, block);
+    block = __vsf_tlsf_merge_next(tlsf, block);
+    __vsf_tlsf_insert_free(tlsf, block);
+}
+
+void * vsf_tlsf_realloc_aligned(vsf_tlsf_t *tlsf, void *buffer, uint_fast32_t size, uint_fast32_t alignment)
+{
+    vsf_tlsf_block_t *block, *next;
+    uintptr_t adjusted_size, cur_size;
+    void *new_buffer;
+
+    if (NULL == buffer) {
+        return vsf_tlsf_malloc_aligned(tlsf, size, alignment);
+    }
+
+    block = __vsf_tlsf_block_from_ptr(buffer);
+    VSF_SERVICE_ASSERT(!__vsf_tlsf_block_is_free(block));
+    adjusted_size = __vsf_tlsf_adjust_size(size);
+    if (!adjusted_size) {
+        return NULL;
+    }
+
+    // in place only if buffer is the start of the payload and meets the alignment
+    cur_size = __vsf_tlsf_block_size(block);
+    if (    ((uint8_t *)buffer == __vsf_tlsf_block_payload(block))
+        &&  (!alignment || !((uintptr_t)buffer & (alignment - 1)))) {
+        if (adjusted_size > cur_size) {
+            next = __vsf_tlsf_block_next(block);
+            if (    __vsf_tlsf_block_is_free(next)
+                &&  (cur_size + VSF_TLSF_HEADER_SIZE + __vsf_tlsf_block_size(next) >= adjusted_size)) {
+                __vsf_tlsf_remove_free(tlsf, next);
+                __vsf_tlsf_block_absorb(block, next);
+                __vsf_tlsf_block_mark_used(block);
+                cur_size = adjusted_size;
+            }
+        }
+        if (adjusted_size <= cur_size) {
+            __vsf_tlsf_trim_used(tlsf, block, adjusted_size);
+            return buffer;
+        }
+    }
+
+    new_buffer = vsf_tlsf_malloc_aligned(tlsf, size, alignment);
+    if (new_buffer != NULL) {
+        cur_size = vsf_tlsf_get_size(tlsf, buffer);
+        memcpy(new_buffer, buffer, min(cur_size, size));
+        vsf_tlsf_free(tlsf, buffer);
+    }
+    return new_buffer;
+}
+
+//           pos
+// |--------------------------------|
+// |   head   |   free   |   tail   |
+// |--------------------------------|
+//             ___size___
+bool vsf_tlsf_partial_free(vsf_tlsf_t *tlsf, void *buffer, uint_fast32_t pos, uint_fast32_t size)
+{
+    vsf_tlsf_block_t *block, *block_free, *block_tail, *next;
+    uint8_t *payload, *end, *tail;
+
+    VSF_SERVICE_ASSERT((tlsf != NULL) && (buffer != NULL));
+    block = __vsf_tlsf_block_from_ptr(buffer);
+    VSF_SERVICE_ASSERT(     !__vsf_tlsf_block_is_free(block)
+                        &&  (vsf_tlsf_get_size(tlsf, buffer) >= pos + size));
+    payload = __vsf_tlsf_block_payload(block);
+    end = payload + __vsf_tlsf_block_size(block);
+    next = (vsf_tlsf_block_t *)end;
+
+    // header of the freed block is in the freed area
+    if ((uint8_t *)buffer + pos <= payload) {
+        block_free = block;
+    } else {
+        block_free = (vsf_tlsf_block_t *)__vsf_tlsf_align_up((uint8_t *)buffer + pos, VSF_TLSF_ALIGN);
+    }
+    // header of the tail block is just before the aligned tail buffer
+    tail = (uint8_t *)buffer + pos + size;
+    if (tail < end) {
+        block_tail = __vsf_tlsf_block_from_ptr(tail);
+        if ((uint8_t *)block_tail < (uint8_t *)block_free + sizeof(vsf_tlsf_block_t)) {
+            return false;
+        }
+    } else {
+        block_tail = NULL;
+        if (end < (uint8_t *)block_free + sizeof(vsf_tlsf_block_t)) {
+            return false;
+        }
+    }
+
+    if (block_tail != NULL) {
+        block_tail->prev_phys = block_free;
+        block_tail->size = end - __vsf_tlsf_block_payload(block_tail);
+        next->prev_phys = block_tail;
+    }
+    if (block_free != block) {
+        __vsf_tlsf_block_set_size(block, (uint8_t *)block_free - payload);
+        block_free->prev_phys = block;
+        block_free->size = 0;
+    }
+    block_free->size = (block_tail != NULL ? (uint8_t *)block_tail : end)
+        - __vsf_tlsf_block_payload(block_free) + (block_free->size & VSF_TLSF_BLOCK_FLAGS);
+    __vsf_tlsf_block_link_next(block_free);
+
+    vsf_tlsf_free(tlsf, __vsf_tlsf_block_payload(block_free));
+    return true;
+}
+
+uint_fast32_t vsf_tlsf_get_size(vsf_tlsf_t *tlsf, void *buffer)
+{
+    vsf_tlsf_block_t *block = __vsf_tlsf_block_from_ptr(buffer);
+    UNUSED_PARAM(tlsf);
+    return __vsf_tlsf_block_size(block) - ((uint8_t *)buffer - __vsf_tlsf_block_payload(block));
+}
+
+#if VSF_HEAP_CFG_ALGORITHM == VSF_HEAP_CFG_ALGORITHM_TLSF
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+// called in heap protection
+static void __vsf_heap_statistics_update(void *buffer)
+{
+    if (buffer != NULL) {
+        __vsf_heap_statistics.max_used_size = max(__vsf_heap_statistics.max_used_size,
+                    __vsf_heap.all_size - __vsf_heap.free_size);
+        __vsf_heap_statistics.alloc_cnt++;
+    } else {
+        __vsf_heap_statistics.fail_cnt++;
+    }
+}
+#endif
+
+void vsf_heap_init(void)
+{
+    vsf_tlsf_init(&__vsf_heap);
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+    memset(&__vsf_heap_statistics, 0, sizeof(__vsf_heap_statistics));
+#endif
+#if VSF_HEAP_CFG_CACHE == ENABLED
+    __vsf_heap_cache_init();
+#endif
+}
+
+void vsf_heap_add(uint8_t *heap, uint_fast32_t size)
+{
+    vsf_protect_t state = __vsf_heap_protect();
+        vsf_tlsf_add(&__vsf_heap, heap, size);
+    __vsf_heap_unprotect(state);
+}
+
+void vsf_heap_add_memory(vsf_mem_t mem)
+{
+    vsf_heap_add(mem.buffer, (uint_fast32_t)mem.size);
+}
+
+void * vsf_heap_malloc_aligned(uint_fast32_t size, uint_fast32_t alignment)
+{
+    void *buffer;
+    vsf_protect_t state = __vsf_heap_protect();
+        buffer = vsf_tlsf_malloc_aligned(&__vsf_heap, size, alignment);
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+        __vsf_heap_statistics_update(buffer);
+#endif
+    __vsf_heap_unprotect(state);
+    return buffer;
+}
+
+void * vsf_heap_malloc(uint_fast32_t size)
+{
+#if VSF_HEAP_CFG_CACHE == ENABLED
+    return __vsf_heap_cache_malloc(size);
+#else
+    return vsf_heap_malloc_aligned(size, 0);
+#endif
+}
+
+void * vsf_heap_realloc_aligned(void *buffer, uint_fast32_t size, uint_fast32_t alignment)
+{
+    vsf_protect_t state = __vsf_heap_protect();
+        buffer = vsf_tlsf_realloc_aligned(&__vsf_heap, buffer, size, alignment);
+    __vsf_heap_unprotect(state);
+    return buffer;
+}
+
+void * vsf_heap_realloc(void *buffer, uint_fast32_t size)
+{
+    return vsf_heap_realloc_aligned(buffer, size, sizeof(uintalu_t));
+}
+
+// free to heap bypassing cache
+void __vsf_heap_free(void *buffer)
+{
+    vsf_protect_t state = __vsf_heap_protect();
+        vsf_tlsf_free(&__vsf_heap, buffer);
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+        __vsf_heap_statistics.free_cnt++;
+#endif
+    __vsf_heap_unprotect(state);
+}
+
+void vsf_heap_free(void *buffer)
+{
+#if VSF_HEAP_CFG_CACHE == ENABLED
+    if (__vsf_heap_cache_free(buffer)) {
+        return;
+    }
+#endif
+    __vsf_heap_free(buffer);
+}
+
+uint_fast32_t vsf_heap_size(void *buffer)
+{
+    return vsf_tlsf_get_size(&__vsf_heap, buffer);
+}
+
+bool vsf_heap_partial_free(void *buffer, uint_fast32_t pos, uint_fast32_t size)
+{
+    bool result;
+    vsf_protect_t state = __vsf_heap_protect();
+        result = vsf_tlsf_partial_free(&__vsf_heap, buffer, pos, size);
+    __vsf_heap_unprotect(state);
+    return result;
+}
+
+#   if VSF_HEAP_CFG_STATISTICS == ENABLED
+void vsf_heap_walk(vsf_heap_walker_t *walker, void *param)
+{
+    vsf_heap_block_info_t info = { 0 };
+    vsf_tlsf_block_t *block;
+
+    VSF_SERVICE_ASSERT(walker != NULL);
+    vsf_protect_t state = __vsf_heap_protect();
+        for (uint_fast8_t fl = 0; fl < VSF_TLSF_FL_COUNT; fl++) {
+            info.freelist = fl;
+            for (uint_fast8_t sl = 0; sl < VSF_TLSF_SL_COUNT; sl++) {
+                for (block = __vsf_heap.blocks[fl][sl]; block != NULL; block = block->next_free) {
+                    info.buffer = __vsf_tlsf_block_payload(block);
+                    info.size = __vsf_tlsf_block_size(block) + VSF_TLSF_HEADER_SIZE;
+                    if (!walker(param, &info)) {
+                        goto end;
+                    }
+                }
+            }
+        }
+end:
+    __vsf_heap_unprotect(state);
+}
+
+static bool __vsf_heap_statistics_walker(void *param, vsf_heap_block_info_t *info)
+{
+    vsf_heap_statistics_t *statistics = param;
+    statistics->largest_free_size = max(statistics->largest_free_size, info->size);
+    statistics->free_num++;
+    return true;
+}
+
+void vsf_heap_statistics(vsf_heap_statistics_t *statistics)
+{
+    uint_fast32_t free_size;
+
+    VSF_SERVICE_ASSERT(statistics != NULL);
+    memset(statistics, 0, sizeof(*statistics));
+    vsf_heap_walk(__vsf_heap_statistics_walker, statistics);
+
+    vsf_protect_t state = __vsf_heap_protect();
+        free_size = __vsf_heap.free_size;
+        statistics->all_size = __vsf_heap.all_size;
+        statistics->used_size = __vsf_heap.all_size - free_size;
+        statistics->max_used_size = __vsf_heap_statistics.max_used_size;
+        statistics->alloc_cnt = __vsf_heap_statistics.alloc_cnt;
+        statistics->free_cnt = __vsf_heap_statistics.free_cnt;
+        statistics->fail_cnt = __vsf_heap_statistics.fail_cnt;
+    __vsf_heap_unprotect(state);
+
+    if (free_size > 0) {
+        statistics->fragmentation = 100 - (uint8_t)((uint64_t)statistics->largest_free_size * 100 / free_size);
+    }
+}
+
+// freelists of tlsf are the first level classes
+bool vsf_heap_freelist_statistics(uint_fast8_t freelist, vsf_heap_freelist_statistics_t *statistics)
+{
+    vsf_tlsf_block_t *block;
+
+    VSF_SERVICE_ASSERT(statistics != NULL);
+    if (freelist >= VSF_TLSF_FL_COUNT) {
+        return false;
+    }
+
+    memset(statistics, 0, sizeof(*statistics));
+    vsf_protect_t state = __vsf_heap_protect();
+        for (uint_fast8_t sl = 0; sl < VSF_TLSF_SL_COUNT; sl++) {
+            for (block = __vsf_heap.blocks[freelist][sl]; block != NULL; block = block->next_free) {
+                statistics->free_size += __vsf_tlsf_block_size(block) + VSF_TLSF_HEADER_SIZE;
+                statistics->free_num++;
+            }
+        }
+    __vsf_heap_unprotect(state);
+    return true;
+}
+#   endif
+#endif
+
+#if __IS_COMPILER_LLVM__ || __IS_COMPILER_ARM_COMPILER_6__
+#   pragma clang diagnostic pop
+#endif
+
+#if __IS_COMPILER_GCC__
+#   pragma GCC diagnostic pop
+#endif
+
+#endif      // VSF_USE_HEAP
@@ -0,0 +1,116 @@
+/*****************************************************************************
+ *   Copyright(C)2009-2019 by VSF Team                                       *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the "License");          *
+ *  you may not use this file except in compliance with the License.         *
+ *  You may obtain a copy of the License at                                  *
+ *                                                                           *
+ *     http://www.apache.org/licenses/LICENSE-2.0                            *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an "AS IS" BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef __VSF_TLSF_H__
+#define __VSF_TLSF_H__
+
+/*============================ INCLUDES ======================================*/
+#include "service/vsf_service_cfg.h"
+#include "utilities/vsf_utilities.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*============================ MACROS ========================================*/
+
+/*! \note   TLSF(Two-Level Segregated Fit) allocator
+ *!         free blocks are segregated by size into first level classes of power
+ *!         of 2, and every first level class is divided linearly into
+ *!         (1 << VSF_HEAP_CFG_TLSF_SL_BITS) second level classes. Two levels of
+ *!         bitmaps index the non-empty classes, so malloc, free and coalescing
+ *!         are all O(1) with bounded fragmentation.
+ *!
+ *!         vsf_tlsf_t is not protected, caller should serialize the access.
+ */
+
+#ifndef VSF_HEAP_CFG_TLSF_SL_BITS
+#   define VSF_HEAP_CFG_TLSF_SL_BITS        4
+#endif
+#if VSF_HEAP_CFG_TLSF_SL_BITS > 5
+#   error VSF_HEAP_CFG_TLSF_SL_BITS MUST be <= 5
+#endif
+
+// max block size is (1 << VSF_HEAP_CFG_TLSF_FL_MAX_BIT) - 1
+#ifndef VSF_HEAP_CFG_TLSF_FL_MAX_BIT
+#   define VSF_HEAP_CFG_TLSF_FL_MAX_BIT     28
+#endif
+
+#define VSF_TLSF_SL_COUNT                   (1 << VSF_HEAP_CFG_TLSF_SL_BITS)
+// block header is 2 pointers, which is also the alignment of payload
+#if UINTPTR_MAX > 0xFFFFFFFF
+#   define VSF_TLSF_ALIGN_BITS              4
+#else
+#   define VSF_TLSF_ALIGN_BITS              3
+#endif
+#define VSF_TLSF_ALIGN                      (1 << VSF_TLSF_ALIGN_BITS)
+// blocks smaller than (1 << VSF_TLSF_FL_SHIFT) are linearly mapped in fl 0
+#define VSF_TLSF_FL_SHIFT                   (VSF_HEAP_CFG_TLSF_SL_BITS + VSF_TLSF_ALIGN_BITS)
+#define VSF_TLSF_FL_COUNT                   (VSF_HEAP_CFG_TLSF_FL_MAX_BIT - VSF_TLSF_FL_SHIFT + 1)
+
+#if VSF_TLSF_FL_COUNT > 32
+#   error VSF_HEAP_CFG_TLSF_FL_MAX_BIT is too large
+#endif
+
+/*============================ MACROFIED FUNCTIONS ===========================*/
+/*============================ TYPES =========================================*/
+
+typedef struct vsf_tlsf_block_t vsf_tlsf_block_t;
+struct vsf_tlsf_block_t {
+    // previous physical block, NULL for the first block in a region
+    vsf_tlsf_block_t *prev_phys;
+    // payload size, bit0: block is free, bit1: previous physical block is free
+    uintptr_t size;
+
+    // valid only if the block is free, overlapped with the payload
+    vsf_tlsf_block_t *next_free;
+    vsf_tlsf_block_t *prev_free;
+};
+
+typedef struct vsf_tlsf_t {
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[VSF_TLSF_FL_COUNT];
+    vsf_tlsf_block_t *blocks[VSF_TLSF_FL_COUNT][VSF_TLSF_SL_COUNT];
+#if VSF_HEAP_CFG_STATISTICS == ENABLED
+    // sizes include block headers
+    uint32_t all_size;
+    uint32_t free_size;
+#endif
+} vsf_tlsf_t;
+
+/*============================ GLOBAL VARIABLES ==============================*/
+/*============================ PROTOTYPES ====================================*/
+
+extern void vsf_tlsf_init(vsf_tlsf_t *tlsf);
+/*! \brief add a memory region to tlsf, regions need not to be contiguous,
+ *!        and are never merged with each other
+ */
+extern void vsf_tlsf_add(vsf_tlsf_t *tlsf, uint8_t *buffer, uint_fast32_t size);
+//! \note alignment can be 0, or a power of 2
+extern void * vsf_tlsf_malloc_aligned(vsf_tlsf_t *tlsf, uint_fast32_t size, uint_fast32_t alignment);
+//! \note buffer can be NULL, in which case it's the same as malloc
+extern void * vsf_tlsf_realloc_aligned(vsf_tlsf_t *tlsf, void *buffer, uint_fast32_t size, uint_fast32_t alignment);
+extern void vsf_tlsf_free(vsf_tlsf_t *tlsf, void *buffer);
+//! \brief same as vsf_heap_partial_free, tail part is returned as a new buffer
+extern bool vsf_tlsf_partial_free(vsf_tlsf_t *tlsf, void *buffer, uint_fast32_t pos, uint_fast32_t size);
+//! \brief get usable size of an allocated buffer
+extern uint_fast32_t vsf_tlsf_get_size(vsf_tlsf_t *tlsf, void *buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif      // __VSF_TLSF_H__
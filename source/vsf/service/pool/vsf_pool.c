@@ -58,7 +58,35 @@
 #   define VSF_POOL_CFG_SUPPORT_USER_ITEM_INIT      ENABLED
 #endif
 
+#if VSF_POOL_CFG_LOCK_FREE == ENABLED
+#   if !__IS_COMPILER_SUPPORT_GNUC_EXTENSION__
+#       error "VSF_POOL_CFG_LOCK_FREE depends on gnu __atomic builtins"
+#   endif
+// tag is saved in the bits of the lock_free_head not used by pointer,
+//  user space pointers of 64-bit platforms are no more than 48-bit.
+#   if UINTPTR_MAX > 0xFFFFFFFF
+#       define __VSF_POOL_TAG_SHIFT         48
+#   else
+#       if !defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+#           error "VSF_POOL_CFG_LOCK_FREE depends on 64-bit CAS"
+#       endif
+#       define __VSF_POOL_TAG_SHIFT         32
+#   endif
+#endif
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
+
+#if VSF_POOL_CFG_LOCK_FREE == ENABLED
+#   define __vsf_pool_tagged_ptr(__tagged)                                      \
+            ((__vsf_pool_node_t *)(uintptr_t)((__tagged) & (((uint64_t)1 << __VSF_POOL_TAG_SHIFT) - 1)))
+#   define __vsf_pool_tagged_tag(__tagged)                                      \
+            ((__tagged) >> __VSF_POOL_TAG_SHIFT)
+#   define __vsf_pool_tagged(__ptr, __tag)                                      \
+            ((uint64_t)(uintptr_t)(__ptr) | ((uint64_t)(__tag) << __VSF_POOL_TAG_SHIFT))
+
+#   define __vsf_pool_atomic_inc(__ptr)     __atomic_add_fetch((__ptr), 1, __ATOMIC_RELAXED)
+#   define __vsf_pool_atomic_dec(__ptr)     __atomic_sub_fetch((__ptr), 1, __ATOMIC_RELAXED)
+#endif
 /*============================ TYPES =========================================*/
 //! \name protected class __vsf_pool_node_t
 //! @{
@@ -178,6 +206,66 @@ void vsf_pool_init( vsf_pool_t *obj_ptr,
     vsf_slist_init(&this.free_list);
 }
 
+#if VSF_POOL_CFG_LOCK_FREE == ENABLED
+/*! \brief initialise target pool as lock-free pool
+ *! \param this_ptr address of the target pool
+ *! \param cfg_ptr configurations
+ *! \return none
+ */
+void vsf_pool_init_lock_free(   vsf_pool_t *obj_ptr,
+                                uint32_t item_size,
+                                uint_fast16_t align,
+                                vsf_pool_cfg_t *cfg_ptr)
+{
+    class_internal(obj_ptr, this_ptr, vsf_pool_t);
+
+    vsf_pool_init(obj_ptr, item_size, align, cfg_ptr);
+    this.lock_free_head = __vsf_pool_tagged(NULL, 0);
+    this.is_lock_free = true;
+}
+
+static __vsf_pool_node_t * __vsf_pool_lock_free_pop(vsf_pool_t *obj_ptr)
+{
+    class_internal(obj_ptr, this_ptr, vsf_pool_t);
+    uint64_t head = __atomic_load_n(&this.lock_free_head, __ATOMIC_ACQUIRE), next;
+    __vsf_pool_node_t *node_ptr;
+
+    do {
+        node_ptr = __vsf_pool_tagged_ptr(head);
+        if (NULL == node_ptr) {
+            return NULL;
+        }
+        // node_ptr maybe popped and modified by others here, but the memory
+        //  is still valid because items are never released by the pool, and
+        //  the tag increased by every pop will fail the CAS.
+        next = __vsf_pool_tagged(
+                    __atomic_load_n(&node_ptr->node.next, __ATOMIC_RELAXED),
+                    __vsf_pool_tagged_tag(head) + 1);
+    } while (!__atomic_compare_exchange_n(&this.lock_free_head, &head, next,
+                    true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    __vsf_pool_atomic_dec(&this.free_cnt);
+    return node_ptr;
+}
+
+static void __vsf_pool_lock_free_push(vsf_pool_t *obj_ptr, __vsf_pool_node_t *node_ptr)
+{
+    class_internal(obj_ptr, this_ptr, vsf_pool_t);
+    uint64_t head = __atomic_load_n(&this.lock_free_head, __ATOMIC_RELAXED), next;
+
+    // pointer bits used by tag MUST be zero
+    VSF_SERVICE_ASSERT(__vsf_pool_tagged_ptr(__vsf_pool_tagged(node_ptr, 0)) == node_ptr);
+
+    do {
+        __atomic_store_n(&node_ptr->node.next, (void *)__vsf_pool_tagged_ptr(head), __ATOMIC_RELAXED);
+        next = __vsf_pool_tagged(node_ptr, __vsf_pool_tagged_tag(head));
+    } while (!__atomic_compare_exchange_n(&this.lock_free_head, &head, next,
+                    true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    __vsf_pool_atomic_inc(&this.free_cnt);
+}
+#endif
+
 /*! \brief add memory to pool
  *! \param this_ptr       address of the target pool
  *! \param buffer_ptr      address of the target memory
@@ -245,6 +333,31 @@ extern int posix_memalign(  void ** /*ret*/,
 }
 #endif
 
+#if VSF_POOL_CFG_FEED_ON_HEAP == ENABLED
+static __vsf_pool_node_t * __vsf_pool_feed_on_heap(vsf_pool_t *obj_ptr)
+{
+    __vsf_pool_node_t *node_ptr;
+    class_internal(obj_ptr, this_ptr, vsf_pool_t);
+
+    do {
+        node_ptr = (__vsf_pool_node_t *)vsf_heap_malloc_aligned(this.statistic.item_size, this.statistic.u15_align);
+        if (NULL != node_ptr) {
+        #if VSF_POOL_CFG_SUPPORT_USER_OBJECT == ENABLED
+            if (this.item_init_fn != NULL) {
+                (*(this.item_init_fn))(this.target_ptr, (uintptr_t)node_ptr, this.statistic.item_size);
+            }
+        #else
+            if (this.item_init_fn != NULL) {
+                (*(this.item_init_fn))(NULL, (uintptr_t)node_ptr, this.item_size);
+            }
+        #endif
+            break;
+        }
+    } while (vsf_plug_in_on_failed_to_feed_pool_on_heap(obj_ptr));
+    return node_ptr;
+}
+#endif
+
 /*! \brief try to fetch a memory block from the target pool
  *! \param this_ptr    address of the target pool
  *! \retval NULL    the pool is empty
@@ -258,6 +371,26 @@ uintptr_t vsf_pool_alloc(vsf_pool_t *obj_ptr)
 
     VSF_SERVICE_ASSERT(this_ptr != NULL);
 
+#if VSF_POOL_CFG_LOCK_FREE == ENABLED
+    if (this.is_lock_free) {
+        node_ptr = __vsf_pool_lock_free_pop(obj_ptr);
+        if (NULL != node_ptr) {
+    #if VSF_POOL_CFG_STATISTIC_MODE == ENABLED
+            __vsf_pool_atomic_inc(&this.used_cnt);
+    #endif
+        }
+    #if VSF_POOL_CFG_FEED_ON_HEAP == ENABLED
+        else if (!this.statistic.is_no_feed_on_heap) {
+            node_ptr = __vsf_pool_feed_on_heap(obj_ptr);
+            if (node_ptr != NULL) {
+                __vsf_pool_atomic_inc(&this.used_cnt);
+            }
+        }
+    #endif
+        return (uintptr_t)node_ptr;
+    }
+#endif
+
     VSF_POOL_LOCK();
         /* verify it again for safe */
         if (!vsf_slist_is_empty(&this.free_list)) {
@@ -272,25 +405,10 @@ uintptr_t vsf_pool_alloc(vsf_pool_t *obj_ptr)
         }
 #if VSF_POOL_CFG_FEED_ON_HEAP == ENABLED
         else if (!this.statistic.is_no_feed_on_heap) {
-            bool retry = false;
-            do {
-                //! feed on heap
-                node_ptr = (__vsf_pool_node_t *)vsf_heap_malloc_aligned(this.statistic.item_size, this.statistic.u15_align);
-                if (NULL != node_ptr) {
-                #if VSF_POOL_CFG_SUPPORT_USER_OBJECT == ENABLED
-                    if (this.item_init_fn != NULL) {
-                        (*(this.item_init_fn))(this.target_ptr, (uintptr_t)node_ptr, this.statistic.item_size);
-                    }
-                #else
-                    if (this.item_init_fn != NULL) {
-                        (*(this.item_init_fn))(NULL, (uintptr_t)node_ptr, this.item_size);
-                    }
-                #endif
-                    this.used_cnt++;
-                } else {
-                    retry = vsf_plug_in_on_failed_to_feed_pool_on_heap(obj_ptr);
-                }
-            } while(retry);
+            node_ptr = __vsf_pool_feed_on_heap(obj_ptr);
+            if (node_ptr != NULL) {
+                this.used_cnt++;
+            }
         }
 #endif
     VSF_POOL_UNLOCK();
@@ -303,6 +421,12 @@ static void __vsf_pool_add_item(vsf_pool_t *obj_ptr, uintptr_t pitem)
     __vsf_pool_node_t *node_ptr = (__vsf_pool_node_t *)pitem;
     class_internal(obj_ptr, this_ptr, vsf_pool_t);
 
+#if VSF_POOL_CFG_LOCK_FREE == ENABLED
+    if (this.is_lock_free) {
+        __vsf_pool_lock_free_push(obj_ptr, node_ptr);
+        return;
+    }
+#endif
 
     VSF_POOL_LOCK();
         vsf_slist_stack_push(__vsf_pool_node_t, node, &this.free_list, node_ptr);
@@ -376,6 +500,14 @@ void vsf_pool_free(vsf_pool_t *obj_ptr, uintptr_t pItem)
     class_internal(obj_ptr, this_ptr, vsf_pool_t);
     VSF_SERVICE_ASSERT((obj_ptr != NULL) && (pItem != 0));
 
+#if VSF_POOL_CFG_LOCK_FREE == ENABLED
+    if (this.is_lock_free) {
+        __vsf_pool_lock_free_push(obj_ptr, (__vsf_pool_node_t *)pItem);
+        __vsf_pool_atomic_dec(&this.used_cnt);
+        return;
+    }
+#endif
+
     VSF_POOL_LOCK();
         __vsf_pool_add_item(obj_ptr, (uintptr_t)pItem);
         this.used_cnt--;
@@ -37,6 +37,11 @@
     // 4. Implement the pool
     imp_vsf_pool(xxxx_pool, xxxx_t)
 
+    //    or implement a lock-free pool if it's accessed from different
+    //    priorities or cores frequently(VSF_POOL_CFG_LOCK_FREE is needed)
+
+    //    imp_vsf_pool_lock_free(xxxx_pool, xxxx_t)
+
     // 5. Defining pool variable
     static NO_INIT vsf_pool(xxxx_pool) __xxxx_pool;
 
@@ -119,6 +124,23 @@ extern "C" {
 #   define VSF_POOL_CFG_SUPPORT_USER_OBJECT ENABLED
 #endif
 
+/*! \note support lock-free pools implemented by implement_vsf_pool_lock_free,
+ *!       free list of lock-free pools is a treiber stack with ABA tag, and
+ *!       code region is not used in alloc/free. GNU __atomic builtins are
+ *!       needed, 64-bit CAS is needed for 32-bit platforms.
+ *!       If disabled, implement_vsf_pool_lock_free is the same as
+ *!       implement_vsf_pool.
+ */
+#ifndef VSF_POOL_CFG_LOCK_FREE
+#   define VSF_POOL_CFG_LOCK_FREE           DISABLED
+#endif
+
+#if VSF_POOL_CFG_LOCK_FREE == ENABLED
+#   define __vsf_pool_lock_free_init        vsf_pool_init_lock_free
+#else
+#   define __vsf_pool_lock_free_init        vsf_pool_init
+#endif
+
 #define __vsf_pool(__name)          __name##_pool_t
 #define __vsf_pool_item(__name)     __name##_pool_item_t
 
@@ -185,11 +207,11 @@ extern "C" {
     __define_vsf_pool_tag(__name)
 
 
-#define __implement_vsf_pool(__name, __type)                                    \
+#define __implement_vsf_pool_ex(__name, __type, __init)                         \
 WEAK(__name##_pool_init)                                                        \
 void __name##_pool_init(vsf_pool(__name) *this_ptr, vsf_pool_cfg_t *cfg_ptr)    \
 {                                                                               \
-    vsf_pool_init(  &(this_ptr->use_as__vsf_pool_t),                            \
+    __init(         &(this_ptr->use_as__vsf_pool_t),                            \
                     sizeof(__type),                                             \
                     __alignof__(__type),                                        \
                     cfg_ptr);                                                   \
@@ -198,7 +220,7 @@ void __name##_pool_init_ex( vsf_pool(__name) *this_ptr,
                             uint_fast16_t align,                                \
                             vsf_pool_cfg_t *cfg_ptr)                            \
 {                                                                               \
-    vsf_pool_init(  &(this_ptr->use_as__vsf_pool_t),                            \
+    __init(         &(this_ptr->use_as__vsf_pool_t),                            \
                     sizeof(__type),                                             \
                     max(align,__alignof__(__type)),                             \
                     cfg_ptr);                                                   \
@@ -248,6 +270,12 @@ code_region_t *__name##_pool_get_region(vsf_pool(__name) *this_ptr)
 }                                                                               \
 __implement_vsf_pool_tag(__name)
 
+#define __implement_vsf_pool(__name, __type)                                    \
+            __implement_vsf_pool_ex(__name, __type, vsf_pool_init)
+
+#define __implement_vsf_pool_lock_free(__name, __type)                          \
+            __implement_vsf_pool_ex(__name, __type, __vsf_pool_lock_free_init)
+
 
 
 
@@ -281,6 +309,16 @@ __implement_vsf_pool_tag(__name)
                      __type)            /* the type of the unit */              \
             implement_vsf_pool(__name, __type)
 
+#define implement_vsf_pool_lock_free(                                           \
+                     __name,            /* the name of the pool */              \
+                     __type)            /* the type of the unit */              \
+            __implement_vsf_pool_lock_free(__name, __type)
+
+#define imp_vsf_pool_lock_free(                                                 \
+                     __name,            /* the name of the pool */              \
+                     __type)            /* the type of the unit */              \
+            implement_vsf_pool_lock_free(__name, __type)
+
 #if !defined(__STDC_VERSION__) || __STDC_VERSION__ < 199901L
 #define VSF_POOL_INIT(__NAME,       /* the name of the pool */                  \
                       __VSF_POOL,   /* the address of the pool */               \
@@ -498,6 +536,14 @@ def_class(vsf_pool_t,
         uint16_t used_cnt;
     )
 
+#if VSF_POOL_CFG_LOCK_FREE == ENABLED
+    private_member(
+        /*! free list of lock-free pool, tagged pointer of the first block */
+        uint64_t lock_free_head ALIGN(8);
+        bool is_lock_free;
+    )
+#endif
+
 #if     VSF_POOL_CFG_STATISTIC_MODE == ENABLED                                  \
     ||  VSF_POOL_CFG_FEED_ON_HEAP   == ENABLED
     private_member(
@@ -585,6 +631,20 @@ extern void vsf_pool_init(  vsf_pool_t *obj_ptr,
                             uint_fast16_t align,
                             vsf_pool_cfg_t *cfg_ptr);
 
+#if VSF_POOL_CFG_LOCK_FREE == ENABLED
+/*! \brief initialise target pool as lock-free pool
+ *! \param obj_ptr address of the target pool
+ *! \param item_size memory item size
+ *! \param align Item Alignment
+ *! \param cfg_ptr configurations, region_ptr is not used in alloc/free
+ *! \return none
+ */
+extern void vsf_pool_init_lock_free(vsf_pool_t *obj_ptr,
+                                    uint32_t item_size,
+                                    uint_fast16_t align,
+                                    vsf_pool_cfg_t *cfg_ptr);
+#endif
+
 /*! \brief add memory to pool
  *! \param obj_ptr             address of the target pool
  *! \param buffer_ptr          address of the target memory
@@ -18,6 +18,9 @@ extern "C" {
 #define O_TRUNC         0x0400
 #define O_EXCL          0x0800
 
+#define F_DUPFD         0
+#define F_DUPFD_CLOEXEC 1030
+
 int fcntl(int fd, int cmd, ...);
 
 #ifdef __cplusplus
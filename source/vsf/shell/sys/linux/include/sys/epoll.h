@@ -0,0 +1,60 @@
+#ifndef __EPOLL_H__
+#define __EPOLL_H__
+
+#include "shell/sys/linux/vsf_linux_cfg.h"
+
+#if VSF_LINUX_CFG_RELATIVE_PATH == ENABLED
+#   include "../signal.h"
+#else
+#   include <signal.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define epoll_create            __vsf_linux_epoll_create
+#define epoll_create1           __vsf_linux_epoll_create1
+#define epoll_ctl               __vsf_linux_epoll_ctl
+#define epoll_wait              __vsf_linux_epoll_wait
+#define epoll_pwait             __vsf_linux_epoll_pwait
+
+#define EPOLL_CLOEXEC           (1 << 19)
+
+#define EPOLL_CTL_ADD           1
+#define EPOLL_CTL_DEL           2
+#define EPOLL_CTL_MOD           3
+
+#define EPOLLIN                 0x00000001
+#define EPOLLPRI                0x00000002
+#define EPOLLOUT                0x00000004
+#define EPOLLERR                0x00000008
+#define EPOLLHUP                0x00000010
+#define EPOLLRDHUP              0x00002000
+#define EPOLLONESHOT            0x40000000
+#define EPOLLET                 0x80000000
+
+typedef union epoll_data {
+    void *ptr;
+    int fd;
+    uint32_t u32;
+    uint64_t u64;
+} epoll_data_t;
+
+struct epoll_event {
+    uint32_t events;
+    epoll_data_t data;
+};
+
+int epoll_create(int size);
+int epoll_create1(int flags);
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event *event);
+int epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout);
+int epoll_pwait(int epfd, struct epoll_event *events, int maxevents, int timeout,
+                const sigset_t *sigmask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -18,7 +18,15 @@ extern "C" {
 #endif
 
 #ifndef __WIN__
-__vsf_declare_bitmap_ex(fd_set, 1024)
+#define FD_SETSIZE              1024
+
+#define FD_ZERO(__set)          vsf_bitmap_reset((__set), FD_SETSIZE)
+#define FD_SET(__fd, __set)     vsf_bitmap_set((__set), (__fd))
+#define FD_CLR(__fd, __set)     vsf_bitmap_clear((__set), (__fd))
+#define FD_ISSET(__fd, __set)                                                   \
+            (!!((*(__set))[(__fd) / __optimal_bit_sz] & ((uintalu_t)1 << ((__fd) & __optimal_bit_msk))))
+
+__vsf_declare_bitmap_ex(fd_set, FD_SETSIZE)
 int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *execeptfds, struct timeval *timeout);
 #endif
 
@@ -40,6 +40,8 @@ extern "C" {
 #   define remove           __vsf_linux_remove
 #   define mkdir            __vsf_linux_mkdir
 #   define close            __vsf_linux_close
+#   define dup              __vsf_linux_dup
+#   define dup2             __vsf_linux_dup2
 #   define lseek            __vsf_linux_lseek
 #   define read             __vsf_linux_read
 #   define write            __vsf_linux_write
@@ -87,6 +89,8 @@ int remove(const char *pathname);
 int mkdir(const char* pathname, mode_t mode);
 
 int close(int fd);
+int dup(int oldfd);
+int dup2(int oldfd, int newfd);
 off_t lseek(int fd, off_t offset, int whence);
 ssize_t read(int fd, void *buf, size_t count);
 ssize_t write(int fd, void *buf, size_t count);
@@ -33,6 +33,7 @@
 #   include "./include/poll.h"
 #   include "./include/sys/stat.h"
 #   include "./include/sys/select.h"
+#   include "./include/sys/epoll.h"
 #   include "./include/sys/wait.h"
 #   include "./include/sys/mount.h"
 #   include "./include/fcntl.h"
@@ -45,6 +46,7 @@
 #   include <poll.h>
 #   include <sys/stat.h>
 #   include <sys/select.h>
+#   include <sys/epoll.h>
 #   include <sys/wait.h>
 #   include <sys/mount.h>
 #   include <fcntl.h>
@@ -96,6 +98,13 @@
 #   define VSF_LINUX_CFG_PRIO_HIGHEST       vsf_prio_0
 #endif
 
+#if VSF_LINUX_CFG_FD_SLAB_NUM > 0
+#   define __VSF_LINUX_FD_SLAB_HEAD_SIZE                                        \
+            ((sizeof(vsf_linux_fd_slab_node_t) + 7) & ~7)
+#   define __VSF_LINUX_FD_SLAB_OBJ_SIZE                                         \
+            ((sizeof(vsf_linux_fd_t) + VSF_LINUX_CFG_FD_SLAB_PRIV_SIZE + 7) & ~7)
+#endif
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 /*============================ TYPES =========================================*/
 
@@ -118,6 +127,46 @@ typedef struct vsf_linux_stream_priv_t {
     vsf_stream_t *stream;
 } vsf_linux_stream_priv_t;
 
+// node of slab list and fd object free list
+typedef struct vsf_linux_fd_slab_node_t {
+    vsf_slist_node_t node;
+} vsf_linux_fd_slab_node_t;
+
+typedef struct vsf_linux_epoll_priv_t {
+    vsf_dlist_t item_list;
+    // items with pending events, so that epoll_wait is O(ready)
+    vsf_dlist_t ready_list;
+    // threads in epoll_wait
+    vsf_dlist_t wait_list;
+} vsf_linux_epoll_priv_t;
+
+// waiter of poll on a fd, or of epoll_wait on an epoll instance
+typedef struct vsf_linux_fd_waiter_t {
+    vsf_dlist_node_t node;
+    vsf_linux_fd_t *sfd;
+    vsf_trig_t *trig;
+    // epoll events to wait for
+    uint32_t events;
+} vsf_linux_fd_waiter_t;
+
+typedef struct vsf_linux_epoll_item_t {
+    vsf_dlist_node_t fd_node;
+    vsf_dlist_node_t item_node;
+    vsf_dlist_node_t ready_node;
+    vsf_linux_epoll_priv_t *epoll;
+    vsf_linux_fd_t *sfd;
+    // events triggered but not reported yet
+    uint32_t revents;
+    struct epoll_event event;
+} vsf_linux_epoll_item_t;
+
+typedef struct vsf_linux_timeout_t {
+    int_fast32_t tick;
+#if VSF_KERNEL_CFG_EDA_SUPPORT_TIMER == ENABLED
+    vsf_systimer_cnt_t deadline;
+#endif
+} vsf_linux_timeout_t;
+
 /*============================ GLOBAL VARIABLES ==============================*/
 
 int errno;
@@ -140,6 +189,13 @@ static ssize_t __vsf_linux_stream_read(vsf_linux_fd_t *sfd, void *buf, size_t co
 static ssize_t __vsf_linux_stream_write(vsf_linux_fd_t *sfd, void *buf, size_t count);
 static int __vsf_linux_stream_close(vsf_linux_fd_t *sfd);
 
+static int __vsf_linux_epoll_fcntl(vsf_linux_fd_t *sfd, int cmd, long arg);
+static ssize_t __vsf_linux_epoll_read(vsf_linux_fd_t *sfd, void *buf, size_t count);
+static ssize_t __vsf_linux_epoll_write(vsf_linux_fd_t *sfd, void *buf, size_t count);
+static int __vsf_linux_epoll_close(vsf_linux_fd_t *sfd);
+static void __vsf_linux_epoll_remove(vsf_linux_epoll_item_t *item);
+static void __vsf_linux_fd_table_fini(vsf_linux_process_t *process);
+
 static vsf_linux_process_t * __vsf_linux_start_process_internal(int stack_size,
         vsf_linux_main_entry_t entry, vsf_prio_t prio);
 
@@ -169,6 +225,14 @@ static const vsf_linux_fd_op_t __vsf_linux_stream_fdop = {
     .fn_close           = __vsf_linux_stream_close,
 };
 
+static const vsf_linux_fd_op_t __vsf_linux_epoll_fdop = {
+    .priv_size          = sizeof(vsf_linux_epoll_priv_t),
+    .fn_fcntl           = __vsf_linux_epoll_fcntl,
+    .fn_read            = __vsf_linux_epoll_read,
+    .fn_write           = __vsf_linux_epoll_write,
+    .fn_close           = __vsf_linux_epoll_close,
+};
+
 /*============================ IMPLEMENTATION ================================*/
 
 #ifndef WEAK_VSF_LINUX_CREATE_FHS
@@ -422,12 +486,11 @@ static void __vsf_linux_main_on_run(vsf_thread_cb_t *cb)
     thread->retval = ctx->entry(ctx->arg.argc, (char **)ctx->arg.argv);
 
     // clean up
-    do {
-        vsf_dlist_peek_head(vsf_linux_fd_t, fd_node, &process->fd_list, sfd);
-        if (sfd != NULL) {
-            close(sfd->fd);
+    for (int fd = 0; fd < process->fd_table_size; fd++) {
+        if (vsf_linux_get_fd(fd) != NULL) {
+            close(fd);
         }
-    } while (sfd != NULL);
+    }
 }
 
 void vsf_linux_thread_on_terminate(vsf_linux_thread_t *thread)
@@ -453,6 +516,7 @@ void vsf_linux_thread_on_terminate(vsf_linux_thread_t *thread)
         if (process->thread_pending != NULL) {
             vsf_eda_post_evt(&process->thread_pending->use_as__vsf_eda_t, VSF_EVT_USER);
         }
+        __vsf_linux_fd_table_fini(process);
         free(process);
     }
 }
@@ -734,37 +798,230 @@ static int __vsf_linux_stream_close(vsf_linux_fd_t *sfd)
     return 0;
 }
 
-vsf_linux_fd_t * vsf_linux_get_fd(int fd)
+static int __vsf_linux_epoll_fcntl(vsf_linux_fd_t *sfd, int cmd, long arg)
+{
+    return 0;
+}
+
+static ssize_t __vsf_linux_epoll_read(vsf_linux_fd_t *sfd, void *buf, size_t count)
+{
+    errno = EINVAL;
+    return -1;
+}
+
+static ssize_t __vsf_linux_epoll_write(vsf_linux_fd_t *sfd, void *buf, size_t count)
+{
+    errno = EINVAL;
+    return -1;
+}
+
+static int __vsf_linux_epoll_close(vsf_linux_fd_t *sfd)
 {
-    vsf_dlist_t *fd_list = &vsf_linux_get_cur_process()->fd_list;
+    vsf_linux_epoll_priv_t *epoll = (vsf_linux_epoll_priv_t *)sfd->priv;
+    vsf_linux_epoll_item_t *item;
+
+    do {
+        vsf_protect_t orig = vsf_protect_sched();
+            vsf_dlist_peek_head(vsf_linux_epoll_item_t, item_node, &epoll->item_list, item);
+            if (item != NULL) {
+                __vsf_linux_epoll_remove(item);
+            }
+        vsf_unprotect_sched(orig);
+        if (item != NULL) {
+            free(item);
+        }
+    } while (item != NULL);
+    return 0;
+}
+
+static vsf_linux_fd_t * __vsf_linux_fd_alloc(vsf_linux_process_t *process, int priv_size)
+{
+#if VSF_LINUX_CFG_FD_SLAB_NUM > 0
+    if (priv_size <= VSF_LINUX_CFG_FD_SLAB_PRIV_SIZE) {
+        vsf_linux_fd_slab_node_t *node;
+        uint8_t *slab;
+
+        vsf_protect_t orig = vsf_protect_sched();
+            vsf_slist_stack_pop(vsf_linux_fd_slab_node_t, node, &process->fd_free_list, node);
+        vsf_unprotect_sched(orig);
+
+        if (NULL == node) {
+            slab = malloc(__VSF_LINUX_FD_SLAB_HEAD_SIZE
+                        +   VSF_LINUX_CFG_FD_SLAB_NUM * __VSF_LINUX_FD_SLAB_OBJ_SIZE);
+            if (NULL == slab) {
+                return NULL;
+            }
+
+            // first object is returned, others are put into free list
+            node = (vsf_linux_fd_slab_node_t *)(slab + __VSF_LINUX_FD_SLAB_HEAD_SIZE);
+            orig = vsf_protect_sched();
+                vsf_slist_stack_push(vsf_linux_fd_slab_node_t, node, &process->fd_slab_list,
+                        (vsf_linux_fd_slab_node_t *)slab);
+                for (int i = 1; i < VSF_LINUX_CFG_FD_SLAB_NUM; i++) {
+                    vsf_slist_stack_push(vsf_linux_fd_slab_node_t, node, &process->fd_free_list,
+                        (vsf_linux_fd_slab_node_t *)((uint8_t *)node + i * __VSF_LINUX_FD_SLAB_OBJ_SIZE));
+                }
+            vsf_unprotect_sched(orig);
+        }
+        memset(node, 0, __VSF_LINUX_FD_SLAB_OBJ_SIZE);
+        return (vsf_linux_fd_t *)node;
+    }
+#endif
+    return calloc(1, sizeof(vsf_linux_fd_t) + priv_size);
+}
+
+static void __vsf_linux_fd_free(vsf_linux_process_t *process, vsf_linux_fd_t *sfd)
+{
+#if VSF_LINUX_CFG_FD_SLAB_NUM > 0
+    int priv_size = (sfd->op != NULL) ? sfd->op->priv_size : 0;
+    if (priv_size <= VSF_LINUX_CFG_FD_SLAB_PRIV_SIZE) {
+        vsf_protect_t orig = vsf_protect_sched();
+            vsf_slist_stack_push(vsf_linux_fd_slab_node_t, node, &process->fd_free_list,
+                        (vsf_linux_fd_slab_node_t *)sfd);
+        vsf_unprotect_sched(orig);
+        return;
+    }
+#endif
+    free(sfd);
+}
+
+static void __vsf_linux_fd_table_fini(vsf_linux_process_t *process)
+{
+    if (process->fd_table != NULL) {
+        free(process->fd_table);
+        process->fd_table = NULL;
+        process->fd_bitmap = NULL;
+        process->fd_table_size = 0;
+    }
+
+#if VSF_LINUX_CFG_FD_SLAB_NUM > 0
+    vsf_linux_fd_slab_node_t *slab;
+    do {
+        vsf_slist_stack_pop(vsf_linux_fd_slab_node_t, node, &process->fd_slab_list, slab);
+        if (slab != NULL) {
+            free(slab);
+        }
+    } while (slab != NULL);
+    vsf_slist_init(&process->fd_free_list);
+#endif
+}
+
+// make fd table hold at least size entries
+static int __vsf_linux_fd_table_grow(vsf_linux_process_t *process, int size)
+{
+    int cur_size = process->fd_table_size, new_size, word_num;
+    vsf_linux_fd_t **table, **table_orig;
+
+    new_size = (cur_size > 0) ? cur_size << 1 : VSF_LINUX_CFG_FD_TABLE_SIZE;
+    while (new_size < size) {
+        new_size <<= 1;
+    }
+    if (new_size > VSF_LINUX_CFG_FD_MAX) {
+        new_size = VSF_LINUX_CFG_FD_MAX;
+    }
+    if ((new_size <= cur_size) || (new_size < size)) {
+        errno = EMFILE;
+        return -1;
+    }
+
+    // bitmap follows the table in the same memory block
+    word_num = (new_size + __optimal_bit_sz - 1) / __optimal_bit_sz;
+    table = calloc(1, new_size * sizeof(vsf_linux_fd_t *) + word_num * sizeof(uintalu_t));
+    if (NULL == table) {
+        errno = ENOMEM;
+        return -1;
+    }
+
     vsf_protect_t orig = vsf_protect_sched();
-    __vsf_dlist_foreach_unsafe(vsf_linux_fd_t, fd_node, fd_list) {
-        if (_->fd == fd) {
+        table_orig = process->fd_table;
+        cur_size = process->fd_table_size;
+        if (cur_size >= new_size) {
+            // already grown by another thread
             vsf_unprotect_sched(orig);
-            return _;
+            free(table);
+            return 0;
+        }
+        if (table_orig != NULL) {
+            memcpy(table, table_orig, cur_size * sizeof(vsf_linux_fd_t *));
+            memcpy(&table[new_size], process->fd_bitmap,
+                ((cur_size + __optimal_bit_sz - 1) / __optimal_bit_sz) * sizeof(uintalu_t));
+        }
+        process->fd_table = table;
+        process->fd_bitmap = (uintalu_t *)&table[new_size];
+        process->fd_table_size = new_size;
+    vsf_unprotect_sched(orig);
+
+    if (table_orig != NULL) {
+        free(table_orig);
+    }
+    return 0;
+}
+
+// install sfd to the lowest free fd no less than minfd
+static int __vsf_linux_fd_install(vsf_linux_process_t *process, vsf_linux_fd_t *sfd, int minfd)
+{
+    uintalu_t word_orig;
+    int fd, word;
+
+    while (1) {
+        vsf_protect_t orig = vsf_protect_sched();
+        if (minfd < process->fd_table_size) {
+            // bits below minfd are taken as allocated while searching
+            word = minfd / __optimal_bit_sz;
+            word_orig = process->fd_bitmap[word];
+            process->fd_bitmap[word] |= ((uintalu_t)1 << (minfd & __optimal_bit_msk)) - 1;
+            fd = vsf_bitmap_ffz(&process->fd_bitmap[word],
+                        process->fd_table_size - word * __optimal_bit_sz);
+            process->fd_bitmap[word] = word_orig;
+
+            if (fd >= 0) {
+                fd += word * __optimal_bit_sz;
+                vsf_bitmap_set(process->fd_bitmap, fd);
+                process->fd_table[fd] = sfd;
+                sfd->ref++;
+                vsf_unprotect_sched(orig);
+                return fd;
+            }
+        }
+        // grow to cover minfd, table is at least doubled
+        fd = ((minfd < process->fd_table_size) ? process->fd_table_size : minfd) + 1;
+        vsf_unprotect_sched(orig);
+
+        if (__vsf_linux_fd_table_grow(process, fd) < 0) {
+            return -1;
         }
     }
+}
+
+vsf_linux_fd_t * vsf_linux_get_fd(int fd)
+{
+    vsf_linux_process_t *process = vsf_linux_get_cur_process();
+    vsf_linux_fd_t *sfd = NULL;
+
+    vsf_protect_t orig = vsf_protect_sched();
+        if ((fd >= 0) && (fd < process->fd_table_size)) {
+            sfd = process->fd_table[fd];
+        }
     vsf_unprotect_sched(orig);
-    return NULL;
+    return sfd;
 }
 
 int vsf_linux_create_fd(vsf_linux_fd_t **sfd, const vsf_linux_fd_op_t *op)
 {
     vsf_linux_process_t *process = vsf_linux_get_cur_process();
     int priv_size = (op != NULL) ? op->priv_size : 0;
-    vsf_linux_fd_t *new_sfd = calloc(1, sizeof(vsf_linux_fd_t) + priv_size);
+    vsf_linux_fd_t *new_sfd = __vsf_linux_fd_alloc(process, priv_size);
     if (!new_sfd) {
         errno = ENOMEM;
         return -1;
     }
 
     new_sfd->op = op;
-    new_sfd->rxpend = new_sfd->txpend = NULL;
-    new_sfd->fd = process->cur_fd++;
-
-    vsf_protect_t orig = vsf_protect_sched();
-        vsf_dlist_add_to_tail(vsf_linux_fd_t, fd_node, &process->fd_list, new_sfd);
-    vsf_unprotect_sched(orig);
+    new_sfd->fd = __vsf_linux_fd_install(process, new_sfd, 0);
+    if (new_sfd->fd < 0) {
+        __vsf_linux_fd_free(process, new_sfd);
+        return -1;
+    }
 
     if (sfd != NULL) {
         *sfd = new_sfd;
@@ -772,15 +1029,76 @@ int vsf_linux_create_fd(vsf_linux_fd_t **sfd, const vsf_linux_fd_op_t *op)
     return new_sfd->fd;
 }
 
-void vsf_linux_delete_fd(int fd)
+// get sfd of fd with a reference held, which MUST be released by __vsf_linux_fd_put
+static vsf_linux_fd_t * __vsf_linux_fd_get(vsf_linux_process_t *process, int fd)
+{
+    vsf_linux_fd_t *sfd = NULL;
+
+    vsf_protect_t orig = vsf_protect_sched();
+        if ((fd >= 0) && (fd < process->fd_table_size)) {
+            sfd = process->fd_table[fd];
+            if (sfd != NULL) {
+                sfd->ref++;
+            }
+        }
+    vsf_unprotect_sched(orig);
+    return sfd;
+}
+
+// object is shared by fds from dup, close and free it with the last reference
+static int __vsf_linux_fd_put(vsf_linux_process_t *process, vsf_linux_fd_t *sfd)
+{
+    vsf_linux_epoll_item_t *item;
+    int ref, err = 0;
+
+    vsf_protect_t orig = vsf_protect_sched();
+        ref = --sfd->ref;
+    vsf_unprotect_sched(orig);
+    if (ref > 0) {
+        return 0;
+    }
+
+    if ((sfd->op != NULL) && (sfd->op->fn_close != NULL)) {
+        err = sfd->op->fn_close(sfd);
+    }
+
+    // closed fd is removed from all epoll instances watching it
+    do {
+        orig = vsf_protect_sched();
+            vsf_dlist_peek_head(vsf_linux_epoll_item_t, fd_node, &sfd->epoll_list, item);
+            if (item != NULL) {
+                __vsf_linux_epoll_remove(item);
+            }
+        vsf_unprotect_sched(orig);
+        if (item != NULL) {
+            free(item);
+        }
+    } while (item != NULL);
+    __vsf_linux_fd_free(process, sfd);
+    return err;
+}
+
+int vsf_linux_delete_fd(int fd)
 {
-    vsf_linux_fd_t *sfd = vsf_linux_get_fd(fd);
     vsf_linux_process_t *process = vsf_linux_get_cur_process();
+    vsf_linux_fd_t *sfd = NULL;
 
     vsf_protect_t orig = vsf_protect_sched();
-        vsf_dlist_remove(vsf_linux_fd_t, fd_node, &process->fd_list, sfd);
+        if ((fd >= 0) && (fd < process->fd_table_size)) {
+            sfd = process->fd_table[fd];
+        }
+        if (sfd != NULL) {
+            process->fd_table[fd] = NULL;
+            vsf_bitmap_clear(process->fd_bitmap, fd);
+        }
     vsf_unprotect_sched(orig);
-    free(sfd);
+
+    if (NULL == sfd) {
+        errno = EBADF;
+        return -1;
+    }
+    // reference of the fd table entry
+    return __vsf_linux_fd_put(process, sfd);
 }
 
 int vsf_linux_fd_tx_pend(int fd)
@@ -819,6 +1137,55 @@ int vsf_linux_fd_rx_pend(int fd)
     return 0;
 }
 
+static uint32_t __vsf_linux_fd_get_events(vsf_linux_fd_t *sfd)
+{
+    return (sfd->rxevt ? EPOLLIN : 0) | (sfd->txevt ? EPOLLOUT : 0);
+}
+
+// call with sched protected
+static void __vsf_linux_epoll_ready(vsf_linux_epoll_item_t *item)
+{
+    vsf_linux_epoll_priv_t *epoll = item->epoll;
+
+    if (!vsf_dlist_is_in(vsf_linux_epoll_item_t, ready_node, &epoll->ready_list, item)) {
+        vsf_dlist_add_to_tail(vsf_linux_epoll_item_t, ready_node, &epoll->ready_list, item);
+    }
+    // all waiters rescan, and the ones finding nothing wait again
+    __vsf_dlist_foreach_unsafe(vsf_linux_fd_waiter_t, node, &epoll->wait_list) {
+        vsf_eda_trig_set(_->trig);
+    }
+}
+
+// call with sched protected
+static void __vsf_linux_epoll_remove(vsf_linux_epoll_item_t *item)
+{
+    vsf_linux_epoll_priv_t *epoll = item->epoll;
+
+    vsf_dlist_remove(vsf_linux_epoll_item_t, fd_node, &item->sfd->epoll_list, item);
+    vsf_dlist_remove(vsf_linux_epoll_item_t, item_node, &epoll->item_list, item);
+    if (vsf_dlist_is_in(vsf_linux_epoll_item_t, ready_node, &epoll->ready_list, item)) {
+        vsf_dlist_remove(vsf_linux_epoll_item_t, ready_node, &epoll->ready_list, item);
+    }
+}
+
+// wake epoll instances and poll calls watching sfd, independent of rxpend/txpend
+static void __vsf_linux_fd_notify(vsf_linux_fd_t *sfd, uint32_t events)
+{
+    vsf_protect_t orig = vsf_protect_sched();
+    __vsf_dlist_foreach_unsafe(vsf_linux_epoll_item_t, fd_node, &sfd->epoll_list) {
+        if (_->event.events & events) {
+            _->revents |= events;
+            __vsf_linux_epoll_ready(_);
+        }
+    }
+    __vsf_dlist_foreach_unsafe(vsf_linux_fd_waiter_t, node, &sfd->poll_list) {
+        if (_->events & events) {
+            vsf_eda_trig_set(_->trig);
+        }
+    }
+    vsf_unprotect_sched(orig);
+}
+
 int vsf_linux_fd_tx_trigger(int fd)
 {
     vsf_linux_fd_t *sfd = vsf_linux_get_fd(fd);
@@ -833,6 +1200,7 @@ int vsf_linux_fd_tx_trigger(int fd)
         sfd->txevt = true;
         vsf_unprotect_sched(orig);
     }
+    __vsf_linux_fd_notify(sfd, EPOLLOUT);
     return 0;
 }
 
@@ -850,15 +1218,118 @@ int vsf_linux_fd_rx_trigger(int fd)
         sfd->rxevt = true;
         vsf_unprotect_sched(orig);
     }
+    __vsf_linux_fd_notify(sfd, EPOLLIN);
     return 0;
 }
 
+static void __vsf_linux_timeout_start(vsf_linux_timeout_t *to, int timeout_ms)
+{
+    if (timeout_ms < 0) {
+        to->tick = -1;
+    } else if (0 == timeout_ms) {
+        to->tick = 0;
+    } else {
+#if VSF_KERNEL_CFG_EDA_SUPPORT_TIMER == ENABLED
+        to->tick = vsf_systimer_ms_to_tick(timeout_ms);
+        if (to->tick <= 0) {
+            to->tick = 1;
+        }
+        to->deadline = vsf_systimer_get() + to->tick;
+#else
+        // no timer support, wait forever
+        to->tick = -1;
+#endif
+    }
+}
+
+static void __vsf_linux_timeout_update(vsf_linux_timeout_t *to, vsf_sync_reason_t reason)
+{
+    if (VSF_SYNC_TIMEOUT == reason) {
+        // do a last check before returning
+        to->tick = 0;
+    }
+#if VSF_KERNEL_CFG_EDA_SUPPORT_TIMER == ENABLED
+    else if (to->tick > 0) {
+        vsf_systimer_cnt_t now = vsf_systimer_get();
+        to->tick = (now >= to->deadline) ? 0 : (int_fast32_t)(to->deadline - now);
+    }
+#endif
+}
+
 #ifndef __WIN__
 // conflicts with select in winsock.h
 int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *execeptfds, struct timeval *timeout)
 {
-    VSF_LINUX_ASSERT(false);
-    return -1;
+    struct pollfd *fds;
+    int timeout_ms, ret, i, num = 0;
+    short events;
+
+    if ((nfds < 0) || (nfds > FD_SETSIZE)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    fds = malloc((nfds > 0 ? nfds : 1) * sizeof(struct pollfd));
+    if (NULL == fds) {
+        errno = ENOMEM;
+        return -1;
+    }
+    for (i = 0; i < nfds; i++) {
+        events = 0;
+        if ((readfds != NULL) && FD_ISSET(i, readfds)) {
+            events |= POLLIN;
+        }
+        if ((writefds != NULL) && FD_ISSET(i, writefds)) {
+            events |= POLLOUT;
+        }
+        if (events) {
+            fds[num].fd = i;
+            fds[num].events = events;
+            num++;
+        }
+    }
+
+    if (NULL == timeout) {
+        timeout_ms = -1;
+    } else {
+        timeout_ms = timeout->tv_sec * 1000 + (timeout->tv_usec + 999) / 1000;
+    }
+    ret = poll(fds, num, timeout_ms);
+
+    if (ret >= 0) {
+        for (i = 0; i < num; i++) {
+            if (fds[i].revents & POLLNVAL) {
+                errno = EBADF;
+                ret = -1;
+                goto cleanup;
+            }
+        }
+
+        ret = 0;
+        if (readfds != NULL) {
+            FD_ZERO(readfds);
+        }
+        if (writefds != NULL) {
+            FD_ZERO(writefds);
+        }
+        if (execeptfds != NULL) {
+            FD_ZERO(execeptfds);
+        }
+        for (i = 0; i < num; i++) {
+            if ((fds[i].revents & POLLIN) && (readfds != NULL)) {
+                FD_SET(fds[i].fd, readfds);
+                ret++;
+            }
+            if ((fds[i].revents & POLLOUT) && (writefds != NULL)) {
+                FD_SET(fds[i].fd, writefds);
+                ret++;
+            }
+        }
+    }
+
+cleanup:
+    free(fds);
+    return ret;
 }
 
 // conflicts with remove in ucrt
@@ -872,65 +1343,98 @@ int remove(const char * pathname)
 
 int poll(struct pollfd *fds, nfds_t nfds, int timeout)
 {
+    vsf_linux_process_t *process = vsf_linux_get_cur_process();
+    vsf_linux_fd_waiter_t *waiters = NULL;
+    vsf_linux_timeout_t to;
+    vsf_sync_reason_t reason;
     vsf_protect_t orig;
     vsf_linux_fd_t *sfd;
-    int ret = 0;
-    nfds_t i;
     vsf_trig_t trig;
+    short revents;
+    int ret;
+    nfds_t i;
 
+    __vsf_linux_timeout_start(&to, timeout);
     vsf_eda_trig_init(&trig, false, true);
     while (1) {
+        ret = 0;
+        orig = vsf_protect_sched();
         for (i = 0; i < nfds; i++) {
-            sfd = vsf_linux_get_fd(fds[i].fd);
-            if (sfd->rxevt || sfd->txevt) {
-                if ((fds[i].events & POLLIN) && sfd->rxevt) {
-                    fds[i].revents |= POLLIN;
-                }
-                if ((fds[i].events & POLLOUT) && sfd->txevt) {
-                    fds[i].revents |= POLLOUT;
-                }
-                if (fds[i].revents) {
-                    ret++;
+            revents = 0;
+            if (fds[i].fd >= 0) {
+                sfd = vsf_linux_get_fd(fds[i].fd);
+                if (NULL == sfd) {
+                    revents = POLLNVAL;
+                } else {
+                    if ((fds[i].events & POLLIN) && sfd->rxevt) {
+                        revents |= POLLIN;
+                    }
+                    if ((fds[i].events & POLLOUT) && sfd->txevt) {
+                        revents |= POLLOUT;
+                    }
                 }
             }
+            fds[i].revents = revents;
+            if (revents) {
+                ret++;
+            }
         }
-        if (ret) {
-            return ret;
+        if (ret || !to.tick) {
+            vsf_unprotect_sched(orig);
+            break;
+        }
+        if (NULL == waiters) {
+            vsf_unprotect_sched(orig);
+            waiters = malloc((nfds > 0 ? nfds : 1) * sizeof(vsf_linux_fd_waiter_t));
+            if (NULL == waiters) {
+                errno = ENOMEM;
+                return -1;
+            }
+            // rescan, events maybe triggered while allocating
+            continue;
         }
 
+        // register in the same protected region as the scan, so no trigger is lost,
+        //  waiters do not take rxpend/txpend, which maybe used by read/write of other threads
         for (i = 0; i < nfds; i++) {
+            waiters[i].sfd = NULL;
+            if (fds[i].fd < 0) {
+                continue;
+            }
+            // sfd is held while waiting, in case it's closed by other threads
             sfd = vsf_linux_get_fd(fds[i].fd);
-            orig = vsf_protect_sched();
-                if (fds[i].events & POLLIN) {
-                    sfd->rxpend = &trig;
-                }
-                if (fds[i].events & POLLOUT) {
-                    sfd->txpend = &trig;
-                }
-            vsf_unprotect_sched(orig);
+            sfd->ref++;
+            waiters[i].sfd = sfd;
+            waiters[i].trig = &trig;
+            waiters[i].events = ((fds[i].events & POLLIN) ? EPOLLIN : 0)
+                            |   ((fds[i].events & POLLOUT) ? EPOLLOUT : 0);
+            vsf_dlist_init_node(vsf_linux_fd_waiter_t, node, &waiters[i]);
+            vsf_dlist_add_to_tail(vsf_linux_fd_waiter_t, node, &sfd->poll_list, &waiters[i]);
         }
-        vsf_thread_trig_pend(&trig, -1);
+        vsf_unprotect_sched(orig);
+
+        reason = vsf_thread_trig_pend(&trig, to.tick);
+
+        orig = vsf_protect_sched();
         for (i = 0; i < nfds; i++) {
-            sfd = vsf_linux_get_fd(fds[i].fd);
-            orig = vsf_protect_sched();
-                if (fds[i].events & POLLIN) {
-                    if (NULL == sfd->rxpend) {
-                        sfd->rxevt = true;
-                    } else {
-                        sfd->rxpend = NULL;
-                    }
-                }
-                if (fds[i].events & POLLOUT) {
-                    if (NULL == sfd->txpend) {
-                        sfd->txevt = true;
-                    } else {
-                        sfd->txpend = NULL;
-                    }
-                }
-            vsf_unprotect_sched(orig);
+            if (waiters[i].sfd != NULL) {
+                vsf_dlist_remove(vsf_linux_fd_waiter_t, node, &waiters[i].sfd->poll_list, &waiters[i]);
+            }
+        }
+        vsf_unprotect_sched(orig);
+        for (i = 0; i < nfds; i++) {
+            if (waiters[i].sfd != NULL) {
+                __vsf_linux_fd_put(process, waiters[i].sfd);
+            }
         }
+
+        __vsf_linux_timeout_update(&to, reason);
     }
-    return 0;
+
+    if (waiters != NULL) {
+        free(waiters);
+    }
+    return ret;
 }
 
 int ppoll(struct pollfd *fds, nfds_t nfds, const struct timespec *timeout_ts, const sigset_t *sigmask)
@@ -946,6 +1450,246 @@ int ppoll(struct pollfd *fds, nfds_t nfds, const struct timespec *timeout_ts, co
     return ready;
 }
 
+// call with sched protected
+static vsf_linux_epoll_item_t * __vsf_linux_epoll_find(vsf_linux_epoll_priv_t *epoll, vsf_linux_fd_t *sfd)
+{
+    __vsf_dlist_foreach_unsafe(vsf_linux_epoll_item_t, fd_node, &sfd->epoll_list) {
+        if (_->epoll == epoll) {
+            return _;
+        }
+    }
+    return NULL;
+}
+
+static vsf_linux_epoll_priv_t * __vsf_linux_epoll_get(int epfd)
+{
+    vsf_linux_fd_t *sfd = vsf_linux_get_fd(epfd);
+    if (NULL == sfd) {
+        errno = EBADF;
+        return NULL;
+    }
+    if (sfd->op != &__vsf_linux_epoll_fdop) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return (vsf_linux_epoll_priv_t *)sfd->priv;
+}
+
+int epoll_create(int size)
+{
+    if (size <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return epoll_create1(0);
+}
+
+int epoll_create1(int flags)
+{
+    return vsf_linux_create_fd(NULL, &__vsf_linux_epoll_fdop);
+}
+
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+{
+    vsf_linux_epoll_priv_t *epoll = __vsf_linux_epoll_get(epfd);
+    vsf_linux_epoll_item_t *item, *new_item = NULL, *del_item = NULL;
+    vsf_linux_fd_t *sfd = vsf_linux_get_fd(fd);
+    int err = 0;
+
+    if (NULL == epoll) {
+        return -1;
+    }
+    if (NULL == sfd) {
+        errno = EBADF;
+        return -1;
+    }
+    if ((fd == epfd) || (sfd->op == &__vsf_linux_epoll_fdop)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((op != EPOLL_CTL_DEL) && (NULL == event)) {
+        errno = EFAULT;
+        return -1;
+    }
+
+    if (EPOLL_CTL_ADD == op) {
+        new_item = calloc(1, sizeof(vsf_linux_epoll_item_t));
+        if (NULL == new_item) {
+            errno = ENOMEM;
+            return -1;
+        }
+        new_item->epoll = epoll;
+        new_item->sfd = sfd;
+    }
+
+    vsf_protect_t orig = vsf_protect_sched();
+        item = __vsf_linux_epoll_find(epoll, sfd);
+        switch (op) {
+        case EPOLL_CTL_ADD:
+            if (item != NULL) {
+                err = EEXIST;
+                break;
+            }
+            item = new_item;
+            new_item = NULL;
+            vsf_dlist_add_to_tail(vsf_linux_epoll_item_t, fd_node, &sfd->epoll_list, item);
+            vsf_dlist_add_to_tail(vsf_linux_epoll_item_t, item_node, &epoll->item_list, item);
+            // fall through
+        case EPOLL_CTL_MOD:
+            if (NULL == item) {
+                err = ENOENT;
+                break;
+            }
+            item->event = *event;
+            // fd already ready is reported without waiting for the next trigger
+            item->revents = __vsf_linux_fd_get_events(sfd) & event->events;
+            if (item->revents) {
+                __vsf_linux_epoll_ready(item);
+            }
+            break;
+        case EPOLL_CTL_DEL:
+            if (NULL == item) {
+                err = ENOENT;
+                break;
+            }
+            __vsf_linux_epoll_remove(item);
+            del_item = item;
+            break;
+        default:
+            err = EINVAL;
+            break;
+        }
+    vsf_unprotect_sched(orig);
+
+    if (new_item != NULL) {
+        free(new_item);
+    }
+    if (del_item != NULL) {
+        free(del_item);
+    }
+    if (err) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+int epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout)
+{
+    vsf_linux_process_t *process = vsf_linux_get_cur_process();
+    // epoll instance is held while waiting, in case epfd is closed by other threads
+    vsf_linux_fd_t *sfd = __vsf_linux_fd_get(process, epfd);
+    vsf_linux_epoll_priv_t *epoll;
+    vsf_linux_epoll_item_t *item;
+    vsf_linux_fd_waiter_t waiter;
+    vsf_linux_timeout_t to;
+    vsf_sync_reason_t reason;
+    vsf_protect_t orig;
+    vsf_dlist_t requeue_list;
+    vsf_trig_t trig;
+    uint32_t revents;
+    int ret;
+
+    if (NULL == sfd) {
+        errno = EBADF;
+        return -1;
+    }
+    if (sfd->op != &__vsf_linux_epoll_fdop) {
+        errno = EINVAL;
+        ret = -1;
+        goto done;
+    }
+    if ((NULL == events) || (maxevents <= 0)) {
+        errno = EINVAL;
+        ret = -1;
+        goto done;
+    }
+    epoll = (vsf_linux_epoll_priv_t *)sfd->priv;
+
+    __vsf_linux_timeout_start(&to, timeout);
+    vsf_eda_trig_init(&trig, false, true);
+    vsf_dlist_init(&requeue_list);
+    waiter.sfd = sfd;
+    waiter.trig = &trig;
+    waiter.events = 0;
+    vsf_dlist_init_node(vsf_linux_fd_waiter_t, node, &waiter);
+    while (1) {
+        ret = 0;
+        orig = vsf_protect_sched();
+        // only ready items are visited, so cost does not depend on number of watched fds
+        while (ret < maxevents) {
+            vsf_dlist_remove_head(vsf_linux_epoll_item_t, ready_node, &epoll->ready_list, item);
+            if (NULL == item) {
+                break;
+            }
+
+            if (item->event.events & EPOLLET) {
+                revents = item->revents;
+            } else {
+                revents = __vsf_linux_fd_get_events(item->sfd);
+            }
+            revents &= item->event.events;
+            item->revents = 0;
+            if (!revents) {
+                continue;
+            }
+
+            events[ret].events = revents;
+            events[ret].data = item->event.data;
+            ret++;
+            if (item->event.events & EPOLLONESHOT) {
+                item->event.events = 0;
+            } else if (!(item->event.events & EPOLLET)) {
+                // level-triggered item is reported again until the event is consumed
+                vsf_dlist_add_to_tail(vsf_linux_epoll_item_t, ready_node, &requeue_list, item);
+            }
+        }
+        while (1) {
+            vsf_dlist_remove_head(vsf_linux_epoll_item_t, ready_node, &requeue_list, item);
+            if (NULL == item) {
+                break;
+            }
+            vsf_dlist_add_to_tail(vsf_linux_epoll_item_t, ready_node, &epoll->ready_list, item);
+        }
+
+        if (ret || !to.tick) {
+            vsf_unprotect_sched(orig);
+            break;
+        }
+        // multiple threads can wait on the same epoll instance
+        vsf_dlist_add_to_tail(vsf_linux_fd_waiter_t, node, &epoll->wait_list, &waiter);
+        vsf_unprotect_sched(orig);
+
+        reason = vsf_thread_trig_pend(&trig, to.tick);
+
+        orig = vsf_protect_sched();
+            vsf_dlist_remove(vsf_linux_fd_waiter_t, node, &epoll->wait_list, &waiter);
+        vsf_unprotect_sched(orig);
+
+        __vsf_linux_timeout_update(&to, reason);
+    }
+
+done:
+    __vsf_linux_fd_put(process, sfd);
+    return ret;
+}
+
+int epoll_pwait(int epfd, struct epoll_event *events, int maxevents, int timeout,
+                const sigset_t *sigmask)
+{
+    sigset_t origmask;
+    int ready;
+
+    if (NULL == sigmask) {
+        return epoll_wait(epfd, events, maxevents, timeout);
+    }
+
+    sigprocmask(SIG_SETMASK, sigmask, &origmask);
+    ready = epoll_wait(epfd, events, maxevents, timeout);
+    sigprocmask(SIG_SETMASK, &origmask, NULL);
+    return ready;
+}
+
 int sigprocmask(int how, const sigset_t *set, sigset_t *oldset)
 {
     vsf_linux_process_t *process = vsf_linux_get_cur_process();
@@ -1052,24 +1796,99 @@ int open(const char *pathname, int flags, ...)
 
 int close(int fd)
 {
-    vsf_linux_fd_t *sfd = vsf_linux_get_fd(fd);
-    if (!sfd) { return -1; }
+    return vsf_linux_delete_fd(fd);
+}
 
-    int err = sfd->op->fn_close(sfd);
-    vsf_linux_delete_fd(fd);
-    return err;
+// sfd of oldfd is held while duplicating, so that it can not be freed by close
+int dup(int oldfd)
+{
+    vsf_linux_process_t *process = vsf_linux_get_cur_process();
+    vsf_linux_fd_t *sfd = __vsf_linux_fd_get(process, oldfd);
+    int fd;
+
+    if (!sfd) {
+        errno = EBADF;
+        return -1;
+    }
+    fd = __vsf_linux_fd_install(process, sfd, 0);
+    __vsf_linux_fd_put(process, sfd);
+    return fd;
+}
+
+int dup2(int oldfd, int newfd)
+{
+    vsf_linux_process_t *process = vsf_linux_get_cur_process();
+    vsf_linux_fd_t *sfd;
+
+    if ((newfd < 0) || (newfd >= VSF_LINUX_CFG_FD_MAX)) {
+        errno = EBADF;
+        return -1;
+    }
+    sfd = __vsf_linux_fd_get(process, oldfd);
+    if (!sfd) {
+        errno = EBADF;
+        return -1;
+    }
+    if (oldfd == newfd) {
+        goto done;
+    }
+
+    if (vsf_linux_get_fd(newfd) != NULL) {
+        close(newfd);
+    }
+    if ((newfd >= process->fd_table_size) && (__vsf_linux_fd_table_grow(process, newfd + 1) < 0)) {
+        newfd = -1;
+        goto done;
+    }
+
+    vsf_protect_t orig = vsf_protect_sched();
+        if (process->fd_table[newfd] != NULL) {
+            // newfd is allocated by another thread after close
+            vsf_unprotect_sched(orig);
+            errno = EBUSY;
+            newfd = -1;
+            goto done;
+        }
+        vsf_bitmap_set(process->fd_bitmap, newfd);
+        process->fd_table[newfd] = sfd;
+        sfd->ref++;
+    vsf_unprotect_sched(orig);
+
+done:
+    __vsf_linux_fd_put(process, sfd);
+    return newfd;
 }
 
 int fcntl(int fd, int cmd, ...)
 {
-    vsf_linux_fd_t *sfd = vsf_linux_get_fd(fd);
+    vsf_linux_process_t *process = vsf_linux_get_cur_process();
+    vsf_linux_fd_t *sfd;
     va_list ap;
     long arg;
 
-    if (!sfd) { return -1; }
     va_start(ap, cmd);
         arg = va_arg(ap, long);
     va_end(ap);
+
+    switch (cmd) {
+    case F_DUPFD:
+    case F_DUPFD_CLOEXEC:
+        if ((arg < 0) || (arg >= VSF_LINUX_CFG_FD_MAX)) {
+            errno = EINVAL;
+            return -1;
+        }
+        sfd = __vsf_linux_fd_get(process, fd);
+        if (!sfd) {
+            errno = EBADF;
+            return -1;
+        }
+        fd = __vsf_linux_fd_install(process, sfd, arg);
+        __vsf_linux_fd_put(process, sfd);
+        return fd;
+    }
+
+    sfd = vsf_linux_get_fd(fd);
+    if (!sfd) { return -1; }
     return sfd->op->fn_fcntl(sfd, cmd, arg);
 }
 
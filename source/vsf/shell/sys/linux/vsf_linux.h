@@ -65,6 +65,27 @@ extern "C" {
 #   error invalid VSF_LINUX_CFG_STACKSIZE
 #endif
 
+// fd table starts at VSF_LINUX_CFG_FD_TABLE_SIZE entries, doubled when full
+#ifndef VSF_LINUX_CFG_FD_TABLE_SIZE
+#   define VSF_LINUX_CFG_FD_TABLE_SIZE      32
+#endif
+#ifndef VSF_LINUX_CFG_FD_MAX
+#   define VSF_LINUX_CFG_FD_MAX             1024
+#endif
+#if VSF_LINUX_CFG_FD_MAX > 0x4000
+#   error VSF_LINUX_CFG_FD_MAX should be no more than 0x4000
+#endif
+
+// fd objects with private data no larger than VSF_LINUX_CFG_FD_SLAB_PRIV_SIZE
+//  are allocated from per-process slabs of VSF_LINUX_CFG_FD_SLAB_NUM objects,
+//  0 to disable
+#ifndef VSF_LINUX_CFG_FD_SLAB_NUM
+#   define VSF_LINUX_CFG_FD_SLAB_NUM        8
+#endif
+#ifndef VSF_LINUX_CFG_FD_SLAB_PRIV_SIZE
+#   define VSF_LINUX_CFG_FD_SLAB_PRIV_SIZE  64
+#endif
+
 /*============================ MACROFIED FUNCTIONS ===========================*/
 
 #define vsf_linux_thread_get_priv(__thread)         (void *)(&(((vsf_linux_thread_t *)(__thread))[1]))
@@ -143,8 +164,15 @@ def_simple_class(vsf_linux_process_t) {
     private_member(
         vsf_dlist_node_t process_node;
         vsf_dlist_t thread_list;
-        vsf_dlist_t fd_list;
-        int cur_fd;
+
+        // fd table indexed by fd, fd_bitmap marks allocated entries
+        vsf_linux_fd_t **fd_table;
+        uintalu_t *fd_bitmap;
+        int fd_table_size;
+#if VSF_LINUX_CFG_FD_SLAB_NUM > 0
+        vsf_slist_t fd_slab_list;
+        vsf_slist_t fd_free_list;
+#endif
         vsf_linux_thread_t *thread_pending;
         vsf_linux_stdio_stream_t stdio_stream;
 
@@ -181,7 +209,12 @@ def_simple_class(vsf_linux_fd_t) {
     )
 
     private_member(
-        vsf_dlist_node_t fd_node;
+        // number of fd table entries and dup in progress referring to this object
+        int ref;
+        // epoll instances watching this fd
+        vsf_dlist_t epoll_list;
+        // poll calls waiting on this fd
+        vsf_dlist_t poll_list;
     )
 
     protected_member(
@@ -234,7 +267,8 @@ extern vsf_linux_process_t * vsf_linux_get_process(pid_t pid);
 extern int vsf_linux_create_fd(vsf_linux_fd_t **sfd, const vsf_linux_fd_op_t *op);
 extern vsf_linux_fd_t * vsf_linux_get_fd(int fd);
 
-extern void vsf_linux_delete_fd(int fd);
+// file is closed when the last fd referring to it is deleted
+extern int vsf_linux_delete_fd(int fd);
 extern int vsf_linux_fd_tx_pend(int fd);
 extern int vsf_linux_fd_rx_pend(int fd);
 extern int vsf_linux_fd_tx_trigger(int fd);